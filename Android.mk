@@ -5,23 +5,33 @@ LOCAL_MODULE:=amber
 LOCAL_CXXFLAGS:=-std=c++11 -fno-exceptions -fno-rtti
 LOCAL_SRC_FILES:= \
     src/amber.cc \
+    src/amber_c.cc \
     src/amberscript/parser.cc \
     src/buffer.cc \
     src/command.cc \
     src/command_data.cc \
+    src/command_optimizer.cc \
+    src/command_scheduler.cc \
+    src/data_file.cc \
     src/datum_type.cc \
     src/engine.cc \
+    src/engine_trace.cc \
     src/executor.cc \
     src/format.cc \
     src/format_parser.cc \
+    src/huge_alloc.cc \
     src/parser.cc \
     src/pipeline.cc \
     src/pipeline_data.cc \
+    src/profiler.cc \
     src/recipe.cc \
+    src/recipe_bundle.cc \
     src/result.cc \
     src/script.cc \
+    src/script_serializer.cc \
     src/shader.cc \
     src/shader_compiler.cc \
+    src/sleep.cc \
     src/tokenizer.cc \
     src/value.cc \
     src/verifier.cc \
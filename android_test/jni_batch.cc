@@ -0,0 +1,112 @@
+// Copyright 2019 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <jni.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "amber/amber.h"
+#include "amber/recipe.h"
+#include "amber/result.h"
+
+namespace {
+
+// Reads the whole file at |path| into |content|. Returns false when the
+// file cannot be opened.
+bool ReadFileToString(const std::string& path, std::string* content) {
+  std::ifstream file(path);
+  if (!file.is_open())
+    return false;
+
+  std::ostringstream text;
+  text << file.rdbuf();
+  *content = text.str();
+  return true;
+}
+
+std::string ToStdString(JNIEnv* env, jstring str) {
+  const char* chars = env->GetStringUTFChars(str, nullptr);
+  std::string result(chars ? chars : "");
+  if (chars)
+    env->ReleaseStringUTFChars(str, chars);
+  return result;
+}
+
+}  // namespace
+
+// Batch entry point for instrumented runs. Reads script paths from the
+// file at |script_list_path|, one per line, and executes them all inside
+// this process against one Amber object whose engine is kept warm
+// between scripts, so library load, activity launch and device creation
+// are paid once per batch instead of once per test. One "PASS <script>"
+// or "FAIL <script>: <error>" line per script is written to
+// |results_path|, flushed as each script finishes so a crash loses only
+// the script being executed. Returns the number of failures, or -1 when
+// the list or results file cannot be opened.
+extern "C" JNIEXPORT jint JNICALL
+Java_com_google_amber_AmberBatchRunner_nativeRunBatch(JNIEnv* env,
+                                                      jclass /*clazz*/,
+                                                      jstring script_list_path,
+                                                      jstring results_path) {
+  std::string list_content;
+  if (!ReadFileToString(ToStdString(env, script_list_path), &list_content))
+    return -1;
+
+  std::ofstream results(ToStdString(env, results_path), std::ios::trunc);
+  if (!results.is_open())
+    return -1;
+
+  std::vector<std::string> scripts;
+  std::istringstream lines(list_content);
+  for (std::string line; std::getline(lines, line);) {
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+    if (!line.empty())
+      scripts.push_back(line);
+  }
+
+  amber::Amber am;
+  jint failures = 0;
+  for (const auto& script : scripts) {
+    std::string script_content;
+    if (!ReadFileToString(script, &script_content)) {
+      results << "FAIL " << script << ": cannot read file" << std::endl;
+      ++failures;
+      continue;
+    }
+
+    amber::Recipe recipe;
+    amber::Result r = am.Parse(script_content, &recipe);
+    if (r.IsSuccess()) {
+      // A fresh Options per script so extraction and timing state does
+      // not leak between tests; reuse_engine keeps the device warm
+      // inside |am| across scripts all the same.
+      amber::Options amber_options;
+      amber_options.reuse_engine = true;
+      r = am.Execute(&recipe, &amber_options);
+    }
+
+    if (r.IsSuccess()) {
+      results << "PASS " << script << std::endl;
+    } else {
+      results << "FAIL " << script << ": " << r.Error() << std::endl;
+      ++failures;
+    }
+  }
+
+  return failures;
+}
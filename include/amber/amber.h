@@ -17,7 +17,10 @@
 
 #include <stdint.h>
 
+#include <functional>
+#include <future>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -27,6 +30,8 @@
 
 namespace amber {
 
+class Engine;
+
 /// The shader map is a map from the name of a shader to the spirv-binary
 /// which is the compiled representation of that named shader.
 typedef std::map<std::string, std::vector<uint32_t> > ShaderMap;
@@ -41,6 +46,26 @@ enum EngineType {
 /// Override point of engines to add their own configuration.
 struct EngineConfig {};
 
+/// Interface through which an embedder supplies the host memory backing
+/// amber's transient bulk storage: the parser's token arena slabs and
+/// the host-side shadows of device buffers. An arena implementation may
+/// make Free() a no-op and reclaim its memory wholesale after the run,
+/// which removes the per-block free() storm at teardown. Allocations
+/// can come from worker threads, so implementations must be thread
+/// safe.
+class HostAllocator {
+ public:
+  virtual ~HostAllocator();
+
+  /// Returns a block of |size_in_bytes| bytes suitably aligned for any
+  /// object type, or null when the allocation fails.
+  virtual void* Allocate(size_t size_in_bytes) = 0;
+
+  /// Releases a block returned by Allocate(). |size_in_bytes| is the
+  /// size the block was requested with.
+  virtual void Free(void* ptr, size_t size_in_bytes) = 0;
+};
+
 struct BufferInfo {
   /// Holds the buffer name
   std::string buffer_name;
@@ -50,6 +75,80 @@ struct BufferInfo {
   uint32_t height;
   /// Contains the buffer internal data
   std::vector<Value> values;
+  /// Contains the raw texel bytes of the buffer in tightly packed rows.
+  /// Framebuffer extractions are written here instead of |values| so no
+  /// per-channel Value objects are created for large captures.
+  std::vector<uint8_t> raw_data;
+};
+
+/// GPU execution time of one engine command, measured with device
+/// timestamp queries.
+struct CommandTiming {
+  /// Name of the measured command, e.g. "DrawArrays" or "Compute".
+  std::string command_name;
+  /// Time the device spent executing the command, in nanoseconds.
+  uint64_t gpu_duration_ns = 0;
+  /// Shader invocations the command caused, from pipeline statistics
+  /// queries, so a regression can be split into workload change versus
+  /// speed change. Collected when the device supports the
+  /// pipelineStatisticsQuery feature; zero otherwise.
+  uint64_t vertex_invocations = 0;
+  uint64_t fragment_invocations = 0;
+  uint64_t compute_invocations = 0;
+};
+
+/// Device memory drawn from one memory heap over an execution.
+struct MemoryHeapUsage {
+  /// Index of the heap in the device's memory properties.
+  uint32_t heap_index = 0;
+  /// Bytes of device memory still allocated from the heap when the
+  /// execution finished.
+  uint64_t live_bytes = 0;
+  /// Highest number of bytes allocated from the heap at any point.
+  uint64_t peak_bytes = 0;
+  /// Portions of the peak requested by buffer and by image resources.
+  uint64_t peak_buffer_bytes = 0;
+  uint64_t peak_image_bytes = 0;
+};
+
+/// CPU time an execution spent in each of its phases, in nanoseconds.
+/// The phases can overlap: framebuffer probes verify on a worker thread
+/// while commands keep executing, and SSBO probes verify inside the
+/// command loop, so the sum can differ from the wall time.
+struct PhaseTimings {
+  /// Shader compilation, including cache lookups.
+  uint64_t compile_ns = 0;
+  /// Engine pipeline creation and buffer hand-over.
+  uint64_t pipeline_ns = 0;
+  /// The command loop: everything submitted to the engine.
+  uint64_t execute_ns = 0;
+  /// Probe verification, on the worker thread and inline.
+  uint64_t verify_ns = 0;
+};
+
+/// Rolling window statistics of a soak run; one record is produced per
+/// completed window. See Options::soak_iterations.
+struct SoakRecord {
+  /// Iteration the window ended at, counted from one.
+  uint64_t iteration = 0;
+  /// Median and 99th percentile GPU time of the window's executions, in
+  /// nanoseconds. Zero unless |enable_command_timings| is set.
+  uint64_t median_gpu_ns = 0;
+  uint64_t p99_gpu_ns = 0;
+  /// Median and 99th percentile wall time of the window's executions,
+  /// in nanoseconds.
+  uint64_t median_wall_ns = 0;
+  uint64_t p99_wall_ns = 0;
+  /// Resident set size of the process when the window completed; zero
+  /// on platforms where it cannot be read.
+  uint64_t resident_set_bytes = 0;
+  /// Device memory live across all heaps when the window completed.
+  uint64_t device_memory_bytes = 0;
+  /// True when a metric drifted more than |soak_alert_threshold| from
+  /// the baseline window; |alert_message| names the metrics and how far
+  /// they moved.
+  bool alert = false;
+  std::string alert_message;
 };
 
 struct Options {
@@ -57,8 +156,114 @@ struct Options {
   EngineType engine;
   /// Holds engine specific configuration. Ownership stays with the caller.
   EngineConfig* config;
-  /// Lists the buffers to extract at the end of the execution
+  /// Lists the buffers to extract at the end of the execution. An entry
+  /// named "framebuffer" receives the framebuffer texels; a name of the
+  /// form "<descriptor set>:<binding>", or just "<binding>" for
+  /// descriptor set 0, receives the raw bytes of that descriptor's
+  /// buffer. Both are written to |raw_data|.
   std::vector<BufferInfo> extractions;
+  /// Directory where compiled shader binaries are cached between runs,
+  /// keyed by a hash of the shader source. The directory must already
+  /// exist. Empty, the default, disables the cache.
+  std::string shader_cache_directory;
+  /// Runs each compiled shader through spirv-opt's performance passes
+  /// before it is handed to the engine. Driver pipeline-compile time
+  /// scales with module size and unoptimized glslang output is several
+  /// times larger than necessary. The optimized binary is what lands in
+  /// |shader_cache_directory|. Requires SPIRV-Tools support; without it
+  /// the flag is ignored. Default false.
+  bool optimize_shaders = false;
+  /// Disables the dead command elimination pass the executor runs over
+  /// the parsed command stream. The pass only removes commands whose
+  /// effect a later command provably overwrites before anything can
+  /// observe it, but a test exercising exactly such redundant sequences
+  /// - a driver stress test, say - may need every command submitted as
+  /// written. Default false: the pass runs.
+  bool disable_command_optimizer = false;
+  /// File used to persist the engine's pipeline cache across invocations.
+  /// It is loaded before the engine initializes and written back after a
+  /// successful execution. Empty, the default, disables persistence.
+  std::string pipeline_cache_path;
+  /// Brackets each draw and dispatch with a pair of GPU timestamp
+  /// queries and writes the measured durations to |command_timings|
+  /// after execution, so a slow script can be attributed to pipeline
+  /// work rather than host overhead. Default false: nothing is
+  /// recorded.
+  bool enable_command_timings = false;
+  /// Receives one entry per timed command, in submission order, when
+  /// |enable_command_timings| is set.
+  std::vector<CommandTiming> command_timings;
+  /// Receives one entry per device memory heap the execution allocated
+  /// from, so scripts approaching a small device's limits can be found
+  /// before they hit a driver out-of-memory error. Left empty by
+  /// engines without memory accounting.
+  std::vector<MemoryHeapUsage> memory_heap_usage;
+  /// Receives the CPU time of the execution's phases, accumulated over
+  /// repeat and soak iterations.
+  PhaseTimings phase_timings;
+  /// Number of times the script's command stream is executed. Shaders
+  /// are compiled and pipelines created once; only the commands repeat.
+  /// Default 1: a single execution, as before.
+  uint32_t repeat_count = 1;
+  /// Executions run before the measured |repeat_count| ones; their
+  /// timings are discarded. The very first execution also pays pipeline
+  /// creation, so at least one warmup run is advisable when measuring.
+  /// Default 0.
+  uint32_t warmup_count = 0;
+  /// Receives the wall time, in nanoseconds, of each measured execution
+  /// when |repeat_count| is greater than one.
+  std::vector<uint64_t> repeat_wall_times_ns;
+  /// Receives the total GPU time, in nanoseconds, of each measured
+  /// execution when |repeat_count| is greater than one and
+  /// |enable_command_timings| is set.
+  std::vector<uint64_t> repeat_gpu_times_ns;
+  /// Number of executions a soak run performs, for catching driver
+  /// performance drift over hours or days. The iterations are grouped
+  /// into windows of |soak_window|; each completed window yields a
+  /// SoakRecord with its rolling statistics, and the first window is
+  /// the baseline later ones are compared against. Pass a very large
+  /// count together with |soak_stop| for an open-ended run. Takes
+  /// precedence over |repeat_count|. Zero, the default, disables soak
+  /// mode.
+  uint64_t soak_iterations = 0;
+  /// Iterations per soak statistics window. Default 100.
+  uint32_t soak_window = 100;
+  /// Fraction a metric may move from the baseline window before its
+  /// record is marked as an alert. Default 0.1, i.e. ten percent.
+  double soak_alert_threshold = 0.1;
+  /// Optional stop flag checked before every soak iteration; set it
+  /// from another thread or a signal handler to end an open-ended run
+  /// cleanly after the current iteration.
+  const bool* soak_stop = nullptr;
+  /// Called with each completed window's record, on the executing
+  /// thread, so a long run reports while it is still going. May be
+  /// null.
+  std::function<void(const SoakRecord&)> soak_record_callback;
+  /// Receives every window record of the soak run.
+  std::vector<SoakRecord> soak_records;
+  /// File the engine call trace of the execution is written to. Every
+  /// shader binary, buffer declaration and command the engine receives
+  /// is recorded in a compact binary form that ReplayEngineTrace() can
+  /// feed straight back into an engine, with no parsing or shader
+  /// compilation in the replayed run. Empty, the default, disables
+  /// recording. Traces are only guaranteed to replay with the Amber
+  /// version which recorded them.
+  std::string engine_trace_path;
+  /// Keeps the engine created by the first Execute call alive inside the
+  /// Amber object and reuses it for later calls with the same engine type,
+  /// so instance and device setup is paid once for a multi-recipe run.
+  /// The engine is shut down when the Amber object is destroyed. Default
+  /// false: each execution creates and destroys its own engine.
+  bool reuse_engine = false;
+  /// Routes amber's transient bulk allocations - parser token arenas
+  /// and host-side shadows of device buffers - through the given
+  /// allocator. It is installed process-wide by the first execution
+  /// that sees it and serves every later parse and execution, so it
+  /// must stay valid for the rest of the process; concurrent executions
+  /// must agree on one allocator. Parses before the first execution use
+  /// the built-in allocator. Null, the default, keeps the built-in
+  /// allocator.
+  HostAllocator* host_allocator = nullptr;
 };
 
 /// Main interface to the Amber environment.
@@ -70,6 +275,18 @@ class Amber {
   /// Parse the given |data| into the |recipe|.
   amber::Result Parse(const std::string& data, amber::Recipe* recipe);
 
+  /// Parses each entry of |data| into the recipe at the same index of
+  /// |recipes|. Parsing has no shared state so the scripts are distributed
+  /// over a pool of worker threads. If |results| is non-null it receives the
+  /// parse result for each input, in input order. The returned result is the
+  /// first failure, if any; recipes which parsed successfully are still
+  /// filled in. A non-null |durations_ns| receives the wall time of each
+  /// parse, in nanoseconds, in input order.
+  amber::Result ParseAll(const std::vector<std::string>& data,
+                         std::vector<amber::Recipe*>* recipes,
+                         std::vector<amber::Result>* results = nullptr,
+                         std::vector<uint64_t>* durations_ns = nullptr);
+
   /// Executes the given |recipe| with the provided |opts|. Returns a
   /// |Result| which indicates if the execution succeded.
   amber::Result Execute(const amber::Recipe* recipe, Options* opts);
@@ -80,6 +297,81 @@ class Amber {
   amber::Result ExecuteWithShaderData(const amber::Recipe* recipe,
                                       Options* opts,
                                       const ShaderMap& shader_data);
+
+  /// Executes the given |recipe| with the provided |opts| on a worker
+  /// thread and returns a future holding the execution result, so the
+  /// caller can prepare its next recipe while this one runs. The Amber
+  /// object, |recipe| and |opts| must stay alive and untouched until the
+  /// future is ready; executions on one Amber object are not concurrent
+  /// with each other.
+  std::future<amber::Result> ExecuteAsync(const amber::Recipe* recipe,
+                                          Options* opts);
+
+  /// Asynchronous version of ExecuteWithShaderData(). The lifetime rules
+  /// of ExecuteAsync() apply; |shader_data| is copied.
+  std::future<amber::Result> ExecuteWithShaderDataAsync(
+      const amber::Recipe* recipe,
+      Options* opts,
+      const ShaderMap& shader_data);
+
+  /// Executes the given |recipe| twice, once with |opts| and once with
+  /// |secondary_opts|, and compares the two resulting framebuffers byte
+  /// for byte. The script is parsed once and the shaders compiled once;
+  /// the two engines run concurrently on separate threads. A mismatch
+  /// names the first differing texel, which points differential testing
+  /// of two backends or devices straight at the divergence. Both options
+  /// must use distinct |config| values when they target the same engine
+  /// type.
+  amber::Result ExecuteDifferential(const amber::Recipe* recipe,
+                                    Options* opts,
+                                    Options* secondary_opts);
+
+  /// Compiles the shaders of |recipe| and stores the binaries on the
+  /// recipe, so a later Execute of the same recipe skips compilation.
+  /// This lets a CPU thread compile upcoming recipes ahead while another
+  /// thread feeds the GPU. |opts| supplies the shader cache directory
+  /// and may be null. The recipe must not be executed or precompiled
+  /// concurrently with this call.
+  amber::Result PrecompileShaders(const amber::Recipe* recipe, Options* opts);
+
+  /// Same as PrecompileShaders() but uses |shader_data| to look up shader
+  /// binaries before attempting to compile, like ExecuteWithShaderData().
+  amber::Result PrecompileShadersWithShaderData(const amber::Recipe* recipe,
+                                                Options* opts,
+                                                const ShaderMap& shader_data);
+
+  /// Goes one step further than PrecompileShaders(): a throwaway engine is
+  /// created from |opts| and asked to build the pipeline state objects the
+  /// recipe's draws and dispatches will need, without submitting any GPU
+  /// work. When |opts->config| supplies an externally created device, the
+  /// driver compilation lands in a pipeline cache shared by every engine
+  /// on that device, so a concurrent or later Execute() of the recipe
+  /// finds its pipelines ready made. Like PrecompileShaders(), the recipe
+  /// must not be executed or prewarmed concurrently with this call; the
+  /// execution itself may run on another thread against its own engine.
+  amber::Result PrewarmPipelines(const amber::Recipe* recipe, Options* opts);
+
+  /// Replays the engine call trace in the file at |path|, recorded by an
+  /// execution with Options::engine_trace_path set, against a fresh
+  /// engine of |opts->engine| created on |opts->config|. The replayed
+  /// run performs the recorded device workload only - no parsing, shader
+  /// compilation or result verification - so two drivers can be compared
+  /// free of front-end noise.
+  amber::Result ReplayEngineTrace(const std::string& path, Options* opts);
+
+  /// Uses |dir| as an on-disk parse cache. Parse() keys each input by a hash
+  /// of its text: on a hit the serialized script stored in |dir| is loaded
+  /// instead of running the parser, on a miss the parsed script is written
+  /// back for next time. The directory must already exist. Pass an empty
+  /// string to disable caching, which is the default.
+  void SetParseCacheDirectory(const std::string& dir);
+
+ private:
+  std::string parse_cache_dir_;
+  /// Engine kept alive between executions when Options::reuse_engine is set,
+  /// together with the type it was created as.
+  std::unique_ptr<Engine> cached_engine_;
+  EngineType cached_engine_type_ = kEngineTypeVulkan;
 };
 
 }  // namespace amber
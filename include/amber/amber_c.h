@@ -0,0 +1,97 @@
+// Copyright 2019 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AMBER_AMBER_C_H_
+#define AMBER_AMBER_C_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Flat C interface over the amber::Amber class, for embedders which
+/// cannot link against the C++ API or need a stable ABI. A context
+/// corresponds to one Amber object and keeps its engine alive between
+/// executions, so an embedder running many scripts through one context
+/// pays device creation once and gets the shader and parse caches for
+/// free. Contexts are not thread safe; use one context per thread.
+///
+/// Every function returning int returns 0 on success and non-zero on
+/// failure; amber_context_get_error() describes the most recent failure
+/// on the context.
+
+/// Opaque handle to an Amber instance plus its execution options.
+typedef struct amber_context amber_context;
+
+/// Opaque handle to a parsed script.
+typedef struct amber_recipe amber_recipe;
+
+enum amber_engine_type {
+  AMBER_ENGINE_TYPE_VULKAN = 0,
+  AMBER_ENGINE_TYPE_DAWN = 1,
+};
+
+/// Creates a context using the default (Vulkan) engine. Returns a null
+/// pointer on allocation failure. The context must be destroyed with
+/// amber_context_destroy().
+amber_context* amber_context_create(void);
+
+/// Destroys |context|, shutting down any engine it kept alive. Recipes
+/// parsed through the context stay valid; they are destroyed
+/// separately.
+void amber_context_destroy(amber_context* context);
+
+/// Selects the engine used by later amber_execute() calls. Changing the
+/// engine type shuts down a previously cached engine.
+int amber_context_set_engine(amber_context* context,
+                             enum amber_engine_type engine);
+
+/// Sets the directory compiled shader binaries are cached in between
+/// executions, shared with the C++ API's shader_cache_directory option.
+/// The directory must already exist; an empty string disables caching.
+int amber_context_set_shader_cache_directory(amber_context* context,
+                                             const char* directory);
+
+/// Sets the directory parsed scripts are cached in, keyed by a hash of
+/// their text, so re-parsing a script the context has seen before is a
+/// file load. The directory must already exist; an empty string
+/// disables caching.
+int amber_context_set_parse_cache_directory(amber_context* context,
+                                            const char* directory);
+
+/// Parses the NUL-terminated script |text| into a new recipe, returned
+/// through |recipe|. The recipe must be destroyed with
+/// amber_recipe_destroy() and may be executed any number of times, on
+/// this context or another.
+int amber_parse(amber_context* context,
+                const char* text,
+                amber_recipe** recipe);
+
+/// Executes |recipe| on the context's engine. The engine created by the
+/// first execution is kept alive inside the context and reused by later
+/// executions with the same engine type.
+int amber_execute(amber_context* context, amber_recipe* recipe);
+
+/// Returns the error message of the most recent failed call on
+/// |context|, or an empty string when no call has failed yet. The
+/// pointer stays valid until the next call on the context.
+const char* amber_context_get_error(amber_context* context);
+
+/// Destroys a recipe returned by amber_parse().
+void amber_recipe_destroy(amber_recipe* recipe);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // AMBER_AMBER_C_H_
@@ -15,10 +15,13 @@
 #ifndef AMBER_RECIPE_H_
 #define AMBER_RECIPE_H_
 
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "amber/result.h"
 #include "amber/shader_info.h"
 
 namespace amber {
@@ -28,40 +31,80 @@ class RecipeImpl {
  public:
   virtual ~RecipeImpl();
 
-  /// Retrieves information on all the shaders in the given recipe.
-  virtual std::vector<ShaderInfo> GetShaderInfo() const = 0;
+  /// Retrieves information on all the shaders in the given recipe. The
+  /// returned reference stays valid as long as the recipe does.
+  virtual const std::vector<ShaderInfo>& GetShaderInfo() const = 0;
 
-  /// Returns required features in the given recipe.
-  virtual std::vector<std::string> GetRequiredFeatures() const = 0;
+  /// Returns required features in the given recipe. The returned
+  /// reference stays valid as long as the recipe does.
+  virtual const std::vector<std::string>& GetRequiredFeatures() const = 0;
 
-  /// Returns required extensions in the given recipe.
-  virtual std::vector<std::string> GetRequiredExtensions() const = 0;
+  /// Returns required extensions in the given recipe. The returned
+  /// reference stays valid as long as the recipe does.
+  virtual const std::vector<std::string>& GetRequiredExtensions() const = 0;
+
+  /// Returns the paths of the external files the recipe's commands read
+  /// during execution.
+  virtual std::vector<std::string> GetReferencedDataFiles() const = 0;
 
  protected:
   RecipeImpl();
 };
 
-/// A recipe is the parsed representation of the input script.
+/// A recipe is the parsed representation of the input script. The parsed
+/// representation is immutable and held by shared pointer, so one recipe
+/// can be executed concurrently from several threads, each against its
+/// own engine, without parsing per thread.
 class Recipe {
  public:
   Recipe();
   ~Recipe();
 
-  /// Retrieves information on all the shaders in the recipe.
-  std::vector<ShaderInfo> GetShaderInfo() const;
+  /// Retrieves information on all the shaders in the recipe. References
+  /// the recipe's stored data; no shader source is copied.
+  const std::vector<ShaderInfo>& GetShaderInfo() const;
 
-  RecipeImpl* GetImpl() const { return impl_; }
+  RecipeImpl* GetImpl() const { return impl_.get(); }
+  /// Returns shared ownership of the recipe implementation, for callers
+  /// that must keep the parsed script alive past this recipe's lifetime.
+  std::shared_ptr<RecipeImpl> GetSharedImpl() const { return impl_; }
   /// Sets the recipe implementation. Ownership transfers to the recipe.
-  void SetImpl(RecipeImpl* impl) { impl_ = impl; }
+  void SetImpl(RecipeImpl* impl) { impl_.reset(impl); }
+
+  /// Returns required features in the given recipe. References the
+  /// recipe's stored data; nothing is copied.
+  const std::vector<std::string>& GetRequiredFeatures() const;
+
+  /// Returns required extensions in the given recipe. References the
+  /// recipe's stored data; nothing is copied.
+  const std::vector<std::string>& GetRequiredExtensions() const;
+
+  /// Returns the paths of the external files the recipe's commands read
+  /// during execution - buffer initializers and probe reference images -
+  /// so an embedder can warm them while earlier recipes execute.
+  std::vector<std::string> GetReferencedDataFiles() const;
+
+  /// Appends a serialized form of the parsed recipe to |out|. The blob can
+  /// be turned back into a recipe with Deserialize(), skipping the parse
+  /// step entirely. The format is internal and only guaranteed to load with
+  /// the same version of Amber which produced it.
+  amber::Result Serialize(std::vector<uint8_t>* out) const;
 
-  /// Returns required features in the given recipe.
-  std::vector<std::string> GetRequiredFeatures() const;
+  /// Replaces the recipe contents with the scripts stored in |data|, which
+  /// must have been produced by Serialize().
+  amber::Result Deserialize(const std::vector<uint8_t>& data);
 
-  /// Returns required extensions in the given recipe.
-  std::vector<std::string> GetRequiredExtensions() const;
+  /// Like Deserialize() above, but reads from |data| of |size| bytes
+  /// without owning the memory, so a blob in a memory-mapped file can
+  /// be loaded in place. Nothing is retained once the call returns.
+  amber::Result Deserialize(const uint8_t* data, size_t size);
 
  private:
-  RecipeImpl* impl_;
+  std::shared_ptr<RecipeImpl> impl_;
+  /// Returned by the accessors above while no implementation is set, so
+  /// they can hand out references without ever copying.
+  std::vector<ShaderInfo> empty_shader_info_;
+  std::vector<std::string> empty_strings_;
 };
 
 }  // namespace amber
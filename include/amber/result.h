@@ -15,8 +15,8 @@
 #ifndef AMBER_RESULT_H_
 #define AMBER_RESULT_H_
 
+#include <memory>
 #include <string>
-#include <vector>
 
 namespace amber {
 
@@ -28,19 +28,23 @@ class Result {
   /// Creates a result which failed and will return |err|.
   explicit Result(const std::string& err);
   Result(const Result&);
+  Result(Result&&) noexcept;
   ~Result();
 
   Result& operator=(const Result&);
+  Result& operator=(Result&&) noexcept;
 
   /// Returns true if the result is a success.
-  bool IsSuccess() const { return succeeded_; }
+  bool IsSuccess() const { return error_ == nullptr; }
 
   /// Returns the error string if |IsSuccess| is false.
-  const std::string& Error() const { return error_; }
+  const std::string& Error() const;
 
  private:
-  bool succeeded_;
-  std::string error_;
+  /// Only failures carry state: a success is a null pointer, so the
+  /// results returned by value all along the hot path construct, copy
+  /// and destroy without touching the heap.
+  std::unique_ptr<std::string> error_;
 };
 
 }  // namespace amber
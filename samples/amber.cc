@@ -12,20 +12,47 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <deque>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <set>
+#include <thread>
 #include <utility>
 #include <vector>
 
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "amber/amber.h"
 #include "amber/recipe.h"
 #include "samples/config_helper.h"
+#include "samples/log.h"
+#include "samples/png.h"
 #include "samples/ppm.h"
 #include "src/build-versions.h"
 #include "src/make_unique.h"
+#include "src/profiler.h"
+#include "src/recipe_bundle.h"
 
 namespace {
 
@@ -35,22 +62,145 @@ struct Options {
   std::string image_filename;
   std::string buffer_filename;
   int64_t buffer_binding_index = 0;
+  bool buffer_as_text = false;
+  std::string trace_filename;
+  int64_t device_count = 1;
+  int64_t compile_thread_count = 0;
+  int64_t repeat_count = 1;
+  int64_t warmup_count = 0;
+  int64_t soak_count = -1;
+  int64_t shard_index = 0;
+  int64_t shard_count = 0;
+  std::string shard_results_filename;
+  std::string enumeration_cache_filename;
+  std::string result_cache_filename;
+  std::string timing_cache_filename;
+  std::string report_filename;
+  bool force_execution = false;
+  std::string record_trace_filename;
+  std::string replay_trace_filename;
   bool parse_only = false;
+  bool validate_only = false;
+  bool server_mode = false;
+  bool watch_mode = false;
   bool show_summary = false;
+  bool show_memory_report = false;
   bool show_help = false;
   bool show_version_info = false;
+  bool diff_mode = false;
   amber::EngineType engine = amber::kEngineTypeVulkan;
+  amber::EngineType diff_engine = amber::kEngineTypeVulkan;
 };
 
 const char kUsage[] = R"(Usage: amber [options] SCRIPT [SCRIPTS...]
+       amber bundle BUNDLE SCRIPT [SCRIPTS...]
+       amber merge RESULTS [RESULTS...]
+
+The bundle form parses the named scripts and packs their parsed recipes
+into the single indexed archive BUNDLE. A bundle passed in place of a
+SCRIPT expands to its entries: the archive is mapped into memory and an
+entry's bytes are only read when it executes, so a corpus of thousands
+of scripts opens with one file instead of thousands.
+
+The merge form aggregates the --shard-results files of a sharded run,
+prints the combined failures and summary, and exits non-zero if any
+shard recorded a failure.
 
  options:
   -p             -- Parse input files only; Don't execute.
+  --validate     -- Parse input files and compile their shaders without
+                    creating an engine or touching a GPU, parallel
+                    across cores; errors print per file. Lints a large
+                    corpus on machines without the target device.
   -s             -- Print summary of pass/failure.
   -i <filename>  -- Write rendering to <filename> as a PPM image.
   -b <filename>  -- Write contents of a UBO or SSBO to <filename>.
   -B <buffer>    -- Index of buffer to write. Defaults buffer 0.
+  -t             -- Write the -b buffer dump as hex text instead of the
+                    default raw binary bytes.
+  -T <filename>  -- Profile the run and write a Chrome trace-event JSON
+                    file, loadable by chrome://tracing.
+  -m             -- Print a per-script report of the device memory drawn
+                    from each Vulkan memory heap.
   -e <engine>    -- Specify graphics engine: vulkan, dawn. Default is vulkan.
+  --diff <engine> -- Execute each script on the -e engine and <engine>
+                    concurrently and compare the two framebuffers byte
+                    for byte, reporting the first differing texel. The
+                    script is parsed and its shaders compiled once for
+                    both engines. Uses one device per engine; -d is
+                    ignored.
+  -d <devices>   -- Spread scripts across up to <devices> GPUs; 0 means all
+                    usable GPUs in the machine. Defaults to 1.
+  -j <threads>   -- Compile shaders and pre-warm pipelines on <threads>
+                    worker threads ahead of execution so the GPU never
+                    waits on the compiler or the driver.
+                    Defaults to 0: each script compiles as it executes.
+  --repeat <N>   -- Execute each script's commands N times against one
+                    engine and report min/median/p95 wall and GPU times
+                    per iteration. Defaults to 1: a single execution.
+  --warmup <M>   -- Unmeasured executions run before the --repeat ones.
+                    Defaults to 0.
+  --soak <N>     -- Soak run: execute each script's commands N times (0:
+                    until interrupted) and print a rolling statistics
+                    line - median/p99 GPU and wall time, resident set
+                    and device memory - every 100 iterations, plus an
+                    ALERT line when a metric drifts more than 10% from
+                    the first window's.
+  --record-trace <file> -- Record every engine call of the run into a
+                    binary trace for --replay-trace.
+  --replay-trace <file> -- Replay a recorded engine trace instead of
+                    running scripts: the exact device workload re-runs
+                    with no parsing or shader compilation, for driver
+                    A/B comparisons. A trace only replays with the Amber
+                    version which recorded it.
+  --shard-index <N> -- Execute only the Nth shard of the input files.
+                    Requires --shard-count. Defaults to 0.
+  --shard-count <M> -- Split the input files into M shards; script i
+                    belongs to shard i mod M, so every machine given the
+                    same file list computes the same split. Defaults to
+                    0: no sharding.
+  --shard-results <file> -- Write one "PASS <script>" or "FAIL <script>"
+                    line per executed script to <file>, for aggregation
+                    with the merge form.
+  --enum-cache <file> -- Cache the Vulkan layer checks and per-device
+                    extension lists in <file> and reuse them on later
+                    launches, skipping the startup vkEnumerate* round
+                    trips while the driver is unchanged.
+  --result-cache <file> -- Cache each script's verdict and wall time in
+                    <file>, keyed by the parsed script contents and the
+                    executing device's identity. A script whose key is
+                    already present is not executed again and reports
+                    its cached verdict, so a re-run of a mostly
+                    unchanged corpus only executes the scripts that
+                    changed. Not consulted by --diff runs.
+  --force        -- Execute every script even when its --result-cache
+                    key is present, refreshing the stored verdicts.
+  --timing-cache <file> -- Record each script's wall time in <file> and
+                    order the next run's work queue longest-first from
+                    it, so a long script pulled last cannot stretch a
+                    multi-device run past everyone else's finish.
+                    Scripts without a recorded time run first.
+  --report <file> -- Write a machine-readable per-script performance
+                    report at the end of the run: parse, shader compile,
+                    pipeline creation, execution and verification CPU
+                    time plus GPU and wall time per script, with a
+                    totals entry. JSON by default; a file name ending in
+                    .csv selects CSV.
+  --watch        -- Re-execute the single input script whenever its file
+                    changes, printing a PASS or FAIL line with the wall
+                    time of each run. The device, engine and compiler
+                    caches stay warm between runs, so an edit costs only
+                    the re-parse and the execution. The device is
+                    created from the first version of the script, so
+                    edits adding optional device features need a
+                    restart. Stop with Ctrl-C.
+  --server       -- Read script paths from stdin, one per line, and print
+                    a PASS or FAIL line for each. The process, device and
+                    shader compilers stay warm between scripts, so a
+                    harness feeding a pipe skips the per-invocation
+                    startup cost. An empty stdin, EOF or the line "quit"
+                    ends the server. The device is created up front, so
+                    scripts needing optional device features will fail.
   -V, --version  -- Output version information for Amber and libraries.
   -h             -- This help text.
 )";
@@ -88,6 +238,176 @@ bool ParseArgs(const std::vector<std::string>& args, Options* opts) {
         return false;
       }
 
+    } else if (arg == "-T") {
+      ++i;
+      if (i >= args.size()) {
+        std::cerr << "Missing value for -T argument." << std::endl;
+        return false;
+      }
+      opts->trace_filename = args[i];
+
+    } else if (arg == "-d") {
+      ++i;
+      if (i >= args.size()) {
+        std::cerr << "Missing value for -d argument." << std::endl;
+        return false;
+      }
+      opts->device_count =
+          static_cast<int64_t>(strtol(args[i].c_str(), nullptr, 10));
+
+      if (opts->device_count < 0) {
+        std::cerr << "Invalid value for -d, must be 0 or greater." << std::endl;
+        return false;
+      }
+
+    } else if (arg == "-j") {
+      ++i;
+      if (i >= args.size()) {
+        std::cerr << "Missing value for -j argument." << std::endl;
+        return false;
+      }
+      opts->compile_thread_count =
+          static_cast<int64_t>(strtol(args[i].c_str(), nullptr, 10));
+
+      if (opts->compile_thread_count < 0) {
+        std::cerr << "Invalid value for -j, must be 0 or greater." << std::endl;
+        return false;
+      }
+
+    } else if (arg == "--repeat") {
+      ++i;
+      if (i >= args.size()) {
+        std::cerr << "Missing value for --repeat argument." << std::endl;
+        return false;
+      }
+      opts->repeat_count =
+          static_cast<int64_t>(strtol(args[i].c_str(), nullptr, 10));
+
+      if (opts->repeat_count < 1) {
+        std::cerr << "Invalid value for --repeat, must be 1 or greater."
+                  << std::endl;
+        return false;
+      }
+
+    } else if (arg == "--warmup") {
+      ++i;
+      if (i >= args.size()) {
+        std::cerr << "Missing value for --warmup argument." << std::endl;
+        return false;
+      }
+      opts->warmup_count =
+          static_cast<int64_t>(strtol(args[i].c_str(), nullptr, 10));
+
+      if (opts->warmup_count < 0) {
+        std::cerr << "Invalid value for --warmup, must be 0 or greater."
+                  << std::endl;
+        return false;
+      }
+
+    } else if (arg == "--soak") {
+      ++i;
+      if (i >= args.size()) {
+        std::cerr << "Missing value for --soak argument." << std::endl;
+        return false;
+      }
+      opts->soak_count =
+          static_cast<int64_t>(strtol(args[i].c_str(), nullptr, 10));
+
+      if (opts->soak_count < 0) {
+        std::cerr << "Invalid value for --soak, must be 0 or greater."
+                  << std::endl;
+        return false;
+      }
+
+    } else if (arg == "--report") {
+      ++i;
+      if (i >= args.size()) {
+        std::cerr << "Missing value for --report argument." << std::endl;
+        return false;
+      }
+      opts->report_filename = args[i];
+
+    } else if (arg == "--record-trace") {
+      ++i;
+      if (i >= args.size()) {
+        std::cerr << "Missing value for --record-trace argument." << std::endl;
+        return false;
+      }
+      opts->record_trace_filename = args[i];
+
+    } else if (arg == "--replay-trace") {
+      ++i;
+      if (i >= args.size()) {
+        std::cerr << "Missing value for --replay-trace argument." << std::endl;
+        return false;
+      }
+      opts->replay_trace_filename = args[i];
+
+    } else if (arg == "--shard-index") {
+      ++i;
+      if (i >= args.size()) {
+        std::cerr << "Missing value for --shard-index argument." << std::endl;
+        return false;
+      }
+      opts->shard_index =
+          static_cast<int64_t>(strtol(args[i].c_str(), nullptr, 10));
+
+      if (opts->shard_index < 0) {
+        std::cerr << "Invalid value for --shard-index, must be 0 or greater."
+                  << std::endl;
+        return false;
+      }
+
+    } else if (arg == "--shard-count") {
+      ++i;
+      if (i >= args.size()) {
+        std::cerr << "Missing value for --shard-count argument." << std::endl;
+        return false;
+      }
+      opts->shard_count =
+          static_cast<int64_t>(strtol(args[i].c_str(), nullptr, 10));
+
+      if (opts->shard_count < 0) {
+        std::cerr << "Invalid value for --shard-count, must be 0 or greater."
+                  << std::endl;
+        return false;
+      }
+
+    } else if (arg == "--shard-results") {
+      ++i;
+      if (i >= args.size()) {
+        std::cerr << "Missing value for --shard-results argument." << std::endl;
+        return false;
+      }
+      opts->shard_results_filename = args[i];
+
+    } else if (arg == "--enum-cache") {
+      ++i;
+      if (i >= args.size()) {
+        std::cerr << "Missing value for --enum-cache argument." << std::endl;
+        return false;
+      }
+      opts->enumeration_cache_filename = args[i];
+
+    } else if (arg == "--result-cache") {
+      ++i;
+      if (i >= args.size()) {
+        std::cerr << "Missing value for --result-cache argument." << std::endl;
+        return false;
+      }
+      opts->result_cache_filename = args[i];
+
+    } else if (arg == "--timing-cache") {
+      ++i;
+      if (i >= args.size()) {
+        std::cerr << "Missing value for --timing-cache argument." << std::endl;
+        return false;
+      }
+      opts->timing_cache_filename = args[i];
+
+    } else if (arg == "--force") {
+      opts->force_execution = true;
+
     } else if (arg == "-e") {
       ++i;
       if (i >= args.size()) {
@@ -106,14 +426,43 @@ bool ParseArgs(const std::vector<std::string>& args, Options* opts) {
         return false;
       }
 
+    } else if (arg == "--diff") {
+      ++i;
+      if (i >= args.size()) {
+        std::cerr << "Missing value for --diff argument." << std::endl;
+        return false;
+      }
+      const std::string& engine = args[i];
+      if (engine == "vulkan") {
+        opts->diff_engine = amber::kEngineTypeVulkan;
+      } else if (engine == "dawn") {
+        opts->diff_engine = amber::kEngineTypeDawn;
+      } else {
+        std::cerr
+            << "Invalid value for --diff argument. Must be one of: vulkan dawn"
+            << std::endl;
+        return false;
+      }
+      opts->diff_mode = true;
+
     } else if (arg == "-h" || arg == "--help") {
       opts->show_help = true;
     } else if (arg == "-V" || arg == "--version") {
       opts->show_version_info = true;
     } else if (arg == "-p") {
       opts->parse_only = true;
+    } else if (arg == "--validate") {
+      opts->validate_only = true;
+    } else if (arg == "--server") {
+      opts->server_mode = true;
+    } else if (arg == "--watch") {
+      opts->watch_mode = true;
+    } else if (arg == "-t") {
+      opts->buffer_as_text = true;
     } else if (arg == "-s") {
       opts->show_summary = true;
+    } else if (arg == "-m") {
+      opts->show_memory_report = true;
     } else if (arg.size() > 0 && arg[0] == '-') {
       std::cerr << "Unrecognized option " << arg << std::endl;
       return false;
@@ -125,7 +474,107 @@ bool ParseArgs(const std::vector<std::string>& args, Options* opts) {
   return true;
 }
 
+// Read-only view of a file mapped into memory. The mapping is released when
+// the object goes out of scope. data() is null if the mapping failed.
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string& input_file) {
+#if defined(_WIN32) || defined(_WIN64)
+    file_ = CreateFileA(input_file.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE)
+      return;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file_, &file_size) || file_size.QuadPart <= 0)
+      return;
+
+    mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping_)
+      return;
+
+    data_ = static_cast<const char*>(
+        MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    if (data_)
+      size_ = static_cast<size_t>(file_size.QuadPart);
+#else
+    fd_ = open(input_file.c_str(), O_RDONLY);
+    if (fd_ < 0)
+      return;
+
+    struct stat st;
+    if (fstat(fd_, &st) != 0 || st.st_size <= 0)
+      return;
+
+    void* addr =
+        mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE,
+             fd_, 0);
+    if (addr == MAP_FAILED)
+      return;
+
+    data_ = static_cast<const char*>(addr);
+    size_ = static_cast<size_t>(st.st_size);
+#endif
+  }
+
+  ~MappedFile() {
+#if defined(_WIN32) || defined(_WIN64)
+    if (data_)
+      UnmapViewOfFile(data_);
+    if (mapping_)
+      CloseHandle(mapping_);
+    if (file_ != INVALID_HANDLE_VALUE)
+      CloseHandle(file_);
+#else
+    if (data_)
+      munmap(const_cast<char*>(data_), size_);
+    if (fd_ >= 0)
+      close(fd_);
+#endif
+  }
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+#if defined(_WIN32) || defined(_WIN64)
+  HANDLE file_ = INVALID_HANDLE_VALUE;
+  HANDLE mapping_ = nullptr;
+#else
+  int fd_ = -1;
+#endif
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+// Reads the file at |path| front to back and discards the bytes,
+// leaving them in the OS page cache so the execution-time open of the
+// same file does not stall on storage. Failures are ignored; the real
+// read reports them.
+void PrefetchFile(const std::string& path) {
+  FILE* file = nullptr;
+#if defined(_MSC_VER)
+  fopen_s(&file, path.c_str(), "rb");
+#else
+  file = fopen(path.c_str(), "rb");
+#endif
+  if (!file)
+    return;
+
+  char buffer[1 << 16];
+  while (fread(buffer, 1, sizeof(buffer), file) == sizeof(buffer)) {
+  }
+  fclose(file);
+}
+
 std::string ReadFile(const std::string& input_file) {
+  // Map the file and build the script string straight from the mapping so the
+  // kernel pages the data in once with no intermediate read buffer. Falls
+  // back to stdio when the file can not be mapped (e.g. a pipe).
+  MappedFile map(input_file);
+  if (map.data())
+    return std::string(map.data(), map.size());
+
   FILE* file = nullptr;
 #if defined(_MSC_VER)
   fopen_s(&file, input_file.c_str(), "rb");
@@ -160,143 +609,1544 @@ std::string ReadFile(const std::string& input_file) {
   return std::string(data.begin(), data.end());
 }
 
-}  // namespace
+// Writes the raw buffer bytes in |data| to |file_name| in one buffered
+// write.
+amber::Result WriteBufferBinary(const std::string& file_name,
+                                const std::vector<uint8_t>& data) {
+  std::ofstream file(file_name, std::ios::out | std::ios::binary);
+  if (!file.is_open())
+    return amber::Result("Cannot open file for buffer dump: " + file_name);
 
-int main(int argc, const char** argv) {
-  std::vector<std::string> args(argv, argv + argc);
-  Options options;
+  file.write(reinterpret_cast<const char*>(data.data()),
+             static_cast<std::streamsize>(data.size()));
+  if (!file.good())
+    return amber::Result("Failed to write buffer file: " + file_name);
+  return {};
+}
 
-  if (!ParseArgs(args, &options)) {
-    std::cerr << "Failed to parse arguments." << std::endl;
-    return 1;
-  }
+// Formats |data| as hex text, an offset prefix and four 32 bit words per
+// line, and writes the whole dump in one go.
+amber::Result WriteBufferText(const std::string& file_name,
+                              const std::vector<uint8_t>& data) {
+  std::string text;
+  text.reserve(data.size() * 4);
 
-  if (options.show_version_info) {
-    std::cout << "Amber        : " << AMBER_VERSION << std::endl;
-#if AMBER_ENABLE_SPIRV_TOOLS
-    std::cout << "SPIRV-Tools  : " << SPIRV_TOOLS_VERSION << std::endl;
-    std::cout << "SPIRV-Headers: " << SPIRV_HEADERS_VERSION << std::endl;
-#endif  // AMBER_ENABLE_SPIRV_TOOLS
-#if AMBER_ENABLE_SHADERC
-    std::cout << "GLSLang      : " << GLSLANG_VERSION << std::endl;
-    std::cout << "Shaderc      : " << SHADERC_VERSION << std::endl;
-#endif  // AMBER_ENABLE_SHADERC
-  }
+  char piece[32];
+  for (size_t offset = 0; offset < data.size(); offset += 16) {
+    int n = snprintf(piece, sizeof(piece), "%08zx:", offset);
+    text.append(piece, static_cast<size_t>(n));
 
-  if (options.show_help) {
-    std::cout << kUsage << std::endl;
-    return 0;
+    const size_t line_end = std::min(offset + 16, data.size());
+    size_t i = offset;
+    for (; i + 4 <= line_end; i += 4) {
+      uint32_t word;
+      memcpy(&word, data.data() + i, sizeof(word));
+      n = snprintf(piece, sizeof(piece), " 0x%08x", word);
+      text.append(piece, static_cast<size_t>(n));
+    }
+    for (; i < line_end; ++i) {
+      n = snprintf(piece, sizeof(piece), " 0x%02x", data[i]);
+      text.append(piece, static_cast<size_t>(n));
+    }
+    text.push_back('\n');
   }
 
-  if (options.input_filenames.empty()) {
-    std::cerr << "Input file must be provided." << std::endl;
-    return 2;
+  std::ofstream file(file_name, std::ios::out);
+  if (!file.is_open())
+    return amber::Result("Cannot open file for buffer dump: " + file_name);
+
+  file.write(text.data(), static_cast<std::streamsize>(text.size()));
+  if (!file.good())
+    return amber::Result("Failed to write buffer file: " + file_name);
+  return {};
+}
+
+bool HasSuffix(const std::string& str, const std::string& suffix) {
+  return str.size() >= suffix.size() &&
+         str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Background writer for -i images and -b buffer dumps. Artifacts are
+// queued as self-contained jobs owning their bytes, so the batch loop
+// moves on to the next script while the previous one's files land on
+// disk. Jobs run in queue order on one thread; a write failure is
+// printed when it happens, matching the old synchronous behaviour.
+// Finish() drains the queue and joins the thread.
+class ArtifactWriter {
+ public:
+  ArtifactWriter() : writer_(&ArtifactWriter::Run, this) {}
+
+  ~ArtifactWriter() { Finish(); }
+
+  void Enqueue(std::function<amber::Result()> job) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      jobs_.push_back(std::move(job));
+    }
+    wake_.notify_one();
   }
 
-  amber::Result result;
-  std::vector<std::string> failures;
-  struct RecipeData {
-    std::string file;
-    std::unique_ptr<amber::Recipe> recipe;
-  };
-  std::vector<RecipeData> recipe_data;
-  for (const auto& file : options.input_filenames) {
-    auto data = ReadFile(file);
-    if (data.empty()) {
-      std::cerr << file << " is empty." << std::endl;
-      failures.push_back(file);
-      continue;
+  void Finish() {
+    if (!writer_.joinable())
+      return;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      done_ = true;
     }
+    wake_.notify_one();
+    writer_.join();
+  }
 
-    amber::Amber am;
-    std::unique_ptr<amber::Recipe> recipe = amber::MakeUnique<amber::Recipe>();
+ private:
+  void Run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+      wake_.wait(lock, [this]() { return done_ || !jobs_.empty(); });
+      if (jobs_.empty()) {
+        if (done_)
+          break;
+        continue;
+      }
 
-    result = am.Parse(data, recipe.get());
-    if (!result.IsSuccess()) {
-      std::cerr << file << ": " << result.Error() << std::endl;
-      failures.push_back(file);
-      continue;
+      std::function<amber::Result()> job = std::move(jobs_.front());
+      jobs_.pop_front();
+      lock.unlock();
+      amber::Result r = job();
+      if (!r.IsSuccess())
+        std::cerr << r.Error() << std::endl;
+      lock.lock();
     }
-
-    recipe_data.emplace_back();
-    recipe_data.back().file = file;
-    recipe_data.back().recipe = std::move(recipe);
   }
 
-  if (options.parse_only)
-    return 0;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::deque<std::function<amber::Result()>> jobs_;
+  bool done_ = false;
+  std::thread writer_;
+};
 
-  amber::Options amber_options;
-  amber_options.engine = options.engine;
+// 64-bit FNV-1a over |size| bytes at |data|, continuing |hash|.
+uint64_t HashBytes(uint64_t hash, const void* data, size_t size) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
 
-  std::set<std::string> required_features;
-  std::set<std::string> required_extensions;
-  for (const auto& recipe_data_elem : recipe_data) {
-    const auto features = recipe_data_elem.recipe->GetRequiredFeatures();
-    required_features.insert(features.begin(), features.end());
+// Computes the result cache key of one (script, device) combination
+// into |key|. The serialized recipe covers the script and every shader
+// it carries, |device_identity| covers the GPU and its driver, and the
+// Amber version stands in for the compiled SPIR-V: the binaries depend
+// only on the shader sources and the compiler toolchain this build
+// pins, and compiling them just to hash them would cost most of what
+// the cache saves. Returns false when the recipe cannot be serialized.
+bool ComputeResultKey(const amber::Recipe& recipe,
+                      const std::string& device_identity,
+                      uint64_t* key) {
+  std::vector<uint8_t> serialized;
+  if (!recipe.Serialize(&serialized).IsSuccess())
+    return false;
 
-    const auto extensions = recipe_data_elem.recipe->GetRequiredExtensions();
-    required_extensions.insert(extensions.begin(), extensions.end());
+  uint64_t hash = 0xcbf29ce484222325ull;
+  hash = HashBytes(hash, serialized.data(), serialized.size());
+  hash = HashBytes(hash, device_identity.data(), device_identity.size());
+  hash = HashBytes(hash, AMBER_VERSION, strlen(AMBER_VERSION));
+
+  // The serialized recipe stores only the paths of external data files
+  // and reference images; hash their contents too, so editing one
+  // invalidates the cached verdict. A missing file contributes just its
+  // path and still fails at execution time.
+  for (const auto& path : recipe.GetReferencedDataFiles()) {
+    hash = HashBytes(hash, path.data(), path.size());
+    MappedFile map(path);
+    if (map.data())
+      hash = HashBytes(hash, map.data(), map.size());
   }
 
-  sample::ConfigHelper config_helper;
-  auto config = config_helper.CreateConfig(
-      amber_options.engine,
-      std::vector<std::string>(required_features.begin(),
-                               required_features.end()),
-      std::vector<std::string>(required_extensions.begin(),
-                               required_extensions.end()));
+  *key = hash;
+  return true;
+}
+
+// On-disk cache of per-script verdicts for incremental runs, keyed by
+// ComputeResultKey(). A hit means the same script ran on the same
+// device and driver with the same Amber before, so the batch loop can
+// report the stored verdict without executing. Workers on several
+// threads store concurrently; Save() rewrites the file once at the end
+// of the run when anything changed.
+class ResultCache {
+ public:
+  struct Entry {
+    bool pass = false;
+    uint64_t wall_ns = 0;
+  };
 
-  amber_options.config = config.get();
+  bool Enabled() const { return !path_.empty(); }
 
-  if (!options.buffer_filename.empty()) {
-    // TODO(dsinclair): Write buffer file
-    assert(false);
+  // Reads the cache at |path|, once; a missing or malformed file leaves
+  // the cache empty and every script executes.
+  void Load(const std::string& path) {
+    path_ = path;
+    if (path_.empty())
+      return;
+
+    std::ifstream file(path_);
+    if (!file.is_open())
+      return;
+
+    std::string tag;
+    uint32_t version = 0;
+    if (!(file >> tag >> version) || tag != "amber-result-cache" ||
+        version != 1) {
+      return;
+    }
+
+    uint64_t key = 0;
+    std::string verdict;
+    uint64_t wall_ns = 0;
+    while (file >> key >> verdict >> wall_ns) {
+      if (verdict != "PASS" && verdict != "FAIL")
+        return;
+      Entry entry;
+      entry.pass = verdict == "PASS";
+      entry.wall_ns = wall_ns;
+      entries_[key] = entry;
+    }
   }
 
-  if (!options.image_filename.empty()) {
-    amber::BufferInfo buffer_info;
-    buffer_info.buffer_name = "framebuffer";
-    amber_options.extractions.push_back(buffer_info);
+  bool Lookup(uint64_t key, Entry* entry) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it == entries_.end())
+      return false;
+    *entry = it->second;
+    return true;
   }
 
-  for (const auto& recipe_data_elem : recipe_data) {
-    const auto* recipe = recipe_data_elem.recipe.get();
-    const auto& file = recipe_data_elem.file;
+  void Store(uint64_t key, const Entry& entry) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_[key] = entry;
+    dirty_ = true;
+  }
 
-    amber::Amber am;
-    result = am.Execute(recipe, &amber_options);
-    if (!result.IsSuccess()) {
-      std::cerr << file << ": " << result.Error() << std::endl;
-      failures.push_back(file);
-      continue;
+  // Rewrites the cache file with the merged entries. Entries of scripts
+  // not in this run survive, so sharded corpora share one cache file
+  // per machine.
+  void Save() {
+    if (path_.empty() || !dirty_)
+      return;
+    dirty_ = false;
+
+    std::ofstream file(path_, std::ios::trunc);
+    if (!file.is_open()) {
+      std::cerr << "Cannot open result cache file: " << path_ << std::endl;
+      return;
     }
 
-    if (!options.image_filename.empty()) {
-      std::string image;
-      for (amber::BufferInfo buffer_info : amber_options.extractions) {
-        if (buffer_info.buffer_name == "framebuffer") {
-          std::tie(result, image) = ppm::ConvertToPPM(
-              buffer_info.width, buffer_info.height, buffer_info.values);
-          break;
-        }
-      }
-      if (!result.IsSuccess()) {
-        std::cerr << result.Error() << std::endl;
-        continue;
-      }
-      std::ofstream image_file;
-      image_file.open(options.image_filename, std::ios::out | std::ios::binary);
-      if (!image_file.is_open()) {
-        std::cerr << "Cannot open file for image dump: ";
-        std::cerr << options.image_filename << std::endl;
-        continue;
-      }
-      image_file << image;
-      image_file.close();
+    file << "amber-result-cache 1\n";
+    for (const auto& entry : entries_) {
+      file << entry.first << (entry.second.pass ? " PASS " : " FAIL ")
+           << entry.second.wall_ns << "\n";
     }
   }
 
+ private:
+  std::string path_;
+  std::mutex mutex_;
+  std::map<uint64_t, Entry> entries_;
+  bool dirty_ = false;
+};
+
+// On-disk record of each script's last measured wall time, keyed by its
+// input name. The batch loop sorts the work queue longest-first from
+// it, so with several executing workers a long script cannot be pulled
+// last and stretch the whole run past everyone else's finish. Save()
+// rewrites the file once at the end of the run; entries of scripts not
+// in this run survive.
+class TimingCache {
+ public:
+  bool Enabled() const { return !path_.empty(); }
+
+  // Reads the cache at |path|, once; a missing or malformed file leaves
+  // the cache empty and the work queue in input order.
+  void Load(const std::string& path) {
+    path_ = path;
+    if (path_.empty())
+      return;
+
+    std::ifstream file(path_);
+    if (!file.is_open())
+      return;
+
+    std::string tag;
+    uint32_t version = 0;
+    if (!(file >> tag >> version) || tag != "amber-timing-cache" ||
+        version != 1) {
+      return;
+    }
+
+    // One "<wall_ns> <name>" line per script; the name runs to the end
+    // of the line so paths with spaces round trip.
+    uint64_t wall_ns = 0;
+    while (file >> wall_ns) {
+      std::string name;
+      if (!std::getline(file, name))
+        return;
+      if (!name.empty() && name[0] == ' ')
+        name.erase(0, 1);
+      if (name.empty())
+        return;
+      entries_[name] = wall_ns;
+    }
+  }
+
+  // Returns true and sets |wall_ns| when a time is recorded for |name|.
+  bool GetDuration(const std::string& name, uint64_t* wall_ns) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(name);
+    if (it == entries_.end())
+      return false;
+    *wall_ns = it->second;
+    return true;
+  }
+
+  void Store(const std::string& name, uint64_t wall_ns) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_[name] = wall_ns;
+    dirty_ = true;
+  }
+
+  void Save() {
+    if (path_.empty() || !dirty_)
+      return;
+    dirty_ = false;
+
+    std::ofstream file(path_, std::ios::trunc);
+    if (!file.is_open()) {
+      std::cerr << "Cannot open timing cache file: " << path_ << std::endl;
+      return;
+    }
+
+    file << "amber-timing-cache 1\n";
+    for (const auto& entry : entries_)
+      file << entry.second << " " << entry.first << "\n";
+  }
+
+ private:
+  std::string path_;
+  std::mutex mutex_;
+  std::map<std::string, uint64_t> entries_;
+  bool dirty_ = false;
+};
+
+double ToMiB(uint64_t bytes) {
+  return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+// Set by the SIGINT handler to end an open-ended --soak run after the
+// current iteration.
+bool soak_stop_requested = false;
+
+void HandleSoakInterrupt(int) {
+  soak_stop_requested = true;
+}
+
+// Prints min, median and p95 of |times_ns| in milliseconds, labelled
+// with the script file and the kind of time measured.
+void PrintIterationTimes(const std::string& file,
+                         const char* label,
+                         std::vector<uint64_t> times_ns) {
+  if (times_ns.empty())
+    return;
+
+  std::sort(times_ns.begin(), times_ns.end());
+  auto percentile = [&times_ns](double p) {
+    size_t index = static_cast<size_t>(
+        p * static_cast<double>(times_ns.size() - 1) + 0.5);
+    return static_cast<double>(times_ns[index]) / 1000000.0;
+  };
+
+  std::cout << file << ": " << label << " min " << percentile(0.0)
+            << "ms median " << percentile(0.5) << "ms p95 " << percentile(0.95)
+            << "ms over " << times_ns.size() << " iterations" << std::endl;
+}
+
+// One row of the --report file; all times in nanoseconds.
+struct ReportEntry {
+  std::string file;
+  bool pass = false;
+  uint64_t parse_ns = 0;
+  uint64_t compile_ns = 0;
+  uint64_t pipeline_ns = 0;
+  uint64_t execute_ns = 0;
+  uint64_t verify_ns = 0;
+  uint64_t gpu_ns = 0;
+  uint64_t wall_ns = 0;
+};
+
+std::string JsonEscape(const std::string& text) {
+  std::string out;
+  for (char c : text) {
+    if (c == '"' || c == '\\')
+      out += '\\';
+    out += c;
+  }
+  return out;
+}
+
+// Writes the per-script performance report collected over the run as
+// JSON, or as CSV when |filename| ends in .csv; see --report. Either
+// form carries one entry per executed script plus totals.
+amber::Result WriteReport(const std::string& filename,
+                          const std::vector<ReportEntry>& entries) {
+  std::ofstream file(filename, std::ios::trunc);
+  if (!file.is_open())
+    return amber::Result("Cannot open report file: " + filename);
+
+  ReportEntry totals;
+  size_t failure_count = 0;
+  for (const auto& entry : entries) {
+    totals.parse_ns += entry.parse_ns;
+    totals.compile_ns += entry.compile_ns;
+    totals.pipeline_ns += entry.pipeline_ns;
+    totals.execute_ns += entry.execute_ns;
+    totals.verify_ns += entry.verify_ns;
+    totals.gpu_ns += entry.gpu_ns;
+    totals.wall_ns += entry.wall_ns;
+    if (!entry.pass)
+      ++failure_count;
+  }
+
+  auto write_times = [&file](const ReportEntry& entry, char sep) {
+    file << entry.parse_ns << sep << entry.compile_ns << sep
+         << entry.pipeline_ns << sep << entry.execute_ns << sep
+         << entry.verify_ns << sep << entry.gpu_ns << sep << entry.wall_ns;
+  };
+
+  if (HasSuffix(filename, ".csv")) {
+    file << "file,pass,parse_ns,compile_ns,pipeline_ns,execute_ns,verify_ns,"
+            "gpu_ns,wall_ns\n";
+    for (const auto& entry : entries) {
+      file << entry.file << ',' << (entry.pass ? 1 : 0) << ',';
+      write_times(entry, ',');
+      file << '\n';
+    }
+    file << "TOTAL," << (failure_count == 0 ? 1 : 0) << ',';
+    write_times(totals, ',');
+    file << '\n';
+    return {};
+  }
+
+  auto write_json_times = [&file](const ReportEntry& entry) {
+    file << "\"parse_ns\": " << entry.parse_ns
+         << ", \"compile_ns\": " << entry.compile_ns
+         << ", \"pipeline_ns\": " << entry.pipeline_ns
+         << ", \"execute_ns\": " << entry.execute_ns
+         << ", \"verify_ns\": " << entry.verify_ns
+         << ", \"gpu_ns\": " << entry.gpu_ns
+         << ", \"wall_ns\": " << entry.wall_ns;
+  };
+
+  file << "{\n  \"tests\": [\n";
+  for (size_t i = 0; i < entries.size(); ++i) {
+    file << "    {\"file\": \"" << JsonEscape(entries[i].file)
+         << "\", \"pass\": " << (entries[i].pass ? "true" : "false") << ", ";
+    write_json_times(entries[i]);
+    file << (i + 1 < entries.size() ? "},\n" : "}\n");
+  }
+  file << "  ],\n  \"totals\": {\"tests\": " << entries.size()
+       << ", \"failures\": " << failure_count << ", ";
+  write_json_times(totals);
+  file << "}\n}\n";
+  return {};
+}
+
+// Executes script paths read from stdin, one per line, printing a PASS
+// or FAIL line per script. The instance, device and compiler contexts
+// are created once and the engine is reused across scripts, so a
+// harness driving the pipe pays the startup cost a single time instead
+// of on every script. Returns the process exit code.
+int RunServer(const Options& options) {
+  amber::Options amber_options;
+  amber_options.engine = options.engine;
+  amber_options.reuse_engine = true;
+
+  // The scripts are not known yet, so the device is created without any
+  // optional features or extensions.
+  sample::ConfigHelper config_helper;
+  config_helper.SetEnumerationCachePath(options.enumeration_cache_filename);
+  auto configs =
+      config_helper.CreateConfigs(amber_options.engine, 1,
+                                  std::vector<std::string>(),
+                                  std::vector<std::string>());
+  amber_options.config = configs[0].get();
+
+  // One Amber object for the whole session keeps the cached engine and
+  // the compiler state alive between scripts.
+  auto am = amber::MakeUnique<amber::Amber>();
+
+  std::string line;
+  while (std::getline(std::cin, line)) {
+    // Writers on the other end of a pipe may terminate lines with CRLF.
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+    if (line.empty())
+      continue;
+    if (line == "quit")
+      break;
+
+    auto data = ReadFile(line);
+    if (data.empty()) {
+      std::cout << "FAIL " << line << ": file is empty or unreadable"
+                << std::endl;
+      continue;
+    }
+
+    amber::Recipe recipe;
+    amber::Result result = am->Parse(data, &recipe);
+    if (result.IsSuccess()) {
+      // Execute() fills per-script output fields in the options, so each
+      // script gets a fresh copy.
+      amber::Options script_options = amber_options;
+      result = am->Execute(&recipe, &script_options);
+    }
+
+    // std::endl flushes, so the harness sees the verdict as soon as the
+    // script finishes.
+    if (result.IsSuccess())
+      std::cout << "PASS " << line << std::endl;
+    else
+      std::cout << "FAIL " << line << ": " << result.Error() << std::endl;
+  }
+
+  // The engine holds device objects; drop it before the device goes.
+  am.reset();
+  config_helper.Shutdown();
+  return 0;
+}
+
+// Re-executes the single input script whenever its file changes,
+// printing a PASS or FAIL line with the run's wall time after each
+// execution. The instance, device, engine and compiler caches are
+// created once and stay warm, so an edit costs only the re-parse and
+// the execution itself instead of full process startup. The file is
+// polled by content hash at a short interval: portable where inotify
+// and kqueue are not, quiet across the partial states editors save
+// through, and well inside the poll budget for script-sized files.
+// Runs until the process is interrupted.
+int RunWatch(const Options& options) {
+  if (options.input_filenames.size() != 1) {
+    std::cerr << "--watch requires exactly one input file." << std::endl;
+    return 1;
+  }
+  const std::string& file = options.input_filenames[0];
+
+  amber::Options amber_options;
+  amber_options.engine = options.engine;
+  amber_options.reuse_engine = true;
+
+  auto am = amber::MakeUnique<amber::Amber>();
+
+  // The device is created from the first version of the script, so the
+  // features and extensions it requires are honoured; an edit adding
+  // new ones needs a restart. A script that does not parse yet gets a
+  // device without optional features.
+  amber::Recipe first_recipe;
+  auto first_data = ReadFile(file);
+  if (!first_data.empty()) {
+    amber::Result parsed = am->Parse(first_data, &first_recipe);
+    if (!parsed.IsSuccess())
+      std::cerr << file << ": " << parsed.Error() << std::endl;
+  }
+
+  sample::ConfigHelper config_helper;
+  config_helper.SetEnumerationCachePath(options.enumeration_cache_filename);
+  auto configs = config_helper.CreateConfigs(
+      amber_options.engine, 1, first_recipe.GetRequiredFeatures(),
+      first_recipe.GetRequiredExtensions());
+  amber_options.config = configs[0].get();
+
+  std::cout << "Watching " << file << "; stop with Ctrl-C." << std::endl;
+
+  uint64_t last_hash = 0;
+  for (;;) {
+    // Mapping instead of ReadFile() keeps the poll quiet while the file
+    // is missing or empty mid-save.
+    std::string contents;
+    {
+      MappedFile map(file);
+      if (map.data())
+        contents.assign(map.data(), map.size());
+    }
+
+    uint64_t hash = 0;
+    if (!contents.empty()) {
+      hash =
+          HashBytes(0xcbf29ce484222325ull, contents.data(), contents.size());
+    }
+
+    if (hash != 0 && hash != last_hash) {
+      last_hash = hash;
+
+      const auto start = std::chrono::steady_clock::now();
+      amber::Recipe recipe;
+      amber::Result result = am->Parse(contents, &recipe);
+      if (result.IsSuccess()) {
+        // Execute() fills per-run output fields in the options, so each
+        // run gets a fresh copy.
+        amber::Options run_options = amber_options;
+        result = am->Execute(&recipe, &run_options);
+      }
+      const double wall_ms =
+          static_cast<double>(
+              std::chrono::duration_cast<std::chrono::microseconds>(
+                  std::chrono::steady_clock::now() - start)
+                  .count()) /
+          1000.0;
+
+      // Queued validation messages belong ahead of the verdict line.
+      sample::LogFlush();
+      if (result.IsSuccess())
+        std::cout << "PASS " << file << " (" << wall_ms << "ms)" << std::endl;
+      else
+        std::cout << "FAIL " << file << ": " << result.Error() << std::endl;
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+}
+
+// Writes one "PASS <script>" or "FAIL <script>" line per executed
+// script, in input order, so the shards of a split corpus can be
+// aggregated with the merge form.
+void WriteShardResults(const Options& options,
+                       const std::vector<std::string>& failures) {
+  if (options.shard_results_filename.empty())
+    return;
+
+  const std::set<std::string> failed(failures.begin(), failures.end());
+
+  std::ofstream file(options.shard_results_filename, std::ios::out);
+  if (!file.is_open()) {
+    std::cerr << "Cannot open shard results file: "
+              << options.shard_results_filename << std::endl;
+    return;
+  }
+
+  for (const auto& input : options.input_filenames) {
+    file << (failed.count(input) ? "FAIL " : "PASS ") << input << "\n";
+  }
+}
+
+// Aggregates the --shard-results files named on the command line,
+// printing every failure and a combined summary. Returns the process
+// exit code: non-zero when a shard file is unreadable or recorded a
+// failure.
+int RunMerge(const std::vector<std::string>& args) {
+  if (args.size() < 3) {
+    std::cerr << "merge requires at least one results file." << std::endl;
+    return 1;
+  }
+
+  size_t pass_count = 0;
+  std::vector<std::string> failures;
+  bool read_error = false;
+
+  for (size_t i = 2; i < args.size(); ++i) {
+    std::ifstream file(args[i]);
+    if (!file.is_open()) {
+      std::cerr << "Cannot open shard results file: " << args[i] << std::endl;
+      read_error = true;
+      continue;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+      if (!line.empty() && line.back() == '\r')
+        line.pop_back();
+      if (line.compare(0, 5, "PASS ") == 0) {
+        ++pass_count;
+      } else if (line.compare(0, 5, "FAIL ") == 0) {
+        failures.push_back(line.substr(5));
+      } else if (!line.empty()) {
+        std::cerr << args[i] << ": unrecognized result line: " << line
+                  << std::endl;
+        read_error = true;
+      }
+    }
+  }
+
+  if (!failures.empty()) {
+    std::cout << "\nSummary of Failures:" << std::endl;
+    for (const auto& failure : failures)
+      std::cout << "  " << failure << std::endl;
+  }
+
+  std::cout << "\nSummary: " << pass_count << " pass, " << failures.size()
+            << " fail" << std::endl;
+
+  return (!failures.empty() || read_error) ? 1 : 0;
+}
+
+// Parses the scripts named on the command line and packs their parsed
+// recipes into one indexed archive, written to the file named after
+// "bundle". Returns the process exit code.
+int RunBundle(const std::vector<std::string>& args) {
+  if (args.size() < 4) {
+    std::cerr << "bundle requires an output file and at least one script."
+              << std::endl;
+    return 1;
+  }
+
+  amber::RecipeBundleWriter writer;
+  amber::Amber parser;
+  for (size_t i = 3; i < args.size(); ++i) {
+    auto data = ReadFile(args[i]);
+    if (data.empty()) {
+      std::cerr << args[i] << " is empty." << std::endl;
+      return 1;
+    }
+
+    amber::Recipe recipe;
+    amber::Result result = parser.Parse(data, &recipe);
+    if (!result.IsSuccess()) {
+      std::cerr << args[i] << ": " << result.Error() << std::endl;
+      return 1;
+    }
+
+    result = writer.Add(args[i], recipe);
+    if (!result.IsSuccess()) {
+      std::cerr << args[i] << ": " << result.Error() << std::endl;
+      return 1;
+    }
+  }
+
+  std::vector<uint8_t> archive;
+  amber::Result result = writer.Write(&archive);
+  if (!result.IsSuccess()) {
+    std::cerr << result.Error() << std::endl;
+    return 1;
+  }
+
+  std::ofstream file(args[2], std::ios::out | std::ios::binary);
+  if (!file.is_open()) {
+    std::cerr << "Cannot open bundle file: " << args[2] << std::endl;
+    return 1;
+  }
+  file.write(reinterpret_cast<const char*>(archive.data()),
+             static_cast<std::streamsize>(archive.size()));
+  file.close();
+  if (file.fail()) {
+    std::cerr << "Failed writing bundle file: " << args[2] << std::endl;
+    return 1;
+  }
+
+  std::cout << (args.size() - 3) << " recipes bundled into " << args[2]
+            << std::endl;
+  return 0;
+}
+
+// Writes the collected profile to the -T file, if one was requested.
+void WriteTrace(const Options& options) {
+  if (options.trace_filename.empty())
+    return;
+
+  amber::Result result =
+      amber::Profiler::Get()->WriteChromeTrace(options.trace_filename);
+  if (!result.IsSuccess())
+    std::cerr << result.Error() << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, const char** argv) {
+  std::vector<std::string> args(argv, argv + argc);
+  Options options;
+
+  // The merge form aggregates shard result files and runs no scripts.
+  if (args.size() > 1 && args[1] == "merge")
+    return RunMerge(args);
+
+  // The bundle form packs parsed scripts into one archive and runs none.
+  if (args.size() > 1 && args[1] == "bundle")
+    return RunBundle(args);
+
+  if (!ParseArgs(args, &options)) {
+    std::cerr << "Failed to parse arguments." << std::endl;
+    return 1;
+  }
+
+  if (options.show_version_info) {
+    std::cout << "Amber        : " << AMBER_VERSION << std::endl;
+#if AMBER_ENABLE_SPIRV_TOOLS
+    std::cout << "SPIRV-Tools  : " << SPIRV_TOOLS_VERSION << std::endl;
+    std::cout << "SPIRV-Headers: " << SPIRV_HEADERS_VERSION << std::endl;
+#endif  // AMBER_ENABLE_SPIRV_TOOLS
+#if AMBER_ENABLE_SHADERC
+    std::cout << "GLSLang      : " << GLSLANG_VERSION << std::endl;
+    std::cout << "Shaderc      : " << SHADERC_VERSION << std::endl;
+#endif  // AMBER_ENABLE_SHADERC
+  }
+
+  if (options.show_help) {
+    std::cout << kUsage << std::endl;
+    return 0;
+  }
+
+  // Server mode takes its scripts from stdin instead of argv.
+  if (options.server_mode)
+    return RunServer(options);
+
+  // Watch mode re-runs its one script on every edit until interrupted.
+  if (options.watch_mode)
+    return RunWatch(options);
+
+  // Replaying a trace needs a device but no scripts.
+  if (!options.replay_trace_filename.empty()) {
+    amber::Options amber_options;
+    amber_options.engine = options.engine;
+
+    sample::ConfigHelper config_helper;
+    config_helper.SetEnumerationCachePath(options.enumeration_cache_filename);
+    auto configs =
+        config_helper.CreateConfigs(amber_options.engine, 1,
+                                    std::vector<std::string>(),
+                                    std::vector<std::string>());
+    amber_options.config = configs[0].get();
+
+    amber::Amber am;
+    amber::Result result =
+        am.ReplayEngineTrace(options.replay_trace_filename, &amber_options);
+    config_helper.Shutdown();
+
+    if (!result.IsSuccess()) {
+      std::cerr << result.Error() << std::endl;
+      return 1;
+    }
+    return 0;
+  }
+
+  if (options.input_filenames.empty()) {
+    std::cerr << "Input file must be provided." << std::endl;
+    return 2;
+  }
+
+  // A bundle input expands to one pseudo input per archive entry, named
+  // <bundle>:<entry>, before sharding so a corpus archive spreads over
+  // the shards like a plain file list. The archive stays mapped for the
+  // whole run and an entry's bytes are only read when a worker loads
+  // it, so each shard faults in just its own recipes and the read-only
+  // pages are shared with every other amber process mapping the file.
+  struct BundleData {
+    std::unique_ptr<MappedFile> file;
+    amber::RecipeBundleReader reader;
+  };
+  struct InputSource {
+    std::string name;
+    // Parse the file at |name| when |bundle| is null; otherwise load
+    // entry |bundle_entry| from |bundle|.
+    amber::RecipeBundleReader* bundle = nullptr;
+    size_t bundle_entry = 0;
+  };
+  std::vector<std::unique_ptr<BundleData>> bundles;
+  std::vector<InputSource> sources;
+  std::vector<std::string> failures;
+  for (const auto& file : options.input_filenames) {
+    auto bundle = amber::MakeUnique<BundleData>();
+    bundle->file = amber::MakeUnique<MappedFile>(file);
+    const auto* data =
+        reinterpret_cast<const uint8_t*>(bundle->file->data());
+    if (!data ||
+        !amber::RecipeBundleReader::IsBundle(data, bundle->file->size())) {
+      InputSource source;
+      source.name = file;
+      sources.push_back(source);
+      continue;
+    }
+
+    amber::Result result = bundle->reader.Open(data, bundle->file->size());
+    if (!result.IsSuccess()) {
+      std::cerr << file << ": " << result.Error() << std::endl;
+      failures.push_back(file);
+      continue;
+    }
+    for (size_t i = 0; i < bundle->reader.GetRecipeCount(); ++i) {
+      InputSource source;
+      source.name = file + ":" + bundle->reader.GetRecipeName(i);
+      source.bundle = &bundle->reader;
+      source.bundle_entry = i;
+      sources.push_back(source);
+    }
+    bundles.push_back(std::move(bundle));
+  }
+
+  if (options.shard_count > 0) {
+    if (options.shard_index >= options.shard_count) {
+      std::cerr << "Invalid value for --shard-index, must be less than the "
+                   "--shard-count of "
+                << options.shard_count << "." << std::endl;
+      return 1;
+    }
+
+    // Round-robin by position in the input list: script i belongs to
+    // shard i mod M. Every machine handed the same list computes the
+    // same split, and adjacent heavy scripts spread over the shards.
+    std::vector<InputSource> shard_sources;
+    for (size_t i = 0; i < sources.size(); ++i) {
+      if (static_cast<int64_t>(i) % options.shard_count ==
+          options.shard_index) {
+        shard_sources.push_back(sources[i]);
+      }
+    }
+    sources = std::move(shard_sources);
+  } else if (options.shard_index != 0) {
+    std::cerr << "--shard-index requires --shard-count." << std::endl;
+    return 1;
+  }
+
+  // The summary counts and shard result lines name what actually ran:
+  // this shard's inputs, with bundles expanded to their entries.
+  options.input_filenames.clear();
+  for (const auto& source : sources)
+    options.input_filenames.push_back(source.name);
+
+  // Enabled before any parsing so the whole run is covered.
+  if (!options.trace_filename.empty())
+    amber::Profiler::Get()->Enable();
+
+  struct RecipeData {
+    std::string file;
+    std::unique_ptr<amber::Recipe> recipe;
+    // Set for a bundle entry; |recipe| stays null until the first
+    // worker claiming the script loads it.
+    amber::RecipeBundleReader* bundle = nullptr;
+    size_t bundle_entry = 0;
+    // Wall time of this script's parse, for --report. Zero for bundle
+    // entries, which arrive already parsed.
+    uint64_t parse_ns = 0;
+  };
+  std::vector<RecipeData> recipe_data;
+
+  // Bundle entries are already parsed, so only plain files go through
+  // the parser; |parse_slots| maps each source to its parse result.
+  const size_t kNotParsed = std::numeric_limits<size_t>::max();
+  std::vector<size_t> parse_slots(sources.size(), kNotParsed);
+  std::vector<std::string> parse_inputs;
+
+  // The reads go wide: on network-backed storage each open stalls for a
+  // round trip, and a large corpus would otherwise pay them one after
+  // another.
+  std::vector<std::string> file_data(sources.size());
+  {
+    std::atomic<size_t> next_read(0);
+    auto read_worker = [&sources, &file_data, &next_read]() {
+      for (;;) {
+        size_t i = next_read.fetch_add(1);
+        if (i >= sources.size())
+          break;
+        if (!sources[i].bundle)
+          file_data[i] = ReadFile(sources[i].name);
+      }
+    };
+
+    size_t thread_count = std::thread::hardware_concurrency();
+    if (thread_count == 0)
+      thread_count = 1;
+    thread_count = std::min(thread_count, sources.size());
+
+    std::vector<std::thread> readers;
+    for (size_t i = 1; i < thread_count; ++i)
+      readers.emplace_back(read_worker);
+    read_worker();
+    for (auto& reader : readers)
+      reader.join();
+  }
+
+  for (size_t i = 0; i < sources.size(); ++i) {
+    if (sources[i].bundle)
+      continue;
+
+    if (file_data[i].empty()) {
+      std::cerr << sources[i].name << " is empty." << std::endl;
+      failures.push_back(sources[i].name);
+      continue;
+    }
+    parse_slots[i] = parse_inputs.size();
+    parse_inputs.push_back(std::move(file_data[i]));
+  }
+
+  std::vector<std::unique_ptr<amber::Recipe>> parsed_recipes;
+  std::vector<amber::Recipe*> parse_recipes;
+  for (size_t i = 0; i < parse_inputs.size(); ++i) {
+    parsed_recipes.push_back(amber::MakeUnique<amber::Recipe>());
+    parse_recipes.push_back(parsed_recipes.back().get());
+  }
+
+  amber::Amber parser;
+  std::vector<amber::Result> parse_results;
+  std::vector<uint64_t> parse_durations;
+  parser.ParseAll(parse_inputs, &parse_recipes, &parse_results,
+                  &parse_durations);
+  for (size_t i = 0; i < sources.size(); ++i) {
+    if (sources[i].bundle) {
+      recipe_data.emplace_back();
+      recipe_data.back().file = sources[i].name;
+      recipe_data.back().bundle = sources[i].bundle;
+      recipe_data.back().bundle_entry = sources[i].bundle_entry;
+      continue;
+    }
+
+    const size_t slot = parse_slots[i];
+    if (slot == kNotParsed)
+      continue;
+    if (!parse_results[slot].IsSuccess()) {
+      std::cerr << sources[i].name << ": " << parse_results[slot].Error()
+                << std::endl;
+      failures.push_back(sources[i].name);
+      continue;
+    }
+
+    recipe_data.emplace_back();
+    recipe_data.back().file = sources[i].name;
+    recipe_data.back().recipe = std::move(parsed_recipes[slot]);
+    recipe_data.back().parse_ns = parse_durations[slot];
+  }
+
+  // Longest-first order of the shared work queue, from the previous
+  // run's recorded wall times. Scripts without a recorded time go
+  // first: an unknown script may be the longest of all, and putting it
+  // last would recreate the problem the ordering removes. The stable
+  // sort keeps input order within each group.
+  TimingCache timing_cache;
+  timing_cache.Load(options.timing_cache_filename);
+  if (timing_cache.Enabled()) {
+    std::stable_sort(
+        recipe_data.begin(), recipe_data.end(),
+        [&timing_cache](const RecipeData& a, const RecipeData& b) {
+          uint64_t a_ns = 0;
+          uint64_t b_ns = 0;
+          const bool a_known = timing_cache.GetDuration(a.file, &a_ns);
+          const bool b_known = timing_cache.GetDuration(b.file, &b_ns);
+          if (a_known != b_known)
+            return !a_known;
+          return a_ns > b_ns;
+        });
+  }
+
+  if (options.parse_only) {
+    WriteShardResults(options, failures);
+    WriteTrace(options);
+    return 0;
+  }
+
+  if (options.validate_only) {
+    // Compilation needs no engine, so the corpus lints on machines
+    // without the target GPU; the parses above already ran parallel.
+    // Bundle entries arrive parsed but still need loading here.
+    amber::Amber validator;
+    std::atomic<size_t> next_validate(0);
+    std::mutex validate_mutex;
+
+    auto validate_worker = [&]() {
+      for (;;) {
+        size_t index = next_validate.fetch_add(1);
+        if (index >= recipe_data.size())
+          break;
+
+        auto& data = recipe_data[index];
+        amber::Result result;
+        if (!data.recipe && data.bundle) {
+          auto recipe = amber::MakeUnique<amber::Recipe>();
+          result = data.bundle->LoadRecipe(data.bundle_entry, recipe.get());
+          if (result.IsSuccess())
+            data.recipe = std::move(recipe);
+        }
+        if (result.IsSuccess())
+          result = validator.PrecompileShaders(data.recipe.get(), nullptr);
+
+        if (!result.IsSuccess()) {
+          std::lock_guard<std::mutex> lock(validate_mutex);
+          std::cerr << data.file << ": " << result.Error() << std::endl;
+          failures.push_back(data.file);
+        }
+      }
+    };
+
+    size_t thread_count = std::thread::hardware_concurrency();
+    if (thread_count == 0)
+      thread_count = 1;
+    thread_count = std::min(thread_count, recipe_data.size());
+
+    std::vector<std::thread> validators;
+    for (size_t i = 0; i < thread_count; ++i)
+      validators.emplace_back(validate_worker);
+    for (auto& validator_thread : validators)
+      validator_thread.join();
+
+    if (options.show_summary) {
+      std::cout << "Summary: "
+                << (options.input_filenames.size() - failures.size())
+                << " pass, " << failures.size() << " fail" << std::endl;
+    }
+
+    WriteShardResults(options, failures);
+    WriteTrace(options);
+    sample::LogFlush();
+    return !failures.empty();
+  }
+
+  amber::Options amber_options;
+  amber_options.engine = options.engine;
+  amber_options.engine_trace_path = options.record_trace_filename;
+
+  std::set<std::string> required_features;
+  std::set<std::string> required_extensions;
+  for (const auto& recipe_data_elem : recipe_data) {
+    // Bundle entries carry theirs in the archive index, keeping the
+    // recipe blobs untouched until execution.
+    if (recipe_data_elem.bundle) {
+      const auto& features = recipe_data_elem.bundle->GetRequiredFeatures(
+          recipe_data_elem.bundle_entry);
+      required_features.insert(features.begin(), features.end());
+
+      const auto& extensions = recipe_data_elem.bundle->GetRequiredExtensions(
+          recipe_data_elem.bundle_entry);
+      required_extensions.insert(extensions.begin(), extensions.end());
+      continue;
+    }
+
+    const auto& features = recipe_data_elem.recipe->GetRequiredFeatures();
+    required_features.insert(features.begin(), features.end());
+
+    const auto& extensions = recipe_data_elem.recipe->GetRequiredExtensions();
+    required_extensions.insert(extensions.begin(), extensions.end());
+  }
+
+  // One config, and so one worker, per GPU the scripts are spread over.
+  // The default of a single device keeps the old serial behaviour.
+  uint32_t max_devices = options.device_count == 0
+                             ? std::numeric_limits<uint32_t>::max()
+                             : static_cast<uint32_t>(options.device_count);
+  // Differential runs pair one device of each engine.
+  if (options.diff_mode)
+    max_devices = 1;
+
+  sample::ConfigHelper config_helper;
+  config_helper.SetEnumerationCachePath(options.enumeration_cache_filename);
+  auto configs = config_helper.CreateConfigs(
+      amber_options.engine, max_devices,
+      std::vector<std::string>(required_features.begin(),
+                               required_features.end()),
+      std::vector<std::string>(required_extensions.begin(),
+                               required_extensions.end()));
+
+  if (!options.buffer_filename.empty()) {
+    amber::BufferInfo buffer_info;
+    buffer_info.buffer_name = std::to_string(options.buffer_binding_index);
+    amber_options.extractions.push_back(buffer_info);
+  }
+
+  if (!options.image_filename.empty()) {
+    amber::BufferInfo buffer_info;
+    buffer_info.buffer_name = "framebuffer";
+    amber_options.extractions.push_back(buffer_info);
+  }
+
+  // The second engine of a differential run gets its own device, created
+  // with the same feature and extension union as the first.
+  sample::ConfigHelper diff_config_helper;
+  std::vector<std::unique_ptr<amber::EngineConfig>> diff_configs;
+  amber::Options diff_options;
+  if (options.diff_mode) {
+    diff_options.engine = options.diff_engine;
+    diff_config_helper.SetEnumerationCachePath(
+        options.enumeration_cache_filename);
+    diff_configs = diff_config_helper.CreateConfigs(
+        diff_options.engine, 1,
+        std::vector<std::string>(required_features.begin(),
+                                 required_features.end()),
+        std::vector<std::string>(required_extensions.begin(),
+                                 required_extensions.end()));
+    diff_options.config = diff_configs[0].get();
+  }
+
+  // Engines created for the first recipe of each worker are kept alive
+  // and reused for the rest of them.
+  amber_options.reuse_engine = true;
+
+  amber_options.repeat_count = static_cast<uint32_t>(options.repeat_count);
+  amber_options.warmup_count = static_cast<uint32_t>(options.warmup_count);
+  // Repeated runs report GPU time per iteration, which needs the
+  // engine's command timestamps.
+  if (options.repeat_count > 1)
+    amber_options.enable_command_timings = true;
+
+  if (options.soak_count >= 0) {
+    // A --soak of 0 means run until the SIGINT handler trips the stop
+    // flag.
+    amber_options.soak_iterations =
+        options.soak_count == 0 ? std::numeric_limits<uint64_t>::max()
+                                : static_cast<uint64_t>(options.soak_count);
+    amber_options.soak_stop = &soak_stop_requested;
+    amber_options.enable_command_timings = true;
+    std::signal(SIGINT, HandleSoakInterrupt);
+  }
+
+  // The report includes GPU time per script, which needs the engine's
+  // command timestamps.
+  if (!options.report_filename.empty())
+    amber_options.enable_command_timings = true;
+
+  // Each device gets its own Amber object on its own thread. The workers
+  // pull recipes from a shared index so a slow script on one GPU does not
+  // leave the others idle, and failures from every device land in the one
+  // |failures| list.
+  std::atomic<size_t> next_recipe(0);
+  std::mutex result_mutex;
+  ArtifactWriter artifact_writer;
+  // Per-script rows of the --report file, appended by the workers under
+  // |result_mutex| and written once after they join.
+  std::vector<ReportEntry> report_entries;
+
+  if (options.soak_count >= 0) {
+    // Window records print as they complete, so a days-long run reports
+    // live instead of at the end.
+    amber_options.soak_record_callback =
+        [&result_mutex](const amber::SoakRecord& record) {
+          std::lock_guard<std::mutex> lock(result_mutex);
+          std::cout << "soak iteration " << record.iteration << ": gpu median "
+                    << record.median_gpu_ns / 1000 << "us p99 "
+                    << record.p99_gpu_ns / 1000 << "us, wall median "
+                    << record.median_wall_ns / 1000 << "us p99 "
+                    << record.p99_wall_ns / 1000 << "us, rss "
+                    << ToMiB(record.resident_set_bytes) << "MiB, device "
+                    << ToMiB(record.device_memory_bytes) << "MiB" << std::endl;
+          if (record.alert) {
+            std::cerr << "soak ALERT at iteration " << record.iteration << ": "
+                      << record.alert_message << std::endl;
+          }
+        };
+  }
+
+  // Loaded before the workers start; hits skip execution below unless
+  // --force. Identities line up with |configs|; engines without one get
+  // the empty string, which still keys consistently across runs.
+  ResultCache result_cache;
+  result_cache.Load(options.result_cache_filename);
+  std::vector<std::string> device_identities =
+      config_helper.GetDeviceIdentities();
+  device_identities.resize(configs.size());
+
+  // Pipeline pre-warm: -j worker threads race ahead of the executing
+  // workers, compiling each script's shaders onto its recipe and
+  // building its pipeline state objects into the device's shared
+  // pipeline cache, so the driver's compile threads work while the GPU
+  // executes earlier scripts. A state of 0 means untouched, 1 claimed,
+  // 2 prewarmed; an executing worker that claims a script first just
+  // compiles it inline as before.
+  struct CompileState {
+    std::atomic<int> state{0};
+  };
+  std::vector<CompileState> compile_states(recipe_data.size());
+  std::mutex compile_mutex;
+  std::condition_variable compile_cv;
+  std::atomic<size_t> next_compile(0);
+
+  // Materializes a bundle entry's recipe; a no-op for parsed files and
+  // already-loaded entries. This is where the entry's pages of the
+  // mapped archive are first touched. The claim protocol above hands
+  // each script to one thread at a time, so no lock is needed here.
+  auto load_recipe = [](RecipeData* data) -> amber::Result {
+    if (data->recipe || !data->bundle)
+      return {};
+
+    auto recipe = amber::MakeUnique<amber::Recipe>();
+    amber::Result result =
+        data->bundle->LoadRecipe(data->bundle_entry, recipe.get());
+    if (result.IsSuccess())
+      data->recipe = std::move(recipe);
+    return result;
+  };
+
+  auto compile_worker = [&](amber::EngineConfig* config) {
+    amber::Options prewarm_options = amber_options;
+    prewarm_options.config = config;
+    amber::Amber prewarmer;
+
+    for (;;) {
+      size_t index = next_compile.fetch_add(1);
+      if (index >= recipe_data.size())
+        break;
+
+      int expected = 0;
+      if (!compile_states[index].state.compare_exchange_strong(expected, 1))
+        continue;
+
+      // Errors are dropped here on purpose; the executing worker
+      // rediscovers and reports them in the usual way.
+      if (load_recipe(&recipe_data[index]).IsSuccess()) {
+        prewarmer.PrewarmPipelines(recipe_data[index].recipe.get(),
+                                   &prewarm_options);
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(compile_mutex);
+        compile_states[index].state.store(2);
+      }
+      compile_cv.notify_all();
+    }
+  };
+
+  auto run_recipes = [&](amber::EngineConfig* config,
+                         const std::string& device_identity) {
+    amber::Options worker_options = amber_options;
+    worker_options.config = config;
+
+    auto am = amber::MakeUnique<amber::Amber>();
+
+    for (;;) {
+      size_t index = next_recipe.fetch_add(1);
+      if (index >= recipe_data.size())
+        break;
+
+      const auto& file = recipe_data[index].file;
+
+      // Claim the script for inline compilation, or wait for the compile
+      // worker that got there first to finish with it.
+      int expected = 0;
+      if (!compile_states[index].state.compare_exchange_strong(expected, 1)) {
+        std::unique_lock<std::mutex> lock(compile_mutex);
+        compile_cv.wait(lock, [&compile_states, index]() {
+          return compile_states[index].state.load() == 2;
+        });
+      }
+
+      // A bundle entry the compile worker loaded is visible through the
+      // state handshake above; otherwise this worker loads it now.
+      amber::Result load_result = load_recipe(&recipe_data[index]);
+      if (!load_result.IsSuccess()) {
+        std::lock_guard<std::mutex> lock(result_mutex);
+        std::cerr << file << ": " << load_result.Error() << std::endl;
+        failures.push_back(file);
+        continue;
+      }
+      const auto* recipe = recipe_data[index].recipe.get();
+
+      // Differential runs stay out of the cache: the key does not cover
+      // the second engine's device.
+      uint64_t cache_key = 0;
+      const bool cacheable =
+          result_cache.Enabled() && !options.diff_mode &&
+          ComputeResultKey(*recipe, device_identity, &cache_key);
+
+      ResultCache::Entry cached;
+      if (cacheable && !options.force_execution &&
+          result_cache.Lookup(cache_key, &cached)) {
+        if (!cached.pass) {
+          std::lock_guard<std::mutex> lock(result_mutex);
+          std::cerr << file << ": failed an identical earlier run (cached)"
+                    << std::endl;
+          failures.push_back(file);
+        }
+        continue;
+      }
+
+      // Command timings otherwise accumulate across the worker's
+      // scripts; the report wants this script's alone.
+      if (!options.report_filename.empty())
+        worker_options.command_timings.clear();
+
+      const auto wall_start = std::chrono::steady_clock::now();
+
+      amber::Result result;
+      if (options.diff_mode) {
+        amber::Options secondary_options = diff_options;
+        result =
+            am->ExecuteDifferential(recipe, &worker_options, &secondary_options);
+      } else {
+        result = am->Execute(recipe, &worker_options);
+      }
+
+      const uint64_t wall_ns = static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now() - wall_start)
+              .count());
+
+      if (cacheable) {
+        ResultCache::Entry entry;
+        entry.pass = result.IsSuccess();
+        entry.wall_ns = wall_ns;
+        result_cache.Store(cache_key, entry);
+      }
+
+      if (timing_cache.Enabled())
+        timing_cache.Store(file, wall_ns);
+
+      if (!options.report_filename.empty()) {
+        ReportEntry entry;
+        entry.file = file;
+        entry.pass = result.IsSuccess();
+        entry.parse_ns = recipe_data[index].parse_ns;
+        entry.compile_ns = worker_options.phase_timings.compile_ns;
+        entry.pipeline_ns = worker_options.phase_timings.pipeline_ns;
+        entry.execute_ns = worker_options.phase_timings.execute_ns;
+        entry.verify_ns = worker_options.phase_timings.verify_ns;
+        for (const auto& timing : worker_options.command_timings)
+          entry.gpu_ns += timing.gpu_duration_ns;
+        entry.wall_ns = wall_ns;
+
+        std::lock_guard<std::mutex> lock(result_mutex);
+        report_entries.push_back(std::move(entry));
+      }
+
+      if (!result.IsSuccess()) {
+        std::lock_guard<std::mutex> lock(result_mutex);
+        // Queued validation messages belong ahead of the failure line.
+        sample::LogFlush();
+        std::cerr << file << ": " << result.Error() << std::endl;
+        failures.push_back(file);
+        continue;
+      }
+
+      if (!worker_options.repeat_wall_times_ns.empty()) {
+        std::lock_guard<std::mutex> lock(result_mutex);
+        PrintIterationTimes(file, "wall", worker_options.repeat_wall_times_ns);
+        PrintIterationTimes(file, "gpu", worker_options.repeat_gpu_times_ns);
+      }
+
+      if (options.show_memory_report &&
+          !worker_options.memory_heap_usage.empty()) {
+        std::lock_guard<std::mutex> lock(result_mutex);
+        for (const auto& heap : worker_options.memory_heap_usage) {
+          std::cout << file << ": memory heap " << heap.heap_index << " peak "
+                    << ToMiB(heap.peak_bytes) << "MiB (buffers "
+                    << ToMiB(heap.peak_buffer_bytes) << "MiB, images "
+                    << ToMiB(heap.peak_image_bytes) << "MiB), live at end "
+                    << ToMiB(heap.live_bytes) << "MiB" << std::endl;
+        }
+      }
+
+      if (!options.buffer_filename.empty()) {
+        const std::string wanted = std::to_string(options.buffer_binding_index);
+        amber::BufferInfo* buffer = nullptr;
+        for (amber::BufferInfo& buffer_info : worker_options.extractions) {
+          if (buffer_info.buffer_name == wanted) {
+            buffer = &buffer_info;
+            break;
+          }
+        }
+
+        if (buffer) {
+          // The bytes move into the queued job, so the next script can
+          // start while this dump lands on disk. Raw bytes in one write
+          // by default; -t opts into the slower hex text formatting.
+          auto data = std::make_shared<std::vector<uint8_t>>(
+              std::move(buffer->raw_data));
+          const std::string filename = options.buffer_filename;
+          const bool as_text = options.buffer_as_text;
+          artifact_writer.Enqueue([filename, as_text, data]() {
+            return as_text ? WriteBufferText(filename, *data)
+                           : WriteBufferBinary(filename, *data);
+          });
+        }
+      }
+
+      if (!options.image_filename.empty()) {
+        amber::BufferInfo* framebuffer = nullptr;
+        for (amber::BufferInfo& buffer_info : worker_options.extractions) {
+          if (buffer_info.buffer_name == "framebuffer") {
+            framebuffer = &buffer_info;
+            break;
+          }
+        }
+
+        if (framebuffer) {
+          // The writers stream the raw framebuffer bytes straight to
+          // disk instead of building the image in memory first. Files
+          // named *.png get the compact PNG encoding. The bytes move
+          // into the queued job like the buffer dump above.
+          auto data = std::make_shared<std::vector<uint8_t>>(
+              std::move(framebuffer->raw_data));
+          const std::string filename = options.image_filename;
+          const uint32_t width = framebuffer->width;
+          const uint32_t height = framebuffer->height;
+          artifact_writer.Enqueue([filename, width, height, data]() {
+            if (HasSuffix(filename, ".png")) {
+              return png::WriteToPNGFile(filename, width, height, *data);
+            }
+            return ppm::WriteToPPMFile(filename, width, height, *data);
+          });
+        }
+      }
+    }
+
+    // Shut the worker's engine down before the device it was created on
+    // can be torn down below.
+    am.reset();
+  };
+
+  std::vector<std::thread> compile_threads;
+  for (int64_t i = 0; i < options.compile_thread_count; ++i) {
+    compile_threads.emplace_back(
+        compile_worker,
+        configs[static_cast<size_t>(i) % configs.size()].get());
+  }
+
+  // Read-ahead: while a recipe executes, this thread warms what the
+  // next few will need - the mapped blob pages of upcoming bundle
+  // entries and the external data files of upcoming scripts - so
+  // execution does not stall on cold storage. Plain recipes are
+  // immutable by now; a bundle entry's recipe loads under the claim
+  // protocol, so only its mapped blob is touched here.
+  std::atomic<bool> prefetch_stop(false);
+  std::thread prefetch_thread([&recipe_data, &next_recipe, &prefetch_stop]() {
+    const size_t kReadAhead = 8;
+    for (size_t index = 0; index < recipe_data.size(); ++index) {
+      while (!prefetch_stop && index > next_recipe.load() + kReadAhead)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      if (prefetch_stop)
+        return;
+
+      const auto& data = recipe_data[index];
+      if (data.bundle) {
+        data.bundle->PrefetchRecipe(data.bundle_entry);
+        continue;
+      }
+      if (!data.recipe)
+        continue;
+      for (const auto& path : data.recipe->GetReferencedDataFiles())
+        PrefetchFile(path);
+    }
+  });
+
+  if (configs.size() == 1) {
+    run_recipes(configs[0].get(), device_identities[0]);
+  } else {
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < configs.size(); ++i)
+      workers.emplace_back(run_recipes, configs[i].get(), device_identities[i]);
+    for (auto& worker : workers)
+      worker.join();
+  }
+
+  for (auto& thread : compile_threads)
+    thread.join();
+
+  prefetch_stop = true;
+  prefetch_thread.join();
+
+  // All artifacts must be on disk before the summary and exit code.
+  artifact_writer.Finish();
+
+  result_cache.Save();
+  timing_cache.Save();
+
+  // Every differential engine has shut down with its worker's Amber
+  // object by now, so its device can follow.
+  if (options.diff_mode)
+    diff_config_helper.Shutdown();
+
   if (options.show_summary) {
     if (!failures.empty()) {
       std::cout << "\nSummary of Failures:" << std::endl;
@@ -312,5 +2162,16 @@ int main(int argc, const char** argv) {
     config_helper.Shutdown();
   }
 
+  if (!options.report_filename.empty()) {
+    amber::Result report_result =
+        WriteReport(options.report_filename, report_entries);
+    if (!report_result.IsSuccess())
+      std::cerr << report_result.Error() << std::endl;
+  }
+
+  WriteShardResults(options, failures);
+  WriteTrace(options);
+
+  sample::LogFlush();
   return !failures.empty();
 }
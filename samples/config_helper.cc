@@ -30,6 +30,16 @@ namespace sample {
 
 ConfigHelperImpl::~ConfigHelperImpl() = default;
 
+std::vector<std::unique_ptr<amber::EngineConfig>>
+ConfigHelperImpl::CreateConfigs(
+    uint32_t,
+    const std::vector<std::string>& required_features,
+    const std::vector<std::string>& required_extensions) {
+  std::vector<std::unique_ptr<amber::EngineConfig>> configs;
+  configs.push_back(CreateConfig(required_features, required_extensions));
+  return configs;
+}
+
 ConfigHelper::ConfigHelper() = default;
 
 ConfigHelper::~ConfigHelper() = default;
@@ -44,8 +54,46 @@ std::unique_ptr<amber::EngineConfig> ConfigHelper::CreateConfig(
 #if AMBER_ENGINE_VULKAN
   impl_ = amber::MakeUnique<ConfigHelperVulkan>();
 #endif  // AMBER_ENGINE_VULKAN
-  return impl_ ? impl_->CreateConfig(required_features, required_extensions)
-               : nullptr;
+  if (!impl_)
+    return nullptr;
+
+  impl_->SetEnumerationCachePath(enumeration_cache_path_);
+  return impl_->CreateConfig(required_features, required_extensions);
+}
+
+std::vector<std::unique_ptr<amber::EngineConfig>> ConfigHelper::CreateConfigs(
+    amber::EngineType engine,
+    uint32_t max_devices,
+    const std::vector<std::string>& required_features,
+    const std::vector<std::string>& required_extensions) {
+  std::vector<std::unique_ptr<amber::EngineConfig>> configs;
+  if (engine == amber::kEngineTypeDawn || max_devices == 0) {
+    // The engine creates its own single device; one worker with no
+    // external config keeps the old behaviour.
+    configs.push_back(nullptr);
+    return configs;
+  }
+
+#if AMBER_ENGINE_VULKAN
+  impl_ = amber::MakeUnique<ConfigHelperVulkan>();
+#endif  // AMBER_ENGINE_VULKAN
+  if (!impl_) {
+    configs.push_back(nullptr);
+    return configs;
+  }
+  impl_->SetEnumerationCachePath(enumeration_cache_path_);
+  return impl_->CreateConfigs(max_devices, required_features,
+                              required_extensions);
+}
+
+void ConfigHelper::SetEnumerationCachePath(const std::string& path) {
+  enumeration_cache_path_ = path;
+}
+
+std::vector<std::string> ConfigHelper::GetDeviceIdentities() const {
+  if (!impl_)
+    return {};
+  return impl_->GetDeviceIdentities();
 }
 
 void ConfigHelper::Shutdown() {
@@ -36,6 +36,26 @@ class ConfigHelperImpl {
       const std::vector<std::string>& required_features,
       const std::vector<std::string>& required_extensions) = 0;
 
+  // Like CreateConfig() but returns one config per usable GPU, up to
+  // |max_devices| of them. The base implementation returns the single
+  // config of CreateConfig(); backends able to drive several physical
+  // devices override it.
+  virtual std::vector<std::unique_ptr<amber::EngineConfig>> CreateConfigs(
+      uint32_t max_devices,
+      const std::vector<std::string>& required_features,
+      const std::vector<std::string>& required_extensions);
+
+  // Uses |path| as an on-disk cache of startup enumeration results, for
+  // backends whose enumeration round trips are expensive. The base
+  // implementation ignores it.
+  virtual void SetEnumerationCachePath(const std::string&) {}
+
+  // Returns one identity string per config of the last CreateConfig()
+  // or CreateConfigs() call, stable while the device and its driver are
+  // unchanged. Backends without a cheap identity return an empty
+  // vector, which is what the base implementation does.
+  virtual std::vector<std::string> GetDeviceIdentities() const { return {}; }
+
   // Destroy instance and device.
   virtual void Shutdown() = 0;
 };
@@ -56,11 +76,32 @@ class ConfigHelper {
       const std::vector<std::string>& required_features,
       const std::vector<std::string>& required_extensions);
 
+  // Create one config per usable GPU, up to |max_devices| of them, so
+  // the caller can spread work over every device in the machine. For
+  // engines without multi device support the vector holds the single
+  // config CreateConfig() would have returned.
+  std::vector<std::unique_ptr<amber::EngineConfig>> CreateConfigs(
+      amber::EngineType engine,
+      uint32_t max_devices,
+      const std::vector<std::string>& required_features,
+      const std::vector<std::string>& required_extensions);
+
+  // Caches enumeration results of later CreateConfig() calls in the
+  // file at |path|, so repeated launches skip the startup enumeration
+  // round trips. Empty disables caching, which is the default.
+  void SetEnumerationCachePath(const std::string& path);
+
+  // Returns one identity string per config of the last CreateConfig()
+  // or CreateConfigs() call; empty strings for backends without a cheap
+  // device identity.
+  std::vector<std::string> GetDeviceIdentities() const;
+
   // Destroy instance and device.
   void Shutdown();
 
  private:
   std::unique_ptr<ConfigHelperImpl> impl_;
+  std::string enumeration_cache_path_;
 };
 
 }  // namespace sample
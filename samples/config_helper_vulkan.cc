@@ -18,7 +18,9 @@
 #include <algorithm>
 #include <cassert>
 #include <cstring>
+#include <fstream>
 #include <set>
+#include <utility>
 
 #include "samples/log.h"
 
@@ -652,22 +654,153 @@ uint32_t ChooseQueueFamilyIndex(const VkPhysicalDevice& physical_device) {
   return std::numeric_limits<uint32_t>::max();
 }
 
+// Identity string of |physical_device|, stable while the device and its
+// driver are unchanged.
+std::string DeviceIdentity(const VkPhysicalDevice& physical_device) {
+  VkPhysicalDeviceProperties properties = VkPhysicalDeviceProperties();
+  vkGetPhysicalDeviceProperties(physical_device, &properties);
+  return "vulkan:" + std::to_string(properties.vendorID) + ":" +
+         std::to_string(properties.deviceID) + ":" +
+         std::to_string(properties.driverVersion) + ":" +
+         std::to_string(properties.apiVersion);
+}
+
 }  // namespace
 
 ConfigHelperVulkan::ConfigHelperVulkan() = default;
 
 ConfigHelperVulkan::~ConfigHelperVulkan() = default;
 
+void ConfigHelperVulkan::SetEnumerationCachePath(const std::string& path) {
+  enumeration_cache_path_ = path;
+}
+
+std::vector<std::string> ConfigHelperVulkan::GetDeviceIdentities() const {
+  return device_identities_;
+}
+
+void ConfigHelperVulkan::LoadEnumerationCache() {
+  if (enumeration_cache_path_.empty() || enumeration_cache_loaded_)
+    return;
+  enumeration_cache_loaded_ = true;
+
+  std::ifstream file(enumeration_cache_path_);
+  if (!file.is_open())
+    return;
+
+  // The members are only assigned once the whole file parsed, so a
+  // truncated or malformed cache simply falls back to re-querying.
+  std::string tag;
+  uint32_t version = 0;
+  if (!(file >> tag >> version) || tag != "amber-enum-cache" || version != 1)
+    return;
+
+  int layers = -1;
+  int layer_extensions = -1;
+  if (!(file >> tag) || tag != "validation" ||
+      !(file >> layers >> layer_extensions)) {
+    return;
+  }
+
+  std::vector<CachedDeviceInfo> devices;
+  while (file >> tag) {
+    if (tag != "device")
+      return;
+
+    CachedDeviceInfo info;
+    size_t extension_count = 0;
+    if (!(file >> info.vendor_id >> info.device_id >> info.driver_version >>
+          info.api_version >> extension_count)) {
+      return;
+    }
+    for (size_t i = 0; i < extension_count; ++i) {
+      std::string name;
+      if (!(file >> name))
+        return;
+      info.extensions.push_back(name);
+    }
+    devices.push_back(std::move(info));
+  }
+
+  cached_layer_support_ = layers;
+  cached_layer_extension_support_ = layer_extensions;
+  cached_devices_ = std::move(devices);
+}
+
+void ConfigHelperVulkan::SaveEnumerationCache() {
+  if (enumeration_cache_path_.empty() || !enumeration_cache_dirty_)
+    return;
+  enumeration_cache_dirty_ = false;
+
+  std::ofstream file(enumeration_cache_path_, std::ios::trunc);
+  if (!file.is_open())
+    return;
+
+  file << "amber-enum-cache 1\n";
+  file << "validation " << cached_layer_support_ << " "
+       << cached_layer_extension_support_ << "\n";
+  for (const auto& info : cached_devices_) {
+    file << "device " << info.vendor_id << " " << info.device_id << " "
+         << info.driver_version << " " << info.api_version << " "
+         << info.extensions.size() << "\n";
+    for (const auto& extension : info.extensions)
+      file << extension << "\n";
+  }
+}
+
+std::vector<std::string> ConfigHelperVulkan::GetDeviceExtensions(
+    const VkPhysicalDevice& physical_device) {
+  VkPhysicalDeviceProperties properties = VkPhysicalDeviceProperties();
+  vkGetPhysicalDeviceProperties(physical_device, &properties);
+
+  // The property query is a single cheap call; only a matching identity
+  // lets the cached list stand in for the extension enumeration round
+  // trips.
+  for (const auto& info : cached_devices_) {
+    if (info.vendor_id == properties.vendorID &&
+        info.device_id == properties.deviceID &&
+        info.driver_version == properties.driverVersion &&
+        info.api_version == properties.apiVersion) {
+      return info.extensions;
+    }
+  }
+
+  CachedDeviceInfo info;
+  info.vendor_id = properties.vendorID;
+  info.device_id = properties.deviceID;
+  info.driver_version = properties.driverVersion;
+  info.api_version = properties.apiVersion;
+  info.extensions = GetAvailableExtensions(physical_device);
+  cached_devices_.push_back(info);
+  enumeration_cache_dirty_ = true;
+  return info.extensions;
+}
+
 void ConfigHelperVulkan::CreateVulkanInstance() {
+  LoadEnumerationCache();
+
   VkApplicationInfo app_info = {};
   app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
   app_info.apiVersion = VK_MAKE_VERSION(1, 0, 0);
 
-  if (!AreAllValidationLayersSupported()) {
+  // The per-layer enumeration round trips dominate startup on mobile
+  // targets, so their boolean results are cached. Layer installs carry
+  // no identity that could be checked cheaply; deleting the cache file
+  // forces a re-query.
+  if (cached_layer_support_ < 0) {
+    cached_layer_support_ = AreAllValidationLayersSupported() ? 1 : 0;
+    enumeration_cache_dirty_ = true;
+  }
+  if (cached_layer_support_ != 1) {
     assert(false && "Sample: not all validation layers are supported");
   }
 
-  if (!AreAllValidationExtensionsSupported()) {
+  if (cached_layer_extension_support_ < 0) {
+    cached_layer_extension_support_ =
+        AreAllValidationExtensionsSupported() ? 1 : 0;
+    enumeration_cache_dirty_ = true;
+  }
+  if (cached_layer_extension_support_ != 1) {
     assert(false &&
            "Sample: extensions of validation layers are not supported");
   }
@@ -722,7 +855,7 @@ void ConfigHelperVulkan::ChooseVulkanPhysicalDevice(
       continue;
     }
 
-    available_extensions_ = GetAvailableExtensions(physical_devices[i]);
+    available_extensions_ = GetDeviceExtensions(physical_devices[i]);
     if (!AreAllExtensionsSupported(available_extensions_,
                                    required_extensions)) {
       continue;
@@ -766,6 +899,7 @@ void ConfigHelperVulkan::CreateVulkanDevice(
 
   assert(vkCreateDevice(vulkan_physical_device_, &info, nullptr,
                         &vulkan_device_) == VK_SUCCESS);
+  vulkan_devices_.push_back(vulkan_device_);
 }
 
 std::unique_ptr<amber::EngineConfig> ConfigHelperVulkan::CreateConfig(
@@ -779,6 +913,10 @@ std::unique_ptr<amber::EngineConfig> ConfigHelperVulkan::CreateConfig(
   CreateVulkanDevice(required_vulkan_features, required_extensions);
   vkGetDeviceQueue(vulkan_device_, vulkan_queue_family_index_, 0,
                    &vulkan_queue_);
+  SaveEnumerationCache();
+
+  device_identities_.clear();
+  device_identities_.push_back(DeviceIdentity(vulkan_physical_device_));
 
   std::unique_ptr<amber::EngineConfig> cfg_holder =
       std::unique_ptr<amber::EngineConfig>(new amber::VulkanEngineConfig());
@@ -795,9 +933,74 @@ std::unique_ptr<amber::EngineConfig> ConfigHelperVulkan::CreateConfig(
   return cfg_holder;
 }
 
+std::vector<std::unique_ptr<amber::EngineConfig>>
+ConfigHelperVulkan::CreateConfigs(
+    uint32_t max_devices,
+    const std::vector<std::string>& required_features,
+    const std::vector<std::string>& required_extensions) {
+  auto required_vulkan_features = NamesToVulkanFeatures(required_features);
+
+  CreateVulkanInstance();
+  CreateDebugReportCallback();
+
+  uint32_t count;
+  std::vector<VkPhysicalDevice> physical_devices;
+  assert(vkEnumeratePhysicalDevices(vulkan_instance_, &count, nullptr) ==
+         VK_SUCCESS);
+  physical_devices.resize(count);
+  assert(vkEnumeratePhysicalDevices(vulkan_instance_, &count,
+                                    physical_devices.data()) == VK_SUCCESS);
+
+  device_identities_.clear();
+  std::vector<std::unique_ptr<amber::EngineConfig>> configs;
+  for (uint32_t i = 0; i < count && configs.size() < max_devices; ++i) {
+    vkGetPhysicalDeviceFeatures(physical_devices[i], &available_features_);
+    if (!AreAllRequiredFeaturesSupported(available_features_,
+                                         required_vulkan_features)) {
+      continue;
+    }
+
+    available_extensions_ = GetDeviceExtensions(physical_devices[i]);
+    if (!AreAllExtensionsSupported(available_extensions_,
+                                   required_extensions)) {
+      continue;
+    }
+
+    vulkan_queue_family_index_ = ChooseQueueFamilyIndex(physical_devices[i]);
+    if (vulkan_queue_family_index_ == std::numeric_limits<uint32_t>::max())
+      continue;
+
+    vulkan_physical_device_ = physical_devices[i];
+    CreateVulkanDevice(required_vulkan_features, required_extensions);
+    vkGetDeviceQueue(vulkan_device_, vulkan_queue_family_index_, 0,
+                     &vulkan_queue_);
+
+    std::unique_ptr<amber::EngineConfig> cfg_holder =
+        std::unique_ptr<amber::EngineConfig>(new amber::VulkanEngineConfig());
+    amber::VulkanEngineConfig* config =
+        static_cast<amber::VulkanEngineConfig*>(cfg_holder.get());
+    config->physical_device = vulkan_physical_device_;
+    config->available_features = available_features_;
+    config->available_extensions = available_extensions_;
+    config->instance = vulkan_instance_;
+    config->queue_family_index = vulkan_queue_family_index_;
+    config->queue = vulkan_queue_;
+    config->device = vulkan_device_;
+    config->vkGetInstanceProcAddr = vkGetInstanceProcAddr;
+    configs.push_back(std::move(cfg_holder));
+    device_identities_.push_back(DeviceIdentity(vulkan_physical_device_));
+  }
+
+  SaveEnumerationCache();
+  assert(!configs.empty() && "Vulkan::No physical device supports Vulkan");
+  return configs;
+}
+
 void ConfigHelperVulkan::Shutdown() {
-  if (vulkan_device_ != VK_NULL_HANDLE)
-    vkDestroyDevice(vulkan_device_, nullptr);
+  for (auto device : vulkan_devices_) {
+    if (device != VK_NULL_HANDLE)
+      vkDestroyDevice(device, nullptr);
+  }
 
   auto vkDestroyDebugReportCallbackEXT =
       reinterpret_cast<PFN_vkDestroyDebugReportCallbackEXT>(
@@ -42,10 +42,52 @@ class ConfigHelperVulkan : public ConfigHelperImpl {
       const std::vector<std::string>& required_features,
       const std::vector<std::string>& required_extensions) override;
 
-  // Destroy Vulkan instance and device.
+  // Create one logical device and config per physical device that
+  // supports |required_features| and |required_extensions|, up to
+  // |max_devices| of them, sharing a single Vulkan instance.
+  std::vector<std::unique_ptr<amber::EngineConfig>> CreateConfigs(
+      uint32_t max_devices,
+      const std::vector<std::string>& required_features,
+      const std::vector<std::string>& required_extensions) override;
+
+  // Destroy Vulkan instance and all created devices.
   void Shutdown() override;
 
+  // Uses |path| as an on-disk cache of the instance layer checks and
+  // per-device extension lists, skipping their vkEnumerate* round trips
+  // on later launches. Device entries are validated against the cheap
+  // vkGetPhysicalDeviceProperties() identity, so a driver update or a
+  // device change re-queries and rewrites the entry.
+  void SetEnumerationCachePath(const std::string& path) override;
+
+  // Returns "vulkan:<vendor>:<device>:<driver>:<api>" for the physical
+  // device behind each created config, in creation order.
+  std::vector<std::string> GetDeviceIdentities() const override;
+
  private:
+  // One cached device entry; the identity fields invalidate it when the
+  // driver or device changes.
+  struct CachedDeviceInfo {
+    uint32_t vendor_id = 0;
+    uint32_t device_id = 0;
+    uint32_t driver_version = 0;
+    uint32_t api_version = 0;
+    std::vector<std::string> extensions;
+  };
+
+  // Reads the enumeration cache file, once; a missing or malformed file
+  // leaves the cache empty.
+  void LoadEnumerationCache();
+
+  // Writes the cache file back when a query result changed it.
+  void SaveEnumerationCache();
+
+  // Returns the available extensions of |physical_device|, from the
+  // enumeration cache when the device's identity matches a stored
+  // entry.
+  std::vector<std::string> GetDeviceExtensions(
+      const VkPhysicalDevice& physical_device);
+
   // Create Vulkan instance.
   void CreateVulkanInstance();
 
@@ -71,7 +113,24 @@ class ConfigHelperVulkan : public ConfigHelperImpl {
   std::vector<std::string> available_extensions_;
   uint32_t vulkan_queue_family_index_ = std::numeric_limits<uint32_t>::max();
   VkQueue vulkan_queue_ = VK_NULL_HANDLE;
+  // Most recently created logical device; every created device is also
+  // recorded in |vulkan_devices_| so Shutdown() can destroy them all.
   VkDevice vulkan_device_ = VK_NULL_HANDLE;
+  std::vector<VkDevice> vulkan_devices_;
+
+  // One identity string per created config; see GetDeviceIdentities().
+  std::vector<std::string> device_identities_;
+
+  std::string enumeration_cache_path_;
+  bool enumeration_cache_loaded_ = false;
+  bool enumeration_cache_dirty_ = false;
+  // Cached results of the validation layer and layer extension checks:
+  // -1 unknown, otherwise 0 or 1. Layer installs have no identity that
+  // can be checked cheaply, so these entries are trusted until the
+  // cache file is deleted.
+  int cached_layer_support_ = -1;
+  int cached_layer_extension_support_ = -1;
+  std::vector<CachedDeviceInfo> cached_devices_;
 };
 
 }  // namespace sample
@@ -19,7 +19,12 @@
 #ifdef __ANDROID__
 #include <android/log.h>
 #else  // __ANDROID__
+#include <condition_variable>
+#include <deque>
 #include <iostream>
+#include <mutex>
+#include <thread>
+#include <utility>
 #endif  // __ANDROID__
 
 namespace sample {
@@ -27,6 +32,80 @@ namespace {
 
 #ifdef __ANDROID__
 const char* kTAG = "Amber";
+#else  // __ANDROID__
+
+// Buffered asynchronous log sink. Messages are queued and written by a
+// single writer thread, so in verbose batch runs logging does not
+// serialize execution against slow stdio such as a network-mounted
+// home. Flush() blocks until everything queued so far is on the stream,
+// for callers about to report a failure. The queue is drained and the
+// writer joined when the process exits.
+class AsyncLog {
+ public:
+  static AsyncLog* Get() {
+    static AsyncLog instance;
+    return &instance;
+  }
+
+  void Write(std::string msg) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      queue_.push_back(std::move(msg));
+    }
+    wake_.notify_one();
+  }
+
+  void Flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    drained_.wait(lock, [this]() { return queue_.empty() && !writing_; });
+  }
+
+ private:
+  AsyncLog() : writer_(&AsyncLog::Run, this) {}
+
+  ~AsyncLog() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      done_ = true;
+    }
+    wake_.notify_one();
+    writer_.join();
+  }
+
+  void Run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+      wake_.wait(lock, [this]() { return done_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        if (done_)
+          break;
+        continue;
+      }
+
+      // The batch is written with the lock released so producers never
+      // wait on the stream; one flush per batch instead of per line.
+      std::deque<std::string> batch;
+      batch.swap(queue_);
+      writing_ = true;
+      lock.unlock();
+      for (const auto& msg : batch)
+        std::cerr << msg << "\n";
+      std::cerr << std::flush;
+      lock.lock();
+      writing_ = false;
+      drained_.notify_all();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable drained_;
+  std::deque<std::string> queue_;
+  bool writing_ = false;
+  bool done_ = false;
+  std::thread writer_;
+};
+
 #endif  // __ANDROID__
 
 }  // namespace
@@ -35,7 +114,13 @@ void LogError(const std::string& msg) {
 #ifdef __ANDROID__
   ((void)__android_log_print(ANDROID_LOG_ERROR, kTAG, "%s", msg.c_str()));
 #else   // __ANDROID__
-  std::cerr << msg << std::endl << std::flush;
+  AsyncLog::Get()->Write(msg);
+#endif  // __ANDROID__
+}
+
+void LogFlush() {
+#ifndef __ANDROID__
+  AsyncLog::Get()->Flush();
 #endif  // __ANDROID__
 }
 
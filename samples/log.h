@@ -20,8 +20,15 @@
 namespace sample {
 
 // This method is used for debug reports from Vulkan validation layers.
+// Messages are queued and written by a background thread; call
+// LogFlush() when ordering against other output matters.
 void LogError(const std::string& msg);
 
+// Blocks until every message passed to LogError() so far has been
+// written and the stream flushed. Call before reporting a failure so
+// queued validation messages land ahead of it.
+void LogFlush();
+
 }  // namespace sample
 
 #endif  // SAMPLES_LOG_H_
@@ -0,0 +1,259 @@
+// Copyright 2019 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "samples/png.h"
+
+#include <cassert>
+#include <fstream>
+#include <tuple>
+
+#include "amber/result.h"
+
+namespace png {
+namespace {
+
+// CRC32 with the PNG polynomial; the table is built on first use.
+const uint32_t* Crc32Table() {
+  static std::vector<uint32_t> table = []() {
+    std::vector<uint32_t> t(256);
+    for (uint32_t n = 0; n < 256; ++n) {
+      uint32_t c = n;
+      for (uint32_t k = 0; k < 8; ++k)
+        c = (c & 1U) ? 0xedb88320U ^ (c >> 1U) : c >> 1U;
+      t[n] = c;
+    }
+    return t;
+  }();
+  return table.data();
+}
+
+uint32_t Crc32(const uint8_t* data, size_t size) {
+  const uint32_t* table = Crc32Table();
+  uint32_t crc = 0xffffffffU;
+  for (size_t i = 0; i < size; ++i)
+    crc = table[(crc ^ data[i]) & 0xffU] ^ (crc >> 8U);
+  return crc ^ 0xffffffffU;
+}
+
+uint32_t Adler32(const uint8_t* data, size_t size) {
+  // The sums only need reducing every 5552 bytes to stay in 32 bits.
+  uint32_t a = 1;
+  uint32_t b = 0;
+  size_t i = 0;
+  while (i < size) {
+    size_t block_end = i + 5552;
+    if (block_end > size)
+      block_end = size;
+    for (; i < block_end; ++i) {
+      a += data[i];
+      b += a;
+    }
+    a %= 65521U;
+    b %= 65521U;
+  }
+  return (b << 16U) | a;
+}
+
+void AppendBigEndian(std::string* out, uint32_t value) {
+  out->push_back(static_cast<char>((value >> 24U) & 0xffU));
+  out->push_back(static_cast<char>((value >> 16U) & 0xffU));
+  out->push_back(static_cast<char>((value >> 8U) & 0xffU));
+  out->push_back(static_cast<char>(value & 0xffU));
+}
+
+// Appends one PNG chunk: length, 4 byte |type|, |data| and the CRC over
+// type and data.
+void AppendChunk(std::string* out, const char* type, const std::string& data) {
+  AppendBigEndian(out, static_cast<uint32_t>(data.size()));
+  const size_t crc_begin = out->size();
+  out->append(type, 4);
+  out->append(data);
+  AppendBigEndian(out,
+                  Crc32(reinterpret_cast<const uint8_t*>(out->data()) +
+                            crc_begin,
+                        4 + data.size()));
+}
+
+// Accumulates the deflate bit stream. Plain bit fields go in LSB first;
+// Huffman codes go in MSB first, so WriteHuffman() reverses them.
+class BitWriter {
+ public:
+  explicit BitWriter(std::string* out) : out_(out) {}
+
+  void WriteBits(uint32_t value, uint32_t count) {
+    bits_ |= value << bit_count_;
+    bit_count_ += count;
+    while (bit_count_ >= 8) {
+      out_->push_back(static_cast<char>(bits_ & 0xffU));
+      bits_ >>= 8U;
+      bit_count_ -= 8;
+    }
+  }
+
+  void WriteHuffman(uint32_t code, uint32_t length) {
+    uint32_t reversed = 0;
+    for (uint32_t i = 0; i < length; ++i)
+      reversed |= ((code >> i) & 1U) << (length - 1 - i);
+    WriteBits(reversed, length);
+  }
+
+  void AlignToByte() {
+    if (bit_count_ > 0) {
+      out_->push_back(static_cast<char>(bits_ & 0xffU));
+      bits_ = 0;
+      bit_count_ = 0;
+    }
+  }
+
+ private:
+  std::string* out_;
+  uint32_t bits_ = 0;
+  uint32_t bit_count_ = 0;
+};
+
+// Emits literal/length symbol |symbol| with the fixed Huffman code of
+// RFC 1951 section 3.2.6.
+void WriteFixedSymbol(BitWriter* writer, uint32_t symbol) {
+  if (symbol < 144) {
+    writer->WriteHuffman(0x30U + symbol, 8);
+  } else if (symbol < 256) {
+    writer->WriteHuffman(0x190U + symbol - 144, 9);
+  } else if (symbol < 280) {
+    writer->WriteHuffman(symbol - 256, 7);
+  } else {
+    writer->WriteHuffman(0xc0U + symbol - 280, 8);
+  }
+}
+
+// Length code bases and extra bit counts for symbols 257 to 285.
+const uint16_t kLengthBases[] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,
+                                 15, 17, 19, 23, 27, 31, 35, 43, 51,  59,
+                                 67, 83, 99, 115, 131, 163, 195, 227, 258};
+const uint8_t kLengthExtraBits[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1,
+                                    1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                                    4, 4, 4, 4, 5, 5, 5, 5, 0};
+
+// Emits a match of |length| bytes at distance one, i.e. "repeat the
+// previous byte |length| times".
+void WriteRepeat(BitWriter* writer, uint32_t length) {
+  uint32_t code = 28;
+  while (kLengthBases[code] > length)
+    --code;
+  WriteFixedSymbol(writer, 257 + code);
+  writer->WriteBits(length - kLengthBases[code], kLengthExtraBits[code]);
+  // Distance symbol 0, a five bit code of zeroes, is distance one.
+  writer->WriteHuffman(0, 5);
+}
+
+// Compresses |data| into a zlib stream holding one fixed Huffman deflate
+// block. The only matches used are distance one runs, which is where the
+// bulk of the win is for Sub filtered framebuffers: every flat color
+// region filters to a run of zero bytes.
+void DeflateFixed(const std::vector<uint8_t>& data, std::string* out) {
+  out->push_back(0x78);
+  out->push_back(0x01);
+
+  BitWriter writer(out);
+  writer.WriteBits(1, 1);  // Final block.
+  writer.WriteBits(1, 2);  // Fixed Huffman codes.
+
+  size_t i = 0;
+  while (i < data.size()) {
+    if (i > 0 && data[i] == data[i - 1]) {
+      size_t run = 1;
+      while (run < 258 && i + run < data.size() &&
+             data[i + run] == data[i - 1]) {
+        ++run;
+      }
+      if (run >= 3) {
+        WriteRepeat(&writer, static_cast<uint32_t>(run));
+        i += run;
+        continue;
+      }
+    }
+    WriteFixedSymbol(&writer, data[i]);
+    ++i;
+  }
+
+  WriteFixedSymbol(&writer, 256);  // End of block.
+  writer.AlignToByte();
+
+  AppendBigEndian(out, Adler32(data.data(), data.size()));
+}
+
+}  // namespace
+
+std::pair<amber::Result, std::string> ConvertToPNG(
+    uint32_t width,
+    uint32_t height,
+    const std::vector<uint8_t>& data) {
+  assert(data.size() == static_cast<size_t>(width) * height * 4);
+
+  // Sub filter every row: each byte has the matching byte of the pixel
+  // to its left subtracted, turning flat color regions into zero runs
+  // the deflate stage packs into a few bytes.
+  const size_t row_size = static_cast<size_t>(width) * 4;
+  std::vector<uint8_t> filtered;
+  filtered.reserve((row_size + 1) * height);
+  for (uint32_t y = 0; y < height; ++y) {
+    const uint8_t* row = data.data() + static_cast<size_t>(y) * row_size;
+    filtered.push_back(1);  // Sub filter.
+    for (size_t i = 0; i < row_size && i < 4; ++i)
+      filtered.push_back(row[i]);
+    for (size_t i = 4; i < row_size; ++i)
+      filtered.push_back(static_cast<uint8_t>(row[i] - row[i - 4]));
+  }
+
+  std::string image("\x89PNG\r\n\x1a\n", 8);
+
+  std::string ihdr;
+  AppendBigEndian(&ihdr, width);
+  AppendBigEndian(&ihdr, height);
+  ihdr.push_back(8);  // Bit depth.
+  ihdr.push_back(6);  // Color type RGBA.
+  ihdr.push_back(0);  // Compression method.
+  ihdr.push_back(0);  // Filter method.
+  ihdr.push_back(0);  // No interlace.
+  AppendChunk(&image, "IHDR", ihdr);
+
+  std::string idat;
+  DeflateFixed(filtered, &idat);
+  AppendChunk(&image, "IDAT", idat);
+
+  AppendChunk(&image, "IEND", std::string());
+
+  return std::make_pair(amber::Result(), image);
+}
+
+amber::Result WriteToPNGFile(const std::string& file_name,
+                             uint32_t width,
+                             uint32_t height,
+                             const std::vector<uint8_t>& data) {
+  amber::Result result;
+  std::string image;
+  std::tie(result, image) = ConvertToPNG(width, height, data);
+  if (!result.IsSuccess())
+    return result;
+
+  std::ofstream file(file_name, std::ios::out | std::ios::binary);
+  if (!file.is_open())
+    return amber::Result("Cannot open file for image dump: " + file_name);
+
+  file.write(image.data(), static_cast<std::streamsize>(image.size()));
+  if (!file.good())
+    return amber::Result("Failed to write image file: " + file_name);
+  return {};
+}
+
+}  // namespace png
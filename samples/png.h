@@ -0,0 +1,45 @@
+// Copyright 2019 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SAMPLES_PNG_H_
+#define SAMPLES_PNG_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "amber/amber.h"
+
+namespace png {
+
+/// Converts the image of dimensions |width| and |height| and with pixels
+/// stored in row-major order in |data| as tightly packed R8G8B8A8 bytes
+/// into PNG format, returning the PNG binary as a string. The encoder is
+/// self contained: rows are Sub filtered and compressed with a fixed
+/// Huffman deflate stream tuned for the flat color regions typical of
+/// test framebuffers, so no external compression library is needed.
+std::pair<amber::Result, std::string> ConvertToPNG(
+    uint32_t width,
+    uint32_t height,
+    const std::vector<uint8_t>& data);
+
+/// Encodes the image like ConvertToPNG() and writes it to |file_name|.
+amber::Result WriteToPNGFile(const std::string& file_name,
+                             uint32_t width,
+                             uint32_t height,
+                             const std::vector<uint8_t>& data);
+
+}  // namespace png
+
+#endif  // SAMPLES_PNG_H_
@@ -15,33 +15,17 @@
 #include "samples/ppm.h"
 
 #include <cassert>
+#include <fstream>
 
 #include "amber/result.h"
-#include "amber/value.h"
 
 namespace ppm {
 
-namespace {
-
-char byte0(uint32_t word) {
-  return static_cast<char>(word);
-}
-
-char byte1(uint32_t word) {
-  return static_cast<char>(word >> 8);
-}
-
-char byte2(uint32_t word) {
-  return static_cast<char>(word >> 16);
-}
-
-}  // namespace
-
 std::pair<amber::Result, std::string> ConvertToPPM(
     uint32_t width,
     uint32_t height,
-    const std::vector<amber::Value>& values) {
-  assert(values.size() == width * height);
+    const std::vector<uint8_t>& data) {
+  assert(data.size() == static_cast<size_t>(width) * height * 4);
 
   // Write PPM header
   const uint32_t maximum_color_value = 255;
@@ -49,17 +33,60 @@ std::pair<amber::Result, std::string> ConvertToPPM(
   image += std::to_string(width) + " " + std::to_string(height) + "\n";
   image += std::to_string(maximum_color_value) + "\n";
 
-  // Write PPM data
-  for (amber::Value value : values) {
-    const uint32_t pixel = value.AsUint32();
-    // We assume R8G8B8A8_UINT here:
-    image.push_back(byte0(pixel));  // R
-    image.push_back(byte1(pixel));  // G
-    image.push_back(byte2(pixel));  // B
-    // PPM does not support alpha channel
+  // Write PPM data. We assume R8G8B8A8_UINT here and PPM does not
+  // support the alpha channel.
+  for (size_t i = 0; i + 3 < data.size(); i += 4) {
+    image.push_back(static_cast<char>(data[i]));      // R
+    image.push_back(static_cast<char>(data[i + 1]));  // G
+    image.push_back(static_cast<char>(data[i + 2]));  // B
   }
 
   return std::make_pair(amber::Result(), image);
 }
 
+amber::Result WriteToPPMFile(const std::string& file_name,
+                             uint32_t width,
+                             uint32_t height,
+                             const std::vector<uint8_t>& data) {
+  assert(data.size() == static_cast<size_t>(width) * height * 4);
+
+  std::ofstream file(file_name, std::ios::out | std::ios::binary);
+  if (!file.is_open())
+    return amber::Result("Cannot open file for image dump: " + file_name);
+
+  const uint32_t maximum_color_value = 255;
+  file << "P6\n"
+       << width << " " << height << "\n"
+       << maximum_color_value << "\n";
+
+  // Rows are stripped of alpha into |chunk|, which is flushed in writes
+  // of about a megabyte rather than one syscall per row. We assume
+  // R8G8B8A8_UINT here and PPM does not support the alpha channel.
+  const size_t kChunkSize = 1 << 20;
+  const size_t row_size = static_cast<size_t>(width) * 4;
+  std::string chunk;
+  chunk.reserve(kChunkSize + static_cast<size_t>(width) * 3);
+
+  for (uint32_t y = 0; y < height; ++y) {
+    const uint8_t* row = data.data() + static_cast<size_t>(y) * row_size;
+    for (size_t i = 0; i + 3 < row_size; i += 4) {
+      chunk.push_back(static_cast<char>(row[i]));      // R
+      chunk.push_back(static_cast<char>(row[i + 1]));  // G
+      chunk.push_back(static_cast<char>(row[i + 2]));  // B
+    }
+
+    if (chunk.size() >= kChunkSize) {
+      file.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+      chunk.clear();
+    }
+  }
+
+  if (!chunk.empty())
+    file.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+
+  if (!file.good())
+    return amber::Result("Failed to write image file: " + file_name);
+  return {};
+}
+
 }  // namespace ppm
@@ -23,13 +23,22 @@
 
 namespace ppm {
 
-/// Converts the image of dimensions |width| and |height| and with pixels stored
-/// in row-major order in |values| with format R8G8B8A8 into PPM format,
-/// returning the PPM binary as a string.
+/// Converts the image of dimensions |width| and |height| and with pixels
+/// stored in row-major order in |data| as tightly packed R8G8B8A8 bytes
+/// into PPM format, returning the PPM binary as a string.
 std::pair<amber::Result, std::string> ConvertToPPM(
     uint32_t width,
     uint32_t height,
-    const std::vector<amber::Value>& values);
+    const std::vector<uint8_t>& data);
+
+/// Writes the image of dimensions |width| and |height| and with pixels
+/// stored in row-major order in |data| as tightly packed R8G8B8A8 bytes
+/// to |file_name| in PPM format. Rows are converted in bulk and streamed
+/// to disk in large writes instead of building the image in memory.
+amber::Result WriteToPPMFile(const std::string& file_name,
+                             uint32_t width,
+                             uint32_t height,
+                             const std::vector<uint8_t>& data);
 
 }  // namespace ppm
 
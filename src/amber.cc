@@ -14,26 +14,314 @@
 
 #include "amber/amber.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <future>
+#include <iterator>
 #include <memory>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
 
 #include "src/amberscript/parser.h"
 #include "src/engine.h"
+#include "src/engine_trace.h"
 #include "src/executor.h"
+#include "src/huge_alloc.h"
 #include "src/make_unique.h"
 #include "src/parser.h"
+#include "src/shader_compiler.h"
+#include "src/verifier.h"
 #include "src/vkscript/parser.h"
 
 namespace amber {
+namespace {
+
+// FNV-1a over the script text; collisions only cost a wasted cache probe
+// since the serialized blob is validated on load.
+uint64_t HashText(const std::string& text) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (char c : text) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+std::string CacheFilePath(const std::string& dir, const std::string& input) {
+  char name[32];
+  snprintf(name, sizeof(name), "%016llx.amberbin",
+           static_cast<unsigned long long>(HashText(input)));
+  return dir + "/" + name;
+}
+
+// Loads the serialized script at |path| into |recipe|. Returns false if the
+// file is missing or fails to deserialize; the caller falls back to parsing.
+bool LoadCachedScript(const std::string& path, amber::Recipe* recipe) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open())
+    return false;
+
+  std::vector<uint8_t> blob((std::istreambuf_iterator<char>(file)),
+                            std::istreambuf_iterator<char>());
+  return recipe->Deserialize(blob).IsSuccess();
+}
+
+// Best effort; a failed write just means the next run parses again.
+void StoreCachedScript(const std::string& path, const amber::Recipe& recipe) {
+  std::vector<uint8_t> blob;
+  if (!recipe.Serialize(&blob).IsSuccess())
+    return;
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file.is_open())
+    return;
+  file.write(reinterpret_cast<const char*>(blob.data()),
+             static_cast<std::streamsize>(blob.size()));
+}
+
+// Loads the pipeline cache blob at |path| into |data|; leaves it empty when
+// the file does not exist yet.
+void LoadPipelineCacheFile(const std::string& path,
+                           std::vector<uint8_t>* data) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open())
+    return;
+
+  data->assign(std::istreambuf_iterator<char>(file),
+               std::istreambuf_iterator<char>());
+}
+
+// Best effort; a failed write only costs warm-up time on the next run.
+void StorePipelineCacheFile(const std::string& path,
+                            const std::vector<uint8_t>& data) {
+  if (data.empty())
+    return;
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file.is_open())
+    return;
+  file.write(reinterpret_cast<const char*>(data.data()),
+             static_cast<std::streamsize>(data.size()));
+}
+
+// Parses a buffer extraction name of the form "<set>:<binding>" or just
+// "<binding>", which means descriptor set 0.
+bool ParseDescriptorName(const std::string& name,
+                         uint32_t* descriptor_set,
+                         uint32_t* binding) {
+  if (name.empty() || name.find_first_not_of("0123456789:") != std::string::npos)
+    return false;
+
+  size_t colon = name.find(':');
+  if (colon == std::string::npos) {
+    *descriptor_set = 0;
+    *binding = static_cast<uint32_t>(strtoul(name.c_str(), nullptr, 10));
+    return true;
+  }
+  if (colon == 0 || colon + 1 >= name.size() ||
+      name.find(':', colon + 1) != std::string::npos) {
+    return false;
+  }
+
+  *descriptor_set =
+      static_cast<uint32_t>(strtoul(name.substr(0, colon).c_str(), nullptr, 10));
+  *binding = static_cast<uint32_t>(
+      strtoul(name.substr(colon + 1).c_str(), nullptr, 10));
+  return true;
+}
+
+// Resident set size of the process, read from /proc; zero on platforms
+// without it.
+uint64_t ReadResidentSetBytes() {
+#if defined(__linux__)
+  std::ifstream statm("/proc/self/statm");
+  uint64_t total_pages = 0;
+  uint64_t resident_pages = 0;
+  if (!(statm >> total_pages >> resident_pages))
+    return 0;
+  return resident_pages * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#else
+  return 0;
+#endif
+}
+
+// |values| must be sorted and non-empty.
+uint64_t ValueAtPercentile(const std::vector<uint64_t>& values, uint32_t pct) {
+  size_t index = (values.size() * pct) / 100;
+  if (index >= values.size())
+    index = values.size() - 1;
+  return values[index];
+}
+
+// Marks |record| as an alert when a metric moved more than |threshold|
+// of its baseline value away from |baseline|. Metrics the run does not
+// collect are zero in the baseline and skipped.
+void CheckSoakDrift(const SoakRecord& baseline,
+                    double threshold,
+                    SoakRecord* record) {
+  const struct {
+    const char* name;
+    uint64_t base;
+    uint64_t value;
+  } metrics[] = {
+      {"median gpu time", baseline.median_gpu_ns, record->median_gpu_ns},
+      {"p99 gpu time", baseline.p99_gpu_ns, record->p99_gpu_ns},
+      {"median wall time", baseline.median_wall_ns, record->median_wall_ns},
+      {"p99 wall time", baseline.p99_wall_ns, record->p99_wall_ns},
+      {"resident set", baseline.resident_set_bytes,
+       record->resident_set_bytes},
+      {"device memory", baseline.device_memory_bytes,
+       record->device_memory_bytes},
+  };
+  for (const auto& metric : metrics) {
+    if (metric.base == 0)
+      continue;
+
+    double drift = (static_cast<double>(metric.value) -
+                    static_cast<double>(metric.base)) /
+                   static_cast<double>(metric.base);
+    if (drift <= threshold && drift >= -threshold)
+      continue;
+
+    record->alert = true;
+    char text[64];
+    snprintf(text, sizeof(text), "%s drifted %+.1f%% from baseline",
+             metric.name, drift * 100.0);
+    if (!record->alert_message.empty())
+      record->alert_message += "; ";
+    record->alert_message += text;
+  }
+}
+
+// The soak loop: up to |opts->soak_iterations| executions against the
+// pipelines the first one creates, grouped into rolling statistics
+// windows; see Options::soak_iterations. Only an execution failure ends
+// the run early, besides |opts->soak_stop|.
+Result RunSoakLoop(Engine* engine,
+                   Executor* executor,
+                   const Script* script,
+                   const ShaderMap& shader_data,
+                   Options* opts) {
+  opts->soak_records.clear();
+
+  const uint32_t window = opts->soak_window > 0 ? opts->soak_window : 100;
+  std::vector<uint64_t> wall_samples;
+  std::vector<uint64_t> gpu_samples;
+  wall_samples.reserve(window);
+  gpu_samples.reserve(window);
+
+  SoakRecord baseline;
+  bool have_baseline = false;
+
+  uint64_t gpu_total_ns = 0;
+  for (uint64_t i = 0; i < opts->soak_iterations; ++i) {
+    if (opts->soak_stop && *opts->soak_stop)
+      break;
+
+    auto begin = std::chrono::steady_clock::now();
+    Result r;
+    if (i == 0) {
+      r = executor->Execute(engine, script, shader_data,
+                            opts->shader_cache_directory,
+                            opts->optimize_shaders,
+                            !opts->disable_command_optimizer);
+    } else {
+      r = executor->ReExecute(engine, script);
+    }
+    auto end = std::chrono::steady_clock::now();
+    if (!r.IsSuccess())
+      return r;
+
+    wall_samples.push_back(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin)
+            .count()));
+    if (opts->enable_command_timings) {
+      // The engine reports timings cumulatively; the growth since the
+      // previous execution is this one's GPU time.
+      std::vector<CommandTiming> timings;
+      if (engine->GetCommandTimings(&timings).IsSuccess()) {
+        uint64_t sum = 0;
+        for (const auto& timing : timings)
+          sum += timing.gpu_duration_ns;
+        gpu_samples.push_back(sum - gpu_total_ns);
+        gpu_total_ns = sum;
+      }
+    }
+
+    if (wall_samples.size() < window)
+      continue;
+
+    SoakRecord record;
+    record.iteration = i + 1;
+    std::sort(wall_samples.begin(), wall_samples.end());
+    record.median_wall_ns = ValueAtPercentile(wall_samples, 50);
+    record.p99_wall_ns = ValueAtPercentile(wall_samples, 99);
+    if (!gpu_samples.empty()) {
+      std::sort(gpu_samples.begin(), gpu_samples.end());
+      record.median_gpu_ns = ValueAtPercentile(gpu_samples, 50);
+      record.p99_gpu_ns = ValueAtPercentile(gpu_samples, 99);
+    }
+    wall_samples.clear();
+    gpu_samples.clear();
+
+    record.resident_set_bytes = ReadResidentSetBytes();
+    std::vector<MemoryHeapUsage> usage;
+    if (engine->GetMemoryUsage(&usage).IsSuccess()) {
+      for (const auto& heap : usage)
+        record.device_memory_bytes += heap.live_bytes;
+    }
+
+    if (have_baseline) {
+      CheckSoakDrift(baseline, opts->soak_alert_threshold, &record);
+    } else {
+      baseline = record;
+      have_baseline = true;
+    }
+
+    opts->soak_records.push_back(record);
+    if (opts->soak_record_callback)
+      opts->soak_record_callback(record);
+  }
+  return {};
+}
+
+}  // namespace
+
+HostAllocator::~HostAllocator() = default;
 
 Amber::Amber() = default;
 
-Amber::~Amber() = default;
+Amber::~Amber() {
+  if (cached_engine_)
+    cached_engine_->Shutdown();
+}
+
+void Amber::SetParseCacheDirectory(const std::string& dir) {
+  parse_cache_dir_ = dir;
+}
 
 amber::Result Amber::Parse(const std::string& input, amber::Recipe* recipe) {
   if (!recipe)
     return Result("Recipe must be provided to Parse.");
 
+  std::string cache_path;
+  if (!parse_cache_dir_.empty()) {
+    cache_path = CacheFilePath(parse_cache_dir_, input);
+    if (LoadCachedScript(cache_path, recipe))
+      return {};
+  }
+
   std::unique_ptr<Parser> parser;
   if (input.substr(0, 7) == "#!amber")
     parser = MakeUnique<amberscript::Parser>();
@@ -45,57 +333,491 @@ amber::Result Amber::Parse(const std::string& input, amber::Recipe* recipe) {
     return r;
 
   recipe->SetImpl(parser->GetScript().release());
+
+  if (!cache_path.empty())
+    StoreCachedScript(cache_path, *recipe);
   return {};
 }
 
+amber::Result Amber::ParseAll(const std::vector<std::string>& data,
+                              std::vector<amber::Recipe*>* recipes,
+                              std::vector<amber::Result>* results,
+                              std::vector<uint64_t>* durations_ns) {
+  if (!recipes || recipes->size() != data.size())
+    return Result("One recipe must be provided per input to ParseAll.");
+
+  for (auto* recipe : *recipes) {
+    if (!recipe)
+      return Result("One recipe must be provided per input to ParseAll.");
+  }
+
+  uint32_t thread_count = std::thread::hardware_concurrency();
+  if (thread_count == 0)
+    thread_count = 1;
+  if (thread_count > data.size())
+    thread_count = static_cast<uint32_t>(data.size());
+
+  std::vector<Result> parse_results(data.size());
+  if (durations_ns)
+    durations_ns->assign(data.size(), 0);
+  std::atomic<size_t> next_idx(0);
+
+  auto worker = [this, &data, &recipes, &parse_results, &durations_ns,
+                 &next_idx]() {
+    for (;;) {
+      size_t i = next_idx.fetch_add(1);
+      if (i >= data.size())
+        break;
+      auto begin = std::chrono::steady_clock::now();
+      parse_results[i] = Parse(data[i], (*recipes)[i]);
+      if (durations_ns) {
+        (*durations_ns)[i] = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - begin)
+                .count());
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (uint32_t i = 0; i < thread_count; ++i)
+    threads.emplace_back(worker);
+  for (auto& thread : threads)
+    thread.join();
+
+  Result first_failure;
+  for (const auto& result : parse_results) {
+    if (!result.IsSuccess() && first_failure.IsSuccess())
+      first_failure = result;
+  }
+  if (results)
+    *results = std::move(parse_results);
+  return first_failure;
+}
+
 amber::Result Amber::Execute(const amber::Recipe* recipe, Options* opts) {
   ShaderMap map;
   return ExecuteWithShaderData(recipe, opts, map);
 }
 
-amber::Result Amber::ExecuteWithShaderData(const amber::Recipe* recipe,
-                                           Options* opts,
-                                           const ShaderMap& shader_data) {
+std::future<amber::Result> Amber::ExecuteAsync(const amber::Recipe* recipe,
+                                               Options* opts) {
+  ShaderMap map;
+  return ExecuteWithShaderDataAsync(recipe, opts, map);
+}
+
+std::future<amber::Result> Amber::ExecuteWithShaderDataAsync(
+    const amber::Recipe* recipe,
+    Options* opts,
+    const ShaderMap& shader_data) {
+  return std::async(std::launch::async,
+                    [this, recipe, opts, shader_data]() {
+                      return ExecuteWithShaderData(recipe, opts, shader_data);
+                    });
+}
+
+amber::Result Amber::ExecuteDifferential(const amber::Recipe* recipe,
+                                         Options* opts,
+                                         Options* secondary_opts) {
   if (!recipe)
-    return Result("Attempting to execute and invalid recipe");
+    return Result("Attempting to execute an invalid recipe");
 
-  Script* script = static_cast<Script*>(recipe->GetImpl());
+  const Script* script = static_cast<const Script*>(recipe->GetImpl());
   if (!script)
     return Result("Recipe must contain a parsed script");
 
+  if (!opts || !secondary_opts)
+    return Result("ExecuteDifferential requires options for both engines");
+
+  // Compiled binaries land on the script's shader objects, where both
+  // executors look first, so the script is compiled once for the two
+  // runs.
+  Result r = PrecompileShaders(recipe, opts);
+  if (!r.IsSuccess())
+    return r;
+
+  // Both executors hand the same Buffer objects to their engines, which
+  // lazily pack the byte form and release the Value form. Build both
+  // forms now and mark the buffers shared, so the concurrent runs only
+  // ever read them.
+  for (const auto& buf : script->GetBuffers()) {
+    buf->SetSharedBetweenEngines();
+    buf->GetBytes();
+    buf->GetData();
+  }
+
+  // The commands are shared the same way; map their data files and
+  // reference images before the runs race to do it lazily.
+  for (const auto& cmd : script->GetCommands()) {
+    if (cmd->IsBuffer())
+      r = cmd->AsBuffer()->LoadDataFileIfNeeded();
+    else if (cmd->IsProbe())
+      r = cmd->AsProbe()->LoadReferenceImageIfNeeded();
+    if (!r.IsSuccess())
+      return r;
+  }
+
+  struct EngineRun {
+    Result result;
+    std::vector<uint8_t> frame;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t texel_stride = 0;
+    uint32_t row_stride = 0;
+  };
+
+  // One full execution against its own engine, ending with a snapshot of
+  // the framebuffer. Nothing here touches the Amber object, so the two
+  // runs can proceed concurrently.
+  auto run = [script](Options* o, EngineRun* out) {
+    auto engine = Engine::Create(o->engine);
+    if (!engine) {
+      out->result = Result("Failed to create engine");
+      return;
+    }
+
+    Result run_result =
+        engine->Initialize(o->config, script->RequiredFeatures(),
+                           script->RequiredExtensions());
+    if (run_result.IsSuccess()) {
+      Executor executor;
+      run_result =
+          executor.Execute(engine.get(), script, ShaderMap(),
+                           o->shader_cache_directory, o->optimize_shaders,
+                           !o->disable_command_optimizer);
+    }
+    if (run_result.IsSuccess()) {
+      ResourceInfo info;
+      run_result = engine->GetFrameBufferInfo(nullptr, &info);
+      if (run_result.IsSuccess()) {
+        out->width = info.image_info.width;
+        out->height = info.image_info.height;
+        out->texel_stride = info.image_info.texel_stride;
+        out->row_stride = info.image_info.row_stride;
+        const uint8_t* bytes = static_cast<const uint8_t*>(info.cpu_memory);
+        out->frame.assign(bytes, bytes + info.size_in_bytes);
+      }
+    }
+    Result shutdown_result = engine->Shutdown();
+    out->result =
+        run_result.IsSuccess() ? shutdown_result : run_result;
+  };
+
+  EngineRun primary;
+  EngineRun secondary;
+  std::thread secondary_thread(run, secondary_opts, &secondary);
+  run(opts, &primary);
+  secondary_thread.join();
+
+  if (!primary.result.IsSuccess())
+    return primary.result;
+  if (!secondary.result.IsSuccess())
+    return secondary.result;
+
+  if (primary.width != secondary.width ||
+      primary.height != secondary.height ||
+      primary.texel_stride != secondary.texel_stride) {
+    return Result("Framebuffers do not match: " +
+                  std::to_string(primary.width) + "x" +
+                  std::to_string(primary.height) + " with texel stride " +
+                  std::to_string(primary.texel_stride) + " vs " +
+                  std::to_string(secondary.width) + "x" +
+                  std::to_string(secondary.height) + " with texel stride " +
+                  std::to_string(secondary.texel_stride));
+  }
+
+  Verifier verifier;
+  return verifier.CompareImages(primary.width, primary.height,
+                                primary.texel_stride, primary.row_stride,
+                                primary.frame.data(), secondary.row_stride,
+                                secondary.frame.data());
+}
+
+amber::Result Amber::PrecompileShaders(const amber::Recipe* recipe,
+                                       Options* opts) {
+  ShaderMap map;
+  return PrecompileShadersWithShaderData(recipe, opts, map);
+}
+
+amber::Result Amber::PrecompileShadersWithShaderData(
+    const amber::Recipe* recipe,
+    Options* opts,
+    const ShaderMap& shader_data) {
+  if (!recipe)
+    return Result("Attempting to precompile an invalid recipe");
+
+  const Script* script = static_cast<const Script*>(recipe->GetImpl());
+  if (!script)
+    return Result("Recipe must contain a parsed script");
+
+  // Compile() stores each binary on its shader, which is where the
+  // executor looks first, so a later Execute finds them ready made.
+  ShaderCompiler sc(opts ? opts->shader_cache_directory : "",
+                    opts ? opts->optimize_shaders : false);
+  for (const auto& shader : script->GetShaders()) {
+    Result r;
+    std::vector<uint32_t> binary;
+    std::tie(r, binary) = sc.Compile(shader.get(), shader_data);
+    if (!r.IsSuccess())
+      return r;
+  }
+  return {};
+}
+
+amber::Result Amber::PrewarmPipelines(const amber::Recipe* recipe,
+                                      Options* opts) {
+  if (!recipe)
+    return Result("Attempting to prewarm an invalid recipe");
+
+  const Script* script = static_cast<const Script*>(recipe->GetImpl());
+  if (!script)
+    return Result("Recipe must contain a parsed script");
+
+  if (!opts)
+    return Result("PrewarmPipelines requires options");
+
   auto engine = Engine::Create(opts->engine);
   if (!engine)
     return Result("Failed to create engine");
 
   Result r = engine->Initialize(opts->config, script->RequiredFeatures(),
                                 script->RequiredExtensions());
-  if (!r.IsSuccess())
-    return r;
+  if (r.IsSuccess()) {
+    Executor executor;
+    r = executor.Prewarm(engine.get(), script, ShaderMap(),
+                         opts->shader_cache_directory, opts->optimize_shaders);
+  }
+  engine->Shutdown();
+  return r;
+}
 
-  Executor executor;
-  r = executor.Execute(engine.get(), script, shader_data);
+amber::Result Amber::ReplayEngineTrace(const std::string& path,
+                                       Options* opts) {
+  if (!opts)
+    return Result("ReplayEngineTrace requires options");
+
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open())
+    return Result("Cannot open engine trace file: " + path);
+
+  std::vector<uint8_t> trace((std::istreambuf_iterator<char>(file)),
+                             std::istreambuf_iterator<char>());
+
+  auto engine = Engine::Create(opts->engine);
+  if (!engine)
+    return Result("Failed to create engine");
+
+  // The free function of the same name does the actual replay; the
+  // trace carries the features and extensions for Initialize().
+  Result r = amber::ReplayEngineTrace(trace.data(), trace.size(),
+                                      opts->config, engine.get());
+  engine->Shutdown();
+  return r;
+}
+
+amber::Result Amber::ExecuteWithShaderData(const amber::Recipe* recipe,
+                                           Options* opts,
+                                           const ShaderMap& shader_data) {
+  if (!recipe)
+    return Result("Attempting to execute and invalid recipe");
+
+  const Script* script = static_cast<const Script*>(recipe->GetImpl());
+  if (!script)
+    return Result("Recipe must contain a parsed script");
+
+  // Installed for the rest of the process; see Options::host_allocator.
+  if (opts->host_allocator)
+    SetHostBlockAllocator(opts->host_allocator);
+
+  Engine* engine = nullptr;
+  std::unique_ptr<Engine> created_engine;
+  if (opts->reuse_engine && cached_engine_ &&
+      cached_engine_type_ == opts->engine) {
+    engine = cached_engine_.get();
+  } else {
+    if (cached_engine_) {
+      cached_engine_->Shutdown();
+      cached_engine_.reset();
+    }
+
+    created_engine = Engine::Create(opts->engine);
+    if (!created_engine)
+      return Result("Failed to create engine");
+
+    // Recording wraps the engine so every call it receives lands in the
+    // trace file when it shuts down.
+    if (!opts->engine_trace_path.empty()) {
+      created_engine = MakeUnique<TraceEngine>(std::move(created_engine),
+                                               opts->engine_trace_path);
+    }
+    engine = created_engine.get();
+
+    // A reused engine already carries a warm pipeline cache; only a fresh
+    // engine can be seeded from disk.
+    if (!opts->pipeline_cache_path.empty()) {
+      std::vector<uint8_t> cache_data;
+      LoadPipelineCacheFile(opts->pipeline_cache_path, &cache_data);
+      if (!cache_data.empty()) {
+        Result r = engine->SetPipelineCacheData(cache_data);
+        if (!r.IsSuccess())
+          return r;
+      }
+    }
+  }
+
+  Result r = engine->Initialize(opts->config, script->RequiredFeatures(),
+                                script->RequiredExtensions());
   if (!r.IsSuccess()) {
-    // Clean up Vulkan/Dawn objects
     engine->Shutdown();
+    cached_engine_.reset();
     return r;
   }
 
+  engine->SetCommandTimingEnabled(opts->enable_command_timings);
+
+  // Repeat mode runs the command stream |warmup_count| + |repeat_count|
+  // times against the pipelines the first execution creates, timing the
+  // last |repeat_count| of them. That first execution also pays shader
+  // compilation and pipeline creation, which is why it should normally
+  // be covered by a warmup run.
+  uint32_t repeat_count = opts->repeat_count > 0 ? opts->repeat_count : 1;
+  uint32_t total_count = opts->warmup_count + repeat_count;
+  if (total_count > 1) {
+    opts->repeat_wall_times_ns.clear();
+    opts->repeat_gpu_times_ns.clear();
+  }
+
+  Executor executor;
+  if (opts->soak_iterations > 0) {
+    // Soak mode takes over the whole loop; see RunSoakLoop().
+    r = RunSoakLoop(engine, &executor, script, shader_data, opts);
+    if (!r.IsSuccess()) {
+      engine->Shutdown();
+      cached_engine_.reset();
+      return r;
+    }
+  } else {
+    uint64_t gpu_total_ns = 0;
+    for (uint32_t i = 0; i < total_count; ++i) {
+      auto begin = std::chrono::steady_clock::now();
+      if (i == 0) {
+        r = executor.Execute(engine, script, shader_data,
+                             opts->shader_cache_directory,
+                             opts->optimize_shaders,
+                             !opts->disable_command_optimizer);
+      } else {
+        r = executor.ReExecute(engine, script);
+      }
+      auto end = std::chrono::steady_clock::now();
+      if (!r.IsSuccess()) {
+        // Clean up Vulkan/Dawn objects
+        engine->Shutdown();
+        cached_engine_.reset();
+        return r;
+      }
+
+      if (total_count == 1)
+        break;
+
+      uint64_t gpu_ns = 0;
+      if (opts->enable_command_timings) {
+        // The engine reports timings cumulatively; the growth since the
+        // previous execution is this one's GPU time.
+        std::vector<CommandTiming> timings;
+        if (engine->GetCommandTimings(&timings).IsSuccess()) {
+          uint64_t sum = 0;
+          for (const auto& timing : timings)
+            sum += timing.gpu_duration_ns;
+          gpu_ns = sum - gpu_total_ns;
+          gpu_total_ns = sum;
+        }
+      }
+
+      if (i >= opts->warmup_count) {
+        opts->repeat_wall_times_ns.push_back(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin)
+                .count()));
+        if (opts->enable_command_timings)
+          opts->repeat_gpu_times_ns.push_back(gpu_ns);
+      }
+    }
+  }
+
+  opts->phase_timings = executor.GetPhaseTimings();
+
   for (BufferInfo& buffer_info : opts->extractions) {
     if (buffer_info.buffer_name == "framebuffer") {
       ResourceInfo info;
-      r = engine->GetFrameBufferInfo(&info);
+      r = engine->GetFrameBufferInfo(nullptr, &info);
       if (!r.IsSuccess()) {
         engine->Shutdown();
+        cached_engine_.reset();
         return r;
       }
       buffer_info.width = info.image_info.width;
       buffer_info.height = info.image_info.height;
-      r = engine->GetFrameBuffer(&(buffer_info.values));
+      buffer_info.raw_data.resize(
+          static_cast<size_t>(info.image_info.row_stride) *
+          info.image_info.height);
+      r = engine->GetFrameBufferData(buffer_info.raw_data.data(),
+                                     info.image_info.row_stride);
       if (!r.IsSuccess()) {
         engine->Shutdown();
+        cached_engine_.reset();
         return r;
       }
+      continue;
+    }
+
+    // Descriptor extractions copy the raw bytes straight out of the
+    // engine's host visible pointer; no per-element Value objects.
+    uint32_t descriptor_set = 0;
+    uint32_t binding = 0;
+    if (!ParseDescriptorName(buffer_info.buffer_name, &descriptor_set,
+                             &binding)) {
+      continue;
+    }
+
+    ResourceInfo info;
+    r = engine->GetDescriptorInfo(descriptor_set, binding, &info);
+    if (!r.IsSuccess()) {
+      engine->Shutdown();
+      cached_engine_.reset();
+      return r;
+    }
+    const uint8_t* bytes = static_cast<const uint8_t*>(info.cpu_memory);
+    buffer_info.raw_data.assign(bytes, bytes + info.size_in_bytes);
+  }
+
+  if (!opts->pipeline_cache_path.empty()) {
+    std::vector<uint8_t> cache_data;
+    if (engine->GetPipelineCacheData(&cache_data).IsSuccess())
+      StorePipelineCacheFile(opts->pipeline_cache_path, cache_data);
+  }
+
+  if (opts->enable_command_timings) {
+    r = engine->GetCommandTimings(&opts->command_timings);
+    if (!r.IsSuccess()) {
+      engine->Shutdown();
+      cached_engine_.reset();
+      return r;
+    }
+  }
+
+  opts->memory_heap_usage.clear();
+  r = engine->GetMemoryUsage(&opts->memory_heap_usage);
+  if (!r.IsSuccess()) {
+    engine->Shutdown();
+    cached_engine_.reset();
+    return r;
+  }
+
+  if (opts->reuse_engine) {
+    if (created_engine) {
+      cached_engine_ = std::move(created_engine);
+      cached_engine_type_ = opts->engine;
     }
+    return {};
   }
 
   return engine->Shutdown();
@@ -0,0 +1,137 @@
+// Copyright 2019 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "amber/amber_c.h"
+
+#include <string>
+
+#include "amber/amber.h"
+#include "amber/recipe.h"
+#include "amber/result.h"
+
+/// One Amber object plus the options reused across executions. The
+/// options carry reuse_engine so the engine created by the first
+/// execution stays warm inside |amber| for the rest of the context's
+/// life.
+struct amber_context {
+  amber::Amber amber;
+  amber::Options options;
+  std::string last_error;
+};
+
+struct amber_recipe {
+  amber::Recipe recipe;
+};
+
+namespace {
+
+// Folds |r| into the context's error state and the C return code.
+int ToReturnCode(amber_context* context, const amber::Result& r) {
+  if (r.IsSuccess()) {
+    context->last_error.clear();
+    return 0;
+  }
+  context->last_error = r.Error();
+  return -1;
+}
+
+}  // namespace
+
+extern "C" {
+
+amber_context* amber_context_create(void) {
+  amber_context* context = new (std::nothrow) amber_context();
+  if (context)
+    context->options.reuse_engine = true;
+  return context;
+}
+
+void amber_context_destroy(amber_context* context) {
+  delete context;
+}
+
+int amber_context_set_engine(amber_context* context,
+                             enum amber_engine_type engine) {
+  if (!context)
+    return -1;
+  switch (engine) {
+    case AMBER_ENGINE_TYPE_VULKAN:
+      context->options.engine = amber::kEngineTypeVulkan;
+      return ToReturnCode(context, amber::Result());
+    case AMBER_ENGINE_TYPE_DAWN:
+      context->options.engine = amber::kEngineTypeDawn;
+      return ToReturnCode(context, amber::Result());
+  }
+  return ToReturnCode(context, amber::Result("Unknown engine type"));
+}
+
+int amber_context_set_shader_cache_directory(amber_context* context,
+                                             const char* directory) {
+  if (!context)
+    return -1;
+  context->options.shader_cache_directory = directory ? directory : "";
+  return ToReturnCode(context, amber::Result());
+}
+
+int amber_context_set_parse_cache_directory(amber_context* context,
+                                            const char* directory) {
+  if (!context)
+    return -1;
+  context->amber.SetParseCacheDirectory(directory ? directory : "");
+  return ToReturnCode(context, amber::Result());
+}
+
+int amber_parse(amber_context* context,
+                const char* text,
+                amber_recipe** recipe) {
+  if (!context)
+    return -1;
+  if (!text || !recipe) {
+    return ToReturnCode(context,
+                        amber::Result("amber_parse requires script text and "
+                                      "a recipe out-parameter"));
+  }
+
+  amber_recipe* parsed = new (std::nothrow) amber_recipe();
+  if (!parsed)
+    return ToReturnCode(context, amber::Result("Out of memory"));
+
+  amber::Result r = context->amber.Parse(text, &parsed->recipe);
+  if (!r.IsSuccess()) {
+    delete parsed;
+    return ToReturnCode(context, r);
+  }
+  *recipe = parsed;
+  return ToReturnCode(context, r);
+}
+
+int amber_execute(amber_context* context, amber_recipe* recipe) {
+  if (!context)
+    return -1;
+  if (!recipe)
+    return ToReturnCode(context, amber::Result("amber_execute requires a recipe"));
+  return ToReturnCode(context,
+                      context->amber.Execute(&recipe->recipe,
+                                             &context->options));
+}
+
+const char* amber_context_get_error(amber_context* context) {
+  return context ? context->last_error.c_str() : "";
+}
+
+void amber_recipe_destroy(amber_recipe* recipe) {
+  delete recipe;
+}
+
+}  // extern "C"
@@ -22,6 +22,7 @@
 
 #include "src/format_parser.h"
 #include "src/make_unique.h"
+#include "src/profiler.h"
 #include "src/shader_data.h"
 #include "src/tokenizer.h"
 
@@ -37,6 +38,8 @@ std::string Parser::make_error(const std::string& err) {
 }
 
 Result Parser::Parse(const std::string& data) {
+  ScopedPhaseTimer timer("Parser::Parse");
+
   tokenizer_ = MakeUnique<Tokenizer>(data);
 
   for (auto token = tokenizer_->NextToken(); !token->IsEOS();
@@ -47,19 +50,25 @@ Result Parser::Parse(const std::string& data) {
       return Result(make_error("expected string"));
 
     Result r;
-    std::string tok = token->AsString();
-    if (tok == "BUFFER") {
-      r = ParseBuffer();
-    } else if (tok == "PIPELINE") {
-      r = ParsePipelineBlock();
-    } else if (tok == "SHADER") {
-      r = ParseShaderBlock();
-    } else {
-      r = Result("unknown token: " + tok);
+    switch (token->GetKeyword()) {
+      case KeywordType::kBuffer:
+        r = ParseBuffer();
+        break;
+      case KeywordType::kPipeline:
+        r = ParsePipelineBlock();
+        break;
+      case KeywordType::kShader:
+        r = ParseShaderBlock();
+        break;
+      default:
+        r = Result("unknown token: " + token->AsString());
+        break;
     }
     if (!r.IsSuccess())
       return Result(make_error(r.Error()));
   }
+
+  script_->Finalize();
   return {};
 }
 
@@ -554,15 +563,14 @@ Result Parser::ParseBufferInitializerSize(DataBuffer* buffer) {
     return Result("BUFFER invalid initializer");
 
   if (token->AsString() == "FILL")
-    return ParseBufferInitializerFill(buffer, size_in_items);
+    return ParseBufferInitializerFill(buffer);
   if (token->AsString() == "SERIES_FROM")
-    return ParseBufferInitializerSeries(buffer, size_in_items);
+    return ParseBufferInitializerSeries(buffer);
 
   return Result("invalid BUFFER initializer provided");
 }
 
-Result Parser::ParseBufferInitializerFill(DataBuffer* buffer,
-                                          uint32_t size_in_items) {
+Result Parser::ParseBufferInitializerFill(DataBuffer* buffer) {
   auto token = tokenizer_->NextToken();
   if (token->IsEOS() || token->IsEOL())
     return Result("missing BUFFER fill value");
@@ -572,23 +580,20 @@ Result Parser::ParseBufferInitializerFill(DataBuffer* buffer,
   auto& type = buffer->GetDatumType();
   bool is_double_data = type.IsFloat() || type.IsDouble();
 
-  // Inflate the size because our items are multi-dimensional.
-  size_in_items = size_in_items * type.RowCount() * type.ColumnCount();
+  // Only the generator is recorded; it is evaluated straight into the
+  // packed byte form when the data is first needed, so a fill costs
+  // neither parse time nor per-element host storage.
+  Value fill_value;
+  if (is_double_data)
+    fill_value.SetDoubleValue(token->AsDouble());
+  else
+    fill_value.SetIntValue(token->AsUint64());
 
-  std::vector<Value> values;
-  values.resize(size_in_items);
-  for (size_t i = 0; i < size_in_items; ++i) {
-    if (is_double_data)
-      values[i].SetDoubleValue(token->AsDouble());
-    else
-      values[i].SetIntValue(token->AsUint64());
-  }
-  buffer->SetData(std::move(values));
+  buffer->SetGenerator(BufferDataGenerator::kFill, fill_value, Value());
   return ValidateEndOfStatement("BUFFER fill command");
 }
 
-Result Parser::ParseBufferInitializerSeries(DataBuffer* buffer,
-                                            uint32_t size_in_items) {
+Result Parser::ParseBufferInitializerSeries(DataBuffer* buffer) {
   auto token = tokenizer_->NextToken();
   if (token->IsEOS() || token->IsEOL())
     return Result("missing BUFFER series_from value");
@@ -619,20 +624,13 @@ Result Parser::ParseBufferInitializerSeries(DataBuffer* buffer,
   if (!token->IsInteger() && !token->IsDouble())
     return Result("invalid BUFFER series_from inc_by value");
 
-  std::vector<Value> values;
-  values.resize(size_in_items);
-  for (size_t i = 0; i < size_in_items; ++i) {
-    if (is_double_data) {
-      double value = counter.AsDouble();
-      values[i].SetDoubleValue(value);
-      counter.SetDoubleValue(value + token->AsDouble());
-    } else {
-      uint64_t value = counter.AsUint64();
-      values[i].SetIntValue(value);
-      counter.SetIntValue(value + token->AsUint64());
-    }
-  }
-  buffer->SetData(std::move(values));
+  Value step;
+  if (is_double_data)
+    step.SetDoubleValue(token->AsDouble());
+  else
+    step.SetIntValue(token->AsUint64());
+
+  buffer->SetGenerator(BufferDataGenerator::kSeries, counter, step);
   return ValidateEndOfStatement("BUFFER series_from command");
 }
 
@@ -49,8 +49,8 @@ class Parser : public amber::Parser {
   Result ParseBuffer();
   Result ParseBufferInitializer(DataBuffer*);
   Result ParseBufferInitializerSize(DataBuffer*);
-  Result ParseBufferInitializerFill(DataBuffer*, uint32_t);
-  Result ParseBufferInitializerSeries(DataBuffer*, uint32_t);
+  Result ParseBufferInitializerFill(DataBuffer*);
+  Result ParseBufferInitializerSeries(DataBuffer*);
   Result ParseBufferInitializerData(DataBuffer*);
   Result ParseShaderBlock();
   Result ParsePipelineBlock();
@@ -1029,6 +1029,32 @@ TEST_F(AmberScriptParserTest, BufferFill) {
   }
 }
 
+TEST_F(AmberScriptParserTest, BufferFillGeneratesBytesWithoutValues) {
+  std::string in =
+      "BUFFER my_buffer DATA_TYPE uint16 SIZE 4 SERIES_FROM 3 INC_BY 2";
+
+  Parser parser;
+  Result r = parser.Parse(in);
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  auto script = parser.GetScript();
+  const auto& buffers = script->GetBuffers();
+  ASSERT_EQ(1U, buffers.size());
+
+  // The parser stores only the generator; the packed bytes are produced
+  // directly from it without materializing per-element Values.
+  auto* buffer = buffers[0]->AsDataBuffer();
+  EXPECT_EQ(BufferDataGenerator::kSeries, buffer->GetGenerator());
+
+  const auto& bytes = buffer->GetBytes();
+  ASSERT_EQ(4U * sizeof(uint16_t), bytes.size());
+  const uint16_t* values = reinterpret_cast<const uint16_t*>(bytes.data());
+  EXPECT_EQ(3U, values[0]);
+  EXPECT_EQ(5U, values[1]);
+  EXPECT_EQ(7U, values[2]);
+  EXPECT_EQ(9U, values[3]);
+}
+
 TEST_F(AmberScriptParserTest, BufferFillFloat) {
   std::string in = "BUFFER my_buffer DATA_TYPE float SIZE 5 FILL 5.2";
 
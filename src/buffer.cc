@@ -14,7 +14,159 @@
 
 #include "src/buffer.h"
 
+#include <cassert>
+#include <cstring>
+
 namespace amber {
+namespace {
+
+// Append the values of |data| to |bytes| as a packed array of |T|.
+template <typename T>
+void PackIntValues(const std::vector<Value>& data, std::vector<uint8_t>* bytes) {
+  size_t offset = bytes->size();
+  bytes->resize(offset + data.size() * sizeof(T));
+  uint8_t* ptr = bytes->data() + offset;
+  for (const auto& v : data) {
+    T value = static_cast<T>(v.AsUint64());
+    std::memcpy(ptr, &value, sizeof(T));
+    ptr += sizeof(T);
+  }
+}
+
+// As PackIntValues() but for float and double values.
+template <typename T>
+void PackFloatValues(const std::vector<Value>& data,
+                     std::vector<uint8_t>* bytes) {
+  size_t offset = bytes->size();
+  bytes->resize(offset + data.size() * sizeof(T));
+  uint8_t* ptr = bytes->data() + offset;
+  for (const auto& v : data) {
+    T value = static_cast<T>(v.AsDouble());
+    std::memcpy(ptr, &value, sizeof(T));
+    ptr += sizeof(T);
+  }
+}
+
+// Append |count| elements of a generated sequence to |bytes| as a
+// packed array of |T|: |start| repeated for a fill, start + i * step
+// for a series. The plain constant or strided store loops vectorize,
+// so a generated initializer costs a memset-like sweep over the bytes
+// instead of a Value conversion per element.
+template <typename T>
+void GenerateIntValues(BufferDataGenerator generator,
+                       const Value& start,
+                       const Value& step,
+                       size_t count,
+                       std::vector<uint8_t>* bytes) {
+  size_t offset = bytes->size();
+  bytes->resize(offset + count * sizeof(T));
+  T* ptr = reinterpret_cast<T*>(bytes->data() + offset);
+  T value = static_cast<T>(start.AsUint64());
+  T increment = generator == BufferDataGenerator::kSeries
+                    ? static_cast<T>(step.AsUint64())
+                    : static_cast<T>(0);
+  for (size_t i = 0; i < count; ++i) {
+    ptr[i] = value;
+    value = static_cast<T>(value + increment);
+  }
+}
+
+// As GenerateIntValues() but for float and double values.
+template <typename T>
+void GenerateFloatValues(BufferDataGenerator generator,
+                         const Value& start,
+                         const Value& step,
+                         size_t count,
+                         std::vector<uint8_t>* bytes) {
+  size_t offset = bytes->size();
+  bytes->resize(offset + count * sizeof(T));
+  T* ptr = reinterpret_cast<T*>(bytes->data() + offset);
+  T value = static_cast<T>(start.AsDouble());
+  T increment = generator == BufferDataGenerator::kSeries
+                    ? static_cast<T>(step.AsDouble())
+                    : static_cast<T>(0);
+  for (size_t i = 0; i < count; ++i) {
+    ptr[i] = value;
+    value += increment;
+  }
+}
+
+// Return sign value of 32 bits float.
+uint16_t FloatSign(const uint32_t hex_float) {
+  return static_cast<uint16_t>(hex_float >> 31U);
+}
+
+// Return exponent value of 32 bits float.
+uint16_t FloatExponent(const uint32_t hex_float) {
+  uint32_t exponent = ((hex_float >> 23U) & ((1U << 8U) - 1U)) - 112U;
+  const uint32_t half_exponent_mask = (1U << 5U) - 1U;
+  assert(((exponent & ~half_exponent_mask) == 0U) && "Float exponent overflow");
+  return static_cast<uint16_t>(exponent & half_exponent_mask);
+}
+
+// Return mantissa value of 32 bits float. Note that mantissa for 32
+// bits float is 23 bits and this method must return uint32_t.
+uint32_t FloatMantissa(const uint32_t hex_float) {
+  return static_cast<uint32_t>(hex_float & ((1U << 23U) - 1U));
+}
+
+// Convert 32 bits float |value| to 16 bits float based on IEEE-754.
+uint16_t FloatToHexFloat16(const float value) {
+  const uint32_t* hex = reinterpret_cast<const uint32_t*>(&value);
+  return static_cast<uint16_t>(FloatSign(*hex) << 15U) |
+         static_cast<uint16_t>(FloatExponent(*hex) << 10U) |
+         static_cast<uint16_t>(FloatMantissa(*hex) >> 13U);
+}
+
+// Convert 32 bits float |value| to 11 bits float based on IEEE-754.
+uint16_t FloatToHexFloat11(const float value) {
+  const uint32_t* hex = reinterpret_cast<const uint32_t*>(&value);
+  assert(FloatSign(*hex) == 0);
+  return static_cast<uint16_t>(FloatExponent(*hex) << 6U) |
+         static_cast<uint16_t>(FloatMantissa(*hex) >> 17U);
+}
+
+// Convert 32 bits float |value| to 10 bits float based on IEEE-754.
+uint16_t FloatToHexFloat10(const float value) {
+  const uint32_t* hex = reinterpret_cast<const uint32_t*>(&value);
+  assert(FloatSign(*hex) == 0);
+  return static_cast<uint16_t>(FloatExponent(*hex) << 5U) |
+         static_cast<uint16_t>(FloatMantissa(*hex) >> 18U);
+}
+
+// Return the native bit pattern of |v| encoded to a |bits| wide format
+// component, in the low |bits| of the result. Floats narrower than 32
+// bits use the small float formats of the graphics APIs.
+uint64_t EncodeValue(const Value& v, uint8_t bits) {
+  if (v.IsInteger()) {
+    uint64_t data = v.AsUint64();
+    return bits >= 64 ? data : data & ((1ULL << bits) - 1ULL);
+  }
+
+  if (bits == 64) {
+    double data = v.AsDouble();
+    uint64_t pattern = 0;
+    std::memcpy(&pattern, &data, sizeof(data));
+    return pattern;
+  }
+  if (bits == 32) {
+    float data = v.AsFloat();
+    uint32_t pattern = 0;
+    std::memcpy(&pattern, &data, sizeof(data));
+    return pattern;
+  }
+  if (bits == 16)
+    return FloatToHexFloat16(v.AsFloat());
+  if (bits == 11)
+    return FloatToHexFloat11(v.AsFloat());
+  if (bits == 10)
+    return FloatToHexFloat10(v.AsFloat());
+
+  assert(false && "Invalid bits for float component");
+  return 0;
+}
+
+}  // namespace
 
 Buffer::Buffer() = default;
 
@@ -30,16 +182,210 @@ FormatBuffer* Buffer::AsFormatBuffer() {
   return static_cast<FormatBuffer*>(this);
 }
 
+const std::vector<uint8_t>& Buffer::GetBytes() const {
+  if (bytes_.empty()) {
+    if (!data_.empty())
+      PackData(&bytes_);
+    else if (generator_ != BufferDataGenerator::kNone)
+      PackGenerated(&bytes_);
+  }
+  return bytes_;
+}
+
 DataBuffer::DataBuffer() = default;
 
 DataBuffer::DataBuffer(BufferType type) : Buffer(type) {}
 
 DataBuffer::~DataBuffer() = default;
 
+void DataBuffer::PackData(std::vector<uint8_t>* bytes) const {
+  const auto& data = GetData();
+  switch (datum_type_.GetType()) {
+    case DataType::kInt8:
+      PackIntValues<int8_t>(data, bytes);
+      break;
+    case DataType::kInt16:
+      PackIntValues<int16_t>(data, bytes);
+      break;
+    case DataType::kInt32:
+      PackIntValues<int32_t>(data, bytes);
+      break;
+    case DataType::kInt64:
+      PackIntValues<int64_t>(data, bytes);
+      break;
+    case DataType::kUint8:
+      PackIntValues<uint8_t>(data, bytes);
+      break;
+    case DataType::kUint16:
+      PackIntValues<uint16_t>(data, bytes);
+      break;
+    case DataType::kUint32:
+      PackIntValues<uint32_t>(data, bytes);
+      break;
+    case DataType::kUint64:
+      PackIntValues<uint64_t>(data, bytes);
+      break;
+    case DataType::kFloat:
+      PackFloatValues<float>(data, bytes);
+      break;
+    case DataType::kDouble:
+      PackFloatValues<double>(data, bytes);
+      break;
+  }
+}
+
+void DataBuffer::PackGenerated(std::vector<uint8_t>* bytes) const {
+  const size_t count =
+      GetSize() * datum_type_.RowCount() * datum_type_.ColumnCount();
+  const auto generator = GetGenerator();
+  const auto& start = GetGeneratorStart();
+  const auto& step = GetGeneratorStep();
+
+  switch (datum_type_.GetType()) {
+    case DataType::kInt8:
+      GenerateIntValues<int8_t>(generator, start, step, count, bytes);
+      break;
+    case DataType::kInt16:
+      GenerateIntValues<int16_t>(generator, start, step, count, bytes);
+      break;
+    case DataType::kInt32:
+      GenerateIntValues<int32_t>(generator, start, step, count, bytes);
+      break;
+    case DataType::kInt64:
+      GenerateIntValues<int64_t>(generator, start, step, count, bytes);
+      break;
+    case DataType::kUint8:
+      GenerateIntValues<uint8_t>(generator, start, step, count, bytes);
+      break;
+    case DataType::kUint16:
+      GenerateIntValues<uint16_t>(generator, start, step, count, bytes);
+      break;
+    case DataType::kUint32:
+      GenerateIntValues<uint32_t>(generator, start, step, count, bytes);
+      break;
+    case DataType::kUint64:
+      GenerateIntValues<uint64_t>(generator, start, step, count, bytes);
+      break;
+    case DataType::kFloat:
+      GenerateFloatValues<float>(generator, start, step, count, bytes);
+      break;
+    case DataType::kDouble:
+      GenerateFloatValues<double>(generator, start, step, count, bytes);
+      break;
+  }
+}
+
+void DataBuffer::MaterializeGenerated(std::vector<Value>* data) const {
+  const size_t count =
+      GetSize() * datum_type_.RowCount() * datum_type_.ColumnCount();
+  const bool is_double_data = datum_type_.IsFloat() || datum_type_.IsDouble();
+  const auto generator = GetGenerator();
+  const auto& start = GetGeneratorStart();
+  const auto& step = GetGeneratorStep();
+
+  data->resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    if (is_double_data) {
+      double value = start.AsDouble();
+      if (generator == BufferDataGenerator::kSeries)
+        value += static_cast<double>(i) * step.AsDouble();
+      (*data)[i].SetDoubleValue(value);
+    } else {
+      uint64_t value = start.AsUint64();
+      if (generator == BufferDataGenerator::kSeries)
+        value += i * step.AsUint64();
+      (*data)[i].SetIntValue(value);
+    }
+  }
+}
+
 FormatBuffer::FormatBuffer() = default;
 
 FormatBuffer::FormatBuffer(BufferType type) : Buffer(type) {}
 
 FormatBuffer::~FormatBuffer() = default;
 
+void FormatBuffer::PackData(std::vector<uint8_t>* bytes) const {
+  const auto& data = GetData();
+  const auto pack_size = format_->GetPackSize();
+
+  // A packed format carries a whole element in each Value; its bit
+  // pattern is already in the element's layout.
+  if (pack_size) {
+    bytes->resize(data.size() * (pack_size / 8));
+    uint8_t* ptr = bytes->data();
+    for (const auto& v : data) {
+      uint64_t pattern = v.AsUint64();
+      std::memcpy(ptr, &pattern, pack_size / 8);
+      ptr += pack_size / 8;
+    }
+    return;
+  }
+
+  const auto& components = format_->GetComponents();
+  const bool byte_aligned = format_->IsByteAligned();
+
+  const uint32_t element_bytes = format_->GetByteSize();
+  const size_t element_count = data.size() / components.size();
+  bytes->resize(element_count * element_bytes);
+  uint8_t* ptr = bytes->data();
+
+  if (byte_aligned) {
+    size_t idx = 0;
+    for (size_t i = 0; i < element_count; ++i) {
+      for (const auto& comp : components) {
+        uint64_t pattern = EncodeValue(data[idx++], comp.num_bits);
+        std::memcpy(ptr, &pattern, comp.num_bits / 8);
+        ptr += comp.num_bits / 8;
+      }
+    }
+    return;
+  }
+
+  // Formats with components narrower than a byte total at most 32 bits
+  // per element, so each element is accumulated in a word and stored
+  // whole.
+  size_t idx = 0;
+  for (size_t i = 0; i < element_count; ++i) {
+    uint64_t element = 0;
+    uint32_t bit_offset = 0;
+    for (const auto& comp : components) {
+      element |= EncodeValue(data[idx++], comp.num_bits) << bit_offset;
+      bit_offset += comp.num_bits;
+    }
+    std::memcpy(ptr, &element, element_bytes);
+    ptr += element_bytes;
+  }
+}
+
+void FormatBuffer::PackGenerated(std::vector<uint8_t>* bytes) const {
+  // The script languages only attach generators to DatumType buffers;
+  // going through the materialized Values keeps this correct should a
+  // format buffer ever grow one.
+  GetData();
+  PackData(bytes);
+}
+
+void FormatBuffer::MaterializeGenerated(std::vector<Value>* data) const {
+  const size_t count = GetSize() * format_->GetComponents().size();
+  const auto generator = GetGenerator();
+  const auto& start = GetGeneratorStart();
+  const auto& step = GetGeneratorStep();
+
+  data->resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    if (start.IsInteger()) {
+      uint64_t value = start.AsUint64();
+      if (generator == BufferDataGenerator::kSeries)
+        value += i * step.AsUint64();
+      (*data)[i].SetIntValue(value);
+    } else {
+      double value = start.AsDouble();
+      if (generator == BufferDataGenerator::kSeries)
+        value += static_cast<double>(i) * step.AsDouble();
+      (*data)[i].SetDoubleValue(value);
+    }
+  }
+}
+
 }  // namespace amber
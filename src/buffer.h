@@ -59,6 +59,12 @@ class Buffer {
   /// Get the location binding value for the buffer.
   uint8_t GetLocation() const { return location_; }
 
+  /// Marks this vertex buffer as advancing per instance instead of per
+  /// vertex when an instanced draw consumes it.
+  void SetInputRateInstance() { input_rate_instance_ = true; }
+  /// Returns true when this vertex buffer advances per instance.
+  bool IsInputRateInstance() const { return input_rate_instance_; }
+
   /// Sets the buffer |name|.
   void SetName(const std::string& name) { name_ = name; }
   /// Returns the name of the buffer.
@@ -74,9 +80,60 @@ class Buffer {
 
   /// Sets the data into the buffer. The size will also be updated to be the
   /// size of the data provided.
-  virtual void SetData(std::vector<Value>&& data) { data_ = std::move(data); }
-  /// Returns the vector of Values stored in the buffer.
-  const std::vector<Value>& GetData() const { return data_; }
+  virtual void SetData(std::vector<Value>&& data) {
+    bytes_.clear();
+    data_ = std::move(data);
+  }
+
+  /// Declares the contents procedurally instead of storing them: a
+  /// kFill generator repeats |start| for every element, a kSeries
+  /// generator produces start + i * step for element i. The buffer must
+  /// already have its size; the generator is evaluated straight into
+  /// the packed byte form when the bytes are first needed, so neither
+  /// parsing nor per-element Value storage scales with the buffer size.
+  void SetGenerator(BufferDataGenerator generator, Value start, Value step) {
+    generator_ = generator;
+    generator_start_ = start;
+    generator_step_ = step;
+  }
+  /// Returns how the buffer contents are produced.
+  BufferDataGenerator GetGenerator() const { return generator_; }
+
+  /// Returns the vector of Values stored in the buffer. For a generated
+  /// buffer the Values are materialized on first use; consumers which
+  /// can work from |GetBytes| never pay for them.
+  const std::vector<Value>& GetData() const {
+    if (data_.empty() && generator_ != BufferDataGenerator::kNone)
+      MaterializeGenerated(&data_);
+    return data_;
+  }
+
+  /// Returns the buffer contents packed into each element's native
+  /// encoding, laid out as described by the DatumType or Format. The
+  /// packed form is built from the Values on first use and cached, so
+  /// consumers which only need raw bytes do not pay for a ~16 byte
+  /// tagged Value per element.
+  const std::vector<uint8_t>& GetBytes() const;
+
+  /// Frees the tagged Value storage, keeping only the packed byte form.
+  /// The packed form is built first if needed, so |GetBytes| keeps
+  /// returning the buffer contents; |GetData| returns an empty vector
+  /// afterwards. Engines call this once a buffer's data has been handed
+  /// to the device so a script does not pin both representations for the
+  /// rest of the run. A no-op on a buffer marked shared between engines.
+  void ReleaseValues() {
+    if (shared_between_engines_)
+      return;
+    GetBytes();
+    std::vector<Value>().swap(data_);
+  }
+
+  /// Marks the buffer as handed to engines executing concurrently, as in
+  /// a differential run. ReleaseValues() then keeps the Value form:
+  /// clearing it while another engine's thread reads the buffer would
+  /// race. The caller must build both forms - GetBytes() and GetData() -
+  /// before the concurrent runs start, so they only ever read.
+  void SetSharedBetweenEngines() { shared_between_engines_ = true; }
 
  protected:
   /// Create an un-typed buffer.
@@ -84,12 +141,38 @@ class Buffer {
   /// Create a buffer of |type_|.
   explicit Buffer(BufferType type);
 
+  /// Packs the Values of this buffer into |bytes| using the native
+  /// layout of the derived class.
+  virtual void PackData(std::vector<uint8_t>* bytes) const = 0;
+
+  /// Evaluates the generator straight into |bytes| in the native layout
+  /// of the derived class, without going through Values.
+  virtual void PackGenerated(std::vector<uint8_t>* bytes) const = 0;
+
+  /// Expands the generator into one Value per element for consumers
+  /// which need the tagged form.
+  virtual void MaterializeGenerated(std::vector<Value>* data) const = 0;
+
+  /// Returns the value the generator starts from.
+  const Value& GetGeneratorStart() const { return generator_start_; }
+  /// Returns the per-element increment of a kSeries generator.
+  const Value& GetGeneratorStep() const { return generator_step_; }
+
  private:
   BufferType buffer_type_;
-  std::vector<Value> data_;
+  /// Mutable so a generated buffer can materialize its Values lazily in
+  /// |GetData|.
+  mutable std::vector<Value> data_;
+  /// Cache of the packed form of |data_|, built by |GetBytes|.
+  mutable std::vector<uint8_t> bytes_;
+  BufferDataGenerator generator_ = BufferDataGenerator::kNone;
+  Value generator_start_;
+  Value generator_step_;
   std::string name_;
   size_t size_ = 0;
   uint8_t location_ = 0;
+  bool input_rate_instance_ = false;
+  bool shared_between_engines_ = false;
 };
 
 /// A buffer class where the data is described by a |DatumType| object.
@@ -114,6 +197,11 @@ class DataBuffer : public Buffer {
   /// Returns the DatumType describing the buffer data.
   const DatumType& GetDatumType() const { return datum_type_; }
 
+ protected:
+  void PackData(std::vector<uint8_t>* bytes) const override;
+  void PackGenerated(std::vector<uint8_t>* bytes) const override;
+  void MaterializeGenerated(std::vector<Value>* data) const override;
+
  private:
   DatumType datum_type_;
 };
@@ -135,15 +223,21 @@ class FormatBuffer : public Buffer {
     Buffer::SetData(std::move(data));
   }
 
-  /// Sets the Format of the buffer to |format|.
-  void SetFormat(std::unique_ptr<Format> format) {
+  /// Sets the Format of the buffer to |format|. Formats are immutable
+  /// and commonly shared between buffers via the parser's format cache.
+  void SetFormat(std::shared_ptr<const Format> format) {
     format_ = std::move(format);
   }
   /// Returns the Format describing the buffer data.
   const Format& GetFormat() const { return *(format_.get()); }
 
+ protected:
+  void PackData(std::vector<uint8_t>* bytes) const override;
+  void PackGenerated(std::vector<uint8_t>* bytes) const override;
+  void MaterializeGenerated(std::vector<Value>* data) const override;
+
  private:
-  std::unique_ptr<Format> format_;
+  std::shared_ptr<const Format> format_;
 };
 
 }  // namespace amber
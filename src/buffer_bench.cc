@@ -0,0 +1,56 @@
+// Copyright 2018 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "src/buffer.h"
+#include "src/format.h"
+#include "src/make_unique.h"
+
+namespace amber {
+namespace {
+
+void BM_FormatBufferPackData(benchmark::State& state) {
+  // Packing values into the native buffer encoding is the per-element
+  // hot loop behind every vertex buffer upload.
+  const size_t kVertices = 4096;
+
+  std::vector<Value> values;
+  values.resize(kVertices * 4);
+  for (size_t i = 0; i < values.size(); ++i)
+    values[i].SetDoubleValue(static_cast<double>(i) * 0.25);
+
+  for (auto _ : state) {
+    auto format = MakeUnique<Format>();
+    format->SetFormatType(FormatType::kR32G32B32A32_SFLOAT);
+    format->AddComponent(FormatComponentType::kR, FormatMode::kSFloat, 32);
+    format->AddComponent(FormatComponentType::kG, FormatMode::kSFloat, 32);
+    format->AddComponent(FormatComponentType::kB, FormatMode::kSFloat, 32);
+    format->AddComponent(FormatComponentType::kA, FormatMode::kSFloat, 32);
+
+    FormatBuffer b(BufferType::kVertex);
+    b.SetFormat(std::move(format));
+    b.SetData(std::vector<Value>(values));
+
+    benchmark::DoNotOptimize(b.GetBytes().data());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(values.size()));
+}
+BENCHMARK(BM_FormatBufferPackData);
+
+}  // namespace
+}  // namespace amber
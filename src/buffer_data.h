@@ -35,6 +35,19 @@ enum class BufferType : uint8_t {
   kVertex
 };
 
+/// Ways the contents of a buffer can be produced procedurally instead
+/// of being spelled out as literal values. Generators are stored
+/// symbolically and evaluated only when the bytes are needed, so the
+/// expanded data never exists as parsed values on the host.
+enum class BufferDataGenerator : uint8_t {
+  /// The contents are given explicitly.
+  kNone = 0,
+  /// Every element is the same value.
+  kFill,
+  /// Element i is start + i * step.
+  kSeries
+};
+
 }  // namespace amber
 
 #endif  // SRC_BUFFER_DATA_H_
@@ -12,10 +12,12 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstring>
 #include <utility>
 
 #include "gtest/gtest.h"
 #include "src/buffer.h"
+#include "src/make_unique.h"
 
 namespace amber {
 
@@ -69,6 +71,74 @@ TEST_F(BufferTest, DataBufferSizeFromDataOverrideSize) {
   EXPECT_EQ(2 * 5, b.GetSizeInBytes());
 }
 
+TEST_F(BufferTest, DataBufferPacksBytes) {
+  DatumType type;
+  type.SetType(DataType::kUint8);
+
+  std::vector<Value> values;
+  values.resize(4);
+  values[0].SetIntValue(1);
+  values[1].SetIntValue(255);
+  values[2].SetIntValue(3);
+  values[3].SetIntValue(4);
+
+  DataBuffer b(BufferType::kColor);
+  b.SetDatumType(type);
+  b.SetData(std::move(values));
+
+  const auto& bytes = b.GetBytes();
+  ASSERT_EQ(static_cast<size_t>(4U), bytes.size());
+  EXPECT_EQ(1U, bytes[0]);
+  EXPECT_EQ(255U, bytes[1]);
+  EXPECT_EQ(3U, bytes[2]);
+  EXPECT_EQ(4U, bytes[3]);
+}
+
+TEST_F(BufferTest, DataBufferPacksFloatBytes) {
+  DatumType type;
+  type.SetType(DataType::kFloat);
+
+  std::vector<Value> values;
+  values.resize(2);
+  values[0].SetDoubleValue(1.5);
+  values[1].SetDoubleValue(-2.25);
+
+  DataBuffer b(BufferType::kColor);
+  b.SetDatumType(type);
+  b.SetData(std::move(values));
+
+  const auto& bytes = b.GetBytes();
+  ASSERT_EQ(2 * sizeof(float), bytes.size());
+
+  float unpacked[2];
+  memcpy(unpacked, bytes.data(), sizeof(unpacked));
+  EXPECT_FLOAT_EQ(1.5f, unpacked[0]);
+  EXPECT_FLOAT_EQ(-2.25f, unpacked[1]);
+}
+
+TEST_F(BufferTest, FormatBufferPacksComponents) {
+  auto format = MakeUnique<Format>();
+  format->SetFormatType(FormatType::kR8G8B8A8_UINT);
+  format->AddComponent(FormatComponentType::kR, FormatMode::kUInt, 8);
+  format->AddComponent(FormatComponentType::kG, FormatMode::kUInt, 8);
+  format->AddComponent(FormatComponentType::kB, FormatMode::kUInt, 8);
+  format->AddComponent(FormatComponentType::kA, FormatMode::kUInt, 8);
+
+  std::vector<Value> values;
+  values.resize(8);
+  for (size_t i = 0; i < values.size(); ++i)
+    values[i].SetIntValue(i + 1);
+
+  FormatBuffer b(BufferType::kVertex);
+  b.SetFormat(std::move(format));
+  b.SetData(std::move(values));
+
+  const auto& bytes = b.GetBytes();
+  ASSERT_EQ(static_cast<size_t>(8U), bytes.size());
+  for (size_t i = 0; i < bytes.size(); ++i)
+    EXPECT_EQ(i + 1, bytes[i]);
+}
+
 TEST_F(BufferTest, DataBufferSizeMatrix) {
   DatumType type;
   type.SetType(DataType::kInt16);
@@ -14,6 +14,11 @@
 
 #include "src/command.h"
 
+#include <utility>
+
+#include "src/data_file.h"
+#include "src/make_unique.h"
+
 namespace amber {
 
 Command::Command(Type type) : command_type_(type) {}
@@ -90,11 +95,70 @@ ProbeCommand::ProbeCommand() : Probe(Type::kProbe) {}
 
 ProbeCommand::~ProbeCommand() = default;
 
+Result ProbeCommand::LoadReferenceImageIfNeeded() {
+  if (reference_image_path_.empty() || reference_image_)
+    return {};
+
+  auto file = MakeUnique<DataFile>();
+  Result r = file->Map(reference_image_path_);
+  if (!r.IsSuccess())
+    return r;
+
+  if (file->GetSize() == 0) {
+    return Result("reference image " + reference_image_path_ +
+                  " provides no data");
+  }
+
+  reference_image_ = std::move(file);
+  return {};
+}
+
+const uint8_t* ProbeCommand::GetReferenceImageData() const {
+  return reference_image_->GetData();
+}
+
+uint64_t ProbeCommand::GetReferenceImageSize() const {
+  return reference_image_->GetSize();
+}
+
 BufferCommand::BufferCommand(BufferType type)
     : Command(Type::kBuffer), buffer_type_(type) {}
 
 BufferCommand::~BufferCommand() = default;
 
+Result BufferCommand::LoadDataFileIfNeeded() {
+  if (data_file_path_.empty() || data_file_)
+    return {};
+
+  auto file = MakeUnique<DataFile>();
+  Result r = file->Map(data_file_path_);
+  if (!r.IsSuccess())
+    return r;
+
+  if (data_file_offset_ > file->GetSize()) {
+    return Result("offset into data file " + data_file_path_ +
+                  " exceeds the file size");
+  }
+
+  uint64_t available = file->GetSize() - data_file_offset_;
+  if (data_file_size_ == 0)
+    data_file_size_ = available;
+  else if (data_file_size_ > available)
+    return Result("data file " + data_file_path_ +
+                  " is too small for the requested byte count");
+
+  if (data_file_size_ == 0)
+    return Result("data file " + data_file_path_ + " provides no data");
+
+  size_ = static_cast<uint32_t>(data_file_size_);
+  data_file_ = std::move(file);
+  return {};
+}
+
+const uint8_t* BufferCommand::GetDataFileData() const {
+  return data_file_->GetData() + data_file_offset_;
+}
+
 ProbeSSBOCommand::ProbeSSBOCommand() : Probe(Type::kProbeSSBO) {}
 
 ProbeSSBOCommand::~ProbeSSBOCommand() = default;
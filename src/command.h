@@ -16,12 +16,15 @@
 #define SRC_COMMAND_H_
 
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "amber/result.h"
 #include "amber/shader_info.h"
 #include "amber/value.h"
+#include "src/buffer_data.h"
 #include "src/command_data.h"
 #include "src/datum_type.h"
 #include "src/pipeline_data.h"
@@ -33,6 +36,7 @@ class ClearColorCommand;
 class ClearDepthCommand;
 class ClearStencilCommand;
 class ComputeCommand;
+class DataFile;
 class DrawArraysCommand;
 class DrawRectCommand;
 class EntryPointCommand;
@@ -61,6 +65,8 @@ class Command {
 
   virtual ~Command();
 
+  Type GetType() const { return command_type_; }
+
   bool IsDrawRect() const { return command_type_ == Type::kDrawRect; }
   bool IsDrawArrays() const { return command_type_ == Type::kDrawArrays; }
   bool IsCompute() const { return command_type_ == Type::kCompute; }
@@ -183,10 +189,17 @@ class ComputeCommand : public Command {
   void SetZ(uint32_t z) { z_ = z; }
   uint32_t GetZ() const { return z_; }
 
+  /// Marks the dispatch as data-parallel: the script promises that
+  /// workgroups do not depend on each other, so the engine may split the
+  /// workgroup range into independently submitted slices.
+  void SetDataParallel() { is_data_parallel_ = true; }
+  bool IsDataParallel() const { return is_data_parallel_; }
+
  private:
   uint32_t x_ = 0;
   uint32_t y_ = 0;
   uint32_t z_ = 0;
+  bool is_data_parallel_ = false;
 };
 
 class Probe : public Command {
@@ -252,6 +265,25 @@ class ProbeCommand : public Probe {
   void SetA(float a) { a_ = a; }
   float GetA() const { return a_; }
 
+  /// Compares the whole framebuffer against the raw contents of the
+  /// image file at |path| instead of a constant colour.
+  void SetReferenceImagePath(const std::string& path) {
+    reference_image_path_ = path;
+  }
+  const std::string& GetReferenceImagePath() const {
+    return reference_image_path_;
+  }
+  bool IsReferenceImage() const { return !reference_image_path_.empty(); }
+
+  /// Maps the reference image file into memory if it has not been mapped
+  /// yet. Must be called before GetReferenceImageData().
+  Result LoadReferenceImageIfNeeded();
+
+  /// Returns the mapped bytes of the reference image. Only valid after a
+  /// successful LoadReferenceImageIfNeeded().
+  const uint8_t* GetReferenceImageData() const;
+  uint64_t GetReferenceImageSize() const;
+
  private:
   enum class ColorFormat {
     kRGB = 0,
@@ -272,6 +304,9 @@ class ProbeCommand : public Probe {
   float g_ = 0.0;
   float b_ = 0.0;
   float a_ = 0.0;
+
+  std::string reference_image_path_;
+  std::unique_ptr<DataFile> reference_image_;
 };
 
 class ProbeSSBOCommand : public Probe {
@@ -304,16 +339,58 @@ class ProbeSSBOCommand : public Probe {
   void SetDatumType(const DatumType& type) { datum_type_ = type; }
   const DatumType& GetDatumType() const { return datum_type_; }
 
-  void SetValues(std::vector<Value>&& values) { values_ = std::move(values); }
+  void SetValues(std::vector<Value>&& values) {
+    values_ = std::move(values);
+    lowered_values_.clear();
+  }
   const std::vector<Value>& GetValues() const { return values_; }
 
+  // One time lowering cache filled by the verifier: the expected values
+  // converted to the command's datum type and laid out contiguously the
+  // way they appear in the probed buffer. Recipes executed repeatedly
+  // then verify with a single typed loop instead of re-running the per
+  // Value conversion switches every pass.
+  bool HasLoweredValues() const { return !lowered_values_.empty(); }
+  void SetLoweredValues(std::vector<uint8_t> data,
+                        bool all_integers) const {
+    lowered_values_ = std::move(data);
+    lowered_values_are_integers_ = all_integers;
+  }
+  const std::vector<uint8_t>& GetLoweredValues() const {
+    return lowered_values_;
+  }
+  bool AreLoweredValuesIntegers() const {
+    return lowered_values_are_integers_;
+  }
+
+  // A checksum probe carries a 64 bit hash of the expected bytes
+  // instead of per-element values. The verifier hashes |size_in_bytes|
+  // bytes of the readback at the probe's offset in a single pass and
+  // compares only the hashes, so large regression outputs verify
+  // without element-wise work.
+  void SetChecksum(uint64_t checksum, uint32_t size_in_bytes) {
+    is_checksum_ = true;
+    checksum_ = checksum;
+    checksum_size_in_bytes_ = size_in_bytes;
+  }
+  bool IsChecksum() const { return is_checksum_; }
+  uint64_t GetChecksum() const { return checksum_; }
+  uint32_t GetChecksumSizeInBytes() const { return checksum_size_in_bytes_; }
+
  private:
   Comparator comparator_ = Comparator::kEqual;
   uint32_t descriptor_set_id_ = 0;
   uint32_t binding_num_ = 0;
   uint32_t offset_ = 0;
+  bool is_checksum_ = false;
+  uint64_t checksum_ = 0;
+  uint32_t checksum_size_in_bytes_ = 0;
   DatumType datum_type_;
   std::vector<Value> values_;
+  // See SetLoweredValues(); mutable because the verifier only sees the
+  // command through a const pointer.
+  mutable std::vector<uint8_t> lowered_values_;
+  mutable bool lowered_values_are_integers_ = false;
 };
 
 class BufferCommand : public Command {
@@ -358,6 +435,66 @@ class BufferCommand : public Command {
   }
   const std::vector<Value>& GetValues() const { return values_; }
 
+  // The initializer can also be procedural: |item_count| items of the
+  // datum type, either all |value| or the series starting at |start|
+  // and advancing by |step| per element. Only the generator is stored;
+  // it is evaluated at upload time directly into the mapped buffer
+  // memory, so the expanded data never exists on the host. The datum
+  // type must be set before declaring the generator.
+  void SetGeneratorFill(Value value, uint32_t item_count) {
+    generator_ = BufferDataGenerator::kFill;
+    generator_start_ = value;
+    size_ = item_count * datum_type_.SizeInBytes();
+  }
+  void SetGeneratorSeries(Value start, Value step, uint32_t item_count) {
+    generator_ = BufferDataGenerator::kSeries;
+    generator_start_ = start;
+    generator_step_ = step;
+    size_ = item_count * datum_type_.SizeInBytes();
+  }
+  BufferDataGenerator GetGenerator() const { return generator_; }
+  const Value& GetGeneratorStart() const { return generator_start_; }
+  const Value& GetGeneratorStep() const { return generator_step_; }
+
+  // The initializer can come from an external binary file instead of
+  // |values_|; the file's bytes are used as-is, no parsing or per
+  // element conversion happens. The file is not touched at parse time;
+  // the executor maps it right before handing the command to the
+  // engine.
+  void SetDataFilePath(const std::string& path) { data_file_path_ = path; }
+  const std::string& GetDataFilePath() const { return data_file_path_; }
+
+  void SetDataFileOffset(uint64_t offset) { data_file_offset_ = offset; }
+  uint64_t GetDataFileOffset() const { return data_file_offset_; }
+
+  // A size of 0 means everything from the file offset to the end of the
+  // file.
+  void SetDataFileSize(uint64_t size) { data_file_size_ = size; }
+  uint64_t GetDataFileSize() const { return data_file_size_; }
+
+  bool IsFromDataFile() const { return !data_file_path_.empty(); }
+
+  // Map the data file if this command references one and it is not
+  // mapped yet. On success GetSize() reflects the number of bytes the
+  // file provides and GetDataFileData() points at them.
+  Result LoadDataFileIfNeeded();
+
+  // Valid after a successful LoadDataFileIfNeeded(); stays valid for the
+  // lifetime of this command.
+  const uint8_t* GetDataFileData() const;
+
+  // The initializer can also be raw bytes owned by the caller, already
+  // in buffer layout; they are used as-is like a data file's bytes.
+  // Used by the executor's checkpoint restore to re-upload snapshotted
+  // buffer contents. The bytes must stay valid until the engine has
+  // consumed the command.
+  void SetRawBytes(const uint8_t* data, uint32_t size) {
+    raw_bytes_ = data;
+    size_ = size;
+  }
+  bool HasRawBytes() const { return raw_bytes_ != nullptr; }
+  const uint8_t* GetRawBytes() const { return raw_bytes_; }
+
  private:
   BufferType buffer_type_;
   bool is_subdata_ = false;
@@ -367,6 +504,14 @@ class BufferCommand : public Command {
   uint32_t offset_ = 0;
   DatumType datum_type_;
   std::vector<Value> values_;
+  BufferDataGenerator generator_ = BufferDataGenerator::kNone;
+  Value generator_start_;
+  Value generator_step_;
+  std::string data_file_path_;
+  uint64_t data_file_offset_ = 0;
+  uint64_t data_file_size_ = 0;
+  std::unique_ptr<DataFile> data_file_;
+  const uint8_t* raw_bytes_ = nullptr;
 };
 
 class ClearCommand : public Command {
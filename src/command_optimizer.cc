@@ -0,0 +1,173 @@
+// Copyright 2019 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/command_optimizer.h"
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+#include "src/buffer_data.h"
+#include "src/command.h"
+
+namespace amber {
+namespace {
+
+const size_t kNotSeen = static_cast<size_t>(-1);
+
+// A buffer upload no draw, dispatch or probe has observed yet; a later
+// upload of the same binding covering [begin, end) makes it dead.
+struct PendingWrite {
+  size_t index;
+  uint64_t begin;
+  uint64_t end;
+};
+
+// Push constant uploads share one range space; descriptor uploads are
+// keyed by set and binding like the scheduler keys them.
+const uint64_t kPushConstantKey = static_cast<uint64_t>(-1);
+
+uint64_t BindingKey(const BufferCommand* cmd) {
+  if (cmd->IsPushConstant())
+    return kPushConstantKey;
+  return (static_cast<uint64_t>(cmd->GetDescriptorSet()) << 32) |
+         cmd->GetBinding();
+}
+
+// Return true if |cmd| writes a byte range known at parse time. A data
+// file command's extent is only known once the file is mapped, and a
+// command without values or a generator only declares a size; neither
+// can prove another upload dead or be proven dead itself.
+bool HasKnownData(const BufferCommand* cmd) {
+  return cmd->GetSize() > 0 && !cmd->IsFromDataFile() &&
+         (!cmd->GetValues().empty() ||
+          cmd->GetGenerator() != BufferDataGenerator::kNone);
+}
+
+}  // namespace
+
+std::vector<CommandStreamEntry> CommandOptimizer::Optimize(
+    const std::vector<CommandStreamEntry>& stream) {
+  const size_t count = stream.size();
+  std::vector<bool> keep(count, true);
+
+  // Index of the latest setting of each clear value nothing consumed
+  // yet; a newer setting of the same value makes it dead.
+  size_t pending_clear_color = kNotSeen;
+  size_t pending_clear_depth = kNotSeen;
+  size_t pending_clear_stencil = kNotSeen;
+  size_t pending_patch = kNotSeen;
+  // Latest clear with nothing reading or redrawing the framebuffer
+  // since; the next clear rewrites every aspect, making it dead.
+  size_t pending_clear = kNotSeen;
+
+  std::map<uint64_t, std::vector<PendingWrite>> pending_writes;
+
+  for (size_t i = 0; i < count; ++i) {
+    switch (stream[i].type) {
+      case Command::Type::kClearColor:
+        if (pending_clear_color != kNotSeen)
+          keep[pending_clear_color] = false;
+        pending_clear_color = i;
+        break;
+      case Command::Type::kClearDepth:
+        if (pending_clear_depth != kNotSeen)
+          keep[pending_clear_depth] = false;
+        pending_clear_depth = i;
+        break;
+      case Command::Type::kClearStencil:
+        if (pending_clear_stencil != kNotSeen)
+          keep[pending_clear_stencil] = false;
+        pending_clear_stencil = i;
+        break;
+      case Command::Type::kPatchParameterVertices:
+        if (pending_patch != kNotSeen)
+          keep[pending_patch] = false;
+        pending_patch = i;
+        break;
+      case Command::Type::kClear:
+        if (pending_clear != kNotSeen)
+          keep[pending_clear] = false;
+        pending_clear = i;
+        pending_clear_color = kNotSeen;
+        pending_clear_depth = kNotSeen;
+        pending_clear_stencil = kNotSeen;
+        break;
+      case Command::Type::kBuffer: {
+        const BufferCommand* buffer = stream[i].command->AsBuffer();
+        std::vector<PendingWrite>& writes = pending_writes[BindingKey(buffer)];
+        if (!HasKnownData(buffer)) {
+          // Unknown extent or a bare size declaration; assume it can
+          // interact with every earlier upload of the binding.
+          writes.clear();
+          break;
+        }
+
+        const uint64_t begin = buffer->GetOffset();
+        const uint64_t end = begin + buffer->GetSize();
+        for (size_t w = 0; w < writes.size();) {
+          if (begin <= writes[w].begin && writes[w].end <= end) {
+            keep[writes[w].index] = false;
+            writes.erase(writes.begin() + static_cast<ptrdiff_t>(w));
+          } else {
+            ++w;
+          }
+        }
+        writes.push_back(PendingWrite{i, begin, end});
+        break;
+      }
+      case Command::Type::kDrawRect:
+      case Command::Type::kDrawArrays:
+        // A draw reads the patch parameter, renders over the cleared
+        // framebuffer and can read any bound descriptor or push
+        // constant; everything pending is now observed.
+        pending_patch = kNotSeen;
+        pending_clear = kNotSeen;
+        pending_writes.clear();
+        break;
+      case Command::Type::kCompute:
+        pending_writes.clear();
+        break;
+      case Command::Type::kProbe:
+        pending_clear = kNotSeen;
+        break;
+      case Command::Type::kProbeSSBO:
+        pending_writes.clear();
+        break;
+      default:
+        // Entry points, pipeline properties and anything added later:
+        // treated as able to observe every pending command.
+        pending_clear_color = kNotSeen;
+        pending_clear_depth = kNotSeen;
+        pending_clear_stencil = kNotSeen;
+        pending_patch = kNotSeen;
+        pending_clear = kNotSeen;
+        pending_writes.clear();
+        break;
+    }
+  }
+
+  // Commands still pending at the end of the stream stay: extraction
+  // reads buffers and the framebuffer after the run, and a reused
+  // engine keeps its state into the next execution.
+  std::vector<CommandStreamEntry> result;
+  result.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    if (keep[i])
+      result.push_back(stream[i]);
+  }
+  return result;
+}
+
+}  // namespace amber
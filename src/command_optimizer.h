@@ -0,0 +1,46 @@
+// Copyright 2019 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_COMMAND_OPTIMIZER_H_
+#define SRC_COMMAND_OPTIMIZER_H_
+
+#include <vector>
+
+#include "src/script.h"
+
+namespace amber {
+
+/// Dead command elimination over the flat command stream. A command is
+/// dead when a later command provably overwrites its whole effect
+/// before anything can observe it: a clear value setting superseded by
+/// another before any clear, a clear followed by another clear with
+/// nothing reading or redrawing the framebuffer in between, or a buffer
+/// upload completely covered by a later upload of the same binding
+/// before any draw, dispatch or probe. Fuzzer derived scripts are dense
+/// with such sequences; hand written scripts rarely contain any, and
+/// the pass then returns the stream unchanged. Commands at the end of
+/// the stream are never removed, since extraction and engine reuse can
+/// observe their effect after the run.
+class CommandOptimizer {
+ public:
+  /// Returns |stream| with provably dead commands removed, preserving
+  /// the relative order of the survivors. The commands themselves stay
+  /// owned by the script; only stream entries are dropped.
+  static std::vector<CommandStreamEntry> Optimize(
+      const std::vector<CommandStreamEntry>& stream);
+};
+
+}  // namespace amber
+
+#endif  // SRC_COMMAND_OPTIMIZER_H_
@@ -0,0 +1,184 @@
+// Copyright 2019 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/command_optimizer.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "src/command.h"
+#include "src/make_unique.h"
+
+namespace amber {
+namespace {
+
+CommandStreamEntry Entry(Command* cmd) {
+  return CommandStreamEntry{cmd->GetType(), cmd};
+}
+
+std::unique_ptr<BufferCommand> MakeSSBOWrite(uint32_t binding,
+                                             uint32_t offset,
+                                             uint32_t byte_count) {
+  auto cmd = MakeUnique<BufferCommand>(BufferCommand::BufferType::kSSBO);
+  cmd->SetDescriptorSet(0);
+  cmd->SetBinding(binding);
+  cmd->SetOffset(offset);
+
+  DatumType type;
+  type.SetType(DataType::kUint8);
+  cmd->SetDatumType(type);
+
+  std::vector<Value> values(byte_count);
+  for (auto& v : values)
+    v.SetIntValue(0);
+  cmd->SetValues(std::move(values));
+  return cmd;
+}
+
+}  // namespace
+
+using CommandOptimizerTest = testing::Test;
+
+TEST_F(CommandOptimizerTest, DropsSupersededClearColor) {
+  auto color_a = MakeUnique<ClearColorCommand>();
+  auto color_b = MakeUnique<ClearColorCommand>();
+  auto clear = MakeUnique<ClearCommand>();
+
+  std::vector<CommandStreamEntry> stream = {
+      Entry(color_a.get()), Entry(color_b.get()), Entry(clear.get())};
+
+  // Nothing consumed the first clear color before it was replaced.
+  auto result = CommandOptimizer::Optimize(stream);
+  ASSERT_EQ(2U, result.size());
+  EXPECT_EQ(color_b.get(), result[0].command);
+  EXPECT_EQ(clear.get(), result[1].command);
+}
+
+TEST_F(CommandOptimizerTest, KeepsClearColorConsumedByClear) {
+  auto color_a = MakeUnique<ClearColorCommand>();
+  auto clear_a = MakeUnique<ClearCommand>();
+  auto probe = MakeUnique<ProbeCommand>();
+  auto color_b = MakeUnique<ClearColorCommand>();
+  auto clear_b = MakeUnique<ClearCommand>();
+
+  std::vector<CommandStreamEntry> stream = {
+      Entry(color_a.get()), Entry(clear_a.get()), Entry(probe.get()),
+      Entry(color_b.get()), Entry(clear_b.get())};
+
+  // Each clear color is consumed by its clear and the probe reads the
+  // first clear's result; nothing is dead.
+  auto result = CommandOptimizer::Optimize(stream);
+  EXPECT_EQ(5U, result.size());
+}
+
+TEST_F(CommandOptimizerTest, DropsClearOverwrittenByClear) {
+  auto clear_a = MakeUnique<ClearCommand>();
+  auto clear_b = MakeUnique<ClearCommand>();
+  auto probe = MakeUnique<ProbeCommand>();
+
+  std::vector<CommandStreamEntry> stream = {
+      Entry(clear_a.get()), Entry(clear_b.get()), Entry(probe.get())};
+
+  // The second clear rewrites every framebuffer aspect before anything
+  // read the first one.
+  auto result = CommandOptimizer::Optimize(stream);
+  ASSERT_EQ(2U, result.size());
+  EXPECT_EQ(clear_b.get(), result[0].command);
+  EXPECT_EQ(probe.get(), result[1].command);
+}
+
+TEST_F(CommandOptimizerTest, KeepsClearObservedByDraw) {
+  auto clear_a = MakeUnique<ClearCommand>();
+  auto draw = MakeUnique<DrawRectCommand>(PipelineData());
+  auto clear_b = MakeUnique<ClearCommand>();
+
+  std::vector<CommandStreamEntry> stream = {
+      Entry(clear_a.get()), Entry(draw.get()), Entry(clear_b.get())};
+
+  // The draw renders over the first clear's result, so that clear is
+  // observable.
+  auto result = CommandOptimizer::Optimize(stream);
+  EXPECT_EQ(3U, result.size());
+}
+
+TEST_F(CommandOptimizerTest, DropsCoveredBufferWrite) {
+  auto write_a = MakeSSBOWrite(0, 0, 16);
+  auto write_b = MakeSSBOWrite(0, 0, 16);
+  auto compute = MakeUnique<ComputeCommand>();
+
+  std::vector<CommandStreamEntry> stream = {
+      Entry(write_a.get()), Entry(write_b.get()), Entry(compute.get())};
+
+  // The second upload rewrites every byte of the first before the
+  // dispatch runs.
+  auto result = CommandOptimizer::Optimize(stream);
+  ASSERT_EQ(2U, result.size());
+  EXPECT_EQ(write_b.get(), result[0].command);
+  EXPECT_EQ(compute.get(), result[1].command);
+}
+
+TEST_F(CommandOptimizerTest, KeepsBufferWriteReadByDispatch) {
+  auto write_a = MakeSSBOWrite(0, 0, 16);
+  auto compute = MakeUnique<ComputeCommand>();
+  auto write_b = MakeSSBOWrite(0, 0, 16);
+
+  std::vector<CommandStreamEntry> stream = {
+      Entry(write_a.get()), Entry(compute.get()), Entry(write_b.get())};
+
+  // The dispatch between the uploads can read the first one.
+  auto result = CommandOptimizer::Optimize(stream);
+  EXPECT_EQ(3U, result.size());
+}
+
+TEST_F(CommandOptimizerTest, KeepsPartiallyCoveredBufferWrite) {
+  auto write_a = MakeSSBOWrite(0, 0, 16);
+  auto write_b = MakeSSBOWrite(0, 0, 8);
+  auto compute = MakeUnique<ComputeCommand>();
+
+  std::vector<CommandStreamEntry> stream = {
+      Entry(write_a.get()), Entry(write_b.get()), Entry(compute.get())};
+
+  // The second upload leaves half of the first one's bytes visible.
+  auto result = CommandOptimizer::Optimize(stream);
+  EXPECT_EQ(3U, result.size());
+}
+
+TEST_F(CommandOptimizerTest, KeepsWritesToDifferentBindings) {
+  auto write_a = MakeSSBOWrite(0, 0, 16);
+  auto write_b = MakeSSBOWrite(1, 0, 16);
+  auto compute = MakeUnique<ComputeCommand>();
+
+  std::vector<CommandStreamEntry> stream = {
+      Entry(write_a.get()), Entry(write_b.get()), Entry(compute.get())};
+
+  auto result = CommandOptimizer::Optimize(stream);
+  EXPECT_EQ(3U, result.size());
+}
+
+TEST_F(CommandOptimizerTest, KeepsTrailingCommands) {
+  auto clear = MakeUnique<ClearCommand>();
+  auto write = MakeSSBOWrite(0, 0, 16);
+
+  std::vector<CommandStreamEntry> stream = {Entry(clear.get()),
+                                            Entry(write.get())};
+
+  // Extraction reads buffers and the framebuffer after the run; nothing
+  // at the end of the stream is removable.
+  auto result = CommandOptimizer::Optimize(stream);
+  EXPECT_EQ(2U, result.size());
+}
+
+}  // namespace amber
@@ -0,0 +1,203 @@
+// Copyright 2019 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/command_scheduler.h"
+
+#include <algorithm>
+
+#include "src/command.h"
+
+namespace amber {
+namespace {
+
+// Bound on how far past an unissued probe the scheduler looks for
+// hoistable commands, so the pass stays linear on fuzzer sized streams
+// with hundreds of thousands of commands.
+const size_t kMaxLookahead = 256;
+
+// Resources a command may read or write, at the granularity the
+// executor can determine without shader reflection.
+struct ResourceUse {
+  bool reads_framebuffer = false;
+  bool writes_framebuffer = false;
+  // Reads and writes every descriptor binding; used for draws and
+  // dispatches, whose shaders can touch anything bound.
+  bool uses_all_descriptors = false;
+  // Pipeline state: entry points, patch parameters, push constants.
+  bool reads_pipeline_state = false;
+  bool writes_pipeline_state = false;
+  // Unknown command; orders with everything.
+  bool is_global = false;
+  // Forces a submission and fence wait when executed.
+  bool is_flush = false;
+  // Single descriptor binding read or written, as set << 32 | binding.
+  bool has_descriptor = false;
+  bool writes_descriptor = false;
+  uint64_t descriptor_id = 0;
+};
+
+uint64_t DescriptorId(uint32_t descriptor_set, uint32_t binding) {
+  return (static_cast<uint64_t>(descriptor_set) << 32) | binding;
+}
+
+ResourceUse ClassifyCommand(const CommandStreamEntry& entry) {
+  ResourceUse use;
+  switch (entry.type) {
+    case Command::Type::kClear:
+    case Command::Type::kClearColor:
+    case Command::Type::kClearDepth:
+    case Command::Type::kClearStencil:
+      use.writes_framebuffer = true;
+      break;
+    case Command::Type::kDrawRect:
+    case Command::Type::kDrawArrays:
+      use.writes_framebuffer = true;
+      use.uses_all_descriptors = true;
+      use.reads_pipeline_state = true;
+      break;
+    case Command::Type::kCompute:
+      use.uses_all_descriptors = true;
+      use.reads_pipeline_state = true;
+      break;
+    case Command::Type::kEntryPoint:
+    case Command::Type::kPatchParameterVertices:
+      use.writes_pipeline_state = true;
+      break;
+    case Command::Type::kProbe:
+      use.reads_framebuffer = true;
+      use.is_flush = true;
+      break;
+    case Command::Type::kProbeSSBO: {
+      const ProbeSSBOCommand* probe = entry.command->AsProbeSSBO();
+      use.has_descriptor = true;
+      use.descriptor_id =
+          DescriptorId(probe->GetDescriptorSet(), probe->GetBinding());
+      use.is_flush = true;
+      break;
+    }
+    case Command::Type::kBuffer: {
+      const BufferCommand* buffer = entry.command->AsBuffer();
+      if (buffer->IsPushConstant()) {
+        use.writes_pipeline_state = true;
+      } else {
+        use.has_descriptor = true;
+        use.writes_descriptor = true;
+        use.descriptor_id =
+            DescriptorId(buffer->GetDescriptorSet(), buffer->GetBinding());
+      }
+      break;
+    }
+    default:
+      use.is_global = true;
+      break;
+  }
+  return use;
+}
+
+// Return true if |a| and |b| must keep their script order i.e., they
+// touch a common resource and at least one of them writes it.
+bool Conflicts(const ResourceUse& a, const ResourceUse& b) {
+  if (a.is_global || b.is_global)
+    return true;
+
+  if ((a.writes_framebuffer && (b.reads_framebuffer || b.writes_framebuffer)) ||
+      (b.writes_framebuffer && a.reads_framebuffer)) {
+    return true;
+  }
+
+  if ((a.writes_pipeline_state &&
+       (b.reads_pipeline_state || b.writes_pipeline_state)) ||
+      (b.writes_pipeline_state && a.reads_pipeline_state)) {
+    return true;
+  }
+
+  if (a.uses_all_descriptors && (b.uses_all_descriptors || b.has_descriptor))
+    return true;
+  if (b.uses_all_descriptors && a.has_descriptor)
+    return true;
+
+  if (a.has_descriptor && b.has_descriptor &&
+      a.descriptor_id == b.descriptor_id &&
+      (a.writes_descriptor || b.writes_descriptor)) {
+    return true;
+  }
+
+  return false;
+}
+
+}  // namespace
+
+std::vector<size_t> CommandScheduler::ScheduleOrder(
+    const std::vector<CommandStreamEntry>& stream) {
+  const size_t count = stream.size();
+
+  std::vector<size_t> order;
+  order.reserve(count);
+
+  std::vector<ResourceUse> uses;
+  uses.reserve(count);
+  bool any_flush = false;
+  for (size_t i = 0; i < count; ++i) {
+    uses.push_back(ClassifyCommand(stream[i]));
+    any_flush = any_flush || uses.back().is_flush;
+  }
+
+  // Reordering only ever moves work above a flush; without one the
+  // script order is already the issue order.
+  if (!any_flush) {
+    for (size_t i = 0; i < count; ++i)
+      order.push_back(i);
+    return order;
+  }
+
+  std::vector<bool> issued(count, false);
+  size_t head = 0;
+  while (head < count) {
+    if (issued[head]) {
+      ++head;
+      continue;
+    }
+
+    size_t pick = head;
+    if (uses[head].is_flush) {
+      // Look for a later command whose chain does not pass through this
+      // probe: it must be independent of every unissued command before
+      // it, so hoisting it changes no dependent ordering.
+      const size_t limit = std::min(count, head + kMaxLookahead);
+      for (size_t candidate = head + 1; candidate < limit; ++candidate) {
+        if (issued[candidate] || uses[candidate].is_flush)
+          continue;
+
+        bool independent = true;
+        for (size_t prev = head; prev < candidate; ++prev) {
+          if (!issued[prev] && Conflicts(uses[prev], uses[candidate])) {
+            independent = false;
+            break;
+          }
+        }
+        if (independent) {
+          pick = candidate;
+          break;
+        }
+      }
+    }
+
+    issued[pick] = true;
+    order.push_back(pick);
+  }
+
+  return order;
+}
+
+}  // namespace amber
@@ -0,0 +1,44 @@
+// Copyright 2019 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_COMMAND_SCHEDULER_H_
+#define SRC_COMMAND_SCHEDULER_H_
+
+#include <vector>
+
+#include "src/script.h"
+
+namespace amber {
+
+/// Conservative dependency analysis over the flat command stream. Each
+/// command is mapped to the resources it may read or write - the
+/// framebuffer, a descriptor binding, or pipeline state like push
+/// constants and entry points. Draws and dispatches can touch any bound
+/// descriptor and the executor has no shader reflection, so they use
+/// every descriptor resource; the analysis never claims independence it
+/// cannot prove.
+class CommandScheduler {
+ public:
+  /// Returns the indices of |stream| in issue order. Commands touching
+  /// the same resource keep their script order; independent commands may
+  /// be hoisted above flush-forcing probes, so their device work joins
+  /// the submission the probe waits on and overlaps on the device
+  /// instead of starting after the probe's fence wait.
+  static std::vector<size_t> ScheduleOrder(
+      const std::vector<CommandStreamEntry>& stream);
+};
+
+}  // namespace amber
+
+#endif  // SRC_COMMAND_SCHEDULER_H_
@@ -0,0 +1,151 @@
+// Copyright 2019 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/command_scheduler.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "src/command.h"
+#include "src/make_unique.h"
+
+namespace amber {
+namespace {
+
+CommandStreamEntry Entry(Command* cmd) {
+  return CommandStreamEntry{cmd->GetType(), cmd};
+}
+
+std::unique_ptr<BufferCommand> MakeSSBOCommand(uint32_t descriptor_set,
+                                               uint32_t binding) {
+  auto cmd = MakeUnique<BufferCommand>(BufferCommand::BufferType::kSSBO);
+  cmd->SetDescriptorSet(descriptor_set);
+  cmd->SetBinding(binding);
+  return cmd;
+}
+
+std::unique_ptr<ProbeSSBOCommand> MakeProbeSSBOCommand(
+    uint32_t descriptor_set,
+    uint32_t binding) {
+  auto cmd = MakeUnique<ProbeSSBOCommand>();
+  cmd->SetDescriptorSet(descriptor_set);
+  cmd->SetBinding(binding);
+  return cmd;
+}
+
+}  // namespace
+
+using CommandSchedulerTest = testing::Test;
+
+TEST_F(CommandSchedulerTest, NoFlushKeepsScriptOrder) {
+  auto upload = MakeSSBOCommand(0, 0);
+  auto compute = MakeUnique<ComputeCommand>();
+  auto clear = MakeUnique<ClearCommand>();
+
+  std::vector<CommandStreamEntry> stream = {
+      Entry(upload.get()), Entry(compute.get()), Entry(clear.get())};
+
+  auto order = CommandScheduler::ScheduleOrder(stream);
+  ASSERT_EQ(3U, order.size());
+  EXPECT_EQ(0U, order[0]);
+  EXPECT_EQ(1U, order[1]);
+  EXPECT_EQ(2U, order[2]);
+}
+
+TEST_F(CommandSchedulerTest, HoistsIndependentUploadAboveProbe) {
+  auto upload_a = MakeSSBOCommand(0, 0);
+  auto compute = MakeUnique<ComputeCommand>();
+  auto probe_a = MakeProbeSSBOCommand(0, 0);
+  auto upload_b = MakeSSBOCommand(0, 1);
+
+  std::vector<CommandStreamEntry> stream = {
+      Entry(upload_a.get()), Entry(compute.get()), Entry(probe_a.get()),
+      Entry(upload_b.get())};
+
+  // The second upload touches another binding than the probe, so its
+  // device work joins the submission the probe waits on.
+  auto order = CommandScheduler::ScheduleOrder(stream);
+  ASSERT_EQ(4U, order.size());
+  EXPECT_EQ(0U, order[0]);
+  EXPECT_EQ(1U, order[1]);
+  EXPECT_EQ(3U, order[2]);
+  EXPECT_EQ(2U, order[3]);
+}
+
+TEST_F(CommandSchedulerTest, KeepsDependentDispatchAfterProbe) {
+  auto upload = MakeSSBOCommand(0, 0);
+  auto compute_a = MakeUnique<ComputeCommand>();
+  auto probe = MakeProbeSSBOCommand(0, 0);
+  auto compute_b = MakeUnique<ComputeCommand>();
+
+  std::vector<CommandStreamEntry> stream = {
+      Entry(upload.get()), Entry(compute_a.get()), Entry(probe.get()),
+      Entry(compute_b.get())};
+
+  // A dispatch can write any bound descriptor, including the probed
+  // one, so it must not move above the probe.
+  auto order = CommandScheduler::ScheduleOrder(stream);
+  ASSERT_EQ(4U, order.size());
+  EXPECT_EQ(0U, order[0]);
+  EXPECT_EQ(1U, order[1]);
+  EXPECT_EQ(2U, order[2]);
+  EXPECT_EQ(3U, order[3]);
+}
+
+TEST_F(CommandSchedulerTest, HoistsUploadAboveFramebufferProbe) {
+  auto clear = MakeUnique<ClearCommand>();
+  auto probe = MakeUnique<ProbeCommand>();
+  auto upload = MakeSSBOCommand(0, 0);
+
+  std::vector<CommandStreamEntry> stream = {
+      Entry(clear.get()), Entry(probe.get()), Entry(upload.get())};
+
+  // The upload touches no framebuffer state; it does not have to wait
+  // for the framebuffer verification.
+  auto order = CommandScheduler::ScheduleOrder(stream);
+  ASSERT_EQ(3U, order.size());
+  EXPECT_EQ(0U, order[0]);
+  EXPECT_EQ(2U, order[1]);
+  EXPECT_EQ(1U, order[2]);
+}
+
+TEST_F(CommandSchedulerTest, PushConstantOrdersWithDispatch) {
+  auto push = MakeUnique<BufferCommand>(BufferCommand::BufferType::kPushConstant);
+  auto upload = MakeSSBOCommand(0, 0);
+  auto compute = MakeUnique<ComputeCommand>();
+  auto probe = MakeProbeSSBOCommand(0, 0);
+  auto push_b =
+      MakeUnique<BufferCommand>(BufferCommand::BufferType::kPushConstant);
+  auto compute_b = MakeUnique<ComputeCommand>();
+
+  std::vector<CommandStreamEntry> stream = {
+      Entry(push.get()),  Entry(upload.get()),  Entry(compute.get()),
+      Entry(probe.get()), Entry(push_b.get()),  Entry(compute_b.get())};
+
+  // The push constant write touches no descriptor and hoists above the
+  // probe, but the dispatch reading it can write the probed binding and
+  // must stay behind, keeping the pair in order relative to each other.
+  auto order = CommandScheduler::ScheduleOrder(stream);
+  ASSERT_EQ(6U, order.size());
+  EXPECT_EQ(0U, order[0]);
+  EXPECT_EQ(1U, order[1]);
+  EXPECT_EQ(2U, order[2]);
+  EXPECT_EQ(4U, order[3]);
+  EXPECT_EQ(3U, order[4]);
+  EXPECT_EQ(5U, order[5]);
+}
+
+}  // namespace amber
@@ -0,0 +1,98 @@
+// Copyright 2018 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/data_file.h"
+
+#include <cstdio>
+
+#include "src/platform.h"
+
+#if AMBER_PLATFORM_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace amber {
+
+DataFile::DataFile() = default;
+
+DataFile::~DataFile() {
+#if AMBER_PLATFORM_POSIX
+  if (data_ != nullptr && contents_.empty()) {
+    munmap(const_cast<uint8_t*>(data_), static_cast<size_t>(size_));
+  }
+#endif
+}
+
+Result DataFile::Map(const std::string& path) {
+#if AMBER_PLATFORM_POSIX
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return Result("Unable to open data file: " + path);
+
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    close(fd);
+    return Result("Unable to stat data file: " + path);
+  }
+
+  size_ = static_cast<uint64_t>(info.st_size);
+  if (size_ == 0) {
+    // mmap() rejects zero length mappings; an empty file simply has no
+    // data to point at.
+    close(fd);
+    return {};
+  }
+
+  void* mapping =
+      mmap(nullptr, static_cast<size_t>(size_), PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping keeps its own reference to the file.
+  close(fd);
+  if (mapping == MAP_FAILED)
+    return Result("Unable to map data file: " + path);
+
+  data_ = static_cast<const uint8_t*>(mapping);
+  return {};
+#else
+  FILE* file = fopen(path.c_str(), "rb");
+  if (!file)
+    return Result("Unable to open data file: " + path);
+
+  if (fseek(file, 0, SEEK_END) != 0) {
+    fclose(file);
+    return Result("Unable to read data file: " + path);
+  }
+  long end = ftell(file);
+  if (end < 0 || fseek(file, 0, SEEK_SET) != 0) {
+    fclose(file);
+    return Result("Unable to read data file: " + path);
+  }
+
+  contents_.resize(static_cast<size_t>(end));
+  if (!contents_.empty() &&
+      fread(contents_.data(), 1, contents_.size(), file) != contents_.size()) {
+    fclose(file);
+    return Result("Unable to read data file: " + path);
+  }
+  fclose(file);
+
+  data_ = contents_.data();
+  size_ = contents_.size();
+  return {};
+#endif
+}
+
+}  // namespace amber
@@ -0,0 +1,52 @@
+// Copyright 2018 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_DATA_FILE_H_
+#define SRC_DATA_FILE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "amber/result.h"
+
+namespace amber {
+
+/// Read only view of a binary file's contents. On POSIX the file is
+/// memory mapped, so referencing a multi-gigabyte initializer costs no
+/// up front I/O and pages are read on demand while the upload walks
+/// them; elsewhere the contents are read into an owned buffer. The view
+/// stays valid until the DataFile is destroyed.
+class DataFile {
+ public:
+  DataFile();
+  ~DataFile();
+
+  /// Maps the contents of the file at |path|. Must be called at most
+  /// once.
+  Result Map(const std::string& path);
+
+  const uint8_t* GetData() const { return data_; }
+  uint64_t GetSize() const { return size_; }
+
+ private:
+  const uint8_t* data_ = nullptr;
+  uint64_t size_ = 0;
+  /// Backing storage on platforms without memory mapping.
+  std::vector<uint8_t> contents_;
+};
+
+}  // namespace amber
+
+#endif  // SRC_DATA_FILE_H_
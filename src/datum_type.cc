@@ -18,6 +18,8 @@ namespace amber {
 
 DatumType::DatumType() = default;
 
+DatumType::DatumType(const DatumType&) = default;
+
 DatumType::~DatumType() = default;
 
 DatumType& DatumType::operator=(const DatumType&) = default;
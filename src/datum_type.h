@@ -36,6 +36,7 @@ enum class DataType {
 class DatumType {
  public:
   DatumType();
+  DatumType(const DatumType&);
   ~DatumType();
 
   DatumType& operator=(const DatumType&);
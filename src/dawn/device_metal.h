@@ -23,6 +23,10 @@
 namespace amber {
 namespace dawn {
 
+// Returns a Dawn device backed by the system Metal device. The device
+// is created once and shared by every caller in the process, so
+// repeated executions do not pay device and procedure table setup
+// again.
 Result CreateMetalDevice(::dawn::Device*);
 
 }  // namespace dawn
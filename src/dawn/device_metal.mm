@@ -34,16 +34,29 @@ Result CreateMetalDevice(::dawn::Device* device_ptr) {
   if (!device_ptr) {
     return Result("::amber::dawn::CreateMetalDevice: invalid device parameter");
   }
-  dawnDevice cDevice =
-      ::dawn_native::metal::CreateDevice(MTLCreateSystemDefaultDevice());
-  if (!cDevice) {
+
+  // Creating the MTLDevice and installing Dawn's procedure table costs
+  // hundreds of milliseconds and holds no per-script state, so one
+  // device is built on first use and handed to every later engine. The
+  // handle is refcounted; this static keeps the device alive for the
+  // life of the process, matching an externally provided long-lived
+  // device in DawnEngineConfig.
+  static ::dawn::Device shared_device = []() -> ::dawn::Device {
+    dawnDevice cDevice =
+        ::dawn_native::metal::CreateDevice(MTLCreateSystemDefaultDevice());
+    if (!cDevice)
+      return ::dawn::Device();
+    dawnProcTable procs = ::dawn_native::GetProcs();
+    dawnSetProcs(&procs);
+    procs.deviceSetErrorCallback(cDevice, PrintDeviceError, 0);
+    return ::dawn::Device::Acquire(cDevice);
+  }();
+
+  if (!shared_device) {
     return Result(
         "::amber::dawn::CreateMetalDevice: Failed to create metal device");
   }
-  dawnProcTable procs = ::dawn_native::GetProcs();
-  dawnSetProcs(&procs);
-  procs.deviceSetErrorCallback(cDevice, PrintDeviceError, 0);
-  *device_ptr = ::dawn::Device::Acquire(cDevice);
+  *device_ptr = shared_device;
 
   return {};
 }
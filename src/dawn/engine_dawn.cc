@@ -105,12 +105,6 @@ Result MakeFramebufferBuffer(const ::dawn::Device& device,
   return {};
 }
 
-// Result status object and data pointer resulting from a buffer mapping.
-struct MapResult {
-  Result result;
-  const void* data = nullptr;
-};
-
 // Handles the update from an asynchronous buffer map request, updating the
 // state of the MapResult object hidden inside the |userdata| parameter.
 // On a successful mapping outcome, set the data pointer in the map result.
@@ -137,34 +131,52 @@ void HandleBufferMapCallback(dawnBufferMapAsyncStatus status,
   }
 }
 
-// Maps the given buffer.  Assumes the buffer has usage bit
-// dawn::BufferUsageBit::MapRead set.  Returns a MapResult structure, with the
-// status saved in the .result member and the host pointer to the mapped data
-// in the |.data| member. Mapping a buffer can fail if the context is lost, for
-// example. In the failure case, the .data member of the result will be null.
-MapResult MapBuffer(const ::dawn::Device& device,
-                    const ::dawn::Buffer& buf,
-                    uint32_t size) {
-  MapResult map_result;
+// Starts mapping the given buffer for reading.  Assumes the buffer has
+// usage bit dawn::BufferUsageBit::MapRead set.  The callback writes
+// through |map_result|, which must stay alive and at a fixed address
+// until WaitForMappedBuffer() observed the map completing.  No waiting
+// happens here.
+void StartBufferMapRead(const ::dawn::Buffer& buf,
+                        uint32_t size,
+                        MapResult* map_result) {
   buf.MapReadAsync(0, size, HandleBufferMapCallback,
                    static_cast<dawnCallbackUserdata>(
-                       reinterpret_cast<uintptr_t>(&map_result)));
+                       reinterpret_cast<uintptr_t>(map_result)));
+}
+
+// Waits for a map started with StartBufferMapRead() to complete, ticking
+// the device to pump its callbacks.  On success |map_result->data| points
+// at the mapped bytes.  Mapping a buffer can fail if the context is lost,
+// for example. In the failure case, the .data member of the result will be
+// null.
+Result WaitForMappedBuffer(const ::dawn::Device& device,
+                           MapResult* map_result) {
   device.Tick();
-  // Wait until the callback has been processed.  Use an exponential backoff
-  // interval, but cap it at one second intervals.  But never loop forever.
-  const int max_iters = 100;
-  const int one_second_in_us = 1000000;
+  // The callback fires from inside Tick(), so completion can only be
+  // observed by ticking. Most maps finish within a few ticks; spin
+  // through those first, because for a sub-millisecond map a single
+  // sleep quantum would cost more than the map itself. Past the spin
+  // budget, back off exponentially but cap the interval at one
+  // millisecond so a late completion is noticed promptly instead of
+  // after a second-long quantum. The iteration cap bounds the total
+  // wait at roughly a minute.
+  const int spin_iters = 1000;
+  const int max_iters = 64000;
+  const int one_ms_in_us = 1000;
   for (int iters = 0, interval = 1;
-       !map_result.data && map_result.result.IsSuccess();
-       iters++, interval = std::min(2 * interval, one_second_in_us)) {
+       !map_result->data && map_result->result.IsSuccess(); iters++) {
     device.Tick();
     if (iters > max_iters) {
-      map_result.result = Result("MapBuffer timed out after 100 iterations");
+      map_result->result = Result("MapBuffer timed out");
       break;
     }
-    USleep(interval);
+    if (iters < spin_iters)
+      continue;
+
+    USleep(static_cast<uint32_t>(interval));
+    interval = std::min(2 * interval, one_ms_in_us);
   }
-  return map_result;
+  return map_result->result;
 }
 
 }  // namespace
@@ -176,8 +188,25 @@ EngineDawn::~EngineDawn() = default;
 Result EngineDawn::Initialize(EngineConfig* config,
                               const std::vector<Feature>&,
                               const std::vector<std::string>&) {
-  if (device_)
-    return Result("Dawn:Initialize device_ already exists");
+  if (device_) {
+    // The engine is being reused for another script. The device handle is
+    // refcounted and cheap to keep; just drop state left over from the
+    // previous script. A readback the previous script never consumed
+    // must complete before its buffer can be dropped.
+    if (fb_map_pending_) {
+      WaitForMappedBuffer(device_, &fb_map_);
+      fb_map_pending_ = false;
+    }
+    fb_map_ = MapResult();
+    fb_copied_row_begin_ = 0;
+    fb_copied_row_end_ = 0;
+    fb_contents_stale_ = true;
+    module_for_type_.clear();
+    compute_pipeline_info_ = ComputePipelineInfo();
+    render_pipeline_info_ = RenderPipelineInfo();
+    DestroyCommandBufferBuilder();
+    return {};
+  }
 
   if (config) {
     DawnEngineConfig* dawn_config = static_cast<DawnEngineConfig*>(config);
@@ -195,6 +224,11 @@ Result EngineDawn::Initialize(EngineConfig* config,
 }
 
 Result EngineDawn::Shutdown() {
+  if (fb_map_pending_) {
+    WaitForMappedBuffer(device_, &fb_map_);
+    fb_map_pending_ = false;
+  }
+  module_cache_.clear();
   device_ = ::dawn::Device();
   return {};
 }
@@ -231,13 +265,22 @@ Result EngineDawn::CreatePipeline(PipelineType type) {
 
 Result EngineDawn::SetShader(ShaderType type,
                              const std::vector<uint32_t>& code) {
+  if (!device_) {
+    return Result("Dawn::SetShader: device is not created");
+  }
+
+  // A module already translated from the same SPIR-V is reused; the
+  // translation is the expensive part of module creation.
+  auto cached = module_cache_.find(code);
+  if (cached != module_cache_.end()) {
+    module_for_type_[type] = cached->second;
+    return {};
+  }
+
   ::dawn::ShaderModuleDescriptor descriptor;
   descriptor.nextInChain = nullptr;
   descriptor.code = code.data();
   descriptor.codeSize = uint32_t(code.size());
-  if (!device_) {
-    return Result("Dawn::SetShader: device is not created");
-  }
   auto shader = device_.CreateShaderModule(&descriptor);
   if (!shader) {
     return Result("Dawn::SetShader: failed to create shader");
@@ -246,13 +289,11 @@ Result EngineDawn::SetShader(ShaderType type,
     Result("Dawn::SetShader: module for type already exists");
   }
   module_for_type_[type] = shader;
+  module_cache_[code] = shader;
   return {};
 }
 
-Result EngineDawn::SetBuffer(BufferType,
-                             uint8_t,
-                             const Format&,
-                             const std::vector<Value>&) {
+Result EngineDawn::SetBuffer(Buffer*) {
   return Result("Dawn:SetBuffer not implemented");
 }
 
@@ -278,21 +319,33 @@ Result EngineDawn::DoClear(const ClearCommand*) {
 
   const auto& clear_color = render_pipeline_info_.clear_color_value;
 
-  ::dawn::RenderPassColorAttachmentDescriptor color_attachment =
-      ::dawn::RenderPassColorAttachmentDescriptor();
-  color_attachment.attachment =
-      render_pipeline_info_.fb_texture.CreateDefaultTextureView();
-  color_attachment.resolveTarget = nullptr;
-  color_attachment.clearColor = {clear_color.GetR(), clear_color.GetG(),
-                                 clear_color.GetB(), clear_color.GetA()};
-  color_attachment.loadOp = ::dawn::LoadOp::Clear;
-  color_attachment.storeOp = ::dawn::StoreOp::Store;
-
-  ::dawn::RenderPassDescriptor rpd =
-      device_.CreateRenderPassDescriptorBuilder()
-          .SetColorAttachments(1, &color_attachment)
-          .GetResult();
-  command_buffer_builder_.BeginRenderPass(rpd).EndPass();
+  // Reuse the descriptor built for the last clear while the color is
+  // unchanged; only the pass recorded into the command buffer is new.
+  const float color[4] = {clear_color.GetR(), clear_color.GetG(),
+                          clear_color.GetB(), clear_color.GetA()};
+  if (!render_pipeline_info_.has_clear_render_pass ||
+      !std::equal(color, color + 4,
+                  render_pipeline_info_.clear_render_pass_color)) {
+    ::dawn::RenderPassColorAttachmentDescriptor color_attachment =
+        ::dawn::RenderPassColorAttachmentDescriptor();
+    color_attachment.attachment = render_pipeline_info_.fb_texture_view;
+    color_attachment.resolveTarget = nullptr;
+    color_attachment.clearColor = {color[0], color[1], color[2], color[3]};
+    color_attachment.loadOp = ::dawn::LoadOp::Clear;
+    color_attachment.storeOp = ::dawn::StoreOp::Store;
+
+    render_pipeline_info_.clear_render_pass =
+        device_.CreateRenderPassDescriptorBuilder()
+            .SetColorAttachments(1, &color_attachment)
+            .GetResult();
+    std::copy(color, color + 4,
+              render_pipeline_info_.clear_render_pass_color);
+    render_pipeline_info_.has_clear_render_pass = true;
+  }
+
+  command_buffer_builder_
+      .BeginRenderPass(render_pipeline_info_.clear_render_pass)
+      .EndPass();
   return {};
 }
 
@@ -322,13 +375,9 @@ Result EngineDawn::DoBuffer(const BufferCommand*) {
 }
 
 Result EngineDawn::DoProcessCommands() {
-  Result result;
-
   // TODO(dneto): How to distinguish the compute case: It won't have a
   // framebuffer?
 
-  // Add one more command to the command buffer builder, which is to
-  // copy the framebuffer texture to the framebuffer host-side buffer.
   ::dawn::Buffer& fb_buffer = render_pipeline_info_.fb_buffer;
   if (!fb_buffer) {
     return Result(
@@ -336,52 +385,129 @@ Result EngineDawn::DoProcessCommands() {
         "any graphics pipeline commands?");
   }
 
-  result = CreateCommandBufferBuilderIfNeeded();
+  // Nothing was recorded since the last submission; the framebuffer and
+  // any rows already copied from it are still current.
+  if (!command_buffer_builder_)
+    return {};
+
+  // Make sure we have a queue.
+  if (!queue_)
+    queue_ = device_.CreateQueue();
+
+  // Now run the commands.
+  auto command_buffer = command_buffer_builder_.GetResult();
+  queue_.Submit(1, &command_buffer);
+
+  // And any further commands start afresh.
+  DestroyCommandBufferBuilder();
+
+  // The framebuffer texture changed, so rows copied to the host before
+  // no longer reflect it. The copy back happens when a probe asks for
+  // rows, and transfers only the rows the probe reads.
+  fb_contents_stale_ = true;
+  device_.Tick();
+  return {};
+}
+
+Result EngineDawn::CopyFramebufferRowsToHost(uint32_t row_begin,
+                                             uint32_t row_count) {
+  ::dawn::Buffer& fb_buffer = render_pipeline_info_.fb_buffer;
+
+  // The requested rows were already copied since the last submission and
+  // are still mapped.
+  if (!fb_contents_stale_ && render_pipeline_info_.fb_data != nullptr &&
+      row_begin >= fb_copied_row_begin_ &&
+      row_begin + row_count <= fb_copied_row_end_) {
+    return {};
+  }
+
+  // Rows copied earlier are still valid in the buffer; widen the span to
+  // the union so the covered rows stay one contiguous range.
+  if (!fb_contents_stale_ && fb_copied_row_end_ > fb_copied_row_begin_) {
+    const uint32_t row_end =
+        std::max(fb_copied_row_end_, row_begin + row_count);
+    row_begin = std::min(row_begin, fb_copied_row_begin_);
+    row_count = row_end - row_begin;
+  }
+
+  // Dawn requires the buffer offset of a texture copy to be 512 byte
+  // aligned. The row stride is a multiple of 256, so walking the start
+  // up by at most one row brings the offset into alignment.
+  while (row_begin > 0 &&
+         (row_begin * render_pipeline_info_.fb_row_stride) % 512 != 0) {
+    --row_begin;
+    ++row_count;
+  }
+
+  // The buffer is about to be rewritten by the device; it cannot stay
+  // mapped for that.
+  if (render_pipeline_info_.fb_data != nullptr) {
+    fb_buffer.Unmap();
+    render_pipeline_info_.fb_data = nullptr;
+  }
+
+  Result result = CreateCommandBufferBuilderIfNeeded();
   if (!result.IsSuccess())
     return result;
 
   {
-    const int x = 0, y = 0, z = 0, depth = 1, level = 0, slice = 0,
-              buffer_offset = 0;
+    const int x = 0, z = 0, depth = 1, level = 0, slice = 0;
 
     ::dawn::TextureCopyView texture_copy_view = ::dawn::TextureCopyView();
     texture_copy_view.texture = render_pipeline_info_.fb_texture;
     texture_copy_view.level = level;
     texture_copy_view.slice = slice;
-    texture_copy_view.origin = {x, y, z};
+    texture_copy_view.origin.x = x;
+    texture_copy_view.origin.y = static_cast<int>(row_begin);
+    texture_copy_view.origin.z = z;
 
+    // The rows land at the offsets a whole framebuffer copy would put
+    // them, so probe reads index the buffer the same either way.
     ::dawn::BufferCopyView buffer_copy_view = ::dawn::BufferCopyView();
     buffer_copy_view.buffer = fb_buffer;
-    buffer_copy_view.offset = buffer_offset;
+    buffer_copy_view.offset = row_begin * render_pipeline_info_.fb_row_stride;
     buffer_copy_view.rowPitch = render_pipeline_info_.fb_row_stride;
     buffer_copy_view.imageHeight = 1;
 
-    ::dawn::Extent3D extent = {kFramebufferWidth, kFramebufferHeight, depth};
+    ::dawn::Extent3D extent = {kFramebufferWidth, row_count, depth};
 
     command_buffer_builder_.CopyTextureToBuffer(&texture_copy_view,
                                                 &buffer_copy_view, &extent);
   }
 
-  // Make sure we have a queue.
   if (!queue_)
     queue_ = device_.CreateQueue();
 
-  // Now run the commands.
   auto command_buffer = command_buffer_builder_.GetResult();
+  queue_.Submit(1, &command_buffer);
+  DestroyCommandBufferBuilder();
 
-  if (render_pipeline_info_.fb_data != nullptr) {
-    fb_buffer.Unmap();
-    render_pipeline_info_.fb_data = nullptr;
-  }
+  // The probe consumes the rows right away, so map and wait here; the
+  // transfer is sized to the probe and no longer worth overlapping.
+  fb_map_ = MapResult();
+  StartBufferMapRead(fb_buffer, render_pipeline_info_.fb_size, &fb_map_);
+  fb_map_pending_ = true;
+  result = FinishFramebufferReadback();
+  if (!result.IsSuccess())
+    return result;
 
-  queue_.Submit(1, &command_buffer);
+  fb_copied_row_begin_ = row_begin;
+  fb_copied_row_end_ = row_begin + row_count;
+  fb_contents_stale_ = false;
+  return {};
+}
 
-  // And any further commands start afresh.
-  DestroyCommandBufferBuilder();
+Result EngineDawn::FinishFramebufferReadback() {
+  if (!fb_map_pending_)
+    return {};
+
+  Result r = WaitForMappedBuffer(device_, &fb_map_);
+  fb_map_pending_ = false;
+  if (!r.IsSuccess())
+    return r;
 
-  MapResult map = MapBuffer(device_, fb_buffer, render_pipeline_info_.fb_size);
-  render_pipeline_info_.fb_data = map.data;
-  return map.result;
+  render_pipeline_info_.fb_data = fb_map_.data;
+  return {};
 }
 
 Result EngineDawn::CreateCommandBufferBuilderIfNeeded() {
@@ -413,12 +539,22 @@ Result EngineDawn::CreateRenderObjectsIfNeeded() {
 
 Result EngineDawn::CreateFramebufferIfNeeded() {
   Result result;
+
+  // The framebuffer texture and its host-side readback buffer carry no
+  // per-command state, so the ones made for the first command serve the
+  // whole script; recreating them per command would also throw away the
+  // readback mapping kept open between submissions.
+  if (render_pipeline_info_.fb_texture && render_pipeline_info_.fb_buffer)
+    return {};
+
   {
     ::dawn::Texture fb_texture;
     result = MakeFramebufferTexture(device_, kFramebufferFormat, &fb_texture);
     if (!result.IsSuccess())
       return result;
     render_pipeline_info_.fb_texture = std::move(fb_texture);
+    render_pipeline_info_.fb_texture_view =
+        render_pipeline_info_.fb_texture.CreateDefaultTextureView();
   }
 
   {
@@ -439,9 +575,49 @@ Result EngineDawn::CreateFramebufferIfNeeded() {
   return {};
 }
 
-Result EngineDawn::GetFrameBufferInfo(ResourceInfo* info) {
+Result EngineDawn::GetFrameBufferInfo(const ProbeCommand* probe,
+                                      ResourceInfo* info) {
   assert(info);
 
+  if (!render_pipeline_info_.fb_buffer)
+    return Result("Dawn: FrameBuffer was not created");
+
+  // Copy only the rows of the framebuffer the probe will read; a probe of
+  // a single pixel does not need the whole attachment transferred to the
+  // host. No probe or a whole window probe reads everything.
+  uint32_t row_begin = 0;
+  uint32_t row_count = kFramebufferHeight;
+  if (probe && !probe->IsWholeWindow()) {
+    if (probe->IsRelative()) {
+      row_begin = static_cast<uint32_t>(
+          static_cast<float>(kFramebufferHeight) * probe->GetY());
+      if (probe->IsProbeRect()) {
+        row_count = static_cast<uint32_t>(
+            static_cast<float>(kFramebufferHeight) * probe->GetHeight());
+      } else {
+        row_count = 1;
+      }
+    } else {
+      row_begin = static_cast<uint32_t>(probe->GetY());
+      row_count = probe->IsProbeRect()
+                      ? static_cast<uint32_t>(probe->GetHeight())
+                      : 1;
+    }
+
+    // An out of range probe is reported by the verifier; keep the copy
+    // inside the image so the command itself stays valid.
+    if (row_begin >= kFramebufferHeight) {
+      row_begin = 0;
+      row_count = kFramebufferHeight;
+    } else if (row_begin + row_count > kFramebufferHeight) {
+      row_count = kFramebufferHeight - row_begin;
+    }
+  }
+
+  Result result = CopyFramebufferRowsToHost(row_begin, row_count);
+  if (!result.IsSuccess())
+    return result;
+
   if (render_pipeline_info_.fb_data == nullptr)
     return Result("Dawn: FrameBuffer is not mapped");
 
@@ -461,6 +637,10 @@ Result EngineDawn::GetFrameBuffer(std::vector<Value>* values) {
   return Result("Dawn::GetFrameBuffer not implemented");
 }
 
+Result EngineDawn::GetFrameBufferData(void*, size_t) {
+  return Result("Dawn::GetFrameBufferData not implemented");
+}
+
 Result EngineDawn::GetDescriptorInfo(const uint32_t,
                                      const uint32_t,
                                      ResourceInfo*) {
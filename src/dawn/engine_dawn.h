@@ -16,6 +16,7 @@
 #define SRC_DAWN_ENGINE_DAWN_H_
 
 #include <cstdint>
+#include <map>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -29,6 +30,14 @@
 namespace amber {
 namespace dawn {
 
+// Result status object and data pointer resulting from a buffer mapping.
+// The asynchronous map callback writes into this object, so its address
+// must stay fixed while a map is in flight.
+struct MapResult {
+  Result result;
+  const void* data = nullptr;
+};
+
 class EngineDawn : public Engine {
  public:
   EngineDawn();
@@ -47,10 +56,7 @@ class EngineDawn : public Engine {
   // and a fragment shader.
   Result CreatePipeline(PipelineType) override;
   Result SetShader(ShaderType type, const std::vector<uint32_t>& data) override;
-  Result SetBuffer(BufferType type,
-                   uint8_t location,
-                   const Format& format,
-                   const std::vector<Value>& data) override;
+  Result SetBuffer(Buffer* buffer) override;
   Result DoClearColor(const ClearColorCommand* cmd) override;
   Result DoClearStencil(const ClearStencilCommand* cmd) override;
   Result DoClearDepth(const ClearDepthCommand* cmd) override;
@@ -63,8 +69,10 @@ class EngineDawn : public Engine {
       const PatchParameterVerticesCommand* cmd) override;
   Result DoBuffer(const BufferCommand* cmd) override;
   Result DoProcessCommands() override;
-  Result GetFrameBufferInfo(ResourceInfo* info) override;
+  Result GetFrameBufferInfo(const ProbeCommand* probe,
+                            ResourceInfo* info) override;
   Result GetFrameBuffer(std::vector<Value>* values) override;
+  Result GetFrameBufferData(void* dst, size_t row_stride) override;
   Result GetDescriptorInfo(const uint32_t descriptor_set,
                            const uint32_t binding,
                            ResourceInfo* info) override;
@@ -83,6 +91,16 @@ class EngineDawn : public Engine {
   // resulting pixels for use in checking expectations, and bookkeeping info
   // for that host-side buffer.
   Result CreateFramebufferIfNeeded();
+  // Completes the in-flight framebuffer readback, if any, and publishes
+  // the mapped pointer into |render_pipeline_info_.fb_data|. A no-op when
+  // no readback is pending.
+  Result FinishFramebufferReadback();
+  // Copies rows [|row_begin|, |row_begin| + |row_count|) of the
+  // framebuffer texture into the readback buffer at the offsets a whole
+  // framebuffer copy would use, maps the buffer and waits for the data.
+  // Rows still covered from an earlier copy of the same rendering are
+  // served without touching the device.
+  Result CopyFramebufferRowsToHost(uint32_t row_begin, uint32_t row_count);
 
   ::dawn::Device device_;
   ::dawn::Queue queue_;
@@ -90,10 +108,30 @@ class EngineDawn : public Engine {
 
   std::unordered_map<ShaderType, ::dawn::ShaderModule, CastHash<ShaderType>>
       module_for_type_;
+  // Shader modules already translated by the backend, keyed by their
+  // SPIR-V words. |module_for_type_| is reset per script but this cache
+  // survives engine reuse, so a script re-sending the same binary skips
+  // Dawn's shader translation. Cleared only on Shutdown(), when the
+  // device the modules belong to goes away.
+  std::map<std::vector<uint32_t>, ::dawn::ShaderModule> module_cache_;
   // Accumulated data for the current compute pipeline.
   ComputePipelineInfo compute_pipeline_info_;
   // Accumulated data for the current render pipeline.
   RenderPipelineInfo render_pipeline_info_;
+
+  // In-flight framebuffer readback started by
+  // CopyFramebufferRowsToHost(); the wait happens in
+  // FinishFramebufferReadback().
+  MapResult fb_map_;
+  bool fb_map_pending_ = false;
+
+  // Rows of the framebuffer texture that CopyFramebufferRowsToHost()
+  // already transferred into the readback buffer. Valid only while
+  // |fb_contents_stale_| is false; a submission rendering again marks
+  // everything stale.
+  uint32_t fb_copied_row_begin_ = 0;
+  uint32_t fb_copied_row_end_ = 0;
+  bool fb_contents_stale_ = true;
 };
 
 }  // namespace dawn
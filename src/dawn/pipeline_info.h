@@ -38,6 +38,15 @@ struct RenderPipelineInfo {
 
   // The framebuffer color render target.  This resides on the GPU.
   ::dawn::Texture fb_texture;
+  // Default view of |fb_texture|, created with it and reused by every
+  // render pass instead of being recreated per command.
+  ::dawn::TextureView fb_texture_view;
+  // Render pass descriptor that clears |fb_texture|, kept across
+  // commands and rebuilt only when the clear color changes, so back to
+  // back clears skip the descriptor builder round trip.
+  ::dawn::RenderPassDescriptor clear_render_pass;
+  float clear_render_pass_color[4] = {0.f, 0.f, 0.f, 0.f};
+  bool has_clear_render_pass = false;
   // The buffer to which we will copy the rendered pixel values, for
   // use on the host.
   ::dawn::Buffer fb_buffer;
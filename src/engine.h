@@ -21,6 +21,7 @@
 
 #include "amber/amber.h"
 #include "amber/result.h"
+#include "src/buffer.h"
 #include "src/buffer_data.h"
 #include "src/command.h"
 #include "src/feature.h"
@@ -91,6 +92,29 @@ class Engine {
   /// Shutdown the engine and cleanup any resources.
   virtual Result Shutdown() = 0;
 
+  /// Seeds the engine's pipeline cache with |data| saved from an earlier
+  /// run. Must be called before Initialize(). Engines without a pipeline
+  /// cache ignore the data.
+  virtual Result SetPipelineCacheData(const std::vector<uint8_t>&) {
+    return {};
+  }
+
+  /// Copies the engine's serialized pipeline cache into |data|, or leaves it
+  /// empty for engines without one.
+  virtual Result GetPipelineCacheData(std::vector<uint8_t>*) { return {}; }
+
+  /// Turns per command GPU timing on or off. Engines without timestamp
+  /// support ignore this.
+  virtual void SetCommandTimingEnabled(bool) {}
+
+  /// Appends the GPU durations measured since the last call to
+  /// |timings|, or leaves it untouched for engines without timing.
+  virtual Result GetCommandTimings(std::vector<CommandTiming>*) { return {}; }
+
+  /// Fills |usage| with the device memory drawn from each memory heap,
+  /// or leaves it empty for engines without memory accounting.
+  virtual Result GetMemoryUsage(std::vector<MemoryHeapUsage>*) { return {}; }
+
   /// Create graphics pipeline.
   virtual Result CreatePipeline(PipelineType type) = 0;
 
@@ -98,13 +122,11 @@ class Engine {
   virtual Result SetShader(ShaderType type,
                            const std::vector<uint32_t>& data) = 0;
 
-  /// Provides the data for a given buffer to be bound at the given location
-  /// This is used to declare and populate vertex and index inputs to a graphics
-  /// pipeline.
-  virtual Result SetBuffer(BufferType type,
-                           uint8_t location,
-                           const Format& format,
-                           const std::vector<Value>& data) = 0;
+  /// Provides |buffer| to be bound at its location. This is used to declare
+  /// and populate vertex and index inputs to a graphics pipeline. The engine
+  /// reads the type, location and format from the buffer and consumes the
+  /// packed form of its data where possible.
+  virtual Result SetBuffer(Buffer* buffer) = 0;
 
   /// Execute the clear color command
   virtual Result DoClearColor(const ClearColorCommand* cmd) = 0;
@@ -124,6 +146,19 @@ class Engine {
   /// Execute the draw arrays command
   virtual Result DoDrawArrays(const DrawArraysCommand* cmd) = 0;
 
+  /// Execute a run of consecutive draw arrays commands. Engines able to
+  /// record the run faster than one draw at a time e.g., in parallel,
+  /// override this; the default executes the commands one by one.
+  virtual Result DoDrawArraysBatch(
+      const std::vector<const DrawArraysCommand*>& cmds) {
+    for (const auto* cmd : cmds) {
+      Result r = DoDrawArrays(cmd);
+      if (!r.IsSuccess())
+        return r;
+    }
+    return {};
+  }
+
   /// Execute the compute command
   virtual Result DoCompute(const ComputeCommand* cmd) = 0;
 
@@ -139,21 +174,29 @@ class Engine {
   /// This covers both Vulkan buffers and images.
   virtual Result DoBuffer(const BufferCommand* cmd) = 0;
 
-  /// Run all queued commands and copy frame buffer data to the host
-  /// if graphics pipeline.
+  /// Run all queued commands.
   virtual Result DoProcessCommands() = 0;
 
   /// Get stride, width, height, and memory pointer of color frame buffer.
-  /// This is only valid if the buffer of color framebuffer is mapped into
-  /// the host address space. In particular, if we have run
-  /// DoProcessCommands() and since then no graphics pipeline drawing
-  /// commands have occurred e.g., DoClear, DoDrawArrays, DoDrawRect.
-  virtual Result GetFrameBufferInfo(ResourceInfo* info) = 0;
+  /// Ensures the region of the framebuffer |probe| will read is copied to
+  /// the host; |probe| may be nullptr meaning the whole framebuffer will
+  /// be read. The returned pointer stays valid until the next graphics
+  /// pipeline drawing command e.g., DoClear, DoDrawArrays, DoDrawRect.
+  virtual Result GetFrameBufferInfo(const ProbeCommand* probe,
+                                    ResourceInfo* info) = 0;
 
   /// Copy the content of the framebuffer into |values|, each value is a pixel
   /// in R8G8B8A8 format.
   virtual Result GetFrameBuffer(std::vector<Value>* values) = 0;
 
+  /// Copy the raw texel rows of the framebuffer into |dst|, placing the
+  /// start of each row |row_stride| bytes apart. |dst| must hold at least
+  /// height * |row_stride| bytes; |row_stride| must not be smaller than
+  /// the tightly packed row size reported by GetFrameBufferInfo(). Unlike
+  /// GetFrameBuffer() no per-channel Value objects are created, so this
+  /// is the path to use for large captures.
+  virtual Result GetFrameBufferData(void* dst, size_t row_stride) = 0;
+
   /// Copy the contents of the resource bound to the given descriptor
   /// and get the resource information e.g., size for buffer, width,
   /// height, depth for image of descriptor given as |descriptor_set|
@@ -162,8 +205,50 @@ class Engine {
                                    const uint32_t binding,
                                    ResourceInfo* info) = 0;
 
-  /// Sets the engine data to use.
-  void SetEngineData(const EngineData& data) { engine_data_ = data; }
+  /// Hint that the next GetDescriptorInfo() for the descriptor given as
+  /// |descriptor_set| and |binding| only needs |size| bytes at |offset|
+  /// readable on the host. Engines can use it to skip reading the rest
+  /// of the resource back; ignoring the hint is always correct, and the
+  /// default does so.
+  virtual Result SetDescriptorReadbackWindow(uint32_t,
+                                             uint32_t,
+                                             uint64_t,
+                                             uint64_t) {
+    return {};
+  }
+
+  /// Tells the engine a repeated execution of the same command stream is
+  /// about to run. Engines may reuse recordings made for the previous
+  /// iteration instead of rebuilding them; the default does nothing,
+  /// which is always correct.
+  virtual Result BeginRepeatIteration() { return {}; }
+
+  /// Tells the engine the repeated execution started by
+  /// BeginRepeatIteration() completed. The default does nothing.
+  virtual Result EndRepeatIteration() { return {}; }
+
+  /// Creates the pipeline state objects the draw or dispatch |cmd| will
+  /// need when it executes, without submitting any GPU work, so driver
+  /// compilation can happen before - or on a different thread than - the
+  /// run itself. Prewarming is purely an optimization; the default does
+  /// nothing, which is always correct.
+  virtual Result DoPrewarm(const Command*) { return {}; }
+
+  /// Checks the probe |cmd| against the bound descriptor contents on the
+  /// device, so only a verdict instead of the full resource crosses back
+  /// to the host. Engines whose descriptor storage lives in device local
+  /// memory should override this; the default leaves |*verified| false,
+  /// without error, and the caller falls back to reading the resource
+  /// back and running the host-side Verifier.
+  virtual Result DoVerifyProbeSSBOOnDevice(const ProbeSSBOCommand*,
+                                           bool* verified) {
+    *verified = false;
+    return {};
+  }
+
+  /// Sets the engine data to use. Virtual so wrapping engines, like the
+  /// trace recorder, can pass the data through to the engine they wrap.
+  virtual void SetEngineData(const EngineData& data) { engine_data_ = data; }
 
  protected:
   Engine();
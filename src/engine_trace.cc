@@ -0,0 +1,515 @@
+// Copyright 2019 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/engine_trace.h"
+
+#include <fstream>
+#include <utility>
+
+#include "src/script_serializer.h"
+#include "src/serializer_stream.h"
+
+namespace amber {
+namespace {
+
+const uint32_t kTraceMagic = 0x43525441;  // 'ATRC'
+const uint32_t kTraceVersion = 1;
+
+/// Trace record opcodes. Every record is one opcode byte followed by
+/// that record's payload.
+enum TraceOp : uint8_t {
+  kOpInitialize = 0,       // features and extensions given to Initialize()
+  kOpSetEngineData,        // u32 fence timeout
+  kOpCreatePipeline,       // u8 pipeline type
+  kOpSetShader,            // u8 shader type, u32 word count, words
+  kOpSetBuffer,            // serialized buffer
+  kOpCommand,              // serialized command, dispatched by its type
+  kOpDrawBatch,            // u32 count, that many serialized draw commands
+  kOpProcessCommands,      // no payload
+  kOpFrameBufferInfo,      // bool has probe, serialized probe if so
+  kOpDescriptorInfo,       // u32 descriptor set, u32 binding
+  kOpReadbackWindow,       // u32 set, u32 binding, u64 offset, u64 size
+  kOpBeginRepeat,          // no payload
+  kOpEndRepeat,            // no payload
+};
+
+/// Invokes the Do* call matching |cmd|'s type on |engine|, the same
+/// dispatch the executor performs when it runs a script.
+Result DispatchCommand(Engine* engine, Command* cmd) {
+  switch (cmd->GetType()) {
+    case Command::Type::kClear:
+      return engine->DoClear(cmd->AsClear());
+    case Command::Type::kClearColor:
+      return engine->DoClearColor(cmd->AsClearColor());
+    case Command::Type::kClearDepth:
+      return engine->DoClearDepth(cmd->AsClearDepth());
+    case Command::Type::kClearStencil:
+      return engine->DoClearStencil(cmd->AsClearStencil());
+    case Command::Type::kCompute:
+      return engine->DoCompute(cmd->AsCompute());
+    case Command::Type::kDrawArrays:
+      return engine->DoDrawArrays(cmd->AsDrawArrays());
+    case Command::Type::kDrawRect:
+      return engine->DoDrawRect(cmd->AsDrawRect());
+    case Command::Type::kEntryPoint:
+      return engine->DoEntryPoint(cmd->AsEntryPoint());
+    case Command::Type::kPatchParameterVertices:
+      return engine->DoPatchParameterVertices(
+          cmd->AsPatchParameterVertices());
+    case Command::Type::kBuffer: {
+      // Data file backed buffers map their file before the engine sees
+      // them, exactly as the executor does.
+      Result r = cmd->AsBuffer()->LoadDataFileIfNeeded();
+      if (!r.IsSuccess())
+        return r;
+      return engine->DoBuffer(cmd->AsBuffer());
+    }
+    default:
+      return Result("engine trace has a record the engine cannot execute");
+  }
+}
+
+}  // namespace
+
+TraceEngine::TraceEngine(std::unique_ptr<Engine> engine,
+                         const std::string& path)
+    : engine_(std::move(engine)), path_(path) {
+  ByteWriter w(&trace_);
+  w.U32(kTraceMagic);
+  w.U32(kTraceVersion);
+}
+
+TraceEngine::~TraceEngine() = default;
+
+Result TraceEngine::Initialize(EngineConfig* config,
+                               const std::vector<Feature>& features,
+                               const std::vector<std::string>& extensions) {
+  ByteWriter w(&trace_);
+  w.U8(kOpInitialize);
+  w.U32(static_cast<uint32_t>(features.size()));
+  for (const auto& feature : features)
+    w.U32(static_cast<uint32_t>(feature));
+  w.U32(static_cast<uint32_t>(extensions.size()));
+  for (const auto& ext : extensions)
+    w.Str(ext);
+  return engine_->Initialize(config, features, extensions);
+}
+
+Result TraceEngine::Shutdown() {
+  Result write_result;
+  std::ofstream file(path_, std::ios::out | std::ios::binary);
+  if (!file.is_open()) {
+    write_result = Result("Cannot open engine trace file: " + path_);
+  } else {
+    file.write(reinterpret_cast<const char*>(trace_.data()),
+               static_cast<std::streamsize>(trace_.size()));
+    if (!file.good())
+      write_result = Result("Failed to write engine trace file: " + path_);
+  }
+
+  Result r = engine_->Shutdown();
+  if (!r.IsSuccess())
+    return r;
+  return write_result;
+}
+
+void TraceEngine::SetEngineData(const EngineData& data) {
+  ByteWriter w(&trace_);
+  w.U8(kOpSetEngineData);
+  w.U32(data.fence_timeout_ms);
+  engine_->SetEngineData(data);
+}
+
+Result TraceEngine::SetPipelineCacheData(const std::vector<uint8_t>& data) {
+  return engine_->SetPipelineCacheData(data);
+}
+
+Result TraceEngine::GetPipelineCacheData(std::vector<uint8_t>* data) {
+  return engine_->GetPipelineCacheData(data);
+}
+
+void TraceEngine::SetCommandTimingEnabled(bool enabled) {
+  engine_->SetCommandTimingEnabled(enabled);
+}
+
+Result TraceEngine::GetCommandTimings(std::vector<CommandTiming>* timings) {
+  return engine_->GetCommandTimings(timings);
+}
+
+Result TraceEngine::GetMemoryUsage(std::vector<MemoryHeapUsage>* usage) {
+  return engine_->GetMemoryUsage(usage);
+}
+
+Result TraceEngine::CreatePipeline(PipelineType type) {
+  ByteWriter w(&trace_);
+  w.U8(kOpCreatePipeline);
+  w.U8(static_cast<uint8_t>(type));
+  return engine_->CreatePipeline(type);
+}
+
+Result TraceEngine::SetShader(ShaderType type,
+                              const std::vector<uint32_t>& data) {
+  ByteWriter w(&trace_);
+  w.U8(kOpSetShader);
+  w.U8(static_cast<uint8_t>(type));
+  w.U32(static_cast<uint32_t>(data.size()));
+  for (uint32_t word : data)
+    w.U32(word);
+  return engine_->SetShader(type, data);
+}
+
+Result TraceEngine::SetBuffer(Buffer* buffer) {
+  trace_.push_back(kOpSetBuffer);
+  Result r = ScriptSerializer::SerializeBuffer(buffer, &trace_);
+  if (!r.IsSuccess())
+    return r;
+  return engine_->SetBuffer(buffer);
+}
+
+Result TraceEngine::RecordCommand(uint8_t op, const Command* cmd) {
+  trace_.push_back(op);
+  // The serializer reads through the non-const As*() accessors but does
+  // not modify the command.
+  return ScriptSerializer::SerializeCommand(const_cast<Command*>(cmd),
+                                            &trace_);
+}
+
+Result TraceEngine::DoClearColor(const ClearColorCommand* cmd) {
+  Result r = RecordCommand(kOpCommand, cmd);
+  if (!r.IsSuccess())
+    return r;
+  return engine_->DoClearColor(cmd);
+}
+
+Result TraceEngine::DoClearStencil(const ClearStencilCommand* cmd) {
+  Result r = RecordCommand(kOpCommand, cmd);
+  if (!r.IsSuccess())
+    return r;
+  return engine_->DoClearStencil(cmd);
+}
+
+Result TraceEngine::DoClearDepth(const ClearDepthCommand* cmd) {
+  Result r = RecordCommand(kOpCommand, cmd);
+  if (!r.IsSuccess())
+    return r;
+  return engine_->DoClearDepth(cmd);
+}
+
+Result TraceEngine::DoClear(const ClearCommand* cmd) {
+  Result r = RecordCommand(kOpCommand, cmd);
+  if (!r.IsSuccess())
+    return r;
+  return engine_->DoClear(cmd);
+}
+
+Result TraceEngine::DoDrawRect(const DrawRectCommand* cmd) {
+  Result r = RecordCommand(kOpCommand, cmd);
+  if (!r.IsSuccess())
+    return r;
+  return engine_->DoDrawRect(cmd);
+}
+
+Result TraceEngine::DoDrawArrays(const DrawArraysCommand* cmd) {
+  Result r = RecordCommand(kOpCommand, cmd);
+  if (!r.IsSuccess())
+    return r;
+  return engine_->DoDrawArrays(cmd);
+}
+
+Result TraceEngine::DoDrawArraysBatch(
+    const std::vector<const DrawArraysCommand*>& cmds) {
+  ByteWriter w(&trace_);
+  w.U8(kOpDrawBatch);
+  w.U32(static_cast<uint32_t>(cmds.size()));
+  for (const auto* cmd : cmds) {
+    Result r = ScriptSerializer::SerializeCommand(
+        const_cast<DrawArraysCommand*>(cmd), &trace_);
+    if (!r.IsSuccess())
+      return r;
+  }
+  return engine_->DoDrawArraysBatch(cmds);
+}
+
+Result TraceEngine::DoCompute(const ComputeCommand* cmd) {
+  Result r = RecordCommand(kOpCommand, cmd);
+  if (!r.IsSuccess())
+    return r;
+  return engine_->DoCompute(cmd);
+}
+
+Result TraceEngine::DoEntryPoint(const EntryPointCommand* cmd) {
+  Result r = RecordCommand(kOpCommand, cmd);
+  if (!r.IsSuccess())
+    return r;
+  return engine_->DoEntryPoint(cmd);
+}
+
+Result TraceEngine::DoPatchParameterVertices(
+    const PatchParameterVerticesCommand* cmd) {
+  Result r = RecordCommand(kOpCommand, cmd);
+  if (!r.IsSuccess())
+    return r;
+  return engine_->DoPatchParameterVertices(cmd);
+}
+
+Result TraceEngine::DoBuffer(const BufferCommand* cmd) {
+  Result r = RecordCommand(kOpCommand, cmd);
+  if (!r.IsSuccess())
+    return r;
+  return engine_->DoBuffer(cmd);
+}
+
+Result TraceEngine::DoProcessCommands() {
+  trace_.push_back(kOpProcessCommands);
+  return engine_->DoProcessCommands();
+}
+
+Result TraceEngine::GetFrameBufferInfo(const ProbeCommand* probe,
+                                       ResourceInfo* info) {
+  ByteWriter w(&trace_);
+  w.U8(kOpFrameBufferInfo);
+  w.Bool(probe != nullptr);
+  if (probe) {
+    Result r = ScriptSerializer::SerializeCommand(
+        const_cast<ProbeCommand*>(probe), &trace_);
+    if (!r.IsSuccess())
+      return r;
+  }
+  return engine_->GetFrameBufferInfo(probe, info);
+}
+
+// The bulk framebuffer extraction calls serve host side image dumps, not
+// the engine workload, so they are forwarded without being recorded.
+Result TraceEngine::GetFrameBuffer(std::vector<Value>* values) {
+  return engine_->GetFrameBuffer(values);
+}
+
+Result TraceEngine::GetFrameBufferData(void* dst, size_t row_stride) {
+  return engine_->GetFrameBufferData(dst, row_stride);
+}
+
+Result TraceEngine::GetDescriptorInfo(const uint32_t descriptor_set,
+                                      const uint32_t binding,
+                                      ResourceInfo* info) {
+  ByteWriter w(&trace_);
+  w.U8(kOpDescriptorInfo);
+  w.U32(descriptor_set);
+  w.U32(binding);
+  return engine_->GetDescriptorInfo(descriptor_set, binding, info);
+}
+
+Result TraceEngine::SetDescriptorReadbackWindow(uint32_t descriptor_set,
+                                                uint32_t binding,
+                                                uint64_t offset,
+                                                uint64_t size) {
+  ByteWriter w(&trace_);
+  w.U8(kOpReadbackWindow);
+  w.U32(descriptor_set);
+  w.U32(binding);
+  w.U64(offset);
+  w.U64(size);
+  return engine_->SetDescriptorReadbackWindow(descriptor_set, binding, offset,
+                                              size);
+}
+
+Result TraceEngine::BeginRepeatIteration() {
+  trace_.push_back(kOpBeginRepeat);
+  return engine_->BeginRepeatIteration();
+}
+
+Result TraceEngine::EndRepeatIteration() {
+  trace_.push_back(kOpEndRepeat);
+  return engine_->EndRepeatIteration();
+}
+
+// Prewarming and on-device verification are optimizations of the run
+// being recorded, not part of the workload to reproduce.
+Result TraceEngine::DoPrewarm(const Command* cmd) {
+  return engine_->DoPrewarm(cmd);
+}
+
+Result TraceEngine::DoVerifyProbeSSBOOnDevice(const ProbeSSBOCommand* cmd,
+                                              bool* verified) {
+  return engine_->DoVerifyProbeSSBOOnDevice(cmd, verified);
+}
+
+Result ReplayEngineTrace(const uint8_t* data,
+                         size_t size,
+                         EngineConfig* config,
+                         Engine* engine) {
+  ByteReader r(data, size);
+  if (r.U32() != kTraceMagic)
+    return Result("engine trace has invalid magic number");
+  if (r.U32() != kTraceVersion)
+    return Result("engine trace has unsupported version");
+
+  // Deserialized commands and buffers stay alive for the whole replay;
+  // the engine may hold pointers into them between calls.
+  std::vector<std::unique_ptr<Command>> commands;
+  std::vector<std::unique_ptr<Buffer>> buffers;
+  bool initialized = false;
+
+  while (r.IsValid() && !r.AtEnd()) {
+    uint8_t op = r.U8();
+    Result result;
+
+    switch (op) {
+      case kOpInitialize: {
+        std::vector<Feature> features;
+        uint32_t count = r.U32();
+        for (uint32_t i = 0; i < count && r.IsValid(); ++i)
+          features.push_back(static_cast<Feature>(r.U32()));
+
+        std::vector<std::string> extensions;
+        count = r.U32();
+        for (uint32_t i = 0; i < count && r.IsValid(); ++i)
+          extensions.push_back(r.Str());
+
+        if (!r.IsValid())
+          break;
+        result = engine->Initialize(config, features, extensions);
+        initialized = true;
+        break;
+      }
+      case kOpSetEngineData: {
+        EngineData engine_data;
+        engine_data.fence_timeout_ms = r.U32();
+        engine->SetEngineData(engine_data);
+        break;
+      }
+      case kOpCreatePipeline:
+        result = engine->CreatePipeline(static_cast<PipelineType>(r.U8()));
+        break;
+      case kOpSetShader: {
+        auto type = static_cast<ShaderType>(r.U8());
+        uint32_t count = r.U32();
+        std::vector<uint32_t> words;
+        words.reserve(count);
+        for (uint32_t i = 0; i < count && r.IsValid(); ++i)
+          words.push_back(r.U32());
+
+        if (!r.IsValid())
+          break;
+        result = engine->SetShader(type, words);
+        break;
+      }
+      case kOpSetBuffer: {
+        size_t consumed = 0;
+        std::unique_ptr<Buffer> buffer;
+        result = ScriptSerializer::DeserializeBuffer(
+            data + r.Offset(), size - r.Offset(), &consumed, &buffer);
+        if (!result.IsSuccess())
+          break;
+        r.Skip(consumed);
+
+        buffers.push_back(std::move(buffer));
+        result = engine->SetBuffer(buffers.back().get());
+        break;
+      }
+      case kOpCommand: {
+        size_t consumed = 0;
+        std::unique_ptr<Command> cmd;
+        result = ScriptSerializer::DeserializeCommand(
+            data + r.Offset(), size - r.Offset(), &consumed, &cmd);
+        if (!result.IsSuccess())
+          break;
+        r.Skip(consumed);
+
+        commands.push_back(std::move(cmd));
+        result = DispatchCommand(engine, commands.back().get());
+        break;
+      }
+      case kOpDrawBatch: {
+        uint32_t count = r.U32();
+        std::vector<const DrawArraysCommand*> batch;
+        for (uint32_t i = 0; i < count && r.IsValid(); ++i) {
+          size_t consumed = 0;
+          std::unique_ptr<Command> cmd;
+          result = ScriptSerializer::DeserializeCommand(
+              data + r.Offset(), size - r.Offset(), &consumed, &cmd);
+          if (!result.IsSuccess())
+            break;
+          r.Skip(consumed);
+
+          if (!cmd->IsDrawArrays())
+            return Result("engine trace draw batch holds a non draw record");
+          commands.push_back(std::move(cmd));
+          batch.push_back(commands.back()->AsDrawArrays());
+        }
+        if (!result.IsSuccess() || !r.IsValid())
+          break;
+        result = engine->DoDrawArraysBatch(batch);
+        break;
+      }
+      case kOpProcessCommands:
+        result = engine->DoProcessCommands();
+        break;
+      case kOpFrameBufferInfo: {
+        const ProbeCommand* probe = nullptr;
+        if (r.Bool()) {
+          size_t consumed = 0;
+          std::unique_ptr<Command> cmd;
+          result = ScriptSerializer::DeserializeCommand(
+              data + r.Offset(), size - r.Offset(), &consumed, &cmd);
+          if (!result.IsSuccess())
+            break;
+          r.Skip(consumed);
+
+          if (!cmd->IsProbe())
+            return Result("engine trace probe record holds a non probe");
+          commands.push_back(std::move(cmd));
+          probe = commands.back()->AsProbe();
+        }
+        ResourceInfo info;
+        result = engine->GetFrameBufferInfo(probe, &info);
+        break;
+      }
+      case kOpDescriptorInfo: {
+        uint32_t descriptor_set = r.U32();
+        uint32_t binding = r.U32();
+        ResourceInfo info;
+        result = engine->GetDescriptorInfo(descriptor_set, binding, &info);
+        break;
+      }
+      case kOpReadbackWindow: {
+        uint32_t descriptor_set = r.U32();
+        uint32_t binding = r.U32();
+        uint64_t offset = r.U64();
+        uint64_t window_size = r.U64();
+        result = engine->SetDescriptorReadbackWindow(descriptor_set, binding,
+                                                     offset, window_size);
+        break;
+      }
+      case kOpBeginRepeat:
+        result = engine->BeginRepeatIteration();
+        break;
+      case kOpEndRepeat:
+        result = engine->EndRepeatIteration();
+        break;
+      default:
+        return Result("engine trace has unknown record type");
+    }
+
+    if (!result.IsSuccess())
+      return result;
+  }
+
+  if (!r.IsValid())
+    return Result("engine trace is truncated or corrupt");
+  if (!initialized)
+    return Result("engine trace is missing its initialize record");
+  return {};
+}
+
+}  // namespace amber
@@ -0,0 +1,110 @@
+// Copyright 2019 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_ENGINE_TRACE_H_
+#define SRC_ENGINE_TRACE_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "amber/result.h"
+#include "src/engine.h"
+
+namespace amber {
+
+/// Engine wrapper recording every call it forwards - the shader
+/// binaries, buffer declarations and commands the wrapped engine
+/// executes - into a compact binary trace. Replaying the trace against
+/// a bare engine re-runs the exact device workload without parsing,
+/// shader compilation or any other front-end work, which is what driver
+/// A/B comparisons want to measure. The format is internal to Amber;
+/// traces are only guaranteed to replay with the same Amber version
+/// which recorded them.
+class TraceEngine : public Engine {
+ public:
+  /// Wraps |engine|, which must outlive recording. The trace is written
+  /// to |path| when Shutdown() is called.
+  TraceEngine(std::unique_ptr<Engine> engine, const std::string& path);
+  ~TraceEngine() override;
+
+  Result Initialize(EngineConfig* config,
+                    const std::vector<Feature>& features,
+                    const std::vector<std::string>& extensions) override;
+  Result Shutdown() override;
+  void SetEngineData(const EngineData& data) override;
+  Result SetPipelineCacheData(const std::vector<uint8_t>& data) override;
+  Result GetPipelineCacheData(std::vector<uint8_t>* data) override;
+  void SetCommandTimingEnabled(bool enabled) override;
+  Result GetCommandTimings(std::vector<CommandTiming>* timings) override;
+  Result GetMemoryUsage(std::vector<MemoryHeapUsage>* usage) override;
+  Result CreatePipeline(PipelineType type) override;
+  Result SetShader(ShaderType type, const std::vector<uint32_t>& data) override;
+  Result SetBuffer(Buffer* buffer) override;
+  Result DoClearColor(const ClearColorCommand* cmd) override;
+  Result DoClearStencil(const ClearStencilCommand* cmd) override;
+  Result DoClearDepth(const ClearDepthCommand* cmd) override;
+  Result DoClear(const ClearCommand* cmd) override;
+  Result DoDrawRect(const DrawRectCommand* cmd) override;
+  Result DoDrawArrays(const DrawArraysCommand* cmd) override;
+  Result DoDrawArraysBatch(
+      const std::vector<const DrawArraysCommand*>& cmds) override;
+  Result DoCompute(const ComputeCommand* cmd) override;
+  Result DoEntryPoint(const EntryPointCommand* cmd) override;
+  Result DoPatchParameterVertices(
+      const PatchParameterVerticesCommand* cmd) override;
+  Result DoBuffer(const BufferCommand* cmd) override;
+  Result DoProcessCommands() override;
+  Result GetFrameBufferInfo(const ProbeCommand* probe,
+                            ResourceInfo* info) override;
+  Result GetFrameBuffer(std::vector<Value>* values) override;
+  Result GetFrameBufferData(void* dst, size_t row_stride) override;
+  Result GetDescriptorInfo(const uint32_t descriptor_set,
+                           const uint32_t binding,
+                           ResourceInfo* info) override;
+  Result SetDescriptorReadbackWindow(uint32_t descriptor_set,
+                                     uint32_t binding,
+                                     uint64_t offset,
+                                     uint64_t size) override;
+  Result BeginRepeatIteration() override;
+  Result EndRepeatIteration() override;
+  Result DoPrewarm(const Command* cmd) override;
+  Result DoVerifyProbeSSBOOnDevice(const ProbeSSBOCommand* cmd,
+                                   bool* verified) override;
+
+  /// The trace recorded so far, for callers keeping the bytes somewhere
+  /// other than the file Shutdown() writes.
+  const std::vector<uint8_t>& GetTrace() const { return trace_; }
+
+ private:
+  /// Records a command-carrying call as |op| plus the serialized |cmd|.
+  Result RecordCommand(uint8_t op, const Command* cmd);
+
+  std::unique_ptr<Engine> engine_;
+  std::string path_;
+  std::vector<uint8_t> trace_;
+};
+
+/// Replays the engine trace in |data| of |size| bytes against |engine|,
+/// which must not yet be initialized: the features and extensions the
+/// recording passed to Initialize() are in the trace, and |config| is
+/// handed through. The engine is not shut down on return.
+Result ReplayEngineTrace(const uint8_t* data,
+                         size_t size,
+                         EngineConfig* config,
+                         Engine* engine);
+
+}  // namespace amber
+
+#endif  // SRC_ENGINE_TRACE_H_
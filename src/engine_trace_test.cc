@@ -0,0 +1,224 @@
+// Copyright 2019 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/engine_trace.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "src/make_unique.h"
+
+namespace amber {
+namespace {
+
+/// Engine stub logging the name of every call it receives, so a
+/// recorded trace can be checked to replay the same call sequence.
+class CallLogEngine : public Engine {
+ public:
+  CallLogEngine() : Engine() {}
+  ~CallLogEngine() override = default;
+
+  Result Initialize(EngineConfig*,
+                    const std::vector<Feature>& features,
+                    const std::vector<std::string>& extensions) override {
+    calls.push_back("Initialize");
+    this->features = features;
+    this->extensions = extensions;
+    return {};
+  }
+  Result Shutdown() override {
+    calls.push_back("Shutdown");
+    return {};
+  }
+  Result CreatePipeline(PipelineType) override {
+    calls.push_back("CreatePipeline");
+    return {};
+  }
+  Result SetShader(ShaderType, const std::vector<uint32_t>& data) override {
+    calls.push_back("SetShader");
+    shader_words = data;
+    return {};
+  }
+  Result SetBuffer(Buffer* buffer) override {
+    calls.push_back("SetBuffer");
+    buffer_name = buffer->GetName();
+    return {};
+  }
+  Result DoClearColor(const ClearColorCommand*) override {
+    calls.push_back("DoClearColor");
+    return {};
+  }
+  Result DoClearStencil(const ClearStencilCommand*) override {
+    calls.push_back("DoClearStencil");
+    return {};
+  }
+  Result DoClearDepth(const ClearDepthCommand*) override {
+    calls.push_back("DoClearDepth");
+    return {};
+  }
+  Result DoClear(const ClearCommand*) override {
+    calls.push_back("DoClear");
+    return {};
+  }
+  Result DoDrawRect(const DrawRectCommand*) override {
+    calls.push_back("DoDrawRect");
+    return {};
+  }
+  Result DoDrawArrays(const DrawArraysCommand*) override {
+    calls.push_back("DoDrawArrays");
+    return {};
+  }
+  Result DoCompute(const ComputeCommand* cmd) override {
+    calls.push_back("DoCompute");
+    compute_x = cmd->GetX();
+    return {};
+  }
+  Result DoEntryPoint(const EntryPointCommand*) override {
+    calls.push_back("DoEntryPoint");
+    return {};
+  }
+  Result DoPatchParameterVertices(
+      const PatchParameterVerticesCommand*) override {
+    calls.push_back("DoPatchParameterVertices");
+    return {};
+  }
+  Result DoBuffer(const BufferCommand*) override {
+    calls.push_back("DoBuffer");
+    return {};
+  }
+  Result DoProcessCommands() override {
+    calls.push_back("DoProcessCommands");
+    return {};
+  }
+  Result GetFrameBufferInfo(const ProbeCommand*, ResourceInfo*) override {
+    calls.push_back("GetFrameBufferInfo");
+    return {};
+  }
+  Result GetFrameBuffer(std::vector<Value>*) override {
+    calls.push_back("GetFrameBuffer");
+    return {};
+  }
+  Result GetFrameBufferData(void*, size_t) override {
+    calls.push_back("GetFrameBufferData");
+    return {};
+  }
+  Result GetDescriptorInfo(const uint32_t, const uint32_t,
+                           ResourceInfo*) override {
+    calls.push_back("GetDescriptorInfo");
+    return {};
+  }
+
+  std::vector<std::string> calls;
+  std::vector<Feature> features;
+  std::vector<std::string> extensions;
+  std::vector<uint32_t> shader_words;
+  std::string buffer_name;
+  uint32_t compute_x = 0;
+};
+
+}  // namespace
+
+using EngineTraceTest = testing::Test;
+
+TEST_F(EngineTraceTest, ReplayRepeatsRecordedCalls) {
+  auto recorded = MakeUnique<CallLogEngine>();
+  auto* recorded_ptr = recorded.get();
+  TraceEngine trace(std::move(recorded), "");
+
+  Result r = trace.Initialize(nullptr, {Feature::kGeometryShader},
+                              {"VK_KHR_storage_buffer_storage_class"});
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  EngineData data;
+  data.fence_timeout_ms = 12345;
+  trace.SetEngineData(data);
+
+  r = trace.CreatePipeline(PipelineType::kCompute);
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  r = trace.SetShader(kShaderTypeCompute, {7, 8, 9});
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  DataBuffer buffer(BufferType::kVertex);
+  DatumType datum_type;
+  datum_type.SetType(DataType::kUint32);
+  buffer.SetDatumType(datum_type);
+  buffer.SetName("verts");
+  std::vector<Value> values(2);
+  values[0].SetIntValue(1);
+  values[1].SetIntValue(2);
+  buffer.SetData(std::move(values));
+  buffer.SetSize(2);
+  r = trace.SetBuffer(&buffer);
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  ComputeCommand compute;
+  compute.SetX(16);
+  compute.SetY(1);
+  compute.SetZ(1);
+  r = trace.DoCompute(&compute);
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  r = trace.DoProcessCommands();
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  ResourceInfo info;
+  r = trace.GetFrameBufferInfo(nullptr, &info);
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  CallLogEngine replayed;
+  r = ReplayEngineTrace(trace.GetTrace().data(), trace.GetTrace().size(),
+                        nullptr, &replayed);
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  EXPECT_EQ(recorded_ptr->calls, replayed.calls);
+  EXPECT_EQ(recorded_ptr->features, replayed.features);
+  EXPECT_EQ(recorded_ptr->extensions, replayed.extensions);
+  EXPECT_EQ(recorded_ptr->shader_words, replayed.shader_words);
+  EXPECT_EQ("verts", replayed.buffer_name);
+  EXPECT_EQ(16U, replayed.compute_x);
+}
+
+TEST_F(EngineTraceTest, ReplayRejectsBadMagic) {
+  std::vector<uint8_t> bogus = {0, 1, 2, 3, 4, 5, 6, 7};
+
+  CallLogEngine replayed;
+  Result r = ReplayEngineTrace(bogus.data(), bogus.size(), nullptr, &replayed);
+  ASSERT_FALSE(r.IsSuccess());
+  EXPECT_EQ("engine trace has invalid magic number", r.Error());
+}
+
+TEST_F(EngineTraceTest, ReplayRequiresInitialize) {
+  std::vector<uint8_t> header;
+  // Magic 'ATRC' and version 1, little endian, with no records.
+  header.push_back(0x41);
+  header.push_back(0x54);
+  header.push_back(0x52);
+  header.push_back(0x43);
+  header.push_back(1);
+  header.push_back(0);
+  header.push_back(0);
+  header.push_back(0);
+
+  CallLogEngine replayed;
+  Result r =
+      ReplayEngineTrace(header.data(), header.size(), nullptr, &replayed);
+  ASSERT_FALSE(r.IsSuccess());
+  EXPECT_EQ("engine trace is missing its initialize record", r.Error());
+}
+
+}  // namespace amber
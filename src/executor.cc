@@ -14,139 +14,692 @@
 
 #include "src/executor.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <tuple>
+#include <utility>
 #include <vector>
 
+#include "src/command_optimizer.h"
+#include "src/command_scheduler.h"
 #include "src/engine.h"
 #include "src/script.h"
 #include "src/shader_compiler.h"
 
 namespace amber {
+namespace {
+
+uint64_t NsSince(std::chrono::steady_clock::time_point begin) {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - begin)
+          .count());
+}
+
+}  // namespace
 
 Executor::Executor() = default;
 
-Executor::~Executor() = default;
+Executor::~Executor() {
+  // Execute() always drains the queue; this only matters if it returned
+  // before the command loop ever ran.
+  FinishPendingProbes();
+}
 
-Result Executor::Execute(Engine* engine,
+std::vector<uint8_t> Executor::AcquireBounceBuffer(size_t size) {
+  std::vector<uint8_t> buffer;
+  {
+    std::lock_guard<std::mutex> lock(bounce_mutex_);
+    if (!bounce_buffers_.empty()) {
+      buffer = std::move(bounce_buffers_.back());
+      bounce_buffers_.pop_back();
+    }
+  }
+  buffer.resize(size);
+  return buffer;
+}
+
+void Executor::ReleaseBounceBuffer(std::vector<uint8_t> buffer) {
+  std::lock_guard<std::mutex> lock(bounce_mutex_);
+  bounce_buffers_.push_back(std::move(buffer));
+}
+
+void Executor::QueueProbe(PendingProbe probe) {
+  if (!probe_thread_.joinable())
+    probe_thread_ = std::thread(&Executor::ProbeWorker, this);
+
+  {
+    std::lock_guard<std::mutex> lock(probe_mutex_);
+    probe_queue_.push_back(std::move(probe));
+  }
+  probe_cv_.notify_one();
+}
+
+Result Executor::FinishPendingProbes() {
+  if (!probe_thread_.joinable())
+    return {};
+
+  {
+    std::lock_guard<std::mutex> lock(probe_mutex_);
+    probe_done_ = true;
+  }
+  probe_cv_.notify_one();
+  probe_thread_.join();
+
+  probe_done_ = false;
+  probe_failed_ = false;
+  Result r = probe_failure_;
+  probe_failure_ = Result();
+  return r;
+}
+
+void Executor::ProbeWorker() {
+  for (;;) {
+    PendingProbe probe;
+    {
+      std::unique_lock<std::mutex> lock(probe_mutex_);
+      probe_cv_.wait(
+          lock, [this]() { return probe_done_ || !probe_queue_.empty(); });
+      if (probe_queue_.empty())
+        return;
+      probe = std::move(probe_queue_.front());
+      probe_queue_.pop_front();
+    }
+
+    // The run's result is already known after the first failure; checking
+    // the remaining probes would only overwrite it.
+    if (probe_failed_)
+      continue;
+
+    auto begin = std::chrono::steady_clock::now();
+    verifier_.SetFrameGeneration(probe.frame_generation);
+    Result r = verifier_.Probe(probe.probe, probe.texel_format,
+                               probe.texel_stride, probe.row_stride,
+                               probe.width, probe.height, probe.data.data());
+    verify_ns_ += NsSince(begin);
+    ReleaseBounceBuffer(std::move(probe.data));
+    if (!r.IsSuccess()) {
+      std::lock_guard<std::mutex> lock(probe_mutex_);
+      probe_failure_ = r;
+      probe_failed_ = true;
+    }
+  }
+}
+
+Result Executor::Prepare(Engine* engine,
                          const amber::Script* script,
-                         const ShaderMap& shader_map) {
+                         const ShaderMap& shader_map,
+                         const std::string& shader_cache_dir,
+                         bool optimize_shaders) {
   engine->SetEngineData(script->GetEngineData());
 
-  // Process Shader nodes
-  PipelineType pipeline_type = PipelineType::kGraphics;
-  for (const auto& shader : script->GetShaders()) {
-    ShaderCompiler sc;
+  auto compile_begin = std::chrono::steady_clock::now();
+
+  // Process Shader nodes. The compiles are independent of each other and of
+  // the engine, so they run concurrently; the engine only sees the binaries
+  // once every worker has joined.
+  ShaderCompiler sc(shader_cache_dir, optimize_shaders);
+
+  const auto& shaders = script->GetShaders();
+  std::vector<Result> compile_results(shaders.size());
+  std::vector<std::vector<uint32_t>> compiled(shaders.size());
+
+  std::atomic<size_t> next_idx(0);
+  auto worker = [&sc, &shaders, &shader_map, &compile_results, &compiled,
+                 &next_idx]() {
+    for (;;) {
+      size_t i = next_idx.fetch_add(1);
+      if (i >= shaders.size())
+        break;
+      std::tie(compile_results[i], compiled[i]) =
+          sc.Compile(shaders[i].get(), shader_map);
+    }
+  };
+
+  if (shaders.size() > 1) {
+    size_t thread_count = std::thread::hardware_concurrency();
+    if (thread_count == 0)
+      thread_count = 1;
+    thread_count = std::min(thread_count, shaders.size());
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < thread_count; ++i)
+      threads.emplace_back(worker);
+    for (auto& thread : threads)
+      thread.join();
+  } else {
+    worker();
+  }
 
-    Result r;
-    std::vector<uint32_t> data;
-    std::tie(r, data) = sc.Compile(shader.get(), shader_map);
+  for (size_t i = 0; i < shaders.size(); ++i) {
+    if (!compile_results[i].IsSuccess())
+      return compile_results[i];
+  }
+
+  phase_timings_.compile_ns += NsSince(compile_begin);
+  auto pipeline_begin = std::chrono::steady_clock::now();
+
+  // Scripts which declare pipelines bind their shaders per pipeline below;
+  // otherwise all shaders belong to the single implicit pipeline.
+  if (script->GetPipelines().empty()) {
+    for (size_t i = 0; i < shaders.size(); ++i) {
+      Result r = engine->SetShader(shaders[i]->GetType(), compiled[i]);
+      if (!r.IsSuccess())
+        return r;
+    }
+  }
+
+  // Handle Image and Depth buffers early so they are available when we call
+  // the CreatePipeline method. The script partitioned its buffers when it
+  // was finalized.
+  for (auto* buf : script->GetAttachmentBuffers()) {
+    Result r = engine->SetBuffer(buf);
     if (!r.IsSuccess())
       return r;
+  }
+
+  Result r;
+  if (!script->GetPipelines().empty()) {
+    // Every pipeline declared by the script becomes its own engine
+    // pipeline with its own shaders, descriptor state and command
+    // buffers; the engine spreads them over the device's queues so
+    // independent pipelines can run in parallel.
+    for (const auto& pipeline : script->GetPipelines()) {
+      for (const auto& shader_info : pipeline->GetShaders()) {
+        size_t idx = shaders.size();
+        for (size_t i = 0; i < shaders.size(); ++i) {
+          if (shaders[i].get() == shader_info.GetShader()) {
+            idx = i;
+            break;
+          }
+        }
+        if (idx == shaders.size())
+          return Result("Executor::Execute pipeline uses an unknown shader");
 
-    r = engine->SetShader(shader->GetType(), data);
+        r = engine->SetShader(shader_info.GetShaderType(), compiled[idx]);
+        if (!r.IsSuccess())
+          return r;
+      }
+
+      r = engine->CreatePipeline(pipeline->GetType());
+      if (!r.IsSuccess())
+        return r;
+    }
+  } else {
+    r = engine->CreatePipeline(script->GetImplicitPipelineType());
     if (!r.IsSuccess())
       return r;
+  }
 
-    if (shader->GetType() == kShaderTypeCompute)
-      pipeline_type = PipelineType::kCompute;
+  // Process Buffers. The attachments were handed over before the pipeline
+  // was created.
+  for (auto* buf : script->GetPlainBuffers()) {
+    r = engine->SetBuffer(buf);
+    if (!r.IsSuccess())
+      return r;
   }
 
-  // Handle Image and Depth buffers early so they are available when we call
-  // the CreatePipeline method.
-  for (const auto& buf : script->GetBuffers()) {
-    // Image and depth are handled earlier. They will be moved to the pipeline
-    // object when it exists.
-    if (buf->GetBufferType() != BufferType::kColor &&
-        buf->GetBufferType() != BufferType::kDepth) {
+  phase_timings_.pipeline_ns += NsSince(pipeline_begin);
+  return {};
+}
+
+Result Executor::Execute(Engine* engine,
+                         const amber::Script* script,
+                         const ShaderMap& shader_map,
+                         const std::string& shader_cache_dir,
+                         bool optimize_shaders,
+                         bool optimize_commands) {
+  optimize_commands_ = optimize_commands;
+
+  Result r =
+      Prepare(engine, script, shader_map, shader_cache_dir, optimize_shaders);
+  if (!r.IsSuccess())
+    return r;
+
+  // Process Commands. Framebuffer probes are verified on a worker thread
+  // while the engine keeps going, so even a failed command run must wait
+  // for the queued verifications before this method returns.
+  auto execute_begin = std::chrono::steady_clock::now();
+  r = ExecuteCommands(engine, script);
+  phase_timings_.execute_ns += NsSince(execute_begin);
+  Result probe_result = FinishPendingProbes();
+  if (!r.IsSuccess())
+    return r;
+  return probe_result;
+}
+
+Result Executor::Prewarm(Engine* engine,
+                         const amber::Script* script,
+                         const ShaderMap& shader_map,
+                         const std::string& shader_cache_dir,
+                         bool optimize_shaders) {
+  Result r =
+      Prepare(engine, script, shader_map, shader_cache_dir, optimize_shaders);
+  if (!r.IsSuccess())
+    return r;
+
+  // Replay only the host-side state the pipelines depend on - descriptor
+  // registrations, entry points, patch parameters - and hand each draw
+  // and dispatch to the engine's prewarm hook instead of executing it.
+  for (const auto& entry : script->GetCommandStream()) {
+    Command* cmd = entry.command;
+    switch (entry.type) {
+      case Command::Type::kBuffer: {
+        BufferCommand* buffer_cmd = cmd->AsBuffer();
+        r = buffer_cmd->LoadDataFileIfNeeded();
+        if (r.IsSuccess())
+          r = engine->DoBuffer(buffer_cmd);
+        break;
+      }
+      case Command::Type::kEntryPoint:
+        r = engine->DoEntryPoint(cmd->AsEntryPoint());
+        break;
+      case Command::Type::kPatchParameterVertices:
+        r = engine->DoPatchParameterVertices(cmd->AsPatchParameterVertices());
+        break;
+      case Command::Type::kDrawRect:
+      case Command::Type::kDrawArrays:
+      case Command::Type::kCompute:
+        r = engine->DoPrewarm(cmd);
+        break;
+      default:
+        break;
+    }
+    if (!r.IsSuccess())
+      return r;
+  }
+  return {};
+}
+
+Result Executor::ReExecute(Engine* engine, const Script* script) {
+  Result r = engine->BeginRepeatIteration();
+  if (!r.IsSuccess())
+    return r;
+
+  auto execute_begin = std::chrono::steady_clock::now();
+  r = ExecuteCommands(engine, script);
+  phase_timings_.execute_ns += NsSince(execute_begin);
+  Result end_result = engine->EndRepeatIteration();
+  Result probe_result = FinishPendingProbes();
+  if (!r.IsSuccess())
+    return r;
+  if (!end_result.IsSuccess())
+    return end_result;
+  return probe_result;
+}
+
+PhaseTimings Executor::GetPhaseTimings() const {
+  PhaseTimings timings = phase_timings_;
+  timings.verify_ns = verify_ns_;
+  return timings;
+}
+
+Result Executor::ExecuteUpTo(Engine* engine,
+                             const Script* script,
+                             const ShaderMap& shader_map,
+                             size_t command_count,
+                             ExecutorCheckpoint* checkpoint,
+                             const std::string& shader_cache_dir,
+                             bool optimize_shaders) {
+  Result r =
+      Prepare(engine, script, shader_map, shader_cache_dir, optimize_shaders);
+  if (!r.IsSuccess())
+    return r;
+
+  const auto& stream = script->GetCommandStream();
+  const size_t count = std::min(command_count, stream.size());
+
+  // Plain script order, so the stop point means the same commands on
+  // every run of the bisection.
+  std::vector<size_t> order(count);
+  for (size_t i = 0; i < count; ++i)
+    order[i] = i;
+
+  r = ExecuteOrderedCommands(engine, stream, order);
+  Result probe_result = FinishPendingProbes();
+  if (!r.IsSuccess())
+    return r;
+  if (!probe_result.IsSuccess())
+    return probe_result;
+
+  return CaptureCheckpoint(engine, stream, count, checkpoint);
+}
+
+Result Executor::CaptureCheckpoint(Engine* engine,
+                                   const std::vector<CommandStreamEntry>& stream,
+                                   size_t command_count,
+                                   ExecutorCheckpoint* checkpoint) {
+  checkpoint->resume_index = command_count;
+  checkpoint->buffers.clear();
+
+  // Every descriptor binding the prefix wrote; later bindings have no
+  // engine state yet and need none restored.
+  for (size_t i = 0; i < command_count; ++i) {
+    if (stream[i].type != Command::Type::kBuffer)
       continue;
+    const BufferCommand* cmd = stream[i].command->AsBuffer();
+    if (cmd->IsPushConstant())
+      continue;
+
+    bool seen = false;
+    for (const auto& snapshot : checkpoint->buffers) {
+      if (snapshot.descriptor_set == cmd->GetDescriptorSet() &&
+          snapshot.binding == cmd->GetBinding()) {
+        seen = true;
+        break;
+      }
     }
+    if (seen)
+      continue;
+
+    ExecutorCheckpoint::BufferSnapshot snapshot;
+    snapshot.descriptor_set = cmd->GetDescriptorSet();
+    snapshot.binding = cmd->GetBinding();
+    snapshot.is_ssbo = cmd->IsSSBO();
+    checkpoint->buffers.push_back(std::move(snapshot));
+  }
 
-    Result r = engine->SetBuffer(
-        buf->GetBufferType(), buf->GetLocation(),
-        buf->IsFormatBuffer() ? buf->AsFormatBuffer()->GetFormat() : Format(),
-        buf->GetData());
+  // Mirror the probe flow: announce the readbacks first, submit once,
+  // then copy each buffer's bytes out of the host visible memory.
+  std::vector<ResourceInfo> infos(checkpoint->buffers.size());
+  for (size_t i = 0; i < checkpoint->buffers.size(); ++i) {
+    Result r = engine->GetDescriptorInfo(checkpoint->buffers[i].descriptor_set,
+                                         checkpoint->buffers[i].binding,
+                                         &infos[i]);
     if (!r.IsSuccess())
       return r;
   }
 
-  // TODO(jaebaek): Support multiple pipelines.
-  Result r = engine->CreatePipeline(pipeline_type);
+  Result r = engine->DoProcessCommands();
   if (!r.IsSuccess())
     return r;
 
-  // Process Buffers
-  for (const auto& buf : script->GetBuffers()) {
-    // Image and depth are handled earlier. They will be moved to the pipeline
-    // object when it exists.
-    if (buf->GetBufferType() == BufferType::kColor ||
-        buf->GetBufferType() == BufferType::kDepth) {
+  for (size_t i = 0; i < checkpoint->buffers.size(); ++i) {
+    if (infos[i].cpu_memory == nullptr || infos[i].size_in_bytes == 0)
       continue;
+    const uint8_t* data = static_cast<const uint8_t*>(infos[i].cpu_memory);
+    checkpoint->buffers[i].data.assign(data, data + infos[i].size_in_bytes);
+  }
+  return {};
+}
+
+Result Executor::RestoreAndContinue(Engine* engine,
+                                    const Script* script,
+                                    const ExecutorCheckpoint& checkpoint) {
+  const auto& stream = script->GetCommandStream();
+  if (checkpoint.resume_index > stream.size())
+    return Result("Executor: checkpoint does not belong to this script");
+
+  // Replay the host side pipeline state the prefix established; these
+  // touch no device memory, so the replay cost does not scale with the
+  // prefix's draws and dispatches.
+  Result r;
+  for (size_t i = 0; i < checkpoint.resume_index; ++i) {
+    Command* cmd = stream[i].command;
+    switch (stream[i].type) {
+      case Command::Type::kClearColor:
+        r = engine->DoClearColor(cmd->AsClearColor());
+        break;
+      case Command::Type::kClearDepth:
+        r = engine->DoClearDepth(cmd->AsClearDepth());
+        break;
+      case Command::Type::kClearStencil:
+        r = engine->DoClearStencil(cmd->AsClearStencil());
+        break;
+      case Command::Type::kEntryPoint:
+        r = engine->DoEntryPoint(cmd->AsEntryPoint());
+        break;
+      case Command::Type::kPatchParameterVertices:
+        r = engine->DoPatchParameterVertices(cmd->AsPatchParameterVertices());
+        break;
+      case Command::Type::kBuffer: {
+        BufferCommand* buffer_cmd = cmd->AsBuffer();
+        if (!buffer_cmd->IsPushConstant())
+          break;
+        r = buffer_cmd->LoadDataFileIfNeeded();
+        if (r.IsSuccess())
+          r = engine->DoBuffer(buffer_cmd);
+        break;
+      }
+      default:
+        break;
     }
+    if (!r.IsSuccess())
+      return r;
+  }
 
-    r = engine->SetBuffer(
-        buf->GetBufferType(), buf->GetLocation(),
-        buf->IsFormatBuffer() ? buf->AsFormatBuffer()->GetFormat() : Format(),
-        buf->GetData());
+  // Re-upload the snapshotted buffer contents. The synthesized commands
+  // hand the engine a view of the checkpoint's bytes, which outlive the
+  // upload: the engine consumes its input queue within this call.
+  for (const auto& snapshot : checkpoint.buffers) {
+    if (snapshot.data.empty())
+      continue;
+    BufferCommand restore(snapshot.is_ssbo
+                              ? BufferCommand::BufferType::kSSBO
+                              : BufferCommand::BufferType::kUniform);
+    restore.SetDescriptorSet(snapshot.descriptor_set);
+    restore.SetBinding(snapshot.binding);
+    restore.SetOffset(0);
+    restore.SetRawBytes(snapshot.data.data(),
+                        static_cast<uint32_t>(snapshot.data.size()));
+    r = engine->DoBuffer(&restore);
     if (!r.IsSuccess())
       return r;
   }
 
-  // Process Commands
-  for (const auto& cmd : script->GetCommands()) {
-    if (cmd->IsProbe()) {
-      ResourceInfo info;
+  // Run the suffix in script order, matching ExecuteUpTo().
+  std::vector<size_t> order(stream.size() - checkpoint.resume_index);
+  for (size_t i = 0; i < order.size(); ++i)
+    order[i] = checkpoint.resume_index + i;
 
-      r = engine->DoProcessCommands();
-      if (!r.IsSuccess())
-        return r;
+  r = ExecuteOrderedCommands(engine, stream, order);
+  Result probe_result = FinishPendingProbes();
+  if (!r.IsSuccess())
+    return r;
+  return probe_result;
+}
 
-      // This must come after processing commands because we require
-      // the frambuffer buffer to be mapped into host memory and have
-      // a valid host-side pointer.
-      r = engine->GetFrameBufferInfo(&info);
-      if (!r.IsSuccess())
-        return r;
-      assert(info.cpu_memory != nullptr);
-
-      r = verifier_.Probe(cmd->AsProbe(), info.image_info.texel_format,
-                          info.image_info.texel_stride,
-                          info.image_info.row_stride, info.image_info.width,
-                          info.image_info.height, info.cpu_memory);
-    } else if (cmd->IsProbeSSBO()) {
-      auto probe_ssbo = cmd->AsProbeSSBO();
-      ResourceInfo info;
-      r = engine->GetDescriptorInfo(probe_ssbo->GetDescriptorSet(),
-                                    probe_ssbo->GetBinding(), &info);
-      if (!r.IsSuccess())
-        return r;
+Result Executor::ExecuteCommands(Engine* engine, const Script* script) {
+  // The flat stream keeps the dispatch tags in one contiguous array so
+  // the command loop does not chase a pointer per command just to find
+  // out what kind it is.
+  const auto& script_stream = script->GetCommandStream();
 
-      r = engine->DoProcessCommands();
-      if (!r.IsSuccess())
-        return r;
+  // Drop commands whose effect the rest of the stream provably
+  // overwrites before anything observes it; fuzzer derived scripts are
+  // dense with such sequences. See CommandOptimizer.
+  const std::vector<CommandStreamEntry> stream =
+      optimize_commands_ ? CommandOptimizer::Optimize(script_stream)
+                         : script_stream;
+
+  // Issue independent chains ahead of flush-forcing probes: their device
+  // work then joins the submission the probe waits on instead of
+  // starting after its fence wait. Dependent commands keep script order;
+  // see CommandScheduler.
+  const std::vector<size_t> order = CommandScheduler::ScheduleOrder(stream);
+
+  return ExecuteOrderedCommands(engine, stream, order);
+}
+
+Result Executor::ExecuteOrderedCommands(
+    Engine* engine,
+    const std::vector<CommandStreamEntry>& stream,
+    const std::vector<size_t>& order) {
+  Result r;
+
+  for (size_t oi = 0; oi < order.size(); ++oi) {
+    // A probe already failed on the verification thread; submitting more
+    // work would only burn time after the run's result is known.
+    if (probe_failed_)
+      break;
+
+    const size_t i = order[oi];
+    Command* cmd = stream[i].command;
+    switch (stream[i].type) {
+      case Command::Type::kProbe: {
+        ResourceInfo info;
+
+        r = cmd->AsProbe()->LoadReferenceImageIfNeeded();
+        if (!r.IsSuccess())
+          return r;
+
+        r = engine->DoProcessCommands();
+        if (!r.IsSuccess())
+          return r;
+
+        // This must come after processing commands because we require
+        // the frambuffer buffer to be mapped into host memory and have
+        // a valid host-side pointer. The probe command is passed down so
+        // the engine only needs to copy the region being checked.
+        r = engine->GetFrameBufferInfo(cmd->AsProbe(), &info);
+        if (!r.IsSuccess())
+          return r;
+        assert(info.cpu_memory != nullptr);
+
+        // Snapshot the probed bytes and let the verification thread
+        // compare them; the engine starts on the next commands while the
+        // CPU is still checking pixels.
+        PendingProbe probe;
+        probe.probe = cmd->AsProbe();
+        probe.texel_format = info.image_info.texel_format;
+        probe.texel_stride = info.image_info.texel_stride;
+        probe.row_stride = info.image_info.row_stride;
+        probe.width = info.image_info.width;
+        probe.height = info.image_info.height;
+        probe.frame_generation = frame_generation_;
+        probe.data = AcquireBounceBuffer(info.size_in_bytes);
+        memcpy(probe.data.data(), info.cpu_memory, info.size_in_bytes);
+        QueueProbe(std::move(probe));
+        break;
+      }
+      case Command::Type::kProbeSSBO: {
+        auto probe_ssbo = cmd->AsProbeSSBO();
+
+        // Engines backing descriptors with device local memory can run
+        // the comparison on the device and hand back just a verdict,
+        // sparing the full readback below. |verified| stays false when
+        // the engine has no such path.
+        bool verified = false;
+        r = engine->DoVerifyProbeSSBOOnDevice(probe_ssbo, &verified);
+        if (!r.IsSuccess())
+          return r;
+        if (verified)
+          break;
+
+        // Announce how little of the buffer the probe is going to read,
+        // so the engine can keep the rest of the data on the device
+        // instead of copying the whole resource to the host.
+        const auto& datum_type = probe_ssbo->GetDatumType();
+        uint64_t bytes_per_elem = datum_type.SizeInBytes() /
+                                  datum_type.RowCount() /
+                                  datum_type.ColumnCount();
+        uint64_t window_size =
+            probe_ssbo->IsChecksum()
+                ? probe_ssbo->GetChecksumSizeInBytes()
+                : probe_ssbo->GetValues().size() * bytes_per_elem;
+        r = engine->SetDescriptorReadbackWindow(
+            probe_ssbo->GetDescriptorSet(), probe_ssbo->GetBinding(),
+            probe_ssbo->GetOffset(), window_size);
+        if (!r.IsSuccess())
+          return r;
+
+        ResourceInfo info;
+        r = engine->GetDescriptorInfo(probe_ssbo->GetDescriptorSet(),
+                                      probe_ssbo->GetBinding(), &info);
+        if (!r.IsSuccess())
+          return r;
+
+        r = engine->DoProcessCommands();
+        if (!r.IsSuccess())
+          return r;
+
+        // Verify against a bounce copy of the readback window: one
+        // streaming memcpy out of the possibly write-combined mapping
+        // instead of the verifier's scattered reads from it. A null
+        // pointer stays as is so the verifier reports it.
+        const void* probe_memory = info.cpu_memory;
+        std::vector<uint8_t> bounce;
+        if (probe_memory != nullptr && info.size_in_bytes > 0) {
+          bounce = AcquireBounceBuffer(info.size_in_bytes);
+          memcpy(bounce.data(), probe_memory, info.size_in_bytes);
+          probe_memory = bounce.data();
+        }
 
-      r = verifier_.ProbeSSBO(probe_ssbo, info.size_in_bytes, info.cpu_memory);
-    } else if (cmd->IsClear()) {
-      r = engine->DoClear(cmd->AsClear());
-    } else if (cmd->IsClearColor()) {
-      r = engine->DoClearColor(cmd->AsClearColor());
-    } else if (cmd->IsClearDepth()) {
-      r = engine->DoClearDepth(cmd->AsClearDepth());
-    } else if (cmd->IsClearStencil()) {
-      r = engine->DoClearStencil(cmd->AsClearStencil());
-    } else if (cmd->IsDrawRect()) {
-      r = engine->DoDrawRect(cmd->AsDrawRect());
-    } else if (cmd->IsDrawArrays()) {
-      r = engine->DoDrawArrays(cmd->AsDrawArrays());
-    } else if (cmd->IsCompute()) {
-      r = engine->DoCompute(cmd->AsCompute());
-    } else if (cmd->IsEntryPoint()) {
-      r = engine->DoEntryPoint(cmd->AsEntryPoint());
-    } else if (cmd->IsPatchParameterVertices()) {
-      r = engine->DoPatchParameterVertices(cmd->AsPatchParameterVertices());
-    } else if (cmd->IsBuffer()) {
-      r = engine->DoBuffer(cmd->AsBuffer());
-    } else {
-      return Result("Unknown command type");
+        // The verifier varies its sampled-verification subset by frame
+        // generation; an unchanged generation is a no-op.
+        auto verify_begin = std::chrono::steady_clock::now();
+        verifier_.SetFrameGeneration(frame_generation_);
+        r = verifier_.ProbeSSBO(probe_ssbo, info.size_in_bytes, probe_memory);
+        verify_ns_ += NsSince(verify_begin);
+        if (!bounce.empty())
+          ReleaseBounceBuffer(std::move(bounce));
+        break;
+      }
+      case Command::Type::kClear:
+        ++frame_generation_;
+        r = engine->DoClear(cmd->AsClear());
+        break;
+      case Command::Type::kClearColor:
+        r = engine->DoClearColor(cmd->AsClearColor());
+        break;
+      case Command::Type::kClearDepth:
+        r = engine->DoClearDepth(cmd->AsClearDepth());
+        break;
+      case Command::Type::kClearStencil:
+        r = engine->DoClearStencil(cmd->AsClearStencil());
+        break;
+      case Command::Type::kDrawRect:
+        ++frame_generation_;
+        r = engine->DoDrawRect(cmd->AsDrawRect());
+        break;
+      case Command::Type::kDrawArrays: {
+        // Consecutive draws go to the engine as one run so it can record
+        // them faster than one call at a time; fuzzer generated scripts
+        // contain runs of 100k+ draws. Draws all write the framebuffer,
+        // so the scheduler keeps them in script order and adjacency in
+        // the issue order is enough.
+        size_t run_end = oi + 1;
+        while (run_end < order.size() &&
+               stream[order[run_end]].type == Command::Type::kDrawArrays) {
+          ++run_end;
+        }
+        frame_generation_ += run_end - oi;
+        if (run_end - oi > 1) {
+          std::vector<const DrawArraysCommand*> batch;
+          batch.reserve(run_end - oi);
+          for (size_t j = oi; j < run_end; ++j)
+            batch.push_back(stream[order[j]].command->AsDrawArrays());
+          r = engine->DoDrawArraysBatch(batch);
+          oi = run_end - 1;
+        } else {
+          r = engine->DoDrawArrays(cmd->AsDrawArrays());
+        }
+        break;
+      }
+      case Command::Type::kCompute:
+        ++frame_generation_;
+        r = engine->DoCompute(cmd->AsCompute());
+        break;
+      case Command::Type::kEntryPoint:
+        ++frame_generation_;
+        r = engine->DoEntryPoint(cmd->AsEntryPoint());
+        break;
+      case Command::Type::kPatchParameterVertices:
+        r = engine->DoPatchParameterVertices(cmd->AsPatchParameterVertices());
+        break;
+      case Command::Type::kBuffer: {
+        BufferCommand* buffer_cmd = cmd->AsBuffer();
+        r = buffer_cmd->LoadDataFileIfNeeded();
+        if (r.IsSuccess())
+          r = engine->DoBuffer(buffer_cmd);
+        break;
+      }
+      default:
+        return Result("Unknown command type");
     }
 
     if (!r.IsSuccess())
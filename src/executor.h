@@ -15,13 +15,43 @@
 #ifndef SRC_EXECUTOR_H_
 #define SRC_EXECUTOR_H_
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "amber/result.h"
+#include "src/command.h"
 #include "src/engine.h"
 #include "src/script.h"
 #include "src/verifier.h"
 
 namespace amber {
 
+/// Engine visible state captured after a prefix of a script's command
+/// stream executed, used to bisect a failure without re-running the
+/// prefix on every probe. Captured by Executor::ExecuteUpTo() and fed
+/// back by Executor::RestoreAndContinue(); only meaningful for the
+/// script and engine it was captured from.
+struct ExecutorCheckpoint {
+  /// Contents of one descriptor backed buffer, read back through the
+  /// engine's readback path.
+  struct BufferSnapshot {
+    uint32_t descriptor_set = 0;
+    uint32_t binding = 0;
+    bool is_ssbo = true;
+    std::vector<uint8_t> data;
+  };
+
+  /// Index into the command stream of the first command that did not
+  /// execute.
+  size_t resume_index = 0;
+  std::vector<BufferSnapshot> buffers;
+};
+
 /// The executor is responsible for running the given script against an engine.
 class Executor {
  public:
@@ -31,11 +61,180 @@ class Executor {
 
   /// Executes |script| against |engine|. For each shader described in |script|
   /// if the shader name exists in |map| the value for that map'd key will be
-  /// used as the shader binary.
-  Result Execute(Engine* engine, const Script* script, const ShaderMap& map);
+  /// used as the shader binary. A non-empty |shader_cache_dir| is used as an
+  /// on-disk cache of compiled shader binaries. |optimize_shaders| runs
+  /// compiled binaries through spirv-opt before the engine sees them.
+  /// |optimize_commands| runs dead command elimination over the command
+  /// stream before it executes; see CommandOptimizer.
+  Result Execute(Engine* engine,
+                 const Script* script,
+                 const ShaderMap& map,
+                 const std::string& shader_cache_dir = std::string(),
+                 bool optimize_shaders = false,
+                 bool optimize_commands = true);
+
+  /// Runs the command stream of a |script| prepared by an earlier
+  /// Execute() call against the same |engine| again, skipping shader
+  /// compilation, buffer upload and pipeline creation. Used for
+  /// repeated timing runs of the same script.
+  Result ReExecute(Engine* engine, const Script* script);
+
+  /// Like Execute() but stops after the first |command_count| commands
+  /// and snapshots the contents of every descriptor buffer the prefix
+  /// touched into |checkpoint|. The stream runs in plain script order -
+  /// no scheduling or dead command elimination - so a command index
+  /// means the same work on every run. Bisecting a failure around
+  /// command k then pays the k command prefix once; each probe of the
+  /// suffix goes through RestoreAndContinue() instead.
+  Result ExecuteUpTo(Engine* engine,
+                     const Script* script,
+                     const ShaderMap& map,
+                     size_t command_count,
+                     ExecutorCheckpoint* checkpoint,
+                     const std::string& shader_cache_dir = std::string(),
+                     bool optimize_shaders = false);
+
+  /// Re-uploads |checkpoint|'s buffer contents into |engine| - which
+  /// must have run ExecuteUpTo() for the same |script| - replays the
+  /// host side pipeline state commands of the prefix (clear values,
+  /// entry points, patch parameters, push constants; all cheap), and
+  /// executes the stream from the checkpoint to the end in script
+  /// order. May be called repeatedly on the same checkpoint. The
+  /// framebuffer is not part of the snapshot, so a checkpoint between a
+  /// draw and a probe of that draw's output does not replay faithfully;
+  /// checkpoint at a frame boundary (after a probe or before a clear).
+  Result RestoreAndContinue(Engine* engine,
+                            const Script* script,
+                            const ExecutorCheckpoint& checkpoint);
+
+  /// Performs the setup portion of Execute() - shader compilation, buffer
+  /// hand-over and engine pipeline creation - and then asks the engine to
+  /// create the pipeline state objects the script's draws and dispatches
+  /// will need, without submitting any GPU work. The driver compilation
+  /// this triggers lands in the device's pipeline cache, so a later
+  /// Execute() of the script - possibly from another engine sharing the
+  /// device - finds its pipelines ready made.
+  Result Prewarm(Engine* engine,
+                 const Script* script,
+                 const ShaderMap& map,
+                 const std::string& shader_cache_dir = std::string(),
+                 bool optimize_shaders = false);
+
+  /// CPU time spent in each phase of the executions so far; see
+  /// PhaseTimings. Verification time covers the verification thread's
+  /// probes as well as the inline SSBO probes.
+  PhaseTimings GetPhaseTimings() const;
 
  private:
+  /// A framebuffer probe waiting to be checked on the verification
+  /// thread. The probed bytes are snapshotted into |data| so the engine
+  /// can render the next commands into the framebuffer meanwhile;
+  /// |data| comes from the bounce buffer pool and the verification
+  /// thread returns it there once the probe was checked.
+  struct PendingProbe {
+    const ProbeCommand* probe = nullptr;
+    /// Points at the engine owned framebuffer format, which is stable for
+    /// the whole execution.
+    const Format* texel_format = nullptr;
+    uint32_t texel_stride = 0;
+    uint32_t row_stride = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    /// Generation of the framebuffer the probe reads; probes of the same
+    /// generation share the verifier's decoded texel cache.
+    uint64_t frame_generation = 0;
+    std::vector<uint8_t> data;
+  };
+
+  /// Compiles the shaders of |script|, hands its buffers to |engine| and
+  /// creates the engine pipelines: everything Execute() does before the
+  /// command loop runs.
+  Result Prepare(Engine* engine,
+                 const Script* script,
+                 const ShaderMap& map,
+                 const std::string& shader_cache_dir,
+                 bool optimize_shaders);
+
+  /// Runs the command stream of |script| against |engine|. Framebuffer
+  /// probes are handed to the verification thread instead of being
+  /// checked inline, so the engine is already submitting the next batch
+  /// of commands while the CPU compares one readback.
+  Result ExecuteCommands(Engine* engine, const Script* script);
+
+  /// Issues |stream|'s commands against |engine| in the order |order|
+  /// lists them: the body of ExecuteCommands(), shared with the
+  /// checkpoint paths, which issue sub-ranges in plain script order.
+  Result ExecuteOrderedCommands(Engine* engine,
+                                const std::vector<CommandStreamEntry>& stream,
+                                const std::vector<size_t>& order);
+
+  /// Reads back every descriptor buffer commands [0, |command_count|)
+  /// of |stream| touched and stores the contents into |checkpoint|.
+  Result CaptureCheckpoint(Engine* engine,
+                           const std::vector<CommandStreamEntry>& stream,
+                           size_t command_count,
+                           ExecutorCheckpoint* checkpoint);
+
+  /// Returns a buffer of |size| bytes from the bounce buffer pool,
+  /// growing the pool when it is empty. Readback memory handed out by
+  /// the engine is typically mapped write-combined device memory, where
+  /// the verifier's scattered reads are an order of magnitude slower
+  /// than from ordinary RAM; probed bytes are copied into a pooled
+  /// buffer with one streaming memcpy and every verification loop runs
+  /// against the cacheable copy.
+  std::vector<uint8_t> AcquireBounceBuffer(size_t size);
+
+  /// Returns |buffer| to the pool once verification is done with it;
+  /// its allocation is kept for the next probe.
+  void ReleaseBounceBuffer(std::vector<uint8_t> buffer);
+
+  /// Hands |probe| to the verification thread, starting the thread on
+  /// its first use.
+  void QueueProbe(PendingProbe probe);
+
+  /// Waits until every queued probe was verified, stops the verification
+  /// thread and returns the first probe failure, if any.
+  Result FinishPendingProbes();
+
+  /// Body of the verification thread.
+  void ProbeWorker();
+
   Verifier verifier_;
+
+  /// Phase durations accumulated across executions. Verification time
+  /// lives in |verify_ns_| because the verification thread adds to it
+  /// concurrently with the command loop.
+  PhaseTimings phase_timings_;
+  std::atomic<uint64_t> verify_ns_{0};
+
+  /// Bumped by every command that may change the framebuffer, so probes
+  /// of an unchanged frame are recognizable as such. Never reset, so
+  /// repeated runs of the same script do not collide.
+  uint64_t frame_generation_ = 0;
+
+  /// Whether ExecuteCommands() runs dead command elimination over the
+  /// stream first. Set by Execute() so ReExecute() repeats the same
+  /// stream the measured first run executed.
+  bool optimize_commands_ = true;
+
+  std::thread probe_thread_;
+  std::mutex probe_mutex_;
+  std::condition_variable probe_cv_;
+  std::deque<PendingProbe> probe_queue_;
+  /// Asks the verification thread to exit once |probe_queue_| drains.
+  /// Guarded by |probe_mutex_|.
+  bool probe_done_ = false;
+  /// First probe failure seen by the verification thread. Guarded by
+  /// |probe_mutex_|; |probe_failed_| gives the command loop a lock free
+  /// peek so it can stop submitting work early.
+  Result probe_failure_;
+  std::atomic<bool> probe_failed_{false};
+
+  /// Retired bounce buffers waiting for reuse; see AcquireBounceBuffer().
+  /// The verification thread releases buffers concurrently with the
+  /// command loop acquiring them, hence the lock.
+  std::mutex bounce_mutex_;
+  std::vector<std::vector<uint8_t>> bounce_buffers_;
 };
 
 }  // namespace amber
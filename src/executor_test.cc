@@ -49,7 +49,11 @@ class EngineStub : public Engine {
   FormatType GetDepthFrameFormat() const { return depth_frame_format_; }
   uint32_t GetFenceTimeoutMs() { return GetEngineData().fence_timeout_ms; }
 
-  Result CreatePipeline(PipelineType) override { return {}; }
+  uint32_t GetPipelineCount() const { return pipeline_count_; }
+  Result CreatePipeline(PipelineType) override {
+    ++pipeline_count_;
+    return {};
+  }
 
   void FailShaderCommand() { fail_shader_command_ = true; }
   const std::vector<ShaderType>& GetShaderTypesSeen() const {
@@ -70,10 +74,11 @@ class EngineStub : public Engine {
   const std::vector<Value>& GetBufferValues(size_t idx) const {
     return buffer_values_[idx];
   }
-  Result SetBuffer(BufferType type,
-                   uint8_t location,
-                   const Format& format,
-                   const std::vector<Value>& data) override {
+  Result SetBuffer(Buffer* buffer) override {
+    BufferType type = buffer->GetBufferType();
+    Format format = buffer->IsFormatBuffer()
+                        ? buffer->AsFormatBuffer()->GetFormat()
+                        : Format();
     if (type == BufferType::kColor || type == BufferType::kDepth) {
       if (type == BufferType::kColor)
         color_frame_format_ = format.GetFormatType();
@@ -84,9 +89,9 @@ class EngineStub : public Engine {
 
     ++buffer_call_count_;
     buffer_types_.push_back(type);
-    buffer_locations_.push_back(location);
+    buffer_locations_.push_back(buffer->GetLocation());
     buffer_formats_.push_back(format);
-    buffer_values_.push_back(data);
+    buffer_values_.push_back(buffer->GetData());
     return {};
   }
 
@@ -188,20 +193,37 @@ class EngineStub : public Engine {
 
   void FailBufferCommand() { fail_buffer_command_ = true; }
   bool DidBufferCommand() const { return did_buffer_command_; }
-  Result DoBuffer(const BufferCommand*) override {
+  const std::vector<uint8_t>& GetLastRawBufferData() const {
+    return last_raw_buffer_data_;
+  }
+  Result DoBuffer(const BufferCommand* cmd) override {
     did_buffer_command_ = true;
 
     if (fail_buffer_command_)
       return Result("buffer command failed");
+
+    if (cmd->HasRawBytes()) {
+      last_raw_buffer_data_.assign(cmd->GetRawBytes(),
+                                   cmd->GetRawBytes() + cmd->GetSize());
+    }
     return {};
   }
 
   Result DoProcessCommands() override { return {}; }
-  Result GetFrameBufferInfo(ResourceInfo*) override { return {}; }
+  Result GetFrameBufferInfo(const ProbeCommand*, ResourceInfo*) override {
+    return {};
+  }
   Result GetFrameBuffer(std::vector<Value>*) override { return {}; }
+  Result GetFrameBufferData(void*, size_t) override { return {}; }
+  void SetDescriptorData(std::vector<uint8_t> data) {
+    descriptor_data_ = std::move(data);
+  }
   Result GetDescriptorInfo(const uint32_t,
                            const uint32_t,
-                           ResourceInfo*) override {
+                           ResourceInfo* info) override {
+    info->size_in_bytes = descriptor_data_.size();
+    info->cpu_memory = descriptor_data_.empty() ? nullptr
+                                                : descriptor_data_.data();
     return {};
   }
 
@@ -229,12 +251,16 @@ class EngineStub : public Engine {
   bool did_patch_command_ = false;
   bool did_buffer_command_ = false;
 
+  std::vector<uint8_t> descriptor_data_;
+  std::vector<uint8_t> last_raw_buffer_data_;
+
   uint8_t buffer_call_count_ = 0;
   std::vector<uint8_t> buffer_locations_;
   std::vector<BufferType> buffer_types_;
   std::vector<Format> buffer_formats_;
   std::vector<std::vector<Value>> buffer_values_;
 
+  uint32_t pipeline_count_ = 0;
   std::vector<ShaderType> shaders_seen_;
   FormatType color_frame_format_ = FormatType::kUnknown;
   FormatType depth_frame_format_ = FormatType::kUnknown;
@@ -984,5 +1010,85 @@ TEST_F(VkScriptExecutorTest, IndexBuffer) {
   }
 }
 
+TEST_F(VkScriptExecutorTest, ReExecuteSkipsSetup) {
+  std::string input = R"(
+[test]
+clear)";
+
+  Parser parser;
+  ASSERT_TRUE(parser.Parse(input).IsSuccess());
+
+  auto engine = MakeEngine();
+  auto script = parser.GetScript();
+
+  Executor ex;
+  Result r = ex.Execute(engine.get(), script.get(), ShaderMap());
+  ASSERT_TRUE(r.IsSuccess());
+  EXPECT_EQ(1U, ToStub(engine.get())->GetPipelineCount());
+  EXPECT_TRUE(ToStub(engine.get())->DidClearCommand());
+
+  // Re-execution replays the command stream without creating new
+  // pipelines.
+  r = ex.ReExecute(engine.get(), script.get());
+  ASSERT_TRUE(r.IsSuccess());
+  EXPECT_EQ(1U, ToStub(engine.get())->GetPipelineCount());
+}
+
+TEST_F(VkScriptExecutorTest, CheckpointCapturesBufferContents) {
+  std::string input = R"(
+[test]
+ssbo 0 24
+compute 1 1 1
+compute 2 2 2)";
+
+  Parser parser;
+  ASSERT_TRUE(parser.Parse(input).IsSuccess());
+
+  auto engine = MakeEngine();
+  ToStub(engine.get())->SetDescriptorData({1, 2, 3, 4});
+  auto script = parser.GetScript();
+
+  Executor ex;
+  ExecutorCheckpoint checkpoint;
+  Result r = ex.ExecuteUpTo(engine.get(), script.get(), ShaderMap(), 2,
+                            &checkpoint);
+  ASSERT_TRUE(r.IsSuccess());
+  EXPECT_EQ(2U, checkpoint.resume_index);
+  ASSERT_EQ(1U, checkpoint.buffers.size());
+  EXPECT_EQ(0U, checkpoint.buffers[0].descriptor_set);
+  EXPECT_EQ(0U, checkpoint.buffers[0].binding);
+  EXPECT_EQ(std::vector<uint8_t>({1, 2, 3, 4}), checkpoint.buffers[0].data);
+}
+
+TEST_F(VkScriptExecutorTest, RestoreUploadsSnapshotAndRunsSuffix) {
+  std::string input = R"(
+[test]
+ssbo 0 24
+compute 1 1 1
+clear)";
+
+  Parser parser;
+  ASSERT_TRUE(parser.Parse(input).IsSuccess());
+
+  auto engine = MakeEngine();
+  ToStub(engine.get())->SetDescriptorData({9, 8, 7, 6});
+  auto script = parser.GetScript();
+
+  Executor ex;
+  ExecutorCheckpoint checkpoint;
+  Result r = ex.ExecuteUpTo(engine.get(), script.get(), ShaderMap(), 2,
+                            &checkpoint);
+  ASSERT_TRUE(r.IsSuccess());
+  EXPECT_FALSE(ToStub(engine.get())->DidClearCommand());
+
+  // The resume re-uploads the snapshotted bytes and executes only the
+  // commands after the checkpoint.
+  r = ex.RestoreAndContinue(engine.get(), script.get(), checkpoint);
+  ASSERT_TRUE(r.IsSuccess());
+  EXPECT_EQ(std::vector<uint8_t>({9, 8, 7, 6}),
+            ToStub(engine.get())->GetLastRawBufferData());
+  EXPECT_TRUE(ToStub(engine.get())->DidClearCommand());
+}
+
 }  // namespace vkscript
 }  // namespace amber
@@ -33,6 +33,13 @@ class Format {
     FormatComponentType type;
     FormatMode mode;
     uint8_t num_bits;
+    /// Offset of this component from the start of the texel, filled in
+    /// by AddComponent() so consumers do not re-sum the widths of the
+    /// preceding components per texel.
+    uint16_t bit_offset = 0;
+    /// Byte offset of this component; only meaningful when the format
+    /// IsByteAligned().
+    uint8_t byte_offset = 0;
   };
 
   Format();
@@ -52,24 +59,34 @@ class Format {
   uint8_t GetPackSize() const { return pack_size_in_bytes_; }
 
   void AddComponent(FormatComponentType type, FormatMode mode, uint8_t bits) {
-    components_.emplace_back(type, mode, bits);
+    Component component(type, mode, bits);
+    component.bit_offset = total_num_bits_;
+    component.byte_offset = static_cast<uint8_t>(total_num_bits_ / 8);
+    components_.push_back(component);
+
+    total_num_bits_ = static_cast<uint16_t>(total_num_bits_ + bits);
+    if (bits % 8 != 0)
+      is_byte_aligned_ = false;
   }
   const std::vector<Component>& GetComponents() const { return components_; }
 
+  /// Number of bytes one texel of this format occupies. Kept up to date
+  /// by AddComponent(), so this is a plain read in per texel loops.
   uint32_t GetByteSize() const {
     if (pack_size_in_bytes_)
       return pack_size_in_bytes_;
-
-    uint32_t bits = 0;
-    for (uint32_t j = 0; j < components_.size(); ++j) {
-      bits += components_[j].num_bits;
-    }
-    return bits / 8;
+    return total_num_bits_ / 8;
   }
 
+  /// True when every component of this format starts and ends on a byte
+  /// boundary.
+  bool IsByteAligned() const { return is_byte_aligned_; }
+
  private:
   FormatType type_;
   uint8_t pack_size_in_bytes_ = 0;
+  uint16_t total_num_bits_ = 0;
+  bool is_byte_aligned_ = true;
   std::vector<Component> components_;
 };
 
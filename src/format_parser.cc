@@ -14,8 +14,13 @@
 
 #include "src/format_parser.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
 
 #include "src/make_unique.h"
 
@@ -25,7 +30,34 @@ FormatParser::FormatParser() = default;
 
 FormatParser::~FormatParser() = default;
 
-std::unique_ptr<Format> FormatParser::Parse(const std::string& data) {
+std::shared_ptr<const Format> FormatParser::Parse(const std::string& data) {
+  // Formats are immutable once built, so every parse of the same name
+  // can hand out one shared object. Scripts may be parsed concurrently;
+  // the lock only guards the cache map, not the parse itself.
+  static std::mutex cache_mutex;
+  static std::unordered_map<std::string, std::shared_ptr<const Format>> cache;
+
+  {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    auto it = cache.find(data);
+    if (it != cache.end())
+      return it->second;
+  }
+
+  std::shared_ptr<const Format> fmt = BuildFormat(data);
+  if (!fmt)
+    return nullptr;
+
+  // Two threads may both miss and build; the first insert wins so every
+  // caller still sees the same object.
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  auto& entry = cache[data];
+  if (!entry)
+    entry = std::move(fmt);
+  return entry;
+}
+
+std::unique_ptr<Format> FormatParser::BuildFormat(const std::string& data) {
   if (data.empty())
     return nullptr;
 
@@ -157,264 +189,152 @@ void FormatParser::ProcessChunk(Format* fmt, const std::string& data) {
 }
 
 FormatType FormatParser::NameToType(const std::string& data) {
-  if (data == "A1R5G5B5_UNORM_PACK16")
-    return FormatType::kA1R5G5B5_UNORM_PACK16;
-  if (data == "A2B10G10R10_SINT_PACK32")
-    return FormatType::kA2B10G10R10_SINT_PACK32;
-  if (data == "A2B10G10R10_SNORM_PACK32")
-    return FormatType::kA2B10G10R10_SNORM_PACK32;
-  if (data == "A2B10G10R10_SSCALED_PACK32")
-    return FormatType::kA2B10G10R10_SSCALED_PACK32;
-  if (data == "A2B10G10R10_UINT_PACK32")
-    return FormatType::kA2B10G10R10_UINT_PACK32;
-  if (data == "A2B10G10R10_UNORM_PACK32")
-    return FormatType::kA2B10G10R10_UNORM_PACK32;
-  if (data == "A2B10G10R10_USCALED_PACK32")
-    return FormatType::kA2B10G10R10_USCALED_PACK32;
-  if (data == "A2R10G10B10_SINT_PACK32")
-    return FormatType::kA2R10G10B10_SINT_PACK32;
-  if (data == "A2R10G10B10_SNORM_PACK32")
-    return FormatType::kA2R10G10B10_SNORM_PACK32;
-  if (data == "A2R10G10B10_SSCALED_PACK32")
-    return FormatType::kA2R10G10B10_SSCALED_PACK32;
-  if (data == "A2R10G10B10_UINT_PACK32")
-    return FormatType::kA2R10G10B10_UINT_PACK32;
-  if (data == "A2R10G10B10_UNORM_PACK32")
-    return FormatType::kA2R10G10B10_UNORM_PACK32;
-  if (data == "A2R10G10B10_USCALED_PACK32")
-    return FormatType::kA2R10G10B10_USCALED_PACK32;
-  if (data == "A8B8G8R8_SINT_PACK32")
-    return FormatType::kA8B8G8R8_SINT_PACK32;
-  if (data == "A8B8G8R8_SNORM_PACK32")
-    return FormatType::kA8B8G8R8_SNORM_PACK32;
-  if (data == "A8B8G8R8_SRGB_PACK32")
-    return FormatType::kA8B8G8R8_SRGB_PACK32;
-  if (data == "A8B8G8R8_SSCALED_PACK32")
-    return FormatType::kA8B8G8R8_SSCALED_PACK32;
-  if (data == "A8B8G8R8_UINT_PACK32")
-    return FormatType::kA8B8G8R8_UINT_PACK32;
-  if (data == "A8B8G8R8_UNORM_PACK32")
-    return FormatType::kA8B8G8R8_UNORM_PACK32;
-  if (data == "A8B8G8R8_USCALED_PACK32")
-    return FormatType::kA8B8G8R8_USCALED_PACK32;
-  if (data == "B10G11R11_UFLOAT_PACK32")
-    return FormatType::kB10G11R11_UFLOAT_PACK32;
-  if (data == "B4G4R4A4_UNORM_PACK16")
-    return FormatType::kB4G4R4A4_UNORM_PACK16;
-  if (data == "B5G5R5A1_UNORM_PACK16")
-    return FormatType::kB5G5R5A1_UNORM_PACK16;
-  if (data == "B5G6R5_UNORM_PACK16")
-    return FormatType::kB5G6R5_UNORM_PACK16;
-  if (data == "B8G8R8A8_SINT")
-    return FormatType::kB8G8R8A8_SINT;
-  if (data == "B8G8R8A8_SNORM")
-    return FormatType::kB8G8R8A8_SNORM;
-  if (data == "B8G8R8A8_SRGB")
-    return FormatType::kB8G8R8A8_SRGB;
-  if (data == "B8G8R8A8_SSCALED")
-    return FormatType::kB8G8R8A8_SSCALED;
-  if (data == "B8G8R8A8_UINT")
-    return FormatType::kB8G8R8A8_UINT;
-  if (data == "B8G8R8A8_UNORM")
-    return FormatType::kB8G8R8A8_UNORM;
-  if (data == "B8G8R8A8_USCALED")
-    return FormatType::kB8G8R8A8_USCALED;
-  if (data == "B8G8R8_SINT")
-    return FormatType::kB8G8R8_SINT;
-  if (data == "B8G8R8_SNORM")
-    return FormatType::kB8G8R8_SNORM;
-  if (data == "B8G8R8_SRGB")
-    return FormatType::kB8G8R8_SRGB;
-  if (data == "B8G8R8_SSCALED")
-    return FormatType::kB8G8R8_SSCALED;
-  if (data == "B8G8R8_UINT")
-    return FormatType::kB8G8R8_UINT;
-  if (data == "B8G8R8_UNORM")
-    return FormatType::kB8G8R8_UNORM;
-  if (data == "B8G8R8_USCALED")
-    return FormatType::kB8G8R8_USCALED;
-  if (data == "D16_UNORM")
-    return FormatType::kD16_UNORM;
-  if (data == "D16_UNORM_S8_UINT")
-    return FormatType::kD16_UNORM_S8_UINT;
-  if (data == "D24_UNORM_S8_UINT")
-    return FormatType::kD24_UNORM_S8_UINT;
-  if (data == "D32_SFLOAT")
-    return FormatType::kD32_SFLOAT;
-  if (data == "D32_SFLOAT_S8_UINT")
-    return FormatType::kD32_SFLOAT_S8_UINT;
-  if (data == "R16G16B16A16_SFLOAT")
-    return FormatType::kR16G16B16A16_SFLOAT;
-  if (data == "R16G16B16A16_SINT")
-    return FormatType::kR16G16B16A16_SINT;
-  if (data == "R16G16B16A16_SNORM")
-    return FormatType::kR16G16B16A16_SNORM;
-  if (data == "R16G16B16A16_SSCALED")
-    return FormatType::kR16G16B16A16_SSCALED;
-  if (data == "R16G16B16A16_UINT")
-    return FormatType::kR16G16B16A16_UINT;
-  if (data == "R16G16B16A16_UNORM")
-    return FormatType::kR16G16B16A16_UNORM;
-  if (data == "R16G16B16A16_USCALED")
-    return FormatType::kR16G16B16A16_USCALED;
-  if (data == "R16G16B16_SFLOAT")
-    return FormatType::kR16G16B16_SFLOAT;
-  if (data == "R16G16B16_SINT")
-    return FormatType::kR16G16B16_SINT;
-  if (data == "R16G16B16_SNORM")
-    return FormatType::kR16G16B16_SNORM;
-  if (data == "R16G16B16_SSCALED")
-    return FormatType::kR16G16B16_SSCALED;
-  if (data == "R16G16B16_UINT")
-    return FormatType::kR16G16B16_UINT;
-  if (data == "R16G16B16_UNORM")
-    return FormatType::kR16G16B16_UNORM;
-  if (data == "R16G16B16_USCALED")
-    return FormatType::kR16G16B16_USCALED;
-  if (data == "R16G16_SFLOAT")
-    return FormatType::kR16G16_SFLOAT;
-  if (data == "R16G16_SINT")
-    return FormatType::kR16G16_SINT;
-  if (data == "R16G16_SNORM")
-    return FormatType::kR16G16_SNORM;
-  if (data == "R16G16_SSCALED")
-    return FormatType::kR16G16_SSCALED;
-  if (data == "R16G16_UINT")
-    return FormatType::kR16G16_UINT;
-  if (data == "R16G16_UNORM")
-    return FormatType::kR16G16_UNORM;
-  if (data == "R16G16_USCALED")
-    return FormatType::kR16G16_USCALED;
-  if (data == "R16_SFLOAT")
-    return FormatType::kR16_SFLOAT;
-  if (data == "R16_SINT")
-    return FormatType::kR16_SINT;
-  if (data == "R16_SNORM")
-    return FormatType::kR16_SNORM;
-  if (data == "R16_SSCALED")
-    return FormatType::kR16_SSCALED;
-  if (data == "R16_UINT")
-    return FormatType::kR16_UINT;
-  if (data == "R16_UNORM")
-    return FormatType::kR16_UNORM;
-  if (data == "R16_USCALED")
-    return FormatType::kR16_USCALED;
-  if (data == "R32G32B32A32_SFLOAT")
-    return FormatType::kR32G32B32A32_SFLOAT;
-  if (data == "R32G32B32A32_SINT")
-    return FormatType::kR32G32B32A32_SINT;
-  if (data == "R32G32B32A32_UINT")
-    return FormatType::kR32G32B32A32_UINT;
-  if (data == "R32G32B32_SFLOAT")
-    return FormatType::kR32G32B32_SFLOAT;
-  if (data == "R32G32B32_SINT")
-    return FormatType::kR32G32B32_SINT;
-  if (data == "R32G32B32_UINT")
-    return FormatType::kR32G32B32_UINT;
-  if (data == "R32G32_SFLOAT")
-    return FormatType::kR32G32_SFLOAT;
-  if (data == "R32G32_SINT")
-    return FormatType::kR32G32_SINT;
-  if (data == "R32G32_UINT")
-    return FormatType::kR32G32_UINT;
-  if (data == "R32_SFLOAT")
-    return FormatType::kR32_SFLOAT;
-  if (data == "R32_SINT")
-    return FormatType::kR32_SINT;
-  if (data == "R32_UINT")
-    return FormatType::kR32_UINT;
-  if (data == "R4G4B4A4_UNORM_PACK16")
-    return FormatType::kR4G4B4A4_UNORM_PACK16;
-  if (data == "R4G4_UNORM_PACK8")
-    return FormatType::kR4G4_UNORM_PACK8;
-  if (data == "R5G5B5A1_UNORM_PACK16")
-    return FormatType::kR5G5B5A1_UNORM_PACK16;
-  if (data == "R5G6B5_UNORM_PACK16")
-    return FormatType::kR5G6B5_UNORM_PACK16;
-  if (data == "R64G64B64A64_SFLOAT")
-    return FormatType::kR64G64B64A64_SFLOAT;
-  if (data == "R64G64B64A64_SINT")
-    return FormatType::kR64G64B64A64_SINT;
-  if (data == "R64G64B64A64_UINT")
-    return FormatType::kR64G64B64A64_UINT;
-  if (data == "R64G64B64_SFLOAT")
-    return FormatType::kR64G64B64_SFLOAT;
-  if (data == "R64G64B64_SINT")
-    return FormatType::kR64G64B64_SINT;
-  if (data == "R64G64B64_UINT")
-    return FormatType::kR64G64B64_UINT;
-  if (data == "R64G64_SFLOAT")
-    return FormatType::kR64G64_SFLOAT;
-  if (data == "R64G64_SINT")
-    return FormatType::kR64G64_SINT;
-  if (data == "R64G64_UINT")
-    return FormatType::kR64G64_UINT;
-  if (data == "R64_SFLOAT")
-    return FormatType::kR64_SFLOAT;
-  if (data == "R64_SINT")
-    return FormatType::kR64_SINT;
-  if (data == "R64_UINT")
-    return FormatType::kR64_UINT;
-  if (data == "R8G8B8A8_SINT")
-    return FormatType::kR8G8B8A8_SINT;
-  if (data == "R8G8B8A8_SNORM")
-    return FormatType::kR8G8B8A8_SNORM;
-  if (data == "R8G8B8A8_SRGB")
-    return FormatType::kR8G8B8A8_SRGB;
-  if (data == "R8G8B8A8_SSCALED")
-    return FormatType::kR8G8B8A8_SSCALED;
-  if (data == "R8G8B8A8_UINT")
-    return FormatType::kR8G8B8A8_UINT;
-  if (data == "R8G8B8A8_UNORM")
-    return FormatType::kR8G8B8A8_UNORM;
-  if (data == "R8G8B8A8_USCALED")
-    return FormatType::kR8G8B8A8_USCALED;
-  if (data == "R8G8B8_SINT")
-    return FormatType::kR8G8B8_SINT;
-  if (data == "R8G8B8_SNORM")
-    return FormatType::kR8G8B8_SNORM;
-  if (data == "R8G8B8_SRGB")
-    return FormatType::kR8G8B8_SRGB;
-  if (data == "R8G8B8_SSCALED")
-    return FormatType::kR8G8B8_SSCALED;
-  if (data == "R8G8B8_UINT")
-    return FormatType::kR8G8B8_UINT;
-  if (data == "R8G8B8_UNORM")
-    return FormatType::kR8G8B8_UNORM;
-  if (data == "R8G8B8_USCALED")
-    return FormatType::kR8G8B8_USCALED;
-  if (data == "R8G8_SINT")
-    return FormatType::kR8G8_SINT;
-  if (data == "R8G8_SNORM")
-    return FormatType::kR8G8_SNORM;
-  if (data == "R8G8_SRGB")
-    return FormatType::kR8G8_SRGB;
-  if (data == "R8G8_SSCALED")
-    return FormatType::kR8G8_SSCALED;
-  if (data == "R8G8_UINT")
-    return FormatType::kR8G8_UINT;
-  if (data == "R8G8_UNORM")
-    return FormatType::kR8G8_UNORM;
-  if (data == "R8G8_USCALED")
-    return FormatType::kR8G8_USCALED;
-  if (data == "R8_SINT")
-    return FormatType::kR8_SINT;
-  if (data == "R8_SNORM")
-    return FormatType::kR8_SNORM;
-  if (data == "R8_SRGB")
-    return FormatType::kR8_SRGB;
-  if (data == "R8_SSCALED")
-    return FormatType::kR8_SSCALED;
-  if (data == "R8_UINT")
-    return FormatType::kR8_UINT;
-  if (data == "R8_UNORM")
-    return FormatType::kR8_UNORM;
-  if (data == "R8_USCALED")
-    return FormatType::kR8_USCALED;
-  if (data == "S8_UINT")
-    return FormatType::kS8_UINT;
-  if (data == "X8_D24_UNORM_PACK32")
-    return FormatType::kX8_D24_UNORM_PACK32;
+  struct NameType {
+    const char* name;
+    FormatType type;
+  };
+  // Sorted by name so the lookup can binary search. Keep the table sorted
+  // when adding new formats.
+  static const NameType kFormats[] = {
+      {"A1R5G5B5_UNORM_PACK16", FormatType::kA1R5G5B5_UNORM_PACK16},
+      {"A2B10G10R10_SINT_PACK32", FormatType::kA2B10G10R10_SINT_PACK32},
+      {"A2B10G10R10_SNORM_PACK32", FormatType::kA2B10G10R10_SNORM_PACK32},
+      {"A2B10G10R10_SSCALED_PACK32", FormatType::kA2B10G10R10_SSCALED_PACK32},
+      {"A2B10G10R10_UINT_PACK32", FormatType::kA2B10G10R10_UINT_PACK32},
+      {"A2B10G10R10_UNORM_PACK32", FormatType::kA2B10G10R10_UNORM_PACK32},
+      {"A2B10G10R10_USCALED_PACK32", FormatType::kA2B10G10R10_USCALED_PACK32},
+      {"A2R10G10B10_SINT_PACK32", FormatType::kA2R10G10B10_SINT_PACK32},
+      {"A2R10G10B10_SNORM_PACK32", FormatType::kA2R10G10B10_SNORM_PACK32},
+      {"A2R10G10B10_SSCALED_PACK32", FormatType::kA2R10G10B10_SSCALED_PACK32},
+      {"A2R10G10B10_UINT_PACK32", FormatType::kA2R10G10B10_UINT_PACK32},
+      {"A2R10G10B10_UNORM_PACK32", FormatType::kA2R10G10B10_UNORM_PACK32},
+      {"A2R10G10B10_USCALED_PACK32", FormatType::kA2R10G10B10_USCALED_PACK32},
+      {"A8B8G8R8_SINT_PACK32", FormatType::kA8B8G8R8_SINT_PACK32},
+      {"A8B8G8R8_SNORM_PACK32", FormatType::kA8B8G8R8_SNORM_PACK32},
+      {"A8B8G8R8_SRGB_PACK32", FormatType::kA8B8G8R8_SRGB_PACK32},
+      {"A8B8G8R8_SSCALED_PACK32", FormatType::kA8B8G8R8_SSCALED_PACK32},
+      {"A8B8G8R8_UINT_PACK32", FormatType::kA8B8G8R8_UINT_PACK32},
+      {"A8B8G8R8_UNORM_PACK32", FormatType::kA8B8G8R8_UNORM_PACK32},
+      {"A8B8G8R8_USCALED_PACK32", FormatType::kA8B8G8R8_USCALED_PACK32},
+      {"B10G11R11_UFLOAT_PACK32", FormatType::kB10G11R11_UFLOAT_PACK32},
+      {"B4G4R4A4_UNORM_PACK16", FormatType::kB4G4R4A4_UNORM_PACK16},
+      {"B5G5R5A1_UNORM_PACK16", FormatType::kB5G5R5A1_UNORM_PACK16},
+      {"B5G6R5_UNORM_PACK16", FormatType::kB5G6R5_UNORM_PACK16},
+      {"B8G8R8A8_SINT", FormatType::kB8G8R8A8_SINT},
+      {"B8G8R8A8_SNORM", FormatType::kB8G8R8A8_SNORM},
+      {"B8G8R8A8_SRGB", FormatType::kB8G8R8A8_SRGB},
+      {"B8G8R8A8_SSCALED", FormatType::kB8G8R8A8_SSCALED},
+      {"B8G8R8A8_UINT", FormatType::kB8G8R8A8_UINT},
+      {"B8G8R8A8_UNORM", FormatType::kB8G8R8A8_UNORM},
+      {"B8G8R8A8_USCALED", FormatType::kB8G8R8A8_USCALED},
+      {"B8G8R8_SINT", FormatType::kB8G8R8_SINT},
+      {"B8G8R8_SNORM", FormatType::kB8G8R8_SNORM},
+      {"B8G8R8_SRGB", FormatType::kB8G8R8_SRGB},
+      {"B8G8R8_SSCALED", FormatType::kB8G8R8_SSCALED},
+      {"B8G8R8_UINT", FormatType::kB8G8R8_UINT},
+      {"B8G8R8_UNORM", FormatType::kB8G8R8_UNORM},
+      {"B8G8R8_USCALED", FormatType::kB8G8R8_USCALED},
+      {"D16_UNORM", FormatType::kD16_UNORM},
+      {"D16_UNORM_S8_UINT", FormatType::kD16_UNORM_S8_UINT},
+      {"D24_UNORM_S8_UINT", FormatType::kD24_UNORM_S8_UINT},
+      {"D32_SFLOAT", FormatType::kD32_SFLOAT},
+      {"D32_SFLOAT_S8_UINT", FormatType::kD32_SFLOAT_S8_UINT},
+      {"R16G16B16A16_SFLOAT", FormatType::kR16G16B16A16_SFLOAT},
+      {"R16G16B16A16_SINT", FormatType::kR16G16B16A16_SINT},
+      {"R16G16B16A16_SNORM", FormatType::kR16G16B16A16_SNORM},
+      {"R16G16B16A16_SSCALED", FormatType::kR16G16B16A16_SSCALED},
+      {"R16G16B16A16_UINT", FormatType::kR16G16B16A16_UINT},
+      {"R16G16B16A16_UNORM", FormatType::kR16G16B16A16_UNORM},
+      {"R16G16B16A16_USCALED", FormatType::kR16G16B16A16_USCALED},
+      {"R16G16B16_SFLOAT", FormatType::kR16G16B16_SFLOAT},
+      {"R16G16B16_SINT", FormatType::kR16G16B16_SINT},
+      {"R16G16B16_SNORM", FormatType::kR16G16B16_SNORM},
+      {"R16G16B16_SSCALED", FormatType::kR16G16B16_SSCALED},
+      {"R16G16B16_UINT", FormatType::kR16G16B16_UINT},
+      {"R16G16B16_UNORM", FormatType::kR16G16B16_UNORM},
+      {"R16G16B16_USCALED", FormatType::kR16G16B16_USCALED},
+      {"R16G16_SFLOAT", FormatType::kR16G16_SFLOAT},
+      {"R16G16_SINT", FormatType::kR16G16_SINT},
+      {"R16G16_SNORM", FormatType::kR16G16_SNORM},
+      {"R16G16_SSCALED", FormatType::kR16G16_SSCALED},
+      {"R16G16_UINT", FormatType::kR16G16_UINT},
+      {"R16G16_UNORM", FormatType::kR16G16_UNORM},
+      {"R16G16_USCALED", FormatType::kR16G16_USCALED},
+      {"R16_SFLOAT", FormatType::kR16_SFLOAT},
+      {"R16_SINT", FormatType::kR16_SINT},
+      {"R16_SNORM", FormatType::kR16_SNORM},
+      {"R16_SSCALED", FormatType::kR16_SSCALED},
+      {"R16_UINT", FormatType::kR16_UINT},
+      {"R16_UNORM", FormatType::kR16_UNORM},
+      {"R16_USCALED", FormatType::kR16_USCALED},
+      {"R32G32B32A32_SFLOAT", FormatType::kR32G32B32A32_SFLOAT},
+      {"R32G32B32A32_SINT", FormatType::kR32G32B32A32_SINT},
+      {"R32G32B32A32_UINT", FormatType::kR32G32B32A32_UINT},
+      {"R32G32B32_SFLOAT", FormatType::kR32G32B32_SFLOAT},
+      {"R32G32B32_SINT", FormatType::kR32G32B32_SINT},
+      {"R32G32B32_UINT", FormatType::kR32G32B32_UINT},
+      {"R32G32_SFLOAT", FormatType::kR32G32_SFLOAT},
+      {"R32G32_SINT", FormatType::kR32G32_SINT},
+      {"R32G32_UINT", FormatType::kR32G32_UINT},
+      {"R32_SFLOAT", FormatType::kR32_SFLOAT},
+      {"R32_SINT", FormatType::kR32_SINT},
+      {"R32_UINT", FormatType::kR32_UINT},
+      {"R4G4B4A4_UNORM_PACK16", FormatType::kR4G4B4A4_UNORM_PACK16},
+      {"R4G4_UNORM_PACK8", FormatType::kR4G4_UNORM_PACK8},
+      {"R5G5B5A1_UNORM_PACK16", FormatType::kR5G5B5A1_UNORM_PACK16},
+      {"R5G6B5_UNORM_PACK16", FormatType::kR5G6B5_UNORM_PACK16},
+      {"R64G64B64A64_SFLOAT", FormatType::kR64G64B64A64_SFLOAT},
+      {"R64G64B64A64_SINT", FormatType::kR64G64B64A64_SINT},
+      {"R64G64B64A64_UINT", FormatType::kR64G64B64A64_UINT},
+      {"R64G64B64_SFLOAT", FormatType::kR64G64B64_SFLOAT},
+      {"R64G64B64_SINT", FormatType::kR64G64B64_SINT},
+      {"R64G64B64_UINT", FormatType::kR64G64B64_UINT},
+      {"R64G64_SFLOAT", FormatType::kR64G64_SFLOAT},
+      {"R64G64_SINT", FormatType::kR64G64_SINT},
+      {"R64G64_UINT", FormatType::kR64G64_UINT},
+      {"R64_SFLOAT", FormatType::kR64_SFLOAT},
+      {"R64_SINT", FormatType::kR64_SINT},
+      {"R64_UINT", FormatType::kR64_UINT},
+      {"R8G8B8A8_SINT", FormatType::kR8G8B8A8_SINT},
+      {"R8G8B8A8_SNORM", FormatType::kR8G8B8A8_SNORM},
+      {"R8G8B8A8_SRGB", FormatType::kR8G8B8A8_SRGB},
+      {"R8G8B8A8_SSCALED", FormatType::kR8G8B8A8_SSCALED},
+      {"R8G8B8A8_UINT", FormatType::kR8G8B8A8_UINT},
+      {"R8G8B8A8_UNORM", FormatType::kR8G8B8A8_UNORM},
+      {"R8G8B8A8_USCALED", FormatType::kR8G8B8A8_USCALED},
+      {"R8G8B8_SINT", FormatType::kR8G8B8_SINT},
+      {"R8G8B8_SNORM", FormatType::kR8G8B8_SNORM},
+      {"R8G8B8_SRGB", FormatType::kR8G8B8_SRGB},
+      {"R8G8B8_SSCALED", FormatType::kR8G8B8_SSCALED},
+      {"R8G8B8_UINT", FormatType::kR8G8B8_UINT},
+      {"R8G8B8_UNORM", FormatType::kR8G8B8_UNORM},
+      {"R8G8B8_USCALED", FormatType::kR8G8B8_USCALED},
+      {"R8G8_SINT", FormatType::kR8G8_SINT},
+      {"R8G8_SNORM", FormatType::kR8G8_SNORM},
+      {"R8G8_SRGB", FormatType::kR8G8_SRGB},
+      {"R8G8_SSCALED", FormatType::kR8G8_SSCALED},
+      {"R8G8_UINT", FormatType::kR8G8_UINT},
+      {"R8G8_UNORM", FormatType::kR8G8_UNORM},
+      {"R8G8_USCALED", FormatType::kR8G8_USCALED},
+      {"R8_SINT", FormatType::kR8_SINT},
+      {"R8_SNORM", FormatType::kR8_SNORM},
+      {"R8_SRGB", FormatType::kR8_SRGB},
+      {"R8_SSCALED", FormatType::kR8_SSCALED},
+      {"R8_UINT", FormatType::kR8_UINT},
+      {"R8_UNORM", FormatType::kR8_UNORM},
+      {"R8_USCALED", FormatType::kR8_USCALED},
+      {"S8_UINT", FormatType::kS8_UINT},
+      {"X8_D24_UNORM_PACK32", FormatType::kX8_D24_UNORM_PACK32},
+  };
+
+  const NameType* table_end = kFormats + sizeof(kFormats) / sizeof(kFormats[0]);
+  const NameType* it = std::lower_bound(
+      kFormats, table_end, data,
+      [](const NameType& lhs, const std::string& rhs) {
+        return std::strcmp(lhs.name, rhs.c_str()) < 0;
+      });
+  if (it != table_end && data == it->name)
+    return it->type;
 
   return FormatType::kUnknown;
 }
@@ -497,7 +417,8 @@ std::unique_ptr<Format> FormatParser::ParseGlslFormat(const std::string& fmt) {
   else
     return nullptr;
 
-  return Parse(new_name);
+  // Built by BuildFormat(); Parse() interns it under the glsl name.
+  return BuildFormat(new_name);
 }
 
 }  // namespace amber
@@ -30,9 +30,15 @@ class FormatParser {
   FormatParser();
   ~FormatParser();
 
-  std::unique_ptr<Format> Parse(const std::string& fmt);
+  /// Parses |fmt| and returns the immutable Format it names, or nullptr
+  /// when the name is invalid. Parsed formats are interned in a process
+  /// wide cache keyed by the format string: the corpora use only a
+  /// handful of distinct formats, so the same name always yields the
+  /// same shared object and format equality is a pointer compare.
+  std::shared_ptr<const Format> Parse(const std::string& fmt);
 
  private:
+  std::unique_ptr<Format> BuildFormat(const std::string& fmt);
   std::unique_ptr<Format> ParseGlslFormat(const std::string& fmt);
   void ProcessChunk(Format*, const std::string&);
   FormatType NameToType(const std::string& data);
@@ -1205,6 +1205,40 @@ TEST_F(FormatParserTest, EmptyFormat) {
   EXPECT_TRUE(format == nullptr);
 }
 
+TEST_F(FormatParserTest, InternsParsedFormats) {
+  FormatParser parser1;
+  FormatParser parser2;
+  auto fmt1 = parser1.Parse("R8G8B8A8_UNORM");
+  auto fmt2 = parser2.Parse("R8G8B8A8_UNORM");
+  ASSERT_TRUE(fmt1 != nullptr);
+  EXPECT_EQ(fmt1.get(), fmt2.get());
+
+  auto other = parser1.Parse("R32G32B32A32_SFLOAT");
+  ASSERT_TRUE(other != nullptr);
+  EXPECT_NE(fmt1.get(), other.get());
+}
+
+TEST_F(FormatParserTest, PrecomputedLayoutMetadata) {
+  FormatParser parser;
+  auto format = parser.Parse("R8G8B8A8_UNORM");
+  ASSERT_TRUE(format != nullptr);
+
+  EXPECT_TRUE(format->IsByteAligned());
+  EXPECT_EQ(4U, format->GetByteSize());
+
+  auto& comps = format->GetComponents();
+  ASSERT_EQ(4U, comps.size());
+  EXPECT_EQ(16U, comps[2].bit_offset);
+  EXPECT_EQ(2U, comps[2].byte_offset);
+  EXPECT_EQ(24U, comps[3].bit_offset);
+  EXPECT_EQ(3U, comps[3].byte_offset);
+
+  auto packed = parser.Parse("A2B10G10R10_UNORM_PACK32");
+  ASSERT_TRUE(packed != nullptr);
+  EXPECT_FALSE(packed->IsByteAligned());
+  EXPECT_EQ(12U, packed->GetComponents()[2].bit_offset);
+}
+
 TEST_F(FormatParserTest, GlslString) {
   FormatParser parser;
   auto format = parser.Parse("float/vec3");
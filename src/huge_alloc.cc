@@ -0,0 +1,88 @@
+// Copyright 2019 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/huge_alloc.h"
+
+#include <cstdlib>
+
+#include "amber/amber.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace amber {
+namespace {
+
+// Transparent huge pages are 2MiB on the platforms we run on; only
+// blocks of at least one huge page are worth aligning.
+const std::size_t kHugePageSize = 2 * 1024 * 1024;
+
+// Embedder-installed allocator every block is routed through when set;
+// see Options::host_allocator. A plain pointer so there is nothing to
+// destroy at exit.
+HostAllocator* host_block_allocator = nullptr;
+
+}  // namespace
+
+void SetHostBlockAllocator(HostAllocator* allocator) {
+  host_block_allocator = allocator;
+}
+
+void* AllocHostBlock(std::size_t size_in_bytes) {
+  if (host_block_allocator)
+    return host_block_allocator->Allocate(size_in_bytes);
+
+  if (size_in_bytes < kHugePageSize)
+    return malloc(size_in_bytes);
+
+#if defined(_WIN32) || defined(_WIN64)
+  // True large pages need SeLockMemoryPrivilege, which batch runners
+  // rarely have; aligned memory still lets the system promote pages.
+  return _aligned_malloc(size_in_bytes, kHugePageSize);
+#else
+  void* ptr = nullptr;
+  if (posix_memalign(&ptr, kHugePageSize, size_in_bytes) != 0)
+    return malloc(size_in_bytes);
+#ifdef MADV_HUGEPAGE
+  // Advisory only; the block works the same if the kernel declines.
+  madvise(ptr, size_in_bytes, MADV_HUGEPAGE);
+#endif  // MADV_HUGEPAGE
+  return ptr;
+#endif  // defined(_WIN32) || defined(_WIN64)
+}
+
+void FreeHostBlock(void* ptr, std::size_t size_in_bytes) {
+  if (!ptr)
+    return;
+
+  if (host_block_allocator) {
+    host_block_allocator->Free(ptr, size_in_bytes);
+    return;
+  }
+
+#if defined(_WIN32) || defined(_WIN64)
+  if (size_in_bytes < kHugePageSize)
+    free(ptr);
+  else
+    _aligned_free(ptr);
+#else
+  (void)size_in_bytes;
+  free(ptr);
+#endif  // defined(_WIN32) || defined(_WIN64)
+}
+
+}  // namespace amber
@@ -0,0 +1,82 @@
+// Copyright 2019 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_HUGE_ALLOC_H_
+#define SRC_HUGE_ALLOC_H_
+
+#include <cstddef>
+
+namespace amber {
+
+class HostAllocator;
+
+/// Routes later AllocHostBlock()/FreeHostBlock() calls through
+/// |allocator|; null restores the built-in path. Every block must be
+/// freed through the allocator that provided it, so the override is
+/// meant to be installed once, before block-holding objects exist, and
+/// left in place.
+void SetHostBlockAllocator(HostAllocator* allocator);
+
+/// Allocates |size_in_bytes| of host memory. Blocks of at least one
+/// huge page are aligned to the huge page boundary and, on Linux, the
+/// kernel is asked to back them with transparent huge pages, which
+/// cuts TLB misses in fill and verify loops over multi-gigabyte
+/// buffers. Smaller blocks come from plain malloc. Returns null when
+/// the allocation fails.
+void* AllocHostBlock(std::size_t size_in_bytes);
+
+/// Frees a block from AllocHostBlock(). |size_in_bytes| must be the
+/// size the block was allocated with.
+void FreeHostBlock(void* ptr, std::size_t size_in_bytes);
+
+/// Minimal allocator over AllocHostBlock(), for vectors holding large
+/// host-side shadows of device buffers.
+template <typename T>
+class HugePageAllocator {
+ public:
+  typedef T value_type;
+
+  HugePageAllocator() {}
+  template <typename U>
+  HugePageAllocator(const HugePageAllocator<U>&) {}
+
+  T* allocate(std::size_t count) {
+    return static_cast<T*>(AllocHostBlock(count * sizeof(T)));
+  }
+
+  void deallocate(T* ptr, std::size_t count) {
+    FreeHostBlock(ptr, count * sizeof(T));
+  }
+
+  template <typename U>
+  struct rebind {
+    typedef HugePageAllocator<U> other;
+  };
+};
+
+template <typename T, typename U>
+inline bool operator==(const HugePageAllocator<T>&,
+                       const HugePageAllocator<U>&) {
+  return true;
+}
+
+template <typename T, typename U>
+inline bool operator!=(const HugePageAllocator<T>&,
+                       const HugePageAllocator<U>&) {
+  return false;
+}
+
+}  // namespace amber
+
+#endif  // SRC_HUGE_ALLOC_H_
@@ -22,4 +22,49 @@ PipelineData::~PipelineData() = default;
 
 PipelineData::PipelineData(const PipelineData&) = default;
 
+bool PipelineData::Equals(const PipelineData& other) const {
+  return front_fail_op_ == other.front_fail_op_ &&
+         front_pass_op_ == other.front_pass_op_ &&
+         front_depth_fail_op_ == other.front_depth_fail_op_ &&
+         front_compare_op_ == other.front_compare_op_ &&
+         back_fail_op_ == other.back_fail_op_ &&
+         back_pass_op_ == other.back_pass_op_ &&
+         back_depth_fail_op_ == other.back_depth_fail_op_ &&
+         back_compare_op_ == other.back_compare_op_ &&
+         topology_ == other.topology_ &&
+         polygon_mode_ == other.polygon_mode_ &&
+         cull_mode_ == other.cull_mode_ && front_face_ == other.front_face_ &&
+         depth_compare_op_ == other.depth_compare_op_ &&
+         logic_op_ == other.logic_op_ &&
+         src_color_blend_factor_ == other.src_color_blend_factor_ &&
+         dst_color_blend_factor_ == other.dst_color_blend_factor_ &&
+         src_alpha_blend_factor_ == other.src_alpha_blend_factor_ &&
+         dst_alpha_blend_factor_ == other.dst_alpha_blend_factor_ &&
+         color_blend_op_ == other.color_blend_op_ &&
+         alpha_blend_op_ == other.alpha_blend_op_ &&
+         front_compare_mask_ == other.front_compare_mask_ &&
+         front_write_mask_ == other.front_write_mask_ &&
+         front_reference_ == other.front_reference_ &&
+         back_compare_mask_ == other.back_compare_mask_ &&
+         back_write_mask_ == other.back_write_mask_ &&
+         back_reference_ == other.back_reference_ &&
+         color_write_mask_ == other.color_write_mask_ &&
+         enable_blend_ == other.enable_blend_ &&
+         enable_depth_test_ == other.enable_depth_test_ &&
+         enable_depth_write_ == other.enable_depth_write_ &&
+         enable_depth_clamp_ == other.enable_depth_clamp_ &&
+         enable_depth_bias_ == other.enable_depth_bias_ &&
+         enable_depth_bounds_test_ == other.enable_depth_bounds_test_ &&
+         enable_stencil_test_ == other.enable_stencil_test_ &&
+         enable_primitive_restart_ == other.enable_primitive_restart_ &&
+         enable_rasterizer_discard_ == other.enable_rasterizer_discard_ &&
+         enable_logic_op_ == other.enable_logic_op_ &&
+         line_width_ == other.line_width_ &&
+         depth_bias_constant_factor_ == other.depth_bias_constant_factor_ &&
+         depth_bias_clamp_ == other.depth_bias_clamp_ &&
+         depth_bias_slope_factor_ == other.depth_bias_slope_factor_ &&
+         min_depth_bounds_ == other.min_depth_bounds_ &&
+         max_depth_bounds_ == other.max_depth_bounds_;
+}
+
 }  // namespace amber
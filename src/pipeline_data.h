@@ -27,6 +27,10 @@ class PipelineData {
   ~PipelineData();
   PipelineData(const PipelineData&);
 
+  // Return true when every piece of state matches |other|. Used to decide
+  // whether a pipeline created from this data can be reused.
+  bool Equals(const PipelineData& other) const;
+
   void SetTopology(Topology topo) { topology_ = topo; }
   Topology GetTopology() const { return topology_; }
 
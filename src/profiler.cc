@@ -0,0 +1,82 @@
+// Copyright 2018 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/profiler.h"
+
+#include <fstream>
+
+namespace amber {
+
+Profiler* Profiler::Get() {
+  static Profiler profiler;
+  return &profiler;
+}
+
+Profiler::Profiler()
+    : enabled_(false), run_begin_(std::chrono::steady_clock::now()) {}
+
+uint32_t Profiler::GetThreadIndex() {
+  const auto id = std::this_thread::get_id();
+  for (uint32_t i = 0; i < threads_.size(); ++i) {
+    if (threads_[i] == id)
+      return i;
+  }
+  threads_.push_back(id);
+  return static_cast<uint32_t>(threads_.size() - 1);
+}
+
+void Profiler::AddEvent(const char* name,
+                        std::chrono::steady_clock::time_point begin,
+                        std::chrono::steady_clock::time_point end) {
+  Event event;
+  event.name = name;
+  event.start_us = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(begin - run_begin_)
+          .count());
+  event.duration_us = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(end - begin)
+          .count());
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  event.thread = GetThreadIndex();
+  events_.push_back(event);
+}
+
+Result Profiler::WriteChromeTrace(const std::string& file_name) {
+  std::ofstream file(file_name, std::ios::out | std::ios::trunc);
+  if (!file.is_open())
+    return Result("Cannot open file for trace dump: " + file_name);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  // Complete events ("ph":"X") carry their duration inline, so one
+  // record per instrumented scope is enough.
+  file << "{\"traceEvents\":[";
+  for (size_t i = 0; i < events_.size(); ++i) {
+    const Event& event = events_[i];
+    if (i != 0)
+      file << ",";
+    file << "\n{\"name\":\"" << event.name << "\",\"cat\":\"amber\","
+         << "\"ph\":\"X\",\"ts\":" << event.start_us
+         << ",\"dur\":" << event.duration_us << ",\"pid\":0,\"tid\":"
+         << event.thread << "}";
+  }
+  file << "\n]}\n";
+
+  if (!file.good())
+    return Result("Failed to write trace file: " + file_name);
+  return {};
+}
+
+}  // namespace amber
@@ -0,0 +1,101 @@
+// Copyright 2018 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_PROFILER_H_
+#define SRC_PROFILER_H_
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "amber/result.h"
+
+namespace amber {
+
+/// Process wide collector of timed CPU phases. Profiling is off by
+/// default and an instrumented scope then costs a single branch; when
+/// enabled, every ScopedPhaseTimer records one event which can be
+/// written out as a chrome://tracing trace-event JSON file.
+class Profiler {
+ public:
+  /// Returns the process wide profiler.
+  static Profiler* Get();
+
+  /// Turns event collection on.
+  void Enable() { enabled_ = true; }
+  /// Returns true when events are being collected.
+  bool IsEnabled() const { return enabled_; }
+
+  /// Records an event named |name| lasting from |begin| to |end| on the
+  /// calling thread. |name| must be a string literal; it is not copied.
+  void AddEvent(const char* name,
+                std::chrono::steady_clock::time_point begin,
+                std::chrono::steady_clock::time_point end);
+
+  /// Writes the collected events to |file_name| in the Chrome
+  /// trace-event JSON format, loadable by chrome://tracing and
+  /// compatible viewers.
+  Result WriteChromeTrace(const std::string& file_name);
+
+ private:
+  struct Event {
+    const char* name;
+    uint64_t start_us;
+    uint64_t duration_us;
+    uint32_t thread;
+  };
+
+  Profiler();
+
+  /// Index of the calling thread in |threads_|, registering it on first
+  /// use. Must be called with |mutex_| held.
+  uint32_t GetThreadIndex();
+
+  std::atomic<bool> enabled_;
+  std::chrono::steady_clock::time_point run_begin_;
+  std::mutex mutex_;
+  std::vector<std::thread::id> threads_;
+  std::vector<Event> events_;
+};
+
+/// Times the enclosing scope and records it on the process profiler
+/// under |name| when profiling is enabled. |name| must be a string
+/// literal; it is not copied.
+class ScopedPhaseTimer {
+ public:
+  explicit ScopedPhaseTimer(const char* name) : name_(name) {
+    if (Profiler::Get()->IsEnabled())
+      begin_ = std::chrono::steady_clock::now();
+    else
+      name_ = nullptr;
+  }
+
+  ~ScopedPhaseTimer() {
+    if (name_) {
+      Profiler::Get()->AddEvent(name_, begin_,
+                                std::chrono::steady_clock::now());
+    }
+  }
+
+ private:
+  const char* name_;
+  std::chrono::steady_clock::time_point begin_;
+};
+
+}  // namespace amber
+
+#endif  // SRC_PROFILER_H_
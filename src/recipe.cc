@@ -13,6 +13,11 @@
 
 #include "amber/recipe.h"
 
+#include <memory>
+
+#include "src/script.h"
+#include "src/script_serializer.h"
+
 namespace amber {
 
 RecipeImpl::RecipeImpl() = default;
@@ -21,22 +26,45 @@ RecipeImpl::~RecipeImpl() = default;
 
 Recipe::Recipe() = default;
 
-Recipe::~Recipe() {
-  delete impl_;
+Recipe::~Recipe() = default;
+
+const std::vector<ShaderInfo>& Recipe::GetShaderInfo() const {
+  return impl_ ? impl_->GetShaderInfo() : empty_shader_info_;
 }
 
-std::vector<ShaderInfo> Recipe::GetShaderInfo() const {
+const std::vector<std::string>& Recipe::GetRequiredFeatures() const {
+  return impl_ ? impl_->GetRequiredFeatures() : empty_strings_;
+}
+
+const std::vector<std::string>& Recipe::GetRequiredExtensions() const {
+  return impl_ ? impl_->GetRequiredExtensions() : empty_strings_;
+}
+
+std::vector<std::string> Recipe::GetReferencedDataFiles() const {
+  return impl_ ? impl_->GetReferencedDataFiles() : std::vector<std::string>();
+}
+
+amber::Result Recipe::Serialize(std::vector<uint8_t>* out) const {
+  if (!out)
+    return Result("Buffer must be provided to Serialize.");
   if (!impl_)
-    return {};
-  return impl_->GetShaderInfo();
+    return Result("Recipe must contain a parsed script to serialize.");
+
+  return ScriptSerializer::Serialize(*static_cast<Script*>(impl_.get()), out);
 }
 
-std::vector<std::string> Recipe::GetRequiredFeatures() const {
-  return impl_ ? impl_->GetRequiredFeatures() : std::vector<std::string>();
+amber::Result Recipe::Deserialize(const std::vector<uint8_t>& data) {
+  return Deserialize(data.data(), data.size());
 }
 
-std::vector<std::string> Recipe::GetRequiredExtensions() const {
-  return impl_ ? impl_->GetRequiredExtensions() : std::vector<std::string>();
+amber::Result Recipe::Deserialize(const uint8_t* data, size_t size) {
+  std::unique_ptr<Script> script;
+  Result r = ScriptSerializer::Deserialize(data, size, &script);
+  if (!r.IsSuccess())
+    return r;
+
+  SetImpl(script.release());
+  return {};
 }
 
 }  // namespace amber
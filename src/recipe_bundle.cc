@@ -0,0 +1,208 @@
+// Copyright 2019 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/recipe_bundle.h"
+
+#include <cassert>
+#include <utility>
+
+#include "src/platform.h"
+#include "src/serializer_stream.h"
+
+#if AMBER_PLATFORM_POSIX
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace amber {
+namespace {
+
+const uint32_t kMagic = 0x4c444241;  // 'ABDL'
+const uint32_t kVersion = 1;
+
+size_t EncodedSize(const std::string& s) {
+  return 4 + s.size();
+}
+
+size_t EncodedSize(const std::vector<std::string>& strings) {
+  size_t size = 4;
+  for (const auto& s : strings)
+    size += EncodedSize(s);
+  return size;
+}
+
+void WriteStrings(ByteWriter* w, const std::vector<std::string>& strings) {
+  w->U32(static_cast<uint32_t>(strings.size()));
+  for (const auto& s : strings)
+    w->Str(s);
+}
+
+}  // namespace
+
+RecipeBundleWriter::RecipeBundleWriter() = default;
+
+RecipeBundleWriter::~RecipeBundleWriter() = default;
+
+Result RecipeBundleWriter::Add(const std::string& name, const Recipe& recipe) {
+  Entry entry;
+  entry.name = name;
+  entry.features = recipe.GetRequiredFeatures();
+  entry.extensions = recipe.GetRequiredExtensions();
+
+  Result r = recipe.Serialize(&entry.blob);
+  if (!r.IsSuccess())
+    return r;
+
+  entries_.push_back(std::move(entry));
+  return {};
+}
+
+Result RecipeBundleWriter::Write(std::vector<uint8_t>* out) const {
+  if (!out)
+    return Result("Buffer must be provided to Write.");
+
+  // Blob offsets are archive relative, so the index size comes first:
+  // the fixed header then per entry its name, feature and extension
+  // lists, and an offset and size pair.
+  size_t index_size = 12;
+  for (const auto& entry : entries_) {
+    index_size += EncodedSize(entry.name) + EncodedSize(entry.features) +
+                  EncodedSize(entry.extensions) + 16;
+  }
+
+  ByteWriter w(out);
+  w.U32(kMagic);
+  w.U32(kVersion);
+  w.U32(static_cast<uint32_t>(entries_.size()));
+
+  uint64_t offset = index_size;
+  for (const auto& entry : entries_) {
+    w.Str(entry.name);
+    WriteStrings(&w, entry.features);
+    WriteStrings(&w, entry.extensions);
+    w.U64(offset);
+    w.U64(entry.blob.size());
+    offset += entry.blob.size();
+  }
+
+  for (const auto& entry : entries_)
+    out->insert(out->end(), entry.blob.begin(), entry.blob.end());
+
+  return {};
+}
+
+RecipeBundleReader::RecipeBundleReader() = default;
+
+RecipeBundleReader::~RecipeBundleReader() = default;
+
+bool RecipeBundleReader::IsBundle(const uint8_t* data, size_t size) {
+  if (!data)
+    return false;
+  ByteReader r(data, size);
+  return r.U32() == kMagic && r.IsValid();
+}
+
+Result RecipeBundleReader::Open(const uint8_t* data, size_t size) {
+  if (!data)
+    return Result("Data must be provided to Open.");
+
+  ByteReader r(data, size);
+  if (r.U32() != kMagic || !r.IsValid())
+    return Result("Data is not a recipe bundle.");
+  if (r.U32() != kVersion)
+    return Result("Unsupported recipe bundle version.");
+
+  uint32_t count = r.U32();
+  std::vector<Entry> entries;
+  entries.reserve(count);
+  for (uint32_t i = 0; i < count && r.IsValid(); ++i) {
+    Entry entry;
+    entry.name = r.Str();
+
+    uint32_t feature_count = r.U32();
+    for (uint32_t j = 0; j < feature_count && r.IsValid(); ++j)
+      entry.features.push_back(r.Str());
+
+    uint32_t extension_count = r.U32();
+    for (uint32_t j = 0; j < extension_count && r.IsValid(); ++j)
+      entry.extensions.push_back(r.Str());
+
+    entry.offset = r.U64();
+    entry.size = r.U64();
+    if (!r.IsValid())
+      break;
+
+    if (entry.offset > size || size - entry.offset < entry.size)
+      return Result("Recipe bundle entry is out of range.");
+
+    entries.push_back(std::move(entry));
+  }
+  if (!r.IsValid())
+    return Result("Recipe bundle index is truncated.");
+
+  data_ = data;
+  size_ = size;
+  entries_ = std::move(entries);
+  return {};
+}
+
+const std::string& RecipeBundleReader::GetRecipeName(size_t index) const {
+  assert(index < entries_.size());
+  return entries_[index].name;
+}
+
+const std::vector<std::string>& RecipeBundleReader::GetRequiredFeatures(
+    size_t index) const {
+  assert(index < entries_.size());
+  return entries_[index].features;
+}
+
+const std::vector<std::string>& RecipeBundleReader::GetRequiredExtensions(
+    size_t index) const {
+  assert(index < entries_.size());
+  return entries_[index].extensions;
+}
+
+Result RecipeBundleReader::LoadRecipe(size_t index, Recipe* recipe) const {
+  if (!recipe)
+    return Result("Recipe must be provided to LoadRecipe.");
+  if (index >= entries_.size())
+    return Result("Recipe bundle entry index is out of range.");
+
+  const Entry& entry = entries_[index];
+  return recipe->Deserialize(data_ + entry.offset,
+                             static_cast<size_t>(entry.size));
+}
+
+void RecipeBundleReader::PrefetchRecipe(size_t index) const {
+  assert(index < entries_.size());
+#if AMBER_PLATFORM_POSIX
+  const Entry& entry = entries_[index];
+  if (entry.size == 0)
+    return;
+
+  // madvise() wants a page aligned start; round the range outward. The
+  // advice is harmless when the archive is not a mapping.
+  const uintptr_t page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+  uintptr_t begin = reinterpret_cast<uintptr_t>(data_) + entry.offset;
+  const uintptr_t end = begin + static_cast<uintptr_t>(entry.size);
+  begin &= ~(page_size - 1);
+  madvise(reinterpret_cast<void*>(begin), static_cast<size_t>(end - begin),
+          MADV_WILLNEED);
+#else
+  (void)index;
+#endif
+}
+
+}  // namespace amber
@@ -0,0 +1,117 @@
+// Copyright 2019 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_RECIPE_BUNDLE_H_
+#define SRC_RECIPE_BUNDLE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "amber/recipe.h"
+#include "amber/result.h"
+
+namespace amber {
+
+/// Packs many serialized recipes into one archive with an index, so a
+/// corpus of thousands of scripts ships as a single file instead of one
+/// file per script. The layout favours memory mapping: the index at the
+/// front carries everything needed to enumerate and schedule the entries
+/// (their names and required features and extensions), and a recipe's
+/// blob is only read when that recipe is loaded, so a mapped archive
+/// faults in just the recipes that actually run and its read-only pages
+/// are shared between processes. Like the recipe serializer it builds
+/// on, the format is internal and only guaranteed to load with the same
+/// Amber version which produced it.
+class RecipeBundleWriter {
+ public:
+  RecipeBundleWriter();
+  ~RecipeBundleWriter();
+
+  /// Serializes |recipe| and stores it under |name|. Entries keep the
+  /// order they were added in.
+  Result Add(const std::string& name, const Recipe& recipe);
+
+  /// Appends the archive holding every added entry to |out|.
+  Result Write(std::vector<uint8_t>* out) const;
+
+ private:
+  struct Entry {
+    std::string name;
+    std::vector<std::string> features;
+    std::vector<std::string> extensions;
+    std::vector<uint8_t> blob;
+  };
+
+  std::vector<Entry> entries_;
+};
+
+/// Reads archives produced by RecipeBundleWriter out of a caller-provided
+/// block of memory, typically a memory-mapped file.
+class RecipeBundleReader {
+ public:
+  RecipeBundleReader();
+  ~RecipeBundleReader();
+
+  /// Returns true when |data| of |size| bytes starts with the archive
+  /// magic, so a caller can tell a bundle from a script without parsing
+  /// either.
+  static bool IsBundle(const uint8_t* data, size_t size);
+
+  /// Parses the archive index at |data| of |size| bytes; only index
+  /// bytes are touched. The memory must stay valid and unmodified for
+  /// the life of the reader.
+  Result Open(const uint8_t* data, size_t size);
+
+  size_t GetRecipeCount() const { return entries_.size(); }
+
+  /// Returns the name entry |index| was stored under. |index| must be
+  /// less than GetRecipeCount().
+  const std::string& GetRecipeName(size_t index) const;
+
+  /// Returns the features entry |index|'s recipe requires. Read from
+  /// the index, so scheduling over the entries touches no blob bytes.
+  const std::vector<std::string>& GetRequiredFeatures(size_t index) const;
+
+  /// Returns the extensions entry |index|'s recipe requires, like
+  /// GetRequiredFeatures().
+  const std::vector<std::string>& GetRequiredExtensions(size_t index) const;
+
+  /// Deserializes entry |index| into |recipe|. This is the only call
+  /// which reads an entry's blob bytes.
+  Result LoadRecipe(size_t index, Recipe* recipe) const;
+
+  /// Advises the OS to read entry |index|'s blob bytes ahead, so a
+  /// later LoadRecipe() of the entry finds its pages resident instead
+  /// of faulting them in one at a time. A no-op on platforms without
+  /// the advice call. |index| must be less than GetRecipeCount().
+  void PrefetchRecipe(size_t index) const;
+
+ private:
+  struct Entry {
+    std::string name;
+    std::vector<std::string> features;
+    std::vector<std::string> extensions;
+    uint64_t offset = 0;
+    uint64_t size = 0;
+  };
+
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+  std::vector<Entry> entries_;
+};
+
+}  // namespace amber
+
+#endif  // SRC_RECIPE_BUNDLE_H_
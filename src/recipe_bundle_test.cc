@@ -0,0 +1,102 @@
+// Copyright 2019 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/recipe_bundle.h"
+
+#include <utility>
+
+#include "gtest/gtest.h"
+#include "src/make_unique.h"
+#include "src/script.h"
+
+namespace amber {
+namespace {
+
+// Builds a recipe holding one named shader, with the given required
+// extension when |extension| is non-empty.
+Recipe MakeRecipe(const std::string& shader_name,
+                  const std::string& extension) {
+  auto script = MakeUnique<Script>();
+  if (!extension.empty())
+    script->AddRequiredExtension(extension);
+
+  auto shader = MakeUnique<Shader>(kShaderTypeVertex);
+  shader->SetName(shader_name);
+  shader->SetFormat(kShaderFormatGlsl);
+  shader->SetData("source of " + shader_name);
+  script->AddShader(std::move(shader));
+
+  Recipe recipe;
+  recipe.SetImpl(script.release());
+  return recipe;
+}
+
+}  // namespace
+
+using RecipeBundleTest = testing::Test;
+
+TEST_F(RecipeBundleTest, RoundTripEntries) {
+  RecipeBundleWriter writer;
+  Recipe first = MakeRecipe("first_shader", "VK_KHR_variable_pointers");
+  Recipe second = MakeRecipe("second_shader", "");
+  ASSERT_TRUE(writer.Add("corpus/first.amber", first).IsSuccess());
+  ASSERT_TRUE(writer.Add("corpus/second.amber", second).IsSuccess());
+
+  std::vector<uint8_t> archive;
+  ASSERT_TRUE(writer.Write(&archive).IsSuccess());
+
+  RecipeBundleReader reader;
+  Result r = reader.Open(archive.data(), archive.size());
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  ASSERT_EQ(2U, reader.GetRecipeCount());
+  EXPECT_EQ("corpus/first.amber", reader.GetRecipeName(0));
+  EXPECT_EQ("corpus/second.amber", reader.GetRecipeName(1));
+  ASSERT_EQ(1U, reader.GetRequiredExtensions(0).size());
+  EXPECT_EQ("VK_KHR_variable_pointers", reader.GetRequiredExtensions(0)[0]);
+  EXPECT_TRUE(reader.GetRequiredExtensions(1).empty());
+
+  Recipe loaded;
+  r = reader.LoadRecipe(1, &loaded);
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+  auto* script = static_cast<Script*>(loaded.GetImpl());
+  ASSERT_TRUE(script != nullptr);
+  const auto* shader = script->GetShader("second_shader");
+  ASSERT_TRUE(shader != nullptr);
+  EXPECT_EQ("source of second_shader", shader->GetData());
+}
+
+TEST_F(RecipeBundleTest, RejectsCorruptArchives) {
+  RecipeBundleWriter writer;
+  Recipe recipe = MakeRecipe("a_shader", "");
+  ASSERT_TRUE(writer.Add("a.amber", recipe).IsSuccess());
+
+  std::vector<uint8_t> archive;
+  ASSERT_TRUE(writer.Write(&archive).IsSuccess());
+
+  RecipeBundleReader reader;
+  // Not an archive at all.
+  EXPECT_FALSE(reader.Open(archive.data(), 2).IsSuccess());
+
+  // A truncated index fails cleanly rather than pointing at missing
+  // blob bytes.
+  EXPECT_FALSE(reader.Open(archive.data(), archive.size() / 2).IsSuccess());
+
+  Recipe loaded;
+  ASSERT_TRUE(reader.Open(archive.data(), archive.size()).IsSuccess());
+  EXPECT_FALSE(reader.LoadRecipe(1, &loaded).IsSuccess());
+  EXPECT_TRUE(reader.LoadRecipe(0, &loaded).IsSuccess());
+}
+
+}  // namespace amber
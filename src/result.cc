@@ -16,14 +16,28 @@
 
 namespace amber {
 
-Result::Result() : succeeded_(true) {}
+Result::Result() = default;
 
-Result::Result(const std::string& err) : succeeded_(false), error_(err) {}
+Result::Result(const std::string& err) : error_(new std::string(err)) {}
 
-Result::Result(const Result&) = default;
+Result::Result(const Result& other)
+    : error_(other.error_ ? new std::string(*other.error_) : nullptr) {}
+
+Result::Result(Result&&) noexcept = default;
 
 Result::~Result() = default;
 
-Result& Result::operator=(const Result&) = default;
+Result& Result::operator=(const Result& other) {
+  if (this != &other)
+    error_.reset(other.error_ ? new std::string(*other.error_) : nullptr);
+  return *this;
+}
+
+Result& Result::operator=(Result&&) noexcept = default;
+
+const std::string& Result::Error() const {
+  static const std::string kNoError;
+  return error_ ? *error_ : kNoError;
+}
 
 }  // namespace amber
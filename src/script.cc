@@ -137,8 +137,8 @@ Script::Script() = default;
 
 Script::~Script() = default;
 
-std::vector<ShaderInfo> Script::GetShaderInfo() const {
-  std::vector<ShaderInfo> ret;
+void Script::RebuildRecipeInfo() {
+  shader_info_.clear();
   for (const auto& shader : shaders_) {
     // TODO(dsinclair): The name returned should be the
     // `pipeline_name + shader_name` instead of just shader name when we have
@@ -146,27 +146,45 @@ std::vector<ShaderInfo> Script::GetShaderInfo() const {
 
     // TODO(dsinclair): The optimization passes should be retrieved from the
     // pipeline and returned here instead of an empty array.
-    ret.emplace_back(ShaderInfo{shader->GetFormat(),
-                                shader->GetType(),
-                                shader->GetName(),
-                                shader->GetData(),
-                                {}});
+    shader_info_.emplace_back(ShaderInfo{shader->GetFormat(),
+                                         shader->GetType(),
+                                         shader->GetName(),
+                                         shader->GetData(),
+                                         {}});
   }
-  return ret;
-}
 
-std::vector<std::string> Script::GetRequiredFeatures() const {
-  std::vector<std::string> required_features_in_string;
+  required_feature_names_.clear();
   for (auto feature : engine_info_.required_features) {
     auto name = FeatureToName(feature);
     if (!name.empty())
-      required_features_in_string.push_back(name);
+      required_feature_names_.push_back(name);
   }
-  return required_features_in_string;
 }
 
-std::vector<std::string> Script::GetRequiredExtensions() const {
+const std::vector<ShaderInfo>& Script::GetShaderInfo() const {
+  return shader_info_;
+}
+
+const std::vector<std::string>& Script::GetRequiredFeatures() const {
+  return required_feature_names_;
+}
+
+const std::vector<std::string>& Script::GetRequiredExtensions() const {
   return engine_info_.required_extensions;
 }
 
+std::vector<std::string> Script::GetReferencedDataFiles() const {
+  std::vector<std::string> files;
+  for (const auto& cmd : commands_) {
+    if (cmd->IsBuffer()) {
+      if (cmd->AsBuffer()->IsFromDataFile())
+        files.push_back(cmd->AsBuffer()->GetDataFilePath());
+    } else if (cmd->IsProbe()) {
+      if (cmd->AsProbe()->IsReferenceImage())
+        files.push_back(cmd->AsProbe()->GetReferenceImagePath());
+    }
+  }
+  return files;
+}
+
 }  // namespace amber
@@ -16,9 +16,9 @@
 #define SRC_SCRIPT_H_
 
 #include <cstdint>
-#include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -30,39 +30,63 @@
 #include "src/feature.h"
 #include "src/pipeline.h"
 #include "src/shader.h"
+#include "src/string_interner.h"
 
 namespace amber {
 
-/// Class representing the script to be run against an engine.
+/// One element of the flattened command stream. The tag mirrors the command
+/// type so dispatch only touches this contiguous array; the Command object
+/// itself is only dereferenced once the executor knows what to do with it.
+struct CommandStreamEntry {
+  Command::Type type;
+  Command* command;
+};
+
+/// Class representing the script to be run against an engine. Once
+/// parsing has finished a script is immutable, apart from the compiled
+/// binary cached on each shader which is internally synchronized, so one
+/// script can be executed concurrently from several threads as long as
+/// each uses its own engine.
 class Script : public RecipeImpl {
  public:
   Script();
   ~Script() override;
 
-  /// Retrieves information on the shaders in the given script.
-  std::vector<ShaderInfo> GetShaderInfo() const override;
+  /// Retrieves information on the shaders in the given script. Returns
+  /// the cache built by Finalize(); no shader source is copied per call.
+  const std::vector<ShaderInfo>& GetShaderInfo() const override;
 
-  /// Returns required features in the given recipe.
-  std::vector<std::string> GetRequiredFeatures() const override;
+  /// Returns required features in the given recipe. Returns the cache
+  /// built by Finalize().
+  const std::vector<std::string>& GetRequiredFeatures() const override;
 
   /// Returns required extensions in the given recipe.
-  std::vector<std::string> GetRequiredExtensions() const override;
+  const std::vector<std::string>& GetRequiredExtensions() const override;
+
+  /// Returns the paths of the external files the script's commands read
+  /// during execution: buffer initializer data files and probe
+  /// reference images.
+  std::vector<std::string> GetReferencedDataFiles() const override;
 
   /// Adds |pipeline| to the list of known pipelines. The |pipeline| must have
   /// a unique name over all pipelines in the script.
   Result AddPipeline(std::unique_ptr<Pipeline> pipeline) {
-    if (name_to_pipeline_.count(pipeline->GetName()) > 0)
+    uint32_t id = interner_.Intern(pipeline->GetName());
+    if (id_to_pipeline_.count(id) > 0)
       return Result("duplicate pipeline name provided");
 
     pipelines_.push_back(std::move(pipeline));
-    name_to_pipeline_[pipelines_.back()->GetName()] = pipelines_.back().get();
+    id_to_pipeline_[id] = pipelines_.back().get();
     return {};
   }
 
   /// Retrieves the pipeline with |name|, |nullptr| if not found.
   Pipeline* GetPipeline(const std::string& name) const {
-    auto it = name_to_pipeline_.find(name);
-    return it == name_to_pipeline_.end() ? nullptr : it->second;
+    uint32_t id = interner_.Find(name);
+    if (id == StringInterner::kInvalidId)
+      return nullptr;
+    auto it = id_to_pipeline_.find(id);
+    return it == id_to_pipeline_.end() ? nullptr : it->second;
   }
 
   /// Retrieves a list of all pipelines.
@@ -73,18 +97,22 @@ class Script : public RecipeImpl {
   /// Adds |shader| to the list of known shaders. The |shader| must have a
   /// unique name over all shaders in the script.
   Result AddShader(std::unique_ptr<Shader> shader) {
-    if (name_to_shader_.count(shader->GetName()) > 0)
+    uint32_t id = interner_.Intern(shader->GetName());
+    if (id_to_shader_.count(id) > 0)
       return Result("duplicate shader name provided");
 
     shaders_.push_back(std::move(shader));
-    name_to_shader_[shaders_.back()->GetName()] = shaders_.back().get();
+    id_to_shader_[id] = shaders_.back().get();
     return {};
   }
 
   /// Retrieves the shader with |name|, |nullptr| if not found.
   Shader* GetShader(const std::string& name) const {
-    auto it = name_to_shader_.find(name);
-    return it == name_to_shader_.end() ? nullptr : it->second;
+    uint32_t id = interner_.Find(name);
+    if (id == StringInterner::kInvalidId)
+      return nullptr;
+    auto it = id_to_shader_.find(id);
+    return it == id_to_shader_.end() ? nullptr : it->second;
   }
 
   /// Retrieves a list of all shaders.
@@ -95,18 +123,22 @@ class Script : public RecipeImpl {
   /// Adds |buffer| to the list of known buffers. The |buffer| must have a
   /// unique name over all buffers in the script.
   Result AddBuffer(std::unique_ptr<Buffer> buffer) {
-    if (name_to_buffer_.count(buffer->GetName()) > 0)
+    uint32_t id = interner_.Intern(buffer->GetName());
+    if (id_to_buffer_.count(id) > 0)
       return Result("duplicate buffer name provided");
 
     buffers_.push_back(std::move(buffer));
-    name_to_buffer_[buffers_.back()->GetName()] = buffers_.back().get();
+    id_to_buffer_[id] = buffers_.back().get();
     return {};
   }
 
   /// Retrieves the buffer with |name|, |nullptr| if not found.
   Buffer* GetBuffer(const std::string& name) const {
-    auto it = name_to_buffer_.find(name);
-    return it == name_to_buffer_.end() ? nullptr : it->second;
+    uint32_t id = interner_.Find(name);
+    if (id == StringInterner::kInvalidId)
+      return nullptr;
+    auto it = id_to_buffer_.find(id);
+    return it == id_to_buffer_.end() ? nullptr : it->second;
   }
 
   /// Retrieves a list of all buffers.
@@ -143,6 +175,11 @@ class Script : public RecipeImpl {
   /// Sets |cmds| to the list of commands to execute against the engine.
   void SetCommands(std::vector<std::unique_ptr<Command>> cmds) {
     commands_ = std::move(cmds);
+
+    command_stream_.clear();
+    command_stream_.reserve(commands_.size());
+    for (const auto& cmd : commands_)
+      command_stream_.push_back({cmd->GetType(), cmd.get()});
   }
 
   /// Retrieves the list of commands to execute against the engine.
@@ -150,20 +187,88 @@ class Script : public RecipeImpl {
     return commands_;
   }
 
+  /// Retrieves the commands as a flat tagged array suitable for linear
+  /// iteration. Entries stay valid as long as the command list is unchanged.
+  const std::vector<CommandStreamEntry>& GetCommandStream() const {
+    return command_stream_;
+  }
+
+  /// Precomputes execution metadata once parsing is complete: the type
+  /// of the implicit pipeline and the partition of the buffers into
+  /// frame attachments and plain buffers. The parsers call this at the
+  /// end of a successful parse so executing the script - in particular
+  /// repeatedly - never rediscovers this structure. The flat command
+  /// stream is maintained by SetCommands() already.
+  void Finalize() {
+    implicit_pipeline_type_ = PipelineType::kGraphics;
+    for (const auto& shader : shaders_) {
+      if (shader->GetType() == kShaderTypeCompute)
+        implicit_pipeline_type_ = PipelineType::kCompute;
+    }
+
+    attachment_buffers_.clear();
+    plain_buffers_.clear();
+    for (const auto& buf : buffers_) {
+      if (buf->GetBufferType() == BufferType::kColor ||
+          buf->GetBufferType() == BufferType::kDepth) {
+        attachment_buffers_.push_back(buf.get());
+      } else {
+        plain_buffers_.push_back(buf.get());
+      }
+    }
+
+    RebuildRecipeInfo();
+  }
+
+  /// Type of the pipeline created when the script declares none
+  /// explicitly: compute when any shader is a compute shader, graphics
+  /// otherwise. Valid after Finalize().
+  PipelineType GetImplicitPipelineType() const {
+    return implicit_pipeline_type_;
+  }
+
+  /// Color and depth buffers, which the engine needs before pipelines
+  /// are created. Valid after Finalize().
+  const std::vector<Buffer*>& GetAttachmentBuffers() const {
+    return attachment_buffers_;
+  }
+
+  /// All buffers other than the frame attachments, handed to the engine
+  /// after pipeline creation. Valid after Finalize().
+  const std::vector<Buffer*>& GetPlainBuffers() const {
+    return plain_buffers_;
+  }
+
  private:
+  // Build |shader_info_| and |required_feature_names_| so the recipe
+  // accessors hand out references instead of rebuilding per call.
+  void RebuildRecipeInfo();
+
   struct {
     std::vector<Feature> required_features;
     std::vector<std::string> required_extensions;
   } engine_info_;
 
   EngineData engine_data_;
-  std::map<std::string, Shader*> name_to_shader_;
-  std::map<std::string, Buffer*> name_to_buffer_;
-  std::map<std::string, Pipeline*> name_to_pipeline_;
+  // One interner serves all three registries; ids are unique per name,
+  // not per registry, so a shader and a buffer with the same name share
+  // an id but live in different maps.
+  StringInterner interner_;
+  std::unordered_map<uint32_t, Shader*> id_to_shader_;
+  std::unordered_map<uint32_t, Buffer*> id_to_buffer_;
+  std::unordered_map<uint32_t, Pipeline*> id_to_pipeline_;
   std::vector<std::unique_ptr<Shader>> shaders_;
   std::vector<std::unique_ptr<Command>> commands_;
+  std::vector<CommandStreamEntry> command_stream_;
   std::vector<std::unique_ptr<Buffer>> buffers_;
   std::vector<std::unique_ptr<Pipeline>> pipelines_;
+
+  // Execution metadata derived by Finalize().
+  PipelineType implicit_pipeline_type_ = PipelineType::kGraphics;
+  std::vector<Buffer*> attachment_buffers_;
+  std::vector<Buffer*> plain_buffers_;
+  std::vector<ShaderInfo> shader_info_;
+  std::vector<std::string> required_feature_names_;
 };
 
 }  // namespace amber
@@ -0,0 +1,754 @@
+// Copyright 2019 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/script_serializer.h"
+
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include "src/make_unique.h"
+#include "src/serializer_stream.h"
+
+namespace amber {
+namespace {
+
+const uint32_t kMagic = 0x52424d41;  // 'AMBR'
+const uint32_t kVersion = 3;
+
+void WriteValue(ByteWriter* w, const Value& v) {
+  if (v.IsInteger()) {
+    w->U8(0);
+    w->U64(v.AsUint64());
+  } else {
+    w->U8(1);
+    w->F64(v.AsDouble());
+  }
+}
+
+Value ReadValue(ByteReader* r) {
+  Value v;
+  if (r->U8() == 0)
+    v.SetIntValue(r->U64());
+  else
+    v.SetDoubleValue(r->F64());
+  return v;
+}
+
+void WriteValues(ByteWriter* w, const std::vector<Value>& values) {
+  w->U32(static_cast<uint32_t>(values.size()));
+  for (const auto& v : values) {
+    if (v.IsInteger()) {
+      w->U8(0);
+      w->U64(v.AsUint64());
+    } else {
+      w->U8(1);
+      w->F64(v.AsDouble());
+    }
+  }
+}
+
+std::vector<Value> ReadValues(ByteReader* r) {
+  std::vector<Value> values;
+  uint32_t count = r->U32();
+  for (uint32_t i = 0; i < count && r->IsValid(); ++i) {
+    Value v;
+    if (r->U8() == 0)
+      v.SetIntValue(r->U64());
+    else
+      v.SetDoubleValue(r->F64());
+    values.push_back(v);
+  }
+  return values;
+}
+
+void WriteDatumType(ByteWriter* w, const DatumType& type) {
+  w->U8(static_cast<uint8_t>(type.GetType()));
+  w->U32(type.ColumnCount());
+  w->U32(type.RowCount());
+}
+
+DatumType ReadDatumType(ByteReader* r) {
+  DatumType type;
+  type.SetType(static_cast<DataType>(r->U8()));
+  type.SetColumnCount(r->U32());
+  type.SetRowCount(r->U32());
+  return type;
+}
+
+void WriteFormat(ByteWriter* w, const Format& fmt) {
+  w->U32(static_cast<uint32_t>(fmt.GetFormatType()));
+  w->U8(fmt.GetPackSize());
+  w->U32(static_cast<uint32_t>(fmt.GetComponents().size()));
+  for (const auto& comp : fmt.GetComponents()) {
+    w->U8(static_cast<uint8_t>(comp.type));
+    w->U8(static_cast<uint8_t>(comp.mode));
+    w->U8(comp.num_bits);
+  }
+}
+
+std::unique_ptr<Format> ReadFormat(ByteReader* r) {
+  auto fmt = MakeUnique<Format>();
+  fmt->SetFormatType(static_cast<FormatType>(r->U32()));
+  fmt->SetPackSize(r->U8());
+  uint32_t count = r->U32();
+  for (uint32_t i = 0; i < count && r->IsValid(); ++i) {
+    auto type = static_cast<FormatComponentType>(r->U8());
+    auto mode = static_cast<FormatMode>(r->U8());
+    fmt->AddComponent(type, mode, r->U8());
+  }
+  return fmt;
+}
+
+void WritePipelineData(ByteWriter* w, const PipelineData& data) {
+  w->U8(static_cast<uint8_t>(data.GetTopology()));
+  w->U8(static_cast<uint8_t>(data.GetPolygonMode()));
+  w->U8(static_cast<uint8_t>(data.GetCullMode()));
+  w->U8(static_cast<uint8_t>(data.GetFrontFace()));
+  w->U8(static_cast<uint8_t>(data.GetDepthCompareOp()));
+  w->U8(data.GetColorWriteMask());
+  w->U8(static_cast<uint8_t>(data.GetFrontFailOp()));
+  w->U8(static_cast<uint8_t>(data.GetFrontPassOp()));
+  w->U8(static_cast<uint8_t>(data.GetFrontDepthFailOp()));
+  w->U8(static_cast<uint8_t>(data.GetFrontCompareOp()));
+  w->U32(data.GetFrontCompareMask());
+  w->U32(data.GetFrontWriteMask());
+  w->U32(data.GetFrontReference());
+  w->U8(static_cast<uint8_t>(data.GetBackFailOp()));
+  w->U8(static_cast<uint8_t>(data.GetBackPassOp()));
+  w->U8(static_cast<uint8_t>(data.GetBackDepthFailOp()));
+  w->U8(static_cast<uint8_t>(data.GetBackCompareOp()));
+  w->U32(data.GetBackCompareMask());
+  w->U32(data.GetBackWriteMask());
+  w->U32(data.GetBackReference());
+  w->U8(static_cast<uint8_t>(data.GetLogicOp()));
+  w->U8(static_cast<uint8_t>(data.GetSrcColorBlendFactor()));
+  w->U8(static_cast<uint8_t>(data.GetDstColorBlendFactor()));
+  w->U8(static_cast<uint8_t>(data.GetSrcAlphaBlendFactor()));
+  w->U8(static_cast<uint8_t>(data.GetDstAlphaBlendFactor()));
+  w->U8(static_cast<uint8_t>(data.GetColorBlendOp()));
+  w->U8(static_cast<uint8_t>(data.GetAlphaBlendOp()));
+  w->Bool(data.GetEnableBlend());
+  w->Bool(data.GetEnableDepthTest());
+  w->Bool(data.GetEnableDepthWrite());
+  w->Bool(data.GetEnableStencilTest());
+  w->Bool(data.GetEnablePrimitiveRestart());
+  w->Bool(data.GetEnableDepthClamp());
+  w->Bool(data.GetEnableRasterizerDiscard());
+  w->Bool(data.GetEnableDepthBias());
+  w->Bool(data.GetEnableLogicOp());
+  w->Bool(data.GetEnableDepthBoundsTest());
+  w->F32(data.GetLineWidth());
+  w->F32(data.GetDepthBiasConstantFactor());
+  w->F32(data.GetDepthBiasClamp());
+  w->F32(data.GetDepthBiasSlopeFactor());
+  w->F32(data.GetMinDepthBounds());
+  w->F32(data.GetMaxDepthBounds());
+}
+
+PipelineData ReadPipelineData(ByteReader* r) {
+  PipelineData data;
+  data.SetTopology(static_cast<Topology>(r->U8()));
+  data.SetPolygonMode(static_cast<PolygonMode>(r->U8()));
+  data.SetCullMode(static_cast<CullMode>(r->U8()));
+  data.SetFrontFace(static_cast<FrontFace>(r->U8()));
+  data.SetDepthCompareOp(static_cast<CompareOp>(r->U8()));
+  data.SetColorWriteMask(r->U8());
+  data.SetFrontFailOp(static_cast<StencilOp>(r->U8()));
+  data.SetFrontPassOp(static_cast<StencilOp>(r->U8()));
+  data.SetFrontDepthFailOp(static_cast<StencilOp>(r->U8()));
+  data.SetFrontCompareOp(static_cast<CompareOp>(r->U8()));
+  data.SetFrontCompareMask(r->U32());
+  data.SetFrontWriteMask(r->U32());
+  data.SetFrontReference(r->U32());
+  data.SetBackFailOp(static_cast<StencilOp>(r->U8()));
+  data.SetBackPassOp(static_cast<StencilOp>(r->U8()));
+  data.SetBackDepthFailOp(static_cast<StencilOp>(r->U8()));
+  data.SetBackCompareOp(static_cast<CompareOp>(r->U8()));
+  data.SetBackCompareMask(r->U32());
+  data.SetBackWriteMask(r->U32());
+  data.SetBackReference(r->U32());
+  data.SetLogicOp(static_cast<LogicOp>(r->U8()));
+  data.SetSrcColorBlendFactor(static_cast<BlendFactor>(r->U8()));
+  data.SetDstColorBlendFactor(static_cast<BlendFactor>(r->U8()));
+  data.SetSrcAlphaBlendFactor(static_cast<BlendFactor>(r->U8()));
+  data.SetDstAlphaBlendFactor(static_cast<BlendFactor>(r->U8()));
+  data.SetColorBlendOp(static_cast<BlendOp>(r->U8()));
+  data.SetAlphaBlendOp(static_cast<BlendOp>(r->U8()));
+  data.SetEnableBlend(r->Bool());
+  data.SetEnableDepthTest(r->Bool());
+  data.SetEnableDepthWrite(r->Bool());
+  data.SetEnableStencilTest(r->Bool());
+  data.SetEnablePrimitiveRestart(r->Bool());
+  data.SetEnableDepthClamp(r->Bool());
+  data.SetEnableRasterizerDiscard(r->Bool());
+  data.SetEnableDepthBias(r->Bool());
+  data.SetEnableLogicOp(r->Bool());
+  data.SetEnableDepthBoundsTest(r->Bool());
+  data.SetLineWidth(r->F32());
+  data.SetDepthBiasConstantFactor(r->F32());
+  data.SetDepthBiasClamp(r->F32());
+  data.SetDepthBiasSlopeFactor(r->F32());
+  data.SetMinDepthBounds(r->F32());
+  data.SetMaxDepthBounds(r->F32());
+  return data;
+}
+
+void WriteBuffer(ByteWriter* w, Buffer* buffer) {
+  w->U8(buffer->IsFormatBuffer() ? 1 : 0);
+  w->U8(static_cast<uint8_t>(buffer->GetBufferType()));
+  w->U8(buffer->GetLocation());
+  w->Str(buffer->GetName());
+  w->U64(buffer->GetSize());
+  if (buffer->IsFormatBuffer()) {
+    WriteFormat(w, buffer->AsFormatBuffer()->GetFormat());
+  } else {
+    WriteDatumType(w, buffer->AsDataBuffer()->GetDatumType());
+  }
+  WriteValues(w, buffer->GetData());
+}
+
+std::unique_ptr<Buffer> ReadBuffer(ByteReader* r) {
+  bool is_format = r->U8() == 1;
+  auto buffer_type = static_cast<BufferType>(r->U8());
+  uint8_t location = r->U8();
+  std::string name = r->Str();
+  uint64_t buffer_size = r->U64();
+
+  std::unique_ptr<Buffer> buffer;
+  if (is_format) {
+    auto buf = MakeUnique<FormatBuffer>(buffer_type);
+    buf->SetFormat(ReadFormat(r));
+    buffer = std::move(buf);
+  } else {
+    auto buf = MakeUnique<DataBuffer>(buffer_type);
+    buf->SetDatumType(ReadDatumType(r));
+    buffer = std::move(buf);
+  }
+  buffer->SetLocation(location);
+  buffer->SetName(name);
+  buffer->SetData(ReadValues(r));
+  buffer->SetSize(static_cast<size_t>(buffer_size));
+  return buffer;
+}
+
+void WriteTolerances(ByteWriter* w, const std::vector<Probe::Tolerance>& tols) {
+  w->U32(static_cast<uint32_t>(tols.size()));
+  for (const auto& tol : tols) {
+    w->Bool(tol.is_percent);
+    w->F64(tol.value);
+  }
+}
+
+std::vector<Probe::Tolerance> ReadTolerances(ByteReader* r) {
+  std::vector<Probe::Tolerance> tols;
+  uint32_t count = r->U32();
+  for (uint32_t i = 0; i < count && r->IsValid(); ++i) {
+    bool is_percent = r->Bool();
+    tols.emplace_back(is_percent, r->F64());
+  }
+  return tols;
+}
+
+void WriteCommand(ByteWriter* w, Command* cmd) {
+  w->U64(cmd->GetLine());
+
+  if (cmd->IsDrawRect()) {
+    auto* c = cmd->AsDrawRect();
+    w->U8(0);
+    WritePipelineData(w, *c->GetPipelineData());
+    w->Bool(c->IsOrtho());
+    w->Bool(c->IsPatch());
+    w->F32(c->GetX());
+    w->F32(c->GetY());
+    w->F32(c->GetWidth());
+    w->F32(c->GetHeight());
+  } else if (cmd->IsDrawArrays()) {
+    auto* c = cmd->AsDrawArrays();
+    w->U8(1);
+    WritePipelineData(w, *c->GetPipelineData());
+    w->Bool(c->IsIndexed());
+    w->Bool(c->IsInstanced());
+    w->U8(static_cast<uint8_t>(c->GetTopology()));
+    w->U32(c->GetFirstVertexIndex());
+    w->U32(c->GetVertexCount());
+    w->U32(c->GetInstanceCount());
+  } else if (cmd->IsCompute()) {
+    auto* c = cmd->AsCompute();
+    w->U8(2);
+    w->U32(c->GetX());
+    w->U32(c->GetY());
+    w->U32(c->GetZ());
+  } else if (cmd->IsProbe()) {
+    auto* c = cmd->AsProbe();
+    w->U8(3);
+    WriteTolerances(w, c->GetTolerances());
+    w->Bool(c->IsWholeWindow());
+    w->Bool(c->IsProbeRect());
+    w->Bool(c->IsRelative());
+    w->Bool(c->IsRGBA());
+    w->F32(c->GetX());
+    w->F32(c->GetY());
+    w->F32(c->GetWidth());
+    w->F32(c->GetHeight());
+    w->F32(c->GetR());
+    w->F32(c->GetG());
+    w->F32(c->GetB());
+    w->F32(c->GetA());
+    w->Str(c->GetReferenceImagePath());
+  } else if (cmd->IsProbeSSBO()) {
+    auto* c = cmd->AsProbeSSBO();
+    w->U8(4);
+    WriteTolerances(w, c->GetTolerances());
+    w->U8(static_cast<uint8_t>(c->GetComparator()));
+    w->U32(c->GetDescriptorSet());
+    w->U32(c->GetBinding());
+    w->U32(c->GetOffset());
+    w->Bool(c->IsChecksum());
+    w->U64(c->GetChecksum());
+    w->U32(c->GetChecksumSizeInBytes());
+    WriteDatumType(w, c->GetDatumType());
+    WriteValues(w, c->GetValues());
+  } else if (cmd->IsBuffer()) {
+    auto* c = cmd->AsBuffer();
+    w->U8(5);
+    uint8_t buffer_type = 0;
+    if (c->IsUniform())
+      buffer_type = 1;
+    else if (c->IsPushConstant())
+      buffer_type = 2;
+    w->U8(buffer_type);
+    w->Bool(c->IsSubdata());
+    w->U32(c->GetDescriptorSet());
+    w->U32(c->GetBinding());
+    w->U32(c->GetOffset());
+    w->U32(c->GetSize());
+    w->U8(static_cast<uint8_t>(c->GetGenerator()));
+    WriteValue(w, c->GetGeneratorStart());
+    WriteValue(w, c->GetGeneratorStep());
+    w->Str(c->GetDataFilePath());
+    w->U64(c->GetDataFileOffset());
+    w->U64(c->GetDataFileSize());
+    WriteDatumType(w, c->GetDatumType());
+    WriteValues(w, c->GetValues());
+  } else if (cmd->IsClear()) {
+    w->U8(6);
+  } else if (cmd->IsClearColor()) {
+    auto* c = cmd->AsClearColor();
+    w->U8(7);
+    w->F32(c->GetR());
+    w->F32(c->GetG());
+    w->F32(c->GetB());
+    w->F32(c->GetA());
+  } else if (cmd->IsClearDepth()) {
+    auto* c = cmd->AsClearDepth();
+    w->U8(8);
+    w->F32(c->GetValue());
+  } else if (cmd->IsClearStencil()) {
+    auto* c = cmd->AsClearStencil();
+    w->U8(9);
+    w->U32(c->GetValue());
+  } else if (cmd->IsPatchParameterVertices()) {
+    auto* c = cmd->AsPatchParameterVertices();
+    w->U8(10);
+    w->U32(c->GetControlPointCount());
+  } else if (cmd->IsEntryPoint()) {
+    auto* c = cmd->AsEntryPoint();
+    w->U8(11);
+    w->U8(static_cast<uint8_t>(c->GetShaderType()));
+    w->Str(c->GetEntryPointName());
+  }
+}
+
+std::unique_ptr<Command> ReadCommand(ByteReader* r) {
+  uint64_t line = r->U64();
+  uint8_t tag = r->U8();
+
+  std::unique_ptr<Command> cmd;
+  switch (tag) {
+    case 0: {
+      auto c = MakeUnique<DrawRectCommand>(ReadPipelineData(r));
+      if (r->Bool())
+        c->EnableOrtho();
+      if (r->Bool())
+        c->EnablePatch();
+      c->SetX(r->F32());
+      c->SetY(r->F32());
+      c->SetWidth(r->F32());
+      c->SetHeight(r->F32());
+      cmd = std::move(c);
+      break;
+    }
+    case 1: {
+      auto c = MakeUnique<DrawArraysCommand>(ReadPipelineData(r));
+      if (r->Bool())
+        c->EnableIndexed();
+      if (r->Bool())
+        c->EnableInstanced();
+      c->SetTopology(static_cast<Topology>(r->U8()));
+      c->SetFirstVertexIndex(r->U32());
+      c->SetVertexCount(r->U32());
+      c->SetInstanceCount(r->U32());
+      cmd = std::move(c);
+      break;
+    }
+    case 2: {
+      auto c = MakeUnique<ComputeCommand>();
+      c->SetX(r->U32());
+      c->SetY(r->U32());
+      c->SetZ(r->U32());
+      cmd = std::move(c);
+      break;
+    }
+    case 3: {
+      auto c = MakeUnique<ProbeCommand>();
+      c->SetTolerances(ReadTolerances(r));
+      if (r->Bool())
+        c->SetWholeWindow();
+      if (r->Bool())
+        c->SetProbeRect();
+      if (r->Bool())
+        c->SetRelative();
+      if (r->Bool())
+        c->SetIsRGBA();
+      c->SetX(r->F32());
+      c->SetY(r->F32());
+      c->SetWidth(r->F32());
+      c->SetHeight(r->F32());
+      c->SetR(r->F32());
+      c->SetG(r->F32());
+      c->SetB(r->F32());
+      c->SetA(r->F32());
+      std::string reference_image_path = r->Str();
+      if (!reference_image_path.empty())
+        c->SetReferenceImagePath(reference_image_path);
+      cmd = std::move(c);
+      break;
+    }
+    case 4: {
+      auto c = MakeUnique<ProbeSSBOCommand>();
+      c->SetTolerances(ReadTolerances(r));
+      c->SetComparator(static_cast<ProbeSSBOCommand::Comparator>(r->U8()));
+      c->SetDescriptorSet(r->U32());
+      c->SetBinding(r->U32());
+      c->SetOffset(r->U32());
+      bool is_checksum = r->Bool();
+      uint64_t checksum = r->U64();
+      uint32_t checksum_size = r->U32();
+      if (is_checksum)
+        c->SetChecksum(checksum, checksum_size);
+      c->SetDatumType(ReadDatumType(r));
+      c->SetValues(ReadValues(r));
+      cmd = std::move(c);
+      break;
+    }
+    case 5: {
+      uint8_t buffer_type = r->U8();
+      auto type = BufferCommand::BufferType::kSSBO;
+      if (buffer_type == 1)
+        type = BufferCommand::BufferType::kUniform;
+      else if (buffer_type == 2)
+        type = BufferCommand::BufferType::kPushConstant;
+
+      auto c = MakeUnique<BufferCommand>(type);
+      if (r->Bool())
+        c->SetIsSubdata();
+      c->SetDescriptorSet(r->U32());
+      c->SetBinding(r->U32());
+      c->SetOffset(r->U32());
+      uint32_t size = r->U32();
+      auto generator = static_cast<BufferDataGenerator>(r->U8());
+      Value generator_start = ReadValue(r);
+      Value generator_step = ReadValue(r);
+      std::string data_file_path = r->Str();
+      uint64_t data_file_offset = r->U64();
+      uint64_t data_file_size = r->U64();
+      c->SetDatumType(ReadDatumType(r));
+      c->SetValues(ReadValues(r));
+      if (generator == BufferDataGenerator::kFill) {
+        c->SetGeneratorFill(generator_start, 0);
+      } else if (generator == BufferDataGenerator::kSeries) {
+        c->SetGeneratorSeries(generator_start, generator_step, 0);
+      }
+      // SetValues() and the generator setters recompute the size;
+      // restore the stored one last so the command keeps the size it
+      // was serialized with.
+      c->SetSize(size);
+      if (!data_file_path.empty()) {
+        c->SetDataFilePath(data_file_path);
+        c->SetDataFileOffset(data_file_offset);
+        c->SetDataFileSize(data_file_size);
+      }
+      cmd = std::move(c);
+      break;
+    }
+    case 6: {
+      cmd = MakeUnique<ClearCommand>();
+      break;
+    }
+    case 7: {
+      auto c = MakeUnique<ClearColorCommand>();
+      c->SetR(r->F32());
+      c->SetG(r->F32());
+      c->SetB(r->F32());
+      c->SetA(r->F32());
+      cmd = std::move(c);
+      break;
+    }
+    case 8: {
+      auto c = MakeUnique<ClearDepthCommand>();
+      c->SetValue(r->F32());
+      cmd = std::move(c);
+      break;
+    }
+    case 9: {
+      auto c = MakeUnique<ClearStencilCommand>();
+      c->SetValue(r->U32());
+      cmd = std::move(c);
+      break;
+    }
+    case 10: {
+      auto c = MakeUnique<PatchParameterVerticesCommand>();
+      c->SetControlPointCount(r->U32());
+      cmd = std::move(c);
+      break;
+    }
+    case 11: {
+      auto c = MakeUnique<EntryPointCommand>();
+      c->SetShaderType(static_cast<ShaderType>(r->U8()));
+      c->SetEntryPointName(r->Str());
+      cmd = std::move(c);
+      break;
+    }
+    default:
+      return nullptr;
+  }
+
+  cmd->SetLine(static_cast<size_t>(line));
+  return cmd;
+}
+
+}  // namespace
+
+Result ScriptSerializer::Serialize(const Script& script,
+                                   std::vector<uint8_t>* out) {
+  ByteWriter w(out);
+  w.U32(kMagic);
+  w.U32(kVersion);
+
+  w.U32(script.GetEngineData().fence_timeout_ms);
+
+  const auto& features = script.RequiredFeatures();
+  w.U32(static_cast<uint32_t>(features.size()));
+  for (const auto& feature : features)
+    w.U32(static_cast<uint32_t>(feature));
+
+  const auto& extensions = script.RequiredExtensions();
+  w.U32(static_cast<uint32_t>(extensions.size()));
+  for (const auto& ext : extensions)
+    w.Str(ext);
+
+  const auto& shaders = script.GetShaders();
+  w.U32(static_cast<uint32_t>(shaders.size()));
+  for (const auto& shader : shaders) {
+    w.U8(static_cast<uint8_t>(shader->GetType()));
+    w.U8(static_cast<uint8_t>(shader->GetFormat()));
+    w.Str(shader->GetName());
+    w.Str(shader->GetData());
+  }
+
+  const auto& buffers = script.GetBuffers();
+  w.U32(static_cast<uint32_t>(buffers.size()));
+  for (const auto& buffer : buffers)
+    WriteBuffer(&w, buffer.get());
+
+  const auto& pipelines = script.GetPipelines();
+  w.U32(static_cast<uint32_t>(pipelines.size()));
+  for (const auto& pipeline : pipelines) {
+    w.U8(pipeline->GetType() == PipelineType::kCompute ? 0 : 1);
+    w.Str(pipeline->GetName());
+    w.U32(pipeline->GetFramebufferWidth());
+    w.U32(pipeline->GetFramebufferHeight());
+
+    const auto& infos = pipeline->GetShaders();
+    w.U32(static_cast<uint32_t>(infos.size()));
+    for (const auto& info : infos) {
+      uint32_t shader_idx = 0;
+      for (uint32_t i = 0; i < shaders.size(); ++i) {
+        if (shaders[i].get() == info.GetShader()) {
+          shader_idx = i;
+          break;
+        }
+      }
+      w.U32(shader_idx);
+      w.U8(static_cast<uint8_t>(info.GetShaderType()));
+      w.Str(info.GetEntryPoint());
+      w.U32(static_cast<uint32_t>(info.GetShaderOptimizations().size()));
+      for (const auto& opt : info.GetShaderOptimizations())
+        w.Str(opt);
+    }
+  }
+
+  const auto& commands = script.GetCommands();
+  w.U32(static_cast<uint32_t>(commands.size()));
+  for (const auto& cmd : commands)
+    WriteCommand(&w, cmd.get());
+
+  return {};
+}
+
+Result ScriptSerializer::Deserialize(const uint8_t* data,
+                                     size_t size,
+                                     std::unique_ptr<Script>* script) {
+  ByteReader r(data, size);
+  if (r.U32() != kMagic)
+    return Result("serialized recipe has invalid magic number");
+  if (r.U32() != kVersion)
+    return Result("serialized recipe has unsupported version");
+
+  auto out = MakeUnique<Script>();
+  out->GetEngineData().fence_timeout_ms = r.U32();
+
+  uint32_t feature_count = r.U32();
+  for (uint32_t i = 0; i < feature_count && r.IsValid(); ++i)
+    out->AddRequiredFeature(static_cast<Feature>(r.U32()));
+
+  uint32_t extension_count = r.U32();
+  for (uint32_t i = 0; i < extension_count && r.IsValid(); ++i)
+    out->AddRequiredExtension(r.Str());
+
+  uint32_t shader_count = r.U32();
+  for (uint32_t i = 0; i < shader_count && r.IsValid(); ++i) {
+    auto type = static_cast<ShaderType>(r.U8());
+    auto shader = MakeUnique<Shader>(type);
+    shader->SetFormat(static_cast<ShaderFormat>(r.U8()));
+    shader->SetName(r.Str());
+    shader->SetData(r.Str());
+
+    Result result = out->AddShader(std::move(shader));
+    if (!result.IsSuccess())
+      return result;
+  }
+
+  uint32_t buffer_count = r.U32();
+  for (uint32_t i = 0; i < buffer_count && r.IsValid(); ++i) {
+    Result result = out->AddBuffer(ReadBuffer(&r));
+    if (!result.IsSuccess())
+      return result;
+  }
+
+  uint32_t pipeline_count = r.U32();
+  for (uint32_t i = 0; i < pipeline_count && r.IsValid(); ++i) {
+    auto type = r.U8() == 0 ? PipelineType::kCompute : PipelineType::kGraphics;
+    auto pipeline = MakeUnique<Pipeline>(type);
+    pipeline->SetName(r.Str());
+    pipeline->SetFramebufferWidth(r.U32());
+    pipeline->SetFramebufferHeight(r.U32());
+
+    uint32_t info_count = r.U32();
+    for (uint32_t s = 0; s < info_count && r.IsValid(); ++s) {
+      uint32_t shader_idx = r.U32();
+      auto shader_type = static_cast<ShaderType>(r.U8());
+      std::string entry_point = r.Str();
+
+      std::vector<std::string> opts;
+      uint32_t opt_count = r.U32();
+      for (uint32_t o = 0; o < opt_count && r.IsValid(); ++o)
+        opts.push_back(r.Str());
+
+      if (shader_idx >= out->GetShaders().size())
+        return Result("serialized recipe has invalid shader reference");
+
+      const Shader* shader = out->GetShaders()[shader_idx].get();
+      Result result = pipeline->AddShader(shader, shader_type);
+      if (!result.IsSuccess())
+        return result;
+      if (entry_point != "main") {
+        result = pipeline->SetShaderEntryPoint(shader, entry_point);
+        if (!result.IsSuccess())
+          return result;
+      }
+      if (!opts.empty()) {
+        result = pipeline->SetShaderOptimizations(shader, opts);
+        if (!result.IsSuccess())
+          return result;
+      }
+    }
+
+    Result result = out->AddPipeline(std::move(pipeline));
+    if (!result.IsSuccess())
+      return result;
+  }
+
+  std::vector<std::unique_ptr<Command>> commands;
+  uint32_t command_count = r.U32();
+  for (uint32_t i = 0; i < command_count && r.IsValid(); ++i) {
+    auto cmd = ReadCommand(&r);
+    if (!cmd)
+      return Result("serialized recipe has unknown command type");
+    commands.push_back(std::move(cmd));
+  }
+  out->SetCommands(std::move(commands));
+
+  if (!r.IsValid() || !r.AtEnd())
+    return Result("serialized recipe is truncated or corrupt");
+
+  out->Finalize();
+  *script = std::move(out);
+  return {};
+}
+
+Result ScriptSerializer::SerializeCommand(Command* cmd,
+                                          std::vector<uint8_t>* out) {
+  ByteWriter w(out);
+  WriteCommand(&w, cmd);
+  return {};
+}
+
+Result ScriptSerializer::DeserializeCommand(const uint8_t* data,
+                                            size_t size,
+                                            size_t* consumed,
+                                            std::unique_ptr<Command>* cmd) {
+  ByteReader r(data, size);
+  auto c = ReadCommand(&r);
+  if (!c || !r.IsValid())
+    return Result("serialized command is unknown, truncated or corrupt");
+
+  *consumed = r.Offset();
+  *cmd = std::move(c);
+  return {};
+}
+
+Result ScriptSerializer::SerializeBuffer(Buffer* buffer,
+                                         std::vector<uint8_t>* out) {
+  ByteWriter w(out);
+  WriteBuffer(&w, buffer);
+  return {};
+}
+
+Result ScriptSerializer::DeserializeBuffer(const uint8_t* data,
+                                           size_t size,
+                                           size_t* consumed,
+                                           std::unique_ptr<Buffer>* buffer) {
+  ByteReader r(data, size);
+  auto b = ReadBuffer(&r);
+  if (!r.IsValid())
+    return Result("serialized buffer is truncated or corrupt");
+
+  *consumed = r.Offset();
+  *buffer = std::move(b);
+  return {};
+}
+
+}  // namespace amber
@@ -0,0 +1,68 @@
+// Copyright 2019 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_SCRIPT_SERIALIZER_H_
+#define SRC_SCRIPT_SERIALIZER_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "amber/result.h"
+#include "src/script.h"
+
+namespace amber {
+
+/// Converts parsed scripts to and from a versioned binary form so a corpus
+/// can be parsed once and reloaded with a single bulk read. The format is
+/// internal to Amber; blobs are only guaranteed to load with the same Amber
+/// version which produced them.
+class ScriptSerializer {
+ public:
+  /// Appends the serialized form of |script| to |out|.
+  static Result Serialize(const Script& script, std::vector<uint8_t>* out);
+
+  /// Reconstructs a script from |data| of |size| bytes previously produced
+  /// by Serialize(). On success |script| holds the new script.
+  static Result Deserialize(const uint8_t* data,
+                            size_t size,
+                            std::unique_ptr<Script>* script);
+
+  /// Appends the serialized form of the single |cmd| to |out|. Used by
+  /// the engine trace, which interleaves commands with records of its
+  /// own.
+  static Result SerializeCommand(Command* cmd, std::vector<uint8_t>* out);
+
+  /// Reconstructs one command from |data| of |size| bytes, setting
+  /// |*consumed| to the number of bytes its serialized form occupied so
+  /// a caller parsing a larger stream can resume after it.
+  static Result DeserializeCommand(const uint8_t* data,
+                                   size_t size,
+                                   size_t* consumed,
+                                   std::unique_ptr<Command>* cmd);
+
+  /// Appends the serialized form of the single |buffer| to |out|.
+  static Result SerializeBuffer(Buffer* buffer, std::vector<uint8_t>* out);
+
+  /// Reconstructs one buffer from |data| of |size| bytes, setting
+  /// |*consumed| like DeserializeCommand() does.
+  static Result DeserializeBuffer(const uint8_t* data,
+                                  size_t size,
+                                  size_t* consumed,
+                                  std::unique_ptr<Buffer>* buffer);
+};
+
+}  // namespace amber
+
+#endif  // SRC_SCRIPT_SERIALIZER_H_
@@ -0,0 +1,208 @@
+// Copyright 2019 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/script_serializer.h"
+
+#include <utility>
+
+#include "gtest/gtest.h"
+#include "src/make_unique.h"
+
+namespace amber {
+
+using ScriptSerializerTest = testing::Test;
+
+TEST_F(ScriptSerializerTest, RoundTripShadersAndPipelines) {
+  Script script;
+  script.GetEngineData().fence_timeout_ms = 12345;
+  script.AddRequiredFeature(Feature::kGeometryShader);
+  script.AddRequiredExtension("VK_KHR_storage_buffer_storage_class");
+
+  auto shader = MakeUnique<Shader>(kShaderTypeVertex);
+  shader->SetName("my_shader");
+  shader->SetFormat(kShaderFormatGlsl);
+  shader->SetData("shader source here");
+  script.AddShader(std::move(shader));
+
+  shader = MakeUnique<Shader>(kShaderTypeFragment);
+  shader->SetName("my_fragment");
+  shader->SetFormat(kShaderFormatSpirvAsm);
+  shader->SetData("fragment source");
+  script.AddShader(std::move(shader));
+
+  auto pipeline = MakeUnique<Pipeline>(PipelineType::kGraphics);
+  pipeline->SetName("my_pipeline");
+  pipeline->SetFramebufferWidth(512);
+  pipeline->SetFramebufferHeight(256);
+  const auto* vtex = script.GetShaders()[0].get();
+  ASSERT_TRUE(pipeline->AddShader(vtex, kShaderTypeVertex).IsSuccess());
+  ASSERT_TRUE(pipeline->SetShaderEntryPoint(vtex, "start").IsSuccess());
+  script.AddPipeline(std::move(pipeline));
+
+  std::vector<uint8_t> blob;
+  ASSERT_TRUE(ScriptSerializer::Serialize(script, &blob).IsSuccess());
+
+  std::unique_ptr<Script> loaded;
+  Result r = ScriptSerializer::Deserialize(blob.data(), blob.size(), &loaded);
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  EXPECT_EQ(12345U, loaded->GetEngineData().fence_timeout_ms);
+  ASSERT_EQ(1U, loaded->RequiredFeatures().size());
+  EXPECT_EQ(Feature::kGeometryShader, loaded->RequiredFeatures()[0]);
+  ASSERT_EQ(1U, loaded->RequiredExtensions().size());
+  EXPECT_EQ("VK_KHR_storage_buffer_storage_class",
+            loaded->RequiredExtensions()[0]);
+
+  ASSERT_EQ(2U, loaded->GetShaders().size());
+  const auto* s = loaded->GetShader("my_shader");
+  ASSERT_TRUE(s != nullptr);
+  EXPECT_EQ(kShaderTypeVertex, s->GetType());
+  EXPECT_EQ(kShaderFormatGlsl, s->GetFormat());
+  EXPECT_EQ("shader source here", s->GetData());
+
+  ASSERT_EQ(1U, loaded->GetPipelines().size());
+  const auto* p = loaded->GetPipeline("my_pipeline");
+  ASSERT_TRUE(p != nullptr);
+  EXPECT_EQ(PipelineType::kGraphics, p->GetType());
+  EXPECT_EQ(512U, p->GetFramebufferWidth());
+  EXPECT_EQ(256U, p->GetFramebufferHeight());
+  ASSERT_EQ(1U, p->GetShaders().size());
+  EXPECT_EQ("start", p->GetShaders()[0].GetEntryPoint());
+  EXPECT_EQ(loaded->GetShader("my_shader"), p->GetShaders()[0].GetShader());
+}
+
+TEST_F(ScriptSerializerTest, RoundTripBuffersAndCommands) {
+  Script script;
+
+  auto buffer = MakeUnique<DataBuffer>(BufferType::kStorage);
+  DatumType datum;
+  datum.SetType(DataType::kFloat);
+  datum.SetColumnCount(2);
+  datum.SetRowCount(2);
+  buffer->SetDatumType(datum);
+  buffer->SetName("my_buffer");
+  buffer->SetLocation(3);
+
+  std::vector<Value> values;
+  values.resize(4);
+  values[0].SetDoubleValue(1.0);
+  values[1].SetDoubleValue(2.5);
+  values[2].SetDoubleValue(-3.0);
+  values[3].SetDoubleValue(0.25);
+  buffer->SetData(std::move(values));
+  script.AddBuffer(std::move(buffer));
+
+  std::vector<std::unique_ptr<Command>> commands;
+  auto compute = MakeUnique<ComputeCommand>();
+  compute->SetLine(42);
+  compute->SetX(1);
+  compute->SetY(2);
+  compute->SetZ(3);
+  commands.push_back(std::move(compute));
+
+  auto probe = MakeUnique<ProbeCommand>();
+  probe->SetProbeRect();
+  probe->SetIsRGBA();
+  probe->SetX(5.f);
+  probe->SetY(6.f);
+  probe->SetWidth(7.f);
+  probe->SetHeight(8.f);
+  probe->SetR(0.5f);
+  probe->SetG(0.25f);
+  probe->SetB(0.75f);
+  probe->SetA(1.f);
+  probe->SetTolerances({{true, 1.5}, {false, 2.0}});
+  commands.push_back(std::move(probe));
+
+  auto ssbo = MakeUnique<BufferCommand>(BufferCommand::BufferType::kSSBO);
+  ssbo->SetBinding(5);
+  ssbo->SetDatumType(datum);
+  std::vector<Value> ssbo_values;
+  ssbo_values.resize(4);
+  ssbo_values[0].SetDoubleValue(1.0);
+  ssbo_values[1].SetDoubleValue(2.0);
+  ssbo_values[2].SetDoubleValue(3.0);
+  ssbo_values[3].SetDoubleValue(4.0);
+  ssbo->SetValues(std::move(ssbo_values));
+  commands.push_back(std::move(ssbo));
+
+  script.SetCommands(std::move(commands));
+
+  std::vector<uint8_t> blob;
+  ASSERT_TRUE(ScriptSerializer::Serialize(script, &blob).IsSuccess());
+
+  std::unique_ptr<Script> loaded;
+  Result r = ScriptSerializer::Deserialize(blob.data(), blob.size(), &loaded);
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  const auto* buf = loaded->GetBuffer("my_buffer");
+  ASSERT_TRUE(buf != nullptr);
+  ASSERT_TRUE(buf->IsDataBuffer());
+  EXPECT_EQ(BufferType::kStorage, buf->GetBufferType());
+  EXPECT_EQ(3U, buf->GetLocation());
+  EXPECT_EQ(1U, buf->GetSize());
+  ASSERT_EQ(4U, buf->GetData().size());
+  EXPECT_DOUBLE_EQ(2.5, buf->GetData()[1].AsDouble());
+
+  ASSERT_EQ(3U, loaded->GetCommands().size());
+
+  auto* cmd = loaded->GetCommands()[0].get();
+  ASSERT_TRUE(cmd->IsCompute());
+  EXPECT_EQ(42U, cmd->GetLine());
+  EXPECT_EQ(1U, cmd->AsCompute()->GetX());
+  EXPECT_EQ(2U, cmd->AsCompute()->GetY());
+  EXPECT_EQ(3U, cmd->AsCompute()->GetZ());
+
+  cmd = loaded->GetCommands()[1].get();
+  ASSERT_TRUE(cmd->IsProbe());
+  auto* p = cmd->AsProbe();
+  EXPECT_TRUE(p->IsProbeRect());
+  EXPECT_TRUE(p->IsRGBA());
+  EXPECT_FALSE(p->IsWholeWindow());
+  EXPECT_FLOAT_EQ(7.f, p->GetWidth());
+  EXPECT_FLOAT_EQ(0.25f, p->GetG());
+  ASSERT_EQ(2U, p->GetTolerances().size());
+  EXPECT_TRUE(p->GetTolerances()[0].is_percent);
+  EXPECT_DOUBLE_EQ(2.0, p->GetTolerances()[1].value);
+
+  cmd = loaded->GetCommands()[2].get();
+  ASSERT_TRUE(cmd->IsBuffer());
+  auto* b = cmd->AsBuffer();
+  EXPECT_TRUE(b->IsSSBO());
+  EXPECT_EQ(5U, b->GetBinding());
+  ASSERT_EQ(4U, b->GetValues().size());
+  EXPECT_DOUBLE_EQ(4.0, b->GetValues()[3].AsDouble());
+}
+
+TEST_F(ScriptSerializerTest, RejectsCorruptData) {
+  Script script;
+  std::vector<uint8_t> blob;
+  ASSERT_TRUE(ScriptSerializer::Serialize(script, &blob).IsSuccess());
+
+  std::unique_ptr<Script> loaded;
+
+  // Bad magic.
+  std::vector<uint8_t> bad = blob;
+  bad[0] = 'X';
+  EXPECT_FALSE(
+      ScriptSerializer::Deserialize(bad.data(), bad.size(), &loaded)
+          .IsSuccess());
+
+  // Truncated.
+  EXPECT_FALSE(
+      ScriptSerializer::Deserialize(blob.data(), blob.size() - 1, &loaded)
+          .IsSuccess());
+}
+
+}  // namespace amber
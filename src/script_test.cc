@@ -48,7 +48,10 @@ TEST_F(ScriptTest, GetShaderInfo) {
   shader->SetData("More shader data");
   sp.AddShader(std::move(shader));
 
-  auto info = sp.GetShaderInfo();
+  // The shader info cache is built when parsing finishes.
+  sp.Finalize();
+
+  const auto& info = sp.GetShaderInfo();
   ASSERT_EQ(2U, info.size());
 
   EXPECT_EQ("Shader1", info[0].shader_name);
@@ -66,7 +69,9 @@ TEST_F(ScriptTest, GetShaderInfo) {
 
 TEST_F(ScriptTest, GetShaderInfoNoShaders) {
   ScriptProxy sp;
-  auto info = sp.GetShaderInfo();
+  sp.Finalize();
+
+  const auto& info = sp.GetShaderInfo();
   EXPECT_TRUE(info.empty());
 }
 
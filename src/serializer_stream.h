@@ -0,0 +1,154 @@
+// Copyright 2019 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_SERIALIZER_STREAM_H_
+#define SRC_SERIALIZER_STREAM_H_
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace amber {
+
+/// Appends little-endian encoded primitives to a byte vector. Shared by
+/// the recipe serializer and the engine trace writer so both binary
+/// formats agree on their encoding.
+class ByteWriter {
+ public:
+  explicit ByteWriter(std::vector<uint8_t>* out) : out_(out) {}
+
+  void U8(uint8_t v) { out_->push_back(v); }
+
+  void U32(uint32_t v) {
+    for (int i = 0; i < 4; ++i)
+      out_->push_back(static_cast<uint8_t>(v >> (i * 8)));
+  }
+
+  void U64(uint64_t v) {
+    for (int i = 0; i < 8; ++i)
+      out_->push_back(static_cast<uint8_t>(v >> (i * 8)));
+  }
+
+  void F32(float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    U32(bits);
+  }
+
+  void F64(double v) {
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    U64(bits);
+  }
+
+  void Bool(bool v) { U8(v ? 1 : 0); }
+
+  void Str(const std::string& s) {
+    U32(static_cast<uint32_t>(s.size()));
+    out_->insert(out_->end(), s.begin(), s.end());
+  }
+
+ private:
+  std::vector<uint8_t>* out_;
+};
+
+/// Reads little-endian encoded primitives out of a byte buffer. All reads
+/// are bounds checked; once a read fails every later read fails too so
+/// callers only need to check at convenient points.
+class ByteReader {
+ public:
+  ByteReader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+  bool IsValid() const { return valid_; }
+
+  uint8_t U8() {
+    if (!Require(1))
+      return 0;
+    return data_[pos_++];
+  }
+
+  uint32_t U32() {
+    if (!Require(4))
+      return 0;
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i)
+      v |= static_cast<uint32_t>(data_[pos_++]) << (i * 8);
+    return v;
+  }
+
+  uint64_t U64() {
+    if (!Require(8))
+      return 0;
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i)
+      v |= static_cast<uint64_t>(data_[pos_++]) << (i * 8);
+    return v;
+  }
+
+  float F32() {
+    uint32_t bits = U32();
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+  }
+
+  double F64() {
+    uint64_t bits = U64();
+    double v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+  }
+
+  bool Bool() { return U8() != 0; }
+
+  std::string Str() {
+    uint32_t len = U32();
+    if (!Require(len))
+      return {};
+    std::string s(reinterpret_cast<const char*>(data_ + pos_), len);
+    pos_ += len;
+    return s;
+  }
+
+  bool AtEnd() const { return pos_ == size_; }
+
+  /// How many bytes have been consumed so far. Lets a caller parsing a
+  /// larger stream resume after an embedded object.
+  size_t Offset() const { return pos_; }
+
+  /// Advances past |count| bytes another parser already consumed.
+  void Skip(size_t count) {
+    if (Require(count))
+      pos_ += count;
+  }
+
+ private:
+  bool Require(size_t count) {
+    if (!valid_ || size_ - pos_ < count) {
+      valid_ = false;
+      return false;
+    }
+    return true;
+  }
+
+  const uint8_t* data_;
+  size_t size_;
+  size_t pos_ = 0;
+  bool valid_ = true;
+};
+
+}  // namespace amber
+
+#endif  // SRC_SERIALIZER_STREAM_H_
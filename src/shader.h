@@ -15,7 +15,11 @@
 #ifndef SRC_SHADER_H_
 #define SRC_SHADER_H_
 
+#include <cstdint>
+#include <mutex>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "amber/shader_info.h"
 
@@ -36,14 +40,38 @@ class Shader {
   void SetFormat(ShaderFormat fmt) { shader_format_ = fmt; }
   ShaderFormat GetFormat() const { return shader_format_; }
 
-  void SetData(const std::string& data) { data_ = data; }
+  void SetData(const std::string& data) {
+    data_ = data;
+    std::lock_guard<std::mutex> guard(compiled_binary_mutex_);
+    compiled_binary_.clear();
+  }
   const std::string& GetData() const { return data_; }
 
+  /// Caches the binary produced when this shader was first compiled so
+  /// executing the same recipe again skips the compile entirely. The
+  /// cache is guarded by a mutex because a script may be executed from
+  /// several threads at once; two of them can both miss and compile, in
+  /// which case the later store overwrites an identical binary.
+  void SetCompiledBinary(std::vector<uint32_t> data) {
+    std::lock_guard<std::mutex> guard(compiled_binary_mutex_);
+    compiled_binary_ = std::move(data);
+  }
+  std::vector<uint32_t> GetCompiledBinary() const {
+    std::lock_guard<std::mutex> guard(compiled_binary_mutex_);
+    return compiled_binary_;
+  }
+  bool HasCompiledBinary() const {
+    std::lock_guard<std::mutex> guard(compiled_binary_mutex_);
+    return !compiled_binary_.empty();
+  }
+
  private:
   ShaderType shader_type_;
   ShaderFormat shader_format_;
   std::string data_;
   std::string name_;
+  mutable std::mutex compiled_binary_mutex_;
+  std::vector<uint32_t> compiled_binary_;
 };
 
 }  // namespace amber
@@ -15,14 +15,20 @@
 #include "src/shader_compiler.h"
 
 #include <algorithm>
+#include <cctype>
+#include <cstdio>
 #include <cstdlib>
+#include <fstream>
 #include <iterator>
 #include <string>
 #include <utility>
 
+#include "src/profiler.h"
+
 #if AMBER_ENABLE_SPIRV_TOOLS
 #include "spirv-tools/libspirv.hpp"
 #include "spirv-tools/linker.hpp"
+#include "spirv-tools/optimizer.hpp"
 #endif  // AMBER_ENABLE_SPIRV_TOOLS
 
 #if AMBER_ENABLE_SHADERC
@@ -35,25 +41,109 @@
 #endif  // AMBER_ENABLE_SHADERC
 
 namespace amber {
+namespace {
+
+// FNV-1a; collisions only risk a stale cache entry, and the blob written by
+// a different source would still be valid SPIR-V from a prior compile.
+// |optimize| is part of the key so optimized and unoptimized binaries of
+// one shader never overwrite each other.
+uint64_t HashShader(const Shader* shader, bool optimize) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  auto mix = [&hash](uint8_t byte) {
+    hash ^= byte;
+    hash *= 0x100000001b3ULL;
+  };
+  for (char c : shader->GetData())
+    mix(static_cast<uint8_t>(c));
+  mix(static_cast<uint8_t>(shader->GetType()));
+  mix(static_cast<uint8_t>(shader->GetFormat()));
+  mix(optimize ? 1 : 0);
+  return hash;
+}
+
+// Loads the binary at |path| into |result|. Returns false when the file is
+// missing or not a whole number of SPIR-V words.
+bool LoadCachedBinary(const std::string& path, std::vector<uint32_t>* result) {
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file.is_open())
+    return false;
+
+  auto size = static_cast<size_t>(file.tellg());
+  if (size == 0 || (size % sizeof(uint32_t)) != 0)
+    return false;
+
+  result->resize(size / sizeof(uint32_t));
+  file.seekg(0);
+  file.read(reinterpret_cast<char*>(result->data()),
+            static_cast<std::streamsize>(size));
+  if (!file) {
+    result->clear();
+    return false;
+  }
+  return true;
+}
+
+// Best effort; a failed write just means the shader compiles again next run.
+void StoreCachedBinary(const std::string& path,
+                       const std::vector<uint32_t>& data) {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file.is_open())
+    return;
+  file.write(reinterpret_cast<const char*>(data.data()),
+             static_cast<std::streamsize>(data.size() * sizeof(uint32_t)));
+}
+
+}  // namespace
 
 ShaderCompiler::ShaderCompiler() = default;
 
+ShaderCompiler::ShaderCompiler(const std::string& cache_dir, bool optimize)
+    : cache_dir_(cache_dir), optimize_(optimize) {}
+
 ShaderCompiler::~ShaderCompiler() = default;
 
+std::string ShaderCompiler::CacheFilePath(const Shader* shader) const {
+  char name[24];
+  snprintf(name, sizeof(name), "%016llx.spv",
+           static_cast<unsigned long long>(HashShader(shader, optimize_)));
+  return cache_dir_ + "/" + name;
+}
+
 std::pair<Result, std::vector<uint32_t>> ShaderCompiler::Compile(
     Shader* shader,
     const ShaderMap& shader_map) const {
+  ScopedPhaseTimer timer("ShaderCompiler::Compile");
+
   auto it = shader_map.find(shader->GetName());
   if (it != shader_map.end())
     return {{}, it->second};
 
+  // Repeated executions of one recipe hit the binary cached on the shader.
+  std::vector<uint32_t> previously_compiled = shader->GetCompiledBinary();
+  if (!previously_compiled.empty())
+    return {{}, std::move(previously_compiled)};
+
+  std::string cache_path;
+  if (!cache_dir_.empty()) {
+    cache_path = CacheFilePath(shader);
+
+    std::vector<uint32_t> cached;
+    if (LoadCachedBinary(cache_path, &cached)) {
+      shader->SetCompiledBinary(cached);
+      return {{}, std::move(cached)};
+    }
+  }
+
 #if AMBER_ENABLE_SPIRV_TOOLS
   std::string spv_errors;
   // TODO(dsinclair): Vulkan env should be an option.
-  spvtools::SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
-  tools.SetMessageConsumer([&spv_errors](spv_message_level_t level, const char*,
-                                         const spv_position_t& position,
-                                         const char* message) {
+  // Creating a spirv-tools context is not free; keep one per thread for the
+  // life of the process. The message consumer is rebound on every compile so
+  // errors still land in this call's |spv_errors|.
+  thread_local spvtools::SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
+  auto message_consumer = [&spv_errors](spv_message_level_t level, const char*,
+                                        const spv_position_t& position,
+                                        const char* message) {
     switch (level) {
       case SPV_MSG_FATAL:
       case SPV_MSG_INTERNAL_ERROR:
@@ -72,7 +162,8 @@ std::pair<Result, std::vector<uint32_t>> ShaderCompiler::Compile(
       case SPV_MSG_DEBUG:
         break;
     }
-  });
+  };
+  tools.SetMessageConsumer(message_consumer);
 #endif  // AMBER_ENABLE_SPIRV_TOOLS
 
   std::vector<uint32_t> results;
@@ -105,20 +196,89 @@ std::pair<Result, std::vector<uint32_t>> ShaderCompiler::Compile(
   spvtools::ValidatorOptions options;
   if (!tools.Validate(results.data(), results.size(), options))
     return {Result("Invalid shader: " + spv_errors), {}};
+
+  if (optimize_) {
+    // Driver pipeline-compile time scales with module size, and glslang
+    // output in particular carries a lot of dead weight. The optimized
+    // form is what gets cached below, so a warm cache skips both the
+    // compile and this pass.
+    spvtools::Optimizer optimizer(SPV_ENV_UNIVERSAL_1_0);
+    optimizer.SetMessageConsumer(message_consumer);
+    optimizer.RegisterPerformancePasses();
+
+    std::vector<uint32_t> optimized;
+    if (!optimizer.Run(results.data(), results.size(), &optimized))
+      return {Result("Shader optimization failed: " + spv_errors), {}};
+    results = std::move(optimized);
+  }
 #endif  // AMBER_ENABLE_SPIRV_TOOLS
 
-  return {{}, results};
+  if (!cache_path.empty())
+    StoreCachedBinary(cache_path, results);
+
+  shader->SetCompiledBinary(results);
+  return {{}, std::move(results)};
 }
 
 Result ShaderCompiler::ParseHex(const std::string& data,
                                 std::vector<uint32_t>* result) const {
-  size_t used = 0;
+  // Value of each character as a hex digit, -1 for non-digits. Decoding
+  // through the table instead of strtol avoids relocking locale state per
+  // token, which dominated for multi-megabyte hex blobs.
+  static const int8_t kHexValue[256] = {
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  //
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  //
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  //
+      0,  1,  2,  3,  4,  5,  6,  7,  8,  9,  -1, -1, -1, -1, -1, -1,  //
+      -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,  //
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  //
+      -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,  //
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  //
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  //
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  //
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  //
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  //
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  //
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  //
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  //
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1};
+
+  // A compact blob is three characters per byte, so this slightly over
+  // reserves for the common "0x" prefixed form and never re-allocates.
+  result->reserve(result->size() + data.length() / 12 + 1);
+
   const char* str = data.c_str();
+  const char* end = str + data.length();
   uint8_t converted = 0;
   uint32_t tmp = 0;
-  while (used < data.length()) {
-    char* new_pos = nullptr;
-    uint64_t v = static_cast<uint64_t>(std::strtol(str, &new_pos, 16));
+  while (str < end) {
+    while (str < end && std::isspace(static_cast<unsigned char>(*str)))
+      ++str;
+
+    bool negate = false;
+    if (str < end && (*str == '+' || *str == '-')) {
+      negate = *str == '-';
+      ++str;
+    }
+    if (end - str > 2 && str[0] == '0' && (str[1] == 'x' || str[1] == 'X') &&
+        kHexValue[static_cast<uint8_t>(str[2])] >= 0) {
+      str += 2;
+    }
+
+    const char* digits = str;
+    uint64_t v = 0;
+    while (str < end) {
+      int8_t digit = kHexValue[static_cast<uint8_t>(*str)];
+      if (digit < 0)
+        break;
+      v = (v << 4) | static_cast<uint64_t>(digit);
+      ++str;
+    }
+    // Nothing decodable remains; strtol would have spun here forever.
+    if (str == digits)
+      break;
+    if (negate)
+      v = 0 - v;
 
     ++converted;
 
@@ -129,9 +289,6 @@ Result ShaderCompiler::ParseHex(const std::string& data,
       tmp = 0;
       converted = 0;
     }
-
-    used += static_cast<size_t>(new_pos - str);
-    str = new_pos;
   }
   return {};
 }
@@ -139,7 +296,10 @@ Result ShaderCompiler::ParseHex(const std::string& data,
 #if AMBER_ENABLE_SHADERC
 Result ShaderCompiler::CompileGlsl(Shader* shader,
                                    std::vector<uint32_t>* result) const {
-  shaderc::Compiler compiler;
+  // Constructing a shaderc compiler initializes glslang, which is far more
+  // expensive than most compiles. Keep one for the lifetime of the process;
+  // shaderc documents concurrent Compile* calls on one compiler as safe.
+  static shaderc::Compiler compiler;
   shaderc::CompileOptions options;
 
   shaderc_shader_kind kind;
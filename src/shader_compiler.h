@@ -28,15 +28,29 @@ namespace amber {
 class ShaderCompiler {
  public:
   ShaderCompiler();
+  /// Creates a compiler which caches compiled binaries in |cache_dir|. An
+  /// empty directory name disables the cache. When |optimize| is set the
+  /// compiled SPIR-V is run through spirv-opt's performance passes before
+  /// it is cached or returned.
+  explicit ShaderCompiler(const std::string& cache_dir, bool optimize = false);
   ~ShaderCompiler();
 
   std::pair<Result, std::vector<uint32_t>> Compile(
       Shader* shader,
       const ShaderMap& shader_map) const;
 
+  Result ParseHexForTesting(const std::string& data,
+                            std::vector<uint32_t>* result) const {
+    return ParseHex(data, result);
+  }
+
  private:
   Result ParseHex(const std::string& data, std::vector<uint32_t>* result) const;
   Result CompileGlsl(Shader* shader, std::vector<uint32_t>* result) const;
+  std::string CacheFilePath(const Shader* shader) const;
+
+  std::string cache_dir_;
+  bool optimize_ = false;
 };
 
 }  // namespace amber
@@ -0,0 +1,53 @@
+// Copyright 2018 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "src/shader_compiler.h"
+
+namespace amber {
+namespace {
+
+void BM_ShaderCompilerParseHex(benchmark::State& state) {
+  // A hex shader blob in the "0x" prefixed form the parser sees most,
+  // eight words per line. The word values do not matter to ParseHex().
+  std::string data;
+  data.reserve(64 * 1024 * 11);
+  for (uint32_t i = 0; i < 64 * 1024; ++i) {
+    char word[16];
+    snprintf(word, sizeof(word), "0x%08x", i * 2654435761u);
+    data += word;
+    data += (i % 8 == 7) ? '\n' : ' ';
+  }
+
+  ShaderCompiler sc;
+  for (auto _ : state) {
+    std::vector<uint32_t> words;
+    Result r = sc.ParseHexForTesting(data, &words);
+    if (!r.IsSuccess()) {
+      state.SkipWithError(r.Error().c_str());
+      break;
+    }
+    benchmark::DoNotOptimize(words.data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(data.size()));
+}
+BENCHMARK(BM_ShaderCompilerParseHex);
+
+}  // namespace
+}  // namespace amber
@@ -0,0 +1,62 @@
+// Copyright 2018 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_STRING_INTERNER_H_
+#define SRC_STRING_INTERNER_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+namespace amber {
+
+/// Hash-conses strings into dense integer ids. Registries keyed by name
+/// store the id instead of the string, so a name is hashed once at the
+/// interner and everything after that hashes and compares integers
+/// instead of allocating string copies.
+class StringInterner {
+ public:
+  /// Id returned by Find() for strings that were never interned. An
+  /// enumerator rather than a static member so the header stays
+  /// definition free.
+  enum : uint32_t { kInvalidId = 0xffffffffu };
+
+  /// Returns the id of |str|, assigning the next unused id when the
+  /// string is seen for the first time.
+  uint32_t Intern(const std::string& str) {
+    auto it = ids_.find(str);
+    if (it != ids_.end())
+      return it->second;
+
+    uint32_t id = static_cast<uint32_t>(ids_.size());
+    ids_.emplace(str, id);
+    return id;
+  }
+
+  /// Returns the id of |str|, kInvalidId when it was never interned.
+  uint32_t Find(const std::string& str) const {
+    auto it = ids_.find(str);
+    return it == ids_.end() ? kInvalidId : it->second;
+  }
+
+  /// Number of distinct strings interned so far.
+  size_t GetCount() const { return ids_.size(); }
+
+ private:
+  std::unordered_map<std::string, uint32_t> ids_;
+};
+
+}  // namespace amber
+
+#endif  // SRC_STRING_INTERNER_H_
@@ -0,0 +1,50 @@
+// Copyright 2018 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/string_interner.h"
+
+#include "gtest/gtest.h"
+
+namespace amber {
+
+using StringInternerTest = testing::Test;
+
+TEST_F(StringInternerTest, AssignsDenseIds) {
+  StringInterner interner;
+  EXPECT_EQ(0u, interner.Intern("first"));
+  EXPECT_EQ(1u, interner.Intern("second"));
+  EXPECT_EQ(2u, interner.Intern("third"));
+  EXPECT_EQ(3u, interner.GetCount());
+}
+
+TEST_F(StringInternerTest, InternIsIdempotent) {
+  StringInterner interner;
+  uint32_t id = interner.Intern("name");
+  EXPECT_EQ(id, interner.Intern("name"));
+  EXPECT_EQ(1u, interner.GetCount());
+}
+
+TEST_F(StringInternerTest, FindReturnsInternedId) {
+  StringInterner interner;
+  uint32_t id = interner.Intern("name");
+  EXPECT_EQ(id, interner.Find("name"));
+}
+
+TEST_F(StringInternerTest, FindMissingReturnsInvalidId) {
+  StringInterner interner;
+  interner.Intern("name");
+  EXPECT_EQ(StringInterner::kInvalidId, interner.Find("other"));
+}
+
+}  // namespace amber
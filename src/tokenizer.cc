@@ -14,14 +14,166 @@
 
 #include "src/tokenizer.h"
 
+#include <algorithm>
 #include <cctype>
 #include <cstdlib>
+#include <cstring>
 #include <limits>
+#include <new>
 #include <sstream>
 
-#include "src/make_unique.h"
+#include "src/huge_alloc.h"
 
 namespace amber {
+namespace {
+
+const uint64_t kLowBits = 0x7f7f7f7f7f7f7f7full;
+const uint64_t kHighBits = 0x8080808080808080ull;
+
+// Replicates |b| into every byte of a word.
+uint64_t BroadcastByte(uint8_t b) {
+  return 0x0101010101010101ull * b;
+}
+
+// Returns a word with the high bit set in each byte of |v| which equals the
+// byte replicated through |pattern|, and zero in every other bit. The test is
+// exact for all byte values.
+uint64_t BytesEqualMask(uint64_t v, uint64_t pattern) {
+  uint64_t x = v ^ pattern;
+  return ~(((x & kLowBits) + kLowBits) | x | kLowBits);
+}
+
+// Parses the plain decimal literal [-|+]digits[.digits] filling all of
+// |data[0, len)| into |out|, returning false when the text is anything
+// else (exponents, hex, trailing characters) or needs more precision
+// than the fast path guarantees. This is the classic Clinger fast
+// path: a mantissa below 2^53 and a power of ten up to 10^22 are both
+// exact in a double, so one integer accumulation and one divide give
+// the same correctly rounded result as strtod without its locale
+// machinery. Data heavy vertex sections are made of exactly such
+// literals.
+bool FastParseDouble(const char* data, size_t len, double* out) {
+  size_t i = 0;
+  bool negative = false;
+  if (len > 0 && (data[0] == '-' || data[0] == '+')) {
+    negative = data[0] == '-';
+    i = 1;
+  }
+
+  uint64_t mantissa = 0;
+  uint32_t digit_count = 0;
+  uint32_t frac_digit_count = 0;
+  bool seen_dot = false;
+  for (; i < len; ++i) {
+    const char ch = data[i];
+    if (ch >= '0' && ch <= '9') {
+      mantissa = mantissa * 10 + static_cast<uint64_t>(ch - '0');
+      ++digit_count;
+      if (seen_dot)
+        ++frac_digit_count;
+    } else if (ch == '.' && !seen_dot) {
+      seen_dot = true;
+    } else {
+      return false;
+    }
+  }
+
+  // Nineteen digits always fit a uint64, so the accumulation above
+  // cannot have wrapped; the mantissa and power-of-ten limits keep both
+  // divide operands exact.
+  if (digit_count == 0 || digit_count > 19 || frac_digit_count > 22 ||
+      mantissa >= (1ULL << 53U)) {
+    return false;
+  }
+
+  static const double kPowersOfTen[] = {
+      1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+  const double value =
+      static_cast<double>(mantissa) / kPowersOfTen[frac_digit_count];
+  *out = negative ? -value : value;
+  return true;
+}
+
+// Classifies the dispatch keywords of both script dialects. Called once
+// per string token; the first character narrows the candidates so a
+// non-keyword costs at most one length check and memcmp.
+KeywordType ClassifyKeyword(const char* data, size_t len) {
+  auto matches = [data, len](const char* word, size_t word_len) {
+    return len == word_len && std::memcmp(data, word, word_len) == 0;
+  };
+
+  switch (data[0]) {
+    case 'a':
+      if (matches("arrays", 6))
+        return KeywordType::kArrays;
+      break;
+    case 'c':
+      if (matches("clear", 5))
+        return KeywordType::kClear;
+      if (matches("compute", 7))
+        return KeywordType::kCompute;
+      break;
+    case 'd':
+      if (matches("draw", 4))
+        return KeywordType::kDraw;
+      break;
+    case 'f':
+      if (matches("fragment", 8))
+        return KeywordType::kFragment;
+      break;
+    case 'g':
+      if (matches("geometry", 8))
+        return KeywordType::kGeometry;
+      break;
+    case 'p':
+      if (matches("probe", 5))
+        return KeywordType::kProbe;
+      if (matches("patch", 5))
+        return KeywordType::kPatch;
+      break;
+    case 'r':
+      if (matches("rect", 4))
+        return KeywordType::kRect;
+      if (matches("relative", 8))
+        return KeywordType::kRelative;
+      break;
+    case 's':
+      if (matches("ssbo", 4))
+        return KeywordType::kSsbo;
+      break;
+    case 't':
+      if (matches("tolerance", 9))
+        return KeywordType::kTolerance;
+      if (matches("tessellation", 12))
+        return KeywordType::kTessellation;
+      break;
+    case 'u':
+      if (matches("uniform", 7))
+        return KeywordType::kUniform;
+      break;
+    case 'v':
+      if (matches("vertex", 6))
+        return KeywordType::kVertex;
+      break;
+    case 'B':
+      if (matches("BUFFER", 6))
+        return KeywordType::kBuffer;
+      break;
+    case 'P':
+      if (matches("PIPELINE", 8))
+        return KeywordType::kPipeline;
+      break;
+    case 'S':
+      if (matches("SHADER", 6))
+        return KeywordType::kShader;
+      break;
+  }
+  return KeywordType::kUnknown;
+}
+
+}  // namespace
 
 Token::Token(TokenType type) : type_(type) {}
 
@@ -46,47 +198,76 @@ Result Token::ConvertToDouble() {
     uint_value_ = 0;
   } else if (IsHex()) {
     double_value_ = static_cast<double>(AsHex());
+    string_data_ = nullptr;
+    string_len_ = 0;
     string_value_ = "";
   }
   type_ = TokenType::kDouble;
   return {};
 }
 
-Tokenizer::Tokenizer(const std::string& data) : data_(data) {}
+TokenArena::TokenArena() = default;
+
+TokenArena::~TokenArena() {
+  for (size_t i = 0; i < slabs_.size(); ++i) {
+    size_t count =
+        i + 1 == slabs_.size() ? used_in_last_slab_ : kTokensPerSlab;
+    Token* tokens = reinterpret_cast<Token*>(slabs_[i]);
+    for (size_t t = 0; t < count; ++t)
+      tokens[t].~Token();
+    FreeHostBlock(slabs_[i], kTokensPerSlab * sizeof(Token));
+  }
+}
+
+Token* TokenArena::Create(TokenType type) {
+  if (used_in_last_slab_ == kTokensPerSlab) {
+    slabs_.push_back(
+        static_cast<uint8_t*>(AllocHostBlock(kTokensPerSlab * sizeof(Token))));
+    used_in_last_slab_ = 0;
+  }
+  Token* tokens = reinterpret_cast<Token*>(slabs_.back());
+  return new (&tokens[used_in_last_slab_++]) Token(type);
+}
+
+Tokenizer::Tokenizer(const std::string& data)
+    : owned_data_(data), data_(owned_data_.c_str()), size_(owned_data_.size()) {
+}
+
+Tokenizer::Tokenizer(const char* data, size_t size)
+    : data_(data), size_(size) {}
 
 Tokenizer::~Tokenizer() = default;
 
-std::unique_ptr<Token> Tokenizer::NextToken() {
+Token* Tokenizer::NextToken() {
   SkipWhitespace();
-  if (current_position_ >= data_.length())
-    return MakeUnique<Token>(TokenType::kEOS);
+  if (current_position_ >= size_)
+    return arena_.Create(TokenType::kEOS);
 
   if (data_[current_position_] == '#') {
     SkipComment();
     SkipWhitespace();
   }
-  if (current_position_ >= data_.length())
-    return MakeUnique<Token>(TokenType::kEOS);
+  if (current_position_ >= size_)
+    return arena_.Create(TokenType::kEOS);
 
   if (data_[current_position_] == '\n') {
     ++current_line_;
     ++current_position_;
-    return MakeUnique<Token>(TokenType::kEOL);
+    return arena_.Create(TokenType::kEOL);
   }
 
   // If the current position is a , ( or ) then handle it specially as we don't
   // want to consume any other characters.
   if (data_[current_position_] == ',' || data_[current_position_] == '(' ||
       data_[current_position_] == ')') {
-    auto tok = MakeUnique<Token>(TokenType::kString);
-    std::string str(1, data_[current_position_]);
-    tok->SetStringValue(str);
+    auto tok = arena_.Create(TokenType::kString);
+    tok->SetStringView(data_ + current_position_, 1);
     ++current_position_;
     return tok;
   }
 
   size_t end_pos = current_position_;
-  while (end_pos < data_.length()) {
+  while (end_pos < size_) {
     if (data_[end_pos] == ' ' || data_[end_pos] == '\n' ||
         data_[end_pos] == ')' || data_[end_pos] == ',' ||
         data_[end_pos] == '(') {
@@ -95,23 +276,25 @@ std::unique_ptr<Token> Tokenizer::NextToken() {
     ++end_pos;
   }
 
-  std::string tok_str =
-      data_.substr(current_position_, end_pos - current_position_);
+  // View into |data_| for the token text; no copy is made. Reading one past
+  // the end of the view is safe as |data_| belongs to a null terminated
+  // buffer.
+  const char* tok_data = data_ + current_position_;
+  size_t tok_len = end_pos - current_position_;
   current_position_ = end_pos;
 
   // Starts with an alpha is a string.
-  if (!std::isdigit(tok_str[0]) &&
-      !(tok_str[0] == '-' && std::isdigit(tok_str[1])) &&
-      !(tok_str[0] == '.' && std::isdigit(tok_str[1]))) {
+  if (!std::isdigit(tok_data[0]) &&
+      !(tok_data[0] == '-' && std::isdigit(tok_data[1])) &&
+      !(tok_data[0] == '.' && std::isdigit(tok_data[1]))) {
     // If we've got a continuation, skip over the end of line and get the next
     // token.
-    if (tok_str == "\\") {
-      if ((current_position_ < data_.length() &&
-           data_[current_position_] == '\n')) {
+    if (tok_len == 1 && tok_data[0] == '\\') {
+      if ((current_position_ < size_ && data_[current_position_] == '\n')) {
         ++current_line_;
         ++current_position_;
         return NextToken();
-      } else if (current_position_ + 1 < data_.length() &&
+      } else if (current_position_ + 1 < size_ &&
                  data_[current_position_] == '\r' &&
                  data_[current_position_ + 1] == '\n') {
         ++current_line_;
@@ -120,64 +303,136 @@ std::unique_ptr<Token> Tokenizer::NextToken() {
       }
     }
 
-    auto tok = MakeUnique<Token>(TokenType::kString);
-    tok->SetStringValue(tok_str);
+    auto tok = arena_.Create(TokenType::kString);
+    tok->SetStringView(tok_data, tok_len);
+    tok->SetKeyword(ClassifyKeyword(tok_data, tok_len));
     return tok;
   }
 
   // Handle hex strings
-  if (tok_str.size() > 2 && tok_str[0] == '0' && tok_str[1] == 'x') {
-    auto tok = MakeUnique<Token>(TokenType::kHex);
-    tok->SetStringValue(tok_str);
+  if (tok_len > 2 && tok_data[0] == '0' && tok_data[1] == 'x') {
+    auto tok = arena_.Create(TokenType::kHex);
+    tok->SetStringView(tok_data, tok_len);
     return tok;
   }
 
   bool is_double = false;
-  for (const char ch : tok_str) {
-    if (ch == '.') {
+  for (size_t i = 0; i < tok_len; ++i) {
+    if (tok_data[i] == '.') {
       is_double = true;
       break;
     }
   }
 
-  std::unique_ptr<Token> tok;
+  Token* tok = nullptr;
 
+  // The characters which end a token all stop strtod and strtoull, so we can
+  // parse in place from |data_| without copying out the token text first.
   char* final_pos = nullptr;
   if (is_double) {
-    tok = MakeUnique<Token>(TokenType::kDouble);
+    tok = arena_.Create(TokenType::kDouble);
 
-    double val = strtod(tok_str.c_str(), &final_pos);
+    // Plain decimal literals, the overwhelming majority, take the fast
+    // parser; exponents and oversized mantissas fall back to strtod.
+    double val;
+    if (FastParseDouble(tok_data, tok_len, &val)) {
+      final_pos = const_cast<char*>(tok_data) + tok_len;
+    } else {
+      val = strtod(tok_data, &final_pos);
+    }
     tok->SetDoubleValue(val);
   } else {
-    tok = MakeUnique<Token>(TokenType::kInteger);
+    tok = arena_.Create(TokenType::kInteger);
 
-    uint64_t val = uint64_t(std::strtoull(tok_str.c_str(), &final_pos, 10));
+    uint64_t val = uint64_t(std::strtoull(tok_data, &final_pos, 10));
     tok->SetUint64Value(static_cast<uint64_t>(val));
   }
-  if (tok_str.size() > 1 && tok_str[0] == '-')
+  if (tok_len > 1 && tok_data[0] == '-')
     tok->SetNegative();
 
-  tok->SetOriginalString(tok_str);
+  tok->SetStringView(tok_data, tok_len);
 
   // If the number isn't the whole token then move back so we can then parse
   // the string portion.
-  auto diff = size_t(final_pos - tok_str.c_str());
+  auto diff = size_t(final_pos - tok_data);
   if (diff > 0)
-    current_position_ -= tok_str.length() - diff;
+    current_position_ -= tok_len - diff;
 
   return tok;
 }
 
-std::string Tokenizer::ExtractToNext(const std::string& str) {
-  size_t pos = data_.find(str, current_position_);
-  std::string ret;
-  if (pos == std::string::npos) {
-    ret = data_.substr(current_position_);
-    current_position_ = data_.length();
-  } else {
-    ret = data_.substr(current_position_, pos - current_position_);
-    current_position_ = pos;
+void Tokenizer::ReadNumericValues(bool as_double, std::vector<Value>* values) {
+  // Size the vector for the rest of the line up front; one value per
+  // separator is a tight upper bound for the common space-separated case.
+  const char* line_start = data_ + current_position_;
+  const char* line_end = static_cast<const char*>(
+      memchr(line_start, '\n', size_ - current_position_));
+  size_t line_len = line_end ? static_cast<size_t>(line_end - line_start)
+                             : size_ - current_position_;
+  values->reserve(values->size() +
+                  static_cast<size_t>(
+                      std::count(line_start, line_start + line_len, ' ')) +
+                  1);
+
+  for (;;) {
+    SkipWhitespace();
+
+    const char* start = data_ + current_position_;
+    size_t len = 0;
+    bool has_digit = false;
+    bool has_dot = false;
+    bool is_simple = true;
+    while (current_position_ + len < size_) {
+      char ch = start[len];
+      if (ch == ' ' || ch == '\n' || ch == ')' || ch == ',' || ch == '(')
+        break;
+
+      if (std::isdigit(ch)) {
+        has_digit = true;
+      } else if (ch == '-' && len == 0) {
+        // Leading sign is fine.
+      } else if (ch == '.' && !has_dot) {
+        has_dot = true;
+      } else {
+        is_simple = false;
+        break;
+      }
+      ++len;
+    }
+
+    // Only consume plain decimal literals; anything else (hex, exponents,
+    // strings, end of line) is left for NextToken() so it is classified
+    // exactly as before.
+    if (len == 0 || !is_simple || !has_digit || (has_dot && !as_double))
+      return;
+
+    Value v;
+    if (as_double) {
+      // The scan above admitted only sign, digits and one dot, so the
+      // fast parser handles nearly every literal; only a mantissa too
+      // long for its guarantees drops back to strtod.
+      double val;
+      if (!FastParseDouble(start, len, &val))
+        val = strtod(start, nullptr);
+      v.SetDoubleValue(val);
+    } else {
+      v.SetIntValue(uint64_t(std::strtoull(start, nullptr, 10)));
+    }
+
+    values->push_back(v);
+    current_position_ += len;
   }
+}
+
+std::string Tokenizer::ExtractToNext(const std::string& str) {
+  // std::search lands on the end of the text when |str| is absent, which
+  // extracts the whole remainder just like the found case extracts up to
+  // the match.
+  const char* found = std::search(data_ + current_position_, data_ + size_,
+                                  str.begin(), str.end());
+  size_t pos = static_cast<size_t>(found - data_);
+  std::string ret(data_ + current_position_, pos - current_position_);
+  current_position_ = pos;
 
   // Account for any new lines in the extracted text so our current line
   // number stays correct.
@@ -195,15 +450,38 @@ bool Tokenizer::IsWhitespace(char ch) {
 }
 
 void Tokenizer::SkipWhitespace() {
-  while (current_position_ < data_.size() &&
-         IsWhitespace(data_[current_position_])) {
+  // Scan eight bytes at a time while every byte in the word is whitespace,
+  // then drop to the byte loop to find the exact stopping point. Data heavy
+  // scripts are mostly whitespace separated literals so the bulk of the
+  // skipping happens in the word loop.
+  while (current_position_ + sizeof(uint64_t) <= size_) {
+    uint64_t word;
+    memcpy(&word, data_ + current_position_, sizeof(word));
+    uint64_t ws = BytesEqualMask(word, 0) |
+                  BytesEqualMask(word, BroadcastByte('\t')) |
+                  BytesEqualMask(word, BroadcastByte('\r')) |
+                  BytesEqualMask(word, BroadcastByte(0x0c /* ff */)) |
+                  BytesEqualMask(word, BroadcastByte(' '));
+    if (ws != kHighBits)
+      break;
+    current_position_ += sizeof(uint64_t);
+  }
+  while (current_position_ < size_ && IsWhitespace(data_[current_position_])) {
     ++current_position_;
   }
 }
 
 void Tokenizer::SkipComment() {
-  while (current_position_ < data_.length() &&
-         data_[current_position_] != '\n') {
+  // Scan eight bytes at a time until a word contains the end-of-line byte,
+  // then drop to the byte loop to land on it.
+  while (current_position_ + sizeof(uint64_t) <= size_) {
+    uint64_t word;
+    memcpy(&word, data_ + current_position_, sizeof(word));
+    if (BytesEqualMask(word, BroadcastByte('\n')) != 0)
+      break;
+    current_position_ += sizeof(uint64_t);
+  }
+  while (current_position_ < size_ && data_[current_position_] != '\n') {
     ++current_position_;
   }
 }
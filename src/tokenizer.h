@@ -18,8 +18,10 @@
 #include <cstdlib>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "amber/result.h"
+#include "amber/value.h"
 
 namespace amber {
 
@@ -32,6 +34,34 @@ enum class TokenType : uint8_t {
   kHex,
 };
 
+/// Keywords the parsers dispatch on, classified once per string token by
+/// the tokenizer so parser dispatch is an integer switch instead of a
+/// chain of allocating string compares. Matching is case sensitive;
+/// anything not in the list stays kUnknown.
+enum class KeywordType : uint8_t {
+  kUnknown = 0,
+  // vkscript command words.
+  kDraw,
+  kRect,
+  kArrays,
+  kClear,
+  kSsbo,
+  kUniform,
+  kPatch,
+  kProbe,
+  kTolerance,
+  kRelative,
+  kCompute,
+  kVertex,
+  kFragment,
+  kGeometry,
+  kTessellation,
+  // amberscript top level words.
+  kBuffer,
+  kPipeline,
+  kShader,
+};
+
 class Token {
  public:
   explicit Token(TokenType type);
@@ -45,21 +75,42 @@ class Token {
   bool IsEOL() const { return type_ == TokenType::kEOL; }
 
   bool IsComma() const {
-    return type_ == TokenType::kString && string_value_ == ",";
+    return type_ == TokenType::kString && string_len_ == 1 &&
+           string_data_[0] == ',';
   }
   bool IsOpenBracket() const {
-    return type_ == TokenType::kString && string_value_ == "(";
+    return type_ == TokenType::kString && string_len_ == 1 &&
+           string_data_[0] == '(';
   }
   bool IsCloseBracket() const {
-    return type_ == TokenType::kString && string_value_ == ")";
+    return type_ == TokenType::kString && string_len_ == 1 &&
+           string_data_[0] == ')';
   }
 
+  void SetKeyword(KeywordType keyword) { keyword_ = keyword; }
+  KeywordType GetKeyword() const { return keyword_; }
+
   void SetNegative() { is_negative_ = true; }
-  void SetStringValue(const std::string& val) { string_value_ = val; }
+  void SetStringValue(const std::string& val) {
+    string_value_ = val;
+    string_data_ = string_value_.data();
+    string_len_ = string_value_.length();
+  }
+  /// Points the token at a substring of the script text without copying it.
+  /// The data must remain valid for the lifetime of the token, which holds
+  /// as long as the token does not outlive the tokenizer which produced it.
+  void SetStringView(const char* data, size_t len) {
+    string_data_ = data;
+    string_len_ = len;
+  }
   void SetUint64Value(uint64_t val) { uint_value_ = val; }
   void SetDoubleValue(double val) { double_value_ = val; }
 
-  const std::string& AsString() const { return string_value_; }
+  const std::string& AsString() const {
+    if (string_value_.empty() && string_len_ > 0)
+      string_value_.assign(string_data_, string_len_);
+    return string_value_;
+  }
 
   uint8_t AsUint8() const { return static_cast<uint8_t>(uint_value_); }
   uint16_t AsUint16() const { return static_cast<uint16_t>(uint_value_); }
@@ -77,30 +128,78 @@ class Token {
   double AsDouble() const { return double_value_; }
 
   uint64_t AsHex() const {
-    return uint64_t(std::strtoull(string_value_.c_str(), nullptr, 16));
+    // The viewed data is part of a null terminated string and strtoull stops
+    // at the first character which is not part of the number, so reading past
+    // the end of the view is not a concern.
+    return string_len_ == 0 ? 0
+                            : uint64_t(std::strtoull(string_data_, nullptr, 16));
   }
 
   /// The OriginalString is set for integer and double values to store the
   /// unparsed number which we can return in error messages.
   void SetOriginalString(const std::string& orig_string) {
-    string_value_ = orig_string;
+    SetStringValue(orig_string);
+  }
+  std::string ToOriginalString() const {
+    return string_len_ == 0 ? std::string()
+                            : std::string(string_data_, string_len_);
   }
-  std::string ToOriginalString() const { return string_value_; }
 
  private:
   TokenType type_;
-  std::string string_value_;
+  KeywordType keyword_ = KeywordType::kUnknown;
+  const char* string_data_ = nullptr;
+  size_t string_len_ = 0;
+  // Cache for AsString(); filled in lazily the first time the token text is
+  // needed as a std::string.
+  mutable std::string string_value_;
   uint64_t uint_value_ = 0;
   double double_value_ = 0.0;
   bool is_negative_ = false;
 };
 
+/// Bump allocator which hands out Token objects from large slabs instead of
+/// allocating each token individually. All tokens are destroyed together when
+/// the arena goes away, so tokens must not outlive the arena.
+class TokenArena {
+ public:
+  TokenArena();
+  ~TokenArena();
+
+  Token* Create(TokenType type);
+
+ private:
+  static const size_t kTokensPerSlab = 512;
+
+  /// Slab storage comes from AllocHostBlock(), so an embedder-installed
+  /// allocator covers token memory too.
+  std::vector<uint8_t*> slabs_;
+  size_t used_in_last_slab_ = kTokensPerSlab;
+};
+
 class Tokenizer {
  public:
+  /// Copies |data| so the tokenizer owns the text it scans.
   explicit Tokenizer(const std::string& data);
+  /// Tokenizes |size| bytes at |data| in place without copying them. The
+  /// text must stay valid for the lifetime of the tokenizer and must be
+  /// part of a null terminated buffer - a view into a larger script is
+  /// fine - so the in-place numeric parsing never runs off allocated
+  /// memory.
+  Tokenizer(const char* data, size_t size);
   ~Tokenizer();
 
-  std::unique_ptr<Token> NextToken();
+  /// The returned token is owned by the tokenizer's arena and remains valid
+  /// until the tokenizer is destroyed.
+  Token* NextToken();
+  /// Parses a run of whitespace separated numeric literals directly out of
+  /// the script text, appending one Value per literal to |values|. If
+  /// |as_double| is true values are stored as doubles, otherwise as unsigned
+  /// 64-bit integers with the same negative-value semantics as Token.
+  /// Scanning stops before the first item which is not a simple decimal
+  /// literal (and before any end of line), leaving it for NextToken(), so
+  /// error handling and token splitting behave exactly as the slow path.
+  void ReadNumericValues(bool as_double, std::vector<Value>* values);
   std::string ExtractToNext(const std::string& str);
 
   void SetCurrentLine(size_t line) { current_line_ = line; }
@@ -111,7 +210,13 @@ class Tokenizer {
   void SkipWhitespace();
   void SkipComment();
 
-  std::string data_;
+  /// Backing storage when the tokenizer was constructed from a
+  /// std::string; empty when it scans caller-owned text through the view
+  /// constructor.
+  std::string owned_data_;
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+  TokenArena arena_;
   size_t current_position_ = 0;
   size_t current_line_ = 1;
 };
@@ -0,0 +1,43 @@
+// Copyright 2018 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "benchmark/benchmark.h"
+#include "src/tokenizer.h"
+
+namespace amber {
+namespace {
+
+void BM_TokenizerNextToken(benchmark::State& state) {
+  // A line mixing words, integers, floats and punctuation, as a typical
+  // script does.
+  std::string source;
+  for (size_t i = 0; i < 1024; ++i)
+    source += "probe rect rgba (0, 0, 250, 250) (0.5, 0.25, 0.125, 1.0)\n";
+
+  for (auto _ : state) {
+    Tokenizer tokenizer(source);
+    for (auto* token = tokenizer.NextToken(); !token->IsEOS();
+         token = tokenizer.NextToken()) {
+      benchmark::DoNotOptimize(token);
+    }
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(source.size()));
+}
+BENCHMARK(BM_TokenizerNextToken);
+
+}  // namespace
+}  // namespace amber
@@ -12,15 +12,55 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstdlib>
 #include <limits>
 
+#include "amber/amber.h"
 #include "gtest/gtest.h"
+#include "src/huge_alloc.h"
 #include "src/tokenizer.h"
 
 namespace amber {
+namespace {
+
+// Counts the blocks passing through it so a test can check the
+// embedder hook really carries the token storage.
+class CountingHostAllocator : public HostAllocator {
+ public:
+  ~CountingHostAllocator() override = default;
+
+  void* Allocate(size_t size_in_bytes) override {
+    ++allocations;
+    return malloc(size_in_bytes);
+  }
+
+  void Free(void* ptr, size_t) override {
+    ++frees;
+    free(ptr);
+  }
+
+  size_t allocations = 0;
+  size_t frees = 0;
+};
+
+}  // namespace
 
 using TokenizerTest = testing::Test;
 
+TEST_F(TokenizerTest, HostAllocatorCarriesTokenStorage) {
+  CountingHostAllocator allocator;
+  SetHostBlockAllocator(&allocator);
+  {
+    Tokenizer t("1 2 3 four 5.0");
+    while (!t.NextToken()->IsEOS()) {
+    }
+  }
+  SetHostBlockAllocator(nullptr);
+
+  EXPECT_GT(allocator.allocations, 0U);
+  EXPECT_EQ(allocator.allocations, allocator.frees);
+}
+
 TEST_F(TokenizerTest, ProcessEmpty) {
   Tokenizer t("");
   auto next = t.NextToken();
@@ -40,6 +80,15 @@ TEST_F(TokenizerTest, ProcessString) {
   EXPECT_TRUE(next->IsEOS());
 }
 
+TEST_F(TokenizerTest, ClassifiesKeywords) {
+  Tokenizer t("draw rect SHADER TestString");
+
+  EXPECT_EQ(KeywordType::kDraw, t.NextToken()->GetKeyword());
+  EXPECT_EQ(KeywordType::kRect, t.NextToken()->GetKeyword());
+  EXPECT_EQ(KeywordType::kShader, t.NextToken()->GetKeyword());
+  EXPECT_EQ(KeywordType::kUnknown, t.NextToken()->GetKeyword());
+}
+
 TEST_F(TokenizerTest, ProcessInt) {
   Tokenizer t("123");
   auto next = t.NextToken();
@@ -100,6 +149,32 @@ TEST_F(TokenizerTest, ProcessDoubleStartWithDot) {
   EXPECT_TRUE(next->IsEOS());
 }
 
+TEST_F(TokenizerTest, ProcessDoubleManyDigits) {
+  // Too many mantissa bits for the fast literal parser; the fallback
+  // must still produce the correctly rounded value.
+  Tokenizer t("0.30000000000000004");
+  auto next = t.NextToken();
+  ASSERT_TRUE(next != nullptr);
+  EXPECT_TRUE(next->IsDouble());
+  EXPECT_DOUBLE_EQ(0.30000000000000004, next->AsDouble());
+
+  next = t.NextToken();
+  ASSERT_TRUE(next != nullptr);
+  EXPECT_TRUE(next->IsEOS());
+}
+
+TEST_F(TokenizerTest, ProcessDoubleWithExponent) {
+  Tokenizer t("1.5e3");
+  auto next = t.NextToken();
+  ASSERT_TRUE(next != nullptr);
+  EXPECT_TRUE(next->IsDouble());
+  EXPECT_DOUBLE_EQ(1500.0, next->AsDouble());
+
+  next = t.NextToken();
+  ASSERT_TRUE(next != nullptr);
+  EXPECT_TRUE(next->IsEOS());
+}
+
 TEST_F(TokenizerTest, ProcessStringWithNumberInName) {
   Tokenizer t("BufferAccess32");
   auto next = t.NextToken();
@@ -14,13 +14,19 @@
 
 #include "src/verifier.h"
 
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <cmath>
 #include <cstring>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
 #include "src/command.h"
+#include "src/profiler.h"
 
 namespace amber {
 namespace {
@@ -28,6 +34,43 @@ namespace {
 const double kEpsilon = 0.000001;
 const double kDefaultTexelTolerance = 0.002;
 
+// Hash |size| bytes of |data| into 64 bits, FNV-1a style but folding a
+// 64 bit word per multiply so the scan over a large readback stays
+// memory bound; the sub-word tail is folded byte-wise. The value is
+// stable across runs and platforms of equal endianness, which is what a
+// stored checksum expectation needs; it makes no cryptographic claims.
+uint64_t HashBuffer(const uint8_t* data, size_t size) {
+  const uint64_t kPrime = 0x100000001b3ull;
+  uint64_t hash = 0xcbf29ce484222325ull;
+
+  size_t word_count = size / sizeof(uint64_t);
+  for (size_t i = 0; i < word_count; ++i) {
+    uint64_t word;
+    std::memcpy(&word, data + i * sizeof(uint64_t), sizeof(word));
+    hash = (hash ^ word) * kPrime;
+  }
+  for (size_t i = word_count * sizeof(uint64_t); i < size; ++i)
+    hash = (hash ^ data[i]) * kPrime;
+
+  return hash;
+}
+
+// Finalizer of the splitmix64 generator: a cheap mixer whose output
+// bits each depend on every input bit. Sampled verification uses it to
+// spread element indices over unrelated buckets, so the checked subset
+// is scattered instead of being a strided comb that systematic
+// corruption could slip between.
+uint64_t MixBits(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ull;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+
+// Probes of fewer texels than this are checked on the calling thread;
+// only large rectangles amortize the cost of starting worker threads.
+const uint64_t kMinTexelsForParallelProbe = 16384;
+
 // Copy [src_bit_offset, src_bit_offset + bits) bits of |src| to
 // [0, bits) of |dst|.
 void CopyBitsOfMemoryToBuffer(uint8_t* dst,
@@ -39,6 +82,13 @@ void CopyBitsOfMemoryToBuffer(uint8_t* dst,
     src_bit_offset = static_cast<uint8_t>(src_bit_offset - 8);
   }
 
+  // Byte aligned components i.e., the overwhelmingly common formats like
+  // R8G8B8A8 and R32G32B32A32 need no bit shuffling.
+  if (src_bit_offset == 0 && (bits % 8) == 0) {
+    std::memcpy(dst, src, static_cast<size_t>(bits / 8));
+    return;
+  }
+
   // Number of bytes greater than or equal to |(src_bit_offset + bits) / 8|.
   const uint8_t size_in_bytes =
       static_cast<uint8_t>((src_bit_offset + bits + 7) / 8);
@@ -115,14 +165,62 @@ float HexFloat10ToFloat(const uint8_t* value) {
 // 11 and 10 bits floats are always positive.
 // 14 bits float is used only RGB9_E5 format in OpenGL but it does not exist
 // in Vulkan.
+// Probing a small float framebuffer decodes every component of every
+// texel, so the bit manipulating converters above would run millions of
+// times per probe. These tables precompute the conversion for every
+// possible bit pattern on first use, turning each decode into one load.
+// The largest, for 16 bits, is 256KB.
+const float* HexFloat16Table() {
+  static std::vector<float> table = []() {
+    std::vector<float> t(1U << 16U);
+    for (uint32_t i = 0; i < t.size(); ++i) {
+      const uint8_t value[2] = {static_cast<uint8_t>(i & 0xffU),
+                                static_cast<uint8_t>(i >> 8U)};
+      t[i] = HexFloat16ToFloat(value);
+    }
+    return t;
+  }();
+  return table.data();
+}
+
+const float* HexFloat11Table() {
+  static std::vector<float> table = []() {
+    std::vector<float> t(1U << 11U);
+    for (uint32_t i = 0; i < t.size(); ++i) {
+      const uint8_t value[2] = {static_cast<uint8_t>(i & 0xffU),
+                                static_cast<uint8_t>(i >> 8U)};
+      t[i] = HexFloat11ToFloat(value);
+    }
+    return t;
+  }();
+  return table.data();
+}
+
+const float* HexFloat10Table() {
+  static std::vector<float> table = []() {
+    std::vector<float> t(1U << 10U);
+    for (uint32_t i = 0; i < t.size(); ++i) {
+      const uint8_t value[2] = {static_cast<uint8_t>(i & 0xffU),
+                                static_cast<uint8_t>(i >> 8U)};
+      t[i] = HexFloat10ToFloat(value);
+    }
+    return t;
+  }();
+  return table.data();
+}
+
 float HexFloatToFloat(const uint8_t* value, uint8_t bits) {
+  // CopyBitsOfMemoryToBuffer() leaves the pattern in the low |bits| bits
+  // of |value|, so the two bytes form the table index directly.
+  const uint32_t pattern = static_cast<uint32_t>(value[0]) |
+                           (static_cast<uint32_t>(value[1]) << 8U);
   switch (bits) {
     case 10:
-      return HexFloat10ToFloat(value);
+      return HexFloat10Table()[pattern];
     case 11:
-      return HexFloat11ToFloat(value);
+      return HexFloat11Table()[pattern];
     case 16:
-      return HexFloat16ToFloat(value);
+      return HexFloat16Table()[pattern];
   }
 
   assert(false && "Invalid bits");
@@ -142,6 +240,14 @@ double SRGBToLinearValue(double sRGB) {
 // If |is_tolerance_percent| is true, the actual tolerance will be
 // relative value i.e., |tolerance| / 100 * fabs(expected).
 // Otherwise, this method uses the absolute value i.e., |tolerance|.
+// Resolves |tolerance| for |expected| into an absolute error bound,
+// turning a percentage tolerance into the absolute difference it allows.
+double ToAbsoluteTolerance(double expected,
+                           double tolerance,
+                           bool is_percent) {
+  return is_percent ? (tolerance / 100.0) * std::fabs(expected) : tolerance;
+}
+
 bool IsEqualWithTolerance(const double actual,
                           const double expected,
                           double tolerance,
@@ -157,100 +263,215 @@ bool IsEqualWithTolerance(const double actual,
   return true;
 }
 
-template <typename T>
-Result CheckValue(const ProbeSSBOCommand* command,
-                  const uint8_t* memory,
-                  const std::vector<Value>& values) {
-  const auto comp = command->GetComparator();
-  const auto& tolerance = command->GetTolerances();
-  const T* ptr = reinterpret_cast<const T*>(memory);
+// Returns the comparison symbol |comp| is reported with in failure
+// messages.
+const char* ComparatorSymbol(ProbeSSBOCommand::Comparator comp) {
+  switch (comp) {
+    case ProbeSSBOCommand::Comparator::kEqual:
+      return "==";
+    case ProbeSSBOCommand::Comparator::kNotEqual:
+      return "!=";
+    case ProbeSSBOCommand::Comparator::kFuzzyEqual:
+      return "~=";
+    case ProbeSSBOCommand::Comparator::kLess:
+      return "<";
+    case ProbeSSBOCommand::Comparator::kLessOrEqual:
+      return "<=";
+    case ProbeSSBOCommand::Comparator::kGreater:
+      return ">";
+    case ProbeSSBOCommand::Comparator::kGreaterOrEqual:
+      return ">=";
+  }
+  return "";
+}
+
+// Scans every element with the comparator fixed at compile time, so
+// the hot loop body is a single compare in the element's own type that
+// the compiler can unroll and vectorize; the widening to double
+// survives only in the paths whose tolerance genuinely needs it.
+// |Exact| marks all-integer expectations, whose equality is a native
+// integer compare with no per element type test. CheckValue() selects
+// the right instantiation once per probe.
+template <typename T, ProbeSSBOCommand::Comparator Comp, bool Exact>
+void ScanForFailedElements(const T* actual,
+                           const T* expected,
+                           const std::vector<Value>& values,
+                           double tolerance,
+                           bool is_percent,
+                           size_t max_failures,
+                           uint32_t sample_denominator,
+                           uint64_t sample_salt,
+                           std::vector<size_t>* failed_indices) {
   for (size_t i = 0; i < values.size(); ++i) {
-    const T val = values[i].IsInteger() ? static_cast<T>(values[i].AsUint64())
-                                        : static_cast<T>(values[i].AsDouble());
-    switch (comp) {
+    if (sample_denominator != 0 &&
+        MixBits(i ^ sample_salt) % sample_denominator != 0) {
+      continue;
+    }
+
+    bool ok = true;
+    switch (Comp) {
       case ProbeSSBOCommand::Comparator::kEqual:
-        if (values[i].IsInteger()) {
-          if (static_cast<uint64_t>(*ptr) != static_cast<uint64_t>(val)) {
-            return Result("Line " + std::to_string(command->GetLine()) +
-                          ": Verifier failed: " + std::to_string(*ptr) +
-                          " == " + std::to_string(val) + ", at index " +
-                          std::to_string(i));
-          }
+        if (Exact) {
+          ok = actual[i] == expected[i];
+        } else if (values[i].IsInteger()) {
+          ok = static_cast<uint64_t>(actual[i]) ==
+               static_cast<uint64_t>(expected[i]);
         } else {
-          if (!IsEqualWithTolerance(static_cast<const double>(*ptr),
-                                    static_cast<const double>(val), kEpsilon)) {
-            return Result("Line " + std::to_string(command->GetLine()) +
-                          ": Verifier failed: " + std::to_string(*ptr) +
-                          " == " + std::to_string(val) + ", at index " +
-                          std::to_string(i));
-          }
+          ok = IsEqualWithTolerance(static_cast<double>(actual[i]),
+                                    static_cast<double>(expected[i]),
+                                    kEpsilon);
         }
         break;
       case ProbeSSBOCommand::Comparator::kNotEqual:
-        if (values[i].IsInteger()) {
-          if (static_cast<uint64_t>(*ptr) == static_cast<uint64_t>(val)) {
-            return Result("Line " + std::to_string(command->GetLine()) +
-                          ": Verifier failed: " + std::to_string(*ptr) +
-                          " != " + std::to_string(val) + ", at index " +
-                          std::to_string(i));
-          }
+        if (Exact) {
+          ok = actual[i] != expected[i];
+        } else if (values[i].IsInteger()) {
+          ok = static_cast<uint64_t>(actual[i]) !=
+               static_cast<uint64_t>(expected[i]);
         } else {
-          if (IsEqualWithTolerance(static_cast<const double>(*ptr),
-                                   static_cast<const double>(val), kEpsilon)) {
-            return Result("Line " + std::to_string(command->GetLine()) +
-                          ": Verifier failed: " + std::to_string(*ptr) +
-                          " != " + std::to_string(val) + ", at index " +
-                          std::to_string(i));
-          }
+          ok = !IsEqualWithTolerance(static_cast<double>(actual[i]),
+                                     static_cast<double>(expected[i]),
+                                     kEpsilon);
         }
         break;
       case ProbeSSBOCommand::Comparator::kFuzzyEqual:
-        if (!IsEqualWithTolerance(
-                static_cast<const double>(*ptr), static_cast<const double>(val),
-                command->HasTolerances() ? tolerance[0].value : kEpsilon,
-                command->HasTolerances() ? tolerance[0].is_percent : true)) {
-          return Result("Line " + std::to_string(command->GetLine()) +
-                        ": Verifier failed: " + std::to_string(*ptr) +
-                        " ~= " + std::to_string(val) + ", at index " +
-                        std::to_string(i));
-        }
+        ok = IsEqualWithTolerance(static_cast<double>(actual[i]),
+                                  static_cast<double>(expected[i]), tolerance,
+                                  is_percent);
         break;
       case ProbeSSBOCommand::Comparator::kLess:
-        if (*ptr >= val) {
-          return Result("Line " + std::to_string(command->GetLine()) +
-                        ": Verifier failed: " + std::to_string(*ptr) + " < " +
-                        std::to_string(val) + ", at index " +
-                        std::to_string(i));
-        }
+        ok = actual[i] < expected[i];
         break;
       case ProbeSSBOCommand::Comparator::kLessOrEqual:
-        if (*ptr > val) {
-          return Result("Line " + std::to_string(command->GetLine()) +
-                        ": Verifier failed: " + std::to_string(*ptr) +
-                        " <= " + std::to_string(val) + ", at index " +
-                        std::to_string(i));
-        }
+        ok = actual[i] <= expected[i];
         break;
       case ProbeSSBOCommand::Comparator::kGreater:
-        if (*ptr <= val) {
-          return Result("Line " + std::to_string(command->GetLine()) +
-                        ": Verifier failed: " + std::to_string(*ptr) + " > " +
-                        std::to_string(val) + ", at index " +
-                        std::to_string(i));
-        }
+        ok = actual[i] > expected[i];
         break;
       case ProbeSSBOCommand::Comparator::kGreaterOrEqual:
-        if (*ptr < val) {
-          return Result("Line " + std::to_string(command->GetLine()) +
-                        ": Verifier failed: " + std::to_string(*ptr) +
-                        " >= " + std::to_string(val) + ", at index " +
-                        std::to_string(i));
-        }
+        ok = actual[i] >= expected[i];
+        break;
+    }
+
+    if (!ok) {
+      failed_indices->push_back(i);
+      if (failed_indices->size() >= max_failures)
         break;
     }
-    ++ptr;
   }
-  return {};
+}
+
+template <typename T>
+Result CheckValue(const ProbeSSBOCommand* command,
+                  const uint8_t* memory,
+                  const std::vector<Value>& values,
+                  size_t max_failures,
+                  uint32_t sample_denominator,
+                  uint64_t sample_salt) {
+  const auto comp = command->GetComparator();
+  const auto& tolerance = command->GetTolerances();
+  const T* ptr = reinterpret_cast<const T*>(memory);
+
+  // Lower the expected values into a typed contiguous array once; the
+  // command caches it, so a recipe executed hundreds of times pays the
+  // per Value conversion switches on the first pass only.
+  if (!command->HasLoweredValues() && !values.empty()) {
+    std::vector<uint8_t> lowered(values.size() * sizeof(T));
+    T* out = reinterpret_cast<T*>(lowered.data());
+    bool all_integers = true;
+    for (size_t i = 0; i < values.size(); ++i) {
+      if (values[i].IsInteger()) {
+        out[i] = static_cast<T>(values[i].AsUint64());
+      } else {
+        out[i] = static_cast<T>(values[i].AsDouble());
+        all_integers = false;
+      }
+    }
+    command->SetLoweredValues(std::move(lowered), all_integers);
+  }
+
+  const T* expected =
+      reinterpret_cast<const T*>(command->GetLoweredValues().data());
+
+  // The fuzzy equality settings are the same for every element; resolve
+  // them once instead of inside the comparison loop.
+  double fuzzy_tolerance = kEpsilon;
+  bool fuzzy_is_percent = true;
+  if (command->HasTolerances()) {
+    fuzzy_tolerance = tolerance[0].value;
+    fuzzy_is_percent = tolerance[0].is_percent;
+  }
+
+  // Exact equality on integer data is a bitwise comparison, so the
+  // lowered image is checked with a single memcmp. Only when it differs
+  // does the per element loop below run, to name the first failing
+  // index. A sampled pass skips the shortcut since it reads every
+  // element; its cost must scale with the subset instead.
+  if (sample_denominator == 0 &&
+      comp == ProbeSSBOCommand::Comparator::kEqual &&
+      std::is_integral<T>::value && !values.empty() &&
+      command->AreLoweredValuesIntegers()) {
+    if (std::memcmp(expected, memory, values.size() * sizeof(T)) == 0)
+      return {};
+  }
+
+  // The scan records only the indices of failing elements and stops
+  // once |max_failures| have been found, so a thoroughly corrupted
+  // buffer fails in bounded time. The failure strings are built after
+  // the scan, for the recorded elements only. The comparator picks the
+  // kernel instantiation once; the per element loop has no comparator
+  // dispatch left in it.
+  using Comparator = ProbeSSBOCommand::Comparator;
+  using ScanFn = void (*)(const T*, const T*, const std::vector<Value>&,
+                          double, bool, size_t, uint32_t, uint64_t,
+                          std::vector<size_t>*);
+  const bool exact =
+      std::is_integral<T>::value && command->AreLoweredValuesIntegers();
+  ScanFn scan = nullptr;
+  switch (comp) {
+    case Comparator::kEqual:
+      scan = exact ? &ScanForFailedElements<T, Comparator::kEqual, true>
+                   : &ScanForFailedElements<T, Comparator::kEqual, false>;
+      break;
+    case Comparator::kNotEqual:
+      scan = exact ? &ScanForFailedElements<T, Comparator::kNotEqual, true>
+                   : &ScanForFailedElements<T, Comparator::kNotEqual, false>;
+      break;
+    case Comparator::kFuzzyEqual:
+      scan = &ScanForFailedElements<T, Comparator::kFuzzyEqual, false>;
+      break;
+    case Comparator::kLess:
+      scan = &ScanForFailedElements<T, Comparator::kLess, false>;
+      break;
+    case Comparator::kLessOrEqual:
+      scan = &ScanForFailedElements<T, Comparator::kLessOrEqual, false>;
+      break;
+    case Comparator::kGreater:
+      scan = &ScanForFailedElements<T, Comparator::kGreater, false>;
+      break;
+    case Comparator::kGreaterOrEqual:
+      scan = &ScanForFailedElements<T, Comparator::kGreaterOrEqual, false>;
+      break;
+  }
+
+  std::vector<size_t> failed_indices;
+  scan(ptr, expected, values, fuzzy_tolerance, fuzzy_is_percent, max_failures,
+       sample_denominator, sample_salt, &failed_indices);
+
+  if (failed_indices.empty())
+    return {};
+
+  std::string message;
+  for (size_t n = 0; n < failed_indices.size(); ++n) {
+    const size_t i = failed_indices[n];
+    if (n != 0)
+      message += "\n";
+    message += "Line " + std::to_string(command->GetLine()) +
+               ": Verifier failed: " + std::to_string(ptr[i]) + " " +
+               ComparatorSymbol(comp) + " " + std::to_string(expected[i]) +
+               ", at index " + std::to_string(i);
+  }
+  return Result(message);
 }
 
 void SetupToleranceForTexels(const ProbeCommand* command,
@@ -289,31 +510,168 @@ void SetupToleranceForTexels(const ProbeCommand* command,
   }
 }
 
-// Convert data of |texel| into double values based on the
-// information given in |framebuffer_format|.
-std::vector<double> GetActualValuesFromTexel(const uint8_t* texel,
-                                             const Format* framebuffer_format) {
-  assert(framebuffer_format && !framebuffer_format->GetComponents().empty());
+// Compares the framebuffer bytes in |buf| against the probe's reference
+// image, which holds tightly packed rows of |frame_width| texels in the
+// framebuffer's own byte layout. Each row is checked with one memcmp,
+// which the C library vectorizes; only a row that differs is rescanned
+// per channel to honour the tolerance and name the first bad pixel.
+// Tolerances are only meaningful for byte-per-channel formats since the
+// rescan compares raw bytes.
+Result ProbeReferenceImage(const ProbeCommand* command,
+                           uint32_t texel_stride,
+                           uint32_t row_stride,
+                           uint32_t frame_width,
+                           uint32_t frame_height,
+                           const uint8_t* buf) {
+  const uint8_t* ref = command->GetReferenceImageData();
+  const uint64_t ref_size = command->GetReferenceImageSize();
+  const uint64_t ref_row_pitch =
+      static_cast<uint64_t>(frame_width) * texel_stride;
+  const uint64_t expected_size = ref_row_pitch * frame_height;
+  if (ref_size != expected_size) {
+    return Result("Line " + std::to_string(command->GetLine()) +
+                  ": Verifier::Probe reference image size of " +
+                  std::to_string(ref_size) + " bytes does not match the " +
+                  std::to_string(frame_width) + "x" +
+                  std::to_string(frame_height) + " framebuffer (" +
+                  std::to_string(expected_size) + " bytes)");
+  }
 
-  std::vector<double> actual_values(framebuffer_format->GetComponents().size());
+  const bool has_tolerance = command->HasTolerances();
+  double tolerance[4] = {0, 0, 0, 0};
+  bool is_tolerance_percent[4] = {false, false, false, false};
+  if (has_tolerance)
+    SetupToleranceForTexels(command, tolerance, is_tolerance_percent);
+
+  for (uint32_t j = 0; j < frame_height; ++j) {
+    const uint8_t* actual_row = buf + static_cast<uint64_t>(row_stride) * j;
+    const uint8_t* ref_row = ref + ref_row_pitch * j;
+    if (std::memcmp(actual_row, ref_row, ref_row_pitch) == 0)
+      continue;
+
+    // The rows differ byte for byte but may still agree within the
+    // tolerance; without one, any difference already fails.
+    for (uint32_t i = 0; i < frame_width; ++i) {
+      const uint8_t* actual_texel = actual_row + texel_stride * i;
+      const uint8_t* ref_texel = ref_row + texel_stride * i;
+      for (uint32_t c = 0; c < texel_stride; ++c) {
+        double diff = std::fabs(static_cast<double>(actual_texel[c]) -
+                                static_cast<double>(ref_texel[c]));
+        double allowed = 0.0;
+        if (has_tolerance) {
+          // Tolerances are given in normalized [0, 1] channel units; the
+          // comparison here is on raw bytes.
+          uint32_t channel = c < 4 ? c : 3;
+          allowed = ToAbsoluteTolerance(
+                        static_cast<double>(ref_texel[c]) / 255.0,
+                        tolerance[channel], is_tolerance_percent[channel]) *
+                    255.0;
+        }
+        if (diff > allowed) {
+          return Result("Line " + std::to_string(command->GetLine()) +
+                        ": Verifier::Probe reference image mismatch at (" +
+                        std::to_string(i) + ", " + std::to_string(j) +
+                        ") byte " + std::to_string(c) + ", expected " +
+                        std::to_string(ref_texel[c]) + " but found " +
+                        std::to_string(actual_texel[c]));
+        }
+      }
+    }
+  }
+  return {};
+}
+
+// A texel holds at most the four color components R, G, B and A.
+const size_t kMaxTexelComponents = 4;
+
+// How to decode one component of a texel: where its bits live and which
+// normalization applies to the raw value. Built once per probe by
+// BuildComponentLayout() so the per texel decode neither re-walks the
+// format's component list nor allocates.
+struct ComponentLayout {
   uint8_t bit_offset = 0;
+  uint8_t num_bits = 0;
+  FormatMode mode = FormatMode::kUNorm;
+  FormatComponentType type = FormatComponentType::kR;
+  // Divisor normalizing the decoded raw value; 1.0 for modes that are
+  // not normalized.
+  double scale_divisor = 1.0;
+  // True when the normalized value additionally goes through the sRGB
+  // to linear transfer function.
+  bool srgb_to_linear = false;
+};
+
+// Fill |layout| with the decode plan for every component of
+// |framebuffer_format| and return the component count.
+size_t BuildComponentLayout(const Format* framebuffer_format,
+                            ComponentLayout* layout) {
+  assert(framebuffer_format && !framebuffer_format->GetComponents().empty());
+  const auto& components = framebuffer_format->GetComponents();
+  assert(components.size() <= kMaxTexelComponents);
 
-  for (size_t i = 0; i < framebuffer_format->GetComponents().size(); ++i) {
-    const auto& component = framebuffer_format->GetComponents()[i];
+  for (size_t i = 0; i < components.size(); ++i) {
+    const auto& component = components[i];
+    // The format finalized its component offsets when it was built.
+    layout[i].bit_offset = static_cast<uint8_t>(component.bit_offset);
+    layout[i].num_bits = component.num_bits;
+    layout[i].mode = component.mode;
+    layout[i].type = component.type;
+
+    switch (component.mode) {
+      case FormatMode::kUNorm:
+        layout[i].scale_divisor =
+            static_cast<double>((1 << component.num_bits) - 1);
+        break;
+      case FormatMode::kSNorm:
+        layout[i].scale_divisor =
+            static_cast<double>((1 << (component.num_bits - 1)) - 1);
+        break;
+      case FormatMode::kSRGB:
+        layout[i].scale_divisor =
+            static_cast<double>((1 << component.num_bits) - 1);
+        layout[i].srgb_to_linear = component.type != FormatComponentType::kA;
+        break;
+      case FormatMode::kUInt:
+      case FormatMode::kSInt:
+      case FormatMode::kUFloat:
+      case FormatMode::kSFloat:
+        break;
+      case FormatMode::kUScaled:
+      case FormatMode::kSScaled:
+        assert(false &&
+               "FormatMode::kUScaled and ::kSScaled are not implemented");
+        break;
+    }
+  }
+  return components.size();
+}
+
+// Decode the |component_count| components of |texel| into |values|,
+// already normalized per the layout. |values| must hold
+// kMaxTexelComponents doubles; it lives on the caller's stack so a
+// full frame probe does not allocate per texel.
+void DecodeTexel(const uint8_t* texel,
+                 const ComponentLayout* layout,
+                 size_t component_count,
+                 double* values) {
+  for (size_t i = 0; i < component_count; ++i) {
+    const ComponentLayout& component = layout[i];
     uint8_t actual[8] = {0, 0, 0, 0, 0, 0, 0, 0};
 
-    CopyBitsOfMemoryToBuffer(actual, texel, bit_offset, component.num_bits);
+    CopyBitsOfMemoryToBuffer(actual, texel, component.bit_offset,
+                             component.num_bits);
+    double value = 0.0;
     if (component.mode == FormatMode::kUFloat ||
         component.mode == FormatMode::kSFloat) {
       if (component.num_bits < 32) {
-        actual_values[i] =
-            static_cast<double>(HexFloatToFloat(actual, component.num_bits));
+        value = static_cast<double>(
+            HexFloatToFloat(actual, component.num_bits));
       } else if (component.num_bits == 32) {
         float* ptr = reinterpret_cast<float*>(actual);
-        actual_values[i] = static_cast<double>(*ptr);
+        value = static_cast<double>(*ptr);
       } else if (component.num_bits == 64) {
         double* ptr = reinterpret_cast<double*>(actual);
-        actual_values[i] = *ptr;
+        value = *ptr;
       } else {
         assert(false && "Bits of component is not for double nor float type");
       }
@@ -324,25 +682,25 @@ std::vector<double> GetActualValuesFromTexel(const uint8_t* texel,
           case 8: {
             int8_t* ptr8 = nullptr;
             ptr8 = reinterpret_cast<int8_t*>(actual);
-            actual_values[i] = static_cast<double>(*ptr8);
+            value = static_cast<double>(*ptr8);
             break;
           }
           case 16: {
             int16_t* ptr16 = nullptr;
             ptr16 = reinterpret_cast<int16_t*>(actual);
-            actual_values[i] = static_cast<double>(*ptr16);
+            value = static_cast<double>(*ptr16);
             break;
           }
           case 32: {
             int32_t* ptr32 = nullptr;
             ptr32 = reinterpret_cast<int32_t*>(actual);
-            actual_values[i] = static_cast<double>(*ptr32);
+            value = static_cast<double>(*ptr32);
             break;
           }
           case 64: {
             int64_t* ptr64 = nullptr;
             ptr64 = reinterpret_cast<int64_t*>(actual);
-            actual_values[i] = static_cast<double>(*ptr64);
+            value = static_cast<double>(*ptr64);
             break;
           }
           default: {
@@ -352,25 +710,25 @@ std::vector<double> GetActualValuesFromTexel(const uint8_t* texel,
       } else {
         switch (component.num_bits) {
           case 8: {
-            actual_values[i] = static_cast<double>(*actual);
+            value = static_cast<double>(*actual);
             break;
           }
           case 16: {
             uint16_t* ptr16 = nullptr;
             ptr16 = reinterpret_cast<uint16_t*>(actual);
-            actual_values[i] = static_cast<double>(*ptr16);
+            value = static_cast<double>(*ptr16);
             break;
           }
           case 32: {
             uint32_t* ptr32 = nullptr;
             ptr32 = reinterpret_cast<uint32_t*>(actual);
-            actual_values[i] = static_cast<double>(*ptr32);
+            value = static_cast<double>(*ptr32);
             break;
           }
           case 64: {
             uint64_t* ptr64 = nullptr;
             ptr64 = reinterpret_cast<uint64_t*>(actual);
-            actual_values[i] = static_cast<double>(*ptr64);
+            value = static_cast<double>(*ptr64);
             break;
           }
           default: {
@@ -380,111 +738,128 @@ std::vector<double> GetActualValuesFromTexel(const uint8_t* texel,
       }
     }
 
-    bit_offset += component.num_bits;
+    value /= component.scale_divisor;
+    if (component.srgb_to_linear)
+      value = SRGBToLinearValue(value);
+    values[i] = value;
   }
-
-  return actual_values;
 }
 
-// If component mode of |framebuffer_format| is FormatMode::kUNorm or
-// ::kSNorm or ::kSRGB, scale the corresponding value in |texel|.
-// Note that we do not scale values with FormatMode::kUInt, ::kSInt,
-// ::kUFloat, ::kSFloat.
-void ScaleTexelValuesIfNeeded(std::vector<double>* texel,
-                              const Format* framebuffer_format) {
-  assert(framebuffer_format->GetComponents().size() == texel->size());
-  for (size_t i = 0; i < framebuffer_format->GetComponents().size(); ++i) {
-    const auto& component = framebuffer_format->GetComponents()[i];
-
-    double scaled_value = (*texel)[i];
-    switch (component.mode) {
-      case FormatMode::kUNorm:
-        scaled_value /= static_cast<double>((1 << component.num_bits) - 1);
-        break;
-      case FormatMode::kSNorm:
-        scaled_value /=
-            static_cast<double>((1 << (component.num_bits - 1)) - 1);
-        break;
-      case FormatMode::kUInt:
-      case FormatMode::kSInt:
-      case FormatMode::kUFloat:
-      case FormatMode::kSFloat:
-        break;
-      case FormatMode::kSRGB:
-        scaled_value /= static_cast<double>((1 << component.num_bits) - 1);
-        if (component.type != FormatComponentType::kA)
-          scaled_value = SRGBToLinearValue(scaled_value);
-        break;
-      case FormatMode::kUScaled:
-      case FormatMode::kSScaled:
-        assert(false &&
-               "FormatMode::kUScaled and ::kSScaled are not implemented");
-        break;
-    }
-
-    (*texel)[i] = scaled_value;
-  }
-}
-
-/// Check |texel| with |texel_format| is the same with the expected
-/// RGB(A) values given via |command|. This method allow error
-/// smaller than |tolerance|. If an element of
-/// |is_tolerance_percent| is true, we assume that the corresponding
-/// |tolerance| is relative i.e., percentage allowed error.
-bool IsTexelEqualToExpected(const std::vector<double>& texel,
-                            const Format* framebuffer_format,
+/// Check the decoded |texel| against the expected RGB(A) values given
+/// via |command|. |abs_tolerance| holds the absolute error bound
+/// allowed per RGBA channel; percentage tolerances were already
+/// resolved against the expected channel values, which are fixed for
+/// the whole probe.
+bool IsTexelEqualToExpected(const double* texel,
+                            const ComponentLayout* layout,
+                            size_t component_count,
                             const ProbeCommand* command,
-                            const double* tolerance,
-                            const bool* is_tolerance_percent) {
-  for (size_t i = 0; i < framebuffer_format->GetComponents().size(); ++i) {
-    const auto& component = framebuffer_format->GetComponents()[i];
+                            const double* abs_tolerance) {
+  for (size_t i = 0; i < component_count; ++i) {
+    const ComponentLayout& component = layout[i];
 
     double texel_for_component = texel[i];
     double expected = 0;
     double current_tolerance = 0;
-    bool is_current_tolerance_percent = false;
     switch (component.type) {
       case FormatComponentType::kA:
         if (!command->IsRGBA()) {
           continue;
         }
         expected = static_cast<double>(command->GetA());
-        current_tolerance = tolerance[3];
-        is_current_tolerance_percent = is_tolerance_percent[3];
+        current_tolerance = abs_tolerance[3];
         break;
       case FormatComponentType::kR:
         expected = static_cast<double>(command->GetR());
-        current_tolerance = tolerance[0];
-        is_current_tolerance_percent = is_tolerance_percent[0];
+        current_tolerance = abs_tolerance[0];
         break;
       case FormatComponentType::kG:
         expected = static_cast<double>(command->GetG());
-        current_tolerance = tolerance[1];
-        is_current_tolerance_percent = is_tolerance_percent[1];
+        current_tolerance = abs_tolerance[1];
         break;
       case FormatComponentType::kB:
         expected = static_cast<double>(command->GetB());
-        current_tolerance = tolerance[2];
-        is_current_tolerance_percent = is_tolerance_percent[2];
+        current_tolerance = abs_tolerance[2];
         break;
       default:
         continue;
     }
 
-    if (!IsEqualWithTolerance(expected, texel_for_component, current_tolerance,
-                              is_current_tolerance_percent)) {
+    if (std::fabs(expected - texel_for_component) > current_tolerance)
       return false;
-    }
   }
 
   return true;
 }
 
-std::vector<double> GetTexelInRGBA(const std::vector<double>& texel,
-                                   const Format* framebuffer_format) {
-  std::vector<double> texel_in_rgba(texel.size());
-  for (size_t i = 0; i < framebuffer_format->GetComponents().size(); ++i) {
-    const auto& component = framebuffer_format->GetComponents()[i];
+// Precomputed check for one component of a texel in a byte aligned
+// format, so the hot loop reads the component straight from the texel
+// bytes instead of unpacking bit by bit into a heap allocated vector.
+struct FastComponentCheck {
+  uint32_t byte_offset = 0;
+  bool is_float32 = false;
+  double expected = 0;
+  double abs_tolerance = 0;
+};
+
+// Builds the per component checks for the fast texel path. Only the two
+// dominant framebuffer layouts qualify: every component an eight bit
+// UNorm e.g., R8G8B8A8_UNORM, or every component a 32 bit SFloat e.g.,
+// R32G32B32A32_SFLOAT. Returns false for anything else, which sends the
+// probe down the generic bit unpacking path.
+bool BuildFastComponentChecks(const ProbeCommand* command,
+                              const Format* framebuffer_format,
+                              const double* abs_tolerance,
+                              std::vector<FastComponentCheck>* checks) {
+  if (!framebuffer_format->IsByteAligned())
+    return false;
+
+  for (const auto& component : framebuffer_format->GetComponents()) {
+    const bool is_unorm8 =
+        component.num_bits == 8 && component.mode == FormatMode::kUNorm;
+    const bool is_float32 =
+        component.num_bits == 32 && component.mode == FormatMode::kSFloat;
+    if (!is_unorm8 && !is_float32)
+      return false;
+
+    FastComponentCheck check;
+    check.byte_offset = component.byte_offset;
+    check.is_float32 = is_float32;
+
+    switch (component.type) {
+      case FormatComponentType::kA:
+        if (!command->IsRGBA())
+          continue;
+        check.expected = static_cast<double>(command->GetA());
+        check.abs_tolerance = abs_tolerance[3];
+        break;
+      case FormatComponentType::kR:
+        check.expected = static_cast<double>(command->GetR());
+        check.abs_tolerance = abs_tolerance[0];
+        break;
+      case FormatComponentType::kG:
+        check.expected = static_cast<double>(command->GetG());
+        check.abs_tolerance = abs_tolerance[1];
+        break;
+      case FormatComponentType::kB:
+        check.expected = static_cast<double>(command->GetB());
+        check.abs_tolerance = abs_tolerance[2];
+        break;
+      default:
+        continue;
+    }
+
+    checks->push_back(check);
+  }
+  return true;
+}
+
+std::vector<double> GetTexelInRGBA(const double* texel,
+                                   const ComponentLayout* layout,
+                                   size_t component_count) {
+  std::vector<double> texel_in_rgba(component_count);
+  for (size_t i = 0; i < component_count; ++i) {
+    const ComponentLayout& component = layout[i];
     switch (component.type) {
       case FormatComponentType::kR:
         texel_in_rgba[0] = texel[i];
@@ -511,6 +886,45 @@ Verifier::Verifier() = default;
 
 Verifier::~Verifier() = default;
 
+void Verifier::SetFrameGeneration(uint64_t generation) {
+  if (frame_generation_set_ && generation == frame_generation_)
+    return;
+
+  frame_generation_ = generation;
+  frame_generation_set_ = true;
+  decoded_texels_.clear();
+}
+
+void Verifier::SetSampledVerification(uint32_t denominator,
+                                      uint64_t seed,
+                                      uint64_t full_check_interval) {
+  sample_denominator_ = denominator > 1 ? denominator : 0;
+  sample_seed_ = seed;
+  sample_full_interval_ = full_check_interval;
+}
+
+bool Verifier::IsSampledPass() const {
+  if (!sample_denominator_)
+    return false;
+
+  // Without a frame generation there is no pass counter to vary the
+  // subset by, so every call checks in full rather than re-checking the
+  // same fixed subset forever.
+  if (!frame_generation_set_)
+    return false;
+
+  // Generation zero always checks in full so a recipe broken from the
+  // start fails on its first iteration whatever the sampling settings.
+  if (frame_generation_ == 0)
+    return false;
+
+  if (sample_full_interval_ != 0 &&
+      frame_generation_ % sample_full_interval_ == 0)
+    return false;
+
+  return true;
+}
+
 Result Verifier::Probe(const ProbeCommand* command,
                        const Format* framebuffer_format,
                        uint32_t texel_stride,
@@ -518,6 +932,8 @@ Result Verifier::Probe(const ProbeCommand* command,
                        uint32_t frame_width,
                        uint32_t frame_height,
                        const void* buf) {
+  ScopedPhaseTimer timer("Verifier::Probe");
+
   if (!command)
     return Result("Verifier::Probe given ProbeCommand is nullptr");
 
@@ -572,32 +988,183 @@ Result Verifier::Probe(const ProbeCommand* command,
                   std::to_string(texel_stride) + " bytes each");
   }
 
+  // Reference image probes compare the frame's raw bytes against the
+  // mapped golden file; none of the colour machinery below applies.
+  if (command->IsReferenceImage()) {
+    return ProbeReferenceImage(command, texel_stride, row_stride, frame_width,
+                               frame_height,
+                               static_cast<const uint8_t*>(buf));
+  }
+
+  // A zero-area rectangle - probed directly or via a relative rect whose
+  // fraction rounds down to nothing - has no texels to check and passes
+  // trivially.
+  if (width == 0 || height == 0)
+    return {};
+
   double tolerance[4] = {0, 0, 0, 0};
   bool is_tolerance_percent[4] = {0, 0, 0, 0};
   SetupToleranceForTexels(command, tolerance, is_tolerance_percent);
 
+  // The expected channel values are fixed for the whole probe, so
+  // percentage tolerances resolve to absolute error bounds once here;
+  // the per texel compare is then a subtraction and one compare with no
+  // tolerance mode branch.
+  const double expected_rgba[4] = {
+      static_cast<double>(command->GetR()), static_cast<double>(command->GetG()),
+      static_cast<double>(command->GetB()),
+      static_cast<double>(command->GetA())};
+  double abs_tolerance[4];
+  for (int c = 0; c < 4; ++c) {
+    abs_tolerance[c] = ToAbsoluteTolerance(expected_rgba[c], tolerance[c],
+                                           is_tolerance_percent[c]);
+  }
+
+  // The dominant byte aligned formats are decoded and compared straight
+  // from their texel bytes with precomputed expectations, a tight loop
+  // the compiler can vectorize; the generic path below unpacks bit by
+  // bit and allocates per texel. Failing texels drop back to the generic
+  // decode only to build the error message.
+  std::vector<FastComponentCheck> fast_checks;
+  const bool use_fast_path = BuildFastComponentChecks(
+      command, framebuffer_format, abs_tolerance, &fast_checks);
+
   const uint8_t* ptr = static_cast<const uint8_t*>(buf);
+
+  // How the framebuffer's texels decode into doubles, derived once here
+  // so the per texel loop below neither re-walks the format's component
+  // list nor allocates.
+  ComponentLayout layout[kMaxTexelComponents];
+  const size_t component_count =
+      BuildComponentLayout(framebuffer_format, layout);
+
+  // Texels are independent, so the rows are checked by a pool of worker
+  // threads, each walking its own contiguous block of rows and keeping
+  // the first failure it sees.
+  struct RowBlockResult {
+    uint32_t count = 0;
+    uint32_t first_i = 0;
+    uint32_t first_j = 0;
+    std::vector<double> first_texel;
+  };
+
+  // On a sampled pass only texels whose mixed byte offset lands in
+  // bucket zero are checked. The salt folds the frame generation in, so
+  // each iteration of a soak loop scatters its subset over different
+  // texels and together the passes sweep the whole rectangle.
+  const bool sampled_pass = IsSampledPass();
+  const uint64_t sample_salt =
+      sampled_pass ? MixBits(sample_seed_ ^ frame_generation_) : 0;
+
+  auto probe_rows = [&](uint32_t row_begin, uint32_t row_end, bool use_cache,
+                        RowBlockResult* result) {
+    for (uint32_t j = row_begin; j < row_end; ++j) {
+      const uint8_t* p = ptr + row_stride * (j + y) + texel_stride * x;
+      for (uint32_t i = 0; i < width; ++i) {
+        const uint8_t* texel = p + texel_stride * i;
+
+        if (sampled_pass &&
+            MixBits(static_cast<uint64_t>(texel - ptr) ^ sample_salt) %
+                    sample_denominator_ !=
+                0) {
+          continue;
+        }
+
+        if (use_fast_path) {
+          bool is_good = true;
+          for (const auto& check : fast_checks) {
+            double actual;
+            if (check.is_float32) {
+              float value;
+              std::memcpy(&value, texel + check.byte_offset, sizeof(value));
+              actual = static_cast<double>(value);
+            } else {
+              actual = static_cast<double>(texel[check.byte_offset]) / 255.0;
+            }
+            if (std::fabs(check.expected - actual) > check.abs_tolerance) {
+              is_good = false;
+              break;
+            }
+          }
+          if (is_good)
+            continue;
+        }
+
+        // Scripts commonly probe the same frame many times; once a texel
+        // was decoded for this frame generation, later probes reuse the
+        // values instead of re-doing the format conversion.
+        std::array<double, kMaxTexelComponents> actual_texel_values{};
+        const uint64_t texel_key = static_cast<uint64_t>(texel - ptr);
+        bool decoded = false;
+        if (use_cache) {
+          auto it = decoded_texels_.find(texel_key);
+          if (it != decoded_texels_.end()) {
+            actual_texel_values = it->second;
+            decoded = true;
+          }
+        }
+        if (!decoded) {
+          DecodeTexel(texel, layout, component_count,
+                      actual_texel_values.data());
+          if (use_cache)
+            decoded_texels_[texel_key] = actual_texel_values;
+        }
+        if (use_fast_path ||
+            !IsTexelEqualToExpected(actual_texel_values.data(), layout,
+                                    component_count, command,
+                                    abs_tolerance)) {
+          if (!result->count) {
+            result->first_texel = GetTexelInRGBA(
+                actual_texel_values.data(), layout, component_count);
+            result->first_i = i;
+            result->first_j = j;
+          }
+          ++result->count;
+        }
+      }
+    }
+  };
+
+  uint32_t thread_count = std::thread::hardware_concurrency();
+  if (thread_count == 0)
+    thread_count = 1;
+  thread_count = std::min(thread_count, height);
+
+  std::vector<RowBlockResult> results(thread_count);
+  if (thread_count > 1 &&
+      static_cast<uint64_t>(width) * height >= kMinTexelsForParallelProbe) {
+    const uint32_t rows_per_thread =
+        (height + thread_count - 1) / thread_count;
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < thread_count; ++t) {
+      const uint32_t row_begin = t * rows_per_thread;
+      const uint32_t row_end = std::min(row_begin + rows_per_thread, height);
+      if (row_begin >= row_end)
+        break;
+      // The decode cache is not shared across worker threads; a probe
+      // large enough to go parallel rarely repeats anyway.
+      threads.emplace_back(probe_rows, row_begin, row_end, false, &results[t]);
+    }
+    for (auto& thread : threads)
+      thread.join();
+  } else {
+    probe_rows(0, height, frame_generation_set_, &results[0]);
+  }
+
+  // The blocks are contiguous and scanned in row major order, so merging
+  // them front to back reports the same first failing texel as a serial
+  // walk would.
   uint32_t count_of_invalid_pixels = 0;
   uint32_t first_invalid_i = 0;
   uint32_t first_invalid_j = 0;
   std::vector<double> actual_texel_values_on_failure;
-  for (uint32_t j = 0; j < height; ++j) {
-    const uint8_t* p = ptr + row_stride * (j + y) + texel_stride * x;
-    for (uint32_t i = 0; i < width; ++i) {
-      auto actual_texel_values =
-          GetActualValuesFromTexel(p + texel_stride * i, framebuffer_format);
-      ScaleTexelValuesIfNeeded(&actual_texel_values, framebuffer_format);
-      if (!IsTexelEqualToExpected(actual_texel_values, framebuffer_format,
-                                  command, tolerance, is_tolerance_percent)) {
-        if (!count_of_invalid_pixels) {
-          actual_texel_values_on_failure =
-              GetTexelInRGBA(actual_texel_values, framebuffer_format);
-          first_invalid_i = i;
-          first_invalid_j = j;
-        }
-        ++count_of_invalid_pixels;
-      }
+  for (const auto& result : results) {
+    if (result.count && !count_of_invalid_pixels) {
+      actual_texel_values_on_failure = result.first_texel;
+      first_invalid_i = result.first_i;
+      first_invalid_j = result.first_j;
     }
+    count_of_invalid_pixels += result.count;
   }
 
   if (count_of_invalid_pixels) {
@@ -646,10 +1213,33 @@ Result Verifier::ProbeSSBO(const ProbeSSBOCommand* command,
                            const void* cpu_memory) {
   const auto& values = command->GetValues();
   if (!cpu_memory) {
-    return values.empty() ? Result()
-                          : Result(
-                                "Verifier::ProbeSSBO actual data is empty "
-                                "while expected data is not");
+    return values.empty() && !command->IsChecksum()
+               ? Result()
+               : Result(
+                     "Verifier::ProbeSSBO actual data is empty "
+                     "while expected data is not");
+  }
+
+  if (command->IsChecksum()) {
+    size_t offset = static_cast<size_t>(command->GetOffset());
+    size_t checksum_size =
+        static_cast<size_t>(command->GetChecksumSizeInBytes());
+    if (offset + checksum_size > size_in_bytes) {
+      return Result(
+          "Line " + std::to_string(command->GetLine()) +
+          ": Verifier::ProbeSSBO checksum range exceeds the SSBO size");
+    }
+
+    uint64_t actual = HashBuffer(
+        static_cast<const uint8_t*>(cpu_memory) + offset, checksum_size);
+    if (actual != command->GetChecksum()) {
+      std::ostringstream out;
+      out << "Line " << command->GetLine()
+          << ": Verifier::ProbeSSBO checksum mismatch\n  Expected: 0x"
+          << std::hex << command->GetChecksum() << "\n  Actual: 0x" << actual;
+      return Result(out.str());
+    }
+    return {};
   }
 
   const auto& datum_type = command->GetDatumType();
@@ -670,29 +1260,84 @@ Result Verifier::ProbeSSBO(const ProbeSSBOCommand* command,
   }
 
   const uint8_t* ptr = static_cast<const uint8_t*>(cpu_memory) + offset;
+  const size_t max_failures =
+      max_reported_failures_ == 0 ? 1 : max_reported_failures_;
+
+  // A denominator of zero below makes CheckValue() compare every
+  // element; on a sampled pass the salt folds the frame generation in
+  // so successive iterations compare different subsets.
+  const uint32_t sample_denominator =
+      IsSampledPass() ? sample_denominator_ : 0;
+  const uint64_t sample_salt =
+      sample_denominator != 0 ? MixBits(sample_seed_ ^ frame_generation_) : 0;
   if (datum_type.IsInt8())
-    return CheckValue<int8_t>(command, ptr, values);
+    return CheckValue<int8_t>(command, ptr, values, max_failures,
+                      sample_denominator, sample_salt);
   if (datum_type.IsUint8())
-    return CheckValue<uint8_t>(command, ptr, values);
+    return CheckValue<uint8_t>(command, ptr, values, max_failures,
+                      sample_denominator, sample_salt);
   if (datum_type.IsInt16())
-    return CheckValue<int16_t>(command, ptr, values);
+    return CheckValue<int16_t>(command, ptr, values, max_failures,
+                      sample_denominator, sample_salt);
   if (datum_type.IsUint16())
-    return CheckValue<uint16_t>(command, ptr, values);
+    return CheckValue<uint16_t>(command, ptr, values, max_failures,
+                      sample_denominator, sample_salt);
   if (datum_type.IsInt32())
-    return CheckValue<int32_t>(command, ptr, values);
+    return CheckValue<int32_t>(command, ptr, values, max_failures,
+                      sample_denominator, sample_salt);
   if (datum_type.IsUint32())
-    return CheckValue<uint32_t>(command, ptr, values);
+    return CheckValue<uint32_t>(command, ptr, values, max_failures,
+                      sample_denominator, sample_salt);
   if (datum_type.IsInt64())
-    return CheckValue<int64_t>(command, ptr, values);
+    return CheckValue<int64_t>(command, ptr, values, max_failures,
+                      sample_denominator, sample_salt);
   if (datum_type.IsUint64())
-    return CheckValue<uint64_t>(command, ptr, values);
+    return CheckValue<uint64_t>(command, ptr, values, max_failures,
+                      sample_denominator, sample_salt);
   if (datum_type.IsFloat())
-    return CheckValue<float>(command, ptr, values);
+    return CheckValue<float>(command, ptr, values, max_failures,
+                      sample_denominator, sample_salt);
   if (datum_type.IsDouble())
-    return CheckValue<double>(command, ptr, values);
+    return CheckValue<double>(command, ptr, values, max_failures,
+                      sample_denominator, sample_salt);
 
   return Result("Line " + std::to_string(command->GetLine()) +
                 ": Verifier::ProbeSSBO unknown datum type");
 }
 
+Result Verifier::CompareImages(uint32_t width,
+                               uint32_t height,
+                               uint32_t texel_stride,
+                               uint32_t row_stride_a,
+                               const void* buf_a,
+                               uint32_t row_stride_b,
+                               const void* buf_b) {
+  const uint8_t* a = static_cast<const uint8_t*>(buf_a);
+  const uint8_t* b = static_cast<const uint8_t*>(buf_b);
+  const uint64_t row_bytes = static_cast<uint64_t>(width) * texel_stride;
+
+  for (uint32_t j = 0; j < height; ++j) {
+    const uint8_t* row_a = a + static_cast<uint64_t>(row_stride_a) * j;
+    const uint8_t* row_b = b + static_cast<uint64_t>(row_stride_b) * j;
+    if (std::memcmp(row_a, row_b, row_bytes) == 0)
+      continue;
+
+    for (uint32_t i = 0; i < width; ++i) {
+      const uint8_t* texel_a = row_a + texel_stride * i;
+      const uint8_t* texel_b = row_b + texel_stride * i;
+      for (uint32_t c = 0; c < texel_stride; ++c) {
+        if (texel_a[c] != texel_b[c]) {
+          return Result("Verifier::CompareImages frame mismatch at (" +
+                        std::to_string(i) + ", " + std::to_string(j) +
+                        ") byte " + std::to_string(c) + ", " +
+                        std::to_string(texel_a[c]) + " vs " +
+                        std::to_string(texel_b[c]));
+        }
+      }
+    }
+  }
+
+  return {};
+}
+
 }  // namespace amber
@@ -15,6 +15,8 @@
 #ifndef SRC_VERIFIER_H_
 #define SRC_VERIFIER_H_
 
+#include <array>
+#include <unordered_map>
 #include <vector>
 
 #include "amber/result.h"
@@ -45,6 +47,63 @@ class Verifier {
   Result ProbeSSBO(const ProbeSSBOCommand* command,
                    size_t size,
                    const void* cpu_memory);
+
+  /// Compares two rendered frames of |width| x |height| texels of
+  /// |texel_stride| bytes each, reporting the first texel whose bytes
+  /// differ. The frames may use different row strides. Used by
+  /// differential runs of one script on two engines.
+  Result CompareImages(uint32_t width,
+                       uint32_t height,
+                       uint32_t texel_stride,
+                       uint32_t row_stride_a,
+                       const void* buf_a,
+                       uint32_t row_stride_b,
+                       const void* buf_b);
+
+  /// Sets how many failing elements ProbeSSBO() reports before it stops
+  /// scanning. The default of 1 keeps the historical first-failure
+  /// message; raising it lists up to |count| failures, one per line. A
+  /// |count| of 0 is treated as 1.
+  void SetMaxReportedFailures(size_t count) { max_reported_failures_ = count; }
+
+  /// Identifies the rendered frame the next Probe() calls read. Texel
+  /// values decoded by one probe are reused by later probes of the same
+  /// generation; a new generation drops them. Without a generation no
+  /// caching happens.
+  void SetFrameGeneration(uint64_t generation);
+
+  /// Enables sampled verification for soak runs: Probe() and
+  /// ProbeSSBO() check only a deterministic pseudo-random subset of
+  /// roughly one in |denominator| elements, chosen from |seed| and the
+  /// current frame generation so successive iterations cover different
+  /// subsets and a persistent corruption is still found with high
+  /// probability. Generation zero and, when |full_check_interval| is
+  /// non-zero, every generation divisible by it are checked in full. A
+  /// |denominator| of 0 or 1 disables sampling. Checksum probes are
+  /// always evaluated in full since a partial hash would change the
+  /// value.
+  void SetSampledVerification(uint32_t denominator,
+                              uint64_t seed,
+                              uint64_t full_check_interval);
+
+ private:
+  /// True when the current frame generation checks only the sampled
+  /// subset rather than every element.
+  bool IsSampledPass() const;
+
+  size_t max_reported_failures_ = 1;
+
+  uint32_t sample_denominator_ = 0;
+  uint64_t sample_seed_ = 0;
+  uint64_t sample_full_interval_ = 0;
+
+  /// Texel values decoded from the current frame, keyed by the texel's
+  /// byte offset into the framebuffer. A texel has at most four
+  /// components. Only valid while |frame_generation_set_| is true and
+  /// |frame_generation_| matches the frame being probed.
+  std::unordered_map<uint64_t, std::array<double, 4>> decoded_texels_;
+  uint64_t frame_generation_ = 0;
+  bool frame_generation_set_ = false;
 };
 
 }  // namespace amber
@@ -0,0 +1,61 @@
+// Copyright 2018 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "src/command.h"
+#include "src/datum_type.h"
+#include "src/verifier.h"
+
+namespace amber {
+namespace {
+
+void BM_VerifierProbeSSBO(benchmark::State& state) {
+  const size_t kElements = 4096;
+
+  ProbeSSBOCommand probe_ssbo;
+
+  DatumType datum_type;
+  datum_type.SetType(DataType::kFloat);
+  probe_ssbo.SetDatumType(datum_type);
+
+  probe_ssbo.SetComparator(ProbeSSBOCommand::Comparator::kEqual);
+
+  std::vector<Value> values;
+  values.resize(kElements);
+  for (size_t i = 0; i < values.size(); ++i)
+    values[i].SetDoubleValue(static_cast<double>(i));
+  probe_ssbo.SetValues(std::move(values));
+
+  std::vector<float> ssbo(kElements);
+  for (size_t i = 0; i < ssbo.size(); ++i)
+    ssbo[i] = static_cast<float>(i);
+
+  Verifier verifier;
+  for (auto _ : state) {
+    Result r = verifier.ProbeSSBO(&probe_ssbo, ssbo.size() * sizeof(float),
+                                  ssbo.data());
+    if (!r.IsSuccess()) {
+      state.SkipWithError(r.Error().c_str());
+      break;
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(kElements));
+}
+BENCHMARK(BM_VerifierProbeSSBO);
+
+}  // namespace
+}  // namespace amber
@@ -12,6 +12,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <cstring>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -146,6 +148,29 @@ TEST_F(VerifierTest, ProbeFrameBufferRelativeSmallExpectFail) {
       r.Error());
 }
 
+TEST_F(VerifierTest, ProbeFrameBufferZeroAreaRect) {
+  ProbeCommand probe;
+  probe.SetProbeRect();
+  probe.SetIsRGBA();
+  probe.SetX(0.0f);
+  probe.SetY(0.0f);
+  probe.SetWidth(0.0f);
+  probe.SetHeight(0.0f);
+  probe.SetR(0.1f);
+  probe.SetG(0.2f);
+  probe.SetB(0.3f);
+  probe.SetA(0.4f);
+
+  uint8_t frame_buffer[3][3][4] = {};
+
+  // An empty rectangle has nothing to check and passes trivially, even
+  // though no texel matches the expected color.
+  Verifier verifier;
+  Result r = verifier.Probe(&probe, GetColorFormat(), 4, 12, 3, 3,
+                            static_cast<const void*>(frame_buffer));
+  EXPECT_TRUE(r.IsSuccess()) << r.Error();
+}
+
 TEST_F(VerifierTest, ProbeFrameBuffer) {
   ProbeCommand probe;
   probe.SetProbeRect();
@@ -229,6 +254,51 @@ TEST_F(VerifierTest, ProbeFrameBufferUInt16) {
   EXPECT_TRUE(r.IsSuccess());
 }
 
+TEST_F(VerifierTest, ProbeFrameBufferReusesDecodeForSameGeneration) {
+  ProbeCommand probe;
+  probe.SetIsRGBA();
+  probe.SetX(0.0f);
+  probe.SetY(0.0f);
+  probe.SetR(65535);
+  probe.SetG(14);
+  probe.SetB(1875);
+  probe.SetA(8);
+
+  uint16_t frame_buffer[4] = {65535, 14, 1875, 8};
+
+  Format format;
+  format.SetFormatType(FormatType::kR16G16B16A16_UINT);
+  format.AddComponent(FormatComponentType::kR, FormatMode::kUInt, 16);
+  format.AddComponent(FormatComponentType::kG, FormatMode::kUInt, 16);
+  format.AddComponent(FormatComponentType::kB, FormatMode::kUInt, 16);
+  format.AddComponent(FormatComponentType::kA, FormatMode::kUInt, 16);
+
+  Verifier verifier;
+  verifier.SetFrameGeneration(1);
+  Result r = verifier.Probe(&probe, &format,
+                            4 * static_cast<uint32_t>(sizeof(uint16_t)),
+                            4 * static_cast<uint32_t>(sizeof(uint16_t)), 1, 1,
+                            static_cast<const void*>(&frame_buffer));
+  EXPECT_TRUE(r.IsSuccess());
+
+  // The generation did not change, so the probe reuses the texel decoded
+  // above and never looks at the changed bytes.
+  frame_buffer[1] = 0;
+  r = verifier.Probe(&probe, &format,
+                     4 * static_cast<uint32_t>(sizeof(uint16_t)),
+                     4 * static_cast<uint32_t>(sizeof(uint16_t)), 1, 1,
+                     static_cast<const void*>(&frame_buffer));
+  EXPECT_TRUE(r.IsSuccess());
+
+  // A new generation drops the cache and the changed bytes are seen.
+  verifier.SetFrameGeneration(2);
+  r = verifier.Probe(&probe, &format,
+                     4 * static_cast<uint32_t>(sizeof(uint16_t)),
+                     4 * static_cast<uint32_t>(sizeof(uint16_t)), 1, 1,
+                     static_cast<const void*>(&frame_buffer));
+  EXPECT_FALSE(r.IsSuccess());
+}
+
 TEST_F(VerifierTest, ProbeFrameBufferUInt32) {
   ProbeCommand probe;
   probe.SetIsRGBA();
@@ -631,6 +701,63 @@ TEST_F(VerifierTest, ProbeFrameBufferBadRowStride) {
       r.Error());
 }
 
+TEST_F(VerifierTest, ProbeSSBOChecksum) {
+  std::vector<uint8_t> ssbo(20);
+  for (size_t i = 0; i < ssbo.size(); ++i)
+    ssbo[i] = static_cast<uint8_t>(i * 3);
+
+  // The same word-folding FNV-1a variant the verifier hashes the
+  // readback with.
+  uint64_t expected = 0xcbf29ce484222325ull;
+  size_t word_count = ssbo.size() / sizeof(uint64_t);
+  for (size_t i = 0; i < word_count; ++i) {
+    uint64_t word;
+    memcpy(&word, ssbo.data() + i * sizeof(uint64_t), sizeof(word));
+    expected = (expected ^ word) * 0x100000001b3ull;
+  }
+  for (size_t i = word_count * sizeof(uint64_t); i < ssbo.size(); ++i)
+    expected = (expected ^ ssbo[i]) * 0x100000001b3ull;
+
+  ProbeSSBOCommand probe_ssbo;
+  probe_ssbo.SetChecksum(expected, static_cast<uint32_t>(ssbo.size()));
+
+  Verifier verifier;
+  Result r = verifier.ProbeSSBO(&probe_ssbo, ssbo.size(),
+                                static_cast<const void*>(ssbo.data()));
+  EXPECT_TRUE(r.IsSuccess()) << r.Error();
+}
+
+TEST_F(VerifierTest, ProbeSSBOChecksumMismatch) {
+  std::vector<uint8_t> ssbo(20, 7);
+
+  ProbeSSBOCommand probe_ssbo;
+  probe_ssbo.SetChecksum(1, static_cast<uint32_t>(ssbo.size()));
+
+  Verifier verifier;
+  Result r = verifier.ProbeSSBO(&probe_ssbo, ssbo.size(),
+                                static_cast<const void*>(ssbo.data()));
+  ASSERT_FALSE(r.IsSuccess());
+  EXPECT_TRUE(r.Error().find("ProbeSSBO checksum mismatch") !=
+              std::string::npos)
+      << r.Error();
+}
+
+TEST_F(VerifierTest, ProbeSSBOChecksumRangeTooLarge) {
+  std::vector<uint8_t> ssbo(20, 7);
+
+  ProbeSSBOCommand probe_ssbo;
+  probe_ssbo.SetOffset(8);
+  probe_ssbo.SetChecksum(1, static_cast<uint32_t>(ssbo.size()));
+
+  Verifier verifier;
+  Result r = verifier.ProbeSSBO(&probe_ssbo, ssbo.size(),
+                                static_cast<const void*>(ssbo.data()));
+  ASSERT_FALSE(r.IsSuccess());
+  EXPECT_TRUE(r.Error().find("checksum range exceeds the SSBO size") !=
+              std::string::npos)
+      << r.Error();
+}
+
 TEST_F(VerifierTest, ProbeSSBOUint8Single) {
   ProbeSSBOCommand probe_ssbo;
 
@@ -952,6 +1079,183 @@ TEST_F(VerifierTest, ProbeSSBOEqualFail) {
             r.Error());
 }
 
+TEST_F(VerifierTest, ProbeSSBOEqualFailReportsUpToMaxFailures) {
+  ProbeSSBOCommand probe_ssbo;
+
+  DatumType datum_type;
+  datum_type.SetType(DataType::kDouble);
+  probe_ssbo.SetDatumType(datum_type);
+
+  probe_ssbo.SetComparator(ProbeSSBOCommand::Comparator::kEqual);
+
+  std::vector<Value> values;
+  values.resize(4);
+  values[0].SetDoubleValue(2.9);
+  values[1].SetDoubleValue(0.73);
+  values[2].SetDoubleValue(10.0);
+  values[3].SetDoubleValue(1234.56);
+  probe_ssbo.SetValues(std::move(values));
+
+  const double ssbo[4] = {2.8, 0.72, 9.0, 1234.55};
+
+  Verifier verifier;
+  verifier.SetMaxReportedFailures(2);
+  Result r = verifier.ProbeSSBO(&probe_ssbo, sizeof(double) * 4, ssbo);
+  EXPECT_FALSE(r.IsSuccess());
+  EXPECT_EQ(
+      "Line 1: Verifier failed: 2.800000 == 2.900000, at index 0\n"
+      "Line 1: Verifier failed: 0.720000 == 0.730000, at index 1",
+      r.Error());
+}
+
+TEST_F(VerifierTest, SampledProbeSSBOChecksSubsetPerPass) {
+  ProbeSSBOCommand probe_ssbo;
+
+  DatumType datum_type;
+  datum_type.SetType(DataType::kUint32);
+  probe_ssbo.SetDatumType(datum_type);
+
+  probe_ssbo.SetComparator(ProbeSSBOCommand::Comparator::kEqual);
+
+  std::vector<Value> values;
+  values.resize(64);
+  for (auto& value : values)
+    value.SetIntValue(1);
+  probe_ssbo.SetValues(std::move(values));
+
+  // Every element differs from the expectation.
+  const std::vector<uint32_t> ssbo(64, 0);
+
+  Verifier verifier;
+  verifier.SetMaxReportedFailures(64);
+  verifier.SetSampledVerification(8, 42, 0);
+  verifier.SetFrameGeneration(1);
+  Result r = verifier.ProbeSSBO(&probe_ssbo, sizeof(uint32_t) * ssbo.size(),
+                                ssbo.data());
+  ASSERT_FALSE(r.IsSuccess());
+
+  // Roughly one in eight elements is checked; the skipped ones do not
+  // show up as failures even though all of them differ.
+  const size_t reported = 1 + static_cast<size_t>(std::count(
+                                  r.Error().begin(), r.Error().end(), '\n'));
+  EXPECT_LT(reported, 64U);
+}
+
+TEST_F(VerifierTest, SampledProbeSSBOIsDeterministic) {
+  ProbeSSBOCommand probe_ssbo;
+
+  DatumType datum_type;
+  datum_type.SetType(DataType::kUint32);
+  probe_ssbo.SetDatumType(datum_type);
+
+  probe_ssbo.SetComparator(ProbeSSBOCommand::Comparator::kEqual);
+
+  std::vector<Value> values;
+  values.resize(64);
+  for (auto& value : values)
+    value.SetIntValue(1);
+  probe_ssbo.SetValues(std::move(values));
+
+  const std::vector<uint32_t> ssbo(64, 0);
+
+  // Two verifiers with the same seed and generation check the same
+  // subset and report the same failures.
+  Verifier verifier_a;
+  verifier_a.SetMaxReportedFailures(64);
+  verifier_a.SetSampledVerification(8, 42, 0);
+  verifier_a.SetFrameGeneration(1);
+  Result r_a = verifier_a.ProbeSSBO(&probe_ssbo, sizeof(uint32_t) * ssbo.size(),
+                                    ssbo.data());
+
+  Verifier verifier_b;
+  verifier_b.SetMaxReportedFailures(64);
+  verifier_b.SetSampledVerification(8, 42, 0);
+  verifier_b.SetFrameGeneration(1);
+  Result r_b = verifier_b.ProbeSSBO(&probe_ssbo, sizeof(uint32_t) * ssbo.size(),
+                                    ssbo.data());
+
+  ASSERT_FALSE(r_a.IsSuccess());
+  ASSERT_FALSE(r_b.IsSuccess());
+  EXPECT_EQ(r_a.Error(), r_b.Error());
+
+  // A later generation draws a different subset.
+  verifier_b.SetFrameGeneration(2);
+  r_b = verifier_b.ProbeSSBO(&probe_ssbo, sizeof(uint32_t) * ssbo.size(),
+                             ssbo.data());
+  ASSERT_FALSE(r_b.IsSuccess());
+  EXPECT_NE(r_a.Error(), r_b.Error());
+}
+
+TEST_F(VerifierTest, SampledProbeSSBOFullCheckEveryInterval) {
+  ProbeSSBOCommand probe_ssbo;
+
+  DatumType datum_type;
+  datum_type.SetType(DataType::kUint32);
+  probe_ssbo.SetDatumType(datum_type);
+
+  probe_ssbo.SetComparator(ProbeSSBOCommand::Comparator::kEqual);
+
+  std::vector<Value> values;
+  values.resize(4);
+  for (auto& value : values)
+    value.SetIntValue(1);
+  probe_ssbo.SetValues(std::move(values));
+
+  const std::vector<uint32_t> ssbo(4, 0);
+
+  // The density is so sparse that no element of this small buffer is
+  // sampled; only the full passes can see the corruption.
+  Verifier verifier;
+  verifier.SetSampledVerification(1U << 30U, 7, 4);
+
+  // Generation zero always checks in full.
+  verifier.SetFrameGeneration(0);
+  Result r = verifier.ProbeSSBO(&probe_ssbo, sizeof(uint32_t) * ssbo.size(),
+                                ssbo.data());
+  EXPECT_FALSE(r.IsSuccess());
+
+  // A sampled pass skips everything here.
+  verifier.SetFrameGeneration(1);
+  r = verifier.ProbeSSBO(&probe_ssbo, sizeof(uint32_t) * ssbo.size(),
+                         ssbo.data());
+  EXPECT_TRUE(r.IsSuccess()) << r.Error();
+
+  // Every fourth generation checks in full again.
+  verifier.SetFrameGeneration(4);
+  r = verifier.ProbeSSBO(&probe_ssbo, sizeof(uint32_t) * ssbo.size(),
+                         ssbo.data());
+  EXPECT_FALSE(r.IsSuccess());
+}
+
+TEST_F(VerifierTest, SampledProbeFrameBufferFullCheckEveryInterval) {
+  ProbeCommand probe;
+  probe.SetWholeWindow();
+  probe.SetProbeRect();
+  probe.SetIsRGBA();
+  probe.SetB(0.5f);
+  probe.SetG(0.25f);
+  probe.SetR(0.2f);
+  probe.SetA(0.8f);
+
+  // Every texel differs from the expectation.
+  const uint8_t frame_buffer[3][3][4] = {};
+
+  Verifier verifier;
+  verifier.SetSampledVerification(1U << 30U, 3, 2);
+
+  // The sampled pass skips all nine texels of this tiny frame.
+  verifier.SetFrameGeneration(1);
+  Result r = verifier.Probe(&probe, GetColorFormat(), 4, 12, 3, 3,
+                            static_cast<const void*>(frame_buffer));
+  EXPECT_TRUE(r.IsSuccess()) << r.Error();
+
+  // The next generation is a full pass and sees the corruption.
+  verifier.SetFrameGeneration(2);
+  r = verifier.Probe(&probe, GetColorFormat(), 4, 12, 3, 3,
+                     static_cast<const void*>(frame_buffer));
+  EXPECT_FALSE(r.IsSuccess());
+}
+
 TEST_F(VerifierTest, ProbeSSBOFuzzyEqualWithAbsoluteTolerance) {
   ProbeSSBOCommand probe_ssbo;
 
@@ -1353,4 +1657,36 @@ TEST_F(VerifierTest, CheckRGBAOrderForFailure) {
       r.Error());
 }
 
+TEST_F(VerifierTest, CompareImagesMatch) {
+  uint8_t frame_a[16] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+  uint8_t frame_b[16] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+
+  Verifier verifier;
+  Result r = verifier.CompareImages(2U, 2U, 4U, 8U, frame_a, 8U, frame_b);
+  EXPECT_TRUE(r.IsSuccess()) << r.Error();
+}
+
+TEST_F(VerifierTest, CompareImagesMismatch) {
+  uint8_t frame_a[16] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+  uint8_t frame_b[16] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 99, 12, 13, 14, 15, 16};
+
+  Verifier verifier;
+  Result r = verifier.CompareImages(2U, 2U, 4U, 8U, frame_a, 8U, frame_b);
+  EXPECT_FALSE(r.IsSuccess());
+  EXPECT_EQ("Verifier::CompareImages frame mismatch at (0, 1) byte 2, 11 vs 99",
+            r.Error());
+}
+
+TEST_F(VerifierTest, CompareImagesDifferentRowStrides) {
+  // Frame b pads each row to 12 bytes; only the leading 8 bytes of each
+  // row carry texels and must match frame a's tightly packed rows.
+  uint8_t frame_a[16] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+  uint8_t frame_b[24] = {1, 2,  3,  4,  5,  6,  7,  8,  0, 0, 0, 0,
+                         9, 10, 11, 12, 13, 14, 15, 16, 0, 0, 0, 0};
+
+  Verifier verifier;
+  Result r = verifier.CompareImages(2U, 2U, 4U, 8U, frame_a, 12U, frame_b);
+  EXPECT_TRUE(r.IsSuccess()) << r.Error();
+}
+
 }  // namespace amber
@@ -17,6 +17,7 @@
 #include <algorithm>
 #include <cassert>
 #include <cctype>
+#include <cstring>
 #include <limits>
 #include <string>
 #include <utility>
@@ -50,6 +51,21 @@ ShaderType ShaderNameToType(const std::string& name) {
 CommandParser::CommandParser(size_t current_line, const std::string& data)
     : tokenizer_(MakeUnique<Tokenizer>(data)) {
   tokenizer_->SetCurrentLine(current_line);
+
+  // At most one command per input line; reserving up front avoids the
+  // repeated reallocation-and-move of the unique_ptrs on large test blocks.
+  commands_.reserve(
+      static_cast<size_t>(std::count(data.begin(), data.end(), '\n')) + 1);
+}
+
+CommandParser::CommandParser(size_t current_line,
+                             const char* data,
+                             size_t size)
+    : tokenizer_(MakeUnique<Tokenizer>(data, size)) {
+  tokenizer_->SetCurrentLine(current_line);
+
+  commands_.reserve(
+      static_cast<size_t>(std::count(data, data + size, '\n')) + 1);
 }
 
 CommandParser::~CommandParser() = default;
@@ -89,153 +105,155 @@ Result CommandParser::Parse() {
           token->ToOriginalString()));
     }
 
-    std::string cmd_name = token->AsString();
+    // The tokenizer already classified the dispatch keywords, so the
+    // common commands switch on an integer without touching the token
+    // text.
     Result r;
-    if (cmd_name == "draw") {
-      token = tokenizer_->NextToken();
-      if (!token->IsString())
-        return Result(make_error("Invalid draw command in test: " +
-                                 token->ToOriginalString()));
-
-      cmd_name = token->AsString();
-      if (cmd_name == "rect")
-        r = ProcessDrawRect();
-      else if (cmd_name == "arrays")
-        r = ProcessDrawArrays();
-      else
-        r = Result("Unknown draw command: " + cmd_name);
-
-    } else if (cmd_name == "clear") {
-      r = ProcessClear();
-    } else if (cmd_name == "ssbo") {
-      r = ProcessSSBO();
-    } else if (cmd_name == "uniform") {
-      r = ProcessUniform();
-    } else if (cmd_name == "patch") {
-      r = ProcessPatch();
-    } else if (cmd_name == "probe") {
-      r = ProcessProbe(false);
-    } else if (cmd_name == "tolerance") {
-      r = ProcessTolerance();
-    } else if (cmd_name == "relative") {
-      token = tokenizer_->NextToken();
-      if (!token->IsString() || token->AsString() != "probe")
-        return Result(make_error("relative must be used with probe: " +
-                                 token->ToOriginalString()));
-
-      r = ProcessProbe(true);
-    } else if (cmd_name == "compute") {
-      r = ProcessCompute();
-    } else if (cmd_name == "vertex" || cmd_name == "fragment" ||
-               cmd_name == "geometry" || cmd_name == "tessellation") {
-      std::string shader_name = cmd_name;
-      if (cmd_name == "tessellation") {
+    bool handled = true;
+    switch (token->GetKeyword()) {
+      case KeywordType::kDraw: {
+        token = tokenizer_->NextToken();
+        if (!token->IsString())
+          return Result(make_error("Invalid draw command in test: " +
+                                   token->ToOriginalString()));
+
+        if (token->GetKeyword() == KeywordType::kRect)
+          r = ProcessDrawRect();
+        else if (token->GetKeyword() == KeywordType::kArrays)
+          r = ProcessDrawArrays();
+        else
+          r = Result("Unknown draw command: " + token->AsString());
+        break;
+      }
+      case KeywordType::kClear:
+        r = ProcessClear();
+        break;
+      case KeywordType::kSsbo:
+        r = ProcessSSBO();
+        break;
+      case KeywordType::kUniform:
+        r = ProcessUniform();
+        break;
+      case KeywordType::kPatch:
+        r = ProcessPatch();
+        break;
+      case KeywordType::kProbe:
+        r = ProcessProbe(false);
+        break;
+      case KeywordType::kTolerance:
+        r = ProcessTolerance();
+        break;
+      case KeywordType::kRelative:
         token = tokenizer_->NextToken();
-        if (!token->IsString() || (token->AsString() != "control" &&
-                                   token->AsString() != "evaluation")) {
-          return Result(
-              make_error("Tessellation entrypoint must have "
-                         "<evaluation|control> in name: " +
-                         token->ToOriginalString()));
+        if (token->GetKeyword() != KeywordType::kProbe)
+          return Result(make_error("relative must be used with probe: " +
+                                   token->ToOriginalString()));
+
+        r = ProcessProbe(true);
+        break;
+      case KeywordType::kCompute:
+        r = ProcessCompute();
+        break;
+      case KeywordType::kVertex:
+      case KeywordType::kFragment:
+      case KeywordType::kGeometry:
+      case KeywordType::kTessellation: {
+        std::string shader_name = token->AsString();
+        if (token->GetKeyword() == KeywordType::kTessellation) {
+          token = tokenizer_->NextToken();
+          if (!token->IsString() || (token->AsString() != "control" &&
+                                     token->AsString() != "evaluation")) {
+            return Result(
+                make_error("Tessellation entrypoint must have "
+                           "<evaluation|control> in name: " +
+                           token->ToOriginalString()));
+          }
+          shader_name += " " + token->AsString();
         }
-        shader_name += " " + token->AsString();
+
+        token = tokenizer_->NextToken();
+        if (!token->IsString() || token->AsString() != "entrypoint")
+          return Result(make_error("Unknown command: " + shader_name));
+
+        r = ProcessEntryPoint(shader_name);
+        break;
       }
+      default:
+        handled = false;
+        break;
+    }
 
-      token = tokenizer_->NextToken();
-      if (!token->IsString() || token->AsString() != "entrypoint")
-        return Result(make_error("Unknown command: " + shader_name));
-
-      r = ProcessEntryPoint(shader_name);
-
-      // Pipeline Commands
-    } else if (cmd_name == "primitiveRestartEnable") {
-      r = ProcessPrimitiveRestartEnable();
-    } else if (cmd_name == "depthClampEnable") {
-      r = ProcessDepthClampEnable();
-    } else if (cmd_name == "rasterizerDiscardEnable") {
-      r = ProcessRasterizerDiscardEnable();
-    } else if (cmd_name == "depthBiasEnable") {
-      r = ProcessDepthBiasEnable();
-    } else if (cmd_name == "logicOpEnable") {
-      r = ProcessLogicOpEnable();
-    } else if (cmd_name == "blendEnable") {
-      r = ProcessBlendEnable();
-    } else if (cmd_name == "depthTestEnable") {
-      r = ProcessDepthTestEnable();
-    } else if (cmd_name == "depthWriteEnable") {
-      r = ProcessDepthWriteEnable();
-    } else if (cmd_name == "depthBoundsTestEnable") {
-      r = ProcessDepthBoundsTestEnable();
-    } else if (cmd_name == "stencilTestEnable") {
-      r = ProcessStencilTestEnable();
-    } else if (cmd_name == "topology") {
-      r = ProcessTopology();
-    } else if (cmd_name == "polygonMode") {
-      r = ProcessPolygonMode();
-    } else if (cmd_name == "logicOp") {
-      r = ProcessLogicOp();
-    } else if (cmd_name == "frontFace") {
-      r = ProcessFrontFace();
-    } else if (cmd_name == "cullMode") {
-      r = ProcessCullMode();
-    } else if (cmd_name == "depthBiasConstantFactor") {
-      r = ProcessDepthBiasConstantFactor();
-    } else if (cmd_name == "depthBiasClamp") {
-      r = ProcessDepthBiasClamp();
-    } else if (cmd_name == "depthBiasSlopeFactor") {
-      r = ProcessDepthBiasSlopeFactor();
-    } else if (cmd_name == "lineWidth") {
-      r = ProcessLineWidth();
-    } else if (cmd_name == "minDepthBounds") {
-      r = ProcessMinDepthBounds();
-    } else if (cmd_name == "maxDepthBounds") {
-      r = ProcessMaxDepthBounds();
-    } else if (cmd_name == "srcColorBlendFactor") {
-      r = ProcessSrcColorBlendFactor();
-    } else if (cmd_name == "dstColorBlendFactor") {
-      r = ProcessDstColorBlendFactor();
-    } else if (cmd_name == "srcAlphaBlendFactor") {
-      r = ProcessSrcAlphaBlendFactor();
-    } else if (cmd_name == "dstAlphaBlendFactor") {
-      r = ProcessDstAlphaBlendFactor();
-    } else if (cmd_name == "colorBlendOp") {
-      r = ProcessColorBlendOp();
-    } else if (cmd_name == "alphaBlendOp") {
-      r = ProcessAlphaBlendOp();
-    } else if (cmd_name == "depthCompareOp") {
-      r = ProcessDepthCompareOp();
-    } else if (cmd_name == "front.compareOp") {
-      r = ProcessFrontCompareOp();
-    } else if (cmd_name == "back.compareOp") {
-      r = ProcessBackCompareOp();
-    } else if (cmd_name == "front.failOp") {
-      r = ProcessFrontFailOp();
-    } else if (cmd_name == "front.passOp") {
-      r = ProcessFrontPassOp();
-    } else if (cmd_name == "front.depthFailOp") {
-      r = ProcessFrontDepthFailOp();
-    } else if (cmd_name == "back.failOp") {
-      r = ProcessBackFailOp();
-    } else if (cmd_name == "back.passOp") {
-      r = ProcessBackPassOp();
-    } else if (cmd_name == "back.depthFailOp") {
-      r = ProcessBackDepthFailOp();
-    } else if (cmd_name == "front.compareMask") {
-      r = ProcessFrontCompareMask();
-    } else if (cmd_name == "front.writeMask") {
-      r = ProcessFrontWriteMask();
-    } else if (cmd_name == "back.compareMask") {
-      r = ProcessBackCompareMask();
-    } else if (cmd_name == "back.writeMask") {
-      r = ProcessBackWriteMask();
-    } else if (cmd_name == "front.reference") {
-      r = ProcessFrontReference();
-    } else if (cmd_name == "back.reference") {
-      r = ProcessBackReference();
-    } else if (cmd_name == "colorWriteMask") {
-      r = ProcessColorWriteMask();
-    } else {
-      r = Result("Unknown command: " + cmd_name);
+    // Pipeline Commands
+    if (!handled) {
+      std::string cmd_name = token->AsString();
+      struct PipelineCommand {
+        const char* name;
+        Result (CommandParser::*process)();
+      };
+      // Sorted by name so the lookup can binary search. Keep the table
+      // sorted when adding new pipeline commands.
+      static const PipelineCommand kPipelineCommands[] = {
+          {"alphaBlendOp", &CommandParser::ProcessAlphaBlendOp},
+          {"back.compareMask", &CommandParser::ProcessBackCompareMask},
+          {"back.compareOp", &CommandParser::ProcessBackCompareOp},
+          {"back.depthFailOp", &CommandParser::ProcessBackDepthFailOp},
+          {"back.failOp", &CommandParser::ProcessBackFailOp},
+          {"back.passOp", &CommandParser::ProcessBackPassOp},
+          {"back.reference", &CommandParser::ProcessBackReference},
+          {"back.writeMask", &CommandParser::ProcessBackWriteMask},
+          {"blendEnable", &CommandParser::ProcessBlendEnable},
+          {"colorBlendOp", &CommandParser::ProcessColorBlendOp},
+          {"colorWriteMask", &CommandParser::ProcessColorWriteMask},
+          {"cullMode", &CommandParser::ProcessCullMode},
+          {"depthBiasClamp", &CommandParser::ProcessDepthBiasClamp},
+          {"depthBiasConstantFactor",
+           &CommandParser::ProcessDepthBiasConstantFactor},
+          {"depthBiasEnable", &CommandParser::ProcessDepthBiasEnable},
+          {"depthBiasSlopeFactor", &CommandParser::ProcessDepthBiasSlopeFactor},
+          {"depthBoundsTestEnable",
+           &CommandParser::ProcessDepthBoundsTestEnable},
+          {"depthClampEnable", &CommandParser::ProcessDepthClampEnable},
+          {"depthCompareOp", &CommandParser::ProcessDepthCompareOp},
+          {"depthTestEnable", &CommandParser::ProcessDepthTestEnable},
+          {"depthWriteEnable", &CommandParser::ProcessDepthWriteEnable},
+          {"dstAlphaBlendFactor", &CommandParser::ProcessDstAlphaBlendFactor},
+          {"dstColorBlendFactor", &CommandParser::ProcessDstColorBlendFactor},
+          {"front.compareMask", &CommandParser::ProcessFrontCompareMask},
+          {"front.compareOp", &CommandParser::ProcessFrontCompareOp},
+          {"front.depthFailOp", &CommandParser::ProcessFrontDepthFailOp},
+          {"front.failOp", &CommandParser::ProcessFrontFailOp},
+          {"front.passOp", &CommandParser::ProcessFrontPassOp},
+          {"front.reference", &CommandParser::ProcessFrontReference},
+          {"front.writeMask", &CommandParser::ProcessFrontWriteMask},
+          {"frontFace", &CommandParser::ProcessFrontFace},
+          {"lineWidth", &CommandParser::ProcessLineWidth},
+          {"logicOp", &CommandParser::ProcessLogicOp},
+          {"logicOpEnable", &CommandParser::ProcessLogicOpEnable},
+          {"maxDepthBounds", &CommandParser::ProcessMaxDepthBounds},
+          {"minDepthBounds", &CommandParser::ProcessMinDepthBounds},
+          {"polygonMode", &CommandParser::ProcessPolygonMode},
+          {"primitiveRestartEnable",
+           &CommandParser::ProcessPrimitiveRestartEnable},
+          {"rasterizerDiscardEnable",
+           &CommandParser::ProcessRasterizerDiscardEnable},
+          {"srcAlphaBlendFactor", &CommandParser::ProcessSrcAlphaBlendFactor},
+          {"srcColorBlendFactor", &CommandParser::ProcessSrcColorBlendFactor},
+          {"stencilTestEnable", &CommandParser::ProcessStencilTestEnable},
+          {"topology", &CommandParser::ProcessTopology},
+      };
+
+      const PipelineCommand* table_end =
+          kPipelineCommands +
+          sizeof(kPipelineCommands) / sizeof(kPipelineCommands[0]);
+      const PipelineCommand* it = std::lower_bound(
+          kPipelineCommands, table_end, cmd_name,
+          [](const PipelineCommand& lhs, const std::string& rhs) {
+            return std::strcmp(lhs.name, rhs.c_str()) < 0;
+          });
+      if (it != table_end && cmd_name == it->name)
+        r = (this->*it->process)();
+      else
+        r = Result("Unknown command: " + cmd_name);
     }
 
     if (!r.IsSuccess())
@@ -366,6 +384,13 @@ Result CommandParser::ProcessCompute() {
   if (token->IsString() && token->AsString() == "entrypoint")
     return ProcessEntryPoint("compute");
 
+  // An optional "parallel" marks the dispatch as data-parallel, allowing
+  // the engine to split the workgroup range into independent slices.
+  if (token->IsString() && token->AsString() == "parallel") {
+    cmd->SetDataParallel();
+    token = tokenizer_->NextToken();
+  }
+
   if (!token->IsInteger())
     return Result("Missing integer value for compute X entry: " +
                   token->ToOriginalString());
@@ -473,11 +498,19 @@ Result CommandParser::ParseValues(const std::string& name,
                                   std::vector<Value>* values) {
   assert(values);
 
-  auto token = tokenizer_->NextToken();
-  while (!token->IsEOL() && !token->IsEOS()) {
-    Value v;
+  bool as_double = type.IsFloat() || type.IsDouble();
+  for (;;) {
+    // Bulk-scan runs of plain decimal literals straight out of the script
+    // text; only unusual tokens (hex, malformed input, end of line) go
+    // through the tokenizer.
+    tokenizer_->ReadNumericValues(as_double, values);
+
+    auto token = tokenizer_->NextToken();
+    if (token->IsEOL() || token->IsEOS())
+      break;
 
-    if ((type.IsFloat() || type.IsDouble())) {
+    Value v;
+    if (as_double) {
       if (!token->IsInteger() && !token->IsDouble()) {
         return Result(std::string("Invalid value provided to ") + name +
                       " command: " + token->ToOriginalString());
@@ -498,7 +531,6 @@ Result CommandParser::ParseValues(const std::string& name,
     }
 
     values->push_back(v);
-    token = tokenizer_->NextToken();
   }
 
   size_t seen = values->size();
@@ -513,6 +545,138 @@ Result CommandParser::ParseValues(const std::string& name,
   return {};
 }
 
+Result CommandParser::ParseDataFileReference(const std::string& name,
+                                             BufferCommand* cmd) {
+  auto token = tokenizer_->NextToken();
+  if (!token->IsString())
+    return Result("Missing data file path for " + name + " command");
+
+  cmd->SetDataFilePath(token->AsString());
+
+  token = tokenizer_->NextToken();
+  if (token->IsEOL() || token->IsEOS())
+    return Result("Missing offset for " + name + " command");
+  if (!token->IsInteger())
+    return Result("Invalid offset for " + name + " command: " +
+                  token->ToOriginalString());
+
+  cmd->SetOffset(token->AsUint32());
+
+  token = tokenizer_->NextToken();
+  if (token->IsEOL() || token->IsEOS())
+    return {};
+  if (!token->IsInteger())
+    return Result("Invalid data file offset for " + name + " command: " +
+                  token->ToOriginalString());
+
+  cmd->SetDataFileOffset(token->AsUint64());
+
+  token = tokenizer_->NextToken();
+  if (token->IsEOL() || token->IsEOS())
+    return {};
+  if (!token->IsInteger())
+    return Result("Invalid data file byte count for " + name + " command: " +
+                  token->ToOriginalString());
+
+  cmd->SetDataFileSize(token->AsUint64());
+
+  token = tokenizer_->NextToken();
+  if (!token->IsEOS() && !token->IsEOL())
+    return Result("Extra parameter for " + name + " command: " +
+                  token->ToOriginalString());
+
+  return {};
+}
+
+Result CommandParser::ParseBufferGenerator(const std::string& name,
+                                           bool series,
+                                           BufferCommand* cmd) {
+  const std::string form = series ? "series_from" : "fill";
+  bool as_double =
+      cmd->GetDatumType().IsFloat() || cmd->GetDatumType().IsDouble();
+
+  auto token = tokenizer_->NextToken();
+  if (token->IsEOL() || token->IsEOS())
+    return Result("Missing offset for " + name + " " + form + " command");
+  if (!token->IsInteger())
+    return Result("Invalid offset for " + name + " " + form + " command: " +
+                  token->ToOriginalString());
+
+  cmd->SetOffset(token->AsUint32());
+
+  token = tokenizer_->NextToken();
+  if (token->IsEOL() || token->IsEOS())
+    return Result("Missing count for " + name + " " + form + " command");
+  if (!token->IsInteger() || token->AsUint32() == 0)
+    return Result("Invalid count for " + name + " " + form + " command: " +
+                  token->ToOriginalString());
+
+  uint32_t item_count = token->AsUint32();
+
+  Value start;
+  Result r = ParseGeneratorValue(name + " " + form, as_double, &start);
+  if (!r.IsSuccess())
+    return r;
+
+  if (!series) {
+    cmd->SetGeneratorFill(start, item_count);
+  } else {
+    if (cmd->GetDatumType().RowCount() > 1 ||
+        cmd->GetDatumType().ColumnCount() > 1) {
+      return Result(name + " " + form +
+                    " must not use multi-row/column types");
+    }
+
+    token = tokenizer_->NextToken();
+    if (!token->IsString() || token->AsString() != "inc_by")
+      return Result("Missing inc_by for " + name + " " + form + " command");
+
+    Value step;
+    r = ParseGeneratorValue(name + " " + form, as_double, &step);
+    if (!r.IsSuccess())
+      return r;
+
+    cmd->SetGeneratorSeries(start, step, item_count);
+  }
+
+  token = tokenizer_->NextToken();
+  if (!token->IsEOS() && !token->IsEOL())
+    return Result("Extra parameter for " + name + " " + form + " command: " +
+                  token->ToOriginalString());
+
+  return {};
+}
+
+Result CommandParser::ParseGeneratorValue(const std::string& name,
+                                          bool as_double,
+                                          Value* value) {
+  auto token = tokenizer_->NextToken();
+  if (token->IsEOL() || token->IsEOS())
+    return Result("Missing value for " + name + " command");
+
+  if (as_double) {
+    if (!token->IsInteger() && !token->IsDouble()) {
+      return Result("Invalid value for " + name + " command: " +
+                    token->ToOriginalString());
+    }
+
+    Result r = token->ConvertToDouble();
+    if (!r.IsSuccess())
+      return r;
+
+    value->SetDoubleValue(token->AsDouble());
+  } else {
+    if (!token->IsInteger()) {
+      return Result("Invalid value for " + name + " command: " +
+                    token->ToOriginalString());
+    }
+
+    value->SetIntValue(token->AsUint64());
+  }
+
+  return {};
+}
+
 Result CommandParser::ProcessSSBO() {
   auto cmd = MakeUnique<BufferCommand>(BufferCommand::BufferType::kSSBO);
   cmd->SetLine(tokenizer_->GetCurrentLine());
@@ -563,6 +727,30 @@ Result CommandParser::ProcessSSBO() {
     cmd->SetDatumType(tp.GetType());
 
     token = tokenizer_->NextToken();
+    if (token->IsString() && token->AsString() == "file") {
+      // The initializer lives in an external binary file; nothing is
+      // parsed or converted, the executor maps the file and the raw
+      // bytes go straight to the upload path.
+      r = ParseDataFileReference("ssbo", cmd.get());
+      if (!r.IsSuccess())
+        return r;
+
+      commands_.push_back(std::move(cmd));
+      return {};
+    }
+    if (token->IsString() &&
+        (token->AsString() == "fill" || token->AsString() == "series_from")) {
+      // A procedural initializer; only the generator is recorded and it
+      // is evaluated into the mapped buffer memory at upload time.
+      r = ParseBufferGenerator("ssbo", token->AsString() == "series_from",
+                               cmd.get());
+      if (!r.IsSuccess())
+        return r;
+
+      commands_.push_back(std::move(cmd));
+      return {};
+    }
+
     if (!token->IsInteger())
       return Result("Invalid offset for ssbo command: " +
                     token->ToOriginalString());
@@ -783,6 +971,11 @@ Result CommandParser::ProcessProbe(bool relative) {
   if (token->AsString() == "ssbo")
     return ProcessProbeSSBO();
 
+  // Same for probe image, which takes a file path instead of a region
+  // and colour.
+  if (token->AsString() == "image")
+    return ProcessProbeImage();
+
   auto cmd = MakeUnique<ProbeCommand>();
   cmd->SetLine(tokenizer_->GetCurrentLine());
 
@@ -932,6 +1125,30 @@ Result CommandParser::ProcessProbe(bool relative) {
   return {};
 }
 
+Result CommandParser::ProcessProbeImage() {
+  auto cmd = MakeUnique<ProbeCommand>();
+  cmd->SetLine(tokenizer_->GetCurrentLine());
+  cmd->SetTolerances(current_tolerances_);
+
+  // The reference file always covers the full frame.
+  cmd->SetWholeWindow();
+  cmd->SetProbeRect();
+
+  auto token = tokenizer_->NextToken();
+  if (!token->IsString())
+    return Result("Missing image path for probe image command");
+
+  cmd->SetReferenceImagePath(token->AsString());
+
+  token = tokenizer_->NextToken();
+  if (!token->IsEOS() && !token->IsEOL())
+    return Result("Extra parameter to probe image command: " +
+                  token->ToOriginalString());
+
+  commands_.push_back(std::move(cmd));
+  return {};
+}
+
 Result CommandParser::ProcessTopology() {
   auto token = tokenizer_->NextToken();
   if (token->IsEOS() || token->IsEOL())
@@ -1882,6 +2099,72 @@ Result CommandParser::ParseComparator(const std::string& name,
   return {};
 }
 
+Result CommandParser::ProcessProbeSSBOChecksum(ProbeSSBOCommand* cmd) {
+  auto token = tokenizer_->NextToken();
+  if (!token->IsInteger())
+    return Result("Invalid binding value for probe ssbo checksum command: " +
+                  token->ToOriginalString());
+
+  uint32_t val = token->AsUint32();
+
+  token = tokenizer_->NextToken();
+  if (token->IsString()) {
+    auto& str = token->AsString();
+    if (str.size() >= 2 && str[0] == ':') {
+      cmd->SetDescriptorSet(val);
+
+      auto substr = str.substr(1, str.size());
+      uint64_t binding_val = strtoul(substr.c_str(), nullptr, 10);
+      if (binding_val > std::numeric_limits<uint32_t>::max()) {
+        return Result(
+            "binding value too large in probe ssbo checksum command: " +
+            token->ToOriginalString());
+      }
+
+      cmd->SetBinding(static_cast<uint32_t>(binding_val));
+    } else {
+      return Result("Invalid value for probe ssbo checksum command: " +
+                    token->ToOriginalString());
+    }
+
+    token = tokenizer_->NextToken();
+  } else {
+    cmd->SetBinding(val);
+  }
+
+  if (!token->IsInteger())
+    return Result("Invalid offset for probe ssbo checksum command: " +
+                  token->ToOriginalString());
+
+  cmd->SetOffset(token->AsUint32());
+
+  token = tokenizer_->NextToken();
+  if (!token->IsInteger() || token->AsUint32() == 0)
+    return Result("Invalid size for probe ssbo checksum command: " +
+                  token->ToOriginalString());
+
+  uint32_t size_in_bytes = token->AsUint32();
+
+  token = tokenizer_->NextToken();
+  uint64_t checksum = 0;
+  if (token->IsHex())
+    checksum = token->AsHex();
+  else if (token->IsInteger())
+    checksum = token->AsUint64();
+  else
+    return Result("Invalid checksum value for probe ssbo checksum command: " +
+                  token->ToOriginalString());
+
+  cmd->SetChecksum(checksum, size_in_bytes);
+
+  token = tokenizer_->NextToken();
+  if (!token->IsEOS() && !token->IsEOL())
+    return Result("Extra parameter for probe ssbo checksum command: " +
+                  token->ToOriginalString());
+
+  return {};
+}
+
 Result CommandParser::ProcessProbeSSBO() {
   auto cmd = MakeUnique<ProbeSSBOCommand>();
   cmd->SetLine(tokenizer_->GetCurrentLine());
@@ -1894,6 +2177,17 @@ Result CommandParser::ProcessProbeSSBO() {
     return Result("Invalid type for probe ssbo command: " +
                   token->ToOriginalString());
 
+  if (token->AsString() == "checksum") {
+    // Only a hash of the expected bytes is stored; the verifier hashes
+    // the readback in one pass instead of comparing per element.
+    Result r = ProcessProbeSSBOChecksum(cmd.get());
+    if (!r.IsSuccess())
+      return r;
+
+    commands_.push_back(std::move(cmd));
+    return {};
+  }
+
   DatumTypeParser tp;
   Result r = tp.Parse(token->AsString());
   if (!r.IsSuccess())
@@ -35,6 +35,9 @@ namespace vkscript {
 class CommandParser {
  public:
   CommandParser(size_t current_line, const std::string& data);
+  // Parses |size| bytes at |data| in place; the text must outlive the
+  // parser and belong to a null terminated buffer, as for Tokenizer.
+  CommandParser(size_t current_line, const char* data, size_t size);
   ~CommandParser();
 
   Result Parse();
@@ -86,6 +89,21 @@ class CommandParser {
   Result ParseValues(const std::string& name,
                      const DatumType& type,
                      std::vector<Value>* values);
+  /// Parses the tail of a buffer initializer referencing an external
+  /// binary file: `<path> <offset> [<file_offset> [<byte_count>]]`. The
+  /// leading `file` keyword must already be consumed.
+  Result ParseDataFileReference(const std::string& name, BufferCommand* cmd);
+  /// Parses the tail of a procedural buffer initializer:
+  /// `<offset> <count> <value>` for a fill and
+  /// `<offset> <count> <start> inc_by <step>` for a series. The leading
+  /// `fill` or `series_from` keyword must already be consumed.
+  Result ParseBufferGenerator(const std::string& name,
+                              bool series,
+                              BufferCommand* cmd);
+  /// Parses one literal of a generator, as a double when |as_double|.
+  Result ParseGeneratorValue(const std::string& name,
+                             bool as_double,
+                             Value* value);
 
   Result ProcessDrawRect();
   Result ProcessDrawArrays();
@@ -97,7 +115,14 @@ class CommandParser {
   Result ProcessTolerance();
   Result ProcessEntryPoint(const std::string& name);
   Result ProcessProbe(bool relative);
+  /// Parses the tail of `probe image`: `<path>`. The `image` keyword
+  /// must already be consumed.
+  Result ProcessProbeImage();
   Result ProcessProbeSSBO();
+  /// Parses the tail of `probe ssbo checksum`:
+  /// `<binding> <offset> <size_in_bytes> <hash>`. The `checksum`
+  /// keyword must already be consumed.
+  Result ProcessProbeSSBOChecksum(ProbeSSBOCommand* cmd);
   Result ProcessTopology();
   Result ProcessPolygonMode();
   Result ProcessLogicOp();
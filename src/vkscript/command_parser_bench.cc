@@ -0,0 +1,48 @@
+// Copyright 2018 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "benchmark/benchmark.h"
+#include "src/vkscript/command_parser.h"
+
+namespace amber {
+namespace vkscript {
+namespace {
+
+void BM_CommandParserSSBOData(benchmark::State& state) {
+  // Data-heavy test sections are dominated by value lists like these.
+  std::string data;
+  for (size_t i = 0; i < 512; ++i) {
+    data += "ssbo 6 subdata vec4 " + std::to_string(i * 16) +
+            " 1.1 2.2 3.3 4.4\n";
+  }
+
+  for (auto _ : state) {
+    CommandParser cp(1, data);
+    Result r = cp.Parse();
+    if (!r.IsSuccess()) {
+      state.SkipWithError(r.Error().c_str());
+      break;
+    }
+    benchmark::DoNotOptimize(cp.Commands().size());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(data.size()));
+}
+BENCHMARK(BM_CommandParserSSBOData);
+
+}  // namespace
+}  // namespace vkscript
+}  // namespace amber
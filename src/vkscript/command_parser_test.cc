@@ -334,6 +334,25 @@ TEST_F(CommandParserTest, Compute) {
   EXPECT_EQ(1U, cmd->GetX());
   EXPECT_EQ(2U, cmd->GetY());
   EXPECT_EQ(3U, cmd->GetZ());
+  EXPECT_FALSE(cmd->IsDataParallel());
+}
+
+TEST_F(CommandParserTest, ComputeParallel) {
+  std::string data = "compute parallel 4 5 6";
+
+  CommandParser cp(1, data);
+  Result r = cp.Parse();
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  auto& cmds = cp.Commands();
+  ASSERT_EQ(1U, cmds.size());
+  ASSERT_TRUE(cmds[0]->IsCompute());
+
+  auto* cmd = cmds[0]->AsCompute();
+  EXPECT_EQ(4U, cmd->GetX());
+  EXPECT_EQ(5U, cmd->GetY());
+  EXPECT_EQ(6U, cmd->GetZ());
+  EXPECT_TRUE(cmd->IsDataParallel());
 }
 
 TEST_F(CommandParserTest, ComputeTooShort) {
@@ -900,6 +919,42 @@ TEST_F(CommandParserTest, ProbeAllRGBA) {
   EXPECT_FLOAT_EQ(0.5f, cmd->GetA());
 }
 
+TEST_F(CommandParserTest, ProbeImage) {
+  std::string data = "probe image golden.bin";
+
+  CommandParser cp(1, data);
+  Result r = cp.Parse();
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  auto& cmds = cp.Commands();
+  ASSERT_EQ(1U, cmds.size());
+  ASSERT_TRUE(cmds[0]->IsProbe());
+
+  auto* cmd = cmds[0]->AsProbe();
+  EXPECT_TRUE(cmd->IsReferenceImage());
+  EXPECT_TRUE(cmd->IsWholeWindow());
+  EXPECT_TRUE(cmd->IsProbeRect());
+  EXPECT_EQ("golden.bin", cmd->GetReferenceImagePath());
+}
+
+TEST_F(CommandParserTest, ProbeImageMissingPath) {
+  std::string data = "probe image";
+
+  CommandParser cp(1, data);
+  Result r = cp.Parse();
+  ASSERT_FALSE(r.IsSuccess());
+  EXPECT_EQ("1: Missing image path for probe image command", r.Error());
+}
+
+TEST_F(CommandParserTest, ProbeImageExtraParameter) {
+  std::string data = "probe image golden.bin EXTRA";
+
+  CommandParser cp(1, data);
+  Result r = cp.Parse();
+  ASSERT_FALSE(r.IsSuccess());
+  EXPECT_EQ("1: Extra parameter to probe image command: EXTRA", r.Error());
+}
+
 TEST_F(CommandParserTest, ProbeCommandRectBrackets) {
   std::string data = "relative probe rect rgb (0.5, 0.6, 0.3, 0.4) 1 2 3";
 
@@ -2879,6 +2934,165 @@ TEST_F(CommandParserTest, SSBOSubdataWithMissingAllData) {
             r.Error());
 }
 
+TEST_F(CommandParserTest, SSBOSubdataFromDataFile) {
+  std::string data = "ssbo 6 subdata vec3 file blob.bin 16";
+
+  CommandParser cp(1, data);
+  Result r = cp.Parse();
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  auto& cmds = cp.Commands();
+  ASSERT_EQ(1U, cmds.size());
+  ASSERT_TRUE(cmds[0]->IsBuffer());
+
+  auto* cmd = cmds[0]->AsBuffer();
+  EXPECT_TRUE(cmd->IsSSBO());
+  EXPECT_EQ(static_cast<uint32_t>(0), cmd->GetDescriptorSet());
+  EXPECT_EQ(6U, cmd->GetBinding());
+  EXPECT_EQ(16U, cmd->GetOffset());
+  ASSERT_TRUE(cmd->IsSubdata());
+
+  EXPECT_TRUE(cmd->IsFromDataFile());
+  EXPECT_EQ("blob.bin", cmd->GetDataFilePath());
+  EXPECT_EQ(0U, cmd->GetDataFileOffset());
+  EXPECT_EQ(0U, cmd->GetDataFileSize());
+  EXPECT_TRUE(cmd->GetValues().empty());
+}
+
+TEST_F(CommandParserTest, SSBOSubdataFromDataFileWithRange) {
+  std::string data = "ssbo 5:6 subdata vec3 file data/blob.bin 0 4096 1024";
+
+  CommandParser cp(1, data);
+  Result r = cp.Parse();
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  auto& cmds = cp.Commands();
+  ASSERT_EQ(1U, cmds.size());
+  ASSERT_TRUE(cmds[0]->IsBuffer());
+
+  auto* cmd = cmds[0]->AsBuffer();
+  EXPECT_TRUE(cmd->IsSSBO());
+  EXPECT_EQ(5U, cmd->GetDescriptorSet());
+  EXPECT_EQ(6U, cmd->GetBinding());
+  EXPECT_EQ(0U, cmd->GetOffset());
+  ASSERT_TRUE(cmd->IsSubdata());
+
+  EXPECT_TRUE(cmd->IsFromDataFile());
+  EXPECT_EQ("data/blob.bin", cmd->GetDataFilePath());
+  EXPECT_EQ(4096U, cmd->GetDataFileOffset());
+  EXPECT_EQ(1024U, cmd->GetDataFileSize());
+}
+
+TEST_F(CommandParserTest, SSBOSubdataFromDataFileMissingPath) {
+  std::string data = "ssbo 6 subdata vec3 file";
+
+  CommandParser cp(1, data);
+  Result r = cp.Parse();
+  ASSERT_FALSE(r.IsSuccess());
+  EXPECT_EQ("1: Missing data file path for ssbo command", r.Error());
+}
+
+TEST_F(CommandParserTest, SSBOSubdataFromDataFileMissingOffset) {
+  std::string data = "ssbo 6 subdata vec3 file blob.bin";
+
+  CommandParser cp(1, data);
+  Result r = cp.Parse();
+  ASSERT_FALSE(r.IsSuccess());
+  EXPECT_EQ("1: Missing offset for ssbo command", r.Error());
+}
+
+TEST_F(CommandParserTest, SSBOSubdataFill) {
+  std::string data = "ssbo 6 subdata vec3 fill 8 1024 2.5";
+
+  CommandParser cp(1, data);
+  Result r = cp.Parse();
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  auto& cmds = cp.Commands();
+  ASSERT_EQ(1U, cmds.size());
+  ASSERT_TRUE(cmds[0]->IsBuffer());
+
+  auto* cmd = cmds[0]->AsBuffer();
+  EXPECT_TRUE(cmd->IsSSBO());
+  EXPECT_EQ(6U, cmd->GetBinding());
+  EXPECT_EQ(8U, cmd->GetOffset());
+  ASSERT_TRUE(cmd->IsSubdata());
+
+  EXPECT_EQ(BufferDataGenerator::kFill, cmd->GetGenerator());
+  EXPECT_FLOAT_EQ(2.5f, cmd->GetGeneratorStart().AsFloat());
+  EXPECT_EQ(1024U * 3U * sizeof(float), cmd->GetSize());
+  EXPECT_TRUE(cmd->GetValues().empty());
+}
+
+TEST_F(CommandParserTest, SSBOSubdataSeries) {
+  std::string data = "ssbo 6 subdata int series_from 0 100 7 inc_by 3";
+
+  CommandParser cp(1, data);
+  Result r = cp.Parse();
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  auto& cmds = cp.Commands();
+  ASSERT_EQ(1U, cmds.size());
+  ASSERT_TRUE(cmds[0]->IsBuffer());
+
+  auto* cmd = cmds[0]->AsBuffer();
+  EXPECT_TRUE(cmd->IsSSBO());
+  EXPECT_EQ(6U, cmd->GetBinding());
+  EXPECT_EQ(0U, cmd->GetOffset());
+  ASSERT_TRUE(cmd->IsSubdata());
+
+  EXPECT_EQ(BufferDataGenerator::kSeries, cmd->GetGenerator());
+  EXPECT_EQ(7U, cmd->GetGeneratorStart().AsUint64());
+  EXPECT_EQ(3U, cmd->GetGeneratorStep().AsUint64());
+  EXPECT_EQ(100U * sizeof(int32_t), cmd->GetSize());
+}
+
+TEST_F(CommandParserTest, SSBOSubdataFillMissingValue) {
+  std::string data = "ssbo 6 subdata vec3 fill 8 1024";
+
+  CommandParser cp(1, data);
+  Result r = cp.Parse();
+  ASSERT_FALSE(r.IsSuccess());
+  EXPECT_EQ("1: Missing value for ssbo fill command", r.Error());
+}
+
+TEST_F(CommandParserTest, SSBOSubdataSeriesMissingIncBy) {
+  std::string data = "ssbo 6 subdata int series_from 0 100 7";
+
+  CommandParser cp(1, data);
+  Result r = cp.Parse();
+  ASSERT_FALSE(r.IsSuccess());
+  EXPECT_EQ("1: Missing inc_by for ssbo series_from command", r.Error());
+}
+
+TEST_F(CommandParserTest, SSBOSubdataSeriesWithMultiRowType) {
+  std::string data = "ssbo 6 subdata vec3 series_from 0 100 7 inc_by 3";
+
+  CommandParser cp(1, data);
+  Result r = cp.Parse();
+  ASSERT_FALSE(r.IsSuccess());
+  EXPECT_EQ("1: ssbo series_from must not use multi-row/column types",
+            r.Error());
+}
+
+TEST_F(CommandParserTest, SSBOSubdataFillZeroCount) {
+  std::string data = "ssbo 6 subdata int fill 0 0 1";
+
+  CommandParser cp(1, data);
+  Result r = cp.Parse();
+  ASSERT_FALSE(r.IsSuccess());
+  EXPECT_EQ("1: Invalid count for ssbo fill command: 0", r.Error());
+}
+
+TEST_F(CommandParserTest, SSBOSubdataFromDataFileExtraParameter) {
+  std::string data = "ssbo 6 subdata vec3 file blob.bin 0 0 1024 foo";
+
+  CommandParser cp(1, data);
+  Result r = cp.Parse();
+  ASSERT_FALSE(r.IsSuccess());
+  EXPECT_EQ("1: Extra parameter for ssbo command: foo", r.Error());
+}
+
 TEST_F(CommandParserTest, Uniform) {
   std::string data = "uniform vec3 2 2.1 3.2 4.3";
 
@@ -3394,6 +3608,66 @@ TEST_F(CommandParserTest, ProbeSSBOWithDescriptorSet) {
   }
 }
 
+TEST_F(CommandParserTest, ProbeSSBOChecksum) {
+  std::string data = "probe ssbo checksum 6 16 4096 0xdeadbeefcafef00d";
+
+  CommandParser cp(1, data);
+  Result r = cp.Parse();
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  auto& cmds = cp.Commands();
+  ASSERT_EQ(1U, cmds.size());
+  ASSERT_TRUE(cmds[0]->IsProbeSSBO());
+
+  auto* cmd = cmds[0]->AsProbeSSBO();
+  EXPECT_EQ(static_cast<uint32_t>(0), cmd->GetDescriptorSet());
+  EXPECT_EQ(6U, cmd->GetBinding());
+  EXPECT_EQ(16U, cmd->GetOffset());
+  EXPECT_TRUE(cmd->IsChecksum());
+  EXPECT_EQ(4096U, cmd->GetChecksumSizeInBytes());
+  EXPECT_EQ(0xdeadbeefcafef00dULL, cmd->GetChecksum());
+  EXPECT_TRUE(cmd->GetValues().empty());
+}
+
+TEST_F(CommandParserTest, ProbeSSBOChecksumWithDescriptorSet) {
+  std::string data = "probe ssbo checksum 3:6 0 1024 12345";
+
+  CommandParser cp(1, data);
+  Result r = cp.Parse();
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  auto& cmds = cp.Commands();
+  ASSERT_EQ(1U, cmds.size());
+  ASSERT_TRUE(cmds[0]->IsProbeSSBO());
+
+  auto* cmd = cmds[0]->AsProbeSSBO();
+  EXPECT_EQ(3U, cmd->GetDescriptorSet());
+  EXPECT_EQ(6U, cmd->GetBinding());
+  EXPECT_EQ(0U, cmd->GetOffset());
+  EXPECT_TRUE(cmd->IsChecksum());
+  EXPECT_EQ(1024U, cmd->GetChecksumSizeInBytes());
+  EXPECT_EQ(12345U, cmd->GetChecksum());
+}
+
+TEST_F(CommandParserTest, ProbeSSBOChecksumInvalidSize) {
+  std::string data = "probe ssbo checksum 6 0 0 12345";
+
+  CommandParser cp(1, data);
+  Result r = cp.Parse();
+  ASSERT_FALSE(r.IsSuccess());
+  EXPECT_EQ("1: Invalid size for probe ssbo checksum command: 0", r.Error());
+}
+
+TEST_F(CommandParserTest, ProbeSSBOChecksumMissingHash) {
+  std::string data = "probe ssbo checksum 6 0 1024";
+
+  CommandParser cp(1, data);
+  Result r = cp.Parse();
+  ASSERT_FALSE(r.IsSuccess());
+  EXPECT_EQ("1: Invalid checksum value for probe ssbo checksum command: ",
+            r.Error());
+}
+
 TEST_F(CommandParserTest, ProbeSSBOWithFloats) {
   std::string data = "probe ssbo vec3 6 2 >= 2.3 4.2 1.2";
 
@@ -14,225 +14,116 @@
 
 #include "src/vkscript/datum_type_parser.h"
 
+#include <algorithm>
+#include <cstring>
+
 namespace amber {
 namespace vkscript {
+namespace {
+
+struct TypeName {
+  const char* name;
+  DataType type;
+  uint8_t columns;
+  uint8_t rows;
+};
+
+// Sorted by |name| so it can be binary searched.
+const TypeName kTypeNames[] = {
+    {"dmat2", DataType::kDouble, 2, 2},
+    {"dmat2x2", DataType::kDouble, 2, 2},
+    {"dmat2x3", DataType::kDouble, 2, 3},
+    {"dmat2x4", DataType::kDouble, 2, 4},
+    {"dmat3", DataType::kDouble, 3, 3},
+    {"dmat3x2", DataType::kDouble, 3, 2},
+    {"dmat3x3", DataType::kDouble, 3, 3},
+    {"dmat3x4", DataType::kDouble, 3, 4},
+    {"dmat4", DataType::kDouble, 4, 4},
+    {"dmat4x2", DataType::kDouble, 4, 2},
+    {"dmat4x3", DataType::kDouble, 4, 3},
+    {"dmat4x4", DataType::kDouble, 4, 4},
+    {"double", DataType::kDouble, 1, 1},
+    {"dvec2", DataType::kDouble, 1, 2},
+    {"dvec3", DataType::kDouble, 1, 3},
+    {"dvec4", DataType::kDouble, 1, 4},
+    {"float", DataType::kFloat, 1, 1},
+    {"i16vec2", DataType::kInt16, 1, 2},
+    {"i16vec3", DataType::kInt16, 1, 3},
+    {"i16vec4", DataType::kInt16, 1, 4},
+    {"i64vec2", DataType::kInt64, 1, 2},
+    {"i64vec3", DataType::kInt64, 1, 3},
+    {"i64vec4", DataType::kInt64, 1, 4},
+    {"i8vec2", DataType::kInt8, 1, 2},
+    {"i8vec3", DataType::kInt8, 1, 3},
+    {"i8vec4", DataType::kInt8, 1, 4},
+    {"int", DataType::kInt32, 1, 1},
+    {"int16_t", DataType::kInt16, 1, 1},
+    {"int64_t", DataType::kInt64, 1, 1},
+    {"int8_t", DataType::kInt8, 1, 1},
+    {"ivec2", DataType::kInt32, 1, 2},
+    {"ivec3", DataType::kInt32, 1, 3},
+    {"ivec4", DataType::kInt32, 1, 4},
+    {"mat2", DataType::kFloat, 2, 2},
+    {"mat2x2", DataType::kFloat, 2, 2},
+    {"mat2x3", DataType::kFloat, 2, 3},
+    {"mat2x4", DataType::kFloat, 2, 4},
+    {"mat3", DataType::kFloat, 3, 3},
+    {"mat3x2", DataType::kFloat, 3, 2},
+    {"mat3x3", DataType::kFloat, 3, 3},
+    {"mat3x4", DataType::kFloat, 3, 4},
+    {"mat4", DataType::kFloat, 4, 4},
+    {"mat4x2", DataType::kFloat, 4, 2},
+    {"mat4x3", DataType::kFloat, 4, 3},
+    {"mat4x4", DataType::kFloat, 4, 4},
+    {"u16vec2", DataType::kUint16, 1, 2},
+    {"u16vec3", DataType::kUint16, 1, 3},
+    {"u16vec4", DataType::kUint16, 1, 4},
+    {"u64vec2", DataType::kUint64, 1, 2},
+    {"u64vec3", DataType::kUint64, 1, 3},
+    {"u64vec4", DataType::kUint64, 1, 4},
+    {"u8vec2", DataType::kUint8, 1, 2},
+    {"u8vec3", DataType::kUint8, 1, 3},
+    {"u8vec4", DataType::kUint8, 1, 4},
+    {"uint", DataType::kUint32, 1, 1},
+    {"uint16_t", DataType::kUint16, 1, 1},
+    {"uint64_t", DataType::kUint64, 1, 1},
+    {"uint8_t", DataType::kUint8, 1, 1},
+    {"uvec2", DataType::kUint32, 1, 2},
+    {"uvec3", DataType::kUint32, 1, 3},
+    {"uvec4", DataType::kUint32, 1, 4},
+    {"vec2", DataType::kFloat, 1, 2},
+    {"vec3", DataType::kFloat, 1, 3},
+    {"vec4", DataType::kFloat, 1, 4},
+};
+
+}  // namespace
 
 DatumTypeParser::DatumTypeParser() = default;
 
 DatumTypeParser::~DatumTypeParser() = default;
 
+// static
+const DatumType* DatumTypeParser::LookupType(const char* name,
+                                             DatumType* type) {
+  const auto* begin = kTypeNames;
+  const auto* end = kTypeNames + sizeof(kTypeNames) / sizeof(kTypeNames[0]);
+  const auto* it = std::lower_bound(
+      begin, end, name,
+      [](const TypeName& entry, const char* key) {
+        return std::strcmp(entry.name, key) < 0;
+      });
+  if (it == end || std::strcmp(it->name, name) != 0)
+    return nullptr;
+
+  type->SetType(it->type);
+  type->SetColumnCount(it->columns);
+  type->SetRowCount(it->rows);
+  return type;
+}
+
 Result DatumTypeParser::Parse(const std::string& data) {
-  // TODO(dsinclair): Might want to make this nicer in the future, but this
-  // works and is easy for now.
-  if (data == "int") {
-    type_.SetType(DataType::kInt32);
-  } else if (data == "uint") {
-    type_.SetType(DataType::kUint32);
-  } else if (data == "int8_t") {
-    type_.SetType(DataType::kInt8);
-  } else if (data == "uint8_t") {
-    type_.SetType(DataType::kUint8);
-  } else if (data == "int16_t") {
-    type_.SetType(DataType::kInt16);
-  } else if (data == "uint16_t") {
-    type_.SetType(DataType::kUint16);
-  } else if (data == "int64_t") {
-    type_.SetType(DataType::kInt64);
-  } else if (data == "uint64_t") {
-    type_.SetType(DataType::kUint64);
-  } else if (data == "float") {
-    type_.SetType(DataType::kFloat);
-  } else if (data == "double") {
-    type_.SetType(DataType::kDouble);
-  } else if (data == "vec2") {
-    type_.SetType(DataType::kFloat);
-    type_.SetRowCount(2);
-  } else if (data == "vec3") {
-    type_.SetType(DataType::kFloat);
-    type_.SetRowCount(3);
-  } else if (data == "vec4") {
-    type_.SetType(DataType::kFloat);
-    type_.SetRowCount(4);
-  } else if (data == "dvec2") {
-    type_.SetType(DataType::kDouble);
-    type_.SetRowCount(2);
-  } else if (data == "dvec3") {
-    type_.SetType(DataType::kDouble);
-    type_.SetRowCount(3);
-  } else if (data == "dvec4") {
-    type_.SetType(DataType::kDouble);
-    type_.SetRowCount(4);
-  } else if (data == "ivec2") {
-    type_.SetType(DataType::kInt32);
-    type_.SetRowCount(2);
-  } else if (data == "ivec3") {
-    type_.SetType(DataType::kInt32);
-    type_.SetRowCount(3);
-  } else if (data == "ivec4") {
-    type_.SetType(DataType::kInt32);
-    type_.SetRowCount(4);
-  } else if (data == "uvec2") {
-    type_.SetType(DataType::kUint32);
-    type_.SetRowCount(2);
-  } else if (data == "uvec3") {
-    type_.SetType(DataType::kUint32);
-    type_.SetRowCount(3);
-  } else if (data == "uvec4") {
-    type_.SetType(DataType::kUint32);
-    type_.SetRowCount(4);
-  } else if (data == "i8vec2") {
-    type_.SetType(DataType::kInt8);
-    type_.SetRowCount(2);
-  } else if (data == "i8vec3") {
-    type_.SetType(DataType::kInt8);
-    type_.SetRowCount(3);
-  } else if (data == "i8vec4") {
-    type_.SetType(DataType::kInt8);
-    type_.SetRowCount(4);
-  } else if (data == "u8vec2") {
-    type_.SetType(DataType::kUint8);
-    type_.SetRowCount(2);
-  } else if (data == "u8vec3") {
-    type_.SetType(DataType::kUint8);
-    type_.SetRowCount(3);
-  } else if (data == "u8vec4") {
-    type_.SetType(DataType::kUint8);
-    type_.SetRowCount(4);
-  } else if (data == "i16vec2") {
-    type_.SetType(DataType::kInt16);
-    type_.SetRowCount(2);
-  } else if (data == "i16vec3") {
-    type_.SetType(DataType::kInt16);
-    type_.SetRowCount(3);
-  } else if (data == "i16vec4") {
-    type_.SetType(DataType::kInt16);
-    type_.SetRowCount(4);
-  } else if (data == "u16vec2") {
-    type_.SetType(DataType::kUint16);
-    type_.SetRowCount(2);
-  } else if (data == "u16vec3") {
-    type_.SetType(DataType::kUint16);
-    type_.SetRowCount(3);
-  } else if (data == "u16vec4") {
-    type_.SetType(DataType::kUint16);
-    type_.SetRowCount(4);
-  } else if (data == "i64vec2") {
-    type_.SetType(DataType::kInt64);
-    type_.SetRowCount(2);
-  } else if (data == "i64vec3") {
-    type_.SetType(DataType::kInt64);
-    type_.SetRowCount(3);
-  } else if (data == "i64vec4") {
-    type_.SetType(DataType::kInt64);
-    type_.SetRowCount(4);
-  } else if (data == "u64vec2") {
-    type_.SetType(DataType::kUint64);
-    type_.SetRowCount(2);
-  } else if (data == "u64vec3") {
-    type_.SetType(DataType::kUint64);
-    type_.SetRowCount(3);
-  } else if (data == "u64vec4") {
-    type_.SetType(DataType::kUint64);
-    type_.SetRowCount(4);
-  } else if (data == "mat2") {
-    type_.SetType(DataType::kFloat);
-    type_.SetColumnCount(2);
-    type_.SetRowCount(2);
-  } else if (data == "mat2x2") {
-    type_.SetType(DataType::kFloat);
-    type_.SetColumnCount(2);
-    type_.SetRowCount(2);
-  } else if (data == "mat2x3") {
-    type_.SetType(DataType::kFloat);
-    type_.SetColumnCount(2);
-    type_.SetRowCount(3);
-  } else if (data == "mat2x4") {
-    type_.SetType(DataType::kFloat);
-    type_.SetColumnCount(2);
-    type_.SetRowCount(4);
-  } else if (data == "mat3") {
-    type_.SetType(DataType::kFloat);
-    type_.SetColumnCount(3);
-    type_.SetRowCount(3);
-  } else if (data == "mat3x2") {
-    type_.SetType(DataType::kFloat);
-    type_.SetColumnCount(3);
-    type_.SetRowCount(2);
-  } else if (data == "mat3x3") {
-    type_.SetType(DataType::kFloat);
-    type_.SetColumnCount(3);
-    type_.SetRowCount(3);
-  } else if (data == "mat3x4") {
-    type_.SetType(DataType::kFloat);
-    type_.SetColumnCount(3);
-    type_.SetRowCount(4);
-  } else if (data == "mat4") {
-    type_.SetType(DataType::kFloat);
-    type_.SetColumnCount(4);
-    type_.SetRowCount(4);
-  } else if (data == "mat4x2") {
-    type_.SetType(DataType::kFloat);
-    type_.SetColumnCount(4);
-    type_.SetRowCount(2);
-  } else if (data == "mat4x3") {
-    type_.SetType(DataType::kFloat);
-    type_.SetColumnCount(4);
-    type_.SetRowCount(3);
-  } else if (data == "mat4x4") {
-    type_.SetType(DataType::kFloat);
-    type_.SetColumnCount(4);
-    type_.SetRowCount(4);
-  } else if (data == "dmat2") {
-    type_.SetType(DataType::kDouble);
-    type_.SetColumnCount(2);
-    type_.SetRowCount(2);
-  } else if (data == "dmat2x2") {
-    type_.SetType(DataType::kDouble);
-    type_.SetColumnCount(2);
-    type_.SetRowCount(2);
-  } else if (data == "dmat2x3") {
-    type_.SetType(DataType::kDouble);
-    type_.SetColumnCount(2);
-    type_.SetRowCount(3);
-  } else if (data == "dmat2x4") {
-    type_.SetType(DataType::kDouble);
-    type_.SetColumnCount(2);
-    type_.SetRowCount(4);
-  } else if (data == "dmat3") {
-    type_.SetType(DataType::kDouble);
-    type_.SetColumnCount(3);
-    type_.SetRowCount(3);
-  } else if (data == "dmat3x2") {
-    type_.SetType(DataType::kDouble);
-    type_.SetColumnCount(3);
-    type_.SetRowCount(2);
-  } else if (data == "dmat3x3") {
-    type_.SetType(DataType::kDouble);
-    type_.SetColumnCount(3);
-    type_.SetRowCount(3);
-  } else if (data == "dmat3x4") {
-    type_.SetType(DataType::kDouble);
-    type_.SetColumnCount(3);
-    type_.SetRowCount(4);
-  } else if (data == "dmat4") {
-    type_.SetType(DataType::kDouble);
-    type_.SetColumnCount(4);
-    type_.SetRowCount(4);
-  } else if (data == "dmat4x2") {
-    type_.SetType(DataType::kDouble);
-    type_.SetColumnCount(4);
-    type_.SetRowCount(2);
-  } else if (data == "dmat4x3") {
-    type_.SetType(DataType::kDouble);
-    type_.SetColumnCount(4);
-    type_.SetRowCount(3);
-  } else if (data == "dmat4x4") {
-    type_.SetType(DataType::kDouble);
-    type_.SetColumnCount(4);
-    type_.SetRowCount(4);
-  } else {
+  if (!LookupType(data.c_str(), &type_))
     return Result("Invalid type provided: " + data);
-  }
   return {};
 }
 
@@ -28,6 +28,11 @@ class DatumTypeParser {
   DatumTypeParser();
   ~DatumTypeParser();
 
+  /// Resolves the GLSL-style type name |name| with a binary search of a
+  /// static table. On a hit |type| is filled in and returned, otherwise
+  /// returns nullptr. Shared with any front end which accepts these names.
+  static const DatumType* LookupType(const char* name, DatumType* type);
+
   Result Parse(const std::string& data);
   const DatumType& GetType() const { return type_; }
 
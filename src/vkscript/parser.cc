@@ -23,6 +23,7 @@
 
 #include "src/format_parser.h"
 #include "src/make_unique.h"
+#include "src/profiler.h"
 #include "src/shader.h"
 #include "src/vkscript/command_parser.h"
 
@@ -162,6 +163,8 @@ std::string Parser::make_error(const Tokenizer& tokenizer,
 }
 
 Result Parser::Parse(const std::string& input) {
+  ScopedPhaseTimer timer("Parser::Parse");
+
   SectionParser section_parser;
   Result r = section_parser.Parse(input);
   if (!r.IsSuccess())
@@ -173,6 +176,7 @@ Result Parser::Parse(const std::string& input) {
       return r;
   }
 
+  script_->Finalize();
   return {};
 }
 
@@ -202,7 +206,7 @@ Result Parser::ProcessShaderBlock(const SectionParser::Section& section) {
   // Generate a unique name for the shader.
   shader->SetName("vk_shader_" + std::to_string(script_->GetShaders().size()));
   shader->SetFormat(section.format);
-  shader->SetData(section.contents);
+  shader->SetData(section.ToString());
 
   Result r = script_->AddShader(std::move(shader));
   if (!r.IsSuccess())
@@ -212,7 +216,7 @@ Result Parser::ProcessShaderBlock(const SectionParser::Section& section) {
 }
 
 Result Parser::ProcessRequireBlock(const SectionParser::Section& section) {
-  Tokenizer tokenizer(section.contents);
+  Tokenizer tokenizer(section.data, section.size);
   tokenizer.SetCurrentLine(section.starting_line_number);
   for (auto token = tokenizer.NextToken(); !token->IsEOS();
        token = tokenizer.NextToken()) {
@@ -293,8 +297,13 @@ Result Parser::ProcessRequireBlock(const SectionParser::Section& section) {
 
 Result Parser::ProcessIndicesBlock(const SectionParser::Section& section) {
   std::vector<Value> indices;
+  // One index per whitespace separator is a tight upper bound.
+  indices.reserve(static_cast<size_t>(std::count_if(
+                      section.data, section.data + section.size,
+                      [](char c) { return c == ' ' || c == '\n'; })) +
+                  1);
 
-  Tokenizer tokenizer(section.contents);
+  Tokenizer tokenizer(section.data, section.size);
   tokenizer.SetCurrentLine(section.starting_line_number);
   for (auto token = tokenizer.NextToken(); !token->IsEOS();
        token = tokenizer.NextToken()) {
@@ -331,7 +340,7 @@ Result Parser::ProcessIndicesBlock(const SectionParser::Section& section) {
 }
 
 Result Parser::ProcessVertexDataBlock(const SectionParser::Section& section) {
-  Tokenizer tokenizer(section.contents);
+  Tokenizer tokenizer(section.data, section.size);
   tokenizer.SetCurrentLine(section.starting_line_number);
 
   // Skip blank and comment lines
@@ -346,7 +355,8 @@ Result Parser::ProcessVertexDataBlock(const SectionParser::Section& section) {
   // Process the header line.
   struct Header {
     uint8_t location;
-    std::unique_ptr<Format> format;
+    std::shared_ptr<const Format> format;
+    bool instance_rate;
   };
   std::vector<Header> headers;
   while (!token->IsEOL() && !token->IsEOS()) {
@@ -372,6 +382,18 @@ Result Parser::ProcessVertexDataBlock(const SectionParser::Section& section) {
       return Result(make_error(tokenizer, "Vertex data format too short: " +
                                               token->ToOriginalString()));
 
+    // A "/instance" suffix marks the column as advancing per instance
+    // of an instanced draw instead of per vertex, e.g.
+    // 1/R32G32B32A32_SFLOAT/instance.
+    bool instance_rate = false;
+    const std::string kInstanceSuffix = "/instance";
+    if (fmt_name.size() > kInstanceSuffix.size() &&
+        fmt_name.compare(fmt_name.size() - kInstanceSuffix.size(),
+                         kInstanceSuffix.size(), kInstanceSuffix) == 0) {
+      instance_rate = true;
+      fmt_name.resize(fmt_name.size() - kInstanceSuffix.size());
+    }
+
     FormatParser parser;
     auto fmt = parser.Parse(fmt_name.substr(1, fmt_name.length()));
     if (!fmt) {
@@ -380,7 +402,7 @@ Result Parser::ProcessVertexDataBlock(const SectionParser::Section& section) {
                                     fmt_name.substr(1, fmt_name.length())));
     }
 
-    headers.push_back({loc, std::move(fmt)});
+    headers.push_back({loc, std::move(fmt), instance_rate});
 
     token = tokenizer.NextToken();
   }
@@ -443,6 +465,8 @@ Result Parser::ProcessVertexDataBlock(const SectionParser::Section& section) {
     buffer->SetName("Vertices" + std::to_string(i));
     buffer->SetFormat(std::move(headers[i].format));
     buffer->SetLocation(headers[i].location);
+    if (headers[i].instance_rate)
+      buffer->SetInputRateInstance();
     buffer->SetData(std::move(values[i]));
     script_->AddBuffer(std::move(buffer));
   }
@@ -451,7 +475,8 @@ Result Parser::ProcessVertexDataBlock(const SectionParser::Section& section) {
 }
 
 Result Parser::ProcessTestBlock(const SectionParser::Section& section) {
-  CommandParser cp(section.starting_line_number + 1, section.contents);
+  CommandParser cp(section.starting_line_number + 1, section.data,
+                   section.size);
   Result r = cp.Parse();
   if (!r.IsSuccess())
     return r;
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstring>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -99,7 +100,8 @@ TEST_F(VkScriptParserTest, RequireBlockNoArgumentFeatures) {
   for (const auto& feature : features) {
     SectionParser::Section section;
     section.section_type = NodeType::kRequire;
-    section.contents = feature.name;
+    section.data = feature.name;
+    section.size = strlen(feature.name);
     section.starting_line_number = 0;
 
     Parser parser;
@@ -119,7 +121,8 @@ VK_KHR_variable_pointers)";
 
   SectionParser::Section section;
   section.section_type = NodeType::kRequire;
-  section.contents = block;
+  section.data = block.data();
+  section.size = block.size();
   section.starting_line_number = 0;
 
   Parser parser;
@@ -138,7 +141,8 @@ TEST_F(VkScriptParserTest, RequireBlockFramebuffer) {
 
   SectionParser::Section section;
   section.section_type = NodeType::kRequire;
-  section.contents = block;
+  section.data = block.data();
+  section.size = block.size();
   section.starting_line_number = 0;
 
   Parser parser;
@@ -159,7 +163,8 @@ TEST_F(VkScriptParserTest, RequireBlockDepthStencil) {
 
   SectionParser::Section section;
   section.section_type = NodeType::kRequire;
-  section.contents = block;
+  section.data = block.data();
+  section.size = block.size();
   section.starting_line_number = 0;
 
   Parser parser;
@@ -187,7 +192,8 @@ inheritedQueries # line comment
 
   SectionParser::Section section;
   section.section_type = NodeType::kRequire;
-  section.contents = block;
+  section.data = block.data();
+  section.size = block.size();
   section.starting_line_number = 0;
 
   Parser parser;
@@ -217,7 +223,8 @@ TEST_F(VkScriptParserTest, IndicesBlock) {
 
   SectionParser::Section section;
   section.section_type = NodeType::kIndices;
-  section.contents = block;
+  section.data = block.data();
+  section.size = block.size();
   section.starting_line_number = 0;
 
   Parser parser;
@@ -256,7 +263,8 @@ TEST_F(VkScriptParserTest, IndicesBlockMultipleLines) {
 
   SectionParser::Section section;
   section.section_type = NodeType::kIndices;
-  section.contents = block;
+  section.data = block.data();
+  section.size = block.size();
   section.starting_line_number = 0;
 
   std::vector<uint16_t> results = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
@@ -283,7 +291,8 @@ TEST_F(VkScriptParserTest, IndicesBlockBadValue) {
 
   SectionParser::Section section;
   section.section_type = NodeType::kIndices;
-  section.contents = block;
+  section.data = block.data();
+  section.size = block.size();
   section.starting_line_number = 0;
 
   Parser parser;
@@ -297,7 +306,8 @@ TEST_F(VkScriptParserTest, IndicesBlockValueTooLarge) {
 
   SectionParser::Section section;
   section.section_type = NodeType::kIndices;
-  section.contents = block;
+  section.data = block.data();
+  section.size = block.size();
   section.starting_line_number = 0;
 
   Parser parser;
@@ -311,7 +321,8 @@ TEST_F(VkScriptParserTest, VertexDataEmpty) {
 
   SectionParser::Section section;
   section.section_type = NodeType::kVertexData;
-  section.contents = block;
+  section.data = block.data();
+  section.size = block.size();
   section.starting_line_number = 0;
 
   Parser parser;
@@ -327,7 +338,8 @@ TEST_F(VkScriptParserTest, VertexDataHeaderFormatString) {
 
   SectionParser::Section section;
   section.section_type = NodeType::kVertexData;
-  section.contents = block;
+  section.data = block.data();
+  section.size = block.size();
   section.starting_line_number = 0;
 
   Parser parser;
@@ -351,12 +363,39 @@ TEST_F(VkScriptParserTest, VertexDataHeaderFormatString) {
   EXPECT_TRUE(buffers[1]->GetData().empty());
 }
 
+TEST_F(VkScriptParserTest, VertexDataHeaderInstanceRate) {
+  std::string block = "0/R32G32_SFLOAT 1/R32G32B32A32_SFLOAT/instance";
+
+  SectionParser::Section section;
+  section.section_type = NodeType::kVertexData;
+  section.data = block.data();
+  section.size = block.size();
+  section.starting_line_number = 0;
+
+  Parser parser;
+  Result r = parser.ProcessSectionForTesting(section);
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  auto script = parser.GetScript();
+  const auto& buffers = script->GetBuffers();
+  ASSERT_EQ(2U, buffers.size());
+
+  EXPECT_FALSE(buffers[0]->IsInputRateInstance());
+
+  ASSERT_EQ(BufferType::kVertex, buffers[1]->GetBufferType());
+  EXPECT_EQ(1U, buffers[1]->GetLocation());
+  EXPECT_EQ(FormatType::kR32G32B32A32_SFLOAT,
+            buffers[1]->AsFormatBuffer()->GetFormat().GetFormatType());
+  EXPECT_TRUE(buffers[1]->IsInputRateInstance());
+}
+
 TEST_F(VkScriptParserTest, VertexDataHeaderGlslString) {
   std::string block = "0/float/vec2 1/int/vec3";
 
   SectionParser::Section section;
   section.section_type = NodeType::kVertexData;
-  section.contents = block;
+  section.data = block.data();
+  section.size = block.size();
   section.starting_line_number = 0;
 
   Parser parser;
@@ -397,7 +436,8 @@ clear)";
 
   SectionParser::Section section;
   section.section_type = NodeType::kTest;
-  section.contents = block;
+  section.data = block.data();
+  section.size = block.size();
   section.starting_line_number = 0;
 
   Parser parser;
@@ -435,7 +475,8 @@ TEST_F(VkScriptParserTest, VertexDataRows) {
 
   SectionParser::Section section;
   section.section_type = NodeType::kVertexData;
-  section.contents = block;
+  section.data = block.data();
+  section.size = block.size();
   section.starting_line_number = 0;
 
   Parser parser;
@@ -476,7 +517,8 @@ TEST_F(VkScriptParserTest, VertexDataShortRow) {
 
   SectionParser::Section section;
   section.section_type = NodeType::kVertexData;
-  section.contents = block;
+  section.data = block.data();
+  section.size = block.size();
   section.starting_line_number = 0;
 
   Parser parser;
@@ -494,7 +536,8 @@ TEST_F(VkScriptParserTest, VertexDataIncorrectValue) {
 
   SectionParser::Section section;
   section.section_type = NodeType::kVertexData;
-  section.contents = block;
+  section.data = block.data();
+  section.size = block.size();
   section.starting_line_number = 0;
 
   Parser parser;
@@ -512,7 +555,8 @@ TEST_F(VkScriptParserTest, VertexDataRowsWithHex) {
 
   SectionParser::Section section;
   section.section_type = NodeType::kVertexData;
-  section.contents = block;
+  section.data = block.data();
+  section.size = block.size();
   section.starting_line_number = 0;
 
   Parser parser;
@@ -543,7 +587,8 @@ TEST_F(VkScriptParserTest, VertexDataRowsWithHexWrongColumn) {
 
   SectionParser::Section section;
   section.section_type = NodeType::kVertexData;
-  section.contents = block;
+  section.data = block.data();
+  section.size = block.size();
   section.starting_line_number = 0;
 
   Parser parser;
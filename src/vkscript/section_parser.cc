@@ -15,8 +15,8 @@
 #include "src/vkscript/section_parser.h"
 
 #include <cassert>
+#include <cstring>
 #include <iostream>
-#include <sstream>
 #include <string>
 
 #include "src/make_unique.h"
@@ -129,17 +129,18 @@ void SectionParser::AddSection(NodeType section_type,
                                ShaderType shader_type,
                                ShaderFormat fmt,
                                size_t line_count,
-                               const std::string& contents) {
+                               const char* contents,
+                               size_t size) {
   if (section_type == NodeType::kComment)
     return;
 
   if (fmt == kShaderFormatDefault) {
     sections_.push_back({section_type, shader_type, kShaderFormatSpirvAsm,
-                         line_count, kPassThroughShader});
+                         line_count, kPassThroughShader,
+                         strlen(kPassThroughShader)});
     return;
   }
 
-  size_t size = contents.size();
   while (size > 0) {
     if (contents[size - 1] == '\n' || contents[size - 1] == '\r') {
       --size;
@@ -149,11 +150,10 @@ void SectionParser::AddSection(NodeType section_type,
   }
 
   sections_.push_back(
-      {section_type, shader_type, fmt, line_count, contents.substr(0, size)});
+      {section_type, shader_type, fmt, line_count, contents, size});
 }
 
 Result SectionParser::SplitSections(const std::string& data) {
-  std::stringstream ss(data);
   size_t line_count = 0;
   size_t section_start = 0;
   bool in_section = false;
@@ -161,49 +161,61 @@ Result SectionParser::SplitSections(const std::string& data) {
   NodeType current_type = NodeType::kComment;
   ShaderType current_shader = kShaderTypeVertex;
   ShaderFormat current_fmt = kShaderFormatText;
-  std::string section_contents;
-
-  for (std::string line; std::getline(ss, line);) {
+  // Offset of the first content byte of the current section; the section
+  // becomes a view [contents_begin, start of the next header line).
+  size_t contents_begin = 0;
+
+  size_t pos = 0;
+  while (pos < data.size()) {
+    size_t eol = data.find('\n', pos);
+    size_t line_end = eol == std::string::npos ? data.size() : eol;
+    size_t next_pos = eol == std::string::npos ? data.size() : eol + 1;
+    size_t line_len = line_end - pos;
     ++line_count;
 
+    bool blank =
+        line_len == 0 || (line_len == 1 && data[pos] == '\r');
+
     if (!in_section) {
-      if (line.empty() || line[0] == '#' || line == "\r")
+      if (blank || data[pos] == '#') {
+        pos = next_pos;
         continue;
+      }
 
-      if (line[0] != '[')
+      if (data[pos] != '[')
         return Result(std::to_string(line_count) + ": Invalid character");
 
       section_start = line_count;
       in_section = true;
     }
 
-    if (line.empty()) {
-      section_contents += "\n";
-      continue;
-    }
-
-    if (line[0] == '[') {
+    if (!blank && data[pos] == '[') {
       AddSection(current_type, current_shader, current_fmt, section_start,
-                 section_contents);
+                 data.data() + contents_begin, pos - contents_begin);
       section_start = line_count;
-      section_contents = "";
-
-      size_t name_end = line.rfind("]");
+      contents_begin = next_pos;
+
+      size_t name_end = std::string::npos;
+      for (size_t i = line_end; i-- > pos;) {
+        if (data[i] == ']') {
+          name_end = i;
+          break;
+        }
+      }
       if (name_end == std::string::npos)
         return Result(std::to_string(line_count) + ": Missing section close");
 
-      std::string name = line.substr(1, name_end - 1);
+      std::string name = data.substr(pos + 1, name_end - pos - 1);
 
       Result r =
           NameToNodeType(name, &current_type, &current_shader, &current_fmt);
       if (!r.IsSuccess())
         return Result(std::to_string(line_count) + ": " + r.Error());
-    } else {
-      section_contents += line + "\n";
     }
+    pos = next_pos;
   }
   AddSection(current_type, current_shader, current_fmt, section_start,
-             section_contents);
+             data.data() + contents_begin, data.size() - contents_begin);
 
   return {};
 }
@@ -36,12 +36,19 @@ enum class NodeType : uint8_t {
 
 class SectionParser {
  public:
+  // A section of the script, viewing the text in place instead of
+  // holding a copy; the script buffer handed to Parse() must stay alive
+  // for as long as the sections are used. Passthrough shader sections
+  // view the static passthrough source instead.
   struct Section {
     NodeType section_type;
     ShaderType shader_type;  // Only valid when section_type == kShader
     ShaderFormat format;
     size_t starting_line_number;
-    std::string contents;
+    const char* data;
+    size_t size;
+
+    std::string ToString() const { return std::string(data, size); }
   };
 
   static bool HasShader(const NodeType type);
@@ -69,7 +76,8 @@ class SectionParser {
                   ShaderType shader_type,
                   ShaderFormat fmt,
                   size_t starting_line_number,
-                  const std::string& contents);
+                  const char* contents,
+                  size_t size);
   Result NameToNodeType(const std::string& name,
                         NodeType* section_type,
                         ShaderType* shader_type,
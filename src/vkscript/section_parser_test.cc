@@ -47,7 +47,7 @@ void main() {
   EXPECT_EQ(NodeType::kShader, sections[0].section_type);
   EXPECT_EQ(kShaderTypeVertex, sections[0].shader_type);
   EXPECT_EQ(kShaderFormatGlsl, sections[0].format);
-  EXPECT_EQ(shader, sections[0].contents);
+  EXPECT_EQ(shader, sections[0].ToString());
 }
 
 TEST_F(SectionParserTest, ParseShaderGlslVertexPassthrough) {
@@ -62,7 +62,7 @@ TEST_F(SectionParserTest, ParseShaderGlslVertexPassthrough) {
   EXPECT_EQ(NodeType::kShader, sections[0].section_type);
   EXPECT_EQ(kShaderTypeVertex, sections[0].shader_type);
   EXPECT_EQ(kShaderFormatSpirvAsm, sections[0].format);
-  EXPECT_EQ(kPassThroughShader, sections[0].contents);
+  EXPECT_EQ(kPassThroughShader, sections[0].ToString());
 }
 
 TEST_F(SectionParserTest, SectionParserMultipleSections) {
@@ -99,29 +99,29 @@ test body.)";
   EXPECT_EQ(NodeType::kShader, sections[0].section_type);
   EXPECT_EQ(kShaderTypeVertex, sections[0].shader_type);
   EXPECT_EQ(kShaderFormatSpirvAsm, sections[0].format);
-  EXPECT_EQ(kPassThroughShader, sections[0].contents);
+  EXPECT_EQ(kPassThroughShader, sections[0].ToString());
 
   // fragment shader
   EXPECT_EQ(NodeType::kShader, sections[1].section_type);
   EXPECT_EQ(kShaderTypeFragment, sections[1].shader_type);
   EXPECT_EQ(kShaderFormatGlsl, sections[1].format);
-  EXPECT_EQ("#version 430\nvoid main() {}", sections[1].contents);
+  EXPECT_EQ("#version 430\nvoid main() {}", sections[1].ToString());
 
   // geometry shader
   EXPECT_EQ(NodeType::kShader, sections[2].section_type);
   EXPECT_EQ(kShaderTypeGeometry, sections[2].shader_type);
   EXPECT_EQ(kShaderFormatGlsl, sections[2].format);
-  EXPECT_EQ("float4 main() {}", sections[2].contents);
+  EXPECT_EQ("float4 main() {}", sections[2].ToString());
 
   // indices
   EXPECT_EQ(NodeType::kIndices, sections[3].section_type);
   EXPECT_EQ(kShaderFormatText, sections[3].format);
-  EXPECT_EQ("1 2 3 4\n5 6 7 8", sections[3].contents);
+  EXPECT_EQ("1 2 3 4\n5 6 7 8", sections[3].ToString());
 
   // test
   EXPECT_EQ(NodeType::kTest, sections[4].section_type);
   EXPECT_EQ(kShaderFormatText, sections[4].format);
-  EXPECT_EQ("test body.", sections[4].contents);
+  EXPECT_EQ("test body.", sections[4].ToString());
 }
 
 TEST_F(SectionParserTest, SkipCommentLinesOutsideSections) {
@@ -136,7 +136,7 @@ TEST_F(SectionParserTest, SkipCommentLinesOutsideSections) {
   EXPECT_EQ(NodeType::kShader, sections[0].section_type);
   EXPECT_EQ(kShaderTypeVertex, sections[0].shader_type);
   EXPECT_EQ(kShaderFormatGlsl, sections[0].format);
-  EXPECT_EQ("", sections[0].contents);
+  EXPECT_EQ("", sections[0].ToString());
 }
 
 TEST_F(SectionParserTest, SkipBlankLinesOutsideSections) {
@@ -151,7 +151,7 @@ TEST_F(SectionParserTest, SkipBlankLinesOutsideSections) {
   EXPECT_EQ(NodeType::kShader, sections[0].section_type);
   EXPECT_EQ(kShaderTypeVertex, sections[0].shader_type);
   EXPECT_EQ(kShaderFormatGlsl, sections[0].format);
-  EXPECT_EQ("", sections[0].contents);
+  EXPECT_EQ("", sections[0].ToString());
 }
 
 TEST_F(SectionParserTest, UnknownTextOutsideSection) {
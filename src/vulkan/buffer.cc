@@ -14,10 +14,25 @@
 
 #include "src/vulkan/buffer.h"
 
+#include <cstdint>
+#include <limits>
+
 #include "src/vulkan/device.h"
 
 namespace amber {
 namespace vulkan {
+namespace {
+
+// vkCmdUpdateBuffer caps one inline update at 64KB and requires the
+// size to be a multiple of 4.
+const size_t kMaxInlineUpdateSizeInBytes = 65536;
+
+// Data files are mapped with at least 4KB page granularity, so rounding
+// an import inside one up to an alignment no larger than this never
+// reaches past the mapping. Larger driver alignments decline the import.
+const VkDeviceSize kMaxHostPointerImportAlignment = 4096;
+
+}  // namespace
 
 Buffer::Buffer(Device* device,
                size_t size_in_bytes,
@@ -27,26 +42,168 @@ Buffer::Buffer(Device* device,
 Buffer::~Buffer() = default;
 
 Result Buffer::Initialize(const VkBufferUsageFlags usage) {
+  usage_ = usage;
+
   Result r = CreateVkBuffer(&buffer_, usage);
   if (!r.IsSuccess())
     return r;
 
-  AllocateResult allocate_result =
-      AllocateAndBindMemoryToVkBuffer(buffer_, &memory_,
-                                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                                          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                      true);
+  // On unified memory devices put the buffer straight into device local
+  // memory the host can write; the device then reads it at full speed and
+  // no staging copy ever happens.
+  AllocateResult allocate_result = {Result("no memory type chosen yet"), 0};
+  if (device_->HasUnifiedMemory()) {
+    allocate_result = AllocateAndBindMemoryToVkBuffer(
+        buffer_, &allocation_,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT |
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        true);
+  }
+  if (!allocate_result.r.IsSuccess()) {
+    allocate_result = AllocateAndBindMemoryToVkBuffer(
+        buffer_, &allocation_,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        true);
+  }
+  if (!allocate_result.r.IsSuccess()) {
+    // Some heaps expose only non coherent host visible memory. Fall back
+    // to it; FlushMemoryIfNeeded() and InvalidateMemoryIfNeeded() take
+    // care of the explicit flushes around host accesses.
+    allocate_result = AllocateAndBindMemoryToVkBuffer(
+        buffer_, &allocation_, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, true);
+  }
   if (!allocate_result.r.IsSuccess())
     return allocate_result.r;
 
-  if (!IsMemoryHostAccessible(allocate_result.memory_type_index) ||
-      !IsMemoryHostCoherent(allocate_result.memory_type_index)) {
+  if (!IsMemoryHostAccessible(allocate_result.memory_type_index)) {
     return Result(
-        "Vulkan: Buffer::Initialize() Buffer is not host accessible or not "
-        "host coherent.");
+        "Vulkan: Buffer::Initialize() Buffer is not host accessible.");
   }
 
-  return MapMemory(memory_);
+  return MapMemory(allocation_);
+}
+
+Result Buffer::InitializeFromHostPointer(const VkBufferUsageFlags usage,
+                                         const uint8_t* host_ptr) {
+  if (!device_->SupportsHostPointerImport())
+    return Result("Vulkan::Buffer host pointer import is not supported");
+
+  const VkDeviceSize alignment = device_->GetHostPointerImportAlignment();
+  if (alignment > kMaxHostPointerImportAlignment ||
+      reinterpret_cast<uintptr_t>(host_ptr) % alignment != 0) {
+    return Result("Vulkan::Buffer host pointer is not aligned for import");
+  }
+
+  usage_ = usage;
+
+  VkExternalMemoryBufferCreateInfo external_info =
+      VkExternalMemoryBufferCreateInfo();
+  external_info.sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO;
+  external_info.handleTypes =
+      VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT;
+
+  VkBufferCreateInfo buffer_info = VkBufferCreateInfo();
+  buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  buffer_info.pNext = &external_info;
+  buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  buffer_info.size = GetSizeInBytes();
+  buffer_info.usage = usage;
+
+  if (device_->GetPtrs()->vkCreateBuffer(device_->GetDevice(), &buffer_info,
+                                         device_->GetHostAllocator(),
+                                         &buffer_) != VK_SUCCESS) {
+    return Result("Vulkan::Calling vkCreateBuffer Fail");
+  }
+
+  VkMemoryRequirements requirements = VkMemoryRequirements();
+  device_->GetPtrs()->vkGetBufferMemoryRequirements(device_->GetDevice(),
+                                                    buffer_, &requirements);
+
+  void* import_ptr = const_cast<uint8_t*>(host_ptr);
+
+  VkMemoryHostPointerPropertiesEXT pointer_properties =
+      VkMemoryHostPointerPropertiesEXT();
+  pointer_properties.sType =
+      VK_STRUCTURE_TYPE_MEMORY_HOST_POINTER_PROPERTIES_EXT;
+  if (device_->GetMemoryHostPointerProperties()(
+          device_->GetDevice(),
+          VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT, import_ptr,
+          &pointer_properties) != VK_SUCCESS) {
+    device_->GetPtrs()->vkDestroyBuffer(device_->GetDevice(), buffer_,
+                                        device_->GetHostAllocator());
+    buffer_ = VK_NULL_HANDLE;
+    return Result("Vulkan::Calling vkGetMemoryHostPointerPropertiesEXT Fail");
+  }
+
+  const VkDeviceSize import_size =
+      ((GetSizeInBytes() + alignment - 1) / alignment) * alignment;
+
+  // The memory type must satisfy both the buffer and the pointer, and
+  // must be host coherent because the imported pages may be read only
+  // and can never take an explicit flush or invalidate.
+  const uint32_t type_bits =
+      requirements.memoryTypeBits & pointer_properties.memoryTypeBits;
+  uint32_t memory_type_index = std::numeric_limits<uint32_t>::max();
+  const auto& memory_properties = device_->GetPhysicalMemoryProperties();
+  for (uint32_t i = 0; i < memory_properties.memoryTypeCount; ++i) {
+    if (!(type_bits & (1U << i)))
+      continue;
+    if (IsMemoryHostAccessible(i) && IsMemoryHostCoherent(i)) {
+      memory_type_index = i;
+      break;
+    }
+  }
+  if (memory_type_index == std::numeric_limits<uint32_t>::max() ||
+      requirements.size > import_size) {
+    device_->GetPtrs()->vkDestroyBuffer(device_->GetDevice(), buffer_,
+                                        device_->GetHostAllocator());
+    buffer_ = VK_NULL_HANDLE;
+    return Result("Vulkan::Buffer no importable memory type for host pointer");
+  }
+
+  VkImportMemoryHostPointerInfoEXT import_info =
+      VkImportMemoryHostPointerInfoEXT();
+  import_info.sType = VK_STRUCTURE_TYPE_IMPORT_MEMORY_HOST_POINTER_INFO_EXT;
+  import_info.handleType =
+      VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT;
+  import_info.pHostPointer = import_ptr;
+
+  VkMemoryAllocateInfo allocate_info = VkMemoryAllocateInfo();
+  allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  allocate_info.pNext = &import_info;
+  allocate_info.allocationSize = import_size;
+  allocate_info.memoryTypeIndex = memory_type_index;
+
+  VkDeviceMemory memory = VK_NULL_HANDLE;
+  if (device_->GetPtrs()->vkAllocateMemory(device_->GetDevice(),
+                                           &allocate_info,
+                                           device_->GetHostAllocator(),
+                                           &memory) != VK_SUCCESS) {
+    device_->GetPtrs()->vkDestroyBuffer(device_->GetDevice(), buffer_,
+                                        device_->GetHostAllocator());
+    buffer_ = VK_NULL_HANDLE;
+    return Result("Vulkan::Calling vkAllocateMemory Fail");
+  }
+
+  if (device_->GetPtrs()->vkBindBufferMemory(device_->GetDevice(), buffer_,
+                                             memory, 0) != VK_SUCCESS) {
+    device_->GetPtrs()->vkFreeMemory(device_->GetDevice(), memory,
+                                     device_->GetHostAllocator());
+    device_->GetPtrs()->vkDestroyBuffer(device_->GetDevice(), buffer_,
+                                        device_->GetHostAllocator());
+    buffer_ = VK_NULL_HANDLE;
+    return Result("Vulkan::Calling vkBindBufferMemory Fail");
+  }
+
+  allocation_.memory = memory;
+  allocation_.offset = 0;
+  allocation_.size = import_size;
+  allocation_.cpu_memory = import_ptr;
+  imported_host_pointer_ = true;
+
+  return MapMemory(allocation_);
 }
 
 Result Buffer::CreateVkBufferView(VkFormat format) {
@@ -57,7 +214,8 @@ Result Buffer::CreateVkBufferView(VkFormat format) {
   buffer_view_info.offset = 0;
   buffer_view_info.range = VK_WHOLE_SIZE;
   if (device_->GetPtrs()->vkCreateBufferView(device_->GetDevice(),
-                                             &buffer_view_info, nullptr,
+                                             &buffer_view_info,
+                                             device_->GetHostAllocator(),
                                              &view_) != VK_SUCCESS) {
     return Result("Vulkan::Calling vkCreateBufferView Fail");
   }
@@ -65,20 +223,139 @@ Result Buffer::CreateVkBufferView(VkFormat format) {
   return {};
 }
 
+Result Buffer::CreateDeviceLocalCopy() {
+  if (device_local_buffer_ != VK_NULL_HANDLE)
+    return {};
+
+  Result r = CreateVkBuffer(&device_local_buffer_,
+                            usage_ | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+  if (!r.IsSuccess())
+    return r;
+
+  AllocateResult allocate_result = AllocateAndBindMemoryToVkBuffer(
+      device_local_buffer_, &device_local_allocation_,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+  if (!allocate_result.r.IsSuccess()) {
+    device_->GetPtrs()->vkDestroyBuffer(device_->GetDevice(),
+                                        device_local_buffer_,
+                                        device_->GetHostAllocator());
+    device_local_buffer_ = VK_NULL_HANDLE;
+    return allocate_result.r;
+  }
+
+  return {};
+}
+
+Result Buffer::RecordCopyToDeviceLocal(VkCommandBuffer command) {
+  if (device_local_buffer_ == VK_NULL_HANDLE)
+    return Result("Vulkan::Buffer has no device-local copy to fill");
+
+  Result r = FlushMemoryIfNeeded();
+  if (!r.IsSuccess())
+    return r;
+
+  MemoryBarrier(command, VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_WRITE_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+
+  VkBufferCopy region = VkBufferCopy();
+  region.srcOffset = 0;
+  region.dstOffset = 0;
+  region.size = GetSizeInBytes();
+  device_->GetPtrs()->vkCmdCopyBuffer(command, buffer_, device_local_buffer_,
+                                      1, &region);
+
+  MemoryBarrier(command, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_ACCESS_TRANSFER_WRITE_BIT, GetDeviceStageMask(),
+                GetDeviceAccessMask());
+  return {};
+}
+
+bool Buffer::CanInlineUpdateDeviceLocal() const {
+  return device_local_buffer_ != VK_NULL_HANDLE &&
+         GetSizeInBytes() <= kMaxInlineUpdateSizeInBytes &&
+         GetSizeInBytes() % 4 == 0;
+}
+
+Result Buffer::RecordInlineUpdateToDeviceLocal(VkCommandBuffer command) {
+  if (!CanInlineUpdateDeviceLocal()) {
+    return Result(
+        "Vulkan::Buffer device-local copy cannot be updated inline");
+  }
+
+  // Draws recorded earlier in this command buffer may still read the old
+  // contents; order the update after them.
+  MemoryBarrier(command, GetDeviceStageMask(), GetDeviceAccessMask(),
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+  // The new bytes are copied into the command buffer here at record
+  // time, so the host-visible |buffer_| needs no flush and is never read
+  // by the device for this update.
+  device_->GetPtrs()->vkCmdUpdateBuffer(command, device_local_buffer_, 0,
+                                        GetSizeInBytes(),
+                                        HostAccessibleMemoryPtr());
+
+  MemoryBarrier(command, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_ACCESS_TRANSFER_WRITE_BIT, GetDeviceStageMask(),
+                GetDeviceAccessMask());
+  return {};
+}
+
 Result Buffer::CopyToDevice(VkCommandBuffer command) {
-  // This is redundant because this buffer is always host visible
-  // and coherent and vkQueueSubmit will make writes from host
-  // avaliable (See chapter 6.9. "Host Write Ordering Guarantees" in
-  // Vulkan spec), but we prefer to keep it to simplify our own code.
-  MemoryBarrier(command);
+  Result r = FlushMemoryIfNeeded();
+  if (!r.IsSuccess())
+    return r;
+
+  // The barrier is redundant when this buffer is host coherent because
+  // vkQueueSubmit will make writes from host avaliable (See chapter 6.9.
+  // "Host Write Ordering Guarantees" in Vulkan spec), but we prefer to
+  // keep it to simplify our own code.
+  MemoryBarrier(command, VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_WRITE_BIT,
+                GetDeviceStageMask(), GetDeviceAccessMask());
   return {};
 }
 
 Result Buffer::CopyToHost(VkCommandBuffer command) {
-  MemoryBarrier(command);
+  // Only device writes need to be made visible to the host; a buffer the
+  // device can merely read needs no barrier at all.
+  const VkAccessFlags write_access =
+      GetDeviceAccessMask() &
+      (VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT);
+  if (write_access == 0)
+    return {};
+
+  MemoryBarrier(command, GetDeviceStageMask(), write_access,
+                VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
   return {};
 }
 
+Result Buffer::FlushMemoryIfNeeded() {
+  // Imported host pointer memory is required to be host coherent.
+  if (imported_host_pointer_)
+    return {};
+  return device_->GetMemoryAllocator()->Flush(allocation_);
+}
+
+Result Buffer::FlushMemoryRangeIfNeeded(VkDeviceSize offset,
+                                        VkDeviceSize size) {
+  if (imported_host_pointer_)
+    return {};
+  return device_->GetMemoryAllocator()->FlushRange(allocation_, offset, size);
+}
+
+Result Buffer::InvalidateMemoryIfNeeded() {
+  if (imported_host_pointer_)
+    return {};
+  return device_->GetMemoryAllocator()->Invalidate(allocation_);
+}
+
+Result Buffer::InvalidateMemoryRangeIfNeeded(VkDeviceSize offset,
+                                             VkDeviceSize size) {
+  if (imported_host_pointer_)
+    return {};
+  return device_->GetMemoryAllocator()->InvalidateRange(allocation_, offset,
+                                                        size);
+}
+
 void Buffer::CopyFromBuffer(VkCommandBuffer command, const Buffer& src) {
   VkBufferCopy region = VkBufferCopy();
   region.srcOffset = 0;
@@ -87,22 +364,85 @@ void Buffer::CopyFromBuffer(VkCommandBuffer command, const Buffer& src) {
 
   device_->GetPtrs()->vkCmdCopyBuffer(command, src.buffer_, buffer_, 1,
                                       &region);
-  MemoryBarrier(command);
+  MemoryBarrier(command, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_ACCESS_TRANSFER_WRITE_BIT,
+                GetDeviceStageMask() | VK_PIPELINE_STAGE_HOST_BIT,
+                GetDeviceAccessMask() | VK_ACCESS_HOST_READ_BIT);
+}
+
+VkPipelineStageFlags Buffer::GetDeviceStageMask() const {
+  VkPipelineStageFlags stages = 0;
+  if (usage_ &
+      (VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT)) {
+    stages |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+  }
+  if (usage_ & (VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT |
+                VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT)) {
+    stages |= VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT |
+              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+  }
+  if (usage_ &
+      (VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT)) {
+    stages |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+  }
+  return stages;
+}
+
+VkAccessFlags Buffer::GetDeviceAccessMask() const {
+  VkAccessFlags access = 0;
+  if (usage_ & VK_BUFFER_USAGE_VERTEX_BUFFER_BIT)
+    access |= VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+  if (usage_ & VK_BUFFER_USAGE_INDEX_BUFFER_BIT)
+    access |= VK_ACCESS_INDEX_READ_BIT;
+  if (usage_ & (VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
+                VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT)) {
+    access |= VK_ACCESS_UNIFORM_READ_BIT;
+  }
+  if (usage_ & (VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT)) {
+    access |= VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  }
+  if (usage_ & VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
+    access |= VK_ACCESS_TRANSFER_READ_BIT;
+  if (usage_ & VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+    access |= VK_ACCESS_TRANSFER_WRITE_BIT;
+  return access;
 }
 
 void Buffer::Shutdown() {
   if (view_ != VK_NULL_HANDLE) {
-    device_->GetPtrs()->vkDestroyBufferView(device_->GetDevice(), view_,
-                                            nullptr);
+    device_->GetPtrs()->vkDestroyBufferView(device_->GetDevice(),
+                                            view_,
+                                            device_->GetHostAllocator());
   }
 
-  if (memory_ != VK_NULL_HANDLE) {
-    UnMapMemory(memory_);
-    device_->GetPtrs()->vkFreeMemory(device_->GetDevice(), memory_, nullptr);
+  if (imported_host_pointer_) {
+    // Imported memory is a dedicated allocation, not a sub-allocator
+    // range; the bytes behind it stay with their owner.
+    if (allocation_.memory != VK_NULL_HANDLE) {
+      device_->GetPtrs()->vkFreeMemory(device_->GetDevice(),
+                                       allocation_.memory,
+                                       device_->GetHostAllocator());
+    }
+    allocation_ = MemoryAllocation();
+  } else {
+    FreeMemory(&allocation_);
   }
 
   if (buffer_ != VK_NULL_HANDLE)
-    device_->GetPtrs()->vkDestroyBuffer(device_->GetDevice(), buffer_, nullptr);
+    device_->GetPtrs()->vkDestroyBuffer(device_->GetDevice(),
+                                        buffer_,
+                                        device_->GetHostAllocator());
+
+  FreeMemory(&device_local_allocation_);
+
+  if (device_local_buffer_ != VK_NULL_HANDLE) {
+    device_->GetPtrs()->vkDestroyBuffer(device_->GetDevice(),
+                                        device_local_buffer_,
+                                        device_->GetHostAllocator());
+  }
 
   Resource::Shutdown();
 }
@@ -24,10 +24,9 @@ namespace vulkan {
 
 class Device;
 
-// Class managing Vulkan Buffer i.e., VkBuffer |buffer_|. |memory_|
-// has VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT and
-// VK_MEMORY_PROPERTY_HOST_COHERENT_BIT properties and it is mapped
-// to |buffer_|.
+// Class managing Vulkan Buffer i.e., VkBuffer |buffer_|. |allocation_|
+// has the VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT property, preferably also
+// VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, and it is mapped to |buffer_|.
 class Buffer : public Resource {
  public:
   Buffer(Device* device,
@@ -35,29 +34,91 @@ class Buffer : public Resource {
          const VkPhysicalDeviceMemoryProperties& properties);
   ~Buffer() override;
 
-  // Create |buffer_| whose usage is |usage| and allocate |memory_|
-  // with VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT and
-  // VK_MEMORY_PROPERTY_HOST_COHERENT_BIT properties. It also maps
-  // |memory_| to |buffer_|
+  // Create |buffer_| whose usage is |usage| and allocate |allocation_|
+  // with the VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT property, preferring
+  // memory that is also host coherent. It also binds |allocation_| to
+  // |buffer_|
   Result Initialize(const VkBufferUsageFlags usage);
 
+  // Create |buffer_| backed by |host_ptr| itself, imported as device
+  // memory through VK_EXT_external_memory_host instead of copied into an
+  // allocation. |host_ptr| must stay valid and unchanged for the life of
+  // the buffer and be aligned to the device's import alignment; the
+  // imported size is the buffer size rounded up to that alignment, which
+  // for bytes inside a mapped data file never leaves the mapping. Fails
+  // without side effects when the device or driver declines the import;
+  // callers then fall back to Initialize().
+  Result InitializeFromHostPointer(const VkBufferUsageFlags usage,
+                                   const uint8_t* host_ptr);
+
+  // True when |buffer_| was created by InitializeFromHostPointer(). The
+  // bytes behind HostAccessibleMemoryPtr() then belong to the caller and
+  // may be read only; updates must recreate the buffer instead of
+  // writing them in place.
+  bool IsImportedHostPointer() const { return imported_host_pointer_; }
+
   VkBuffer GetVkBuffer() const { return buffer_; }
   Result CreateVkBufferView(VkFormat format);
   VkBufferView GetVkBufferView() const { return view_; }
 
-  // Since |buffer_| is mapped to host accessible and host coherent
-  // memory |memory_|, this method only conducts memory barrier to
-  // make it available to device domain.
+  // Gives the buffer a device-local shadow: a second VkBuffer bound to
+  // device-local memory, filled by the one-time transfer recorded with
+  // RecordCopyToDeviceLocal(). Draws reading the shadow fetch from
+  // device memory instead of across the bus. Fails when no memory type
+  // carries the device-local property; callers then keep reading
+  // |buffer_|.
+  Result CreateDeviceLocalCopy();
+
+  bool HasDeviceLocalCopy() const {
+    return device_local_buffer_ != VK_NULL_HANDLE;
+  }
+  VkBuffer GetDeviceLocalVkBuffer() const { return device_local_buffer_; }
+
+  // Records the transfer of the current contents into the device-local
+  // copy, bracketed by barriers so the device reads it through the
+  // stages of this buffer's usage.
+  Result RecordCopyToDeviceLocal(VkCommandBuffer command);
+
+  // True when the device-local copy can be refreshed with
+  // RecordInlineUpdateToDeviceLocal(): the buffer has one and its size
+  // meets the vkCmdUpdateBuffer limits of 64KB and a multiple of 4.
+  bool CanInlineUpdateDeviceLocal() const;
+
+  // Records a vkCmdUpdateBuffer rewriting the device-local copy from the
+  // current host-visible contents. The data rides inline in the command
+  // buffer, so no transfer from |buffer_| happens at execution time.
+  // Must be recorded outside a render pass instance.
+  Result RecordInlineUpdateToDeviceLocal(VkCommandBuffer command);
+
+  // Since |buffer_| is bound to host accessible memory |allocation_|,
+  // this method only flushes it if the memory is not host coherent and
+  // conducts a memory barrier making the host writes visible to the
+  // pipeline stages this buffer is used in, derived from its usage.
   virtual Result CopyToDevice(VkCommandBuffer command);
 
   // Resource
-  VkDeviceMemory GetHostAccessMemory() const override { return memory_; }
+  VkDeviceMemory GetHostAccessMemory() const override {
+    return allocation_.memory;
+  }
 
-  // Since |buffer_| is mapped to host accessible and host coherent
-  // memory |memory_|, this method only conducts memory barrier to
-  // make it available to host domain.
+  // Since |buffer_| is bound to host accessible memory |allocation_|,
+  // this method only conducts a memory barrier making device writes
+  // visible to the host. Nothing is recorded for buffers the device can
+  // not write. Readers of HostAccessibleMemoryPtr() must call
+  // InvalidateMemoryIfNeeded() once the submission completed.
   Result CopyToHost(VkCommandBuffer command) override;
 
+  // Resource; |buffer_| is backed by |allocation_| rather than a
+  // staging buffer.
+  Result FlushMemoryIfNeeded() override;
+  Result FlushMemoryRangeIfNeeded(VkDeviceSize offset,
+                                  VkDeviceSize size) override;
+  Result InvalidateMemoryIfNeeded() override;
+
+  // Makes device writes to |size| bytes at |offset| of this buffer
+  // visible to the host. A no-op on host coherent memory.
+  Result InvalidateMemoryRangeIfNeeded(VkDeviceSize offset, VkDeviceSize size);
+
   // Copy all data from |src| to |this| and wait until
   // the memory update is effective by calling vkCmdPipelineBarrier().
   // Note that this method only records the copy command and the
@@ -66,10 +127,23 @@ class Buffer : public Resource {
 
   void Shutdown() override;
 
+  // Pipeline stages and access types that may touch this buffer on the
+  // device, derived from the usage flags it was created with. Used to
+  // build minimal barriers instead of full pipeline ones.
+  VkPipelineStageFlags GetDeviceStageMask() const;
+  VkAccessFlags GetDeviceAccessMask() const;
+
  private:
   VkBuffer buffer_ = VK_NULL_HANDLE;
   VkBufferView view_ = VK_NULL_HANDLE;
-  VkDeviceMemory memory_ = VK_NULL_HANDLE;
+  MemoryAllocation allocation_;
+  VkBufferUsageFlags usage_ = 0;
+  bool imported_host_pointer_ = false;
+
+  // Optional device-local shadow of |buffer_|; see
+  // CreateDeviceLocalCopy().
+  VkBuffer device_local_buffer_ = VK_NULL_HANDLE;
+  MemoryAllocation device_local_allocation_;
 };
 
 }  // namespace vulkan
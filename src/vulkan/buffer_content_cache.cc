@@ -0,0 +1,90 @@
+// Copyright 2018 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/vulkan/buffer_content_cache.h"
+
+#include <cstring>
+
+#include "src/vulkan/device.h"
+
+namespace amber {
+namespace vulkan {
+namespace {
+
+// Total cached bytes past which new content is no longer cached. There
+// is no eviction: a blob worth caching is one that keeps recurring, and
+// dropping it just to admit a newer one would throw the reuse away.
+const size_t kMaxCacheBytes = 256 << 20;
+
+// FNV-1a, 64 bit.
+uint64_t HashBytes(const uint8_t* data, size_t size) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= data[i];
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+}  // namespace
+
+BufferContentCache::BufferContentCache(Device* device) : device_(device) {}
+
+BufferContentCache::~BufferContentCache() = default;
+
+VkBuffer BufferContentCache::GetOrCreate(const uint8_t* data, size_t size) {
+  if (size == 0)
+    return VK_NULL_HANDLE;
+
+  uint64_t hash = HashBytes(data, size);
+  auto& chain = entries_[hash];
+  for (const auto& entry : chain) {
+    if (entry.content_size == size &&
+        std::memcmp(entry.buffer.cpu_memory, data, size) == 0) {
+      return entry.buffer.buffer;
+    }
+  }
+
+  if (total_bytes_ + size > kMaxCacheBytes)
+    return VK_NULL_HANDLE;
+
+  Entry entry;
+  Result r = device_->GetStagingBufferPool()->Acquire(size, &entry.buffer);
+  if (!r.IsSuccess())
+    return VK_NULL_HANDLE;
+
+  std::memcpy(entry.buffer.cpu_memory, data, size);
+  r = device_->GetMemoryAllocator()->Flush(entry.buffer.allocation);
+  if (!r.IsSuccess()) {
+    device_->GetStagingBufferPool()->Release(entry.buffer);
+    return VK_NULL_HANDLE;
+  }
+
+  entry.content_size = size;
+  total_bytes_ += size;
+  chain.push_back(entry);
+  return entry.buffer.buffer;
+}
+
+void BufferContentCache::Shutdown() {
+  for (auto& it : entries_) {
+    for (auto& entry : it.second)
+      device_->GetStagingBufferPool()->Release(entry.buffer);
+  }
+  entries_.clear();
+  total_bytes_ = 0;
+}
+
+}  // namespace vulkan
+}  // namespace amber
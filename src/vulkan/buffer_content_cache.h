@@ -0,0 +1,69 @@
+// Copyright 2018 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_VULKAN_BUFFER_CONTENT_CACHE_H_
+#define SRC_VULKAN_BUFFER_CONTENT_CACHE_H_
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "amber/vulkan_header.h"
+#include "src/vulkan/staging_buffer_pool.h"
+
+namespace amber {
+namespace vulkan {
+
+class Device;
+
+// Content addressed cache of buffer initializer bytes, owned by Device
+// like the other caches so entries survive pipelines and - when the
+// engine is kept alive - scripts. Generated corpora reuse identical
+// initializer blobs (lookup tables, identity matrices) across many
+// buffers; the bytes are uploaded once and every further buffer with
+// the same content is initialized by a device side copy from the cached
+// source instead of another host upload.
+class BufferContentCache {
+ public:
+  explicit BufferContentCache(Device* device);
+  ~BufferContentCache();
+
+  // Returns a buffer holding |size| bytes equal to |data|, uploading
+  // them on first sight. Returns VK_NULL_HANDLE when the content is not
+  // cached and cannot be - the cache reached its memory budget or the
+  // source buffer could not be created - and the caller uploads the
+  // bytes itself.
+  VkBuffer GetOrCreate(const uint8_t* data, size_t size);
+
+  // Releases every cached buffer back to the staging buffer pool. Must
+  // run before the pool's own Shutdown().
+  void Shutdown();
+
+ private:
+  struct Entry {
+    StagingBuffer buffer;
+    size_t content_size = 0;
+  };
+
+  Device* device_ = nullptr;
+  // Entries keyed by content hash. The chain absorbs hash collisions;
+  // every hit is verified against the full bytes.
+  std::map<uint64_t, std::vector<Entry>> entries_;
+  size_t total_bytes_ = 0;
+};
+
+}  // namespace vulkan
+}  // namespace amber
+
+#endif  // SRC_VULKAN_BUFFER_CONTENT_CACHE_H_
@@ -27,6 +27,10 @@ namespace amber {
 namespace vulkan {
 namespace {
 
+// Raw initializers below this size are cheaper to memcpy into the
+// mapped buffer than to hash for the content cache.
+const size_t kMinContentCacheBytes = 4096;
+
 // Return the size in bytes for a buffer that has enough capacity to
 // copy all data in |buffer_input_queue|.
 size_t GetBufferSizeInBytesForQueue(
@@ -59,13 +63,30 @@ BufferDescriptor::~BufferDescriptor() = default;
 
 Result BufferDescriptor::CreateResourceIfNeeded(
     const VkPhysicalDeviceMemoryProperties& properties) {
-  // Amber copies back contents of |buffer_| to host and put it into
-  // |buffer_input_queue_| right after draw or compute. Therefore,
-  // when calling this method, |buffer_| must be always empty.
+  // The buffer survives read backs, so it is usually still here with
+  // its contents current on the device. It is reused as is when no new
+  // data arrived, and kept for a ranged in-place update when every
+  // queued input fits inside it; only an update outgrowing the buffer
+  // pays a full copy out so the new contents merge over complete old
+  // ones.
   if (buffer_) {
-    return Result(
-        "Vulkan: BufferDescriptor::CreateResourceIfNeeded() must be called "
-        "only when |buffer_| is empty");
+    if (GetBufferInputQueue().empty() && GetBufferOutput().empty())
+      return {};
+
+    // RecordCopyDataToResourceIfNeeded() streams just the queued ranges
+    // into the live mapped contents, so the update cost scales with the
+    // bytes changed instead of the buffer size. A buffer backed by an
+    // imported host pointer is excluded: its bytes belong to the data
+    // file mapping and may be read only, so new data recreates it.
+    if (!buffer_->IsImportedHostPointer() && GetBufferOutput().empty() &&
+        GetBufferSizeInBytesForQueue(GetBufferInputQueue()) <=
+            buffer_->GetSizeInBytes()) {
+      return {};
+    }
+
+    Result r = ExtractResourceToBufferOutput();
+    if (!r.IsSuccess())
+      return r;
   }
 
   const auto& buffer_input_queue = GetBufferInputQueue();
@@ -80,9 +101,31 @@ Result BufferDescriptor::CreateResourceIfNeeded(
 
   buffer_ = MakeUnique<Buffer>(device_, size_in_bytes, properties);
 
-  Result r = buffer_->Initialize(GetVkBufferUsage() |
-                                 VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
-                                 VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+  const VkBufferUsageFlags usage = GetVkBufferUsage() |
+                                   VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                                   VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+  // A uniform buffer initialized by one raw input covering it entirely -
+  // the shape an external binary file produces - can import the mapped
+  // bytes as its memory on devices with VK_EXT_external_memory_host,
+  // making the upload free of any copy. The device never writes a
+  // uniform buffer, so handing it the read only mapping is safe. A
+  // declined import falls through to the copied path below.
+  if (device_->SupportsHostPointerImport() && IsUniformBuffer() &&
+      buffer_output.empty() && buffer_input_queue.size() == 1 &&
+      buffer_input_queue[0].raw_data != nullptr &&
+      buffer_input_queue[0].offset == 0 &&
+      buffer_input_queue[0].size_in_bytes == size_in_bytes) {
+    Result import_result = buffer_->InitializeFromHostPointer(
+        usage, buffer_input_queue[0].raw_data);
+    if (import_result.IsSuccess()) {
+      ClearBufferInputQueue();
+      SetUpdateDescriptorSetNeeded();
+      return {};
+    }
+  }
+
+  Result r = buffer_->Initialize(usage);
   if (!r.IsSuccess())
     return r;
 
@@ -90,37 +133,151 @@ Result BufferDescriptor::CreateResourceIfNeeded(
   return {};
 }
 
-Result BufferDescriptor::RecordCopyDataToResourceIfNeeded(
-    VkCommandBuffer command) {
+Result BufferDescriptor::RecordCopyDataToResourceIfNeeded(VkCommandBuffer) {
   auto& buffer_output = GetBufferOutput();
-  if (!buffer_output.empty()) {
+  const bool has_buffer_output = !buffer_output.empty();
+  if (has_buffer_output) {
     buffer_->UpdateMemoryWithRawData(buffer_output);
     buffer_output.clear();
   }
 
   const auto& buffer_input_queue = GetBufferInputQueue();
-  if (buffer_input_queue.empty())
-    return {};
 
-  for (const auto& input : buffer_input_queue) {
-    Result r = buffer_->UpdateMemoryWithInput(input);
+  // Two kinds of initializers become device side writes instead of
+  // being materialized on the host: constant initializers - most output
+  // SSBOs are zero filled - turn into vkCmdFillBuffer, and large raw
+  // initializers whose bytes the content cache has seen before turn
+  // into a copy from the cached source. Deferred writes execute at
+  // submission, after every host write below, and overlapping transfer
+  // writes are unordered among themselves, so an input is deferred only
+  // when no later input overlaps its range at all.
+  std::vector<uint32_t> fill_words(buffer_input_queue.size());
+  std::vector<int> deferred_kind(buffer_input_queue.size(), 0);
+  for (size_t i = 0; i < buffer_input_queue.size(); ++i) {
+    const BufferInput& input = buffer_input_queue[i];
+    if (static_cast<size_t>(input.offset) + input.size_in_bytes >
+        buffer_->GetSizeInBytes()) {
+      continue;
+    }
+
+    int kind = 0;
+    if (input.GetConstantFillWord(&fill_words[i])) {
+      kind = 1;
+    } else if (input.raw_data != nullptr &&
+               input.size_in_bytes >= kMinContentCacheBytes) {
+      kind = 2;
+    }
+    if (kind == 0)
+      continue;
+
+    bool safe = true;
+    for (size_t j = i + 1; j < buffer_input_queue.size(); ++j) {
+      const BufferInput& later = buffer_input_queue[j];
+      if (input.offset < later.offset + later.size_in_bytes &&
+          later.offset < input.offset + input.size_in_bytes) {
+        safe = false;
+        break;
+      }
+    }
+    if (safe)
+      deferred_kind[i] = kind;
+  }
+
+  // Remaining inputs are streamed in bounded chunks, each flushed as
+  // soon as it is written; an initializer larger than host memory
+  // allows therefore never needs one huge flush, and on non coherent
+  // memory the write back of one chunk overlaps the fill of the next.
+  // The pipeline still records one barrier merged over every descriptor
+  // afterwards.
+  for (size_t i = 0; i < buffer_input_queue.size(); ++i) {
+    if (deferred_kind[i] != 0) {
+      PendingDeviceWrite write;
+      write.is_fill = deferred_kind[i] == 1;
+      write.word = fill_words[i];
+      write.input = buffer_input_queue[i];
+      pending_device_writes_.push_back(write);
+      continue;
+    }
+    Result r = buffer_->UpdateMemoryWithInputStreamed(buffer_input_queue[i]);
     if (!r.IsSuccess())
       return r;
   }
 
   ClearBufferInputQueue();
 
-  buffer_->CopyToDevice(command);
+  // Only the raw output path is left to flush; the streamed inputs
+  // above already flushed their own ranges.
+  return has_buffer_output ? buffer_->FlushMemoryIfNeeded() : Result();
+}
+
+Result BufferDescriptor::RecordDeferredDeviceWrites(VkCommandBuffer command,
+                                                    bool* recorded) {
+  if (pending_device_writes_.empty())
+    return {};
+
+  if (!buffer_) {
+    return Result(
+        "Vulkan: BufferDescriptor::RecordDeferredDeviceWrites |buffer_| is "
+        "empty");
+  }
+
+  bool copy_barrier_recorded = false;
+  for (const auto& write : pending_device_writes_) {
+    if (write.is_fill) {
+      device_->GetPtrs()->vkCmdFillBuffer(command, buffer_->GetVkBuffer(),
+                                          write.input.offset,
+                                          write.input.size_in_bytes,
+                                          write.word);
+      *recorded = true;
+      continue;
+    }
+
+    // The cache may decline - budget reached or the source buffer could
+    // not be created - and the bytes then take the streamed host path
+    // after all, which is always correct because no later input
+    // overlaps a deferred range.
+    VkBuffer src = device_->GetBufferContentCache()->GetOrCreate(
+        write.input.raw_data, write.input.size_in_bytes);
+    if (src == VK_NULL_HANDLE) {
+      Result r = buffer_->UpdateMemoryWithInputStreamed(write.input);
+      if (!r.IsSuccess())
+        return r;
+      continue;
+    }
+
+    // The source may have been filled by the host during this very
+    // recording; one barrier covers every copy below.
+    if (!copy_barrier_recorded) {
+      RecordMemoryBarrier(device_, command, VK_PIPELINE_STAGE_HOST_BIT,
+                          VK_ACCESS_HOST_WRITE_BIT,
+                          VK_PIPELINE_STAGE_TRANSFER_BIT,
+                          VK_ACCESS_TRANSFER_READ_BIT);
+      copy_barrier_recorded = true;
+    }
+
+    VkBufferCopy region = VkBufferCopy();
+    region.srcOffset = 0;
+    region.dstOffset = write.input.offset;
+    region.size = write.input.size_in_bytes;
+    device_->GetPtrs()->vkCmdCopyBuffer(command, src, buffer_->GetVkBuffer(),
+                                        1, &region);
+    *recorded = true;
+  }
+  pending_device_writes_.clear();
   return {};
 }
 
-Result BufferDescriptor::RecordCopyDataToHost(VkCommandBuffer command) {
+Result BufferDescriptor::RecordCopyDataToHost(VkCommandBuffer) {
   if (!buffer_) {
     return Result(
         "Vulkan: BufferDescriptor::RecordCopyDataToHost() |buffer_| is empty");
   }
 
-  return buffer_->CopyToHost(command);
+  // The buffer is bound to host accessible memory, so there is no copy
+  // to record; the pipeline emits one merged device to host barrier for
+  // all descriptors.
+  SetPendingReadback();
+  return {};
 }
 
 Result BufferDescriptor::MoveResourceToBufferOutput() {
@@ -130,17 +287,51 @@ Result BufferDescriptor::MoveResourceToBufferOutput() {
         "is empty");
   }
 
+  // A probe announced the window it is going to read. The buffer then
+  // stays on the device untouched and only that window is made visible
+  // to the host; a 4KB probe into a 1GB SSBO costs a 4KB invalidate
+  // instead of a full copy out and a recreate on next use.
+  if (HasReadbackWindow()) {
+    Result r = buffer_->InvalidateMemoryRangeIfNeeded(GetReadbackOffset(),
+                                                      GetReadbackSize());
+    ClearReadbackWindow();
+    ClearPendingReadback();
+    return r;
+  }
+
+  // Without a window the buffer also stays on the device: the memory is
+  // host visible, so making the whole contents readable is a single
+  // invalidate, and a later ranged update writes only its own bytes
+  // instead of paying a full copy out and a recreate.
+  Result r = buffer_->InvalidateMemoryIfNeeded();
+  ClearPendingReadback();
+  return r;
+}
+
+Result BufferDescriptor::ExtractResourceToBufferOutput() {
+  if (!buffer_) {
+    return Result(
+        "Vulkan: BufferDescriptor::ExtractResourceToBufferOutput() |buffer_| "
+        "is empty");
+  }
+
   void* resource_memory_ptr = buffer_->HostAccessibleMemoryPtr();
   if (!resource_memory_ptr) {
     return Result(
-        "Vulkan: BufferDescriptor::MoveResourceToBufferOutput() |buffer_| "
+        "Vulkan: BufferDescriptor::ExtractResourceToBufferOutput() |buffer_| "
         "has nullptr host accessible memory");
   }
 
+  // The data was written by the device; on a non coherent heap it must
+  // be invalidated before the host reads it.
+  Result r = buffer_->InvalidateMemoryIfNeeded();
+  if (!r.IsSuccess())
+    return r;
+
   auto& buffer_output = GetBufferOutput();
   if (!buffer_output.empty()) {
     return Result(
-        "Vulkan: BufferDescriptor::MoveResourceToBufferOutput() "
+        "Vulkan: BufferDescriptor::ExtractResourceToBufferOutput() "
         "|buffer_output_| is not empty");
   }
 
@@ -150,6 +341,7 @@ Result BufferDescriptor::MoveResourceToBufferOutput() {
 
   buffer_->Shutdown();
   buffer_ = nullptr;
+  ClearPendingReadback();
   return {};
 }
 
@@ -174,11 +366,38 @@ ResourceInfo BufferDescriptor::GetResourceInfo() {
   ResourceInfo info = ResourceInfo();
   info.type = ResourceInfoType::kBuffer;
   if (buffer_) {
-    assert(buffer_input_queue.empty() && buffer_output.empty());
-
-    info.size_in_bytes = buffer_->GetSizeInBytes();
-    info.cpu_memory = buffer_->HostAccessibleMemoryPtr();
-    return info;
+    assert(buffer_output.empty());
+
+    // Updates queued since the last draw or dispatch merge straight
+    // into the live mapped contents, writing and flushing only their
+    // own ranges, so a probe sees them exactly like the device will.
+    bool fits = true;
+    for (const auto& input : buffer_input_queue) {
+      if (static_cast<size_t>(input.offset) + input.size_in_bytes >
+          buffer_->GetSizeInBytes()) {
+        fits = false;
+        break;
+      }
+    }
+    // The bytes behind an imported host pointer are the data file
+    // mapping's and may be read only; merging updates means recreating
+    // the buffer, not writing in place.
+    if (!buffer_input_queue.empty() && buffer_->IsImportedHostPointer())
+      fits = false;
+    if (fits) {
+      for (const auto& input : buffer_input_queue)
+        buffer_->UpdateMemoryWithInputStreamed(input);
+      buffer_input_queue.clear();
+
+      info.size_in_bytes = buffer_->GetSizeInBytes();
+      info.cpu_memory = buffer_->HostAccessibleMemoryPtr();
+      return info;
+    }
+
+    // An update outgrew the buffer; pull the contents to host and merge
+    // over them below.
+    if (!ExtractResourceToBufferOutput().IsSuccess())
+      return info;
   }
 
   if (buffer_input_queue.empty()) {
@@ -189,7 +408,7 @@ ResourceInfo BufferDescriptor::GetResourceInfo() {
 
   // Squash elements of |buffer_input_queue_| into |buffer_output_|.
   size_t size_in_bytes = GetBufferSizeInBytesForQueue(buffer_input_queue);
-  std::vector<uint8_t> new_buffer_output = buffer_output;
+  HostShadowBuffer new_buffer_output = buffer_output;
   if (size_in_bytes > new_buffer_output.size())
     new_buffer_output.resize(size_in_bytes);
 
@@ -45,6 +45,8 @@ class BufferDescriptor : public Descriptor {
   Result CreateResourceIfNeeded(
       const VkPhysicalDeviceMemoryProperties& properties) override;
   Result RecordCopyDataToResourceIfNeeded(VkCommandBuffer command) override;
+  Result RecordDeferredDeviceWrites(VkCommandBuffer command,
+                                    bool* recorded) override;
   Result RecordCopyDataToHost(VkCommandBuffer command) override;
   Result MoveResourceToBufferOutput() override;
   Result UpdateDescriptorSetIfNeeded(VkDescriptorSet descriptor_set) override;
@@ -52,6 +54,12 @@ class BufferDescriptor : public Descriptor {
   void Shutdown() override;
 
  private:
+  // Copy the full contents of |buffer_| to |buffer_output_| and destroy
+  // it. Only needed when an update outgrows the buffer and the new
+  // contents must be merged over the complete old ones; in-place
+  // updates keep the buffer alive instead.
+  Result ExtractResourceToBufferOutput();
+
   VkBufferUsageFlagBits GetVkBufferUsage() const {
     return GetType() == DescriptorType::kStorageBuffer
                ? VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
@@ -64,8 +72,23 @@ class BufferDescriptor : public Descriptor {
                : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
   }
 
+  // An initializer RecordCopyDataToResourceIfNeeded() turned into a
+  // device side write instead of materializing it on the host: either a
+  // constant fill or a copy from the device's content cache. Recorded by
+  // RecordDeferredDeviceWrites(); the cache lookup also happens there,
+  // since the parallel copy phase must not touch shared device state.
+  struct PendingDeviceWrite {
+    bool is_fill = false;
+    // Fill word when |is_fill|; ignored otherwise.
+    uint32_t word = 0;
+    // The original input, kept so a failed cache lookup can fall back to
+    // the streamed host upload.
+    BufferInput input;
+  };
+
   std::unique_ptr<Buffer> buffer_;
   std::vector<std::unique_ptr<Buffer>> not_destroyed_buffers_;
+  std::vector<PendingDeviceWrite> pending_device_writes_;
 };
 
 }  // namespace vulkan
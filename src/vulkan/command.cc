@@ -17,11 +17,19 @@
 #include <memory>
 
 #include "src/make_unique.h"
+#include "src/profiler.h"
 #include "src/vulkan/device.h"
 
 namespace amber {
 
 namespace vulkan {
+namespace {
+
+// Number of slots in the command buffer ring. Two slots are enough to
+// record the commands of one submission while the previous one executes.
+const size_t kCommandBufferRingSize = 2;
+
+}  // namespace
 
 CommandPool::CommandPool(Device* device) : device_(device) {}
 
@@ -33,8 +41,10 @@ Result CommandPool::Initialize(uint32_t queue_family_index) {
   pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
   pool_info.queueFamilyIndex = queue_family_index;
 
-  if (device_->GetPtrs()->vkCreateCommandPool(device_->GetDevice(), &pool_info,
-                                              nullptr, &pool_) != VK_SUCCESS) {
+  if (device_->GetPtrs()->vkCreateCommandPool(device_->GetDevice(),
+                                              &pool_info,
+                                              device_->GetHostAllocator(),
+                                              &pool_) != VK_SUCCESS) {
     return Result("Vulkan::Calling vkCreateCommandPool Fail");
   }
 
@@ -43,8 +53,9 @@ Result CommandPool::Initialize(uint32_t queue_family_index) {
 
 void CommandPool::Shutdown() {
   if (pool_ != VK_NULL_HANDLE) {
-    device_->GetPtrs()->vkDestroyCommandPool(device_->GetDevice(), pool_,
-                                             nullptr);
+    device_->GetPtrs()->vkDestroyCommandPool(device_->GetDevice(),
+                                             pool_,
+                                             device_->GetHostAllocator());
   }
 }
 
@@ -54,6 +65,18 @@ CommandBuffer::CommandBuffer(Device* device, VkCommandPool pool, VkQueue queue)
 CommandBuffer::~CommandBuffer() = default;
 
 Result CommandBuffer::Initialize() {
+  slots_.resize(kCommandBufferRingSize);
+
+  for (auto& slot : slots_) {
+    Result r = AllocateSlot(&slot);
+    if (!r.IsSuccess())
+      return r;
+  }
+
+  return {};
+}
+
+Result CommandBuffer::AllocateSlot(Slot* slot) {
   VkCommandBufferAllocateInfo command_info = VkCommandBufferAllocateInfo();
   command_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
   command_info.commandPool = pool_;
@@ -61,14 +84,17 @@ Result CommandBuffer::Initialize() {
   command_info.commandBufferCount = 1;
 
   if (device_->GetPtrs()->vkAllocateCommandBuffers(
-          device_->GetDevice(), &command_info, &command_) != VK_SUCCESS) {
+          device_->GetDevice(), &command_info, &slot->buffer) != VK_SUCCESS) {
     return Result("Vulkan::Calling vkAllocateCommandBuffers Fail");
   }
 
   VkFenceCreateInfo fence_info = VkFenceCreateInfo();
   fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-  if (device_->GetPtrs()->vkCreateFence(device_->GetDevice(), &fence_info,
-                                        nullptr, &fence_) != VK_SUCCESS) {
+
+  if (device_->GetPtrs()->vkCreateFence(device_->GetDevice(),
+                                        &fence_info,
+                                        device_->GetHostAllocator(),
+                                        &slot->fence) != VK_SUCCESS) {
     return Result("Vulkan::Calling vkCreateFence Fail");
   }
 
@@ -84,9 +110,11 @@ Result CommandBuffer::BeginIfNotInRecording() {
 
   VkCommandBufferBeginInfo command_begin_info = VkCommandBufferBeginInfo();
   command_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-  command_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-  if (device_->GetPtrs()->vkBeginCommandBuffer(command_, &command_begin_info) !=
-      VK_SUCCESS) {
+  // No ONE_TIME_SUBMIT: a recording preserved for repeated execution is
+  // submitted once per iteration; see BeginPreserving().
+  command_begin_info.flags = 0;
+  if (device_->GetPtrs()->vkBeginCommandBuffer(
+          slots_[current_slot_].buffer, &command_begin_info) != VK_SUCCESS) {
     return Result("Vulkan::Calling vkBeginCommandBuffer Fail");
   }
 
@@ -98,54 +126,490 @@ Result CommandBuffer::End() {
   if (state_ != CommandBufferState::kRecording)
     return Result("Vulkan::End CommandBuffer from Not Valid State");
 
-  if (device_->GetPtrs()->vkEndCommandBuffer(command_) != VK_SUCCESS)
+  if (device_->GetPtrs()->vkEndCommandBuffer(slots_[current_slot_].buffer) !=
+      VK_SUCCESS) {
     return Result("Vulkan::Calling vkEndCommandBuffer Fail");
+  }
 
   state_ = CommandBufferState::kExecutable;
   return {};
 }
 
-Result CommandBuffer::SubmitAndReset(uint32_t timeout_ms) {
+Result CommandBuffer::WaitSlot(Slot* slot, uint32_t timeout_ms) {
+  VkResult r = device_->GetPtrs()->vkWaitForFences(
+      device_->GetDevice(), 1, &slot->fence, VK_TRUE,
+      static_cast<uint64_t>(timeout_ms) * 1000ULL * 1000ULL /* nanosecond */);
+  if (r == VK_TIMEOUT)
+    return Result("Vulkan::Calling vkWaitForFences Timeout");
+  if (r != VK_SUCCESS)
+    return Result("Vulkan::Calling vkWaitForFences Fail");
+
+  slot->in_flight = false;
+  return {};
+}
+
+Result CommandBuffer::WaitAndResetSlot(Slot* slot, uint32_t timeout_ms) {
+  Result r = WaitSlot(slot, timeout_ms);
+  if (!r.IsSuccess())
+    return r;
+
+  if (device_->GetPtrs()->vkResetCommandBuffer(slot->buffer, 0) != VK_SUCCESS)
+    return Result("Vulkan::Calling vkResetCommandBuffer Fail");
+
+  return {};
+}
+
+Result CommandBuffer::Submit(uint32_t timeout_ms) {
   if (state_ != CommandBufferState::kExecutable)
     return Result("Vulkan::Submit CommandBuffer from Not Valid State");
 
-  if (device_->GetPtrs()->vkResetFences(device_->GetDevice(), 1, &fence_) !=
-      VK_SUCCESS) {
+  Slot& slot = slots_[current_slot_];
+  if (device_->GetPtrs()->vkResetFences(device_->GetDevice(), 1,
+                                        &slot.fence) != VK_SUCCESS) {
     return Result("Vulkan::Calling vkResetFences Fail");
   }
 
   VkSubmitInfo submit_info = VkSubmitInfo();
   submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
   submit_info.commandBufferCount = 1;
-  submit_info.pCommandBuffers = &command_;
-  if (device_->GetPtrs()->vkQueueSubmit(queue_, 1, &submit_info, fence_) !=
+  submit_info.pCommandBuffers = &slot.buffer;
+  if (device_->GetPtrs()->vkQueueSubmit(queue_, 1, &submit_info, slot.fence) !=
       VK_SUCCESS) {
     return Result("Vulkan::Calling vkQueueSubmit Fail");
   }
 
-  VkResult r = device_->GetPtrs()->vkWaitForFences(
-      device_->GetDevice(), 1, &fence_, VK_TRUE,
-      static_cast<uint64_t>(timeout_ms) * 1000ULL * 1000ULL /* nanosecond */);
-  if (r == VK_TIMEOUT)
-    return Result("Vulkan::Calling vkWaitForFences Timeout");
-  if (r != VK_SUCCESS)
-    return Result("Vulkan::Calling vkWaitForFences Fail");
+  slot.in_flight = true;
 
-  if (device_->GetPtrs()->vkResetCommandBuffer(command_, 0) != VK_SUCCESS)
-    return Result("Vulkan::Calling vkResetCommandBuffer Fail");
+  // The recorded commands must stay executable for resubmission: move
+  // the slot out of the ring and record into a fresh one from now on.
+  if (preserving_) {
+    preserved_.push_back(slot);
+    slots_[current_slot_] = Slot();
+    Result alloc_result = AllocateSlot(&slots_[current_slot_]);
+    if (!alloc_result.IsSuccess())
+      return alloc_result;
+  }
+
+  current_slot_ = (current_slot_ + 1) % slots_.size();
+
+  // Commands can be recorded into the next slot while the submitted ones
+  // execute. Only if the next slot is still in flight from an earlier
+  // submission must its completion be awaited here.
+  if (slots_[current_slot_].in_flight) {
+    Result r = WaitAndResetSlot(&slots_[current_slot_], timeout_ms);
+    if (!r.IsSuccess())
+      return r;
+  }
 
   state_ = CommandBufferState::kInitial;
   return {};
 }
 
+Result CommandBuffer::WaitForInFlightCommands(uint32_t timeout_ms) {
+  for (auto& slot : slots_) {
+    if (!slot.in_flight)
+      continue;
+
+    Result r = WaitAndResetSlot(&slot, timeout_ms);
+    if (!r.IsSuccess())
+      return r;
+  }
+
+  // Preserved recordings are awaited without a reset so they stay
+  // executable for the next resubmission.
+  for (auto& slot : preserved_) {
+    if (!slot.in_flight)
+      continue;
+
+    Result r = WaitSlot(&slot, timeout_ms);
+    if (!r.IsSuccess())
+      return r;
+  }
+
+  return {};
+}
+
+Result CommandBuffer::ResubmitPreserved(size_t index, uint32_t timeout_ms) {
+  if (index >= preserved_.size())
+    return Result("Vulkan::ResubmitPreserved No Preserved Submission");
+
+  Slot& slot = preserved_[index];
+  if (slot.in_flight) {
+    Result r = WaitSlot(&slot, timeout_ms);
+    if (!r.IsSuccess())
+      return r;
+  }
+
+  if (device_->GetPtrs()->vkResetFences(device_->GetDevice(), 1,
+                                        &slot.fence) != VK_SUCCESS) {
+    return Result("Vulkan::Calling vkResetFences Fail");
+  }
+
+  VkSubmitInfo submit_info = VkSubmitInfo();
+  submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submit_info.commandBufferCount = 1;
+  submit_info.pCommandBuffers = &slot.buffer;
+  if (device_->GetPtrs()->vkQueueSubmit(queue_, 1, &submit_info, slot.fence) !=
+      VK_SUCCESS) {
+    return Result("Vulkan::Calling vkQueueSubmit Fail");
+  }
+
+  slot.in_flight = true;
+  return {};
+}
+
+Result CommandBuffer::DropPreservedSubmissions(uint32_t timeout_ms) {
+  for (auto& slot : preserved_) {
+    if (slot.in_flight) {
+      Result r = WaitSlot(&slot, timeout_ms);
+      if (!r.IsSuccess())
+        return r;
+    }
+
+    if (slot.fence != VK_NULL_HANDLE) {
+      device_->GetPtrs()->vkDestroyFence(device_->GetDevice(),
+                                         slot.fence,
+                                         device_->GetHostAllocator());
+    }
+
+    if (slot.buffer != VK_NULL_HANDLE) {
+      device_->GetPtrs()->vkFreeCommandBuffers(device_->GetDevice(), pool_, 1,
+                                               &slot.buffer);
+    }
+  }
+
+  preserved_.clear();
+  return {};
+}
+
+Result CommandBuffer::SubmitAndReset(uint32_t timeout_ms) {
+  ScopedPhaseTimer timer("CommandBuffer::SubmitAndReset");
+
+  Result r = Submit(timeout_ms);
+  if (!r.IsSuccess())
+    return r;
+
+  return WaitForInFlightCommands(timeout_ms);
+}
+
 void CommandBuffer::Shutdown() {
-  if (fence_ != VK_NULL_HANDLE)
-    device_->GetPtrs()->vkDestroyFence(device_->GetDevice(), fence_, nullptr);
+  DropPreservedSubmissions(1000);
+
+  for (auto& slot : slots_) {
+    // Submissions are normally drained before Shutdown(); this is a last
+    // resort so an in-flight fence is never destroyed.
+    if (slot.in_flight)
+      WaitAndResetSlot(&slot, 1000);
+
+    if (slot.fence != VK_NULL_HANDLE) {
+      device_->GetPtrs()->vkDestroyFence(device_->GetDevice(),
+                                         slot.fence,
+                                         device_->GetHostAllocator());
+    }
+
+    if (slot.buffer != VK_NULL_HANDLE) {
+      device_->GetPtrs()->vkFreeCommandBuffers(device_->GetDevice(), pool_, 1,
+                                               &slot.buffer);
+    }
+  }
+}
+
+SecondaryCommandBuffers::SecondaryCommandBuffers(Device* device,
+                                                 uint32_t queue_family_index)
+    : device_(device), queue_family_index_(queue_family_index) {}
+
+SecondaryCommandBuffers::~SecondaryCommandBuffers() = default;
+
+Result SecondaryCommandBuffers::Allocate(size_t count,
+                                         std::vector<VkCommandBuffer>* buffers) {
+  buffers->clear();
+
+  while (pools_.size() < count) {
+    VkCommandPoolCreateInfo pool_info = VkCommandPoolCreateInfo();
+    pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool_info.queueFamilyIndex = queue_family_index_;
+
+    VkCommandPool pool = VK_NULL_HANDLE;
+    if (device_->GetPtrs()->vkCreateCommandPool(device_->GetDevice(),
+                                                &pool_info,
+                                                device_->GetHostAllocator(),
+                                                &pool) != VK_SUCCESS) {
+      return Result("Vulkan::Calling vkCreateCommandPool Fail");
+    }
+    pools_.push_back(pool);
+    buffers_.emplace_back();
+  }
+
+  VkCommandBufferAllocateInfo command_info = VkCommandBufferAllocateInfo();
+  command_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  command_info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+  command_info.commandBufferCount = 1;
+
+  for (size_t i = 0; i < count; ++i) {
+    command_info.commandPool = pools_[i];
+
+    VkCommandBuffer buffer = VK_NULL_HANDLE;
+    if (device_->GetPtrs()->vkAllocateCommandBuffers(
+            device_->GetDevice(), &command_info, &buffer) != VK_SUCCESS) {
+      return Result("Vulkan::Calling vkAllocateCommandBuffers Fail");
+    }
+    buffers_[i].push_back(buffer);
+    buffers->push_back(buffer);
+  }
+
+  return {};
+}
+
+Result SecondaryCommandBuffers::Reset() {
+  for (size_t i = 0; i < pools_.size(); ++i) {
+    if (!buffers_[i].empty()) {
+      device_->GetPtrs()->vkFreeCommandBuffers(
+          device_->GetDevice(), pools_[i],
+          static_cast<uint32_t>(buffers_[i].size()), buffers_[i].data());
+      buffers_[i].clear();
+    }
+
+    if (device_->GetPtrs()->vkResetCommandPool(device_->GetDevice(), pools_[i],
+                                               0) != VK_SUCCESS) {
+      return Result("Vulkan::Calling vkResetCommandPool Fail");
+    }
+  }
+
+  return {};
+}
+
+void SecondaryCommandBuffers::Shutdown() {
+  for (size_t i = 0; i < pools_.size(); ++i) {
+    if (!buffers_[i].empty()) {
+      device_->GetPtrs()->vkFreeCommandBuffers(
+          device_->GetDevice(), pools_[i],
+          static_cast<uint32_t>(buffers_[i].size()), buffers_[i].data());
+    }
+    device_->GetPtrs()->vkDestroyCommandPool(device_->GetDevice(),
+                                             pools_[i],
+                                             device_->GetHostAllocator());
+  }
+
+  pools_.clear();
+  buffers_.clear();
+}
+
+TimestampQueryPool::TimestampQueryPool(Device* device) : device_(device) {}
+
+TimestampQueryPool::~TimestampQueryPool() = default;
+
+Result TimestampQueryPool::Initialize(uint32_t max_pairs) {
+  max_pairs_ = max_pairs;
+
+  VkQueryPoolCreateInfo pool_info = VkQueryPoolCreateInfo();
+  pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+  pool_info.queryCount = max_pairs * 2;
+
+  if (device_->GetPtrs()->vkCreateQueryPool(device_->GetDevice(),
+                                            &pool_info,
+                                            device_->GetHostAllocator(),
+                                            &pool_) != VK_SUCCESS) {
+    return Result("Vulkan::Calling vkCreateQueryPool Fail");
+  }
+
+  return {};
+}
+
+void TimestampQueryPool::Shutdown() {
+  if (pool_ != VK_NULL_HANDLE) {
+    device_->GetPtrs()->vkDestroyQueryPool(device_->GetDevice(),
+                                           pool_,
+                                           device_->GetHostAllocator());
+    pool_ = VK_NULL_HANDLE;
+  }
+}
 
-  if (command_ != VK_NULL_HANDLE) {
-    device_->GetPtrs()->vkFreeCommandBuffers(device_->GetDevice(), pool_, 1,
-                                             &command_);
+Result TimestampQueryPool::RearmRecordedPairs(uint32_t pair_count) {
+  if (pair_open_) {
+    return Result(
+        "Vulkan::TimestampQueryPool::RearmRecordedPairs pair is open");
   }
+  if (pair_count > max_pairs_) {
+    return Result(
+        "Vulkan::TimestampQueryPool::RearmRecordedPairs exceeds pool size");
+  }
+
+  pair_count_ = pair_count;
+  return {};
+}
+
+Result TimestampQueryPool::RecordBegin(VkCommandBuffer command) {
+  if (pair_open_) {
+    return Result(
+        "Vulkan::TimestampQueryPool::RecordBegin pair is already open");
+  }
+  if (pair_count_ >= max_pairs_)
+    return {};
+
+  // Queries must be reset on the device before reuse; do it once for the
+  // whole pool when the first pair of a batch is recorded.
+  if (reset_needed_) {
+    device_->GetPtrs()->vkCmdResetQueryPool(command, pool_, 0, max_pairs_ * 2);
+    reset_needed_ = false;
+  }
+
+  device_->GetPtrs()->vkCmdWriteTimestamp(
+      command, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, pool_, pair_count_ * 2);
+  pair_open_ = true;
+  return {};
+}
+
+Result TimestampQueryPool::RecordEnd(VkCommandBuffer command) {
+  // A pair dropped by a full pool has nothing to close.
+  if (!pair_open_)
+    return {};
+
+  device_->GetPtrs()->vkCmdWriteTimestamp(
+      command, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, pool_,
+      pair_count_ * 2 + 1);
+  pair_open_ = false;
+  ++pair_count_;
+  return {};
+}
+
+Result TimestampQueryPool::FetchResults(std::vector<uint64_t>* durations_ns) {
+  // An open pair can span submissions; defer the fetch until it closed
+  // so its queries are not reset from under it.
+  if (pair_count_ == 0 || pair_open_)
+    return {};
+
+  std::vector<uint64_t> ticks(pair_count_ * 2);
+  if (device_->GetPtrs()->vkGetQueryPoolResults(
+          device_->GetDevice(), pool_, 0, pair_count_ * 2,
+          ticks.size() * sizeof(uint64_t), ticks.data(), sizeof(uint64_t),
+          VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT) != VK_SUCCESS) {
+    return Result("Vulkan::Calling vkGetQueryPoolResults Fail");
+  }
+
+  const double period = static_cast<double>(
+      device_->GetPhysicalDeviceProperties().limits.timestampPeriod);
+  for (uint32_t i = 0; i < pair_count_; ++i) {
+    uint64_t elapsed_ticks = ticks[i * 2 + 1] - ticks[i * 2];
+    durations_ns->push_back(
+        static_cast<uint64_t>(static_cast<double>(elapsed_ticks) * period));
+  }
+
+  pair_count_ = 0;
+  reset_needed_ = true;
+  return {};
+}
+
+PipelineStatsQueryPool::PipelineStatsQueryPool(Device* device)
+    : device_(device) {}
+
+PipelineStatsQueryPool::~PipelineStatsQueryPool() = default;
+
+Result PipelineStatsQueryPool::Initialize(uint32_t max_queries) {
+  max_queries_ = max_queries;
+
+  VkQueryPoolCreateInfo pool_info = VkQueryPoolCreateInfo();
+  pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  pool_info.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+  pool_info.queryCount = max_queries;
+  pool_info.pipelineStatistics =
+      VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+      VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+      VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+  if (device_->GetPtrs()->vkCreateQueryPool(device_->GetDevice(),
+                                            &pool_info,
+                                            device_->GetHostAllocator(),
+                                            &pool_) != VK_SUCCESS) {
+    return Result("Vulkan::Calling vkCreateQueryPool Fail");
+  }
+
+  return {};
+}
+
+void PipelineStatsQueryPool::Shutdown() {
+  if (pool_ != VK_NULL_HANDLE) {
+    device_->GetPtrs()->vkDestroyQueryPool(device_->GetDevice(),
+                                           pool_,
+                                           device_->GetHostAllocator());
+    pool_ = VK_NULL_HANDLE;
+  }
+}
+
+Result PipelineStatsQueryPool::RearmRecordedQueries(uint32_t query_count) {
+  if (query_open_) {
+    return Result(
+        "Vulkan::PipelineStatsQueryPool::RearmRecordedQueries query is open");
+  }
+  if (query_count > max_queries_) {
+    return Result(
+        "Vulkan::PipelineStatsQueryPool::RearmRecordedQueries exceeds pool "
+        "size");
+  }
+
+  query_count_ = query_count;
+  return {};
+}
+
+Result PipelineStatsQueryPool::RecordBegin(VkCommandBuffer command) {
+  if (query_open_) {
+    return Result(
+        "Vulkan::PipelineStatsQueryPool::RecordBegin query is already open");
+  }
+  if (query_count_ >= max_queries_)
+    return {};
+
+  // Queries must be reset on the device before reuse; do it once for the
+  // whole pool when the first query of a batch is recorded.
+  if (reset_needed_) {
+    device_->GetPtrs()->vkCmdResetQueryPool(command, pool_, 0, max_queries_);
+    reset_needed_ = false;
+  }
+
+  device_->GetPtrs()->vkCmdBeginQuery(command, pool_, query_count_, 0);
+  query_open_ = true;
+  return {};
+}
+
+Result PipelineStatsQueryPool::RecordEnd(VkCommandBuffer command) {
+  // A query dropped by a full pool has nothing to close.
+  if (!query_open_)
+    return {};
+
+  device_->GetPtrs()->vkCmdEndQuery(command, pool_, query_count_);
+  query_open_ = false;
+  ++query_count_;
+  return {};
+}
+
+Result PipelineStatsQueryPool::FetchResults(std::vector<Stats>* stats) {
+  // An open query can span submissions; defer the fetch until it closed
+  // so its slot is not reset from under it.
+  if (query_count_ == 0 || query_open_)
+    return {};
+
+  // Three counters per query, in the bit order of pipelineStatistics:
+  // vertex, fragment, compute shader invocations.
+  std::vector<uint64_t> counts(query_count_ * 3);
+  if (device_->GetPtrs()->vkGetQueryPoolResults(
+          device_->GetDevice(), pool_, 0, query_count_,
+          counts.size() * sizeof(uint64_t), counts.data(),
+          3 * sizeof(uint64_t),
+          VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT) != VK_SUCCESS) {
+    return Result("Vulkan::Calling vkGetQueryPoolResults Fail");
+  }
+
+  for (uint32_t i = 0; i < query_count_; ++i) {
+    Stats entry;
+    entry.vertex_invocations = counts[i * 3];
+    entry.fragment_invocations = counts[i * 3 + 1];
+    entry.compute_invocations = counts[i * 3 + 2];
+    stats->push_back(entry);
+  }
+
+  query_count_ = 0;
+  reset_needed_ = true;
+  return {};
 }
 
 }  // namespace vulkan
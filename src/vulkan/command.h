@@ -15,6 +15,8 @@
 #ifndef SRC_VULKAN_COMMAND_H_
 #define SRC_VULKAN_COMMAND_H_
 
+#include <vector>
+
 #include "amber/result.h"
 #include "amber/vulkan_header.h"
 
@@ -48,13 +50,19 @@ class CommandPool {
   VkCommandPool pool_ = VK_NULL_HANDLE;
 };
 
+// Ring of Vulkan command buffers with a fence per slot. Commands are
+// recorded into the current slot; submitting a slot does not have to wait
+// for it, so the CPU can record commands for the next slot while the GPU
+// executes the previous one.
 class CommandBuffer {
  public:
   CommandBuffer(Device* device, VkCommandPool pool, VkQueue queue);
   ~CommandBuffer();
 
   Result Initialize();
-  VkCommandBuffer GetCommandBuffer() const { return command_; }
+  VkCommandBuffer GetCommandBuffer() const {
+    return slots_[current_slot_].buffer;
+  }
   void Shutdown();
 
   // Do nothing and return if it is already ready to record. If it is in
@@ -62,16 +70,210 @@ class CommandBuffer {
   // Otherwise, report error.
   Result BeginIfNotInRecording();
 
+  // Return true if the current slot is in recording state i.e., commands
+  // might have been recorded since the last submission.
+  bool IsInRecordingState() const {
+    return state_ == CommandBufferState::kRecording;
+  }
+
+  // Return true if any slot still has a submission in flight.
+  bool HasInFlightCommands() const {
+    for (const auto& slot : slots_) {
+      if (slot.in_flight)
+        return true;
+    }
+    for (const auto& slot : preserved_) {
+      if (slot.in_flight)
+        return true;
+    }
+    return false;
+  }
+
   Result End();
+
+  // Submit the commands of the current slot without waiting for them and
+  // advance to the next slot. If the next slot still has a submission in
+  // flight, wait for it with |timeout_ms| before reusing it.
+  Result Submit(uint32_t timeout_ms);
+
+  // Wait for all submissions still in flight and make their slots ready
+  // to record again.
+  Result WaitForInFlightCommands(uint32_t timeout_ms);
+
+  // Submit the commands of the current slot and wait until all
+  // submissions in flight completed.
   Result SubmitAndReset(uint32_t timeout_ms);
 
+  // Keep the recording of every following Submit(): the submitted slot
+  // is moved to the preserved list and a freshly allocated slot takes
+  // its place in the ring, so the recorded commands stay executable and
+  // can be submitted again. Recordings are begun without ONE_TIME_SUBMIT
+  // for exactly this reason.
+  void BeginPreserving() { preserving_ = true; }
+  void EndPreserving() { preserving_ = false; }
+
+  // Number of submissions moved to the preserved list so far.
+  size_t GetPreservedSubmissionCount() const { return preserved_.size(); }
+
+  // Submit the preserved recording at |index| again without waiting for
+  // it; an earlier resubmission of the same recording still in flight is
+  // awaited first. WaitForInFlightCommands() covers the resubmission.
+  Result ResubmitPreserved(size_t index, uint32_t timeout_ms);
+
+  // Wait for preserved submissions still in flight and free their
+  // command buffers and fences.
+  Result DropPreservedSubmissions(uint32_t timeout_ms);
+
  private:
+  struct Slot {
+    VkCommandBuffer buffer = VK_NULL_HANDLE;
+    VkFence fence = VK_NULL_HANDLE;
+    bool in_flight = false;
+  };
+
+  // Allocate the command buffer and fence of |slot|.
+  Result AllocateSlot(Slot* slot);
+
+  // Wait for the fence of |slot| with |timeout_ms| without touching its
+  // command buffer.
+  Result WaitSlot(Slot* slot, uint32_t timeout_ms);
+
+  // Wait for the fence of |slot| with |timeout_ms| and reset its command
+  // buffer so it is ready to record again.
+  Result WaitAndResetSlot(Slot* slot, uint32_t timeout_ms);
+
   Device* device_ = nullptr;
   VkCommandPool pool_ = VK_NULL_HANDLE;
   VkQueue queue_ = VK_NULL_HANDLE;
-  VkCommandBuffer command_ = VK_NULL_HANDLE;
-  VkFence fence_ = VK_NULL_HANDLE;
+  std::vector<Slot> slots_;
+  size_t current_slot_ = 0;
   CommandBufferState state_ = CommandBufferState::kInitial;
+  // Submissions kept executable for resubmission; see BeginPreserving().
+  std::vector<Slot> preserved_;
+  bool preserving_ = false;
+};
+
+// Per thread pools of secondary command buffers for recording long
+// command runs in parallel. Concurrent recording is only legal when
+// every thread allocates from its own pool, so the buffer at index |i|
+// of an allocation comes from pool |i| and must only be recorded by the
+// worker owning that index. Buffers handed out stay valid until Reset()
+// or Shutdown(), which must not be called while a submission still
+// references them.
+class SecondaryCommandBuffers {
+ public:
+  SecondaryCommandBuffers(Device* device, uint32_t queue_family_index);
+  ~SecondaryCommandBuffers();
+
+  // Hand out |count| secondary command buffers, one per recording
+  // worker, creating the per worker pools on first use.
+  Result Allocate(size_t count, std::vector<VkCommandBuffer>* buffers);
+
+  // Free every buffer handed out and recycle the pools.
+  Result Reset();
+
+  void Shutdown();
+
+ private:
+  Device* device_ = nullptr;
+  uint32_t queue_family_index_ = 0;
+  std::vector<VkCommandPool> pools_;
+  // Buffers allocated from the pool at the same index.
+  std::vector<std::vector<VkCommandBuffer>> buffers_;
+};
+
+// Pool of GPU timestamp query pairs. A pair brackets the device commands
+// recorded between RecordBegin() and RecordEnd(); once the submission
+// holding the pair completed, FetchResults() turns every pair into a
+// duration in nanoseconds using the device's timestamp period.
+class TimestampQueryPool {
+ public:
+  explicit TimestampQueryPool(Device* device);
+  ~TimestampQueryPool();
+
+  Result Initialize(uint32_t max_pairs);
+  void Shutdown();
+
+  // Record the opening timestamp of the next pair into |command|. The
+  // first pair recorded since the last fetch also resets the queries.
+  // When the pool is full the pair is silently dropped.
+  Result RecordBegin(VkCommandBuffer command);
+  // Record the closing timestamp of the pair opened by RecordBegin().
+  // A no-op when the opening pair was dropped by a full pool.
+  Result RecordEnd(VkCommandBuffer command);
+
+  // Number of pairs recorded and closed since the last FetchResults().
+  uint32_t GetRecordedPairCount() const { return pair_count_; }
+
+  // Tell the pool |pair_count| of its recorded pairs were written again
+  // because a preserved command buffer holding the timestamp writes was
+  // resubmitted. The pool reset recorded with the first pair ran again
+  // as part of the resubmission, so FetchResults() resolves the pairs
+  // exactly as it did for the original submission.
+  Result RearmRecordedPairs(uint32_t pair_count);
+
+  // Read the recorded pairs back and append one duration per pair to
+  // |durations_ns|. Must be called after the submissions holding the
+  // timestamps completed. Resets the pool for the next batch.
+  Result FetchResults(std::vector<uint64_t>* durations_ns);
+
+ private:
+  Device* device_ = nullptr;
+  VkQueryPool pool_ = VK_NULL_HANDLE;
+  uint32_t max_pairs_ = 0;
+  uint32_t pair_count_ = 0;
+  bool pair_open_ = false;
+  bool reset_needed_ = true;
+};
+
+// Pool of pipeline statistics queries. A query brackets the device
+// commands recorded between RecordBegin() and RecordEnd() and counts the
+// vertex, fragment and compute shader invocations they caused. Requires
+// the pipelineStatisticsQuery device feature; the pool is only created
+// when the feature was enabled.
+class PipelineStatsQueryPool {
+ public:
+  // Invocation counts of one recorded query.
+  struct Stats {
+    uint64_t vertex_invocations = 0;
+    uint64_t fragment_invocations = 0;
+    uint64_t compute_invocations = 0;
+  };
+
+  explicit PipelineStatsQueryPool(Device* device);
+  ~PipelineStatsQueryPool();
+
+  Result Initialize(uint32_t max_queries);
+  void Shutdown();
+
+  // Begin the next query in |command|. The first query recorded since
+  // the last fetch also resets the queries. When the pool is full the
+  // query is silently dropped.
+  Result RecordBegin(VkCommandBuffer command);
+  // End the query opened by RecordBegin(). A no-op when the opening
+  // query was dropped by a full pool.
+  Result RecordEnd(VkCommandBuffer command);
+
+  // Number of queries recorded and closed since the last FetchResults().
+  uint32_t GetRecordedQueryCount() const { return query_count_; }
+
+  // Tell the pool |query_count| of its recorded queries ran again
+  // because a preserved command buffer holding them was resubmitted,
+  // mirroring TimestampQueryPool::RearmRecordedPairs().
+  Result RearmRecordedQueries(uint32_t query_count);
+
+  // Read the recorded queries back and append one Stats per query to
+  // |stats|. Must be called after the submissions holding the queries
+  // completed. Resets the pool for the next batch.
+  Result FetchResults(std::vector<Stats>* stats);
+
+ private:
+  Device* device_ = nullptr;
+  VkQueryPool pool_ = VK_NULL_HANDLE;
+  uint32_t max_queries_ = 0;
+  uint32_t query_count_ = 0;
+  bool query_open_ = false;
+  bool reset_needed_ = true;
 };
 
 }  // namespace vulkan
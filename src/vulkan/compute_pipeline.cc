@@ -14,6 +14,7 @@
 
 #include "src/vulkan/compute_pipeline.h"
 
+#include "src/make_unique.h"
 #include "src/vulkan/device.h"
 
 namespace amber {
@@ -60,60 +61,198 @@ Result ComputePipeline::CreateVkComputePipeline() {
   pipeline_info.stage = shader_stage_info[0];
   pipeline_info.layout = pipeline_layout_;
 
+  // Dispatching with a nonzero base group, as the split path does, is
+  // only valid against a pipeline created with the dispatch base flag.
+  if (device_->SupportsDispatchBase())
+    pipeline_info.flags |= VK_PIPELINE_CREATE_DISPATCH_BASE_KHR;
+
   if (device_->GetPtrs()->vkCreateComputePipelines(
-          device_->GetDevice(), VK_NULL_HANDLE, 1, &pipeline_info, nullptr,
-          &pipeline_) != VK_SUCCESS) {
+      device_->GetDevice(),
+      device_->GetPipelineCache(),
+      1,
+      &pipeline_info,
+      device_->GetHostAllocator(),
+      &pipeline_) != VK_SUCCESS) {
     return Result("Vulkan::Calling vkCreateComputePipelines Fail");
   }
 
   return {};
 }
 
-Result ComputePipeline::Compute(uint32_t x, uint32_t y, uint32_t z) {
-  Result r = command_->BeginIfNotInRecording();
-  if (!r.IsSuccess())
-    return r;
+void ComputePipeline::SwitchToVariantForCurrentEntryPoint() {
+  const std::string entry = GetEntryPointName(VK_SHADER_STAGE_COMPUTE_BIT);
+  if (pipeline_ != VK_NULL_HANDLE && entry == pipeline_entry_point_)
+    return;
 
-  r = SendDescriptorDataToDeviceIfNeeded();
-  if (!r.IsSuccess())
-    return r;
+  // Park the current variant instead of destroying it: dispatches
+  // already recorded may still bind it, and its entry point coming back
+  // later reuses it without another driver compile.
+  if (pipeline_ != VK_NULL_HANDLE) {
+    pipeline_variants_[pipeline_entry_point_] = pipeline_;
+    pipeline_ = VK_NULL_HANDLE;
+  }
+
+  auto it = pipeline_variants_.find(entry);
+  if (it != pipeline_variants_.end()) {
+    pipeline_ = it->second;
+    pipeline_variants_.erase(it);
+  }
+  pipeline_entry_point_ = entry;
+}
+
+Result ComputePipeline::Prewarm() {
+  SwitchToVariantForCurrentEntryPoint();
+  if (pipeline_ != VK_NULL_HANDLE)
+    return {};
+
+  return CreateVkComputePipeline();
+}
 
-  r = command_->End();
+Result ComputePipeline::Compute(uint32_t x,
+                                uint32_t y,
+                                uint32_t z,
+                                bool is_data_parallel) {
+  Result r = command_->BeginIfNotInRecording();
   if (!r.IsSuccess())
     return r;
 
-  r = command_->SubmitAndReset(GetFenceTimeout());
+  r = SendDescriptorDataToDeviceIfNeeded();
   if (!r.IsSuccess())
     return r;
 
+  SwitchToVariantForCurrentEntryPoint();
   if (pipeline_ == VK_NULL_HANDLE) {
     r = CreateVkComputePipeline();
     if (!r.IsSuccess())
       return r;
   }
 
-  // Note that a command updating a descriptor set and a command using
-  // it must be submitted separately, because using a descriptor set
-  // while updating it is not safe.
+  // UpdateDescriptorSetsIfNeeded() drains the queue before updating a
+  // descriptor set. Otherwise everything keeps batching up in the command
+  // buffer and is submitted by the next ProcessCommands().
   r = UpdateDescriptorSetsIfNeeded();
   if (!r.IsSuccess())
     return r;
 
+  // A dispatch the script marked data-parallel is split along x into one
+  // slice per queue when the device can offset workgroup ids. Grids
+  // smaller than two slices run whole.
+  if (is_data_parallel && device_->SupportsDispatchBase() &&
+      device_->GetQueueCount() > 1 && x >= 2) {
+    return ComputeSplitAcrossQueues(x, y, z);
+  }
+
   r = command_->BeginIfNotInRecording();
   if (!r.IsSuccess())
     return r;
 
-  BindVkDescriptorSets();
-  BindVkPipeline();
+  BindVkDescriptorSets(command_->GetCommandBuffer());
+  BindVkPipeline(command_->GetCommandBuffer());
 
-  r = RecordPushConstant();
+  r = RecordPushConstant(command_->GetCommandBuffer());
   if (!r.IsSuccess())
     return r;
 
+  // Dispatches batched back to back into the command buffer are only
+  // ordered against each other when an earlier one may have written a
+  // descriptor this one touches; independent dispatches get no barrier
+  // and overlap on the GPU.
+  RecordDispatchDependencyBarrierIfNeeded();
+
   device_->GetPtrs()->vkCmdDispatch(command_->GetCommandBuffer(), x, y, z);
+  MarkDispatchDescriptorWrites();
 
   return ReadbackDescriptorsToHostDataQueue();
 }
 
+Result ComputePipeline::ComputeSplitAcrossQueues(uint32_t x,
+                                                 uint32_t y,
+                                                 uint32_t z) {
+  // The split submits outside the pipeline's own command buffer, which a
+  // preserved recording cannot cover.
+  DisableReplay();
+
+  // Submit everything recorded so far - descriptor uploads, earlier
+  // dispatches - and wait for it, so every queue sees current buffer
+  // contents. All queues are in one family, so the buffers need no
+  // ownership transfer.
+  Result r = ProcessCommands();
+  if (!r.IsSuccess())
+    return r;
+
+  const uint32_t queue_count = device_->GetQueueCount();
+  const uint32_t slice_count = x < queue_count ? x : queue_count;
+
+  if (slice_commands_.empty()) {
+    for (uint32_t i = 0; i < queue_count; ++i) {
+      slice_commands_.push_back(MakeUnique<CommandBuffer>(
+          device_, command_pool_, device_->GetQueue(i)));
+      r = slice_commands_.back()->Initialize();
+      if (!r.IsSuccess())
+        return r;
+    }
+  }
+
+  // Round the slice width up so the last slice takes the remainder.
+  const uint32_t slice_width = (x + slice_count - 1) / slice_count;
+  for (uint32_t i = 0; i < slice_count; ++i) {
+    const uint32_t base = i * slice_width;
+    const uint32_t width = x - base < slice_width ? x - base : slice_width;
+    if (width == 0)
+      break;
+
+    CommandBuffer* slice = slice_commands_[i].get();
+    r = slice->BeginIfNotInRecording();
+    if (!r.IsSuccess())
+      return r;
+
+    BindVkDescriptorSets(slice->GetCommandBuffer());
+    BindVkPipeline(slice->GetCommandBuffer());
+    r = RecordPushConstant(slice->GetCommandBuffer());
+    if (!r.IsSuccess())
+      return r;
+
+    device_->GetDispatchBase()(slice->GetCommandBuffer(), base, 0, 0, width, y,
+                               z);
+
+    r = slice->End();
+    if (!r.IsSuccess())
+      return r;
+    r = slice->Submit(GetFenceTimeout());
+    if (!r.IsSuccess())
+      return r;
+  }
+
+  // The slices write disjoint parts of the output - the data-parallel
+  // mark is the script's promise of that - so they only need to be
+  // complete, not ordered, before later work or host reads; the fence
+  // waits provide both.
+  for (uint32_t i = 0; i < slice_count; ++i) {
+    r = slice_commands_[i]->WaitForInFlightCommands(GetFenceTimeout());
+    if (!r.IsSuccess())
+      return r;
+  }
+
+  MarkDispatchDescriptorWrites();
+  return ReadbackDescriptorsToHostDataQueue();
+}
+
+void ComputePipeline::Shutdown() {
+  Pipeline::Shutdown();
+
+  for (auto& slice : slice_commands_) {
+    if (slice)
+      slice->Shutdown();
+  }
+  slice_commands_.clear();
+
+  for (auto& variant : pipeline_variants_) {
+    device_->GetPtrs()->vkDestroyPipeline(device_->GetDevice(),
+                                          variant.second,
+                                          device_->GetHostAllocator());
+  }
+  pipeline_variants_.clear();
+}
+
 }  // namespace vulkan
 }  // namespace amber
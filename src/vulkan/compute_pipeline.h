@@ -15,6 +15,9 @@
 #ifndef SRC_VULKAN_COMPUTE_PIPELINE_H_
 #define SRC_VULKAN_COMPUTE_PIPELINE_H_
 
+#include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "amber/result.h"
@@ -36,10 +39,49 @@ class ComputePipeline : public Pipeline {
 
   Result Initialize(VkCommandPool pool, VkQueue queue);
 
-  Result Compute(uint32_t x, uint32_t y, uint32_t z);
+  // Dispatches an x by y by z workgroup grid. When |is_data_parallel|
+  // the script promised the workgroups are independent, and a device
+  // exposing vkCmdDispatchBase and more than one queue runs the grid as
+  // offset slices submitted to the queues in parallel; otherwise the
+  // grid runs as one dispatch.
+  Result Compute(uint32_t x, uint32_t y, uint32_t z, bool is_data_parallel);
+
+  // Creates the VkPipeline ahead of the first dispatch, so driver
+  // compilation happens before - or on a different thread than - the
+  // run. No GPU work is submitted.
+  Result Prewarm();
+
+  // Pipeline
+  void Shutdown() override;
 
  private:
   Result CreateVkComputePipeline();
+
+  // Split the grid along its x axis into one slice per device queue and
+  // run the slices concurrently; see Compute(). Everything recorded so
+  // far is submitted and awaited first so the slices see current buffer
+  // contents, and the slice submissions are awaited before returning so
+  // later commands see theirs.
+  Result ComputeSplitAcrossQueues(uint32_t x, uint32_t y, uint32_t z);
+
+  // Command buffers for dispatch slices, one per device queue, created
+  // on the first split and reused by later ones.
+  std::vector<std::unique_ptr<CommandBuffer>> slice_commands_;
+
+  // Make |pipeline_| the variant built for the current entry point:
+  // park the variant of another entry point in |pipeline_variants_| and
+  // take the current one out of it, leaving |pipeline_| null when no
+  // variant was built for it yet.
+  void SwitchToVariantForCurrentEntryPoint();
+
+  // Variants built for entry points used earlier, keyed by entry point
+  // name; the shader module of a compute pipeline is fixed, so the name
+  // alone identifies a variant. Scripts cycling through kernels get
+  // each variant compiled once instead of once per switch. The variant
+  // currently in |pipeline_| is not in the map; |pipeline_entry_point_|
+  // names it.
+  std::unordered_map<std::string, VkPipeline> pipeline_variants_;
+  std::string pipeline_entry_point_;
 };
 
 }  // namespace vulkan
@@ -62,6 +62,10 @@ Descriptor::Descriptor(DescriptorType type,
 
 Descriptor::~Descriptor() = default;
 
+Result Descriptor::RecordDeferredDeviceWrites(VkCommandBuffer, bool*) {
+  return {};
+}
+
 VkWriteDescriptorSet Descriptor::GetWriteDescriptorSet(
     VkDescriptorSet descriptor_set,
     VkDescriptorType descriptor_type) const {
@@ -151,8 +155,26 @@ void Descriptor::UpdateVkDescriptorSet(const VkWriteDescriptorSet& write) {
 void Descriptor::AddToBufferInputQueue(DataType type,
                                        uint32_t offset,
                                        size_t size_in_bytes,
-                                       const std::vector<Value>& values) {
-  buffer_input_queue_.push_back({offset, size_in_bytes, type, values});
+                                       const std::vector<Value>* values) {
+  buffer_input_queue_.push_back(
+      {offset, size_in_bytes, type, values, nullptr});
+}
+
+void Descriptor::AddRawToBufferInputQueue(uint32_t offset,
+                                          size_t size_in_bytes,
+                                          const uint8_t* raw_data) {
+  buffer_input_queue_.push_back(
+      {offset, size_in_bytes, DataType::kUint8, nullptr, raw_data});
+}
+
+void Descriptor::AddGeneratedToBufferInputQueue(DataType type,
+                                                uint32_t offset,
+                                                size_t size_in_bytes,
+                                                BufferDataGenerator generator,
+                                                const Value& start,
+                                                const Value& step) {
+  buffer_input_queue_.push_back(
+      {offset, size_in_bytes, type, nullptr, nullptr, generator, start, step});
 }
 
 }  // namespace vulkan
@@ -22,6 +22,7 @@
 #include "amber/vulkan_header.h"
 #include "src/datum_type.h"
 #include "src/engine.h"
+#include "src/huge_alloc.h"
 #include "src/vulkan/resource.h"
 
 namespace amber {
@@ -45,6 +46,11 @@ class Device;
 
 VkDescriptorType ToVkDescriptorType(DescriptorType type);
 
+// Host-side shadow of a device buffer. These reach multi-gigabyte
+// sizes in stress runs, so the storage comes from the huge-page-
+// friendly allocator to cut TLB misses in the fill and verify loops.
+typedef std::vector<uint8_t, HugePageAllocator<uint8_t>> HostShadowBuffer;
+
 class Descriptor {
  public:
   Descriptor(DescriptorType type,
@@ -86,14 +92,54 @@ class Descriptor {
 
   bool HasDataNotSent() { return !buffer_input_queue_.empty(); }
 
+  // Return true if a copy of the resource contents to host accessible
+  // memory was recorded but the data was not yet moved to |buffer_output_|
+  // by MoveResourceToBufferOutput().
+  bool HasPendingReadback() const { return has_pending_readback_; }
+
+  // Restricts the next readback of this descriptor to |size| bytes at
+  // |offset|. With a window set the resource stays on the device and
+  // only the probed bytes are made visible to the host, instead of the
+  // whole contents being copied out and the resource recreated. The
+  // window is one-shot and cleared by the readback that uses it.
+  void SetReadbackWindow(uint64_t offset, uint64_t size) {
+    readback_offset_ = offset;
+    readback_size_ = size;
+    has_readback_window_ = true;
+  }
+
+  bool IsDescriptorSetUpdateNeeded() {
+    return is_descriptor_set_update_needed_;
+  }
+
   // Add the information to |buffer_input_queue_| that "we will fill
   // resource of this descriptor with |values| at |offset| of the
   // resource". |type| indicates the primitive type of |values| and
-  // |size_in_bytes| denotes the total size in bytes of |values|.
+  // |size_in_bytes| denotes the total size in bytes of |values|. The
+  // values are not copied; |values| must outlive the queue entry.
   void AddToBufferInputQueue(DataType type,
                              uint32_t offset,
                              size_t size_in_bytes,
-                             const std::vector<Value>& values);
+                             const std::vector<Value>* values);
+
+  // Same as AddToBufferInputQueue() but with |size_in_bytes| bytes of
+  // |raw_data| already in buffer layout; they are copied to the
+  // resource as-is. The bytes are not copied into the queue; |raw_data|
+  // must outlive the queue entry.
+  void AddRawToBufferInputQueue(uint32_t offset,
+                                size_t size_in_bytes,
+                                const uint8_t* raw_data);
+
+  // Same as AddToBufferInputQueue() but with procedural contents:
+  // |size_in_bytes| bytes of |type| elements produced by |generator|
+  // from |start| and |step|, evaluated straight into the resource at
+  // upload time.
+  void AddGeneratedToBufferInputQueue(DataType type,
+                                      uint32_t offset,
+                                      size_t size_in_bytes,
+                                      BufferDataGenerator generator,
+                                      const Value& start,
+                                      const Value& step);
 
   // Call vkUpdateDescriptorSets() to update the backing resource
   // for this descriptor only when the backing resource was newly
@@ -116,6 +162,14 @@ class Descriptor {
   // done later.
   virtual Result RecordCopyDataToResourceIfNeeded(VkCommandBuffer command) = 0;
 
+  // Record device side writes RecordCopyDataToResourceIfNeeded()
+  // deferred. That method may run on several threads at once and so
+  // cannot record into the shared command buffer; this one is called
+  // serially afterwards. |recorded| is set to true when a command was
+  // recorded. The base implementation has nothing to record.
+  virtual Result RecordDeferredDeviceWrites(VkCommandBuffer command,
+                                            bool* recorded);
+
   // Only record the copy command for copying the resource data to
   // the host accessible memory. The actual submission of the command
   // must be done later.
@@ -153,7 +207,7 @@ class Descriptor {
   std::vector<BufferInput>& GetBufferInputQueue() {
     return buffer_input_queue_;
   }
-  std::vector<uint8_t>& GetBufferOutput() { return buffer_output_; }
+  HostShadowBuffer& GetBufferOutput() { return buffer_output_; }
 
   void ClearBufferInputQueue() { buffer_input_queue_.clear(); }
   void ClearBufferOutput() { buffer_output_.clear(); }
@@ -161,9 +215,14 @@ class Descriptor {
   void SetUpdateDescriptorSetNeeded() {
     is_descriptor_set_update_needed_ = true;
   }
-  bool IsDescriptorSetUpdateNeeded() {
-    return is_descriptor_set_update_needed_;
-  }
+
+  void SetPendingReadback() { has_pending_readback_ = true; }
+  void ClearPendingReadback() { has_pending_readback_ = false; }
+
+  bool HasReadbackWindow() const { return has_readback_window_; }
+  uint64_t GetReadbackOffset() const { return readback_offset_; }
+  uint64_t GetReadbackSize() const { return readback_size_; }
+  void ClearReadbackWindow() { has_readback_window_ = false; }
 
   uint32_t descriptor_set_ = 0;
   uint32_t binding_ = 0;
@@ -185,9 +244,14 @@ class Descriptor {
   std::vector<BufferInput> buffer_input_queue_;
 
   // Vector to keep data from GPU memory i.e., read back from VkBuffer.
-  std::vector<uint8_t> buffer_output_;
+  HostShadowBuffer buffer_output_;
 
   bool is_descriptor_set_update_needed_ = false;
+  bool has_pending_readback_ = false;
+
+  uint64_t readback_offset_ = 0;
+  uint64_t readback_size_ = 0;
+  bool has_readback_window_ = false;
 };
 
 }  // namespace vulkan
@@ -0,0 +1,153 @@
+// Copyright 2018 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/vulkan/descriptor_pool_cache.h"
+
+#include <utility>
+
+#include "src/vulkan/device.h"
+
+namespace amber {
+namespace vulkan {
+namespace {
+
+std::string BindingsSignature(
+    const std::vector<VkDescriptorSetLayoutBinding>& bindings) {
+  std::string signature;
+  for (const auto& binding : bindings) {
+    signature += std::to_string(binding.binding) + ":" +
+                 std::to_string(binding.descriptorType) + ":" +
+                 std::to_string(binding.descriptorCount) + ":" +
+                 std::to_string(binding.stageFlags) + ";";
+  }
+  return signature;
+}
+
+std::string PoolSizesSignature(
+    const std::vector<VkDescriptorPoolSize>& pool_sizes) {
+  std::string signature;
+  for (const auto& size : pool_sizes) {
+    signature += std::to_string(size.type) + ":" +
+                 std::to_string(size.descriptorCount) + ";";
+  }
+  return signature;
+}
+
+}  // namespace
+
+DescriptorPoolCache::DescriptorPoolCache(Device* device) : device_(device) {}
+
+DescriptorPoolCache::~DescriptorPoolCache() = default;
+
+Result DescriptorPoolCache::GetDescriptorSetLayout(
+    const std::vector<VkDescriptorSetLayoutBinding>& bindings,
+    VkDescriptorSetLayout* layout) {
+  const std::string signature = BindingsSignature(bindings);
+
+  auto it = layouts_.find(signature);
+  if (it != layouts_.end()) {
+    *layout = it->second;
+    return {};
+  }
+
+  VkDescriptorSetLayoutCreateInfo desc_info = VkDescriptorSetLayoutCreateInfo();
+  desc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  desc_info.bindingCount = static_cast<uint32_t>(bindings.size());
+  desc_info.pBindings = bindings.data();
+
+  VkDescriptorSetLayout new_layout = VK_NULL_HANDLE;
+  if (device_->GetPtrs()->vkCreateDescriptorSetLayout(
+      device_->GetDevice(),
+      &desc_info,
+      device_->GetHostAllocator(),
+      &new_layout) !=
+      VK_SUCCESS) {
+    return Result("Vulkan::Calling vkCreateDescriptorSetLayout Fail");
+  }
+
+  layouts_[signature] = new_layout;
+  *layout = new_layout;
+  return {};
+}
+
+Result DescriptorPoolCache::AcquireDescriptorPool(
+    const std::vector<VkDescriptorPoolSize>& pool_sizes,
+    VkDescriptorPool* pool) {
+  std::string signature = PoolSizesSignature(pool_sizes);
+
+  auto it = free_pools_.find(signature);
+  if (it != free_pools_.end() && !it->second.empty()) {
+    *pool = it->second.back();
+    it->second.pop_back();
+    in_use_pools_[*pool] = std::move(signature);
+    return {};
+  }
+
+  VkDescriptorPoolCreateInfo pool_info = VkDescriptorPoolCreateInfo();
+  pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  pool_info.maxSets = 1;
+  pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+  pool_info.pPoolSizes = pool_sizes.data();
+
+  VkDescriptorPool new_pool = VK_NULL_HANDLE;
+  if (device_->GetPtrs()->vkCreateDescriptorPool(device_->GetDevice(),
+                                                 &pool_info,
+                                                 device_->GetHostAllocator(),
+                                                 &new_pool) != VK_SUCCESS) {
+    return Result("Vulkan::Calling vkCreateDescriptorPool Fail");
+  }
+
+  in_use_pools_[new_pool] = std::move(signature);
+  *pool = new_pool;
+  return {};
+}
+
+void DescriptorPoolCache::ReleaseDescriptorPool(VkDescriptorPool pool) {
+  auto it = in_use_pools_.find(pool);
+  if (it == in_use_pools_.end())
+    return;
+
+  device_->GetPtrs()->vkResetDescriptorPool(device_->GetDevice(), pool, 0);
+  free_pools_[it->second].push_back(pool);
+  in_use_pools_.erase(it);
+}
+
+void DescriptorPoolCache::Shutdown() {
+  for (auto& it : layouts_) {
+    device_->GetPtrs()->vkDestroyDescriptorSetLayout(
+        device_->GetDevice(),
+        it.second,
+        device_->GetHostAllocator());
+  }
+  layouts_.clear();
+
+  for (auto& it : free_pools_) {
+    for (auto& pool : it.second) {
+      device_->GetPtrs()->vkDestroyDescriptorPool(device_->GetDevice(),
+                                                  pool,
+                                                  device_->GetHostAllocator());
+    }
+  }
+  free_pools_.clear();
+
+  for (auto& it : in_use_pools_) {
+    device_->GetPtrs()->vkDestroyDescriptorPool(device_->GetDevice(),
+                                                it.first,
+                                                device_->GetHostAllocator());
+  }
+  in_use_pools_.clear();
+}
+
+}  // namespace vulkan
+}  // namespace amber
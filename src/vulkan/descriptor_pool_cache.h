@@ -0,0 +1,79 @@
+// Copyright 2018 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_VULKAN_DESCRIPTOR_POOL_CACHE_H_
+#define SRC_VULKAN_DESCRIPTOR_POOL_CACHE_H_
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "amber/result.h"
+#include "amber/vulkan_header.h"
+
+namespace amber {
+namespace vulkan {
+
+class Device;
+
+// Caches descriptor set layouts and descriptor pools on the device so
+// pipelines reuse them across scripts instead of creating and destroying
+// them per run. Layouts are immutable and shared by everyone asking for
+// the same bindings. Pools are checked out exclusively; a released pool
+// has its sets freed with vkResetDescriptorPool and is handed out again
+// for the next matching request.
+class DescriptorPoolCache {
+ public:
+  explicit DescriptorPoolCache(Device* device);
+  ~DescriptorPoolCache();
+
+  // Return the layout for |bindings| through |layout|, creating it on
+  // first use. The cache keeps ownership of the layout.
+  Result GetDescriptorSetLayout(
+      const std::vector<VkDescriptorSetLayoutBinding>& bindings,
+      VkDescriptorSetLayout* layout);
+
+  // Check out a pool able to hold one descriptor set with |pool_sizes|
+  // through |pool|. The pool must be given back with
+  // ReleaseDescriptorPool().
+  Result AcquireDescriptorPool(
+      const std::vector<VkDescriptorPoolSize>& pool_sizes,
+      VkDescriptorPool* pool);
+
+  // Return |pool| to the cache. All descriptor sets allocated from it
+  // are freed.
+  void ReleaseDescriptorPool(VkDescriptorPool pool);
+
+  // Destroy all cached layouts and pools.
+  void Shutdown();
+
+ private:
+  Device* device_ = nullptr;
+
+  // Layout per binding signature, owned by the cache.
+  std::unordered_map<std::string, VkDescriptorSetLayout> layouts_;
+
+  // Released pools per pool size signature, ready to be checked out.
+  std::unordered_map<std::string, std::vector<VkDescriptorPool>> free_pools_;
+
+  // Signature of every checked out pool so ReleaseDescriptorPool() can
+  // put it back into the right bucket.
+  std::map<VkDescriptorPool, std::string> in_use_pools_;
+};
+
+}  // namespace vulkan
+}  // namespace amber
+
+#endif  // SRC_VULKAN_DESCRIPTOR_POOL_CACHE_H_
@@ -14,10 +14,14 @@
 
 #include "src/vulkan/device.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
 #include <cstring>
 #include <memory>
+#include <mutex>
 #include <set>
+#include <unordered_map>
 #include <vector>
 
 #include "src/make_unique.h"
@@ -44,6 +48,37 @@ const size_t kNumberOfRequiredValidationLayers =
 
 const char* kExtensionForValidationLayer = "VK_EXT_debug_report";
 
+const char kExternalMemoryHostExtension[] = "VK_EXT_external_memory_host";
+
+const char kDeviceGroupExtension[] = "VK_KHR_device_group";
+
+// Pipeline caches shared between Device objects wrapping the same
+// externally provided VkDevice, refcounted by the number of wrappers. A
+// VkPipelineCache is internally synchronized, so engines on different
+// threads can create pipelines into one cache concurrently; sharing it
+// is what lets a pre-warm engine compile pipelines that the executing
+// engine then finds ready made.
+struct SharedPipelineCacheEntry {
+  VkPipelineCache cache = VK_NULL_HANDLE;
+  uint32_t ref_count = 0;
+};
+
+std::mutex& SharedPipelineCacheMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::unordered_map<VkDevice, SharedPipelineCacheEntry>&
+SharedPipelineCaches() {
+  static std::unordered_map<VkDevice, SharedPipelineCacheEntry> caches;
+  return caches;
+}
+
+// Upper bound on the number of queues requested from the main queue
+// family. Pipelines are spread over them round robin; more queues than
+// this would not buy additional parallelism on current hardware.
+const uint32_t kMaxQueuesPerFamily = 4;
+
 VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(VkDebugReportFlagsEXT flag,
                                              VkDebugReportObjectTypeEXT,
                                              uint64_t,
@@ -69,428 +104,71 @@ VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(VkDebugReportFlagsEXT flag,
   return VK_FALSE;
 }
 
-VkPhysicalDeviceFeatures RequestedFeatures(
-    const std::vector<Feature>& required_features) {
-  VkPhysicalDeviceFeatures requested_features = VkPhysicalDeviceFeatures();
+// The Feature enum lists the members of VkPhysicalDeviceFeatures in
+// declaration order directly after kUnknown, and the struct consists of
+// nothing but VkBool32s, so the feature maps to the bool at index
+// |feature| - kFirstDeviceFeature. The asserts pin that correspondence.
+const int kFirstDeviceFeature = static_cast<int>(Feature::kRobustBufferAccess);
+const int kDeviceFeatureCount =
+    static_cast<int>(Feature::kInheritedQueries) - kFirstDeviceFeature + 1;
+
+static_assert(sizeof(VkPhysicalDeviceFeatures) ==
+                  static_cast<size_t>(kDeviceFeatureCount) * sizeof(VkBool32),
+              "Feature enum must mirror every member of "
+              "VkPhysicalDeviceFeatures");
+static_assert(offsetof(VkPhysicalDeviceFeatures, robustBufferAccess) == 0 &&
+                  offsetof(VkPhysicalDeviceFeatures, inheritedQueries) ==
+                      static_cast<size_t>(kDeviceFeatureCount - 1) *
+                          sizeof(VkBool32),
+              "Feature enum order must match VkPhysicalDeviceFeatures");
+static_assert(kDeviceFeatureCount <= 64,
+              "device feature mask must fit in 64 bits");
+
+// Squash |features| into one bit per member, in Feature enum order.
+uint64_t FeatureBoolsToMask(const VkPhysicalDeviceFeatures& features) {
+  VkBool32 bools[kDeviceFeatureCount];
+  std::memcpy(bools, &features, sizeof(bools));
+
+  uint64_t mask = 0;
+  for (int i = 0; i < kDeviceFeatureCount; ++i) {
+    if (bools[i] != VK_FALSE)
+      mask |= 1ULL << i;
+  }
+  return mask;
+}
+
+// One bit per required device feature; features without a struct member
+// e.g., kFramebuffer contribute nothing.
+uint64_t RequiredFeaturesToMask(const std::vector<Feature>& required_features) {
+  uint64_t mask = 0;
   for (const auto& feature : required_features) {
-    switch (feature) {
-      case Feature::kRobustBufferAccess:
-        requested_features.robustBufferAccess = VK_TRUE;
-        break;
-      case Feature::kFullDrawIndexUint32:
-        requested_features.fullDrawIndexUint32 = VK_TRUE;
-        break;
-      case Feature::kImageCubeArray:
-        requested_features.imageCubeArray = VK_TRUE;
-        break;
-      case Feature::kIndependentBlend:
-        requested_features.independentBlend = VK_TRUE;
-        break;
-      case Feature::kGeometryShader:
-        requested_features.geometryShader = VK_TRUE;
-        break;
-      case Feature::kTessellationShader:
-        requested_features.tessellationShader = VK_TRUE;
-        break;
-      case Feature::kSampleRateShading:
-        requested_features.sampleRateShading = VK_TRUE;
-        break;
-      case Feature::kDualSrcBlend:
-        requested_features.dualSrcBlend = VK_TRUE;
-        break;
-      case Feature::kLogicOp:
-        requested_features.logicOp = VK_TRUE;
-        break;
-      case Feature::kMultiDrawIndirect:
-        requested_features.multiDrawIndirect = VK_TRUE;
-        break;
-      case Feature::kDrawIndirectFirstInstance:
-        requested_features.drawIndirectFirstInstance = VK_TRUE;
-        break;
-      case Feature::kDepthClamp:
-        requested_features.depthClamp = VK_TRUE;
-        break;
-      case Feature::kDepthBiasClamp:
-        requested_features.depthBiasClamp = VK_TRUE;
-        break;
-      case Feature::kFillModeNonSolid:
-        requested_features.fillModeNonSolid = VK_TRUE;
-        break;
-      case Feature::kDepthBounds:
-        requested_features.depthBounds = VK_TRUE;
-        break;
-      case Feature::kWideLines:
-        requested_features.wideLines = VK_TRUE;
-        break;
-      case Feature::kLargePoints:
-        requested_features.largePoints = VK_TRUE;
-        break;
-      case Feature::kAlphaToOne:
-        requested_features.alphaToOne = VK_TRUE;
-        break;
-      case Feature::kMultiViewport:
-        requested_features.multiViewport = VK_TRUE;
-        break;
-      case Feature::kSamplerAnisotropy:
-        requested_features.samplerAnisotropy = VK_TRUE;
-        break;
-      case Feature::kTextureCompressionETC2:
-        requested_features.textureCompressionETC2 = VK_TRUE;
-        break;
-      case Feature::kTextureCompressionASTC_LDR:
-        requested_features.textureCompressionASTC_LDR = VK_TRUE;
-        break;
-      case Feature::kTextureCompressionBC:
-        requested_features.textureCompressionBC = VK_TRUE;
-        break;
-      case Feature::kOcclusionQueryPrecise:
-        requested_features.occlusionQueryPrecise = VK_TRUE;
-        break;
-      case Feature::kPipelineStatisticsQuery:
-        requested_features.pipelineStatisticsQuery = VK_TRUE;
-        break;
-      case Feature::kVertexPipelineStoresAndAtomics:
-        requested_features.vertexPipelineStoresAndAtomics = VK_TRUE;
-        break;
-      case Feature::kFragmentStoresAndAtomics:
-        requested_features.fragmentStoresAndAtomics = VK_TRUE;
-        break;
-      case Feature::kShaderTessellationAndGeometryPointSize:
-        requested_features.shaderTessellationAndGeometryPointSize = VK_TRUE;
-        break;
-      case Feature::kShaderImageGatherExtended:
-        requested_features.shaderImageGatherExtended = VK_TRUE;
-        break;
-      case Feature::kShaderStorageImageExtendedFormats:
-        requested_features.shaderStorageImageExtendedFormats = VK_TRUE;
-        break;
-      case Feature::kShaderStorageImageMultisample:
-        requested_features.shaderStorageImageMultisample = VK_TRUE;
-        break;
-      case Feature::kShaderStorageImageReadWithoutFormat:
-        requested_features.shaderStorageImageReadWithoutFormat = VK_TRUE;
-        break;
-      case Feature::kShaderStorageImageWriteWithoutFormat:
-        requested_features.shaderStorageImageWriteWithoutFormat = VK_TRUE;
-        break;
-      case Feature::kShaderUniformBufferArrayDynamicIndexing:
-        requested_features.shaderUniformBufferArrayDynamicIndexing = VK_TRUE;
-        break;
-      case Feature::kShaderSampledImageArrayDynamicIndexing:
-        requested_features.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
-        break;
-      case Feature::kShaderStorageBufferArrayDynamicIndexing:
-        requested_features.shaderStorageBufferArrayDynamicIndexing = VK_TRUE;
-        break;
-      case Feature::kShaderStorageImageArrayDynamicIndexing:
-        requested_features.shaderStorageImageArrayDynamicIndexing = VK_TRUE;
-        break;
-      case Feature::kShaderClipDistance:
-        requested_features.shaderClipDistance = VK_TRUE;
-        break;
-      case Feature::kShaderCullDistance:
-        requested_features.shaderCullDistance = VK_TRUE;
-        break;
-      case Feature::kShaderFloat64:
-        requested_features.shaderFloat64 = VK_TRUE;
-        break;
-      case Feature::kShaderInt64:
-        requested_features.shaderInt64 = VK_TRUE;
-        break;
-      case Feature::kShaderInt16:
-        requested_features.shaderInt16 = VK_TRUE;
-        break;
-      case Feature::kShaderResourceResidency:
-        requested_features.shaderResourceResidency = VK_TRUE;
-        break;
-      case Feature::kShaderResourceMinLod:
-        requested_features.shaderResourceMinLod = VK_TRUE;
-        break;
-      case Feature::kSparseBinding:
-        requested_features.sparseBinding = VK_TRUE;
-        break;
-      case Feature::kSparseResidencyBuffer:
-        requested_features.sparseResidencyBuffer = VK_TRUE;
-        break;
-      case Feature::kSparseResidencyImage2D:
-        requested_features.sparseResidencyImage2D = VK_TRUE;
-        break;
-      case Feature::kSparseResidencyImage3D:
-        requested_features.sparseResidencyImage3D = VK_TRUE;
-        break;
-      case Feature::kSparseResidency2Samples:
-        requested_features.sparseResidency2Samples = VK_TRUE;
-        break;
-      case Feature::kSparseResidency4Samples:
-        requested_features.sparseResidency4Samples = VK_TRUE;
-        break;
-      case Feature::kSparseResidency8Samples:
-        requested_features.sparseResidency8Samples = VK_TRUE;
-        break;
-      case Feature::kSparseResidency16Samples:
-        requested_features.sparseResidency16Samples = VK_TRUE;
-        break;
-      case Feature::kSparseResidencyAliased:
-        requested_features.sparseResidencyAliased = VK_TRUE;
-        break;
-      case Feature::kVariableMultisampleRate:
-        requested_features.variableMultisampleRate = VK_TRUE;
-        break;
-      case Feature::kInheritedQueries:
-        requested_features.inheritedQueries = VK_TRUE;
-        break;
-      case Feature::kFramebuffer:
-      case Feature::kDepthStencil:
-      case Feature::kFenceTimeout:
-      case Feature::kUnknown:
-        break;
-    }
+    const int index = static_cast<int>(feature) - kFirstDeviceFeature;
+    if (index >= 0 && index < kDeviceFeatureCount)
+      mask |= 1ULL << index;
   }
-  return requested_features;
+  return mask;
 }
 
-bool AreAllRequiredFeaturesSupported(
-    const VkPhysicalDeviceFeatures& available_features,
+VkPhysicalDeviceFeatures RequestedFeatures(
     const std::vector<Feature>& required_features) {
-  if (required_features.empty())
-    return true;
+  const uint64_t mask = RequiredFeaturesToMask(required_features);
 
-  for (const auto& feature : required_features) {
-    switch (feature) {
-      case Feature::kRobustBufferAccess:
-        if (available_features.robustBufferAccess == VK_FALSE)
-          return false;
-        break;
-      case Feature::kFullDrawIndexUint32:
-        if (available_features.fullDrawIndexUint32 == VK_FALSE)
-          return false;
-        break;
-      case Feature::kImageCubeArray:
-        if (available_features.imageCubeArray == VK_FALSE)
-          return false;
-        break;
-      case Feature::kIndependentBlend:
-        if (available_features.independentBlend == VK_FALSE)
-          return false;
-        break;
-      case Feature::kGeometryShader:
-        if (available_features.geometryShader == VK_FALSE)
-          return false;
-        break;
-      case Feature::kTessellationShader:
-        if (available_features.tessellationShader == VK_FALSE)
-          return false;
-        break;
-      case Feature::kSampleRateShading:
-        if (available_features.sampleRateShading == VK_FALSE)
-          return false;
-        break;
-      case Feature::kDualSrcBlend:
-        if (available_features.dualSrcBlend == VK_FALSE)
-          return false;
-        break;
-      case Feature::kLogicOp:
-        if (available_features.logicOp == VK_FALSE)
-          return false;
-        break;
-      case Feature::kMultiDrawIndirect:
-        if (available_features.multiDrawIndirect == VK_FALSE)
-          return false;
-        break;
-      case Feature::kDrawIndirectFirstInstance:
-        if (available_features.drawIndirectFirstInstance == VK_FALSE)
-          return false;
-        break;
-      case Feature::kDepthClamp:
-        if (available_features.depthClamp == VK_FALSE)
-          return false;
-        break;
-      case Feature::kDepthBiasClamp:
-        if (available_features.depthBiasClamp == VK_FALSE)
-          return false;
-        break;
-      case Feature::kFillModeNonSolid:
-        if (available_features.fillModeNonSolid == VK_FALSE)
-          return false;
-        break;
-      case Feature::kDepthBounds:
-        if (available_features.depthBounds == VK_FALSE)
-          return false;
-        break;
-      case Feature::kWideLines:
-        if (available_features.wideLines == VK_FALSE)
-          return false;
-        break;
-      case Feature::kLargePoints:
-        if (available_features.largePoints == VK_FALSE)
-          return false;
-        break;
-      case Feature::kAlphaToOne:
-        if (available_features.alphaToOne == VK_FALSE)
-          return false;
-        break;
-      case Feature::kMultiViewport:
-        if (available_features.multiViewport == VK_FALSE)
-          return false;
-        break;
-      case Feature::kSamplerAnisotropy:
-        if (available_features.samplerAnisotropy == VK_FALSE)
-          return false;
-        break;
-      case Feature::kTextureCompressionETC2:
-        if (available_features.textureCompressionETC2 == VK_FALSE)
-          return false;
-        break;
-      case Feature::kTextureCompressionASTC_LDR:
-        if (available_features.textureCompressionASTC_LDR == VK_FALSE)
-          return false;
-        break;
-      case Feature::kTextureCompressionBC:
-        if (available_features.textureCompressionBC == VK_FALSE)
-          return false;
-        break;
-      case Feature::kOcclusionQueryPrecise:
-        if (available_features.occlusionQueryPrecise == VK_FALSE)
-          return false;
-        break;
-      case Feature::kPipelineStatisticsQuery:
-        if (available_features.pipelineStatisticsQuery == VK_FALSE)
-          return false;
-        break;
-      case Feature::kVertexPipelineStoresAndAtomics:
-        if (available_features.vertexPipelineStoresAndAtomics == VK_FALSE)
-          return false;
-        break;
-      case Feature::kFragmentStoresAndAtomics:
-        if (available_features.fragmentStoresAndAtomics == VK_FALSE)
-          return false;
-        break;
-      case Feature::kShaderTessellationAndGeometryPointSize:
-        if (available_features.shaderTessellationAndGeometryPointSize ==
-            VK_FALSE)
-          return false;
-        break;
-      case Feature::kShaderImageGatherExtended:
-        if (available_features.shaderImageGatherExtended == VK_FALSE)
-          return false;
-        break;
-      case Feature::kShaderStorageImageExtendedFormats:
-        if (available_features.shaderStorageImageExtendedFormats == VK_FALSE)
-          return false;
-        break;
-      case Feature::kShaderStorageImageMultisample:
-        if (available_features.shaderStorageImageMultisample == VK_FALSE)
-          return false;
-        break;
-      case Feature::kShaderStorageImageReadWithoutFormat:
-        if (available_features.shaderStorageImageReadWithoutFormat == VK_FALSE)
-          return false;
-        break;
-      case Feature::kShaderStorageImageWriteWithoutFormat:
-        if (available_features.shaderStorageImageWriteWithoutFormat == VK_FALSE)
-          return false;
-        break;
-      case Feature::kShaderUniformBufferArrayDynamicIndexing:
-        if (available_features.shaderUniformBufferArrayDynamicIndexing ==
-            VK_FALSE)
-          return false;
-        break;
-      case Feature::kShaderSampledImageArrayDynamicIndexing:
-        if (available_features.shaderSampledImageArrayDynamicIndexing ==
-            VK_FALSE)
-          return false;
-        break;
-      case Feature::kShaderStorageBufferArrayDynamicIndexing:
-        if (available_features.shaderStorageBufferArrayDynamicIndexing ==
-            VK_FALSE)
-          return false;
-        break;
-      case Feature::kShaderStorageImageArrayDynamicIndexing:
-        if (available_features.shaderStorageImageArrayDynamicIndexing ==
-            VK_FALSE)
-          return false;
-        break;
-      case Feature::kShaderClipDistance:
-        if (available_features.shaderClipDistance == VK_FALSE)
-          return false;
-        break;
-      case Feature::kShaderCullDistance:
-        if (available_features.shaderCullDistance == VK_FALSE)
-          return false;
-        break;
-      case Feature::kShaderFloat64:
-        if (available_features.shaderFloat64 == VK_FALSE)
-          return false;
-        break;
-      case Feature::kShaderInt64:
-        if (available_features.shaderInt64 == VK_FALSE)
-          return false;
-        break;
-      case Feature::kShaderInt16:
-        if (available_features.shaderInt16 == VK_FALSE)
-          return false;
-        break;
-      case Feature::kShaderResourceResidency:
-        if (available_features.shaderResourceResidency == VK_FALSE)
-          return false;
-        break;
-      case Feature::kShaderResourceMinLod:
-        if (available_features.shaderResourceMinLod == VK_FALSE)
-          return false;
-        break;
-      case Feature::kSparseBinding:
-        if (available_features.sparseBinding == VK_FALSE)
-          return false;
-        break;
-      case Feature::kSparseResidencyBuffer:
-        if (available_features.sparseResidencyBuffer == VK_FALSE)
-          return false;
-        break;
-      case Feature::kSparseResidencyImage2D:
-        if (available_features.sparseResidencyImage2D == VK_FALSE)
-          return false;
-        break;
-      case Feature::kSparseResidencyImage3D:
-        if (available_features.sparseResidencyImage3D == VK_FALSE)
-          return false;
-        break;
-      case Feature::kSparseResidency2Samples:
-        if (available_features.sparseResidency2Samples == VK_FALSE)
-          return false;
-        break;
-      case Feature::kSparseResidency4Samples:
-        if (available_features.sparseResidency4Samples == VK_FALSE)
-          return false;
-        break;
-      case Feature::kSparseResidency8Samples:
-        if (available_features.sparseResidency8Samples == VK_FALSE)
-          return false;
-        break;
-      case Feature::kSparseResidency16Samples:
-        if (available_features.sparseResidency16Samples == VK_FALSE)
-          return false;
-        break;
-      case Feature::kSparseResidencyAliased:
-        if (available_features.sparseResidencyAliased == VK_FALSE)
-          return false;
-        break;
-      case Feature::kVariableMultisampleRate:
-        if (available_features.variableMultisampleRate == VK_FALSE)
-          return false;
-        break;
-      case Feature::kInheritedQueries:
-        if (available_features.inheritedQueries == VK_FALSE)
-          return false;
-        break;
-      case Feature::kFramebuffer:
-      case Feature::kDepthStencil:
-      case Feature::kFenceTimeout:
-      case Feature::kUnknown:
-        break;
-    }
+  VkBool32 bools[kDeviceFeatureCount] = {};
+  for (int i = 0; i < kDeviceFeatureCount; ++i) {
+    if (mask & (1ULL << i))
+      bools[i] = VK_TRUE;
   }
 
-  return true;
+  VkPhysicalDeviceFeatures requested_features = VkPhysicalDeviceFeatures();
+  std::memcpy(&requested_features, bools, sizeof(bools));
+  return requested_features;
+}
+
+bool AreAllRequiredFeaturesSupported(
+    uint64_t supported_features_mask,
+    const std::vector<Feature>& required_features) {
+  return (RequiredFeaturesToMask(required_features) &
+          ~supported_features_mask) == 0;
 }
 
 bool AreAllExtensionsSupported(
@@ -523,14 +201,67 @@ Device::Device(VkInstance instance,
       physical_device_(physical_device),
       available_physical_device_features_(available_features),
       available_physical_device_extensions_(available_extensions),
+      enabled_features_(available_features),
+      enabled_extensions_(available_extensions),
       queue_family_index_(queue_family_index),
       device_(device),
       queue_(queue),
-      destroy_device_(false) {}
+      destroy_device_(false) {
+  available_features_mask_ = FeatureBoolsToMask(available_features);
+  enabled_features_mask_ = available_features_mask_;
+}
 
 Device::~Device() = default;
 
 void Device::Shutdown() {
+  if (shader_module_cache_) {
+    shader_module_cache_->Shutdown();
+    shader_module_cache_.reset();
+  }
+
+  if (render_target_cache_) {
+    render_target_cache_->Shutdown();
+    render_target_cache_.reset();
+  }
+
+  if (descriptor_pool_cache_) {
+    descriptor_pool_cache_->Shutdown();
+    descriptor_pool_cache_.reset();
+  }
+
+  // The content cache releases its buffers into the pool, so it must go
+  // down first.
+  if (buffer_content_cache_) {
+    buffer_content_cache_->Shutdown();
+    buffer_content_cache_.reset();
+  }
+
+  if (staging_buffer_pool_) {
+    staging_buffer_pool_->Shutdown();
+    staging_buffer_pool_.reset();
+  }
+
+  if (memory_allocator_) {
+    memory_allocator_->Shutdown();
+    memory_allocator_.reset();
+  }
+
+  if (pipeline_cache_ != VK_NULL_HANDLE) {
+    bool destroy = true;
+    if (pipeline_cache_shared_) {
+      std::lock_guard<std::mutex> lock(SharedPipelineCacheMutex());
+      auto it = SharedPipelineCaches().find(device_);
+      if (it != SharedPipelineCaches().end()) {
+        destroy = --it->second.ref_count == 0;
+        if (destroy)
+          SharedPipelineCaches().erase(it);
+      }
+    }
+    if (destroy)
+      ptrs_.vkDestroyPipelineCache(device_, pipeline_cache_, nullptr);
+    pipeline_cache_ = VK_NULL_HANDLE;
+  }
+
   if (destroy_device_) {
     ptrs_.vkDestroyDevice(device_, nullptr);
     ptrs_.vkDestroyDebugReportCallbackEXT(instance_, callback_, nullptr);
@@ -598,11 +329,22 @@ Result Device::Initialize(PFN_vkGetInstanceProcAddr getInstanceProcAddr,
     if (!r.IsSuccess())
       return r;
 
-    ptrs_.vkGetDeviceQueue(device_, queue_family_index_, 0, &queue_);
-    if (queue_ == VK_NULL_HANDLE)
-      return Result("Vulkan::Calling vkGetDeviceQueue Fail");
+    queues_.resize(queue_count_);
+    for (uint32_t i = 0; i < queue_count_; ++i) {
+      ptrs_.vkGetDeviceQueue(device_, queue_family_index_, i, &queues_[i]);
+      if (queues_[i] == VK_NULL_HANDLE)
+        return Result("Vulkan::Calling vkGetDeviceQueue Fail");
+    }
+    queue_ = queues_[0];
+
+    if (has_transfer_queue_family_) {
+      ptrs_.vkGetDeviceQueue(device_, transfer_queue_family_index_, 0,
+                             &transfer_queue_);
+      if (transfer_queue_ == VK_NULL_HANDLE)
+        return Result("Vulkan::Calling vkGetDeviceQueue Fail");
+    }
   } else {
-    if (!AreAllRequiredFeaturesSupported(available_physical_device_features_,
+    if (!AreAllRequiredFeaturesSupported(available_features_mask_,
                                          required_features)) {
       return Result(
           "Vulkan: Device::Initialize given physical device does not support "
@@ -623,6 +365,106 @@ Result Device::Initialize(PFN_vkGetInstanceProcAddr getInstanceProcAddr,
   ptrs_.vkGetPhysicalDeviceMemoryProperties(physical_device_,
                                             &physical_memory_properties_);
 
+  // On unified memory architectures e.g., integrated GPUs, device local
+  // memory can be written directly by the host and resources skip the
+  // staging copies altogether.
+  const VkMemoryPropertyFlags unified_flags =
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT |
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+      VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+  for (uint32_t i = 0; i < physical_memory_properties_.memoryTypeCount; ++i) {
+    if ((physical_memory_properties_.memoryTypes[i].propertyFlags &
+         unified_flags) == unified_flags) {
+      has_unified_memory_ = true;
+      break;
+    }
+  }
+
+  SetupHostPointerImport(getInstanceProcAddr);
+  SetupGroupDispatch(getInstanceProcAddr);
+
+  memory_allocator_ = MakeUnique<MemoryAllocator>(this);
+  staging_buffer_pool_ = MakeUnique<StagingBufferPool>(this);
+  buffer_content_cache_ = MakeUnique<BufferContentCache>(this);
+  descriptor_pool_cache_ = MakeUnique<DescriptorPoolCache>(this);
+  render_target_cache_ = MakeUnique<RenderTargetCache>(this);
+  shader_module_cache_ = MakeUnique<ShaderModuleCache>(this);
+
+  return CreatePipelineCache();
+}
+
+Result Device::CreatePipelineCache() {
+  // Wrappers around one externally provided VkDevice share a single
+  // pipeline cache, so pipelines compiled by any engine on the device -
+  // including a pre-warm engine on another thread - are found by all of
+  // them.
+  if (!destroy_device_) {
+    std::lock_guard<std::mutex> lock(SharedPipelineCacheMutex());
+    auto& shared = SharedPipelineCaches()[device_];
+    if (shared.ref_count == 0) {
+      Result r = CreateVkPipelineCache();
+      if (!r.IsSuccess()) {
+        SharedPipelineCaches().erase(device_);
+        return r;
+      }
+      shared.cache = pipeline_cache_;
+    } else {
+      pipeline_cache_ = shared.cache;
+    }
+    ++shared.ref_count;
+    pipeline_cache_shared_ = true;
+    return {};
+  }
+
+  return CreateVkPipelineCache();
+}
+
+Result Device::CreateVkPipelineCache() {
+  VkPipelineCacheCreateInfo info = VkPipelineCacheCreateInfo();
+  info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+  // Only seed the cache when the blob was produced by the same device and
+  // driver version; anything else is undefined behavior per the spec. The
+  // header is length, version, vendor id, device id then the cache UUID.
+  const auto& data = initial_pipeline_cache_data_;
+  if (data.size() >= 16 + VK_UUID_SIZE) {
+    uint32_t vendor_id = 0;
+    uint32_t device_id = 0;
+    memcpy(&vendor_id, data.data() + 8, sizeof(vendor_id));
+    memcpy(&device_id, data.data() + 12, sizeof(device_id));
+    if (vendor_id == physical_device_properties_.vendorID &&
+        device_id == physical_device_properties_.deviceID &&
+        memcmp(data.data() + 16, physical_device_properties_.pipelineCacheUUID,
+               VK_UUID_SIZE) == 0) {
+      info.initialDataSize = data.size();
+      info.pInitialData = data.data();
+    }
+  }
+
+  if (ptrs_.vkCreatePipelineCache(device_, &info, nullptr, &pipeline_cache_) !=
+      VK_SUCCESS) {
+    return Result("Vulkan::Calling vkCreatePipelineCache Fail");
+  }
+
+  return {};
+}
+
+Result Device::GetPipelineCacheData(std::vector<uint8_t>* data) const {
+  if (pipeline_cache_ == VK_NULL_HANDLE)
+    return Result("Vulkan::GetPipelineCacheData no pipeline cache exists");
+
+  size_t size = 0;
+  if (ptrs_.vkGetPipelineCacheData(device_, pipeline_cache_, &size, nullptr) !=
+      VK_SUCCESS) {
+    return Result("Vulkan::Calling vkGetPipelineCacheData Fail");
+  }
+
+  data->resize(size);
+  if (ptrs_.vkGetPipelineCacheData(device_, pipeline_cache_, &size,
+                                   data->data()) != VK_SUCCESS) {
+    return Result("Vulkan::Calling vkGetPipelineCacheData Fail");
+  }
+
   return {};
 }
 
@@ -637,15 +479,38 @@ bool Device::ChooseQueueFamilyIndex(const VkPhysicalDevice& physical_device) {
   ptrs_.vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &count,
                                                  properties.data());
 
+  bool found = false;
   for (uint32_t i = 0; i < count; ++i) {
     if (properties[i].queueFlags &
         (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) {
       queue_family_index_ = i;
-      return true;
+      queue_count_ = properties[i].queueCount < kMaxQueuesPerFamily
+                         ? properties[i].queueCount
+                         : kMaxQueuesPerFamily;
+      if (queue_count_ == 0)
+        queue_count_ = 1;
+      found = true;
+      break;
     }
   }
 
-  return false;
+  if (!found)
+    return false;
+
+  // Look for a transfer-only queue family e.g., a DMA engine on discrete
+  // GPUs. Copies issued on it can overlap with work on the main queue.
+  has_transfer_queue_family_ = false;
+  for (uint32_t i = 0; i < count; ++i) {
+    if ((properties[i].queueFlags & VK_QUEUE_TRANSFER_BIT) &&
+        !(properties[i].queueFlags &
+          (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+      transfer_queue_family_index_ = i;
+      has_transfer_queue_family_ = true;
+      break;
+    }
+  }
+
+  return true;
 }
 
 Result Device::CreateInstance() {
@@ -708,18 +573,20 @@ Result Device::ChoosePhysicalDevice(
   for (uint32_t i = 0; i < count; ++i) {
     VkPhysicalDeviceFeatures available_features = VkPhysicalDeviceFeatures();
     ptrs_.vkGetPhysicalDeviceFeatures(physical_devices[i], &available_features);
-    if (!AreAllRequiredFeaturesSupported(available_features,
-                                         required_features)) {
+    const uint64_t features_mask = FeatureBoolsToMask(available_features);
+    if (!AreAllRequiredFeaturesSupported(features_mask, required_features))
       continue;
-    }
 
-    if (!AreAllExtensionsSupported(GetAvailableExtensions(physical_devices[i]),
-                                   required_extensions)) {
+    std::vector<std::string> available_extensions =
+        GetAvailableExtensions(physical_devices[i]);
+    if (!AreAllExtensionsSupported(available_extensions, required_extensions))
       continue;
-    }
 
     if (ChooseQueueFamilyIndex(physical_devices[i])) {
       physical_device_ = physical_devices[i];
+      available_physical_device_features_ = available_features;
+      available_features_mask_ = features_mask;
+      available_physical_device_extensions_ = available_extensions;
       return {};
     }
   }
@@ -730,25 +597,64 @@ Result Device::ChoosePhysicalDevice(
 Result Device::CreateDevice(
     const std::vector<Feature>& required_features,
     const std::vector<std::string>& required_extensions) {
-  VkDeviceQueueCreateInfo queue_info = VkDeviceQueueCreateInfo();
-  const float priorities[] = {1.0f};
-  queue_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-  queue_info.queueFamilyIndex = queue_family_index_;
-  queue_info.queueCount = 1;
-  queue_info.pQueuePriorities = priorities;
+  const std::vector<float> priorities(kMaxQueuesPerFamily, 1.0f);
+  std::vector<VkDeviceQueueCreateInfo> queue_infos;
+  queue_infos.emplace_back();
+  queue_infos.back().sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+  queue_infos.back().queueFamilyIndex = queue_family_index_;
+  queue_infos.back().queueCount = queue_count_;
+  queue_infos.back().pQueuePriorities = priorities.data();
+
+  if (has_transfer_queue_family_) {
+    queue_infos.emplace_back();
+    queue_infos.back().sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queue_infos.back().queueFamilyIndex = transfer_queue_family_index_;
+    queue_infos.back().queueCount = 1;
+    queue_infos.back().pQueuePriorities = priorities.data();
+  }
 
   VkDeviceCreateInfo info = VkDeviceCreateInfo();
   info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-  info.pQueueCreateInfos = &queue_info;
-  info.queueCreateInfoCount = 1;
+  info.pQueueCreateInfos = queue_infos.data();
+  info.queueCreateInfoCount = static_cast<uint32_t>(queue_infos.size());
   // TODO(jaebaek): Enable layers
   VkPhysicalDeviceFeatures requested_features =
       RequestedFeatures(required_features);
+  // Opportunistically enable pipeline statistics queries so command
+  // timing runs can also count shader invocations; no script requires
+  // the feature, so a device without it just reports zero counts.
+  if (available_physical_device_features_.pipelineStatisticsQuery)
+    requested_features.pipelineStatisticsQuery = VK_TRUE;
   info.pEnabledFeatures = &requested_features;
 
+  std::vector<std::string> extensions = required_extensions;
+  // Opportunistically enable host pointer imports so initializers mapped
+  // from data files can back buffers directly; no script requires the
+  // extension, and on devices without it buffers just keep being copied.
+  if (std::find(extensions.begin(), extensions.end(),
+                kExternalMemoryHostExtension) == extensions.end() &&
+      std::find(available_physical_device_extensions_.begin(),
+                available_physical_device_extensions_.end(),
+                kExternalMemoryHostExtension) !=
+          available_physical_device_extensions_.end()) {
+    extensions.push_back(kExternalMemoryHostExtension);
+  }
+  // Opportunistically enable the device group extension for its
+  // vkCmdDispatchBase entry point, which lets a data-parallel dispatch
+  // be split into offset slices; without it such dispatches just run
+  // whole.
+  if (std::find(extensions.begin(), extensions.end(), kDeviceGroupExtension) ==
+          extensions.end() &&
+      std::find(available_physical_device_extensions_.begin(),
+                available_physical_device_extensions_.end(),
+                kDeviceGroupExtension) !=
+          available_physical_device_extensions_.end()) {
+    extensions.push_back(kDeviceGroupExtension);
+  }
+
   std::vector<const char*> enabled_extensions;
-  for (size_t i = 0; i < required_extensions.size(); ++i)
-    enabled_extensions.push_back(required_extensions[i].c_str());
+  for (size_t i = 0; i < extensions.size(); ++i)
+    enabled_extensions.push_back(extensions[i].c_str());
   info.enabledExtensionCount = static_cast<uint32_t>(enabled_extensions.size());
   info.ppEnabledExtensionNames = enabled_extensions.data();
 
@@ -757,6 +663,92 @@ Result Device::CreateDevice(
     return Result("Vulkan::Calling vkCreateDevice Fail");
   }
 
+  enabled_features_ = requested_features;
+  enabled_features_mask_ = RequiredFeaturesToMask(required_features);
+  enabled_extensions_ = extensions;
+  return {};
+}
+
+void Device::SetupHostPointerImport(
+    PFN_vkGetInstanceProcAddr getInstanceProcAddr) {
+  if (std::find(enabled_extensions_.begin(), enabled_extensions_.end(),
+                kExternalMemoryHostExtension) == enabled_extensions_.end()) {
+    return;
+  }
+
+  // The import alignment is only reachable through
+  // vkGetPhysicalDeviceProperties2. Neither the core nor the KHR entry
+  // point may resolve on a 1.0 instance created without
+  // VK_KHR_get_physical_device_properties2; imports then stay disabled.
+  auto get_properties2 = reinterpret_cast<PFN_vkGetPhysicalDeviceProperties2>(
+      getInstanceProcAddr(instance_, "vkGetPhysicalDeviceProperties2"));
+  if (!get_properties2) {
+    get_properties2 = reinterpret_cast<PFN_vkGetPhysicalDeviceProperties2>(
+        getInstanceProcAddr(instance_, "vkGetPhysicalDeviceProperties2KHR"));
+  }
+  if (!get_properties2)
+    return;
+
+  vkGetMemoryHostPointerPropertiesEXT_ =
+      reinterpret_cast<PFN_vkGetMemoryHostPointerPropertiesEXT>(
+          getInstanceProcAddr(instance_,
+                              "vkGetMemoryHostPointerPropertiesEXT"));
+  if (!vkGetMemoryHostPointerPropertiesEXT_)
+    return;
+
+  VkPhysicalDeviceExternalMemoryHostPropertiesEXT host_properties =
+      VkPhysicalDeviceExternalMemoryHostPropertiesEXT();
+  host_properties.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_MEMORY_HOST_PROPERTIES_EXT;
+
+  VkPhysicalDeviceProperties2 properties2 = VkPhysicalDeviceProperties2();
+  properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+  properties2.pNext = &host_properties;
+  get_properties2(physical_device_, &properties2);
+
+  if (host_properties.minImportedHostPointerAlignment == 0)
+    return;
+
+  host_pointer_import_alignment_ =
+      host_properties.minImportedHostPointerAlignment;
+  host_pointer_import_supported_ = true;
+}
+
+void Device::SetupGroupDispatch(
+    PFN_vkGetInstanceProcAddr getInstanceProcAddr) {
+  if (std::find(enabled_extensions_.begin(), enabled_extensions_.end(),
+                kDeviceGroupExtension) == enabled_extensions_.end()) {
+    return;
+  }
+
+  // The KHR suffix is the extension's own spelling; the unsuffixed name
+  // resolves when the driver promoted the entry point to core. Either
+  // may fail to resolve on a 1.0 loader, and dispatch splitting then
+  // stays disabled.
+  vkCmdDispatchBaseKHR_ = reinterpret_cast<PFN_vkCmdDispatchBaseKHR>(
+      getInstanceProcAddr(instance_, "vkCmdDispatchBaseKHR"));
+  if (!vkCmdDispatchBaseKHR_) {
+    vkCmdDispatchBaseKHR_ = reinterpret_cast<PFN_vkCmdDispatchBaseKHR>(
+        getInstanceProcAddr(instance_, "vkCmdDispatchBase"));
+  }
+}
+
+Result Device::ValidateRequirements(
+    const std::vector<Feature>& required_features,
+    const std::vector<std::string>& required_extensions) const {
+  if (!AreAllRequiredFeaturesSupported(enabled_features_mask_,
+                                       required_features)) {
+    return Result(
+        "Vulkan: Device::ValidateRequirements device was not created with "
+        "all features required by the script");
+  }
+
+  if (!AreAllExtensionsSupported(enabled_extensions_, required_extensions)) {
+    return Result(
+        "Vulkan: Device::ValidateRequirements device was not created with "
+        "all extensions required by the script");
+  }
+
   return {};
 }
 
@@ -17,11 +17,19 @@
 
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "amber/result.h"
 #include "amber/vulkan_header.h"
 #include "src/feature.h"
+#include "src/vulkan/buffer_content_cache.h"
+#include "src/vulkan/descriptor_pool_cache.h"
+#include "src/vulkan/host_allocator.h"
+#include "src/vulkan/memory_allocator.h"
+#include "src/vulkan/render_target_cache.h"
+#include "src/vulkan/shader_module_cache.h"
+#include "src/vulkan/staging_buffer_pool.h"
 
 namespace amber {
 namespace vulkan {
@@ -51,26 +59,156 @@ class Device {
                     const std::vector<std::string>& required_extensions);
   void Shutdown();
 
+  /// Seeds the pipeline cache created during Initialize() with |data|, which
+  /// must come from GetPipelineCacheData() of an earlier run. Blobs written
+  /// by a different device or driver version are ignored.
+  void SetInitialPipelineCacheData(std::vector<uint8_t> data) {
+    initial_pipeline_cache_data_ = std::move(data);
+  }
+
+  /// Copies the serialized contents of the pipeline cache into |data|.
+  Result GetPipelineCacheData(std::vector<uint8_t>* data) const;
+
+  /// Checks that the logical device this object holds can run a script
+  /// needing |required_features| and |required_extensions|. Used when a
+  /// device is kept alive and reused for a script other than the one it
+  /// was initialized for.
+  Result ValidateRequirements(
+      const std::vector<Feature>& required_features,
+      const std::vector<std::string>& required_extensions) const;
+
   VkInstance GetInstance() const { return instance_; }
+  VkPipelineCache GetPipelineCache() const { return pipeline_cache_; }
   VkPhysicalDevice GetPhysicalDevice() { return physical_device_; }
   VkDevice GetDevice() const { return device_; }
   VkPhysicalDevice GetPhysicalDevice() const { return physical_device_; }
   uint32_t GetQueueFamilyIndex() const { return queue_family_index_; }
   VkQueue GetQueue() const { return queue_; }
+
+  /// Number of queues created in the main queue family. More than one
+  /// lets independent pipelines submit to their own queue and overlap on
+  /// hardware that executes queues in parallel.
+  uint32_t GetQueueCount() const {
+    return queues_.empty() ? 1U : static_cast<uint32_t>(queues_.size());
+  }
+
+  /// Returns the |index| % GetQueueCount() queue of the main family, so
+  /// callers can round robin work over the available queues.
+  VkQueue GetQueue(uint32_t index) const {
+    return queues_.empty() ? queue_ : queues_[index % queues_.size()];
+  }
+
+  /// Returns true when the device was created with an additional queue
+  /// from a transfer-only queue family e.g., a DMA engine on discrete
+  /// GPUs. Copy traffic issued on it overlaps with work on the main
+  /// queue. Devices given from the outside never have one.
+  bool HasDedicatedTransferQueue() const {
+    return transfer_queue_ != VK_NULL_HANDLE;
+  }
+  uint32_t GetTransferQueueFamilyIndex() const {
+    return transfer_queue_family_index_;
+  }
+  VkQueue GetTransferQueue() const { return transfer_queue_; }
+
+  /// Returns true when the device exposes a memory type that is both
+  /// device local and host visible e.g., on integrated GPUs. Buffers
+  /// then live in device local memory the host writes directly, without
+  /// any staging copy.
+  bool HasUnifiedMemory() const { return has_unified_memory_; }
   const VkPhysicalDeviceProperties& GetPhysicalDeviceProperties() const {
     return physical_device_properties_;
   }
+
+  /// Returns true when the device was created with
+  /// VK_EXT_external_memory_host and the import alignment could be
+  /// queried. Suitably aligned host memory e.g., a mapped data file, can
+  /// then back a buffer directly instead of being copied into an
+  /// allocation.
+  bool SupportsHostPointerImport() const {
+    return host_pointer_import_supported_;
+  }
+
+  /// Alignment both the pointer and the size of imported host memory
+  /// must have. Zero until SupportsHostPointerImport() is true.
+  VkDeviceSize GetHostPointerImportAlignment() const {
+    return host_pointer_import_alignment_;
+  }
+
+  /// vkGetMemoryHostPointerPropertiesEXT, loaded only when
+  /// SupportsHostPointerImport() is true; null otherwise.
+  PFN_vkGetMemoryHostPointerPropertiesEXT GetMemoryHostPointerProperties()
+      const {
+    return vkGetMemoryHostPointerPropertiesEXT_;
+  }
+
+  /// Returns true when vkCmdDispatchBase could be loaded - the device
+  /// was created with VK_KHR_device_group - so a dispatch can be
+  /// recorded with a workgroup offset and data-parallel dispatches can
+  /// be split into slices.
+  bool SupportsDispatchBase() const { return vkCmdDispatchBaseKHR_ != nullptr; }
+
+  /// vkCmdDispatchBase, loaded only when SupportsDispatchBase() is true;
+  /// null otherwise.
+  PFN_vkCmdDispatchBaseKHR GetDispatchBase() const {
+    return vkCmdDispatchBaseKHR_;
+  }
+
+  /// Returns true when the device was created with the
+  /// pipelineStatisticsQuery feature, so shader invocation counts can be
+  /// collected alongside command timings.
+  bool SupportsPipelineStatisticsQuery() const {
+    return enabled_features_.pipelineStatisticsQuery == VK_TRUE;
+  }
   const VkPhysicalDeviceMemoryProperties& GetPhysicalMemoryProperties() const {
     return physical_memory_properties_;
   }
 
   const VulkanPtrs* GetPtrs() const { return &ptrs_; }
 
+  /// Sub-allocator all buffer and image memory on this device comes from.
+  MemoryAllocator* GetMemoryAllocator() const {
+    return memory_allocator_.get();
+  }
+
+  /// Pool of reusable staging buffers for host-device copies.
+  StagingBufferPool* GetStagingBufferPool() const {
+    return staging_buffer_pool_.get();
+  }
+
+  /// Cache of uploaded buffer content keyed by its bytes, shared across
+  /// pipelines and recipes.
+  BufferContentCache* GetBufferContentCache() const {
+    return buffer_content_cache_.get();
+  }
+
+  /// Cache of descriptor set layouts and pools shared across pipelines.
+  DescriptorPoolCache* GetDescriptorPoolCache() const {
+    return descriptor_pool_cache_.get();
+  }
+
+  /// Cache of render passes and framebuffers shared across pipelines.
+  RenderTargetCache* GetRenderTargetCache() const {
+    return render_target_cache_.get();
+  }
+
+  /// Cache of shader modules keyed by their SPIR-V, shared across recipes.
+  ShaderModuleCache* GetShaderModuleCache() const {
+    return shader_module_cache_.get();
+  }
+
+  /// Allocation callbacks pooling the driver's host allocations; handed
+  /// to every create and destroy of objects owned by this device.
+  const VkAllocationCallbacks* GetHostAllocator() const {
+    return host_allocator_.GetCallbacks();
+  }
+
  private:
   Result LoadVulkanGlobalPointers(PFN_vkGetInstanceProcAddr);
   Result LoadVulkanPointers(PFN_vkGetInstanceProcAddr);
   Result CreateInstance();
   Result CreateDebugReportCallback();
+  Result CreatePipelineCache();
+  Result CreateVkPipelineCache();
 
   // Get a physical device by checking if the physical device has a proper
   // queue family, required features, and required extensions. Note that
@@ -93,6 +231,16 @@ class Device {
   Result CreateDevice(const std::vector<Feature>& required_features,
                       const std::vector<std::string>& required_extensions);
 
+  // Query whether host memory can be imported as device memory and the
+  // alignment it needs. Leaves imports disabled when the extension was
+  // not enabled or the properties cannot be queried.
+  void SetupHostPointerImport(PFN_vkGetInstanceProcAddr getInstanceProcAddr);
+
+  // Load vkCmdDispatchBase when the device group extension was enabled.
+  // Leaves dispatch splitting disabled when it was not or the entry
+  // point cannot be resolved.
+  void SetupGroupDispatch(PFN_vkGetInstanceProcAddr getInstanceProcAddr);
+
   std::vector<std::string> GetAvailableExtensions(
       const VkPhysicalDevice& physical_device);
   Result AreAllValidationLayersSupported();
@@ -104,11 +252,50 @@ class Device {
   VkPhysicalDeviceProperties physical_device_properties_;
   VkPhysicalDeviceMemoryProperties physical_memory_properties_;
   VkPhysicalDeviceFeatures available_physical_device_features_;
+  // One bit per VkPhysicalDeviceFeatures member, in Feature enum order,
+  // computed once when the physical device is picked; a recipe's feature
+  // requirements then check as a single mask AND.
+  uint64_t available_features_mask_ = 0;
   std::vector<std::string> available_physical_device_extensions_;
+  // Features and extensions the logical device was actually created with;
+  // later scripts reusing this device must fit inside them.
+  VkPhysicalDeviceFeatures enabled_features_;
+  uint64_t enabled_features_mask_ = 0;
+  std::vector<std::string> enabled_extensions_;
   uint32_t queue_family_index_ = 0;
+  // Number of queues the chosen main queue family provides, capped at
+  // kMaxQueuesPerFamily. The logical device is created with all of them.
+  uint32_t queue_count_ = 1;
+  uint32_t transfer_queue_family_index_ = 0;
+  bool has_transfer_queue_family_ = false;
+  bool has_unified_memory_ = false;
+  bool host_pointer_import_supported_ = false;
+  VkDeviceSize host_pointer_import_alignment_ = 0;
+  PFN_vkGetMemoryHostPointerPropertiesEXT vkGetMemoryHostPointerPropertiesEXT_ =
+      nullptr;
+  PFN_vkCmdDispatchBaseKHR vkCmdDispatchBaseKHR_ = nullptr;
   VkDevice device_ = VK_NULL_HANDLE;
+  VkPipelineCache pipeline_cache_ = VK_NULL_HANDLE;
+  /// True when |pipeline_cache_| is shared with other Device objects
+  /// wrapping the same externally provided VkDevice.
+  bool pipeline_cache_shared_ = false;
+  std::vector<uint8_t> initial_pipeline_cache_data_;
+  std::unique_ptr<MemoryAllocator> memory_allocator_;
+  std::unique_ptr<StagingBufferPool> staging_buffer_pool_;
+  std::unique_ptr<BufferContentCache> buffer_content_cache_;
+  std::unique_ptr<DescriptorPoolCache> descriptor_pool_cache_;
+  std::unique_ptr<RenderTargetCache> render_target_cache_;
+  std::unique_ptr<ShaderModuleCache> shader_module_cache_;
+  // Must outlive every device child object created with its callbacks;
+  // Shutdown() destroys them all before the Device goes away.
+  HostAllocator host_allocator_;
 
   VkQueue queue_ = VK_NULL_HANDLE;
+  // All queues retrieved from the main queue family; |queue_| is the
+  // first of them. Empty when the device was provided from the outside,
+  // which only hands us a single queue.
+  std::vector<VkQueue> queues_;
+  VkQueue transfer_queue_ = VK_NULL_HANDLE;
 
   bool destroy_device_ = true;
 
@@ -16,9 +16,12 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <utility>
 
 #include "amber/amber_vulkan.h"
 #include "src/make_unique.h"
+#include "src/profiler.h"
 #include "src/vulkan/compute_pipeline.h"
 #include "src/vulkan/descriptor.h"
 #include "src/vulkan/format_data.h"
@@ -31,6 +34,11 @@ namespace {
 const uint32_t kFramebufferWidth = 250;
 const uint32_t kFramebufferHeight = 250;
 
+// Number of four vertex slots in the quad buffer used by DoDrawRect().
+// When every slot was handed to a recorded draw, the batched commands
+// are submitted and the slots are reused from the beginning.
+const uint32_t kRectVertexSlots = 512;
+
 VkShaderStageFlagBits ToVkShaderStage(ShaderType type) {
   switch (type) {
     case kShaderTypeGeometry:
@@ -63,34 +71,46 @@ EngineVulkan::~EngineVulkan() = default;
 Result EngineVulkan::Initialize(EngineConfig* config,
                                 const std::vector<Feature>& features,
                                 const std::vector<std::string>& extensions) {
-  if (device_)
-    return Result("Vulkan::Initialize device_ already exists");
-
-  VulkanEngineConfig* vk_config = static_cast<VulkanEngineConfig*>(config);
-  if (!vk_config || vk_config->vkGetInstanceProcAddr == VK_NULL_HANDLE)
-    return Result("Vulkan::Initialize vkGetInstanceProcAddr must be provided.");
-
-  // If the device is provided, the physical_device and queue are also required.
-  if (vk_config->device != VK_NULL_HANDLE) {
-    if (vk_config->physical_device == VK_NULL_HANDLE)
-      return Result("Vulkan::Initialize physical device handle is null.");
-    if (vk_config->queue == VK_NULL_HANDLE)
-      return Result("Vulkan::Initialize queue handle is null.");
-
-    device_ = MakeUnique<Device>(
-        vk_config->instance, vk_config->physical_device,
-        vk_config->available_features, vk_config->available_extensions,
-        vk_config->queue_family_index, vk_config->device, vk_config->queue);
+  if (device_) {
+    // Initialize() was called before; the engine is being reused for another
+    // script. Keep the instance, device, command pool and pipeline cache
+    // warm, drop everything tied to the previous script and check the new
+    // script's requirements against the device we already have.
+    DestroyPerScriptObjects();
+
+    Result r = device_->ValidateRequirements(features, extensions);
+    if (!r.IsSuccess())
+      return r;
   } else {
-    device_ = MakeUnique<Device>();
-  }
+    VulkanEngineConfig* vk_config = static_cast<VulkanEngineConfig*>(config);
+    if (!vk_config || vk_config->vkGetInstanceProcAddr == VK_NULL_HANDLE)
+      return Result(
+          "Vulkan::Initialize vkGetInstanceProcAddr must be provided.");
+
+    // If the device is provided, the physical_device and queue are also
+    // required.
+    if (vk_config->device != VK_NULL_HANDLE) {
+      if (vk_config->physical_device == VK_NULL_HANDLE)
+        return Result("Vulkan::Initialize physical device handle is null.");
+      if (vk_config->queue == VK_NULL_HANDLE)
+        return Result("Vulkan::Initialize queue handle is null.");
+
+      device_ = MakeUnique<Device>(
+          vk_config->instance, vk_config->physical_device,
+          vk_config->available_features, vk_config->available_extensions,
+          vk_config->queue_family_index, vk_config->device, vk_config->queue);
+    } else {
+      device_ = MakeUnique<Device>();
+    }
 
-  Result r = device_->Initialize(vk_config->vkGetInstanceProcAddr, features,
-                                 extensions);
-  if (!r.IsSuccess())
-    return r;
+    device_->SetInitialPipelineCacheData(std::move(pipeline_cache_data_));
+    pipeline_cache_data_.clear();
+
+    Result r = device_->Initialize(vk_config->vkGetInstanceProcAddr, features,
+                                   extensions);
+    if (!r.IsSuccess())
+      return r;
 
-  if (!pool_) {
     pool_ = MakeUnique<CommandPool>(device_.get());
     r = pool_->Initialize(device_->GetQueueFamilyIndex());
     if (!r.IsSuccess())
@@ -120,65 +140,161 @@ Result EngineVulkan::Shutdown() {
   if (!device_)
     return {};
 
+  DestroyPerScriptObjects();
+
+  if (pool_) {
+    pool_->Shutdown();
+    pool_.reset();
+  }
+
+  device_->Shutdown();
+  device_.reset();
+  return {};
+}
+
+void EngineVulkan::DestroyPerScriptObjects() {
+  // Modules are owned by the device's cache; dropping the references
+  // keeps them alive for the next recipe on a persistent device.
+  auto* module_cache = device_->GetShaderModuleCache();
   for (auto it = modules_.begin(); it != modules_.end(); ++it) {
-    auto vk_device = device_->GetDevice();
-    if (vk_device != VK_NULL_HANDLE && it->second != VK_NULL_HANDLE)
-      device_->GetPtrs()->vkDestroyShaderModule(vk_device, it->second, nullptr);
+    if (module_cache && it->second != VK_NULL_HANDLE)
+      module_cache->ReleaseShaderModule(it->second);
   }
+  modules_.clear();
 
-  if (pipeline_)
-    pipeline_->Shutdown();
+  for (auto module : retired_modules_) {
+    if (module_cache && module != VK_NULL_HANDLE)
+      module_cache->ReleaseShaderModule(module);
+  }
+  retired_modules_.clear();
 
-  if (vertex_buffer_)
+  for (auto& pipeline : pipelines_)
+    pipeline->Shutdown();
+  pipelines_.clear();
+  pipeline_ = nullptr;
+
+  if (vertex_buffer_) {
     vertex_buffer_->Shutdown();
+    vertex_buffer_.reset();
+  }
 
-  if (pool_)
-    pool_->Shutdown();
+  if (rect_vertex_buffer_) {
+    rect_vertex_buffer_->Shutdown();
+    rect_vertex_buffer_.reset();
+    next_rect_slot_ = 0;
+  }
+}
 
-  device_->Shutdown();
+Result EngineVulkan::SetPipelineCacheData(const std::vector<uint8_t>& data) {
+  if (device_)
+    return Result("Vulkan::SetPipelineCacheData must be called before "
+                  "Initialize");
+
+  pipeline_cache_data_ = data;
   return {};
 }
 
+Result EngineVulkan::GetPipelineCacheData(std::vector<uint8_t>* data) {
+  if (!device_)
+    return Result("Vulkan::GetPipelineCacheData device_ does not exist");
+
+  return device_->GetPipelineCacheData(data);
+}
+
 Result EngineVulkan::CreatePipeline(PipelineType type) {
+  ScopedPhaseTimer timer("EngineVulkan::CreatePipeline");
+
   const auto& engine_data = GetEngineData();
 
+  // Each pipeline submits to its own queue, round robin over the ones
+  // the device exposes, so independent pipelines can overlap.
+  const auto queue =
+      device_->GetQueue(static_cast<uint32_t>(pipelines_.size()));
+
+  std::unique_ptr<Pipeline> pipeline;
+  Result r;
   if (type == PipelineType::kCompute) {
-    pipeline_ = MakeUnique<ComputePipeline>(
+    pipeline = MakeUnique<ComputePipeline>(
         device_.get(), device_->GetPhysicalDeviceProperties(),
         device_->GetPhysicalMemoryProperties(), engine_data.fence_timeout_ms,
         GetShaderStageInfo());
-    return pipeline_->AsCompute()->Initialize(pool_->GetCommandPool(),
-                                              device_->GetQueue());
+    r = pipeline->AsCompute()->Initialize(pool_->GetCommandPool(), queue);
+  } else {
+    pipeline = MakeUnique<GraphicsPipeline>(
+        device_.get(), device_->GetPhysicalDeviceProperties(),
+        device_->GetPhysicalMemoryProperties(),
+        ToVkFormat(color_frame_format_->GetFormatType()),
+        ToVkFormat(depth_frame_format_->GetFormatType()),
+        engine_data.fence_timeout_ms, GetShaderStageInfo());
+    r = pipeline->AsGraphics()->Initialize(kFramebufferWidth,
+                                           kFramebufferHeight,
+                                           pool_->GetCommandPool(), queue);
+  }
+  if (!r.IsSuccess())
+    return r;
+
+  // The new pipeline snapshotted the shader stages; retire the modules so
+  // the next pipeline starts with its own set.
+  for (auto it : modules_)
+    retired_modules_.push_back(it.second);
+  modules_.clear();
+
+  pipeline->SetCommandTimingEnabled(command_timing_enabled_);
+
+  pipelines_.push_back(std::move(pipeline));
+  pipeline_ = pipelines_.back().get();
+  return {};
+}
+
+void EngineVulkan::SetCommandTimingEnabled(bool enabled) {
+  command_timing_enabled_ = enabled;
+  for (auto& pipeline : pipelines_)
+    pipeline->SetCommandTimingEnabled(enabled);
+}
+
+Result EngineVulkan::GetCommandTimings(std::vector<CommandTiming>* timings) {
+  for (auto& pipeline : pipelines_) {
+    const auto& pipeline_timings = pipeline->GetCommandTimings();
+    timings->insert(timings->end(), pipeline_timings.begin(),
+                    pipeline_timings.end());
   }
+  return {};
+}
 
-  pipeline_ = MakeUnique<GraphicsPipeline>(
-      device_.get(), device_->GetPhysicalDeviceProperties(),
-      device_->GetPhysicalMemoryProperties(),
-      ToVkFormat(color_frame_format_->GetFormatType()),
-      ToVkFormat(depth_frame_format_->GetFormatType()),
-      engine_data.fence_timeout_ms, GetShaderStageInfo());
+Result EngineVulkan::GetMemoryUsage(std::vector<MemoryHeapUsage>* usage) {
+  if (!device_)
+    return {};
 
-  return pipeline_->AsGraphics()->Initialize(
-      kFramebufferWidth, kFramebufferHeight, pool_->GetCommandPool(),
-      device_->GetQueue());
+  const auto& heap_stats = device_->GetMemoryAllocator()->GetHeapStats();
+  for (uint32_t i = 0; i < heap_stats.size(); ++i) {
+    const auto& stats = heap_stats[i];
+    if (stats.peak_block_bytes == 0)
+      continue;
+
+    MemoryHeapUsage heap;
+    heap.heap_index = i;
+    heap.live_bytes = stats.live_block_bytes;
+    heap.peak_bytes = stats.peak_block_bytes;
+    heap.peak_buffer_bytes = stats.peak_buffer_bytes;
+    heap.peak_image_bytes = stats.peak_image_bytes;
+    usage->push_back(heap);
+  }
+  return {};
 }
 
 Result EngineVulkan::SetShader(ShaderType type,
                                const std::vector<uint32_t>& data) {
-  VkShaderModuleCreateInfo info = VkShaderModuleCreateInfo();
-  info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-  info.codeSize = data.size() * sizeof(uint32_t);
-  info.pCode = data.data();
-
   auto it = modules_.find(type);
   if (it != modules_.end())
     return Result("Vulkan::Setting Duplicated Shader Types Fail");
 
+  // The device's cache creates the module on first sight of this SPIR-V;
+  // batch runs setting the same binary for every recipe get the module
+  // it already built.
   VkShaderModule shader;
-  if (device_->GetPtrs()->vkCreateShaderModule(
-          device_->GetDevice(), &info, nullptr, &shader) != VK_SUCCESS) {
-    return Result("Vulkan::Calling vkCreateShaderModule Fail");
-  }
+  Result r = device_->GetShaderModuleCache()->GetShaderModule(data, &shader);
+  if (!r.IsSuccess())
+    return r;
 
   modules_[type] = shader;
   return {};
@@ -200,10 +316,12 @@ EngineVulkan::GetShaderStageInfo() {
   return stage_info;
 }
 
-Result EngineVulkan::SetBuffer(BufferType type,
-                               uint8_t location,
-                               const Format& format,
-                               const std::vector<Value>& values) {
+Result EngineVulkan::SetBuffer(Buffer* buffer) {
+  const BufferType type = buffer->GetBufferType();
+  const Format format = buffer->IsFormatBuffer()
+                            ? buffer->AsFormatBuffer()->GetFormat()
+                            : Format();
+
   auto format_type = ToVkFormat(format.GetFormatType());
   if (type != BufferType::kIndex &&
       !IsFormatSupportedByPhysicalDevice(type, device_->GetPhysicalDevice(),
@@ -232,13 +350,24 @@ Result EngineVulkan::SetBuffer(BufferType type,
     if (!vertex_buffer_)
       vertex_buffer_ = MakeUnique<VertexBuffer>(device_.get());
 
-    pipeline_->AsGraphics()->SetVertexBuffer(location, format, values,
-                                             vertex_buffer_.get());
+    // The packed bytes are already in the format's encoding, so the
+    // vertex buffer interleaves them with plain copies instead of
+    // re-encoding a Value per component at draw time.
+    pipeline_->AsGraphics()->SetVertexBuffer(buffer->GetLocation(), format,
+                                             buffer->GetBytes(),
+                                             vertex_buffer_.get(),
+                                             buffer->IsInputRateInstance());
+
+    // The vertex buffer copied the packed bytes; free the script's Value
+    // form so only one host representation of the data stays live. The
+    // packed form is kept on the script buffer for other engines sharing
+    // the script.
+    buffer->ReleaseValues();
     return {};
   }
 
   if (type == BufferType::kIndex) {
-    pipeline_->AsGraphics()->SetIndexBuffer(values);
+    pipeline_->AsGraphics()->SetIndexBuffer(buffer->GetData());
     return {};
   }
 
@@ -271,18 +400,17 @@ Result EngineVulkan::DoClear(const ClearCommand*) {
   if (!pipeline_->IsGraphics())
     return Result("Vulkan::Clear Command for Non-Graphics Pipeline");
 
+  if (pipeline_->IsReplaying()) {
+    pipeline_->SkipReplayedRecording();
+    return {};
+  }
+
   return pipeline_->AsGraphics()->Clear();
 }
 
-Result EngineVulkan::DoDrawRect(const DrawRectCommand* command) {
-  if (!pipeline_->IsGraphics())
-    return Result("Vulkan::DrawRect for Non-Graphics Pipeline");
-
-  auto* graphics = pipeline_->AsGraphics();
-
-  Result r = graphics->ResetPipeline();
-  if (!r.IsSuccess())
-    return r;
+Result EngineVulkan::EnsureRectVertexBuffer(GraphicsPipeline* graphics) {
+  if (rect_vertex_buffer_)
+    return {};
 
   // |format| is not Format for frame buffer but for vertex buffer.
   // Since draw rect command contains its vertex information and it
@@ -293,6 +421,50 @@ Result EngineVulkan::DoDrawRect(const DrawRectCommand* command) {
   format.AddComponent(FormatComponentType::kR, FormatMode::kSFloat, 32);
   format.AddComponent(FormatComponentType::kG, FormatMode::kSFloat, 32);
 
+  rect_vertex_buffer_ = MakeUnique<VertexBuffer>(device_.get());
+  // Every DrawRect rewrites a slot of this buffer with UpdateData(), so
+  // the host-side Values must outlive the upload.
+  rect_vertex_buffer_->RetainHostData();
+  next_rect_slot_ = 0;
+
+  std::vector<Value> initial_values(8 * kRectVertexSlots);
+  for (auto& value : initial_values)
+    value.SetDoubleValue(0.0);
+
+  return graphics->SetVertexBuffer(0, format, initial_values,
+                                   rect_vertex_buffer_.get());
+}
+
+Result EngineVulkan::DoDrawRect(const DrawRectCommand* command) {
+  if (!pipeline_->IsGraphics())
+    return Result("Vulkan::DrawRect for Non-Graphics Pipeline");
+
+  auto* graphics = pipeline_->AsGraphics();
+
+  // The preserved draws read the quad slots written by the captured
+  // iteration; the values only depend on the command, so resubmitting
+  // them draws the same rect without touching the buffer.
+  if (graphics->IsReplaying()) {
+    graphics->SkipReplayedRecording();
+    return {};
+  }
+
+  Result r = EnsureRectVertexBuffer(graphics);
+  if (!r.IsSuccess())
+    return r;
+
+  if (next_rect_slot_ >= kRectVertexSlots) {
+    // Every slot was handed to a recorded draw; complete them before
+    // overwriting the first slot again. Overwriting also invalidates any
+    // preserved draws still referencing the recycled slots.
+    graphics->DisableReplay();
+    r = graphics->ProcessCommands();
+    if (!r.IsSuccess())
+      return r;
+
+    next_rect_slot_ = 0;
+  }
+
   float x = command->GetX();
   float y = command->GetY();
   float width = command->GetWidth();
@@ -320,44 +492,118 @@ Result EngineVulkan::DoDrawRect(const DrawRectCommand* command) {
   values[6].SetDoubleValue(static_cast<double>(x + width));
   values[7].SetDoubleValue(static_cast<double>(y));
 
-  auto vertex_buffer = MakeUnique<VertexBuffer>(device_.get());
-
-  r = graphics->SetVertexBuffer(0, format, values, vertex_buffer.get());
+  r = rect_vertex_buffer_->UpdateData(
+      0, static_cast<size_t>(8) * next_rect_slot_, values);
   if (!r.IsSuccess())
     return r;
 
   DrawArraysCommand draw(*command->GetPipelineData());
   draw.SetTopology(command->IsPatch() ? Topology::kPatchList
                                       : Topology::kTriangleStrip);
-  draw.SetFirstVertexIndex(0);
+  draw.SetFirstVertexIndex(4 * next_rect_slot_);
   draw.SetVertexCount(4);
   draw.SetInstanceCount(1);
+  ++next_rect_slot_;
+
+  return graphics->Draw(&draw, rect_vertex_buffer_.get());
+}
+
+Result EngineVulkan::DoDrawArrays(const DrawArraysCommand* command) {
+  if (!pipeline_->IsGraphics())
+    return Result("Vulkan::DrawArrays for Non-Graphics Pipeline");
+
+  if (pipeline_->IsReplaying()) {
+    pipeline_->SkipReplayedRecording();
+    return {};
+  }
 
-  r = graphics->Draw(&draw, vertex_buffer.get());
+  Result r = pipeline_->RecordTimestampBegin();
   if (!r.IsSuccess())
     return r;
 
-  r = graphics->ResetPipeline();
+  r = pipeline_->AsGraphics()->Draw(command, vertex_buffer_.get());
   if (!r.IsSuccess())
     return r;
 
-  vertex_buffer->Shutdown();
-  return {};
+  return pipeline_->RecordTimestampEnd("DrawArrays");
 }
 
-Result EngineVulkan::DoDrawArrays(const DrawArraysCommand* command) {
+Result EngineVulkan::DoDrawArraysBatch(
+    const std::vector<const DrawArraysCommand*>& commands) {
   if (!pipeline_->IsGraphics())
     return Result("Vulkan::DrawArrays for Non-Graphics Pipeline");
 
-  return pipeline_->AsGraphics()->Draw(command, vertex_buffer_.get());
+  // The whole run was one flush-free stretch when it was captured, so
+  // one skip covers it.
+  if (pipeline_->IsReplaying()) {
+    pipeline_->SkipReplayedRecording();
+    return {};
+  }
+
+  // Per command GPU timing needs a timestamp pair around every single
+  // draw, which parallel recording cannot bracket; keep the serial path.
+  if (command_timing_enabled_)
+    return Engine::DoDrawArraysBatch(commands);
+
+  return pipeline_->AsGraphics()->DrawBatch(commands, vertex_buffer_.get());
+}
+
+Result EngineVulkan::DoPrewarm(const Command* cmd) {
+  if (!pipeline_)
+    return Result("Vulkan::DoPrewarm no Pipeline exists");
+
+  switch (cmd->GetType()) {
+    case Command::Type::kDrawArrays:
+      if (!pipeline_->IsGraphics())
+        return Result("Vulkan::DrawArrays for Non-Graphics Pipeline");
+      return pipeline_->AsGraphics()->Prewarm(cmd->AsDrawArrays(),
+                                              vertex_buffer_.get());
+    case Command::Type::kDrawRect: {
+      if (!pipeline_->IsGraphics())
+        return Result("Vulkan::DrawRect for Non-Graphics Pipeline");
+
+      auto* graphics = pipeline_->AsGraphics();
+      Result r = EnsureRectVertexBuffer(graphics);
+      if (!r.IsSuccess())
+        return r;
+
+      // Mirror the draw DoDrawRect() will issue so the pipeline is keyed
+      // to the same state, including the shared rect vertex buffer.
+      const auto* rect = cmd->AsDrawRect();
+      DrawArraysCommand draw(*rect->GetPipelineData());
+      draw.SetTopology(rect->IsPatch() ? Topology::kPatchList
+                                       : Topology::kTriangleStrip);
+      return graphics->Prewarm(&draw, rect_vertex_buffer_.get());
+    }
+    case Command::Type::kCompute:
+      if (pipeline_->IsGraphics())
+        return Result("Vulkan: Compute called for graphics pipeline.");
+      return pipeline_->AsCompute()->Prewarm();
+    default:
+      return {};
+  }
 }
 
 Result EngineVulkan::DoCompute(const ComputeCommand* command) {
   if (pipeline_->IsGraphics())
     return Result("Vulkan: Compute called for graphics pipeline.");
 
-  return pipeline_->AsCompute()->Compute(command->GetX(), command->GetY(),
-                                         command->GetZ());
+  if (pipeline_->IsReplaying()) {
+    pipeline_->SkipReplayedRecording();
+    return {};
+  }
+
+  Result r = pipeline_->RecordTimestampBegin();
+  if (!r.IsSuccess())
+    return r;
+
+  r = pipeline_->AsCompute()->Compute(command->GetX(), command->GetY(),
+                                      command->GetZ(),
+                                      command->IsDataParallel());
+  if (!r.IsSuccess())
+    return r;
+
+  return pipeline_->RecordTimestampEnd("Compute");
 }
 
 Result EngineVulkan::DoEntryPoint(const EntryPointCommand* command) {
@@ -378,18 +624,103 @@ Result EngineVulkan::DoPatchParameterVertices(
   return {};
 }
 
+Result EngineVulkan::BeginRepeatIteration() {
+  for (auto& pipeline : pipelines_)
+    pipeline->BeginRepeatIteration();
+  return {};
+}
+
+Result EngineVulkan::EndRepeatIteration() {
+  for (auto& pipeline : pipelines_) {
+    Result r = pipeline->EndRepeatIteration();
+    if (!r.IsSuccess())
+      return r;
+  }
+  return {};
+}
+
 Result EngineVulkan::DoProcessCommands() {
-  return pipeline_->ProcessCommands();
+  // Complete pending work of every pipeline, not only the active one, so
+  // a read back observes everything submitted across the queues.
+  for (auto& pipeline : pipelines_) {
+    Result r = pipeline->ProcessCommands();
+    if (!r.IsSuccess())
+      return r;
+  }
+  return {};
 }
 
-Result EngineVulkan::GetFrameBufferInfo(ResourceInfo* info) {
+Result EngineVulkan::GetFrameBufferInfo(const ProbeCommand* probe,
+                                        ResourceInfo* info) {
   assert(info);
 
   if (!pipeline_->IsGraphics())
     return Result("Vulkan::GetFrameBufferInfo for Non-Graphics Pipeline");
 
   const auto graphics = pipeline_->AsGraphics();
+
+  // A probe without a prior draw or clear still reads the framebuffer;
+  // make sure it exists.
+  Result ensure_result = graphics->EnsureRenderTarget();
+  if (!ensure_result.IsSuccess())
+    return ensure_result;
+
   const auto frame = graphics->GetFrame();
+
+  // Copy only the rows of the framebuffer the probe will read; a probe of
+  // a single pixel does not need the whole attachment transferred to the
+  // host. No probe or a whole window probe reads everything.
+  uint32_t row_begin = 0;
+  uint32_t row_count = frame->GetHeight();
+  if (probe && !probe->IsWholeWindow()) {
+    if (probe->IsRelative()) {
+      row_begin = static_cast<uint32_t>(
+          static_cast<float>(frame->GetHeight()) * probe->GetY());
+      if (probe->IsProbeRect()) {
+        row_count = static_cast<uint32_t>(
+            static_cast<float>(frame->GetHeight()) * probe->GetHeight());
+      } else {
+        row_count = 1;
+      }
+    } else {
+      row_begin = static_cast<uint32_t>(probe->GetY());
+      row_count = probe->IsProbeRect()
+                      ? static_cast<uint32_t>(probe->GetHeight())
+                      : 1;
+    }
+
+    // An out of range probe is reported by the verifier; keep the copy
+    // inside the image so the command itself stays valid.
+    if (row_begin >= frame->GetHeight()) {
+      row_begin = 0;
+      row_count = frame->GetHeight();
+    } else if (row_begin + row_count > frame->GetHeight()) {
+      row_count = frame->GetHeight() - row_begin;
+    }
+  }
+
+  // The captured iteration preserved the copy recorded here and the
+  // probe reads the same rows each time; the flush below resubmits the
+  // preserved copy instead of recording it again.
+  if (graphics->IsReplaying()) {
+    graphics->SkipReplayedRecording();
+  } else {
+    Result copy_result =
+        graphics->CopyColorFrameBufferToHost(row_begin, row_count);
+    if (!copy_result.IsSuccess())
+      return copy_result;
+  }
+
+  // Draws and the copy of the framebuffer to host memory may still be
+  // sitting in the command buffer; make them complete before reading.
+  Result r = pipeline_->ProcessCommands();
+  if (!r.IsSuccess())
+    return r;
+
+  r = frame->InvalidateColorImageMemory();
+  if (!r.IsSuccess())
+    return r;
+
   const auto bytes_per_texel = color_frame_format_->GetByteSize();
   info->type = ResourceInfoType::kImage;
   info->image_info.width = frame->GetWidth();
@@ -412,7 +743,7 @@ Result EngineVulkan::GetFrameBuffer(std::vector<Value>* values) {
   values->resize(0);
 
   ResourceInfo info;
-  GetFrameBufferInfo(&info);
+  GetFrameBufferInfo(nullptr, &info);
   if (info.type != ResourceInfoType::kImage) {
     return Result(
         "Vulkan:GetFrameBuffer() is invalid for non-image framebuffer");
@@ -439,12 +770,58 @@ Result EngineVulkan::GetFrameBuffer(std::vector<Value>* values) {
   return {};
 }
 
+Result EngineVulkan::GetFrameBufferData(void* dst, size_t row_stride) {
+  ResourceInfo info;
+  Result r = GetFrameBufferInfo(nullptr, &info);
+  if (!r.IsSuccess())
+    return r;
+
+  if (info.type != ResourceInfoType::kImage) {
+    return Result(
+        "Vulkan:GetFrameBufferData() is invalid for non-image framebuffer");
+  }
+
+  const size_t row_bytes = info.image_info.row_stride;
+  if (row_stride < row_bytes)
+    return Result("Vulkan:GetFrameBufferData() row stride is too small");
+
+  const uint8_t* src = static_cast<const uint8_t*>(info.cpu_memory);
+  uint8_t* dst_bytes = static_cast<uint8_t*>(dst);
+  for (uint32_t y = 0; y < info.image_info.height; ++y)
+    std::memcpy(dst_bytes + row_stride * y, src + row_bytes * y, row_bytes);
+
+  return {};
+}
+
 Result EngineVulkan::GetDescriptorInfo(const uint32_t descriptor_set,
                                        const uint32_t binding,
                                        ResourceInfo* info) {
   return pipeline_->GetDescriptorInfo(descriptor_set, binding, info);
 }
 
+Result EngineVulkan::SetDescriptorReadbackWindow(uint32_t descriptor_set,
+                                                 uint32_t binding,
+                                                 uint64_t offset,
+                                                 uint64_t size) {
+  if (pipeline_) {
+    pipeline_->SetDescriptorReadbackWindow(descriptor_set, binding, offset,
+                                           size);
+  }
+  return {};
+}
+
+Result EngineVulkan::DoVerifyProbeSSBOOnDevice(const ProbeSSBOCommand*,
+                                               bool* verified) {
+  // Descriptor buffers in this engine are bound to host visible, host
+  // coherent memory, so the host-side Verifier already reads the shader's
+  // writes in place; there is no bus transfer for a device-side compare
+  // to save. Engines that move descriptors into device local storage
+  // should dispatch their compare kernel here instead of reporting
+  // unsupported.
+  *verified = false;
+  return {};
+}
+
 Result EngineVulkan::DoBuffer(const BufferCommand* command) {
   if (command->IsPushConstant())
     return pipeline_->AddPushConstant(command);
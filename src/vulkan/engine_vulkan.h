@@ -41,32 +41,55 @@ class EngineVulkan : public Engine {
                     const std::vector<Feature>& features,
                     const std::vector<std::string>& extensions) override;
   Result Shutdown() override;
+  Result SetPipelineCacheData(const std::vector<uint8_t>& data) override;
+  Result GetPipelineCacheData(std::vector<uint8_t>* data) override;
+  void SetCommandTimingEnabled(bool enabled) override;
+  Result GetCommandTimings(std::vector<CommandTiming>* timings) override;
+  Result GetMemoryUsage(std::vector<MemoryHeapUsage>* usage) override;
   Result CreatePipeline(PipelineType type) override;
   Result SetShader(ShaderType type, const std::vector<uint32_t>& data) override;
-  Result SetBuffer(BufferType type,
-                   uint8_t location,
-                   const Format& format,
-                   const std::vector<Value>& data) override;
+  Result SetBuffer(Buffer* buffer) override;
   Result DoClearColor(const ClearColorCommand* cmd) override;
   Result DoClearStencil(const ClearStencilCommand* cmd) override;
   Result DoClearDepth(const ClearDepthCommand* cmd) override;
   Result DoClear(const ClearCommand* cmd) override;
   Result DoDrawRect(const DrawRectCommand* cmd) override;
   Result DoDrawArrays(const DrawArraysCommand* cmd) override;
+  Result DoDrawArraysBatch(
+      const std::vector<const DrawArraysCommand*>& cmds) override;
+  Result DoPrewarm(const Command* cmd) override;
   Result DoCompute(const ComputeCommand* cmd) override;
   Result DoEntryPoint(const EntryPointCommand* cmd) override;
   Result DoPatchParameterVertices(
       const PatchParameterVerticesCommand* cmd) override;
   Result DoBuffer(const BufferCommand* cmd) override;
+  Result BeginRepeatIteration() override;
+  Result EndRepeatIteration() override;
   Result DoProcessCommands() override;
-  Result GetFrameBufferInfo(ResourceInfo* info) override;
+  Result GetFrameBufferInfo(const ProbeCommand* probe,
+                            ResourceInfo* info) override;
   Result GetFrameBuffer(std::vector<Value>* values) override;
+  Result GetFrameBufferData(void* dst, size_t row_stride) override;
   Result GetDescriptorInfo(const uint32_t descriptor_set,
                            const uint32_t binding,
                            ResourceInfo* info) override;
+  Result SetDescriptorReadbackWindow(uint32_t descriptor_set,
+                                     uint32_t binding,
+                                     uint64_t offset,
+                                     uint64_t size) override;
+  Result DoVerifyProbeSSBOOnDevice(const ProbeSSBOCommand* cmd,
+                                   bool* verified) override;
 
  private:
+  // Destroys the shader modules, pipeline and vertex buffer created for the
+  // current script while leaving the device, command pool and pipeline cache
+  // intact, so the engine can run another script.
+  void DestroyPerScriptObjects();
+
   std::vector<VkPipelineShaderStageCreateInfo> GetShaderStageInfo();
+  // Creates |rect_vertex_buffer_| and registers it with |graphics| on
+  // first use; DoDrawRect() and DoPrewarm() share it.
+  Result EnsureRectVertexBuffer(GraphicsPipeline* graphics);
   bool IsFormatSupportedByPhysicalDevice(BufferType type,
                                          VkPhysicalDevice physical_device,
                                          VkFormat format);
@@ -75,13 +98,40 @@ class EngineVulkan : public Engine {
 
   std::unique_ptr<Device> device_;
   std::unique_ptr<CommandPool> pool_;
-  std::unique_ptr<Pipeline> pipeline_;
+
+  // Pipelines created for the current script. Every pipeline owns its
+  // own descriptor state and command buffers and is handed its own
+  // device queue, round robin, so independent pipelines can execute in
+  // parallel on hardware with multiple queues. |pipeline_| is the one
+  // commands currently apply to: the most recently created.
+  std::vector<std::unique_ptr<Pipeline>> pipelines_;
+  Pipeline* pipeline_ = nullptr;
+
+  // When true, every pipeline brackets its draws and dispatches with GPU
+  // timestamp query pairs.
+  bool command_timing_enabled_ = false;
+
   std::unique_ptr<VertexBuffer> vertex_buffer_;
 
+  // Persistent quad buffer DoDrawRect() writes rectangle coordinates
+  // into. Each rect takes its own four vertex slot so draws already
+  // recorded in the command buffer keep their coordinates.
+  std::unique_ptr<VertexBuffer> rect_vertex_buffer_;
+  uint32_t next_rect_slot_ = 0;
+
+  // Shader modules set since the last CreatePipeline() call; creating a
+  // pipeline consumes them so the next pipeline starts from a clean
+  // slate. Consumed modules move to |retired_modules_| until the per
+  // script objects are destroyed.
   std::unordered_map<ShaderType, VkShaderModule, CastHash<ShaderType>> modules_;
+  std::vector<VkShaderModule> retired_modules_;
 
   std::unique_ptr<Format> color_frame_format_;
   std::unique_ptr<Format> depth_frame_format_;
+
+  // Seed for the device's pipeline cache, held until Initialize() creates
+  // the device.
+  std::vector<uint8_t> pipeline_cache_data_;
 };
 
 }  // namespace vulkan
@@ -23,6 +23,9 @@ namespace vulkan {
 
 VkFormat ToVkFormat(FormatType type);
 uint32_t VkFormatToByteSize(VkFormat format);
+// Return the image aspects |format| carries e.g., color, or depth and
+// stencil. Returns 0 for formats Amber does not produce.
+VkImageAspectFlags VkFormatToAspectFlags(VkFormat format);
 bool VkFormatHasStencilComponent(VkFormat format);
 
 }  // namespace vulkan
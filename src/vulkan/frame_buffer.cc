@@ -49,13 +49,10 @@ Result FrameBuffer::Initialize(
   }
 
   if (depth_format != VK_FORMAT_UNDEFINED) {
-    depth_image_ = MakeUnique<Image>(
-        device_, depth_format,
-        static_cast<VkImageAspectFlags>(
-            VkFormatHasStencilComponent(depth_format)
-                ? VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT
-                : VK_IMAGE_ASPECT_DEPTH_BIT),
-        width_, height_, depth_, properties);
+    depth_image_ =
+        MakeUnique<Image>(device_, depth_format,
+                          VkFormatToAspectFlags(depth_format), width_, height_,
+                          depth_, properties);
     Result r =
         depth_image_->Initialize(VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
                                  VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT);
@@ -74,7 +71,8 @@ Result FrameBuffer::Initialize(
   frame_buffer_info.layers = 1;
 
   if (device_->GetPtrs()->vkCreateFramebuffer(device_->GetDevice(),
-                                              &frame_buffer_info, nullptr,
+                                              &frame_buffer_info,
+                                              device_->GetHostAllocator(),
                                               &frame_) != VK_SUCCESS) {
     return Result("Vulkan::Calling vkCreateFramebuffer Fail");
   }
@@ -143,8 +141,9 @@ Result FrameBuffer::ChangeFrameImageLayout(VkCommandBuffer command,
 
 void FrameBuffer::Shutdown() {
   if (frame_ != VK_NULL_HANDLE) {
-    device_->GetPtrs()->vkDestroyFramebuffer(device_->GetDevice(), frame_,
-                                             nullptr);
+    device_->GetPtrs()->vkDestroyFramebuffer(device_->GetDevice(),
+                                             frame_,
+                                             device_->GetHostAllocator());
   }
 
   if (color_image_)
@@ -50,12 +50,21 @@ class FrameBuffer {
   }
   VkImage GetColorImage() const { return color_image_->GetVkImage(); }
 
-  // Only record the command for copying the image that backs this
-  // framebuffer to the host accessible buffer. The actual submission
-  // of the command must be done later.
-  Result CopyColorImageToHost(VkCommandBuffer command) {
+  // Only record the command for copying rows [row_begin, row_begin +
+  // row_count) of the image that backs this framebuffer to the host
+  // accessible buffer. The actual submission of the command must be
+  // done later.
+  Result CopyColorImageToHost(VkCommandBuffer command,
+                              uint32_t row_begin,
+                              uint32_t row_count) {
     ChangeFrameImageLayout(command, FrameImageState::kProbe);
-    return color_image_->CopyToHost(command);
+    return color_image_->CopyRowsToHost(command, row_begin, row_count);
+  }
+
+  // Make rows copied to the host accessible buffer visible to host
+  // reads. A no-op when the memory is host coherent.
+  Result InvalidateColorImageMemory() const {
+    return color_image_->InvalidateMemoryIfNeeded();
   }
 
   uint32_t GetWidth() const { return width_; }
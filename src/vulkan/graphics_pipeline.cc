@@ -14,8 +14,10 @@
 
 #include "src/vulkan/graphics_pipeline.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <thread>
 
 #include "src/command.h"
 #include "src/make_unique.h"
@@ -26,21 +28,16 @@ namespace amber {
 namespace vulkan {
 namespace {
 
-const VkAttachmentDescription kDefaultAttachmentDesc = {
-    0,                     /* flags */
-    VK_FORMAT_UNDEFINED,   /* format */
-    VK_SAMPLE_COUNT_1_BIT, /* samples */
-    // TODO(jaebaek): Set up proper loadOp, StoreOp.
-    VK_ATTACHMENT_LOAD_OP_DONT_CARE,      /* loadOp */
-    VK_ATTACHMENT_STORE_OP_STORE,         /* storeOp */
-    VK_ATTACHMENT_LOAD_OP_LOAD,           /* stencilLoadOp */
-    VK_ATTACHMENT_STORE_OP_STORE,         /* stencilStoreOp */
-    VK_IMAGE_LAYOUT_UNDEFINED,            /* initialLayout */
-    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, /* finalLayout */
-};
-
 const VkSampleMask kSampleMask = ~0U;
 
+// Minimum number of draws a DrawBatch() worker thread must get to pay
+// for its spawn; shorter runs are recorded serially.
+const size_t kMinDrawsPerRecordThread = 1024;
+
+// Cap on DrawBatch() recording threads. Recording throughput flattens
+// out well before the pools start fighting over the allocator.
+const size_t kMaxRecordThreads = 8;
+
 VkPrimitiveTopology ToVkTopology(Topology topology) {
   switch (topology) {
     case Topology::kPointList:
@@ -366,61 +363,6 @@ GraphicsPipeline::GraphicsPipeline(
 
 GraphicsPipeline::~GraphicsPipeline() = default;
 
-Result GraphicsPipeline::CreateRenderPass() {
-  VkSubpassDescription subpass_desc = VkSubpassDescription();
-  subpass_desc.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-
-  std::vector<VkAttachmentDescription> attachment_desc;
-
-  VkAttachmentReference color_refer = VkAttachmentReference();
-  VkAttachmentReference depth_refer = VkAttachmentReference();
-
-  if (color_format_ != VK_FORMAT_UNDEFINED) {
-    attachment_desc.push_back(kDefaultAttachmentDesc);
-    attachment_desc.back().format = color_format_;
-    attachment_desc.back().initialLayout =
-        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-    attachment_desc.back().finalLayout =
-        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-    color_refer.attachment = static_cast<uint32_t>(attachment_desc.size() - 1);
-    color_refer.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-    subpass_desc.colorAttachmentCount = 1;
-    subpass_desc.pColorAttachments = &color_refer;
-  }
-
-  if (depth_stencil_format_ != VK_FORMAT_UNDEFINED) {
-    attachment_desc.push_back(kDefaultAttachmentDesc);
-    attachment_desc.back().format = depth_stencil_format_;
-    attachment_desc.back().initialLayout =
-        VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-    attachment_desc.back().finalLayout =
-        VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-    depth_refer.attachment = static_cast<uint32_t>(attachment_desc.size() - 1);
-    depth_refer.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-    subpass_desc.pDepthStencilAttachment = &depth_refer;
-  }
-
-  VkRenderPassCreateInfo render_pass_info = VkRenderPassCreateInfo();
-  render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-  render_pass_info.attachmentCount =
-      static_cast<uint32_t>(attachment_desc.size());
-  render_pass_info.pAttachments = attachment_desc.data();
-  render_pass_info.subpassCount = 1;
-  render_pass_info.pSubpasses = &subpass_desc;
-
-  if (device_->GetPtrs()->vkCreateRenderPass(device_->GetDevice(),
-                                             &render_pass_info, nullptr,
-                                             &render_pass_) != VK_SUCCESS) {
-    return Result("Vulkan::Calling vkCreateRenderPass Fail");
-  }
-
-  return {};
-}
-
 VkPipelineDepthStencilStateCreateInfo
 GraphicsPipeline::GetPipelineDepthStencilInfo(
     const PipelineData* pipeline_data) {
@@ -508,27 +450,27 @@ Result GraphicsPipeline::CreateVkGraphicsPipeline(
       VkPipelineVertexInputStateCreateInfo();
   vertex_input_info.sType =
       VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-  vertex_input_info.vertexBindingDescriptionCount = 1;
 
-  VkVertexInputBindingDescription vertex_binding_desc =
-      VkVertexInputBindingDescription();
+  std::vector<VkVertexInputBindingDescription> vertex_binding_descs;
   if (vertex_buffer != nullptr) {
-    vertex_binding_desc = vertex_buffer->GetVertexInputBinding();
+    vertex_binding_descs = vertex_buffer->GetVertexInputBindings();
     const auto& vertex_attr_desc = vertex_buffer->GetVertexInputAttr();
 
-    vertex_input_info.pVertexBindingDescriptions = &vertex_binding_desc;
     vertex_input_info.vertexAttributeDescriptionCount =
         static_cast<uint32_t>(vertex_attr_desc.size());
     vertex_input_info.pVertexAttributeDescriptions = vertex_attr_desc.data();
   } else {
-    vertex_binding_desc.binding = 0;
-    vertex_binding_desc.stride = 0;
-    vertex_binding_desc.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    vertex_binding_descs.emplace_back();
+    vertex_binding_descs.back().binding = 0;
+    vertex_binding_descs.back().stride = 0;
+    vertex_binding_descs.back().inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 
-    vertex_input_info.pVertexBindingDescriptions = &vertex_binding_desc;
     vertex_input_info.vertexAttributeDescriptionCount = 0;
     vertex_input_info.pVertexAttributeDescriptions = nullptr;
   }
+  vertex_input_info.vertexBindingDescriptionCount =
+      static_cast<uint32_t>(vertex_binding_descs.size());
+  vertex_input_info.pVertexBindingDescriptions = vertex_binding_descs.data();
 
   VkPipelineInputAssemblyStateCreateInfo input_assembly_info =
       VkPipelineInputAssemblyStateCreateInfo();
@@ -539,22 +481,14 @@ Result GraphicsPipeline::CreateVkGraphicsPipeline(
   input_assembly_info.primitiveRestartEnable =
       pipeline_data->GetEnablePrimitiveRestart();
 
-  VkViewport viewport = {0,
-                         0,
-                         static_cast<float>(frame_->GetWidth()),
-                         static_cast<float>(frame_->GetHeight()),
-                         0,
-                         1};
-
-  VkRect2D scissor = {{0, 0}, {frame_->GetWidth(), frame_->GetHeight()}};
-
+  // Viewport and scissor are dynamic states recorded per draw, so the
+  // frame dimensions never enter the create info and pipelines differing
+  // only in them collapse to one entry in the device's pipeline cache.
   VkPipelineViewportStateCreateInfo viewport_info =
       VkPipelineViewportStateCreateInfo();
   viewport_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
   viewport_info.viewportCount = 1;
-  viewport_info.pViewports = &viewport;
   viewport_info.scissorCount = 1;
-  viewport_info.pScissors = &scissor;
 
   auto shader_stage_info = GetShaderStageInfo();
   bool is_tessellation_needed = false;
@@ -570,12 +504,12 @@ Result GraphicsPipeline::CreateVkGraphicsPipeline(
       VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO, /* sType */
       nullptr,                                                  /* pNext */
       0,                                                        /* flags */
-      kDefaultAttachmentDesc.samples, /* rasterizationSamples */
-      VK_FALSE,                       /* sampleShadingEnable */
-      0,                              /* minSampleShading */
-      &kSampleMask,                   /* pSampleMask */
-      VK_FALSE,                       /* alphaToCoverageEnable */
-      VK_FALSE,                       /* alphaToOneEnable */
+      VK_SAMPLE_COUNT_1_BIT, /* rasterizationSamples */
+      VK_FALSE,              /* sampleShadingEnable */
+      0,                     /* minSampleShading */
+      &kSampleMask,          /* pSampleMask */
+      VK_FALSE,              /* alphaToCoverageEnable */
+      VK_FALSE,              /* alphaToOneEnable */
   };
 
   VkGraphicsPipelineCreateInfo pipeline_info = VkGraphicsPipelineCreateInfo();
@@ -636,13 +570,27 @@ Result GraphicsPipeline::CreateVkGraphicsPipeline(
     pipeline_info.pColorBlendState = &colorblend_info;
   }
 
+  const VkDynamicState dynamic_states[] = {VK_DYNAMIC_STATE_VIEWPORT,
+                                           VK_DYNAMIC_STATE_SCISSOR};
+  VkPipelineDynamicStateCreateInfo dynamic_info =
+      VkPipelineDynamicStateCreateInfo();
+  dynamic_info.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+  dynamic_info.dynamicStateCount =
+      static_cast<uint32_t>(sizeof(dynamic_states) / sizeof(dynamic_states[0]));
+  dynamic_info.pDynamicStates = dynamic_states;
+  pipeline_info.pDynamicState = &dynamic_info;
+
   pipeline_info.layout = pipeline_layout_;
   pipeline_info.renderPass = render_pass_;
   pipeline_info.subpass = 0;
 
   if (device_->GetPtrs()->vkCreateGraphicsPipelines(
-          device_->GetDevice(), VK_NULL_HANDLE, 1, &pipeline_info, nullptr,
-          &pipeline_) != VK_SUCCESS) {
+      device_->GetDevice(),
+      device_->GetPipelineCache(),
+      1,
+      &pipeline_info,
+      device_->GetHostAllocator(),
+      &pipeline_) != VK_SUCCESS) {
     return Result("Vulkan::Calling vkCreateGraphicsPipelines Fail");
   }
 
@@ -657,32 +605,53 @@ Result GraphicsPipeline::Initialize(uint32_t width,
   if (!r.IsSuccess())
     return r;
 
-  r = CreateRenderPass();
-  if (!r.IsSuccess())
-    return r;
+  // The render pass and framebuffer are deferred to EnsureRenderTarget()
+  // so scripts that never render do not pay for them.
+  frame_width_ = width;
+  frame_height_ = height;
 
-  frame_ = MakeUnique<FrameBuffer>(device_, width, height);
-  r = frame_->Initialize(render_pass_, color_format_, depth_stencil_format_,
-                         memory_properties_);
+  return {};
+}
+
+Result GraphicsPipeline::EnsureRenderTarget() {
+  if (frame_)
+    return {};
+
+  Result r = device_->GetRenderTargetCache()->GetRenderPass(
+      color_format_, depth_stencil_format_, false, false, &render_pass_);
   if (!r.IsSuccess())
     return r;
 
-  frame_width_ = width;
-  frame_height_ = height;
+  return device_->GetRenderTargetCache()->AcquireFrameBuffer(
+      render_pass_, color_format_, depth_stencil_format_, frame_width_,
+      frame_height_, memory_properties_, &frame_);
+}
+
+Result GraphicsPipeline::SetVertexBuffer(uint8_t location,
+                                         const Format& format,
+                                         const std::vector<Value>& values,
+                                         VertexBuffer* vertex_buffer,
+                                         bool instance_rate) {
+  if (!vertex_buffer) {
+    return Result(
+        "GraphicsPipeline::SetVertexBuffer: vertex buffer is nullptr");
+  }
 
+  vertex_buffer->SetData(location, format, values, instance_rate);
   return {};
 }
 
 Result GraphicsPipeline::SetVertexBuffer(uint8_t location,
                                          const Format& format,
-                                         const std::vector<Value>& values,
-                                         VertexBuffer* vertex_buffer) {
+                                         const std::vector<uint8_t>& bytes,
+                                         VertexBuffer* vertex_buffer,
+                                         bool instance_rate) {
   if (!vertex_buffer) {
     return Result(
         "GraphicsPipeline::SetVertexBuffer: vertex buffer is nullptr");
   }
 
-  vertex_buffer->SetData(location, format, values);
+  vertex_buffer->SetData(location, format, bytes, instance_rate);
   return {};
 }
 
@@ -719,19 +688,11 @@ Result GraphicsPipeline::SetIndexBuffer(const std::vector<Value>& values) {
 
   DeactivateRenderPassIfNeeded();
 
-  r = index_buffer_->SendIndexData(command_->GetCommandBuffer(),
-                                   memory_properties_, values);
-  if (!r.IsSuccess())
-    return r;
-
-  r = command_->End();
-  if (!r.IsSuccess())
-    return r;
-
-  return command_->SubmitAndReset(GetFenceTimeout());
+  return index_buffer_->SendIndexData(command_->GetCommandBuffer(),
+                                      memory_properties_, values);
 }
 
-Result GraphicsPipeline::ActivateRenderPassIfNeeded() {
+Result GraphicsPipeline::ActivateRenderPassIfNeeded(VkSubpassContents contents) {
   if (render_pass_state_ == RenderPassState::kActive)
     return {};
 
@@ -745,9 +706,35 @@ Result GraphicsPipeline::ActivateRenderPassIfNeeded() {
   render_begin_info.renderPass = render_pass_;
   render_begin_info.framebuffer = frame_->GetFrameBuffer();
   render_begin_info.renderArea = {{0, 0}, {frame_width_, frame_height_}};
+
+  // Clears pending from before this instance become its attachment load
+  // ops: on tilers the tile loader writes the clear values for free
+  // instead of a separate clear pass. The variants only differ in load
+  // ops, so the pipeline and framebuffer built against the plain pass
+  // stay valid.
+  std::vector<VkClearValue> clear_values;
+  if (pending_clear_color_ || pending_clear_depth_) {
+    r = device_->GetRenderTargetCache()->GetRenderPass(
+        color_format_, depth_stencil_format_, pending_clear_color_,
+        pending_clear_depth_, &render_begin_info.renderPass);
+    if (!r.IsSuccess())
+      return r;
+
+    // One value per attachment in framebuffer order, color then depth;
+    // attachments loaded rather than cleared ignore theirs.
+    if (color_format_ != VK_FORMAT_UNDEFINED)
+      clear_values.push_back(pending_clear_color_value_);
+    if (depth_stencil_format_ != VK_FORMAT_UNDEFINED)
+      clear_values.push_back(pending_clear_depth_value_);
+    render_begin_info.clearValueCount =
+        static_cast<uint32_t>(clear_values.size());
+    render_begin_info.pClearValues = clear_values.data();
+    pending_clear_color_ = false;
+    pending_clear_depth_ = false;
+  }
+
   device_->GetPtrs()->vkCmdBeginRenderPass(command_->GetCommandBuffer(),
-                                           &render_begin_info,
-                                           VK_SUBPASS_CONTENTS_INLINE);
+                                           &render_begin_info, contents);
   render_pass_state_ = RenderPassState::kActive;
   return {};
 }
@@ -760,6 +747,19 @@ void GraphicsPipeline::DeactivateRenderPassIfNeeded() {
   render_pass_state_ = RenderPassState::kInactive;
 }
 
+Result GraphicsPipeline::FinishRenderPass() {
+  if (render_pass_state_ == RenderPassState::kInactive &&
+      (pending_clear_color_ || pending_clear_depth_)) {
+    // An empty instance whose load ops perform the pending clears.
+    Result r = ActivateRenderPassIfNeeded();
+    if (!r.IsSuccess())
+      return r;
+  }
+
+  DeactivateRenderPassIfNeeded();
+  return {};
+}
+
 Result GraphicsPipeline::SetClearColor(float r, float g, float b, float a) {
   if (color_format_ == VK_FORMAT_UNDEFINED) {
     return Result(
@@ -825,14 +825,29 @@ Result GraphicsPipeline::Clear() {
 
 Result GraphicsPipeline::ClearBuffer(const VkClearValue& clear_value,
                                      VkImageAspectFlags aspect) {
-  Result r = command_->BeginIfNotInRecording();
+  Result r = EnsureRenderTarget();
   if (!r.IsSuccess())
     return r;
 
-  r = ActivateRenderPassIfNeeded();
+  r = command_->BeginIfNotInRecording();
   if (!r.IsSuccess())
     return r;
 
+  // A clear while no pass instance is open becomes the load op of the
+  // next instance instead of a clear command. A clear landing inside an
+  // open instance stays a clear attachments command, so a merged run of
+  // clears and draws is not split by it.
+  if (render_pass_state_ == RenderPassState::kInactive) {
+    if (aspect & VK_IMAGE_ASPECT_COLOR_BIT) {
+      pending_clear_color_ = true;
+      pending_clear_color_value_ = clear_value;
+    } else {
+      pending_clear_depth_ = true;
+      pending_clear_depth_value_ = clear_value;
+    }
+    return {};
+  }
+
   VkClearAttachment clear_attachment = VkClearAttachment();
   clear_attachment.aspectMask = aspect;
   clear_attachment.colorAttachment = 0;
@@ -846,67 +861,135 @@ Result GraphicsPipeline::ClearBuffer(const VkClearValue& clear_value,
   device_->GetPtrs()->vkCmdClearAttachments(command_->GetCommandBuffer(), 1,
                                             &clear_attachment, 1, &clear_rect);
 
-  DeactivateRenderPassIfNeeded();
-
-  return frame_->CopyColorImageToHost(command_->GetCommandBuffer());
+  return {};
 }
 
-Result GraphicsPipeline::ResetPipeline() {
-  if (pipeline_ == VK_NULL_HANDLE)
-    return {};
-
-  Result r = command_->BeginIfNotInRecording();
+Result GraphicsPipeline::CopyColorFrameBufferToHost(uint32_t row_begin,
+                                                    uint32_t row_count) {
+  Result r = EnsureRenderTarget();
   if (!r.IsSuccess())
     return r;
 
-  DeactivateRenderPassIfNeeded();
-
-  r = command_->End();
+  r = command_->BeginIfNotInRecording();
   if (!r.IsSuccess())
     return r;
 
-  r = command_->SubmitAndReset(GetFenceTimeout());
+  r = FinishRenderPass();
   if (!r.IsSuccess())
     return r;
 
-  if (pipeline_ != VK_NULL_HANDLE) {
-    device_->GetPtrs()->vkDestroyPipeline(device_->GetDevice(), pipeline_,
-                                          nullptr);
-    pipeline_ = VK_NULL_HANDLE;
-  }
+  return frame_->CopyColorImageToHost(command_->GetCommandBuffer(), row_begin,
+                                      row_count);
+}
+
+Result GraphicsPipeline::ResetPipeline() {
+  if (pipeline_ == VK_NULL_HANDLE)
+    return {};
 
+  // Commands still sitting in the command buffer may reference the
+  // pipeline, so keep it alive until the submission using it completed.
+  retired_pipelines_.push_back(pipeline_);
+  pipeline_ = VK_NULL_HANDLE;
   return {};
 }
 
-Result GraphicsPipeline::Draw(const DrawArraysCommand* command,
-                              VertexBuffer* vertex_buffer) {
-  Result r = command_->BeginIfNotInRecording();
+void GraphicsPipeline::DestroyRetiredPipelines() {
+  for (auto& pipeline : retired_pipelines_) {
+    device_->GetPtrs()->vkDestroyPipeline(device_->GetDevice(),
+                                          pipeline,
+                                          device_->GetHostAllocator());
+  }
+  retired_pipelines_.clear();
+}
+
+Result GraphicsPipeline::Prewarm(const DrawArraysCommand* command,
+                                 VertexBuffer* vertex_buffer) {
+  // Only the render pass is needed to create the pipeline; the
+  // framebuffer and its images stay deferred to the first real draw.
+  Result r = device_->GetRenderTargetCache()->GetRenderPass(
+      color_format_, depth_stencil_format_, false, false, &render_pass_);
   if (!r.IsSuccess())
     return r;
 
-  DeactivateRenderPassIfNeeded();
+  const VkPrimitiveTopology topology = ToVkTopology(command->GetTopology());
+  if (pipeline_ != VK_NULL_HANDLE) {
+    if (topology == pipeline_create_topology_ &&
+        vertex_buffer == pipeline_create_vertex_buffer_ &&
+        patch_control_points_ == pipeline_create_patch_control_points_ &&
+        GetEntryPointGeneration() == pipeline_create_entry_point_generation_ &&
+        command->GetPipelineData()->Equals(pipeline_create_data_)) {
+      return {};
+    }
+    r = ResetPipeline();
+    if (!r.IsSuccess())
+      return r;
+  }
 
-  r = SendDescriptorDataToDeviceIfNeeded();
+  r = CreateVkGraphicsPipeline(command->GetPipelineData(), topology,
+                               vertex_buffer);
   if (!r.IsSuccess())
     return r;
 
-  r = command_->End();
+  pipeline_create_data_ = *command->GetPipelineData();
+  pipeline_create_topology_ = topology;
+  pipeline_create_vertex_buffer_ = vertex_buffer;
+  pipeline_create_patch_control_points_ = patch_control_points_;
+  pipeline_create_entry_point_generation_ = GetEntryPointGeneration();
+  return {};
+}
+
+Result GraphicsPipeline::Draw(const DrawArraysCommand* command,
+                              VertexBuffer* vertex_buffer) {
+  Result r = EnsureRenderTarget();
   if (!r.IsSuccess())
     return r;
 
-  r = command_->SubmitAndReset(GetFenceTimeout());
+  r = command_->BeginIfNotInRecording();
   if (!r.IsSuccess())
     return r;
 
-  r = CreateVkGraphicsPipeline(command->GetPipelineData(),
-                               ToVkTopology(command->GetTopology()),
-                               vertex_buffer);
+  // A pass instance left open by the previous clear or draw stays open
+  // when this draw records nothing outside it, folding whole runs of
+  // clears and draws into one instance: on tilers every instance is a
+  // full tile flush and reload. Descriptor traffic ends it like before;
+  // its upload and readback paths record outside the pass.
+  if (HasDescriptors())
+    DeactivateRenderPassIfNeeded();
+
+  r = SendDescriptorDataToDeviceIfNeeded();
   if (!r.IsSuccess())
     return r;
 
-  // Note that a command updating a descriptor set and a command using
-  // it must be submitted separately, because using a descriptor set
-  // while updating it is not safe.
+  // Reuse |pipeline_| from the previous draw when it was created from
+  // identical state; otherwise retire it and build a new one.
+  const VkPrimitiveTopology topology = ToVkTopology(command->GetTopology());
+  if (pipeline_ != VK_NULL_HANDLE &&
+      !(topology == pipeline_create_topology_ &&
+        vertex_buffer == pipeline_create_vertex_buffer_ &&
+        patch_control_points_ == pipeline_create_patch_control_points_ &&
+        GetEntryPointGeneration() == pipeline_create_entry_point_generation_ &&
+        command->GetPipelineData()->Equals(pipeline_create_data_))) {
+    r = ResetPipeline();
+    if (!r.IsSuccess())
+      return r;
+  }
+
+  if (pipeline_ == VK_NULL_HANDLE) {
+    r = CreateVkGraphicsPipeline(command->GetPipelineData(), topology,
+                                 vertex_buffer);
+    if (!r.IsSuccess())
+      return r;
+
+    pipeline_create_data_ = *command->GetPipelineData();
+    pipeline_create_topology_ = topology;
+    pipeline_create_vertex_buffer_ = vertex_buffer;
+    pipeline_create_patch_control_points_ = patch_control_points_;
+    pipeline_create_entry_point_generation_ = GetEntryPointGeneration();
+  }
+
+  // UpdateDescriptorSetsIfNeeded() drains the queue before updating a
+  // descriptor set. Otherwise everything keeps batching up in the command
+  // buffer and is submitted by the next ProcessCommands().
   r = UpdateDescriptorSetsIfNeeded();
   if (!r.IsSuccess())
     return r;
@@ -923,10 +1006,11 @@ Result GraphicsPipeline::Draw(const DrawArraysCommand* command,
   if (!r.IsSuccess())
     return r;
 
-  BindVkDescriptorSets();
-  BindVkPipeline();
+  BindVkDescriptorSets(command_->GetCommandBuffer());
+  BindVkPipeline(command_->GetCommandBuffer());
+  RecordViewportAndScissor(command_->GetCommandBuffer());
 
-  r = RecordPushConstant();
+  r = RecordPushConstant(command_->GetCommandBuffer());
   if (!r.IsSuccess())
     return r;
 
@@ -961,23 +1045,240 @@ Result GraphicsPipeline::Draw(const DrawArraysCommand* command,
                                   command->GetFirstVertexIndex(), 0);
   }
 
+  // The pass instance stays open for the next clear or draw to join;
+  // everything needing it closed ends it through FinishRenderPass().
+  // The readback below records copies only for pipelines with
+  // descriptors, which closed the instance at the top of this draw.
+  if (HasDescriptors())
+    DeactivateRenderPassIfNeeded();
+
+  return ReadbackDescriptorsToHostDataQueue();
+}
+
+Result GraphicsPipeline::DrawBatch(
+    const std::vector<const DrawArraysCommand*>& commands,
+    VertexBuffer* vertex_buffer) {
+  size_t thread_count =
+      std::min(commands.size() / kMinDrawsPerRecordThread,
+               std::min(kMaxRecordThreads,
+                        static_cast<size_t>(std::max(
+                            1u, std::thread::hardware_concurrency()))));
+
+  // Workers record nothing but plain vkCmdDraw() calls, so a run whose
+  // draws need an index buffer or differ in pipeline state keeps the
+  // serial path, as do runs too short to pay for the thread spawns.
+  bool parallel = thread_count >= 2;
+  const DrawArraysCommand* first = commands[0];
+  if (parallel) {
+    for (const auto* command : commands) {
+      if (command->IsIndexed() ||
+          command->GetTopology() != first->GetTopology() ||
+          !command->GetPipelineData()->Equals(*first->GetPipelineData())) {
+        parallel = false;
+        break;
+      }
+    }
+  }
+
+  if (!parallel) {
+    for (const auto* command : commands) {
+      Result r = Draw(command, vertex_buffer);
+      if (!r.IsSuccess())
+        return r;
+    }
+    return {};
+  }
+
+  // Everything a draw records besides the vkCmdDraw() itself - layout
+  // transitions, descriptor and vertex uploads, pipeline creation - is
+  // identical across the run and done once, mirroring Draw().
+  Result r = EnsureRenderTarget();
+  if (!r.IsSuccess())
+    return r;
+
+  r = command_->BeginIfNotInRecording();
+  if (!r.IsSuccess())
+    return r;
+
   DeactivateRenderPassIfNeeded();
 
-  r = frame_->CopyColorImageToHost(command_->GetCommandBuffer());
+  r = SendDescriptorDataToDeviceIfNeeded();
+  if (!r.IsSuccess())
+    return r;
+
+  const VkPrimitiveTopology topology = ToVkTopology(first->GetTopology());
+  if (pipeline_ != VK_NULL_HANDLE &&
+      !(topology == pipeline_create_topology_ &&
+        vertex_buffer == pipeline_create_vertex_buffer_ &&
+        patch_control_points_ == pipeline_create_patch_control_points_ &&
+        GetEntryPointGeneration() == pipeline_create_entry_point_generation_ &&
+        first->GetPipelineData()->Equals(pipeline_create_data_))) {
+    r = ResetPipeline();
+    if (!r.IsSuccess())
+      return r;
+  }
+
+  if (pipeline_ == VK_NULL_HANDLE) {
+    r = CreateVkGraphicsPipeline(first->GetPipelineData(), topology,
+                                 vertex_buffer);
+    if (!r.IsSuccess())
+      return r;
+
+    pipeline_create_data_ = *first->GetPipelineData();
+    pipeline_create_topology_ = topology;
+    pipeline_create_vertex_buffer_ = vertex_buffer;
+    pipeline_create_patch_control_points_ = patch_control_points_;
+    pipeline_create_entry_point_generation_ = GetEntryPointGeneration();
+  }
+
+  r = UpdateDescriptorSetsIfNeeded();
+  if (!r.IsSuccess())
+    return r;
+
+  r = command_->BeginIfNotInRecording();
+  if (!r.IsSuccess())
+    return r;
+
+  r = SendVertexBufferDataIfNeeded(vertex_buffer);
   if (!r.IsSuccess())
     return r;
 
-  r = ReadbackDescriptorsToHostDataQueue();
+  if (!secondary_command_buffers_) {
+    secondary_command_buffers_ = MakeUnique<SecondaryCommandBuffers>(
+        device_, device_->GetQueueFamilyIndex());
+  }
+
+  std::vector<VkCommandBuffer> secondaries;
+  r = secondary_command_buffers_->Allocate(thread_count, &secondaries);
   if (!r.IsSuccess())
     return r;
 
-  return ResetPipeline();
+  VkCommandBufferInheritanceInfo inheritance_info =
+      VkCommandBufferInheritanceInfo();
+  inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+  inheritance_info.renderPass = render_pass_;
+  inheritance_info.subpass = 0;
+  inheritance_info.framebuffer = frame_->GetFrameBuffer();
+
+  const size_t draws_per_thread =
+      (commands.size() + thread_count - 1) / thread_count;
+
+  // State bound in the primary buffer does not carry into a secondary,
+  // so every worker binds the full draw state itself. The binds and the
+  // push constant only read pipeline state, making the concurrent
+  // recording into per pool buffers safe.
+  std::vector<Result> results(thread_count);
+  auto record_worker = [&](size_t index) {
+    VkCommandBuffer secondary = secondaries[index];
+
+    VkCommandBufferBeginInfo begin_info = VkCommandBufferBeginInfo();
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    begin_info.pInheritanceInfo = &inheritance_info;
+    if (device_->GetPtrs()->vkBeginCommandBuffer(secondary, &begin_info) !=
+        VK_SUCCESS) {
+      results[index] = Result("Vulkan::Calling vkBeginCommandBuffer Fail");
+      return;
+    }
+
+    BindVkDescriptorSets(secondary);
+    BindVkPipeline(secondary);
+    RecordViewportAndScissor(secondary);
+
+    Result worker_result = RecordPushConstant(secondary);
+    if (!worker_result.IsSuccess()) {
+      results[index] = worker_result;
+      return;
+    }
+
+    if (vertex_buffer != nullptr)
+      vertex_buffer->BindToCommandBuffer(secondary);
+
+    const size_t begin = index * draws_per_thread;
+    const size_t end = std::min(commands.size(), begin + draws_per_thread);
+    for (size_t i = begin; i < end; ++i) {
+      const DrawArraysCommand* command = commands[i];
+      uint32_t instance_count = command->GetInstanceCount();
+      if (instance_count == 0 && command->GetVertexCount() != 0)
+        instance_count = 1;
+
+      device_->GetPtrs()->vkCmdDraw(secondary, command->GetVertexCount(),
+                                    instance_count,
+                                    command->GetFirstVertexIndex(), 0);
+    }
+
+    if (device_->GetPtrs()->vkEndCommandBuffer(secondary) != VK_SUCCESS)
+      results[index] = Result("Vulkan::Calling vkEndCommandBuffer Fail");
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < thread_count; ++i)
+    threads.emplace_back(record_worker, i);
+  record_worker(0);
+  for (auto& thread : threads)
+    thread.join();
+
+  for (const auto& result : results) {
+    if (!result.IsSuccess())
+      return result;
+  }
+
+  // A subpass begun for secondary buffers may only execute them, so the
+  // stitched run gets its own render pass instance; inline draws before
+  // or after it cannot share one with it.
+  r = ActivateRenderPassIfNeeded(
+      VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+  if (!r.IsSuccess())
+    return r;
+
+  device_->GetPtrs()->vkCmdExecuteCommands(
+      command_->GetCommandBuffer(), static_cast<uint32_t>(secondaries.size()),
+      secondaries.data());
+
+  DeactivateRenderPassIfNeeded();
+
+  return ReadbackDescriptorsToHostDataQueue();
+}
+
+void GraphicsPipeline::RecordViewportAndScissor(
+    VkCommandBuffer command_buffer) {
+  VkViewport viewport = {0,
+                         0,
+                         static_cast<float>(frame_width_),
+                         static_cast<float>(frame_height_),
+                         0,
+                         1};
+  device_->GetPtrs()->vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+
+  VkRect2D scissor = {{0, 0}, {frame_width_, frame_height_}};
+  device_->GetPtrs()->vkCmdSetScissor(command_buffer, 0, 1, &scissor);
 }
 
 Result GraphicsPipeline::ProcessCommands() {
-  DeactivateRenderPassIfNeeded();
+  Result finish_result = FinishRenderPass();
+  if (!finish_result.IsSuccess())
+    return finish_result;
+
+  Result r = Pipeline::ProcessCommands();
+  if (!r.IsSuccess())
+    return r;
 
-  return Pipeline::ProcessCommands();
+  // Pipelines retired before the submission are no longer referenced by
+  // any work in flight. Recordings preserved for replay may still bind
+  // them, so they outlive the replay in that case.
+  if (!HasPreservedRecordings()) {
+    DestroyRetiredPipelines();
+
+    // Same reasoning for the DrawBatch() secondaries: the wait above left
+    // nothing in flight or recorded that could still execute them, unless
+    // a preserved primary replays them later.
+    if (secondary_command_buffers_) {
+      Result reset_result = secondary_command_buffers_->Reset();
+      if (!reset_result.IsSuccess())
+        return reset_result;
+    }
+  }
+  return {};
 }
 
 void GraphicsPipeline::Shutdown() {
@@ -987,11 +1288,17 @@ void GraphicsPipeline::Shutdown() {
     index_buffer_->Shutdown();
 
   Pipeline::Shutdown();
-  frame_->Shutdown();
+  DestroyRetiredPipelines();
+
+  if (secondary_command_buffers_)
+    secondary_command_buffers_->Shutdown();
 
-  if (render_pass_ != VK_NULL_HANDLE) {
-    device_->GetPtrs()->vkDestroyRenderPass(device_->GetDevice(), render_pass_,
-                                            nullptr);
+  // The render pass stays in the device cache; the framebuffer goes back
+  // to its pool. Pipeline::Shutdown() waited for submissions, so nothing
+  // in flight references them anymore.
+  if (frame_) {
+    device_->GetRenderTargetCache()->ReleaseFrameBuffer(
+        color_format_, depth_stencil_format_, std::move(frame_));
   }
 }
 
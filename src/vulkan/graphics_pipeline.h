@@ -23,6 +23,7 @@
 #include "amber/vulkan_header.h"
 #include "src/buffer_data.h"
 #include "src/format.h"
+#include "src/pipeline_data.h"
 #include "src/vulkan/frame_buffer.h"
 #include "src/vulkan/index_buffer.h"
 #include "src/vulkan/pipeline.h"
@@ -53,7 +54,13 @@ class GraphicsPipeline : public Pipeline {
   Result SetVertexBuffer(uint8_t location,
                          const Format& format,
                          const std::vector<Value>& values,
-                         VertexBuffer* vertex_buffer);
+                         VertexBuffer* vertex_buffer,
+                         bool instance_rate = false);
+  Result SetVertexBuffer(uint8_t location,
+                         const Format& format,
+                         const std::vector<uint8_t>& bytes,
+                         VertexBuffer* vertex_buffer,
+                         bool instance_rate = false);
 
   Result SetIndexBuffer(const std::vector<Value>& values);
 
@@ -69,8 +76,41 @@ class GraphicsPipeline : public Pipeline {
 
   Result Draw(const DrawArraysCommand* command, VertexBuffer* vertex_buffer);
 
+  // Record the consecutive draws of |commands| in parallel: the run is
+  // partitioned over worker threads, each records its share into a
+  // secondary command buffer from its own pool, and one render pass in
+  // the primary buffer executes the stitched buffers. Recording vkCmd*
+  // calls is pure CPU work, so a run of 100k fuzzer generated draws
+  // records about core-count times faster. Runs too short to pay for
+  // the thread spawns, or whose draws differ in pipeline state or use
+  // an index buffer, fall back to Draw() one by one.
+  Result DrawBatch(const std::vector<const DrawArraysCommand*>& commands,
+                   VertexBuffer* vertex_buffer);
+
+  // Creates the VkPipeline the given draw state will need and keeps it,
+  // with its state key, as the current pipeline, so the first draw with
+  // the same state binds it directly. Draws with other state still
+  // benefit from the entry the creation left in the device's pipeline
+  // cache. No GPU work is submitted.
+  Result Prewarm(const DrawArraysCommand* command, VertexBuffer* vertex_buffer);
+
+  // Gets the render pass and framebuffer from the device's render target
+  // cache if this pipeline does not have them yet. Both are deferred from
+  // Initialize() to the first command that renders or reads the
+  // framebuffer, so compute and buffer-only scripts never pay for them.
+  // Callers of GetFrame() must ensure the render target first.
+  Result EnsureRenderTarget();
+
   const FrameBuffer* GetFrame() const { return frame_.get(); }
 
+  // Record a copy of rows [row_begin, row_begin + row_count) of the color
+  // attachment to its host accessible buffer. The copy is submitted by
+  // the next ProcessCommands().
+  Result CopyColorFrameBufferToHost(uint32_t row_begin, uint32_t row_count);
+
+  // Retire |pipeline_| so the next draw can create a new one. The retired
+  // pipeline is destroyed after the next submission completed because
+  // commands still sitting in the command buffer may reference it.
   Result ResetPipeline();
 
   uint32_t GetWidth() const { return frame_width_; }
@@ -94,12 +134,31 @@ class GraphicsPipeline : public Pipeline {
                                   VkPrimitiveTopology topology,
                                   const VertexBuffer* vertex_buffer);
 
-  Result CreateRenderPass();
-  Result ActivateRenderPassIfNeeded();
+  Result ActivateRenderPassIfNeeded(
+      VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
   void DeactivateRenderPassIfNeeded();
 
+  // Ends an open render pass instance and materializes clears still
+  // pending as an empty instance whose load ops perform them, so the
+  // framebuffer content is current for copies and submissions.
+  Result FinishRenderPass();
+
+  // True when a draw records descriptor traffic outside the render
+  // pass, which keeps the one-pass-per-draw shape.
+  bool HasDescriptors() const { return !descriptor_set_info_.empty(); }
+
   Result SendVertexBufferDataIfNeeded(VertexBuffer* vertex_buffer);
 
+  // Record the frame-sized viewport and scissor into |command_buffer|.
+  // Both are dynamic pipeline states, so frame dimensions stay out of
+  // the pipeline create info and pipelines differing only in them share
+  // one cache entry. Must be recorded after every pipeline bind.
+  void RecordViewportAndScissor(VkCommandBuffer command_buffer);
+
+  // Destroy pipelines retired by ResetPipeline(). This must be called only
+  // when no submitted work using them is in flight.
+  void DestroyRetiredPipelines();
+
   // TODO(jaebaek): Implement image/ssbo probe.
   Result SubmitProbeCommand();
   Result VerifyPixels(const uint32_t x,
@@ -113,9 +172,40 @@ class GraphicsPipeline : public Pipeline {
   VkPipelineColorBlendAttachmentState GetPipelineColorBlendAttachmentState(
       const PipelineData* pipeline_data);
 
+  // Owned by the device's render target cache.
   VkRenderPass render_pass_ = VK_NULL_HANDLE;
   RenderPassState render_pass_state_ = RenderPassState::kInactive;
 
+  // A clear issued while no render pass instance is open becomes the
+  // load op of the next instance instead of a clear command; the values
+  // are snapshot here until that instance begins.
+  bool pending_clear_color_ = false;
+  bool pending_clear_depth_ = false;
+  VkClearValue pending_clear_color_value_ = VkClearValue();
+  VkClearValue pending_clear_depth_value_ = VkClearValue();
+
+  // Pipelines waiting for the submission that uses them to complete
+  // before they can be destroyed.
+  std::vector<VkPipeline> retired_pipelines_;
+
+  // Per worker secondary command buffers used by DrawBatch(); recycled
+  // once the submission executing them completed.
+  std::unique_ptr<SecondaryCommandBuffers> secondary_command_buffers_;
+
+  // State |pipeline_| was created from. A draw whose state matches reuses
+  // |pipeline_| instead of building a new one; scripts issuing many
+  // identical draws e.g., DRAW_RECT sweeps hit the reuse path every time.
+  // The vertex buffer is compared by identity because a given buffer
+  // keeps its layout once draws against it started.
+  PipelineData pipeline_create_data_;
+  VkPrimitiveTopology pipeline_create_topology_ =
+      VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+  const VertexBuffer* pipeline_create_vertex_buffer_ = nullptr;
+  uint32_t pipeline_create_patch_control_points_ = 0;
+  uint64_t pipeline_create_entry_point_generation_ = 0;
+
+  // Acquired from the device's render target cache and released back to
+  // it at Shutdown().
   std::unique_ptr<FrameBuffer> frame_;
   VkFormat color_format_;
   VkFormat depth_stencil_format_;
@@ -0,0 +1,178 @@
+// Copyright 2018 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/vulkan/host_allocator.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace amber {
+namespace vulkan {
+namespace {
+
+// Smallest pooled block. Blocks are laid out on multiples of this, so
+// any alignment the driver may ask for up to it is satisfied without
+// padding tricks.
+const size_t kMinBlockSize = 64;
+
+// Largest pooled block; bigger requests, e.g. whole pipeline blobs, go
+// to the heap directly.
+const size_t kMaxBlockSize = 64 * 1024;
+
+// Blocks carved out of one slab allocation.
+const size_t kBlocksPerSlab = 16;
+
+// Class index marking a block that came from the heap, not a slab.
+const uint32_t kHeapClass = 0xffffffffu;
+
+size_t AlignUp(size_t value, size_t alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+}  // namespace
+
+HostAllocator::HostAllocator() {
+  size_t class_count = 0;
+  for (size_t size = kMinBlockSize; size <= kMaxBlockSize; size *= 2)
+    ++class_count;
+  free_blocks_.resize(class_count);
+
+  callbacks_ = VkAllocationCallbacks();
+  callbacks_.pUserData = this;
+  callbacks_.pfnAllocation = AllocationThunk;
+  callbacks_.pfnReallocation = ReallocationThunk;
+  callbacks_.pfnFree = FreeThunk;
+}
+
+HostAllocator::~HostAllocator() {
+  for (void* slab : slabs_)
+    std::free(slab);
+}
+
+void* HostAllocator::Allocate(size_t size, size_t alignment) {
+  if (size == 0)
+    return nullptr;
+  // The header before the returned pointer must itself be aligned.
+  if (alignment < sizeof(uint64_t))
+    alignment = sizeof(uint64_t);
+
+  // Worst case room for aligning the driver's pointer past the header.
+  const size_t needed = size + alignment + sizeof(Header);
+
+  char* block = nullptr;
+  uint32_t class_index = 0;
+  if (needed <= kMaxBlockSize && alignment <= kMinBlockSize) {
+    size_t class_size = kMinBlockSize;
+    while (class_size < needed) {
+      class_size *= 2;
+      ++class_index;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& free_list = free_blocks_[class_index];
+    if (free_list.empty()) {
+      // Carve a fresh slab into blocks of this class. The slab start is
+      // aligned to the block size, so every block is too.
+      char* slab = static_cast<char*>(
+          std::malloc(kBlocksPerSlab * class_size + class_size - 1));
+      if (slab == nullptr)
+        return nullptr;
+      slabs_.push_back(slab);
+
+      char* base = reinterpret_cast<char*>(
+          AlignUp(reinterpret_cast<uintptr_t>(slab), class_size));
+      for (size_t i = 0; i < kBlocksPerSlab; ++i)
+        free_list.push_back(base + i * class_size);
+    }
+    block = static_cast<char*>(free_list.back());
+    free_list.pop_back();
+  } else {
+    block = static_cast<char*>(std::malloc(needed));
+    if (block == nullptr)
+      return nullptr;
+    class_index = kHeapClass;
+  }
+
+  char* user = reinterpret_cast<char*>(AlignUp(
+      reinterpret_cast<uintptr_t>(block) + sizeof(Header), alignment));
+  Header* header = reinterpret_cast<Header*>(user) - 1;
+  header->class_index = class_index;
+  header->offset = static_cast<uint32_t>(user - block);
+  header->size = size;
+  return user;
+}
+
+void* HostAllocator::Reallocate(void* original, size_t size,
+                                size_t alignment) {
+  if (original == nullptr)
+    return Allocate(size, alignment);
+
+  if (size == 0) {
+    Free(original);
+    return nullptr;
+  }
+
+  const Header* header = reinterpret_cast<const Header*>(original) - 1;
+  if (header->size >= size)
+    return original;
+
+  void* grown = Allocate(size, alignment);
+  if (grown == nullptr)
+    return nullptr;
+
+  std::memcpy(grown, original, static_cast<size_t>(header->size));
+  Free(original);
+  return grown;
+}
+
+void HostAllocator::Free(void* memory) {
+  if (memory == nullptr)
+    return;
+
+  const Header* header = reinterpret_cast<const Header*>(memory) - 1;
+  char* block = static_cast<char*>(memory) - header->offset;
+  if (header->class_index == kHeapClass) {
+    std::free(block);
+    return;
+  }
+
+  assert(header->class_index < free_blocks_.size());
+  std::lock_guard<std::mutex> lock(mutex_);
+  free_blocks_[header->class_index].push_back(block);
+}
+
+void* VKAPI_CALL HostAllocator::AllocationThunk(void* user_data,
+                                                size_t size,
+                                                size_t alignment,
+                                                VkSystemAllocationScope) {
+  return static_cast<HostAllocator*>(user_data)->Allocate(size, alignment);
+}
+
+void* VKAPI_CALL HostAllocator::ReallocationThunk(void* user_data,
+                                                  void* original,
+                                                  size_t size,
+                                                  size_t alignment,
+                                                  VkSystemAllocationScope) {
+  return static_cast<HostAllocator*>(user_data)->Reallocate(original, size,
+                                                            alignment);
+}
+
+void VKAPI_CALL HostAllocator::FreeThunk(void* user_data, void* memory) {
+  static_cast<HostAllocator*>(user_data)->Free(memory);
+}
+
+}  // namespace vulkan
+}  // namespace amber
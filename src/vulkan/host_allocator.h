@@ -0,0 +1,86 @@
+// Copyright 2018 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_VULKAN_HOST_ALLOCATOR_H_
+#define SRC_VULKAN_HOST_ALLOCATOR_H_
+
+#include <mutex>
+#include <vector>
+
+#include "amber/vulkan_header.h"
+
+namespace amber {
+namespace vulkan {
+
+// VkAllocationCallbacks backed by slabs of pooled blocks. The driver
+// makes bursts of short lived host allocations while pipelines and other
+// device child objects are created; serving them from per size class
+// free lists keeps that churn off the global heap the parser threads
+// share. Freed blocks go back to their class and are handed out again,
+// so a pipeline heavy run settles into reuse with no heap traffic at
+// all. Blocks larger than the biggest class fall through to the heap.
+//
+// The callbacks are handed to every create and destroy call of objects
+// owned by one Device, so the allocator must outlive all of them; it
+// is internally locked because drivers may allocate from worker
+// threads.
+class HostAllocator {
+ public:
+  HostAllocator();
+  ~HostAllocator();
+
+  HostAllocator(const HostAllocator&) = delete;
+  HostAllocator& operator=(const HostAllocator&) = delete;
+
+  const VkAllocationCallbacks* GetCallbacks() const { return &callbacks_; }
+
+ private:
+  // Block header written directly before the pointer handed to the
+  // driver; Free() reads it to find the block start and its class.
+  struct Header {
+    uint32_t class_index;
+    // Byte distance from the block start to the driver's pointer.
+    uint32_t offset;
+    // Size the driver asked for, needed to copy on reallocation.
+    uint64_t size;
+  };
+
+  void* Allocate(size_t size, size_t alignment);
+  void* Reallocate(void* original, size_t size, size_t alignment);
+  void Free(void* memory);
+
+  static void* VKAPI_CALL AllocationThunk(void* user_data,
+                                          size_t size,
+                                          size_t alignment,
+                                          VkSystemAllocationScope scope);
+  static void* VKAPI_CALL ReallocationThunk(void* user_data,
+                                            void* original,
+                                            size_t size,
+                                            size_t alignment,
+                                            VkSystemAllocationScope scope);
+  static void VKAPI_CALL FreeThunk(void* user_data, void* memory);
+
+  VkAllocationCallbacks callbacks_;
+
+  std::mutex mutex_;
+  // Free blocks per power-of-two size class.
+  std::vector<std::vector<void*>> free_blocks_;
+  // Slab allocations the blocks were carved from, freed on destruction.
+  std::vector<void*> slabs_;
+};
+
+}  // namespace vulkan
+}  // namespace amber
+
+#endif  // SRC_VULKAN_HOST_ALLOCATOR_H_
@@ -66,25 +66,23 @@ Result Image::Initialize(VkImageUsageFlags usage) {
 
   image_info_.usage = usage;
 
-  if (device_->GetPtrs()->vkCreateImage(device_->GetDevice(), &image_info_,
-                                        nullptr, &image_) != VK_SUCCESS) {
+  if (device_->GetPtrs()->vkCreateImage(device_->GetDevice(),
+                                        &image_info_,
+                                        device_->GetHostAllocator(),
+                                        &image_) != VK_SUCCESS) {
     return Result("Vulkan::Calling vkCreateImage Fail");
   }
 
   AllocateResult allocate_result = AllocateAndBindMemoryToVkImage(
-      image_, &memory_, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
+      image_, &allocation_, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
   if (!allocate_result.r.IsSuccess())
     return allocate_result.r;
 
-  Result r = CreateVkImageView();
-  if (!r.IsSuccess())
-    return r;
-
-  // For images, we always make a secondary buffer. When the tiling of an image
-  // is optimal, read/write data from CPU does not show correct values. We need
-  // a secondary buffer to convert the GPU-optimial data to CPU-readable data
-  // and vice versa.
-  return Resource::Initialize();
+  // The secondary host-accessible buffer that CPU reads go through is
+  // acquired lazily by CopyRowsToHost(). The tiling of the image is
+  // optimal, so the CPU cannot read it directly anyway, and an image
+  // that no probe ever touches never pays for the buffer.
+  return CreateVkImageView();
 }
 
 Result Image::CreateVkImageView() {
@@ -109,7 +107,8 @@ Result Image::CreateVkImageView() {
   };
 
   if (device_->GetPtrs()->vkCreateImageView(device_->GetDevice(),
-                                            &image_view_info, nullptr,
+                                            &image_view_info,
+                                            device_->GetHostAllocator(),
                                             &view_) != VK_SUCCESS) {
     return Result("Vulkan::Calling vkCreateImageView Fail");
   }
@@ -119,22 +118,48 @@ Result Image::CreateVkImageView() {
 
 void Image::Shutdown() {
   if (view_ != VK_NULL_HANDLE) {
-    device_->GetPtrs()->vkDestroyImageView(device_->GetDevice(), view_,
-                                           nullptr);
+    device_->GetPtrs()->vkDestroyImageView(device_->GetDevice(),
+                                           view_,
+                                           device_->GetHostAllocator());
   }
 
   if (image_ != VK_NULL_HANDLE)
-    device_->GetPtrs()->vkDestroyImage(device_->GetDevice(), image_, nullptr);
+    device_->GetPtrs()->vkDestroyImage(device_->GetDevice(),
+                                       image_,
+                                       device_->GetHostAllocator());
 
-  if (memory_ != VK_NULL_HANDLE)
-    device_->GetPtrs()->vkFreeMemory(device_->GetDevice(), memory_, nullptr);
+  FreeMemory(&allocation_);
 
   Resource::Shutdown();
 }
 
 Result Image::CopyToHost(VkCommandBuffer command) {
+  return CopyRowsToHost(command, 0, image_info_.extent.height);
+}
+
+Result Image::CopyRowsToHost(VkCommandBuffer command,
+                             uint32_t row_begin,
+                             uint32_t row_count) {
+  if (GetHostAccessibleBuffer() == VK_NULL_HANDLE) {
+    Result r = Resource::Initialize();
+    if (!r.IsSuccess())
+      return r;
+  }
+
+  const VkDeviceSize row_stride =
+      image_info_.extent.width * VkFormatToByteSize(image_info_.format);
+
+  // The buffer offset of the copy must be 4 byte aligned. Start early
+  // enough that the first copied row lands on an aligned offset; at most
+  // three extra rows are copied.
+  while (row_begin > 0 &&
+         (static_cast<VkDeviceSize>(row_begin) * row_stride) % 4 != 0) {
+    --row_begin;
+    ++row_count;
+  }
+
   VkBufferImageCopy copy_region = VkBufferImageCopy();
-  copy_region.bufferOffset = 0;
+  copy_region.bufferOffset = static_cast<VkDeviceSize>(row_begin) * row_stride;
   // Row length of 0 results in tight packing of rows, so the row stride
   // is the number of texels times the texel stride.
   copy_region.bufferRowLength = 0;
@@ -145,15 +170,16 @@ Result Image::CopyToHost(VkCommandBuffer command) {
       0,       /* baseArrayLayer */
       1,       /* layerCount */
   };
-  copy_region.imageOffset = {0, 0, 0};
-  copy_region.imageExtent = {image_info_.extent.width,
-                             image_info_.extent.height, 1};
+  copy_region.imageOffset = {0, static_cast<int32_t>(row_begin), 0};
+  copy_region.imageExtent = {image_info_.extent.width, row_count, 1};
 
   device_->GetPtrs()->vkCmdCopyImageToBuffer(
       command, image_, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
       GetHostAccessibleBuffer(), 1, &copy_region);
 
-  MemoryBarrier(command);
+  MemoryBarrier(command, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+                VK_ACCESS_HOST_READ_BIT);
   return {};
 }
 
@@ -57,6 +57,13 @@ class Image : public Resource {
   // must be done later.
   Result CopyToHost(VkCommandBuffer command) override;
 
+  // Same as CopyToHost() but copies only rows [row_begin, row_begin +
+  // row_count). The copied rows land at the same offsets in the
+  // host-accessible buffer as a whole-image copy would put them.
+  Result CopyRowsToHost(VkCommandBuffer command,
+                        uint32_t row_begin,
+                        uint32_t row_count);
+
   void Shutdown() override;
 
  private:
@@ -67,7 +74,7 @@ class Image : public Resource {
 
   VkImage image_ = VK_NULL_HANDLE;
   VkImageView view_ = VK_NULL_HANDLE;
-  VkDeviceMemory memory_ = VK_NULL_HANDLE;
+  MemoryAllocation allocation_;
 };
 
 }  // namespace vulkan
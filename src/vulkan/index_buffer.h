@@ -42,8 +42,8 @@ class IndexBuffer {
   void Shutdown();
 
   // Assuming that |buffer_| is nullptr and |values| is not empty,
-  // it creates |buffer_| whose size is |sizeof(uint32_t) * values.size()|
-  // and coverts |values| as uint32 values and copies them to |buffer_|.
+  // it creates |buffer_| and copies |values| to it, packed as uint16
+  // when every index fits in 16 bits and as uint32 otherwise.
   Result SendIndexData(VkCommandBuffer command,
                        const VkPhysicalDeviceMemoryProperties& properties,
                        const std::vector<Value>& values);
@@ -54,6 +54,8 @@ class IndexBuffer {
  private:
   Device* device_ = nullptr;
   std::unique_ptr<Buffer> buffer_;
+  // Packing chosen by SendIndexData() from the index values.
+  VkIndexType index_type_ = VK_INDEX_TYPE_UINT32;
 };
 
 }  // namespace vulkan
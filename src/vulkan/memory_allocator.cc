@@ -0,0 +1,344 @@
+// Copyright 2018 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/vulkan/memory_allocator.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "src/make_unique.h"
+#include "src/vulkan/device.h"
+
+namespace amber {
+namespace vulkan {
+namespace {
+
+// Size of a regular block. Allocations larger than this get a dedicated
+// block of exactly their size.
+const VkDeviceSize kBlockSize = 16 * 1024 * 1024;
+
+}  // namespace
+
+MemoryAllocator::MemoryAllocator(Device* device) : device_(device) {}
+
+MemoryAllocator::~MemoryAllocator() = default;
+
+Result MemoryAllocator::Allocate(const VkMemoryRequirements& requirements,
+                                 uint32_t memory_type_index,
+                                 bool is_image,
+                                 MemoryAllocation* allocation) {
+  if (allocation == nullptr)
+    return Result("Vulkan::Given MemoryAllocation pointer is nullptr");
+
+  for (auto& block : blocks_) {
+    if (block->memory_type_index != memory_type_index ||
+        block->is_image != is_image) {
+      continue;
+    }
+
+    if (AllocateFromBlock(block.get(), requirements, allocation)) {
+      TrackRangeAllocated(memory_type_index, is_image, requirements.size);
+      return {};
+    }
+  }
+
+  VkDeviceSize block_size = kBlockSize;
+  if (requirements.size > block_size)
+    block_size = requirements.size;
+
+  Block* block = nullptr;
+  Result r = CreateBlock(block_size, memory_type_index, is_image, &block);
+  if (!r.IsSuccess())
+    return r;
+
+  if (!AllocateFromBlock(block, requirements, allocation)) {
+    return Result(
+        "Vulkan::MemoryAllocator fresh block can not fit the allocation");
+  }
+
+  TrackRangeAllocated(memory_type_index, is_image, requirements.size);
+  return {};
+}
+
+void MemoryAllocator::Free(const MemoryAllocation& allocation) {
+  if (allocation.memory == VK_NULL_HANDLE)
+    return;
+
+  for (auto& block : blocks_) {
+    if (block->memory != allocation.memory)
+      continue;
+
+    FreeRange range = {allocation.offset, allocation.size};
+    auto& ranges = block->free_ranges;
+    auto it = std::lower_bound(
+        ranges.begin(), ranges.end(), range,
+        [](const FreeRange& a, const FreeRange& b) {
+          return a.offset < b.offset;
+        });
+    it = ranges.insert(it, range);
+
+    // Coalesce with the following and preceding range when they touch, so
+    // recycled ranges can serve allocations as large as the original ones.
+    if (it + 1 != ranges.end() && it->offset + it->size == (it + 1)->offset) {
+      it->size += (it + 1)->size;
+      it = ranges.erase(it + 1) - 1;
+    }
+    if (it != ranges.begin() && (it - 1)->offset + (it - 1)->size == it->offset) {
+      (it - 1)->size += it->size;
+      ranges.erase(it);
+    }
+
+    TrackRangeFreed(block->memory_type_index, block->is_image,
+                    allocation.size);
+    return;
+  }
+}
+
+void MemoryAllocator::Shutdown() {
+  for (auto& block : blocks_) {
+    if (block->mapped != nullptr)
+      device_->GetPtrs()->vkUnmapMemory(device_->GetDevice(), block->memory);
+
+    device_->GetPtrs()->vkFreeMemory(device_->GetDevice(),
+                                     block->memory,
+                                     device_->GetHostAllocator());
+  }
+  blocks_.clear();
+
+  // Everything is back with the driver; only the peaks remain meaningful.
+  for (auto& stats : heap_stats_) {
+    stats.live_block_bytes = 0;
+    stats.live_buffer_bytes = 0;
+    stats.live_image_bytes = 0;
+  }
+}
+
+Result MemoryAllocator::CreateBlock(VkDeviceSize size,
+                                    uint32_t memory_type_index,
+                                    bool is_image,
+                                    Block** block_out) {
+  VkMemoryAllocateInfo alloc_info = VkMemoryAllocateInfo();
+  alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  alloc_info.allocationSize = size;
+  alloc_info.memoryTypeIndex = memory_type_index;
+
+  VkDeviceMemory memory = VK_NULL_HANDLE;
+  if (device_->GetPtrs()->vkAllocateMemory(device_->GetDevice(),
+                                           &alloc_info,
+                                           device_->GetHostAllocator(),
+                                           &memory) != VK_SUCCESS) {
+    return Result("Vulkan::Calling vkAllocateMemory Fail");
+  }
+
+  auto block = MakeUnique<Block>();
+  block->memory = memory;
+  block->size = size;
+  block->memory_type_index = memory_type_index;
+  block->is_image = is_image;
+  block->free_ranges.push_back({0, size});
+
+  if (IsHostVisible(memory_type_index)) {
+    if (device_->GetPtrs()->vkMapMemory(device_->GetDevice(), memory, 0,
+                                        VK_WHOLE_SIZE, 0,
+                                        &block->mapped) != VK_SUCCESS) {
+      device_->GetPtrs()->vkFreeMemory(device_->GetDevice(),
+                                       memory,
+                                       device_->GetHostAllocator());
+      return Result("Vulkan::Calling vkMapMemory Fail");
+    }
+  }
+
+  blocks_.push_back(std::move(block));
+  *block_out = blocks_.back().get();
+
+  MemoryHeapStats* stats = StatsForMemoryType(memory_type_index);
+  stats->live_block_bytes += size;
+  if (stats->live_block_bytes > stats->peak_block_bytes)
+    stats->peak_block_bytes = stats->live_block_bytes;
+
+  return {};
+}
+
+MemoryHeapStats* MemoryAllocator::StatsForMemoryType(
+    uint32_t memory_type_index) {
+  uint32_t heap_index = device_->GetPhysicalMemoryProperties()
+                            .memoryTypes[memory_type_index]
+                            .heapIndex;
+  if (heap_index >= heap_stats_.size())
+    heap_stats_.resize(heap_index + 1);
+  return &heap_stats_[heap_index];
+}
+
+void MemoryAllocator::TrackRangeAllocated(uint32_t memory_type_index,
+                                          bool is_image,
+                                          VkDeviceSize size) {
+  MemoryHeapStats* stats = StatsForMemoryType(memory_type_index);
+  uint64_t& live =
+      is_image ? stats->live_image_bytes : stats->live_buffer_bytes;
+  uint64_t& peak =
+      is_image ? stats->peak_image_bytes : stats->peak_buffer_bytes;
+  live += size;
+  if (live > peak)
+    peak = live;
+}
+
+void MemoryAllocator::TrackRangeFreed(uint32_t memory_type_index,
+                                      bool is_image,
+                                      VkDeviceSize size) {
+  MemoryHeapStats* stats = StatsForMemoryType(memory_type_index);
+  uint64_t& live =
+      is_image ? stats->live_image_bytes : stats->live_buffer_bytes;
+  live = live >= size ? live - size : 0;
+}
+
+bool MemoryAllocator::AllocateFromBlock(Block* block,
+                                        const VkMemoryRequirements& requirements,
+                                        MemoryAllocation* allocation) {
+  VkDeviceSize alignment = requirements.alignment ? requirements.alignment : 1;
+
+  auto& ranges = block->free_ranges;
+  for (auto it = ranges.begin(); it != ranges.end(); ++it) {
+    VkDeviceSize aligned_offset =
+        (it->offset + alignment - 1) / alignment * alignment;
+    VkDeviceSize padding = aligned_offset - it->offset;
+    if (it->size < padding + requirements.size)
+      continue;
+
+    allocation->memory = block->memory;
+    allocation->offset = aligned_offset;
+    allocation->size = requirements.size;
+    allocation->cpu_memory =
+        block->mapped == nullptr
+            ? nullptr
+            : static_cast<uint8_t*>(block->mapped) + aligned_offset;
+
+    // Keep the alignment padding, if any, as its own free range so a later
+    // allocation with a smaller alignment can still use it.
+    VkDeviceSize tail_offset = aligned_offset + requirements.size;
+    VkDeviceSize tail_size = it->size - padding - requirements.size;
+    if (padding > 0) {
+      it->size = padding;
+      if (tail_size > 0)
+        ranges.insert(it + 1, {tail_offset, tail_size});
+    } else if (tail_size > 0) {
+      *it = {tail_offset, tail_size};
+    } else {
+      ranges.erase(it);
+    }
+
+    return true;
+  }
+
+  return false;
+}
+
+bool MemoryAllocator::IsHostVisible(uint32_t memory_type_index) const {
+  return (device_->GetPhysicalMemoryProperties()
+              .memoryTypes[memory_type_index]
+              .propertyFlags &
+          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) ==
+         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+}
+
+bool MemoryAllocator::IsHostCoherent(uint32_t memory_type_index) const {
+  return (device_->GetPhysicalMemoryProperties()
+              .memoryTypes[memory_type_index]
+              .propertyFlags &
+          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) ==
+         VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+}
+
+Result MemoryAllocator::Flush(const MemoryAllocation& allocation) {
+  return FlushOrInvalidate(allocation, 0, allocation.size, true);
+}
+
+Result MemoryAllocator::Invalidate(const MemoryAllocation& allocation) {
+  return FlushOrInvalidate(allocation, 0, allocation.size, false);
+}
+
+Result MemoryAllocator::FlushRange(const MemoryAllocation& allocation,
+                                   VkDeviceSize offset,
+                                   VkDeviceSize size) {
+  if (offset > allocation.size)
+    offset = allocation.size;
+  if (size > allocation.size - offset)
+    size = allocation.size - offset;
+  return FlushOrInvalidate(allocation, offset, size, true);
+}
+
+Result MemoryAllocator::InvalidateRange(const MemoryAllocation& allocation,
+                                        VkDeviceSize offset,
+                                        VkDeviceSize size) {
+  if (offset > allocation.size)
+    offset = allocation.size;
+  if (size > allocation.size - offset)
+    size = allocation.size - offset;
+  return FlushOrInvalidate(allocation, offset, size, false);
+}
+
+Result MemoryAllocator::FlushOrInvalidate(const MemoryAllocation& allocation,
+                                          VkDeviceSize offset,
+                                          VkDeviceSize size,
+                                          bool flush) {
+  if (allocation.memory == VK_NULL_HANDLE)
+    return {};
+
+  Block* block = nullptr;
+  for (auto& candidate : blocks_) {
+    if (candidate->memory == allocation.memory) {
+      block = candidate.get();
+      break;
+    }
+  }
+  if (block == nullptr)
+    return Result("Vulkan::Allocation does not belong to this allocator");
+
+  if (IsHostCoherent(block->memory_type_index))
+    return {};
+
+  // Mapped memory range offsets and sizes must be multiples of
+  // nonCoherentAtomSize; widen the requested range accordingly and
+  // clamp it to the block.
+  const VkDeviceSize atom_size =
+      device_->GetPhysicalDeviceProperties().limits.nonCoherentAtomSize;
+  VkDeviceSize begin = ((allocation.offset + offset) / atom_size) * atom_size;
+  VkDeviceSize end =
+      ((allocation.offset + offset + size + atom_size - 1) / atom_size) *
+      atom_size;
+  if (end > block->size)
+    end = block->size;
+
+  VkMappedMemoryRange range = VkMappedMemoryRange();
+  range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+  range.memory = block->memory;
+  range.offset = begin;
+  range.size = end - begin;
+
+  if (flush) {
+    if (device_->GetPtrs()->vkFlushMappedMemoryRanges(device_->GetDevice(), 1,
+                                                      &range) != VK_SUCCESS) {
+      return Result("Vulkan::Calling vkFlushMappedMemoryRanges Fail");
+    }
+    return {};
+  }
+
+  if (device_->GetPtrs()->vkInvalidateMappedMemoryRanges(
+          device_->GetDevice(), 1, &range) != VK_SUCCESS) {
+    return Result("Vulkan::Calling vkInvalidateMappedMemoryRanges Fail");
+  }
+  return {};
+}
+
+}  // namespace vulkan
+}  // namespace amber
@@ -0,0 +1,157 @@
+// Copyright 2018 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_VULKAN_MEMORY_ALLOCATOR_H_
+#define SRC_VULKAN_MEMORY_ALLOCATOR_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "amber/result.h"
+#include "amber/vulkan_header.h"
+
+namespace amber {
+namespace vulkan {
+
+class Device;
+
+// A range of a VkDeviceMemory block handed out by MemoryAllocator. The
+// resource using it must bind at |offset|. |cpu_memory| points at the start
+// of the range when the memory type is host visible and is null otherwise.
+struct MemoryAllocation {
+  VkDeviceMemory memory = VK_NULL_HANDLE;
+  VkDeviceSize offset = 0;
+  VkDeviceSize size = 0;
+  void* cpu_memory = nullptr;
+};
+
+// Live and high-water allocation counts for one device memory heap.
+// Block bytes are what the driver actually handed out; buffer and image
+// bytes are the portions of it lent to resources of each kind.
+struct MemoryHeapStats {
+  uint64_t live_block_bytes = 0;
+  uint64_t peak_block_bytes = 0;
+  uint64_t live_buffer_bytes = 0;
+  uint64_t peak_buffer_bytes = 0;
+  uint64_t live_image_bytes = 0;
+  uint64_t peak_image_bytes = 0;
+};
+
+// Slab sub-allocator for device memory. Drivers cap the total number of
+// allocations, often at 4096, and every vkAllocateMemory is a kernel round
+// trip, so instead of one allocation per buffer or image this carves large
+// VkDeviceMemory blocks into aligned ranges. Host visible blocks are mapped
+// once when they are created. Freed ranges go back on a per-block free list,
+// coalesced with their neighbors, and are recycled by later allocations.
+class MemoryAllocator {
+ public:
+  explicit MemoryAllocator(Device* device);
+  ~MemoryAllocator();
+
+  // Reserves |requirements.size| bytes aligned to |requirements.alignment|
+  // from a block of |memory_type_index| memory and describes the range in
+  // |allocation|. Buffer and image resources never share a block so
+  // bufferImageGranularity does not need to be considered; |is_image| picks
+  // which kind of block to use.
+  Result Allocate(const VkMemoryRequirements& requirements,
+                  uint32_t memory_type_index,
+                  bool is_image,
+                  MemoryAllocation* allocation);
+
+  // Returns the range of |allocation| to its block's free list.
+  void Free(const MemoryAllocation& allocation);
+
+  // Makes host writes to the range of |allocation| visible to the device.
+  // A no-op when the range's memory type is host coherent.
+  Result Flush(const MemoryAllocation& allocation);
+
+  // Makes host writes to |size| bytes at |offset| within |allocation|
+  // visible to the device, clamped to the allocation. A no-op when the
+  // range's memory type is host coherent.
+  Result FlushRange(const MemoryAllocation& allocation,
+                    VkDeviceSize offset,
+                    VkDeviceSize size);
+
+  // Makes device writes to the range of |allocation| visible to the host.
+  // A no-op when the range's memory type is host coherent.
+  Result Invalidate(const MemoryAllocation& allocation);
+
+  // Makes device writes to |size| bytes at |offset| within |allocation|
+  // visible to the host, clamped to the allocation. A no-op when the
+  // range's memory type is host coherent.
+  Result InvalidateRange(const MemoryAllocation& allocation,
+                         VkDeviceSize offset,
+                         VkDeviceSize size);
+
+  // Unmaps and releases every block. All ranges handed out by this allocator
+  // become invalid.
+  void Shutdown();
+
+  // Per heap allocation counters, indexed by the heap index in the
+  // device's memory properties. Peaks persist across Shutdown() so a
+  // whole script's high-water mark can be reported at the end.
+  const std::vector<MemoryHeapStats>& GetHeapStats() const {
+    return heap_stats_;
+  }
+
+ private:
+  // An unallocated range of a block, sorted by offset within the free list.
+  struct FreeRange {
+    VkDeviceSize offset;
+    VkDeviceSize size;
+  };
+
+  struct Block {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize size = 0;
+    uint32_t memory_type_index = 0;
+    bool is_image = false;
+    void* mapped = nullptr;
+    std::vector<FreeRange> free_ranges;
+  };
+
+  Result CreateBlock(VkDeviceSize size,
+                     uint32_t memory_type_index,
+                     bool is_image,
+                     Block** block_out);
+  bool AllocateFromBlock(Block* block,
+                         const VkMemoryRequirements& requirements,
+                         MemoryAllocation* allocation);
+  bool IsHostVisible(uint32_t memory_type_index) const;
+  bool IsHostCoherent(uint32_t memory_type_index) const;
+  Result FlushOrInvalidate(const MemoryAllocation& allocation,
+                           VkDeviceSize offset,
+                           VkDeviceSize size,
+                           bool flush);
+
+  // Counters for the heap of |memory_type_index|, growing |heap_stats_|
+  // on first use.
+  MemoryHeapStats* StatsForMemoryType(uint32_t memory_type_index);
+  void TrackRangeAllocated(uint32_t memory_type_index,
+                           bool is_image,
+                           VkDeviceSize size);
+  void TrackRangeFreed(uint32_t memory_type_index,
+                       bool is_image,
+                       VkDeviceSize size);
+
+  Device* device_ = nullptr;
+  std::vector<std::unique_ptr<Block>> blocks_;
+  std::vector<MemoryHeapStats> heap_stats_;
+};
+
+}  // namespace vulkan
+}  // namespace amber
+
+#endif  // SRC_VULKAN_MEMORY_ALLOCATOR_H_
@@ -17,6 +17,7 @@
 #include <algorithm>
 #include <cassert>
 #include <limits>
+#include <thread>
 #include <utility>
 
 #include "src/command.h"
@@ -33,6 +34,14 @@ namespace {
 
 const char* kDefaultEntryPointName = "main";
 
+// Number of timestamp query pairs available per pipeline; commands timed
+// beyond this between two submissions are not measured.
+const uint32_t kMaxTimestampPairs = 512;
+
+// Number of descriptors with pending data below which they are filled
+// serially; spawning threads costs more than a few memcpys.
+const size_t kMinDescriptorsForParallelFill = 16;
+
 }  // namespace
 
 Pipeline::Pipeline(
@@ -63,6 +72,7 @@ Result Pipeline::Initialize(VkCommandPool pool, VkQueue queue) {
   push_constant_ = MakeUnique<PushConstant>(
       device_, physical_device_properties_.limits.maxPushConstantsSize);
 
+  command_pool_ = pool;
   command_ = MakeUnique<CommandBuffer>(device_, pool, queue);
   return command_->Initialize();
 }
@@ -76,22 +86,82 @@ void Pipeline::Shutdown() {
     command_->Shutdown();
   }
 
+  if (timestamp_pool_)
+    timestamp_pool_->Shutdown();
+
+  if (stats_pool_)
+    stats_pool_->Shutdown();
+
   DestroyVkDescriptorAndPipelineRelatedObjects();
 }
 
+Result Pipeline::RecordTimestampBegin() {
+  if (!command_timing_enabled_)
+    return {};
+
+  if (!timestamp_pool_) {
+    timestamp_pool_ = MakeUnique<TimestampQueryPool>(device_);
+    Result r = timestamp_pool_->Initialize(kMaxTimestampPairs);
+    if (!r.IsSuccess())
+      return r;
+
+    // Count shader invocations of the same commands when the device
+    // supports it; the pools share the pair limit so they stay in step.
+    if (device_->SupportsPipelineStatisticsQuery()) {
+      stats_pool_ = MakeUnique<PipelineStatsQueryPool>(device_);
+      r = stats_pool_->Initialize(kMaxTimestampPairs);
+      if (!r.IsSuccess())
+        return r;
+    }
+  }
+
+  Result r = command_->BeginIfNotInRecording();
+  if (!r.IsSuccess())
+    return r;
+
+  r = timestamp_pool_->RecordBegin(command_->GetCommandBuffer());
+  if (!r.IsSuccess())
+    return r;
+
+  return stats_pool_ ? stats_pool_->RecordBegin(command_->GetCommandBuffer())
+                     : Result();
+}
+
+Result Pipeline::RecordTimestampEnd(const std::string& command_name) {
+  if (!command_timing_enabled_ || !timestamp_pool_)
+    return {};
+
+  const uint32_t pairs_before = timestamp_pool_->GetRecordedPairCount();
+  Result r = timestamp_pool_->RecordEnd(command_->GetCommandBuffer());
+  if (!r.IsSuccess())
+    return r;
+
+  if (stats_pool_) {
+    r = stats_pool_->RecordEnd(command_->GetCommandBuffer());
+    if (!r.IsSuccess())
+      return r;
+  }
+
+  // A pair dropped by a full pool gets no timing entry.
+  if (timestamp_pool_->GetRecordedPairCount() > pairs_before)
+    pending_timing_names_.push_back(command_name);
+  return {};
+}
+
 void Pipeline::DestroyVkDescriptorAndPipelineRelatedObjects() {
   for (auto& info : descriptor_set_info_) {
-    if (info.layout != VK_NULL_HANDLE) {
-      device_->GetPtrs()->vkDestroyDescriptorSetLayout(device_->GetDevice(),
-                                                       info.layout, nullptr);
-    }
+    // The descriptor pool cache owns the layout; just drop the handle.
+    info.layout = VK_NULL_HANDLE;
 
     if (info.empty)
       continue;
 
     if (info.pool != VK_NULL_HANDLE) {
-      device_->GetPtrs()->vkDestroyDescriptorPool(device_->GetDevice(),
-                                                  info.pool, nullptr);
+      // Frees the descriptor set allocated from the pool and puts the
+      // pool back for the next pipeline asking for the same sizes.
+      device_->GetDescriptorPoolCache()->ReleaseDescriptorPool(info.pool);
+      info.pool = VK_NULL_HANDLE;
+      info.vk_desc_set = VK_NULL_HANDLE;
     }
 
     for (auto& desc : info.descriptors_) {
@@ -106,23 +176,21 @@ void Pipeline::DestroyVkDescriptorAndPipelineRelatedObjects() {
 void Pipeline::ResetVkPipelineRelatedObjects() {
   if (pipeline_layout_ != VK_NULL_HANDLE) {
     device_->GetPtrs()->vkDestroyPipelineLayout(device_->GetDevice(),
-                                                pipeline_layout_, nullptr);
+                                                pipeline_layout_,
+                                                device_->GetHostAllocator());
     pipeline_layout_ = VK_NULL_HANDLE;
   }
 
   if (pipeline_ != VK_NULL_HANDLE) {
-    device_->GetPtrs()->vkDestroyPipeline(device_->GetDevice(), pipeline_,
-                                          nullptr);
+    device_->GetPtrs()->vkDestroyPipeline(device_->GetDevice(),
+                                          pipeline_,
+                                          device_->GetHostAllocator());
     pipeline_ = VK_NULL_HANDLE;
   }
 }
 
 Result Pipeline::CreateDescriptorSetLayouts() {
   for (auto& info : descriptor_set_info_) {
-    VkDescriptorSetLayoutCreateInfo desc_info =
-        VkDescriptorSetLayoutCreateInfo();
-    desc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-
     // If there are no descriptors for this descriptor set we only
     // need to create its layout and there will be no bindings.
     std::vector<VkDescriptorSetLayoutBinding> bindings;
@@ -133,14 +201,11 @@ Result Pipeline::CreateDescriptorSetLayouts() {
       bindings.back().descriptorCount = 1;
       bindings.back().stageFlags = VK_SHADER_STAGE_ALL;
     }
-    desc_info.bindingCount = static_cast<uint32_t>(bindings.size());
-    desc_info.pBindings = bindings.data();
 
-    if (device_->GetPtrs()->vkCreateDescriptorSetLayout(
-            device_->GetDevice(), &desc_info, nullptr, &info.layout) !=
-        VK_SUCCESS) {
-      return Result("Vulkan::Calling vkCreateDescriptorSetLayout Fail");
-    }
+    Result r = device_->GetDescriptorPoolCache()->GetDescriptorSetLayout(
+        bindings, &info.layout);
+    if (!r.IsSuccess())
+      return r;
   }
 
   return {};
@@ -168,17 +233,10 @@ Result Pipeline::CreateDescriptorPools() {
       pool_sizes.back().descriptorCount = 1;
     }
 
-    VkDescriptorPoolCreateInfo pool_info = VkDescriptorPoolCreateInfo();
-    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    pool_info.maxSets = 1;
-    pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
-    pool_info.pPoolSizes = pool_sizes.data();
-
-    if (device_->GetPtrs()->vkCreateDescriptorPool(device_->GetDevice(),
-                                                   &pool_info, nullptr,
-                                                   &info.pool) != VK_SUCCESS) {
-      return Result("Vulkan::Calling vkCreateDescriptorPool Fail");
-    }
+    Result r = device_->GetDescriptorPoolCache()->AcquireDescriptorPool(
+        pool_sizes, &info.pool);
+    if (!r.IsSuccess())
+      return r;
   }
 
   return {};
@@ -224,9 +282,10 @@ Result Pipeline::CreatePipelineLayout() {
     pipeline_layout_info.pPushConstantRanges = &push_const_range;
   }
 
-  if (device_->GetPtrs()->vkCreatePipelineLayout(
-          device_->GetDevice(), &pipeline_layout_info, nullptr,
-          &pipeline_layout_) != VK_SUCCESS) {
+  if (device_->GetPtrs()->vkCreatePipelineLayout(device_->GetDevice(),
+                                                 &pipeline_layout_info,
+                                                 device_->GetHostAllocator(),
+                                                 &pipeline_layout_) != VK_SUCCESS) {
     return Result("Vulkan::Calling vkCreatePipelineLayout Fail");
   }
 
@@ -256,6 +315,39 @@ Result Pipeline::CreateVkDescriptorRelatedObjectsAndPipelineLayoutIfNeeded() {
 }
 
 Result Pipeline::UpdateDescriptorSetsIfNeeded() {
+  bool update_needed = false;
+  for (auto& info : descriptor_set_info_) {
+    for (auto& desc : info.descriptors_) {
+      if (desc->IsDescriptorSetUpdateNeeded()) {
+        update_needed = true;
+        break;
+      }
+    }
+
+    if (update_needed)
+      break;
+  }
+
+  if (!update_needed)
+    return {};
+
+  // Note that a command updating a descriptor set and a command using
+  // it must be submitted separately, because using a descriptor set
+  // while updating it is not safe. Commands using the sets were already
+  // flushed with a wait when the new resources were created, and the
+  // copies recorded since then do not reference the sets, so submitting
+  // without waiting is enough here. The CPU keeps recording the next
+  // commands while the copies execute.
+  if (command_->IsInRecordingState()) {
+    Result r = command_->End();
+    if (!r.IsSuccess())
+      return r;
+
+    r = command_->Submit(GetFenceTimeout());
+    if (!r.IsSuccess())
+      return r;
+  }
+
   for (auto& info : descriptor_set_info_) {
     for (auto& desc : info.descriptors_) {
       Result r = desc->UpdateDescriptorSetIfNeeded(info.vk_desc_set);
@@ -267,9 +359,9 @@ Result Pipeline::UpdateDescriptorSetsIfNeeded() {
   return {};
 }
 
-Result Pipeline::RecordPushConstant() {
-  return push_constant_->RecordPushConstantVkCommand(
-      command_->GetCommandBuffer(), pipeline_layout_);
+Result Pipeline::RecordPushConstant(VkCommandBuffer command_buffer) {
+  return push_constant_->RecordPushConstantVkCommand(command_buffer,
+                                                     pipeline_layout_);
 }
 
 Result Pipeline::AddPushConstant(const BufferCommand* command) {
@@ -277,6 +369,16 @@ Result Pipeline::AddPushConstant(const BufferCommand* command) {
     return Result(
         "Pipeline::AddPushConstant BufferCommand type is not push constant");
 
+  // A host side data update invalidates any recording preserved for
+  // replay; every iteration of this stream must re-record.
+  DisableReplay();
+
+  // The pipeline layout is destroyed below and commands still sitting in
+  // the command buffer may reference it.
+  Result r = ProcessCommands();
+  if (!r.IsSuccess())
+    return r;
+
   ResetVkPipelineRelatedObjects();
 
   return push_constant_->AddBufferData(command);
@@ -289,6 +391,10 @@ Result Pipeline::AddDescriptor(const BufferCommand* buffer_command) {
   if (!buffer_command->IsSSBO() && !buffer_command->IsUniform())
     return Result("Pipeline::AddDescriptor not supported buffer type");
 
+  // A host side data update invalidates any recording preserved for
+  // replay; every iteration of this stream must re-record.
+  DisableReplay();
+
   const uint32_t desc_set = buffer_command->GetDescriptorSet();
   if (desc_set >= descriptor_set_info_.size()) {
     for (size_t i = descriptor_set_info_.size();
@@ -338,9 +444,31 @@ Result Pipeline::AddDescriptor(const BufferCommand* buffer_command) {
         "and binding");
   }
 
-  desc->AddToBufferInputQueue(
-      buffer_command->GetDatumType().GetType(), buffer_command->GetOffset(),
-      buffer_command->GetSize(), buffer_command->GetValues());
+  if (buffer_command->HasRawBytes()) {
+    // Snapshotted contents being restored by a checkpoint; the bytes
+    // are already in buffer layout.
+    desc->AddRawToBufferInputQueue(buffer_command->GetOffset(),
+                                   buffer_command->GetSize(),
+                                   buffer_command->GetRawBytes());
+  } else if (buffer_command->IsFromDataFile()) {
+    // Bytes mapped from an external binary file, already in buffer
+    // layout; the upload memcpys them without any conversion.
+    desc->AddRawToBufferInputQueue(buffer_command->GetOffset(),
+                                   buffer_command->GetSize(),
+                                   buffer_command->GetDataFileData());
+  } else if (buffer_command->GetGenerator() != BufferDataGenerator::kNone) {
+    // Procedural contents; the generator runs against the mapped
+    // memory at upload time.
+    desc->AddGeneratedToBufferInputQueue(
+        buffer_command->GetDatumType().GetType(), buffer_command->GetOffset(),
+        buffer_command->GetSize(), buffer_command->GetGenerator(),
+        buffer_command->GetGeneratorStart(),
+        buffer_command->GetGeneratorStep());
+  } else {
+    desc->AddToBufferInputQueue(
+        buffer_command->GetDatumType().GetType(), buffer_command->GetOffset(),
+        buffer_command->GetSize(), &buffer_command->GetValues());
+  }
 
   return {};
 }
@@ -362,54 +490,190 @@ Result Pipeline::SendDescriptorDataToDeviceIfNeeded() {
   if (!data_send_needed)
     return {};
 
-  Result r = command_->BeginIfNotInRecording();
+  // Creating a resource for a descriptor below requires that the read
+  // back of its current contents was completed, and direct host writes
+  // to a resource must not race with batched GPU work that reads it.
+  // Flush everything recorded so far to guarantee both.
+  Result r = ProcessCommands();
   if (!r.IsSuccess())
     return r;
 
+  // Create every resource before any is filled so a run of back to back
+  // creations is served from the same sub-allocator blocks in one pass.
+  std::vector<Descriptor*> descriptors;
   for (auto& info : descriptor_set_info_) {
     for (auto& desc : info.descriptors_) {
       r = desc->CreateResourceIfNeeded(memory_properties_);
       if (!r.IsSuccess())
         return r;
+      descriptors.push_back(desc.get());
     }
   }
 
-  r = command_->End();
-  if (!r.IsSuccess())
-    return r;
-
-  // Note that if a buffer for a descriptor is host accessible and
-  // does not need to record a command to copy data to device, it
-  // directly writes data to the buffer. The direct write must be
-  // done after resizing backed buffer i.e., copying data to the new
-  // buffer from the old one. Thus, we must submit commands here to
-  // guarantee this.
-  r = command_->SubmitAndReset(GetFenceTimeout());
-  if (!r.IsSuccess())
-    return r;
-
   r = command_->BeginIfNotInRecording();
   if (!r.IsSuccess())
     return r;
 
-  for (auto& info : descriptor_set_info_) {
-    for (auto& desc : info.descriptors_) {
-      r = desc->RecordCopyDataToResourceIfNeeded(command_->GetCommandBuffer());
-      if (!r.IsSuccess())
-        return r;
+  // Filling a buffer descriptor records nothing into the command buffer;
+  // it is host writes into the descriptor's own mapped region plus a
+  // flush, both safe to run concurrently. Scripts with many bindings
+  // split the descriptors over threads, the rest fill serially.
+  auto fill_range = [this, &descriptors](size_t begin, size_t end,
+                                         Result* result) {
+    for (size_t i = begin; i < end; ++i) {
+      Result fill_result = descriptors[i]->RecordCopyDataToResourceIfNeeded(
+          command_->GetCommandBuffer());
+      if (!fill_result.IsSuccess()) {
+        *result = fill_result;
+        return;
+      }
+    }
+  };
+
+  size_t thread_count = std::thread::hardware_concurrency();
+  if (thread_count == 0)
+    thread_count = 1;
+  thread_count = std::min(thread_count, descriptors.size());
+
+  if (thread_count > 1 &&
+      descriptors.size() >= kMinDescriptorsForParallelFill) {
+    const size_t per_thread =
+        (descriptors.size() + thread_count - 1) / thread_count;
+    std::vector<Result> results(thread_count);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < thread_count; ++t) {
+      const size_t begin = t * per_thread;
+      const size_t end = std::min(begin + per_thread, descriptors.size());
+      if (begin >= end)
+        break;
+      threads.emplace_back(fill_range, begin, end, &results[t]);
     }
+    for (auto& thread : threads)
+      thread.join();
+    for (const auto& result : results) {
+      if (!result.IsSuccess())
+        return result;
+    }
+  } else {
+    Result fill_result;
+    fill_range(0, descriptors.size(), &fill_result);
+    if (!fill_result.IsSuccess())
+      return fill_result;
+  }
+
+  // Initializers the phase above decided to run on the device - fills
+  // of constant content and copies from the content cache - were
+  // deferred rather than recorded, because the parallel phase cannot
+  // record into the shared command buffer or touch the device's shared
+  // caches; they are recorded serially here.
+  for (auto* desc : descriptors) {
+    bool recorded = false;
+    r = desc->RecordDeferredDeviceWrites(command_->GetCommandBuffer(),
+                                         &recorded);
+    if (!r.IsSuccess())
+      return r;
+    if (recorded)
+      transfer_writes_pending_ = true;
   }
 
+  // One barrier merged over every descriptor makes the host writes above
+  // visible to the device, instead of a full barrier per descriptor.
+  RecordDescriptorMemoryBarrier(false);
+
   return {};
 }
 
-void Pipeline::BindVkDescriptorSets() {
+void Pipeline::RecordDescriptorMemoryBarrier(bool to_host) {
+  const VkPipelineStageFlags device_stages =
+      IsGraphics() ? VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT
+                   : VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+  VkAccessFlags read_access = 0;
+  VkAccessFlags write_access = 0;
+  for (const auto& info : descriptor_set_info_) {
+    for (const auto& desc : info.descriptors_) {
+      if (desc->IsStorageBuffer() || desc->IsDynamicStorageBuffer() ||
+          desc->IsStorageTexelBuffer() || desc->IsStorageImage()) {
+        read_access |= VK_ACCESS_SHADER_READ_BIT;
+        write_access |= VK_ACCESS_SHADER_WRITE_BIT;
+      } else if (desc->IsUniformBuffer() || desc->IsDynamicUniformBuffer() ||
+                 desc->IsUniformTexelBuffer()) {
+        read_access |= VK_ACCESS_UNIFORM_READ_BIT;
+      } else {
+        read_access |= VK_ACCESS_SHADER_READ_BIT;
+      }
+    }
+  }
+
+  if (to_host) {
+    // Only device writes must be made visible to the host; read only
+    // descriptors need no barrier unless a constant initializer fill
+    // wrote one on the device.
+    if (write_access == 0 && !transfer_writes_seen_)
+      return;
+
+    VkPipelineStageFlags src_stages = device_stages;
+    VkAccessFlags src_access = write_access;
+    if (transfer_writes_seen_) {
+      src_stages |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+      src_access |= VK_ACCESS_TRANSFER_WRITE_BIT;
+    }
+    RecordMemoryBarrier(device_, command_->GetCommandBuffer(), src_stages,
+                        src_access, VK_PIPELINE_STAGE_HOST_BIT,
+                        VK_ACCESS_HOST_READ_BIT);
+    return;
+  }
+
+  if (read_access == 0 && write_access == 0)
+    return;
+
+  VkPipelineStageFlags src_stages = VK_PIPELINE_STAGE_HOST_BIT;
+  VkAccessFlags src_access = VK_ACCESS_HOST_WRITE_BIT;
+  if (transfer_writes_pending_) {
+    src_stages |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+    src_access |= VK_ACCESS_TRANSFER_WRITE_BIT;
+    transfer_writes_pending_ = false;
+    transfer_writes_seen_ = true;
+  }
+  RecordMemoryBarrier(device_, command_->GetCommandBuffer(), src_stages,
+                      src_access, device_stages,
+                      read_access | write_access);
+}
+
+void Pipeline::RecordDispatchDependencyBarrierIfNeeded() {
+  if (!dispatch_writes_pending_)
+    return;
+
+  RecordMemoryBarrier(
+      device_, command_->GetCommandBuffer(),
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+  dispatch_writes_pending_ = false;
+}
+
+void Pipeline::MarkDispatchDescriptorWrites() {
+  // Every dispatch of this pipeline binds the same descriptor sets, so
+  // two dispatches depend on each other exactly when the sets contain a
+  // descriptor the first one may have written.
+  for (const auto& info : descriptor_set_info_) {
+    for (const auto& desc : info.descriptors_) {
+      if (desc->IsStorageBuffer() || desc->IsDynamicStorageBuffer() ||
+          desc->IsStorageTexelBuffer() || desc->IsStorageImage()) {
+        dispatch_writes_pending_ = true;
+        return;
+      }
+    }
+  }
+}
+
+void Pipeline::BindVkDescriptorSets(VkCommandBuffer command_buffer) {
   for (size_t i = 0; i < descriptor_set_info_.size(); ++i) {
     if (descriptor_set_info_[i].empty)
       continue;
 
     device_->GetPtrs()->vkCmdBindDescriptorSets(
-        command_->GetCommandBuffer(),
+        command_buffer,
         IsGraphics() ? VK_PIPELINE_BIND_POINT_GRAPHICS
                      : VK_PIPELINE_BIND_POINT_COMPUTE,
         pipeline_layout_, static_cast<uint32_t>(i), 1,
@@ -417,8 +681,8 @@ void Pipeline::BindVkDescriptorSets() {
   }
 }
 
-void Pipeline::BindVkPipeline() {
-  device_->GetPtrs()->vkCmdBindPipeline(command_->GetCommandBuffer(),
+void Pipeline::BindVkPipeline(VkCommandBuffer command_buffer) {
+  device_->GetPtrs()->vkCmdBindPipeline(command_buffer,
                                         IsGraphics()
                                             ? VK_PIPELINE_BIND_POINT_GRAPHICS
                                             : VK_PIPELINE_BIND_POINT_COMPUTE,
@@ -435,25 +699,15 @@ Result Pipeline::ReadbackDescriptorsToHostDataQueue() {
       r = desc->RecordCopyDataToHost(command_->GetCommandBuffer());
       if (!r.IsSuccess())
         return r;
-    }
-  }
-
-  r = command_->End();
-  if (!r.IsSuccess())
-    return r;
-
-  r = command_->SubmitAndReset(GetFenceTimeout());
-  if (!r.IsSuccess())
-    return r;
 
-  for (auto& desc_set : descriptor_set_info_) {
-    for (auto& desc : desc_set.descriptors_) {
-      r = desc->MoveResourceToBufferOutput();
-      if (!r.IsSuccess())
-        return r;
+      descriptor_readback_pending_ = true;
     }
   }
 
+  // One barrier merged over every descriptor makes the device writes
+  // visible to the host once the commands are submitted.
+  RecordDescriptorMemoryBarrier(true);
+
   return {};
 }
 
@@ -462,6 +716,15 @@ Result Pipeline::GetDescriptorInfo(const uint32_t descriptor_set,
                                    ResourceInfo* info) {
   assert(info);
 
+  // A read back of the descriptor resources may still be sitting in the
+  // command buffer. Complete it so the returned information points at a
+  // stable host copy of the data.
+  if (descriptor_readback_pending_) {
+    Result r = ProcessCommands();
+    if (!r.IsSuccess())
+      return r;
+  }
+
   if (descriptor_set_info_.size() <= descriptor_set) {
     return Result(
         "Pipeline::GetDescriptorInfo no Descriptor class has given descriptor "
@@ -481,6 +744,21 @@ Result Pipeline::GetDescriptorInfo(const uint32_t descriptor_set,
                 ", binding: " + std::to_string(binding) + " does not exist");
 }
 
+void Pipeline::SetDescriptorReadbackWindow(uint32_t descriptor_set,
+                                           uint32_t binding,
+                                           uint64_t offset,
+                                           uint64_t size) {
+  if (descriptor_set_info_.size() <= descriptor_set)
+    return;
+
+  for (auto& desc : descriptor_set_info_[descriptor_set].descriptors_) {
+    if (desc->GetBinding() == binding) {
+      desc->SetReadbackWindow(offset, size);
+      return;
+    }
+  }
+}
+
 const char* Pipeline::GetEntryPointName(VkShaderStageFlagBits stage) const {
   auto it = entry_points_.find(stage);
   if (it != entry_points_.end())
@@ -489,16 +767,210 @@ const char* Pipeline::GetEntryPointName(VkShaderStageFlagBits stage) const {
   return kDefaultEntryPointName;
 }
 
-Result Pipeline::ProcessCommands() {
-  Result r = command_->BeginIfNotInRecording();
+void Pipeline::BeginRepeatIteration() {
+  if (replay_disabled_)
+    return;
+
+  if (replay_ready_) {
+    replay_active_ = true;
+    replay_next_submission_ = 0;
+    replay_recording_skipped_ = false;
+    return;
+  }
+
+  // First repeated iteration: preserve each of its submissions so the
+  // following iterations can resubmit them.
+  replay_capturing_ = true;
+  preserved_info_.clear();
+  command_->BeginPreserving();
+}
+
+Result Pipeline::EndRepeatIteration() {
+  if (replay_capturing_) {
+    replay_capturing_ = false;
+    command_->EndPreserving();
+
+    // A recording still open here is submitted together with the next
+    // iteration's commands; the preserved recordings cannot mirror a
+    // submission spanning two iterations. An iteration without any
+    // submission has nothing worth replaying either.
+    if (command_->IsInRecordingState() || preserved_info_.empty()) {
+      DisableReplay();
+      return {};
+    }
+
+    replay_ready_ = true;
+    return {};
+  }
+
+  if (replay_active_) {
+    replay_active_ = false;
+
+    // Every skipped recording must have been resubmitted and every
+    // preserved submission consumed; the command stream is the same
+    // each iteration, so a mismatch means the recordings no longer
+    // describe it.
+    if (replay_recording_skipped_ ||
+        replay_next_submission_ != preserved_info_.size()) {
+      DisableReplay();
+      return Result(
+          "Vulkan::Pipeline replayed iteration diverged from its preserved "
+          "recordings");
+    }
+  }
+
+  return {};
+}
+
+void Pipeline::DisableReplay() {
+  replay_disabled_ = true;
+  replay_capturing_ = false;
+  replay_ready_ = false;
+  replay_active_ = false;
+  replay_recording_skipped_ = false;
+  command_->EndPreserving();
+  command_->DropPreservedSubmissions(GetFenceTimeout());
+  preserved_info_.clear();
+}
+
+Result Pipeline::ResubmitNextPreserved() {
+  if (replay_next_submission_ >= preserved_info_.size()) {
+    DisableReplay();
+    return Result(
+        "Vulkan::Pipeline replay ran out of preserved submissions");
+  }
+
+  const PreservedSubmissionInfo& info =
+      preserved_info_[replay_next_submission_];
+  Result r =
+      command_->ResubmitPreserved(replay_next_submission_, GetFenceTimeout());
   if (!r.IsSuccess())
     return r;
+  ++replay_next_submission_;
+
+  // The resubmitted recording wrote its timestamp pairs again; restore
+  // the bookkeeping so they resolve into timings like the first time.
+  if (timestamp_pool_ && info.timestamp_pairs > 0) {
+    r = timestamp_pool_->RearmRecordedPairs(info.timestamp_pairs);
+    if (!r.IsSuccess())
+      return r;
+    pending_timing_names_ = info.timing_names;
+  }
+  if (stats_pool_ && info.stats_queries > 0) {
+    r = stats_pool_->RearmRecordedQueries(info.stats_queries);
+    if (!r.IsSuccess())
+      return r;
+  }
+
+  return {};
+}
+
+Result Pipeline::ProcessCommands() {
+  // A preserved recording stands in for the commands the engine skipped
+  // while replaying; resubmit it where the captured iteration submitted.
+  if (replay_recording_skipped_) {
+    replay_recording_skipped_ = false;
+    Result r = ResubmitNextPreserved();
+    if (!r.IsSuccess())
+      return r;
+  }
+
+  // Nothing recorded, nothing in flight and nothing left to resolve:
+  // the executor flushes before every probe, so back-to-back probes hit
+  // this path and cost no queue or fence traffic at all.
+  if (!command_->IsInRecordingState() && !command_->HasInFlightCommands() &&
+      !descriptor_readback_pending_ &&
+      (!timestamp_pool_ || timestamp_pool_->GetRecordedPairCount() == 0)) {
+    return {};
+  }
+
+  // All GPU work recorded since the last submission goes to the queue as
+  // a single submission. If nothing was recorded e.g., two probes in a
+  // row, skip the submission entirely. Submissions still in flight from
+  // earlier are always awaited so the host sees their results.
+  if (command_->IsInRecordingState()) {
+    // Commands were recorded while replaying: the preserved recordings
+    // do not cover them, so fall back to recording every iteration.
+    if (replay_active_)
+      DisableReplay();
+
+    Result r = command_->End();
+    if (!r.IsSuccess())
+      return r;
+
+    r = command_->Submit(GetFenceTimeout());
+    if (!r.IsSuccess())
+      return r;
+
+    // Remember the timing bookkeeping of the submission just preserved;
+    // a replay of it must restore the same state.
+    if (replay_capturing_) {
+      PreservedSubmissionInfo info;
+      info.timestamp_pairs =
+          timestamp_pool_ ? timestamp_pool_->GetRecordedPairCount() : 0;
+      info.stats_queries =
+          stats_pool_ ? stats_pool_->GetRecordedQueryCount() : 0;
+      info.timing_names = pending_timing_names_;
+      preserved_info_.push_back(info);
+    }
+  }
 
-  r = command_->End();
+  Result r = command_->WaitForInFlightCommands(GetFenceTimeout());
   if (!r.IsSuccess())
     return r;
 
-  return command_->SubmitAndReset(GetFenceTimeout());
+  // The wait ordered all device work; the next dispatch depends on
+  // nothing still outstanding.
+  dispatch_writes_pending_ = false;
+
+  // All submissions holding timestamp pairs completed; resolve them into
+  // per command durations.
+  if (timestamp_pool_ && timestamp_pool_->GetRecordedPairCount() > 0) {
+    std::vector<uint64_t> durations_ns;
+    r = timestamp_pool_->FetchResults(&durations_ns);
+    if (!r.IsSuccess())
+      return r;
+
+    // The stats pool recorded a query per timestamp pair; the counts at
+    // index |i| belong to the command timed by pair |i|.
+    std::vector<PipelineStatsQueryPool::Stats> stats;
+    if (stats_pool_) {
+      r = stats_pool_->FetchResults(&stats);
+      if (!r.IsSuccess())
+        return r;
+    }
+
+    for (size_t i = 0; i < durations_ns.size(); ++i) {
+      CommandTiming timing;
+      if (i < pending_timing_names_.size())
+        timing.command_name = pending_timing_names_[i];
+      timing.gpu_duration_ns = durations_ns[i];
+      if (i < stats.size()) {
+        timing.vertex_invocations = stats[i].vertex_invocations;
+        timing.fragment_invocations = stats[i].fragment_invocations;
+        timing.compute_invocations = stats[i].compute_invocations;
+      }
+      command_timings_.push_back(timing);
+    }
+    pending_timing_names_.clear();
+  }
+
+  if (!descriptor_readback_pending_)
+    return {};
+
+  descriptor_readback_pending_ = false;
+  for (auto& desc_set : descriptor_set_info_) {
+    for (auto& desc : desc_set.descriptors_) {
+      if (!desc->HasPendingReadback())
+        continue;
+
+      r = desc->MoveResourceToBufferOutput();
+      if (!r.IsSuccess())
+        return r;
+    }
+  }
+
+  return {};
 }
 
 }  // namespace vulkan
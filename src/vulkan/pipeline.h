@@ -50,8 +50,10 @@ class Pipeline {
 
   Result AddDescriptor(const BufferCommand*);
 
-  // Read back the contents of resources of all descriptors to a
-  // buffer data object and put it into buffer data queue in host.
+  // Record commands copying the contents of resources of all descriptors
+  // to their host accessible memory. The copied data is moved to the
+  // buffer data queue in host by the next ProcessCommands(), after the
+  // recorded commands were actually submitted.
   Result ReadbackDescriptorsToHostDataQueue();
 
   // Add information of how and what to do with push constant.
@@ -62,16 +64,74 @@ class Pipeline {
                            const uint32_t binding,
                            ResourceInfo* info);
 
+  // Restrict the next readback of the given descriptor to |size| bytes
+  // at |offset|; see Descriptor::SetReadbackWindow(). A no-op when no
+  // such descriptor exists; GetDescriptorInfo() reports that case.
+  void SetDescriptorReadbackWindow(uint32_t descriptor_set,
+                                   uint32_t binding,
+                                   uint64_t offset,
+                                   uint64_t size);
+
   void SetEntryPointName(VkShaderStageFlagBits stage,
                          const std::string& entry) {
+    auto it = entry_points_.find(stage);
+    if (it != entry_points_.end() && it->second == entry)
+      return;
+
     entry_points_[stage] = entry;
+    ++entry_point_generation_;
   }
 
-  // End recording command buffer if it is in recording state. This
-  // method also submits commands in the command buffer and reset
-  // the command buffer.
+  // Submit all commands recorded since the last submission as a single
+  // submission and wait for them with a single fence wait. If the command
+  // buffer has nothing recorded, no submission happens. Descriptor read
+  // backs recorded by ReadbackDescriptorsToHostDataQueue() are moved to
+  // the buffer data queue in host after the wait. Timestamp pairs whose
+  // submission completed are resolved into |command_timings_|.
   virtual Result ProcessCommands();
 
+  // Called by the engine at the start of a repeated execution of the
+  // same command stream. The first repeated iteration preserves each of
+  // its submissions; later iterations resubmit the preserved recordings
+  // instead of recording the same commands again.
+  void BeginRepeatIteration();
+  // Called when the repeated execution completed. Decides whether the
+  // iteration's recordings can be replayed, and whether a replayed
+  // iteration stayed aligned with them.
+  Result EndRepeatIteration();
+
+  // True while the current iteration replays preserved recordings; the
+  // engine skips its recording commands then.
+  bool IsReplaying() const { return replay_active_; }
+
+  // Note that a recording command was skipped because the pipeline is
+  // replaying. The next ProcessCommands() resubmits the preserved
+  // recording standing in for it.
+  void SkipReplayedRecording() { replay_recording_skipped_ = true; }
+
+  // Turn replay off for good and drop the preserved recordings. Called
+  // when a host side update - descriptor or push constant data - makes
+  // them stale, or when commands are recorded that they do not cover.
+  void DisableReplay();
+
+  // Turn GPU timing of draws and dispatches on this pipeline on or off.
+  void SetCommandTimingEnabled(bool enabled) {
+    command_timing_enabled_ = enabled;
+  }
+
+  // Record the opening timestamp of a timed command. Makes sure the
+  // command buffer is in recording state. A no-op when timing is off.
+  Result RecordTimestampBegin();
+  // Record the closing timestamp of the command opened by
+  // RecordTimestampBegin() and remember |command_name| for its timing
+  // entry. A no-op when timing is off.
+  Result RecordTimestampEnd(const std::string& command_name);
+
+  // GPU durations resolved by ProcessCommands() so far.
+  const std::vector<CommandTiming>& GetCommandTimings() const {
+    return command_timings_;
+  }
+
   virtual void Shutdown();
 
  protected:
@@ -98,11 +158,32 @@ class Pipeline {
   Result UpdateDescriptorSetsIfNeeded();
 
   Result SendDescriptorDataToDeviceIfNeeded();
-  void BindVkPipeline();
-  void BindVkDescriptorSets();
-
-  // Record a Vulkan command for push contant.
-  Result RecordPushConstant();
+  // Record the pipeline or descriptor set binds into |command_buffer|,
+  // which is the primary command buffer for ordinary draws and a
+  // secondary one when a draw run is recorded on worker threads.
+  void BindVkPipeline(VkCommandBuffer command_buffer);
+  void BindVkDescriptorSets(VkCommandBuffer command_buffer);
+
+  // Record one memory barrier covering every descriptor resource of
+  // this pipeline instead of one barrier per descriptor. |to_host|
+  // selects the direction: device writes to host reads when true, host
+  // writes to device accesses otherwise. Nothing is recorded when the
+  // direction needs no barrier e.g., read only descriptors to host.
+  void RecordDescriptorMemoryBarrier(bool to_host);
+
+  // Record an execution barrier before the next dispatch only when a
+  // dispatch recorded earlier may have written a descriptor the next
+  // one touches. A pipeline without writable descriptors never records
+  // one, so its dispatches stay independent and overlap on the GPU.
+  void RecordDispatchDependencyBarrierIfNeeded();
+
+  // Note that a dispatch was recorded; when the pipeline has storage
+  // descriptors the dispatch may have written them, making every later
+  // dispatch dependent on it.
+  void MarkDispatchDescriptorWrites();
+
+  // Record a Vulkan command for push contant into |command_buffer|.
+  Result RecordPushConstant(VkCommandBuffer command_buffer);
 
   const std::vector<VkPipelineShaderStageCreateInfo>& GetShaderStageInfo()
       const {
@@ -112,12 +193,25 @@ class Pipeline {
   const char* GetEntryPointName(VkShaderStageFlagBits stage) const;
   uint32_t GetFenceTimeout() const { return fence_timeout_ms_; }
 
+  // Bumped whenever an entry point actually changes; a VkPipeline built
+  // under one generation is stale under another.
+  uint64_t GetEntryPointGeneration() const { return entry_point_generation_; }
+
+  // True while submissions preserved for replay exist; their recordings
+  // may still reference objects retired since they were made.
+  bool HasPreservedRecordings() const {
+    return command_ && command_->GetPreservedSubmissionCount() > 0;
+  }
+
   VkPipeline pipeline_ = VK_NULL_HANDLE;
   VkPipelineLayout pipeline_layout_ = VK_NULL_HANDLE;
 
   Device* device_ = nullptr;
   VkPhysicalDeviceMemoryProperties memory_properties_;
   std::unique_ptr<CommandBuffer> command_;
+  // Pool |command_| was allocated from, kept so further command buffers
+  // e.g., for dispatch slices on other queues, share it.
+  VkCommandPool command_pool_ = VK_NULL_HANDLE;
 
  private:
   struct DescriptorSetInfo {
@@ -143,12 +237,61 @@ class Pipeline {
 
   uint32_t fence_timeout_ms_ = 100;
   bool descriptor_related_objects_already_created_ = false;
+  // True when descriptor read backs were recorded but their data was not
+  // yet moved to host because the recorded commands were not submitted.
+  bool descriptor_readback_pending_ = false;
+  // True when a recorded dispatch may have written a storage descriptor
+  // a later dispatch touches. Cleared by the barrier ordering the two
+  // and by the fence wait of ProcessCommands(), which orders everything.
+  bool dispatch_writes_pending_ = false;
+  // True when constant initializer fills were recorded since the last
+  // descriptor barrier; that barrier then also covers transfer writes.
+  bool transfer_writes_pending_ = false;
+  // True when any such fill was ever recorded, so the read back barrier
+  // makes transfer writes visible to the host as well.
+  bool transfer_writes_seen_ = false;
   std::unordered_map<VkShaderStageFlagBits,
                      std::string,
                      CastHash<VkShaderStageFlagBits>>
       entry_points_;
+  // See GetEntryPointGeneration().
+  uint64_t entry_point_generation_ = 0;
 
   std::unique_ptr<PushConstant> push_constant_;
+
+  // Timing bookkeeping of one preserved submission, restored when the
+  // submission is replayed so its timestamps resolve again.
+  struct PreservedSubmissionInfo {
+    uint32_t timestamp_pairs = 0;
+    uint32_t stats_queries = 0;
+    std::vector<std::string> timing_names;
+  };
+
+  // Resubmit the next preserved recording of the replayed iteration and
+  // restore its timing bookkeeping.
+  Result ResubmitNextPreserved();
+
+  // The current iteration preserves its submissions for later replay.
+  bool replay_capturing_ = false;
+  // A full iteration was preserved and can be replayed.
+  bool replay_ready_ = false;
+  bool replay_active_ = false;
+  bool replay_disabled_ = false;
+  bool replay_recording_skipped_ = false;
+  // Next preserved submission the replayed iteration will consume.
+  size_t replay_next_submission_ = 0;
+  std::vector<PreservedSubmissionInfo> preserved_info_;
+
+  bool command_timing_enabled_ = false;
+  std::unique_ptr<TimestampQueryPool> timestamp_pool_;
+  // Counts shader invocations of the same commands the timestamp pairs
+  // bracket; only created when the device supports pipeline statistics
+  // queries, so the pools record in lockstep or the stats are absent.
+  std::unique_ptr<PipelineStatsQueryPool> stats_pool_;
+  // Names of the commands with recorded but not yet resolved timestamp
+  // pairs, in recording order.
+  std::vector<std::string> pending_timing_names_;
+  std::vector<CommandTiming> command_timings_;
 };
 
 }  // namespace vulkan
@@ -14,7 +14,6 @@
 
 #include "src/vulkan/push_constant.h"
 
-#include <algorithm>
 #include <cassert>
 #include <limits>
 
@@ -35,38 +34,18 @@ PushConstant::PushConstant(Device* device, uint32_t max_push_constant_size)
 PushConstant::~PushConstant() = default;
 
 VkPushConstantRange PushConstant::GetPushConstantRange() {
-  if (push_constant_data_.empty())
+  if (range_end_in_bytes_ == 0)
     return VkPushConstantRange();
 
-  auto it =
-      std::min_element(push_constant_data_.begin(), push_constant_data_.end(),
-                       [](const BufferInput& a, const BufferInput& b) {
-                         return a.offset < b.offset;
-                       });
-  assert(it != push_constant_data_.end());
-
-  uint32_t first_offset = it->offset;
-
-  it = std::max_element(
-      push_constant_data_.begin(), push_constant_data_.end(),
-      [](const BufferInput& a, const BufferInput& b) {
-        return a.offset + static_cast<uint32_t>(a.size_in_bytes) <
-               b.offset + static_cast<uint32_t>(b.size_in_bytes);
-      });
-  assert(it != push_constant_data_.end());
-
-  uint32_t size_in_bytes =
-      it->offset + static_cast<uint32_t>(it->size_in_bytes) - first_offset;
-
   VkPushConstantRange range = VkPushConstantRange();
   range.stageFlags = VK_SHADER_STAGE_ALL;
 
   // Based on Vulkan spec, range.offset must be multiple of 4.
-  range.offset = (first_offset / 4U) * 4U;
+  range.offset = (range_begin_in_bytes_ / 4U) * 4U;
 
   // Based on Vulkan spec, range.size must be multiple of 4.
-  assert(size_in_bytes + 3U <= std::numeric_limits<uint32_t>::max());
-  range.size = ((size_in_bytes + 3U) / 4U) * 4U;
+  assert(range_end_in_bytes_ + 3U <= std::numeric_limits<uint32_t>::max());
+  range.size = ((range_end_in_bytes_ - range.offset + 3U) / 4U) * 4U;
 
   return range;
 }
@@ -74,7 +53,7 @@ VkPushConstantRange PushConstant::GetPushConstantRange() {
 Result PushConstant::RecordPushConstantVkCommand(
     VkCommandBuffer command_buffer,
     VkPipelineLayout pipeline_layout) {
-  if (push_constant_data_.empty())
+  if (range_end_in_bytes_ == 0)
     return {};
 
   auto push_const_range = GetPushConstantRange();
@@ -85,12 +64,6 @@ Result PushConstant::RecordPushConstantVkCommand(
         "exceeds maxPushConstantsSize of VkPhysicalDeviceLimits");
   }
 
-  for (const auto& data : push_constant_data_) {
-    Result r = UpdateMemoryWithInput(data);
-    if (!r.IsSuccess())
-      return r;
-  }
-
   // Based on spec, offset and size in bytes of push constant must
   // be multiple of 4.
   assert(push_const_range.offset % 4U == 0 && push_const_range.size % 4U == 0);
@@ -107,11 +80,27 @@ Result PushConstant::AddBufferData(const BufferCommand* command) {
     return Result(
         "PushConstant::AddBufferData BufferCommand type is not push constant");
 
-  push_constant_data_.emplace_back();
-  push_constant_data_.back().type = command->GetDatumType().GetType();
-  push_constant_data_.back().offset = command->GetOffset();
-  push_constant_data_.back().size_in_bytes = command->GetSize();
-  push_constant_data_.back().values = command->GetValues();
+  // Decode the update straight into the shadow buffer. Recording a draw
+  // then pushes the coalesced range in a single vkCmdPushConstants()
+  // instead of replaying every update given so far.
+  BufferInput input;
+  input.type = command->GetDatumType().GetType();
+  input.offset = command->GetOffset();
+  input.size_in_bytes = command->GetSize();
+  input.values = &command->GetValues();
+  input.raw_data = nullptr;
+  input.generator = BufferDataGenerator::kNone;
+
+  Result r = UpdateMemoryWithInput(input);
+  if (!r.IsSuccess())
+    return r;
+
+  if (range_end_in_bytes_ == 0 || input.offset < range_begin_in_bytes_)
+    range_begin_in_bytes_ = input.offset;
+
+  uint32_t end = input.offset + static_cast<uint32_t>(input.size_in_bytes);
+  if (end > range_end_in_bytes_)
+    range_end_in_bytes_ = end;
 
   return {};
 }
@@ -39,10 +39,9 @@ class PushConstant : public Resource {
   ~PushConstant() override;
 
   // Return a VkPushConstantRange structure whose shader stage flag
-  // is VK_SHADER_STAGE_ALL, offset is minimum |offset| among elements
-  // in |push_constant_data_| rounded down by 4, and size is maximum
-  // |offset| + |size_in_bytes| among elements in |push_constant_data_|
-  // rounded up by 4.
+  // is VK_SHADER_STAGE_ALL, offset is the lowest offset written by
+  // AddBufferData() rounded down by 4, and size is the highest
+  // |offset| + |size_in_bytes| written rounded up by 4.
   VkPushConstantRange GetPushConstantRange();
 
   // Call vkCmdPushConstants() to record a command for push constant
@@ -70,11 +69,14 @@ class PushConstant : public Resource {
   // vkGetPhysicalDeviceProperties().
   uint32_t max_push_constant_size_ = 0;
 
-  // Keep the information of what and how to conduct push constant.
-  // These are applied from lowest index to highest index, so that
-  // if address ranges overlap, then the later values take effect.
-  std::vector<BufferInput> push_constant_data_;
+  // Byte range of |memory_| that AddBufferData() has written so far.
+  // No data was given while |range_end_in_bytes_| is zero. Each update
+  // is decoded into |memory_| as it arrives, so overlapping ranges are
+  // coalesced and later values take effect.
+  uint32_t range_begin_in_bytes_ = 0;
+  uint32_t range_end_in_bytes_ = 0;
 
+  // Shadow copy of the push constant block seen by shaders.
   std::unique_ptr<uint8_t> memory_;
 };
 
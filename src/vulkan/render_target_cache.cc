@@ -0,0 +1,193 @@
+// Copyright 2018 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/vulkan/render_target_cache.h"
+
+#include <utility>
+
+#include "src/make_unique.h"
+#include "src/vulkan/device.h"
+
+namespace amber {
+namespace vulkan {
+namespace {
+
+const VkAttachmentDescription kDefaultAttachmentDesc = {
+    0,                     /* flags */
+    VK_FORMAT_UNDEFINED,   /* format */
+    VK_SAMPLE_COUNT_1_BIT, /* samples */
+    // TODO(jaebaek): Set up proper loadOp, StoreOp.
+    VK_ATTACHMENT_LOAD_OP_DONT_CARE,      /* loadOp */
+    VK_ATTACHMENT_STORE_OP_STORE,         /* storeOp */
+    VK_ATTACHMENT_LOAD_OP_LOAD,           /* stencilLoadOp */
+    VK_ATTACHMENT_STORE_OP_STORE,         /* stencilStoreOp */
+    VK_IMAGE_LAYOUT_UNDEFINED,            /* initialLayout */
+    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, /* finalLayout */
+};
+
+}  // namespace
+
+RenderTargetCache::RenderTargetCache(Device* device) : device_(device) {}
+
+RenderTargetCache::~RenderTargetCache() = default;
+
+Result RenderTargetCache::GetRenderPass(VkFormat color_format,
+                                        VkFormat depth_format,
+                                        bool clear_color,
+                                        bool clear_depth,
+                                        VkRenderPass* render_pass) {
+  for (const auto& entry : render_passes_) {
+    if (entry.color_format == color_format &&
+        entry.depth_format == depth_format &&
+        entry.clear_color == clear_color &&
+        entry.clear_depth == clear_depth) {
+      *render_pass = entry.render_pass;
+      return {};
+    }
+  }
+
+  Result r = CreateRenderPass(color_format, depth_format, clear_color,
+                              clear_depth, render_pass);
+  if (!r.IsSuccess())
+    return r;
+
+  render_passes_.push_back(
+      {color_format, depth_format, clear_color, clear_depth, *render_pass});
+  return {};
+}
+
+Result RenderTargetCache::AcquireFrameBuffer(
+    VkRenderPass render_pass,
+    VkFormat color_format,
+    VkFormat depth_format,
+    uint32_t width,
+    uint32_t height,
+    const VkPhysicalDeviceMemoryProperties& properties,
+    std::unique_ptr<FrameBuffer>* frame) {
+  for (auto it = free_frame_buffers_.begin(); it != free_frame_buffers_.end();
+       ++it) {
+    if (it->color_format == color_format &&
+        it->depth_format == depth_format && it->frame->GetWidth() == width &&
+        it->frame->GetHeight() == height) {
+      *frame = std::move(it->frame);
+      free_frame_buffers_.erase(it);
+      return {};
+    }
+  }
+
+  auto new_frame = MakeUnique<FrameBuffer>(device_, width, height);
+  Result r =
+      new_frame->Initialize(render_pass, color_format, depth_format,
+                            properties);
+  if (!r.IsSuccess())
+    return r;
+
+  *frame = std::move(new_frame);
+  return {};
+}
+
+void RenderTargetCache::ReleaseFrameBuffer(VkFormat color_format,
+                                           VkFormat depth_format,
+                                           std::unique_ptr<FrameBuffer> frame) {
+  if (!frame)
+    return;
+
+  FrameBufferEntry entry;
+  entry.color_format = color_format;
+  entry.depth_format = depth_format;
+  entry.frame = std::move(frame);
+  free_frame_buffers_.push_back(std::move(entry));
+}
+
+void RenderTargetCache::Shutdown() {
+  for (auto& entry : free_frame_buffers_)
+    entry.frame->Shutdown();
+  free_frame_buffers_.clear();
+
+  for (const auto& entry : render_passes_) {
+    device_->GetPtrs()->vkDestroyRenderPass(device_->GetDevice(),
+                                            entry.render_pass,
+                                            device_->GetHostAllocator());
+  }
+  render_passes_.clear();
+}
+
+Result RenderTargetCache::CreateRenderPass(VkFormat color_format,
+                                           VkFormat depth_format,
+                                           bool clear_color,
+                                           bool clear_depth,
+                                           VkRenderPass* render_pass) {
+  VkSubpassDescription subpass_desc = VkSubpassDescription();
+  subpass_desc.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+
+  std::vector<VkAttachmentDescription> attachment_desc;
+
+  VkAttachmentReference color_refer = VkAttachmentReference();
+  VkAttachmentReference depth_refer = VkAttachmentReference();
+
+  if (color_format != VK_FORMAT_UNDEFINED) {
+    attachment_desc.push_back(kDefaultAttachmentDesc);
+    attachment_desc.back().format = color_format;
+    if (clear_color)
+      attachment_desc.back().loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachment_desc.back().initialLayout =
+        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    attachment_desc.back().finalLayout =
+        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    color_refer.attachment = static_cast<uint32_t>(attachment_desc.size() - 1);
+    color_refer.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    subpass_desc.colorAttachmentCount = 1;
+    subpass_desc.pColorAttachments = &color_refer;
+  }
+
+  if (depth_format != VK_FORMAT_UNDEFINED) {
+    attachment_desc.push_back(kDefaultAttachmentDesc);
+    attachment_desc.back().format = depth_format;
+    if (clear_depth) {
+      attachment_desc.back().loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+      attachment_desc.back().stencilLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    }
+    attachment_desc.back().initialLayout =
+        VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    attachment_desc.back().finalLayout =
+        VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    depth_refer.attachment = static_cast<uint32_t>(attachment_desc.size() - 1);
+    depth_refer.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    subpass_desc.pDepthStencilAttachment = &depth_refer;
+  }
+
+  VkRenderPassCreateInfo render_pass_info = VkRenderPassCreateInfo();
+  render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+  render_pass_info.attachmentCount =
+      static_cast<uint32_t>(attachment_desc.size());
+  render_pass_info.pAttachments = attachment_desc.data();
+  render_pass_info.subpassCount = 1;
+  render_pass_info.pSubpasses = &subpass_desc;
+
+  if (device_->GetPtrs()->vkCreateRenderPass(device_->GetDevice(),
+                                             &render_pass_info,
+                                             device_->GetHostAllocator(),
+                                             render_pass) != VK_SUCCESS) {
+    return Result("Vulkan::Calling vkCreateRenderPass Fail");
+  }
+
+  return {};
+}
+
+}  // namespace vulkan
+}  // namespace amber
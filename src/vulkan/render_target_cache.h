@@ -0,0 +1,106 @@
+// Copyright 2018 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_VULKAN_RENDER_TARGET_CACHE_H_
+#define SRC_VULKAN_RENDER_TARGET_CACHE_H_
+
+#include <memory>
+#include <vector>
+
+#include "amber/result.h"
+#include "amber/vulkan_header.h"
+#include "src/vulkan/frame_buffer.h"
+
+namespace amber {
+namespace vulkan {
+
+class Device;
+
+// Cache of render passes keyed by attachment formats and pool of released
+// framebuffers keyed by attachment formats and dimensions. A batch of
+// scripts typically renders to identically configured targets, so when the
+// device is kept alive across recipes the render pass, the framebuffer and
+// its backing images are created once instead of once per pipeline.
+class RenderTargetCache {
+ public:
+  explicit RenderTargetCache(Device* device);
+  ~RenderTargetCache();
+
+  // Fills |render_pass| with the render pass for the given attachment
+  // formats, creating it on first use. |clear_color| and |clear_depth|
+  // select the variant whose load ops clear that attachment, used when a
+  // clear begins a pass instance; all the variants of a format pair are
+  // compatible with each other, so pipelines and framebuffers built
+  // against one work with any of them. The cache keeps ownership of the
+  // returned handle.
+  Result GetRenderPass(VkFormat color_format,
+                       VkFormat depth_format,
+                       bool clear_color,
+                       bool clear_depth,
+                       VkRenderPass* render_pass);
+
+  // Fills |frame| with an initialized framebuffer of the given formats and
+  // dimensions, reusing a released one when available. |render_pass| must
+  // have come from GetRenderPass() with the same formats.
+  Result AcquireFrameBuffer(VkRenderPass render_pass,
+                            VkFormat color_format,
+                            VkFormat depth_format,
+                            uint32_t width,
+                            uint32_t height,
+                            const VkPhysicalDeviceMemoryProperties& properties,
+                            std::unique_ptr<FrameBuffer>* frame);
+
+  // Returns |frame| to the pool for reuse. Submitted work rendering to it
+  // must have completed.
+  void ReleaseFrameBuffer(VkFormat color_format,
+                          VkFormat depth_format,
+                          std::unique_ptr<FrameBuffer> frame);
+
+  // Destroys the cached render passes and every pooled framebuffer.
+  // Framebuffers still acquired must have been released or become invalid
+  // (device teardown).
+  void Shutdown();
+
+ private:
+  struct RenderPassEntry {
+    VkFormat color_format;
+    VkFormat depth_format;
+    bool clear_color;
+    bool clear_depth;
+    VkRenderPass render_pass;
+  };
+
+  struct FrameBufferEntry {
+    VkFormat color_format;
+    VkFormat depth_format;
+    std::unique_ptr<FrameBuffer> frame;
+  };
+
+  Result CreateRenderPass(VkFormat color_format,
+                          VkFormat depth_format,
+                          bool clear_color,
+                          bool clear_depth,
+                          VkRenderPass* render_pass);
+
+  Device* device_ = nullptr;
+  // Scripts use few distinct format pairs, so both caches are linearly
+  // scanned vectors.
+  std::vector<RenderPassEntry> render_passes_;
+  std::vector<FrameBufferEntry> free_frame_buffers_;
+};
+
+}  // namespace vulkan
+}  // namespace amber
+
+#endif  // SRC_VULKAN_RENDER_TARGET_CACHE_H_
@@ -14,6 +14,7 @@
 
 #include "src/vulkan/resource.h"
 
+#include <algorithm>
 #include <cstring>
 #include <limits>
 
@@ -25,76 +26,285 @@ namespace amber {
 namespace vulkan {
 namespace {
 
-VkMemoryBarrier kMemoryBarrierForAll = {
-    VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr,
-    VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
-        VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT |
-        VK_ACCESS_INPUT_ATTACHMENT_READ_BIT | VK_ACCESS_SHADER_READ_BIT |
-        VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_READ_BIT |
-        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
-        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
-        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
-        VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT |
-        VK_ACCESS_HOST_READ_BIT | VK_ACCESS_HOST_WRITE_BIT,
-    VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
-        VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT |
-        VK_ACCESS_INPUT_ATTACHMENT_READ_BIT | VK_ACCESS_SHADER_READ_BIT |
-        VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_READ_BIT |
-        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
-        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
-        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
-        VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT |
-        VK_ACCESS_HOST_READ_BIT | VK_ACCESS_HOST_WRITE_BIT};
-
-// Fill the contents of |buffer| with |values|.
+// Chunk size for streamed buffer updates. Small enough that the chunk
+// being filled stays cache resident, large enough that the cost of one
+// vkFlushMappedMemoryRanges per chunk disappears in the fill time.
+const size_t kStreamChunkSizeInBytes = 16 * 1024 * 1024;
+
+// Fill the contents of |buffer| with elements [begin, begin + count)
+// of |values|.
 template <typename T>
-void SetValuesForBuffer(void* buffer, const std::vector<Value>& values) {
+void SetValuesForBuffer(void* buffer,
+                        const std::vector<Value>& values,
+                        size_t begin,
+                        size_t count) {
   T* ptr = static_cast<T*>(buffer);
-  for (const auto& v : values) {
+  for (size_t i = begin; i < begin + count; ++i) {
+    const Value& v = values[i];
     *ptr = v.IsInteger() ? static_cast<T>(v.AsUint64())
                          : static_cast<T>(v.AsDouble());
     ++ptr;
   }
 }
 
+// Fill |buffer| with elements [begin, begin + count) of the sequence
+// |input|'s generator produces. The element at |begin| is computed
+// directly from the generator parameters, so chunked callers produce
+// the same bytes as a single whole write. The loops are plain constant
+// or strided stores and vectorize.
+template <typename T>
+void GenerateValuesForBuffer(void* buffer,
+                             const BufferInput& input,
+                             size_t begin,
+                             size_t count) {
+  T* ptr = static_cast<T*>(buffer);
+  if (input.generator == BufferDataGenerator::kFill) {
+    const Value& v = input.gen_start;
+    T value = v.IsInteger() ? static_cast<T>(v.AsUint64())
+                            : static_cast<T>(v.AsDouble());
+    for (size_t i = 0; i < count; ++i)
+      ptr[i] = value;
+    return;
+  }
+
+  if (input.gen_start.IsInteger()) {
+    uint64_t start = input.gen_start.AsUint64();
+    uint64_t step = input.gen_step.AsUint64();
+    for (size_t i = 0; i < count; ++i)
+      ptr[i] = static_cast<T>(start + (begin + i) * step);
+  } else {
+    double start = input.gen_start.AsDouble();
+    double step = input.gen_step.AsDouble();
+    for (size_t i = 0; i < count; ++i)
+      ptr[i] = static_cast<T>(start + static_cast<double>(begin + i) * step);
+  }
+}
+
+// Convert |v| the way the buffer writers above do and compare the
+// resulting bytes against |element|.
+template <typename T>
+bool MatchesElement(const Value& v, const void* element) {
+  T converted = v.IsInteger() ? static_cast<T>(v.AsUint64())
+                              : static_cast<T>(v.AsDouble());
+  return std::memcmp(&converted, element, sizeof(T)) == 0;
+}
+
+// If one element of |input| repeats for its whole extent, stores the
+// element's bytes into |element| and returns true. |element| must hold
+// at least 8 bytes.
+template <typename T>
+bool GetConstantElement(const BufferInput& input, void* element) {
+  if (input.generator == BufferDataGenerator::kFill) {
+    const Value& v = input.gen_start;
+    T value = v.IsInteger() ? static_cast<T>(v.AsUint64())
+                            : static_cast<T>(v.AsDouble());
+    std::memcpy(element, &value, sizeof(T));
+    return true;
+  }
+
+  if (input.generator != BufferDataGenerator::kNone || !input.values ||
+      input.values->empty()) {
+    return false;
+  }
+
+  T first = (*input.values)[0].IsInteger()
+                ? static_cast<T>((*input.values)[0].AsUint64())
+                : static_cast<T>((*input.values)[0].AsDouble());
+  std::memcpy(element, &first, sizeof(T));
+  for (const Value& v : *input.values) {
+    if (!MatchesElement<T>(v, element))
+      return false;
+  }
+  return true;
+}
+
+bool GetConstantElementForType(const BufferInput& input, void* element) {
+  switch (input.type) {
+    case DataType::kInt8:
+      return GetConstantElement<int8_t>(input, element);
+    case DataType::kUint8:
+      return GetConstantElement<uint8_t>(input, element);
+    case DataType::kInt16:
+      return GetConstantElement<int16_t>(input, element);
+    case DataType::kUint16:
+      return GetConstantElement<uint16_t>(input, element);
+    case DataType::kInt32:
+      return GetConstantElement<int32_t>(input, element);
+    case DataType::kUint32:
+      return GetConstantElement<uint32_t>(input, element);
+    case DataType::kInt64:
+      return GetConstantElement<int64_t>(input, element);
+    case DataType::kUint64:
+      return GetConstantElement<uint64_t>(input, element);
+    case DataType::kFloat:
+      return GetConstantElement<float>(input, element);
+    case DataType::kDouble:
+      return GetConstantElement<double>(input, element);
+  }
+  return false;
+}
+
 }  // namespace
 
+bool BufferInput::GetConstantFillWord(uint32_t* word) const {
+  if (offset % 4 != 0 || size_in_bytes % 4 != 0 || size_in_bytes == 0)
+    return false;
+
+  if (raw_data) {
+    // Raw bytes repeat a 4 byte pattern only when they are all the
+    // same byte; the comparison fails on the first difference, so a
+    // non constant initializer costs almost nothing to reject.
+    if (size_in_bytes > 1 &&
+        std::memcmp(raw_data, raw_data + 1, size_in_bytes - 1) != 0) {
+      return false;
+    }
+    std::memset(word, raw_data[0], sizeof(*word));
+    return true;
+  }
+
+  uint8_t element[8] = {};
+  if (!GetConstantElementForType(*this, element))
+    return false;
+
+  // Replicate the element up to 4 bytes, or check that a wider element
+  // is itself a repetition of its first 4 bytes.
+  const size_t element_size = GetElementSizeInBytes();
+  uint8_t pattern[4];
+  for (size_t i = 0; i < 4; ++i)
+    pattern[i] = element[i % element_size];
+  for (size_t i = 4; i < element_size; ++i) {
+    if (element[i] != pattern[i % 4])
+      return false;
+  }
+
+  std::memcpy(word, pattern, sizeof(*word));
+  return true;
+}
+
 void BufferInput::UpdateBufferWithValues(void* buffer) const {
-  uint8_t* ptr = static_cast<uint8_t*>(buffer) + offset;
+  UpdateBufferWithValues(buffer, 0, GetElementCount());
+}
+
+void BufferInput::UpdateBufferWithValues(void* buffer,
+                                         size_t element_begin,
+                                         size_t element_count) const {
+  uint8_t* ptr = static_cast<uint8_t*>(buffer) + offset +
+                 element_begin * GetElementSizeInBytes();
+  if (raw_data) {
+    std::memcpy(ptr, raw_data + element_begin, element_count);
+    return;
+  }
+  if (generator != BufferDataGenerator::kNone) {
+    switch (type) {
+      case DataType::kInt8:
+        GenerateValuesForBuffer<int8_t>(ptr, *this, element_begin,
+                                        element_count);
+        break;
+      case DataType::kUint8:
+        GenerateValuesForBuffer<uint8_t>(ptr, *this, element_begin,
+                                         element_count);
+        break;
+      case DataType::kInt16:
+        GenerateValuesForBuffer<int16_t>(ptr, *this, element_begin,
+                                         element_count);
+        break;
+      case DataType::kUint16:
+        GenerateValuesForBuffer<uint16_t>(ptr, *this, element_begin,
+                                          element_count);
+        break;
+      case DataType::kInt32:
+        GenerateValuesForBuffer<int32_t>(ptr, *this, element_begin,
+                                         element_count);
+        break;
+      case DataType::kUint32:
+        GenerateValuesForBuffer<uint32_t>(ptr, *this, element_begin,
+                                          element_count);
+        break;
+      case DataType::kInt64:
+        GenerateValuesForBuffer<int64_t>(ptr, *this, element_begin,
+                                         element_count);
+        break;
+      case DataType::kUint64:
+        GenerateValuesForBuffer<uint64_t>(ptr, *this, element_begin,
+                                          element_count);
+        break;
+      case DataType::kFloat:
+        GenerateValuesForBuffer<float>(ptr, *this, element_begin,
+                                       element_count);
+        break;
+      case DataType::kDouble:
+        GenerateValuesForBuffer<double>(ptr, *this, element_begin,
+                                        element_count);
+        break;
+    }
+    return;
+  }
   switch (type) {
     case DataType::kInt8:
-      SetValuesForBuffer<int8_t>(ptr, values);
+      SetValuesForBuffer<int8_t>(ptr, *values, element_begin, element_count);
       break;
     case DataType::kUint8:
-      SetValuesForBuffer<uint8_t>(ptr, values);
+      SetValuesForBuffer<uint8_t>(ptr, *values, element_begin, element_count);
       break;
     case DataType::kInt16:
-      SetValuesForBuffer<int16_t>(ptr, values);
+      SetValuesForBuffer<int16_t>(ptr, *values, element_begin, element_count);
       break;
     case DataType::kUint16:
-      SetValuesForBuffer<uint16_t>(ptr, values);
+      SetValuesForBuffer<uint16_t>(ptr, *values, element_begin, element_count);
       break;
     case DataType::kInt32:
-      SetValuesForBuffer<int32_t>(ptr, values);
+      SetValuesForBuffer<int32_t>(ptr, *values, element_begin, element_count);
       break;
     case DataType::kUint32:
-      SetValuesForBuffer<uint32_t>(ptr, values);
+      SetValuesForBuffer<uint32_t>(ptr, *values, element_begin, element_count);
       break;
     case DataType::kInt64:
-      SetValuesForBuffer<int64_t>(ptr, values);
+      SetValuesForBuffer<int64_t>(ptr, *values, element_begin, element_count);
       break;
     case DataType::kUint64:
-      SetValuesForBuffer<uint64_t>(ptr, values);
+      SetValuesForBuffer<uint64_t>(ptr, *values, element_begin, element_count);
       break;
     case DataType::kFloat:
-      SetValuesForBuffer<float>(ptr, values);
+      SetValuesForBuffer<float>(ptr, *values, element_begin, element_count);
       break;
     case DataType::kDouble:
-      SetValuesForBuffer<double>(ptr, values);
+      SetValuesForBuffer<double>(ptr, *values, element_begin, element_count);
       break;
   }
 }
 
+size_t BufferInput::GetElementSizeInBytes() const {
+  if (raw_data)
+    return 1;
+  switch (type) {
+    case DataType::kInt8:
+    case DataType::kUint8:
+      return 1;
+    case DataType::kInt16:
+    case DataType::kUint16:
+      return 2;
+    case DataType::kInt32:
+    case DataType::kUint32:
+      return 4;
+    case DataType::kInt64:
+    case DataType::kUint64:
+      return 8;
+    case DataType::kFloat:
+      return sizeof(float);
+    case DataType::kDouble:
+      return sizeof(double);
+  }
+  return 1;
+}
+
+size_t BufferInput::GetElementCount() const {
+  if (values)
+    return values->size();
+  // Raw bytes and generated contents are sized in bytes; for raw data
+  // the element size is one byte.
+  return size_in_bytes / GetElementSizeInBytes();
+}
+
 Resource::Resource(Device* device,
                    size_t size_in_bytes,
                    const VkPhysicalDeviceMemoryProperties& properties)
@@ -104,7 +314,7 @@ Resource::Resource(Device* device,
 
 Resource::~Resource() = default;
 
-Result Resource::UpdateMemoryWithInput(const BufferInput& input) {
+Result Resource::CheckBufferInputFits(const BufferInput& input) const {
   if (static_cast<size_t>(input.offset) >= size_in_bytes_) {
     return Result(
         "Vulkan: Resource::UpdateMemoryWithInput BufferInput offset exceeds "
@@ -118,10 +328,37 @@ Result Resource::UpdateMemoryWithInput(const BufferInput& input) {
         "bytes exceeds memory size");
   }
 
+  return {};
+}
+
+Result Resource::UpdateMemoryWithInput(const BufferInput& input) {
+  Result r = CheckBufferInputFits(input);
+  if (!r.IsSuccess())
+    return r;
+
   input.UpdateBufferWithValues(memory_ptr_);
   return {};
 }
 
+Result Resource::UpdateMemoryWithInputStreamed(const BufferInput& input) {
+  Result r = CheckBufferInputFits(input);
+  if (!r.IsSuccess())
+    return r;
+
+  const size_t element_size = input.GetElementSizeInBytes();
+  const size_t element_count = input.GetElementCount();
+  const size_t elements_per_chunk = kStreamChunkSizeInBytes / element_size;
+  for (size_t begin = 0; begin < element_count; begin += elements_per_chunk) {
+    const size_t count = std::min(elements_per_chunk, element_count - begin);
+    input.UpdateBufferWithValues(memory_ptr_, begin, count);
+    r = FlushMemoryRangeIfNeeded(input.offset + begin * element_size,
+                                 count * element_size);
+    if (!r.IsSuccess())
+      return r;
+  }
+  return {};
+}
+
 void Resource::UpdateMemoryWithRawData(const std::vector<uint8_t>& raw_data) {
   size_t effective_size =
       raw_data.size() > size_in_bytes_ ? size_in_bytes_ : raw_data.size();
@@ -129,34 +366,19 @@ void Resource::UpdateMemoryWithRawData(const std::vector<uint8_t>& raw_data) {
 }
 
 void Resource::Shutdown() {
-  if (host_accessible_memory_ != VK_NULL_HANDLE) {
-    UnMapMemory(host_accessible_memory_);
-    device_->GetPtrs()->vkFreeMemory(device_->GetDevice(),
-                                     host_accessible_memory_, nullptr);
-  }
-
-  if (host_accessible_buffer_ != VK_NULL_HANDLE) {
-    device_->GetPtrs()->vkDestroyBuffer(device_->GetDevice(),
-                                        host_accessible_buffer_, nullptr);
+  if (staging_buffer_.buffer != VK_NULL_HANDLE) {
+    device_->GetStagingBufferPool()->Release(staging_buffer_);
+    staging_buffer_ = StagingBuffer();
   }
 }
 
 Result Resource::Initialize() {
-  Result r = CreateVkBuffer(
-      &host_accessible_buffer_,
-      VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+  Result r = device_->GetStagingBufferPool()->Acquire(size_in_bytes_,
+                                                      &staging_buffer_);
   if (!r.IsSuccess())
     return r;
 
-  AllocateResult allocate_result = AllocateAndBindMemoryToVkBuffer(
-      host_accessible_buffer_, &host_accessible_memory_,
-      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-      true);
-  if (!allocate_result.r.IsSuccess())
-    return allocate_result.r;
-
-  return MapMemory(host_accessible_memory_);
+  return MapMemory(staging_buffer_.allocation);
 }
 
 Result Resource::CreateVkBuffer(VkBuffer* buffer, VkBufferUsageFlags usage) {
@@ -169,8 +391,20 @@ Result Resource::CreateVkBuffer(VkBuffer* buffer, VkBufferUsageFlags usage) {
   buffer_info.size = size_in_bytes_;
   buffer_info.usage = usage;
 
-  if (device_->GetPtrs()->vkCreateBuffer(device_->GetDevice(), &buffer_info,
-                                         nullptr, buffer) != VK_SUCCESS) {
+  // When the device has a dedicated transfer queue, create the buffer so
+  // both queue families can access it without ownership transfers.
+  uint32_t queue_family_indices[2] = {device_->GetQueueFamilyIndex(),
+                                      device_->GetTransferQueueFamilyIndex()};
+  if (device_->HasDedicatedTransferQueue()) {
+    buffer_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+    buffer_info.queueFamilyIndexCount = 2;
+    buffer_info.pQueueFamilyIndices = queue_family_indices;
+  }
+
+  if (device_->GetPtrs()->vkCreateBuffer(device_->GetDevice(),
+                                         &buffer_info,
+                                         device_->GetHostAllocator(),
+                                         buffer) != VK_SUCCESS) {
     return Result("Vulkan::Calling vkCreateBuffer Fail");
   }
 
@@ -227,14 +461,14 @@ const VkMemoryRequirements Resource::GetVkImageMemoryRequirements(
 
 Resource::AllocateResult Resource::AllocateAndBindMemoryToVkBuffer(
     VkBuffer buffer,
-    VkDeviceMemory* memory,
+    MemoryAllocation* allocation,
     VkMemoryPropertyFlags flags,
     bool force_flags) {
   if (buffer == VK_NULL_HANDLE)
     return {Result("Vulkan::Given VkBuffer is VK_NULL_HANDLE"), 0};
 
-  if (memory == nullptr)
-    return {Result("Vulkan::Given VkDeviceMemory pointer is nullptr"), 0};
+  if (allocation == nullptr)
+    return {Result("Vulkan::Given MemoryAllocation pointer is nullptr"), 0};
 
   auto requirement = GetVkBufferMemoryRequirements(buffer);
 
@@ -243,31 +477,19 @@ Resource::AllocateResult Resource::AllocateAndBindMemoryToVkBuffer(
   if (memory_type_index == std::numeric_limits<uint32_t>::max())
     return {Result("Vulkan::Find Proper Memory Fail"), 0};
 
-  Result r = AllocateMemory(memory, requirement.size, memory_type_index);
+  Result r = device_->GetMemoryAllocator()->Allocate(
+      requirement, memory_type_index, false, allocation);
   if (!r.IsSuccess())
     return {r, 0};
 
-  return {BindMemoryToVkBuffer(buffer, *memory), memory_type_index};
+  return {BindMemoryToVkBuffer(buffer, *allocation), memory_type_index};
 }
 
-Result Resource::AllocateMemory(VkDeviceMemory* memory,
-                                VkDeviceSize size,
-                                uint32_t memory_type_index) {
-  VkMemoryAllocateInfo alloc_info = VkMemoryAllocateInfo();
-  alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  alloc_info.allocationSize = size;
-  alloc_info.memoryTypeIndex = memory_type_index;
-  if (device_->GetPtrs()->vkAllocateMemory(device_->GetDevice(), &alloc_info,
-                                           nullptr, memory) != VK_SUCCESS) {
-    return Result("Vulkan::Calling vkAllocateMemory Fail");
-  }
-
-  return {};
-}
-
-Result Resource::BindMemoryToVkBuffer(VkBuffer buffer, VkDeviceMemory memory) {
+Result Resource::BindMemoryToVkBuffer(VkBuffer buffer,
+                                      const MemoryAllocation& allocation) {
   if (device_->GetPtrs()->vkBindBufferMemory(device_->GetDevice(), buffer,
-                                             memory, 0) != VK_SUCCESS) {
+                                             allocation.memory,
+                                             allocation.offset) != VK_SUCCESS) {
     return Result("Vulkan::Calling vkBindBufferMemory Fail");
   }
 
@@ -276,14 +498,14 @@ Result Resource::BindMemoryToVkBuffer(VkBuffer buffer, VkDeviceMemory memory) {
 
 Resource::AllocateResult Resource::AllocateAndBindMemoryToVkImage(
     VkImage image,
-    VkDeviceMemory* memory,
+    MemoryAllocation* allocation,
     VkMemoryPropertyFlags flags,
     bool force_flags) {
   if (image == VK_NULL_HANDLE)
     return {Result("Vulkan::Given VkImage is VK_NULL_HANDLE"), 0};
 
-  if (memory == nullptr)
-    return {Result("Vulkan::Given VkDeviceMemory pointer is nullptr"), 0};
+  if (allocation == nullptr)
+    return {Result("Vulkan::Given MemoryAllocation pointer is nullptr"), 0};
 
   auto requirement = GetVkImageMemoryRequirements(image);
 
@@ -292,61 +514,77 @@ Resource::AllocateResult Resource::AllocateAndBindMemoryToVkImage(
   if (memory_type_index == std::numeric_limits<uint32_t>::max())
     return {Result("Vulkan::Find Proper Memory Fail"), 0};
 
-  Result r = AllocateMemory(memory, requirement.size, memory_type_index);
+  Result r = device_->GetMemoryAllocator()->Allocate(
+      requirement, memory_type_index, true, allocation);
   if (!r.IsSuccess())
     return {r, 0};
 
-  return {BindMemoryToVkImage(image, *memory), memory_type_index};
+  return {BindMemoryToVkImage(image, *allocation), memory_type_index};
 }
 
-Result Resource::BindMemoryToVkImage(VkImage image, VkDeviceMemory memory) {
-  if (device_->GetPtrs()->vkBindImageMemory(device_->GetDevice(), image, memory,
-                                            0) != VK_SUCCESS) {
+Result Resource::BindMemoryToVkImage(VkImage image,
+                                     const MemoryAllocation& allocation) {
+  if (device_->GetPtrs()->vkBindImageMemory(device_->GetDevice(), image,
+                                            allocation.memory,
+                                            allocation.offset) != VK_SUCCESS) {
     return Result("Vulkan::Calling vkBindImageMemory Fail");
   }
 
   return {};
 }
 
-Result Resource::MapMemory(VkDeviceMemory memory) {
-  if (device_->GetPtrs()->vkMapMemory(device_->GetDevice(), memory, 0,
-                                      VK_WHOLE_SIZE, 0,
-                                      &memory_ptr_) != VK_SUCCESS) {
-    return Result("Vulkan::Calling vkMapMemory Fail");
-  }
+Result Resource::FlushMemoryIfNeeded() {
+  return device_->GetMemoryAllocator()->Flush(staging_buffer_.allocation);
+}
 
+Result Resource::FlushMemoryRangeIfNeeded(VkDeviceSize offset,
+                                          VkDeviceSize size) {
+  return device_->GetMemoryAllocator()->FlushRange(staging_buffer_.allocation,
+                                                   offset, size);
+}
+
+Result Resource::InvalidateMemoryIfNeeded() {
+  return device_->GetMemoryAllocator()->Invalidate(staging_buffer_.allocation);
+}
+
+Result Resource::MapMemory(const MemoryAllocation& allocation) {
+  if (allocation.cpu_memory == nullptr)
+    return Result("Vulkan::MapMemory allocation is not host visible");
+
+  memory_ptr_ = allocation.cpu_memory;
   return {};
 }
 
-void Resource::UnMapMemory(VkDeviceMemory memory) {
-  device_->GetPtrs()->vkUnmapMemory(device_->GetDevice(), memory);
+void Resource::FreeMemory(MemoryAllocation* allocation) {
+  if (allocation->memory == VK_NULL_HANDLE)
+    return;
+
+  device_->GetMemoryAllocator()->Free(*allocation);
+  *allocation = MemoryAllocation();
+}
+
+void RecordMemoryBarrier(Device* device,
+                         VkCommandBuffer command,
+                         VkPipelineStageFlags src_stage,
+                         VkAccessFlags src_access,
+                         VkPipelineStageFlags dst_stage,
+                         VkAccessFlags dst_access) {
+  VkMemoryBarrier barrier = VkMemoryBarrier();
+  barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  barrier.srcAccessMask = src_access;
+  barrier.dstAccessMask = dst_access;
+
+  device->GetPtrs()->vkCmdPipelineBarrier(command, src_stage, dst_stage, 0, 1,
+                                          &barrier, 0, nullptr, 0, nullptr);
 }
 
-void Resource::MemoryBarrier(VkCommandBuffer command) {
-  // TODO(jaebaek): Current memory barrier is natively implemented.
-  // Update it with the following access flags:
-  // (r = read, w = write)
-  //
-  //                                 Host           Device
-  // VertexBuffer                  host w         vertex r
-  //                           transfer w       transfer r
-  //
-  // IndexBuffer                   host w          index r
-  //                           transfer w       transfer r
-  //
-  // FrameBuffer                   host r          color w
-  //                                       depth/stencil w
-  //                           transfer r       transfer w
-  //
-  // ReadWrite Descriptors       host r/w       shader r/w
-  //                         transfer r/w     transfer r/w
-  //
-  // ReadOnly Descriptors          host w         shader r
-  //                           transfer w       transfer r
-  device_->GetPtrs()->vkCmdPipelineBarrier(
-      command, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-      VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &kMemoryBarrierForAll, 0,
-      nullptr, 0, nullptr);
+void Resource::MemoryBarrier(VkCommandBuffer command,
+                             VkPipelineStageFlags src_stage,
+                             VkAccessFlags src_access,
+                             VkPipelineStageFlags dst_stage,
+                             VkAccessFlags dst_access) {
+  RecordMemoryBarrier(device_, command, src_stage, src_access, dst_stage,
+                      dst_access);
 }
 
 }  // namespace vulkan
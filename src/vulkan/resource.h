@@ -21,23 +21,71 @@
 #include "amber/result.h"
 #include "amber/value.h"
 #include "amber/vulkan_header.h"
+#include "src/buffer_data.h"
 #include "src/datum_type.h"
+#include "src/vulkan/memory_allocator.h"
+#include "src/vulkan/staging_buffer_pool.h"
 
 namespace amber {
 namespace vulkan {
 
 class Device;
 
+// Record a single global memory barrier into |command| making writes of
+// |src_access| at |src_stage| available and visible to |dst_access| at
+// |dst_stage|. Callers touching several resources in a row use this to
+// merge what would otherwise be one barrier per resource.
+void RecordMemoryBarrier(Device* device,
+                         VkCommandBuffer command,
+                         VkPipelineStageFlags src_stage,
+                         VkAccessFlags src_access,
+                         VkPipelineStageFlags dst_stage,
+                         VkAccessFlags dst_access);
+
 // Contain information of filling memory
 // [|offset|, |offset| + |size_in_bytes|) with |values| whose data
-// type is |type|. This information is given by script.
+// type is |type|. This information is given by script. |values| and
+// |raw_data| are non owning views of the data held by the script's
+// BufferCommand, which outlives the engine, so queueing an input never
+// copies the initializer.
 struct BufferInput {
   void UpdateBufferWithValues(void* buffer) const;
 
+  // Same as above but writes only elements [element_begin, element_begin
+  // + element_count) of |values|, at the offsets a whole update would
+  // put them. Used to stream large initializers in bounded chunks.
+  void UpdateBufferWithValues(void* buffer,
+                              size_t element_begin,
+                              size_t element_count) const;
+
+  // If every byte this input writes is a repetition of one 4 byte
+  // pattern - a fill generator, explicit values that are all equal, or
+  // raw data of one repeated byte - stores that pattern in |word| and
+  // returns true. The write is then expressible as a vkCmdFillBuffer
+  // instead of a host side fill. Requires |offset| and |size_in_bytes|
+  // to be multiples of 4, as the fill command does.
+  bool GetConstantFillWord(uint32_t* word) const;
+
+  // Number of bytes one element of |type| occupies in the buffer.
+  size_t GetElementSizeInBytes() const;
+
+  // Number of elements this input writes.
+  size_t GetElementCount() const;
+
   uint32_t offset;
   size_t size_in_bytes;
-  DataType type;              // Type of |values|.
-  std::vector<Value> values;  // Data whose type is |type|.
+  DataType type;                     // Type of |values|.
+  const std::vector<Value>* values;  // Data whose type is |type|.
+  // When set, |size_in_bytes| bytes already laid out for the buffer;
+  // they are copied as-is and |type| and |values| are ignored.
+  const uint8_t* raw_data;
+  // When not kNone the contents are procedural: every element is
+  // |gen_start| for a fill, gen_start + i * gen_step for a series. The
+  // generator is evaluated straight into the destination, so nothing
+  // is stored per element on the host.
+  BufferDataGenerator generator;
+  Value gen_start;
+  Value gen_step;
 };
 
 // Class for Vulkan resources. Its children are Vulkan Buffer, Vulkan Image,
@@ -47,7 +95,7 @@ class Resource {
   virtual ~Resource();
 
   virtual VkDeviceMemory GetHostAccessMemory() const {
-    return host_accessible_memory_;
+    return staging_buffer_.allocation.memory;
   }
 
   virtual Result CopyToHost(VkCommandBuffer command) = 0;
@@ -58,11 +106,33 @@ class Resource {
   // of |data| with |values| of |data|.
   Result UpdateMemoryWithInput(const BufferInput& input);
 
+  // Same as UpdateMemoryWithInput() but walks |input| in bounded chunks
+  // and flushes each chunk's range right after writing it. On non
+  // coherent memory the write back of chunk k then overlaps the CPU
+  // fill of chunk k+1 and the flushed range never exceeds the chunk
+  // size, so initializers larger than any cache stream through without
+  // a whole buffer flush at the end. The caller must not flush again.
+  Result UpdateMemoryWithInputStreamed(const BufferInput& input);
+
   // Fill |memory_ptr_| from 0 to |raw_data.size()| with |raw_data|.
   void UpdateMemoryWithRawData(const std::vector<uint8_t>& raw_data);
 
   virtual void* HostAccessibleMemoryPtr() const { return memory_ptr_; }
 
+  // Make host writes through HostAccessibleMemoryPtr() visible to the
+  // device. A no-op when the memory behind the pointer is host coherent.
+  virtual Result FlushMemoryIfNeeded();
+
+  // Make host writes to |size| bytes at |offset| behind
+  // HostAccessibleMemoryPtr() visible to the device. A no-op when the
+  // memory is host coherent.
+  virtual Result FlushMemoryRangeIfNeeded(VkDeviceSize offset,
+                                          VkDeviceSize size);
+
+  // Make device writes visible to host reads through
+  // HostAccessibleMemoryPtr(). A no-op when the memory is host coherent.
+  virtual Result InvalidateMemoryIfNeeded();
+
   size_t GetSizeInBytes() const { return size_in_bytes_; }
 
  protected:
@@ -72,7 +142,7 @@ class Resource {
   Result Initialize();
   Result CreateVkBuffer(VkBuffer* buffer, VkBufferUsageFlags usage);
 
-  VkBuffer GetHostAccessibleBuffer() const { return host_accessible_buffer_; }
+  VkBuffer GetHostAccessibleBuffer() const { return staging_buffer_.buffer; }
 
   struct AllocateResult {
     Result r;
@@ -80,11 +150,11 @@ class Resource {
   };
 
   AllocateResult AllocateAndBindMemoryToVkBuffer(VkBuffer buffer,
-                                                 VkDeviceMemory* memory,
+                                                 MemoryAllocation* allocation,
                                                  VkMemoryPropertyFlags flags,
                                                  bool force_flags);
   AllocateResult AllocateAndBindMemoryToVkImage(VkImage image,
-                                                VkDeviceMemory* memory,
+                                                MemoryAllocation* allocation,
                                                 VkMemoryPropertyFlags flags,
                                                 bool force_flags);
 
@@ -102,40 +172,51 @@ class Resource {
            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
   }
 
-  Result MapMemory(VkDeviceMemory memory);
-  void UnMapMemory(VkDeviceMemory memory);
+  // Set |memory_ptr_| to the host visible pointer of |allocation|. The
+  // allocator maps each host visible block once when it is created, so this
+  // does not call vkMapMemory.
+  Result MapMemory(const MemoryAllocation& allocation);
+
+  // Return the range of |allocation| to the device's sub-allocator and
+  // clear it.
+  void FreeMemory(MemoryAllocation* allocation);
 
   // Set |memory_ptr_| as |ptr|. This must be used for only push constant.
   // For Vulkan buffer and image i.e., Buffer and Image classes, we should
   // not call this but uses MapMemory() method.
   void SetMemoryPtr(void* ptr) { memory_ptr_ = ptr; }
 
-  // Make all memory operations before calling this method effective i.e.,
-  // prevent hazards caused by out-of-order execution.
-  void MemoryBarrier(VkCommandBuffer command);
+  // Record a pipeline barrier making writes of |src_access| at
+  // |src_stage| available and visible to |dst_access| at |dst_stage|.
+  void MemoryBarrier(VkCommandBuffer command,
+                     VkPipelineStageFlags src_stage,
+                     VkAccessFlags src_access,
+                     VkPipelineStageFlags dst_stage,
+                     VkAccessFlags dst_access);
 
   Device* device_ = nullptr;
 
  private:
+  // Verify |input| lies inside [0, |size_in_bytes_|).
+  Result CheckBufferInputFits(const BufferInput& input) const;
+
   uint32_t ChooseMemory(uint32_t memory_type_bits,
                         VkMemoryPropertyFlags flags,
                         bool force_flags);
-  Result AllocateMemory(VkDeviceMemory* memory,
-                        VkDeviceSize size,
-                        uint32_t memory_type_index);
-
-  Result BindMemoryToVkBuffer(VkBuffer buffer, VkDeviceMemory memory);
+  Result BindMemoryToVkBuffer(VkBuffer buffer,
+                              const MemoryAllocation& allocation);
   const VkMemoryRequirements GetVkBufferMemoryRequirements(
       VkBuffer buffer) const;
 
-  Result BindMemoryToVkImage(VkImage image, VkDeviceMemory memory);
+  Result BindMemoryToVkImage(VkImage image, const MemoryAllocation& allocation);
   const VkMemoryRequirements GetVkImageMemoryRequirements(VkImage image) const;
 
   size_t size_in_bytes_ = 0;
   VkPhysicalDeviceMemoryProperties physical_memory_properties_;
 
-  VkBuffer host_accessible_buffer_ = VK_NULL_HANDLE;
-  VkDeviceMemory host_accessible_memory_ = VK_NULL_HANDLE;
+  // Staging buffer for copies between the host and this resource, borrowed
+  // from the device's pool for the lifetime of the resource.
+  StagingBuffer staging_buffer_;
   void* memory_ptr_ = nullptr;
 };
 
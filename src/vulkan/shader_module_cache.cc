@@ -0,0 +1,96 @@
+// Copyright 2018 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/vulkan/shader_module_cache.h"
+
+#include "src/vulkan/device.h"
+
+namespace amber {
+namespace vulkan {
+namespace {
+
+// FNV-1a over the SPIR-V words.
+uint64_t HashSpirv(const std::vector<uint32_t>& spirv) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (uint32_t word : spirv) {
+    for (uint32_t i = 0; i < 4; ++i) {
+      hash ^= (word >> (i * 8)) & 0xffU;
+      hash *= 0x100000001b3ULL;
+    }
+  }
+  return hash;
+}
+
+}  // namespace
+
+ShaderModuleCache::ShaderModuleCache(Device* device) : device_(device) {}
+
+ShaderModuleCache::~ShaderModuleCache() = default;
+
+Result ShaderModuleCache::GetShaderModule(const std::vector<uint32_t>& spirv,
+                                          VkShaderModule* module) {
+  auto& bucket = entries_[HashSpirv(spirv)];
+  for (auto& entry : bucket) {
+    if (entry.spirv == spirv) {
+      ++entry.ref_count;
+      *module = entry.module;
+      return {};
+    }
+  }
+
+  VkShaderModuleCreateInfo info = VkShaderModuleCreateInfo();
+  info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+  info.codeSize = spirv.size() * sizeof(uint32_t);
+  info.pCode = spirv.data();
+
+  VkShaderModule shader;
+  if (device_->GetPtrs()->vkCreateShaderModule(device_->GetDevice(),
+                                               &info,
+                                               device_->GetHostAllocator(),
+                                               &shader) !=
+      VK_SUCCESS) {
+    return Result("Vulkan::Calling vkCreateShaderModule Fail");
+  }
+
+  bucket.push_back({spirv, shader, 1});
+  *module = shader;
+  return {};
+}
+
+void ShaderModuleCache::ReleaseShaderModule(VkShaderModule module) {
+  for (auto& bucket : entries_) {
+    for (auto& entry : bucket.second) {
+      if (entry.module == module && entry.ref_count > 0) {
+        --entry.ref_count;
+        return;
+      }
+    }
+  }
+}
+
+void ShaderModuleCache::Shutdown() {
+  for (auto& bucket : entries_) {
+    for (auto& entry : bucket.second) {
+      if (entry.module != VK_NULL_HANDLE) {
+        device_->GetPtrs()->vkDestroyShaderModule(device_->GetDevice(),
+                                                  entry.module,
+                                                  device_->GetHostAllocator());
+      }
+    }
+  }
+  entries_.clear();
+}
+
+}  // namespace vulkan
+}  // namespace amber
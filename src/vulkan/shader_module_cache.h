@@ -0,0 +1,70 @@
+// Copyright 2018 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_VULKAN_SHADER_MODULE_CACHE_H_
+#define SRC_VULKAN_SHADER_MODULE_CACHE_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "amber/result.h"
+#include "amber/vulkan_header.h"
+
+namespace amber {
+namespace vulkan {
+
+class Device;
+
+// Cache of shader modules keyed by a hash of their SPIR-V words. Batch
+// runs on a persistent device hand the engine the same binaries over and
+// over - a corpus commonly shares one pass-through vertex shader - so the
+// module is created once and handed out by reference instead of being
+// re-created for every pipeline.
+class ShaderModuleCache {
+ public:
+  explicit ShaderModuleCache(Device* device);
+  ~ShaderModuleCache();
+
+  // Fills |module| with a shader module for |spirv|, creating it on first
+  // use. Each successful call takes a reference which must be returned
+  // with ReleaseShaderModule().
+  Result GetShaderModule(const std::vector<uint32_t>& spirv,
+                         VkShaderModule* module);
+
+  // Drops a reference taken by GetShaderModule(). Unreferenced modules
+  // stay cached for later recipes; they are only destroyed in Shutdown().
+  void ReleaseShaderModule(VkShaderModule module);
+
+  // Destroys every cached module. Pipelines created from them must no
+  // longer be in use.
+  void Shutdown();
+
+ private:
+  struct Entry {
+    // The SPIR-V is kept to guard against hash collisions; it is small
+    // next to the module the driver built from it.
+    std::vector<uint32_t> spirv;
+    VkShaderModule module;
+    uint32_t ref_count;
+  };
+
+  Device* device_ = nullptr;
+  std::unordered_map<uint64_t, std::vector<Entry>> entries_;
+};
+
+}  // namespace vulkan
+}  // namespace amber
+
+#endif  // SRC_VULKAN_SHADER_MODULE_CACHE_H_
@@ -0,0 +1,174 @@
+// Copyright 2018 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/vulkan/staging_buffer_pool.h"
+
+#include <limits>
+
+#include "src/vulkan/device.h"
+
+namespace amber {
+namespace vulkan {
+namespace {
+
+// Smallest size class; tiny uniform buffers all land in this one.
+const VkDeviceSize kMinimumSize = 256;
+
+// Returns the index of the smallest power-of-two size class that holds
+// |size| bytes, and the class size itself through |class_size|.
+size_t SizeClass(VkDeviceSize size, VkDeviceSize* class_size) {
+  size_t index = 0;
+  VkDeviceSize bytes = kMinimumSize;
+  while (bytes < size) {
+    bytes <<= 1;
+    ++index;
+  }
+  *class_size = bytes;
+  return index;
+}
+
+}  // namespace
+
+StagingBufferPool::StagingBufferPool(Device* device) : device_(device) {}
+
+StagingBufferPool::~StagingBufferPool() = default;
+
+Result StagingBufferPool::Acquire(VkDeviceSize size,
+                                  StagingBuffer* staging_buffer) {
+  if (staging_buffer == nullptr)
+    return Result("Vulkan::Given StagingBuffer pointer is nullptr");
+
+  VkDeviceSize class_size = 0;
+  size_t index = SizeClass(size, &class_size);
+
+  if (index < free_buffers_.size() && !free_buffers_[index].empty()) {
+    *staging_buffer = free_buffers_[index].back();
+    free_buffers_[index].pop_back();
+    return {};
+  }
+
+  return CreateBuffer(class_size, staging_buffer);
+}
+
+void StagingBufferPool::Release(const StagingBuffer& staging_buffer) {
+  if (staging_buffer.buffer == VK_NULL_HANDLE)
+    return;
+
+  VkDeviceSize class_size = 0;
+  size_t index = SizeClass(staging_buffer.size, &class_size);
+  if (index >= free_buffers_.size())
+    free_buffers_.resize(index + 1);
+
+  free_buffers_[index].push_back(staging_buffer);
+}
+
+void StagingBufferPool::Shutdown() {
+  for (auto& size_class : free_buffers_) {
+    for (auto& staging_buffer : size_class) {
+      device_->GetPtrs()->vkDestroyBuffer(device_->GetDevice(),
+                                          staging_buffer.buffer,
+                                          device_->GetHostAllocator());
+      device_->GetMemoryAllocator()->Free(staging_buffer.allocation);
+    }
+  }
+  free_buffers_.clear();
+}
+
+Result StagingBufferPool::CreateBuffer(VkDeviceSize size,
+                                       StagingBuffer* staging_buffer) {
+  VkBufferCreateInfo buffer_info = VkBufferCreateInfo();
+  buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  buffer_info.size = size;
+  buffer_info.usage =
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+  // When the device has a dedicated transfer queue, create the buffer so
+  // both queue families can access it without ownership transfers.
+  uint32_t queue_family_indices[2] = {device_->GetQueueFamilyIndex(),
+                                      device_->GetTransferQueueFamilyIndex()};
+  if (device_->HasDedicatedTransferQueue()) {
+    buffer_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+    buffer_info.queueFamilyIndexCount = 2;
+    buffer_info.pQueueFamilyIndices = queue_family_indices;
+  }
+
+  VkBuffer buffer = VK_NULL_HANDLE;
+  if (device_->GetPtrs()->vkCreateBuffer(device_->GetDevice(),
+                                         &buffer_info,
+                                         device_->GetHostAllocator(),
+                                         &buffer) != VK_SUCCESS) {
+    return Result("Vulkan::Calling vkCreateBuffer Fail");
+  }
+
+  VkMemoryRequirements requirement;
+  device_->GetPtrs()->vkGetBufferMemoryRequirements(device_->GetDevice(),
+                                                    buffer, &requirement);
+
+  // Prefer host coherent memory; heaps exposing only non coherent host
+  // visible memory work too since resources flush and invalidate their
+  // ranges around host accesses.
+  const VkMemoryPropertyFlags wanted_flags[] = {
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT};
+  const auto& properties = device_->GetPhysicalMemoryProperties();
+  uint32_t memory_type_index = std::numeric_limits<uint32_t>::max();
+  for (const auto flags : wanted_flags) {
+    for (uint32_t i = 0; i < properties.memoryTypeCount; ++i) {
+      if ((requirement.memoryTypeBits & (1u << i)) &&
+          (properties.memoryTypes[i].propertyFlags & flags) == flags) {
+        memory_type_index = i;
+        break;
+      }
+    }
+    if (memory_type_index != std::numeric_limits<uint32_t>::max())
+      break;
+  }
+  if (memory_type_index == std::numeric_limits<uint32_t>::max()) {
+    device_->GetPtrs()->vkDestroyBuffer(device_->GetDevice(),
+                                        buffer,
+                                        device_->GetHostAllocator());
+    return Result("Vulkan::Find Proper Memory Fail");
+  }
+
+  MemoryAllocation allocation;
+  Result r = device_->GetMemoryAllocator()->Allocate(
+      requirement, memory_type_index, false, &allocation);
+  if (!r.IsSuccess()) {
+    device_->GetPtrs()->vkDestroyBuffer(device_->GetDevice(),
+                                        buffer,
+                                        device_->GetHostAllocator());
+    return r;
+  }
+
+  if (device_->GetPtrs()->vkBindBufferMemory(device_->GetDevice(), buffer,
+                                             allocation.memory,
+                                             allocation.offset) != VK_SUCCESS) {
+    device_->GetMemoryAllocator()->Free(allocation);
+    device_->GetPtrs()->vkDestroyBuffer(device_->GetDevice(),
+                                        buffer,
+                                        device_->GetHostAllocator());
+    return Result("Vulkan::Calling vkBindBufferMemory Fail");
+  }
+
+  staging_buffer->buffer = buffer;
+  staging_buffer->allocation = allocation;
+  staging_buffer->size = size;
+  staging_buffer->cpu_memory = allocation.cpu_memory;
+  return {};
+}
+
+}  // namespace vulkan
+}  // namespace amber
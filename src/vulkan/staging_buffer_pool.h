@@ -0,0 +1,76 @@
+// Copyright 2018 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_VULKAN_STAGING_BUFFER_POOL_H_
+#define SRC_VULKAN_STAGING_BUFFER_POOL_H_
+
+#include <vector>
+
+#include "amber/result.h"
+#include "amber/vulkan_header.h"
+#include "src/vulkan/memory_allocator.h"
+
+namespace amber {
+namespace vulkan {
+
+class Device;
+
+// A host visible, host coherent VkBuffer with TRANSFER_SRC | TRANSFER_DST
+// usage handed out by StagingBufferPool. |size| is the pool's power-of-two
+// size class and can be larger than what was asked for. |cpu_memory| points
+// at the start of the buffer's persistently mapped memory.
+struct StagingBuffer {
+  VkBuffer buffer = VK_NULL_HANDLE;
+  MemoryAllocation allocation;
+  VkDeviceSize size = 0;
+  void* cpu_memory = nullptr;
+};
+
+// Pool of staging buffers used for copies between the host and the device.
+// Every resource needs one and they all share the same usage flags, so
+// instead of a buffer create + memory allocate + map per resource, released
+// buffers are kept in power-of-two size classes and acquiring one that was
+// used before costs only a vector pop. The pool is owned by Device, so
+// staging buffers are reused across commands and, when the engine is
+// reused, across recipes.
+class StagingBufferPool {
+ public:
+  explicit StagingBufferPool(Device* device);
+  ~StagingBufferPool();
+
+  // Fills |staging_buffer| with a buffer of at least |size| bytes, reusing
+  // a released buffer of the same size class when one exists.
+  Result Acquire(VkDeviceSize size, StagingBuffer* staging_buffer);
+
+  // Returns |staging_buffer| to its size class for reuse.
+  void Release(const StagingBuffer& staging_buffer);
+
+  // Destroys every pooled buffer and frees its memory. Buffers still
+  // acquired from the pool must have been released or become invalid
+  // (device teardown).
+  void Shutdown();
+
+ private:
+  Result CreateBuffer(VkDeviceSize size, StagingBuffer* staging_buffer);
+
+  Device* device_ = nullptr;
+  // Released buffers indexed by size class, where class N holds buffers of
+  // kMinimumSize << N bytes.
+  std::vector<std::vector<StagingBuffer>> free_buffers_;
+};
+
+}  // namespace vulkan
+}  // namespace amber
+
+#endif  // SRC_VULKAN_STAGING_BUFFER_POOL_H_
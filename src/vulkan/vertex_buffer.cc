@@ -14,6 +14,7 @@
 
 #include "src/vulkan/vertex_buffer.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 
@@ -169,6 +170,14 @@ Result CopyBitsOfValueToBuffer(uint8_t* dst,
     dst_bit_offset -= 8;
   }
 
+  // Byte aligned components i.e., the overwhelmingly common formats like
+  // R8G8B8A8 and R32G32B32A32 need no bit shuffling; store the encoded
+  // value directly.
+  if (dst_bit_offset == 0 && (bits % 8) == 0) {
+    std::memcpy(dst, &data, bits / 8);
+    return {};
+  }
+
   // No overflow will happen. |dst_bit_offset| is based on VkFormat
   // and if |bits| is 64, |dst_bit_offset| must be 0. No component
   // has |bits| bigger than 64.
@@ -183,6 +192,96 @@ Result CopyBitsOfValueToBuffer(uint8_t* dst,
   return {};
 }
 
+// Write one integer component for every vertex in a tight loop the
+// compiler can vectorize. |dst| points at the component of the first
+// vertex and |stride| is the distance between vertices in bytes.
+template <typename T>
+void FillIntegerColumn(uint8_t* dst,
+                       uint32_t stride,
+                       const std::vector<Value>& values,
+                       uint32_t vertex_count,
+                       uint32_t component_count,
+                       uint32_t component_index) {
+  for (uint32_t i = 0; i < vertex_count; ++i) {
+    T data =
+        static_cast<T>(values[i * component_count + component_index].AsUint64());
+    std::memcpy(dst, &data, sizeof(T));
+    dst += stride;
+  }
+}
+
+// As FillIntegerColumn() but for float and double components.
+template <typename T>
+void FillFloatColumn(uint8_t* dst,
+                     uint32_t stride,
+                     const std::vector<Value>& values,
+                     uint32_t vertex_count,
+                     uint32_t component_count,
+                     uint32_t component_index) {
+  for (uint32_t i = 0; i < vertex_count; ++i) {
+    T data =
+        static_cast<T>(values[i * component_count + component_index].AsDouble());
+    std::memcpy(dst, &data, sizeof(T));
+    dst += stride;
+  }
+}
+
+// Write the |component_index| component of a byte aligned format for
+// every vertex in one type-specialized pass. The column is assumed to
+// hold values of a single data type, which the script parsers guarantee.
+// Returns false when the component needs the per-value bit copy path.
+bool FillComponentColumn(uint8_t* dst,
+                         uint32_t stride,
+                         const std::vector<Value>& values,
+                         uint32_t vertex_count,
+                         uint32_t component_count,
+                         uint32_t component_index,
+                         uint8_t num_bits) {
+  if (values[component_index].IsInteger()) {
+    switch (num_bits) {
+      case 8:
+        FillIntegerColumn<uint8_t>(dst, stride, values, vertex_count,
+                                   component_count, component_index);
+        return true;
+      case 16:
+        FillIntegerColumn<uint16_t>(dst, stride, values, vertex_count,
+                                    component_count, component_index);
+        return true;
+      case 32:
+        FillIntegerColumn<uint32_t>(dst, stride, values, vertex_count,
+                                    component_count, component_index);
+        return true;
+      case 64:
+        FillIntegerColumn<uint64_t>(dst, stride, values, vertex_count,
+                                    component_count, component_index);
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  switch (num_bits) {
+    case 16:
+      for (uint32_t i = 0; i < vertex_count; ++i) {
+        uint16_t data = FloatToHexFloat16(
+            values[i * component_count + component_index].AsFloat());
+        std::memcpy(dst, &data, sizeof(uint16_t));
+        dst += stride;
+      }
+      return true;
+    case 32:
+      FillFloatColumn<float>(dst, stride, values, vertex_count,
+                             component_count, component_index);
+      return true;
+    case 64:
+      FillFloatColumn<double>(dst, stride, values, vertex_count,
+                              component_count, component_index);
+      return true;
+    default:
+      return false;
+  }
+}
+
 }  // namespace
 
 VertexBuffer::VertexBuffer(Device* device) : device_(device) {}
@@ -196,69 +295,211 @@ void VertexBuffer::Shutdown() {
 
 void VertexBuffer::SetData(uint8_t location,
                            const Format& format,
-                           const std::vector<Value>& values) {
+                           const std::vector<Value>& values,
+                           bool instance_rate) {
   vertex_attr_desc_.emplace_back();
-  // TODO(jaebaek): Support multiple binding
-  vertex_attr_desc_.back().binding = 0;
+  // Per-vertex locations interleave in binding 0, per-instance
+  // locations in binding 1.
+  vertex_attr_desc_.back().binding = instance_rate ? 1 : 0;
   vertex_attr_desc_.back().location = location;
   vertex_attr_desc_.back().format = ToVkFormat(format.GetFormatType());
-  vertex_attr_desc_.back().offset = stride_in_bytes_;
+  vertex_attr_desc_.back().offset =
+      instance_rate ? instance_stride_in_bytes_ : stride_in_bytes_;
 
-  stride_in_bytes_ += format.GetByteSize();
+  if (instance_rate)
+    instance_stride_in_bytes_ += format.GetByteSize();
+  else
+    stride_in_bytes_ += format.GetByteSize();
 
   formats_.push_back(format);
+  instance_rate_.push_back(instance_rate);
   data_.push_back(values);
+  packed_data_.emplace_back();
+
+  if (!instance_rate && vertex_count_ == 0)
+    vertex_count_ = values.size() / format.GetComponents().size();
+}
+
+void VertexBuffer::SetData(uint8_t location,
+                           const Format& format,
+                           const std::vector<uint8_t>& bytes,
+                           bool instance_rate) {
+  vertex_attr_desc_.emplace_back();
+  // Per-vertex locations interleave in binding 0, per-instance
+  // locations in binding 1.
+  vertex_attr_desc_.back().binding = instance_rate ? 1 : 0;
+  vertex_attr_desc_.back().location = location;
+  vertex_attr_desc_.back().format = ToVkFormat(format.GetFormatType());
+  vertex_attr_desc_.back().offset =
+      instance_rate ? instance_stride_in_bytes_ : stride_in_bytes_;
+
+  if (instance_rate)
+    instance_stride_in_bytes_ += format.GetByteSize();
+  else
+    stride_in_bytes_ += format.GetByteSize();
+
+  formats_.push_back(format);
+  instance_rate_.push_back(instance_rate);
+  data_.emplace_back();
+  packed_data_.push_back(bytes);
+
+  if (!instance_rate && vertex_count_ == 0)
+    vertex_count_ = bytes.size() / format.GetByteSize();
+}
+
+size_t VertexBuffer::GetElementCount(size_t index) const {
+  if (!packed_data_[index].empty())
+    return packed_data_[index].size() / formats_[index].GetByteSize();
+
+  if (formats_[index].GetPackSize() > 0)
+    return data_[index].size();
+
+  return data_[index].size() / formats_[index].GetComponents().size();
+}
+
+Result VertexBuffer::UpdateData(uint8_t location,
+                                size_t value_offset,
+                                const std::vector<Value>& values) {
+  for (size_t i = 0; i < vertex_attr_desc_.size(); ++i) {
+    if (vertex_attr_desc_[i].location != location)
+      continue;
+
+    if (!packed_data_[i].empty())
+      return Result("Vulkan::UpdateData not supported for packed vertex data");
+
+    if (value_offset + values.size() > data_[i].size()) {
+      return Result(
+          "Vulkan::UpdateData exceeds the data given for the location");
+    }
+
+    for (size_t j = 0; j < values.size(); ++j)
+      data_[i][value_offset + j] = values[j];
+
+    is_vertex_data_pending_ = true;
+    return {};
+  }
+
+  return Result("Vulkan::UpdateData no vertex data for the given location");
 }
 
 Result VertexBuffer::FillVertexBufferWithData(VkCommandBuffer command) {
-  // Send vertex data from host to device.
-  uint8_t* ptr_in_stride_begin =
+  // Send vertex data from host to device. The buffer is filled column by
+  // column: each byte aligned component gets a single type-specialized
+  // pass over all vertices instead of a per-value dispatch, and only
+  // packed formats fall back to the bit copy.
+  uint8_t* memory_begin =
       static_cast<uint8_t*>(buffer_->HostAccessibleMemoryPtr());
-  for (uint32_t i = 0; i < GetVertexCount(); ++i) {
-    uint8_t* ptr = ptr_in_stride_begin;
-    for (uint32_t j = 0; j < formats_.size(); ++j) {
-      const auto pack_size = formats_[j].GetPackSize();
+
+  uint32_t vertex_format_offset = 0;
+  uint32_t instance_format_offset = 0;
+  for (uint32_t j = 0; j < formats_.size(); ++j) {
+    const auto pack_size = formats_[j].GetPackSize();
+    const auto& components = formats_[j].GetComponents();
+
+    // Per-instance locations interleave in their own region with their
+    // own stride, and the element loops below run once per instance
+    // instead of once per vertex.
+    const bool instance_rate = instance_rate_[j];
+    uint8_t* buffer_begin =
+        memory_begin + (instance_rate ? instance_region_offset_ : 0);
+    const uint32_t stride = instance_rate
+                                ? Get4BytesAligned(instance_stride_in_bytes_)
+                                : Get4BytesAlignedStride();
+    const uint32_t vertex_count =
+        static_cast<uint32_t>(instance_rate ? GetElementCount(j)
+                                            : GetVertexCount());
+    uint32_t& format_offset =
+        instance_rate ? instance_format_offset : vertex_format_offset;
+
+    // Locations backed by packed bytes are already in the format's
+    // encoding; interleaving them is a strided copy per vertex.
+    if (!packed_data_[j].empty()) {
+      const uint32_t element_size = formats_[j].GetByteSize();
+      const uint8_t* src = packed_data_[j].data();
+      uint8_t* dst = buffer_begin + format_offset;
+      for (uint32_t i = 0; i < vertex_count; ++i) {
+        std::memcpy(dst, src, element_size);
+        src += element_size;
+        dst += stride;
+      }
+      format_offset += element_size;
+      continue;
+    }
+
+    if (!pack_size && !data_[j].empty()) {
+      if (formats_[j].IsByteAligned()) {
+        bool filled = true;
+        for (uint32_t k = 0; k < components.size(); ++k) {
+          if (!FillComponentColumn(
+                  buffer_begin + format_offset + components[k].byte_offset,
+                  stride, data_[j], vertex_count,
+                  static_cast<uint32_t>(components.size()), k,
+                  components[k].num_bits)) {
+            filled = false;
+            break;
+          }
+        }
+
+        if (filled) {
+          format_offset += formats_[j].GetByteSize();
+          continue;
+        }
+      }
+    }
+
+    uint8_t* ptr = buffer_begin + format_offset;
+    for (uint32_t i = 0; i < vertex_count; ++i) {
       if (pack_size) {
         Result r = CopyBitsOfValueToBuffer(ptr, data_[j][i], 0, pack_size);
         if (!r.IsSuccess())
           return r;
 
-        ptr += pack_size / 8;
+        ptr += stride;
         continue;
       }
 
-      const auto& components = formats_[j].GetComponents();
-      uint8_t bit_offset = 0;
-
       for (uint32_t k = 0; k < components.size(); ++k) {
-        uint8_t bits = components[k].num_bits;
-        Result r = CopyBitsOfValueToBuffer(
-            ptr, data_[j][i * components.size() + k], bit_offset, bits);
-        if (!r.IsSuccess())
-          return r;
-
-        if ((k != components.size() - 1) &&
-            (static_cast<uint32_t>(bit_offset) + static_cast<uint32_t>(bits) >=
-             256)) {
+        // The format's precomputed component offsets replace the per
+        // vertex accumulation, but the bit copy still addresses with an
+        // eight bit offset.
+        if (components[k].bit_offset >= 256) {
           return Result(
               "Vulkan: VertexBuffer::FillVertexBufferWithData bit_offset "
               "overflow");
         }
-        bit_offset = static_cast<uint8_t>(bit_offset + bits);
+        Result r = CopyBitsOfValueToBuffer(
+            ptr, data_[j][i * components.size() + k],
+            static_cast<uint8_t>(components[k].bit_offset),
+            components[k].num_bits);
+        if (!r.IsSuccess())
+          return r;
       }
 
-      ptr += formats_[j].GetByteSize();
+      ptr += stride;
     }
-    ptr_in_stride_begin += Get4BytesAlignedStride();
+
+    format_offset += pack_size ? pack_size / 8 : formats_[j].GetByteSize();
   }
 
   return buffer_->CopyToDevice(command);
 }
 
 void VertexBuffer::BindToCommandBuffer(VkCommandBuffer command) {
+  // Static geometry binds its device-local shadow; see SendVertexData().
+  const VkBuffer buffer = bind_device_local_
+                              ? buffer_->GetDeviceLocalVkBuffer()
+                              : buffer_->GetVkBuffer();
+  if (instance_stride_in_bytes_ > 0) {
+    // The per instance region lives in the same VkBuffer behind the
+    // per vertex data, bound as binding 1 at its byte offset.
+    const VkBuffer buffers[2] = {buffer, buffer};
+    const VkDeviceSize offsets[2] = {0, instance_region_offset_};
+    device_->GetPtrs()->vkCmdBindVertexBuffers(command, 0, 2, buffers,
+                                               offsets);
+    return;
+  }
+
   const VkDeviceSize offset = 0;
-  const VkBuffer buffer = buffer_->GetVkBuffer();
-  // TODO(jaebaek): Support multiple binding
   device_->GetPtrs()->vkCmdBindVertexBuffers(command, 0, 1, &buffer, &offset);
 }
 
@@ -273,11 +514,26 @@ Result VertexBuffer::SendVertexData(
     return Result("Vulkan::Data for VertexBuffer is empty");
 
   size_t bytes = static_cast<size_t>(Get4BytesAlignedStride()) * n_vertices;
+  if (instance_stride_in_bytes_ > 0) {
+    // The per instance data lives behind the per vertex region of the
+    // same buffer; both strides are 4 byte aligned so the region
+    // offset is too.
+    size_t instance_elements = 0;
+    for (size_t j = 0; j < formats_.size(); ++j) {
+      if (instance_rate_[j])
+        instance_elements = std::max(instance_elements, GetElementCount(j));
+    }
+    instance_region_offset_ = bytes;
+    bytes += static_cast<size_t>(Get4BytesAligned(instance_stride_in_bytes_)) *
+             instance_elements;
+  }
 
+  const bool first_upload = !buffer_;
   if (!buffer_) {
     buffer_ = MakeUnique<Buffer>(device_, bytes, properties);
     Result r = buffer_->Initialize(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
-                                   VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+                                   VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                                   VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
     if (!r.IsSuccess())
       return r;
   }
@@ -285,7 +541,45 @@ Result VertexBuffer::SendVertexData(
   if (formats_.empty() || formats_[0].GetComponents().empty())
     return Result("Vulkan::Formats for VertexBuffer is empty");
 
-  FillVertexBufferWithData(command);
+  Result r = FillVertexBufferWithData(command);
+  if (!r.IsSuccess())
+    return r;
+
+  // The first upload of the geometry gets a device-local shadow filled
+  // by a one-time transfer, so draws fetch vertices from device memory
+  // instead of across the bus on every one; unified memory devices
+  // already read |buffer_| at device speed.
+  if (first_upload && !device_->HasUnifiedMemory() &&
+      buffer_->CreateDeviceLocalCopy().IsSuccess()) {
+    r = buffer_->RecordCopyToDeviceLocal(command);
+    if (!r.IsSuccess())
+      return r;
+
+    bind_device_local_ = true;
+  } else if (!first_upload) {
+    // Rewritten data small enough for vkCmdUpdateBuffer keeps its
+    // shadow: the new bytes ride inline in the command buffer, the
+    // per-update shape of push-style animation scripts. Larger buffers
+    // fall back to the host visible copy rather than paying a full
+    // transfer per change.
+    if (bind_device_local_ && buffer_->CanInlineUpdateDeviceLocal()) {
+      r = buffer_->RecordInlineUpdateToDeviceLocal(command);
+      if (!r.IsSuccess())
+        return r;
+    } else {
+      bind_device_local_ = false;
+    }
+  }
+
+  // The staging memory now holds the interleaved bytes, so the host
+  // copies are dead weight unless UpdateData() will rewrite a region;
+  // callers which do that opt out via RetainHostData().
+  if (!retain_host_data_) {
+    for (auto& values : data_)
+      std::vector<Value>().swap(values);
+    for (auto& bytes_for_location : packed_data_)
+      std::vector<uint8_t>().swap(bytes_for_location);
+  }
 
   is_vertex_data_pending_ = false;
   return {};
@@ -40,30 +40,62 @@ class VertexBuffer {
                         const VkPhysicalDeviceMemoryProperties& properties);
   bool VertexDataSent() const { return !is_vertex_data_pending_; }
 
+  // When |instance_rate| is set the location advances per instance of
+  // an instanced draw instead of per vertex; its data is laid out in a
+  // separate region bound with VK_VERTEX_INPUT_RATE_INSTANCE.
   void SetData(uint8_t location,
                const Format& format,
-               const std::vector<Value>& values);
+               const std::vector<Value>& values,
+               bool instance_rate = false);
+
+  // As SetData() above but takes the data already packed into the
+  // encoding described by |format|, one element per vertex. Packed data
+  // is interleaved into the vertex buffer with plain copies, with no
+  // per-value encoding at fill time.
+  void SetData(uint8_t location,
+               const Format& format,
+               const std::vector<uint8_t>& bytes,
+               bool instance_rate = false);
+
+  // Overwrite |values.size()| values of the data given for |location| by
+  // SetData(), starting at index |value_offset|. The vertex count and the
+  // buffer itself are unchanged, so draws already recorded against other
+  // regions of the buffer stay valid.
+  Result UpdateData(uint8_t location,
+                    size_t value_offset,
+                    const std::vector<Value>& values);
 
   const std::vector<VkVertexInputAttributeDescription>& GetVertexInputAttr()
       const {
     return vertex_attr_desc_;
   }
 
-  VkVertexInputBindingDescription GetVertexInputBinding() const {
-    VkVertexInputBindingDescription vertex_binding_desc =
-        VkVertexInputBindingDescription();
-    vertex_binding_desc.binding = 0;
-    vertex_binding_desc.stride = Get4BytesAlignedStride();
-    vertex_binding_desc.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-    return vertex_binding_desc;
+  // Binding 0 carries the interleaved per-vertex data; when any
+  // location advances per instance a second binding covers the per
+  // instance region of the same VkBuffer.
+  std::vector<VkVertexInputBindingDescription> GetVertexInputBindings() const {
+    std::vector<VkVertexInputBindingDescription> bindings;
+    VkVertexInputBindingDescription desc = VkVertexInputBindingDescription();
+    desc.binding = 0;
+    desc.stride = Get4BytesAlignedStride();
+    desc.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    bindings.push_back(desc);
+    if (instance_stride_in_bytes_ > 0) {
+      desc.binding = 1;
+      desc.stride = Get4BytesAligned(instance_stride_in_bytes_);
+      desc.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+      bindings.push_back(desc);
+    }
+    return bindings;
   }
 
-  size_t GetVertexCount() const {
-    if (data_.empty())
-      return 0;
+  size_t GetVertexCount() const { return vertex_count_; }
 
-    return data_[0].size() / formats_[0].GetComponents().size();
-  }
+  // Keep the host-side copy of the vertex data alive after it has been
+  // sent to the device. Required when UpdateData() will be called to
+  // rewrite regions of the buffer; by default the copies are freed once
+  // the staging memory holds the interleaved bytes.
+  void RetainHostData() { retain_host_data_ = true; }
 
   void BindToCommandBuffer(VkCommandBuffer command);
 
@@ -73,20 +105,48 @@ class VertexBuffer {
  private:
   Result FillVertexBufferWithData(VkCommandBuffer command);
 
+  // Return |bytes| rounded up by 4.
+  static uint32_t Get4BytesAligned(uint32_t bytes) {
+    return ((bytes + 3) / 4) * 4;
+  }
+
   // Return |stride_in_bytes_| rounded up by 4.
   uint32_t Get4BytesAlignedStride() const {
-    return ((stride_in_bytes_ + 3) / 4) * 4;
+    return Get4BytesAligned(stride_in_bytes_);
   }
 
+  // Number of elements given for location index |index|, regardless of
+  // whether they arrived as Values or packed bytes.
+  size_t GetElementCount(size_t index) const;
+
   Device* device_ = nullptr;
 
   bool is_vertex_data_pending_ = true;
+  bool retain_host_data_ = false;
+  // True while draws should read the device-local shadow of |buffer_|;
+  // cleared when the data is re-uploaded after a change.
+  bool bind_device_local_ = false;
+  // Derived from the first location's data when it is set; survives the
+  // release of the host copies below.
+  size_t vertex_count_ = 0;
 
   std::unique_ptr<Buffer> buffer_;
   uint32_t stride_in_bytes_ = 0;
+  // Stride of the per instance region; zero when every location
+  // advances per vertex.
+  uint32_t instance_stride_in_bytes_ = 0;
+  // Byte offset of the per instance region within |buffer_|, set when
+  // the buffer is sized on the first upload.
+  VkDeviceSize instance_region_offset_ = 0;
 
   std::vector<Format> formats_;
+  // Parallel to |formats_|; true when the location advances per
+  // instance.
+  std::vector<bool> instance_rate_;
   std::vector<std::vector<Value>> data_;
+  // Parallel to |data_|; a location holds either Values or packed bytes,
+  // the other entry stays empty.
+  std::vector<std::vector<uint8_t>> packed_data_;
 
   std::vector<VkVertexInputAttributeDescription> vertex_attr_desc_;
 };